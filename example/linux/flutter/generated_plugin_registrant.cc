@@ -0,0 +1,15 @@
+//
+//  Generated file. Do not edit.
+//
+
+// clang-format off
+
+#include "generated_plugin_registrant.h"
+
+#include <just_screenshot/screenshot_plugin.h>
+
+void fl_register_plugins(FlPluginRegistry* registry) {
+  g_autoptr(FlPluginRegistrar) just_screenshot_registrar =
+      fl_plugin_registry_get_registrar_for_plugin(registry, "ScreenshotPlugin");
+  screenshot_plugin_register_with_registrar(just_screenshot_registrar);
+}
@@ -1,11 +1,44 @@
+import 'dart:io';
+import 'dart:math';
+
 import 'screenshot_platform_interface.dart';
+import 'src/models/batch_capture.dart';
+import 'src/models/batch_rect.dart';
+import 'src/models/capture_format.dart';
+import 'src/models/capture_stats.dart';
 import 'src/models/captured_data.dart';
+import 'src/models/captured_file.dart';
+import 'src/models/captured_frame.dart';
+import 'src/models/captured_hash.dart';
+import 'src/models/captured_tiles.dart';
+import 'src/models/chroma_subsampling.dart';
+import 'src/models/display_capture.dart';
+import 'src/models/display_info.dart';
+import 'src/models/image_hash_kind.dart';
+import 'src/models/screenshot_exception.dart';
 import 'src/models/screenshot_mode.dart';
+import 'src/models/shared_frame.dart';
+import 'src/shared_capture.dart';
+import 'src/shared_memory.dart';
 
 // Export public models
+export 'src/models/batch_capture.dart';
+export 'src/models/batch_rect.dart';
+export 'src/models/capture_format.dart';
+export 'src/models/capture_stats.dart';
 export 'src/models/captured_data.dart';
+export 'src/models/captured_file.dart';
+export 'src/models/captured_frame.dart';
+export 'src/models/captured_hash.dart';
+export 'src/models/captured_tiles.dart';
+export 'src/models/chroma_subsampling.dart';
+export 'src/models/display_capture.dart';
+export 'src/models/display_info.dart';
+export 'src/models/image_hash_kind.dart';
 export 'src/models/screenshot_exception.dart';
 export 'src/models/screenshot_mode.dart';
+export 'src/models/shared_frame.dart';
+export 'src/shared_capture.dart';
 
 /// Screenshot plugin singleton.
 ///
@@ -18,11 +51,22 @@ class Screenshot {
 
   /// Capture a screenshot.
   ///
-  /// - [mode]: Screenshot capture mode (screen or region)
+  /// - [mode]: Screenshot capture mode (screen, region or all). All mode
+  ///   captures the whole virtual desktop in one image.
   /// - [includeCursor]: Whether to include the cursor in the screenshot
-  /// - [displayId]: Optional display ID for multi-monitor setups (null = primary display)
+  /// - [displayId]: Display to capture in screen mode, an id from
+  ///   [listDisplays] (null = primary display). Region mode always selects
+  ///   on the primary display.
+  /// - [format]: Format of the returned bytes; raw formats skip PNG encoding
+  /// - [quality]: Quality of lossy formats, 1 (smallest) to 100 (best);
+  ///   null uses the native default of 85
+  /// - [chromaSubsampling]: Chroma resolution of lossy formats; null uses 4:2:0
+  /// - [maxWidth], [maxHeight]: Largest size of the returned image; the capture
+  ///   is shrunk natively to fit, keeping its aspect ratio (null = no limit)
+  /// - [scale]: Factor in (0, 1] the capture is scaled by before [maxWidth] and
+  ///   [maxHeight] apply (null = 1). Captures are never enlarged.
   ///
-  /// Returns [CapturedData] with image dimensions and PNG-encoded bytes,
+  /// Returns [CapturedData] with image dimensions and bytes in [format],
   /// or null if the operation was cancelled by the user.
   ///
   /// Throws [ScreenshotException] if the operation fails.
@@ -39,11 +83,406 @@ class Screenshot {
     required ScreenshotMode mode,
     bool includeCursor = false,
     int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
   }) {
     return ScreenshotPlatform.instance.capture(
       mode: mode,
       includeCursor: includeCursor,
       displayId: displayId,
+      format: format,
+      quality: quality,
+      chromaSubsampling: chromaSubsampling,
+      maxWidth: maxWidth,
+      maxHeight: maxHeight,
+      scale: scale,
+    );
+  }
+
+  /// Capture a screenshot and save it to a file.
+  ///
+  /// The image is encoded on the native side and streamed into the file in
+  /// fixed-size chunks as the encoder produces it, so neither the native
+  /// side nor Dart ever holds the whole encoded file. Prefer this to
+  /// [capture] plus `File.writeAsBytes` when archiving screenshots.
+  ///
+  /// - [path]: File to write; an existing file is replaced
+  /// - [mode], [includeCursor], [displayId], [format], [quality],
+  ///   [chromaSubsampling], [maxWidth], [maxHeight], [scale]: As for
+  ///   [capture]
+  /// - [fsync]: Flush the file to disk before returning, so it survives a
+  ///   crash or power loss
+  /// - [atomic]: Write to a temporary file next to [path] and rename it into
+  ///   place once complete, so readers never see a partial file
+  ///
+  /// Returns [CapturedFile] with the image dimensions, file size and elapsed
+  /// time, or null if the operation was cancelled by the user. A failed
+  /// write leaves no partial file behind.
+  ///
+  /// Throws [ScreenshotException] if the operation fails.
+  ///
+  /// Example:
+  /// ```dart
+  /// final file = await Screenshot.instance.captureToFile(
+  ///   path: r'C:\archive\shot.png',
+  ///   mode: ScreenshotMode.screen,
+  /// );
+  /// print('Wrote ${file?.byteCount} bytes in ${file?.elapsed}');
+  /// ```
+  Future<CapturedFile?> captureToFile({
+    required String path,
+    required ScreenshotMode mode,
+    bool includeCursor = false,
+    int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+    bool fsync = false,
+    bool atomic = true,
+  }) {
+    return ScreenshotPlatform.instance.captureToFile(
+      path: path,
+      mode: mode,
+      includeCursor: includeCursor,
+      displayId: displayId,
+      format: format,
+      quality: quality,
+      chromaSubsampling: chromaSubsampling,
+      maxWidth: maxWidth,
+      maxHeight: maxHeight,
+      scale: scale,
+      fsync: fsync,
+      atomic: atomic,
+    );
+  }
+
+  /// Capture a screenshot into shared memory and read it in place.
+  ///
+  /// Works like [capture], and takes the same parameters, but the bytes are
+  /// written into a slot of shared
+  /// memory owned by the plugin and mapped into Dart, instead of being sent
+  /// over the platform channel. For very large captures (e.g. 8K, or
+  /// several monitors) this avoids copying the frame between the native
+  /// side and Dart altogether.
+  ///
+  /// The plugin has a few slots and reuses them only once they are released,
+  /// so call [SharedCapture.release] as soon as the bytes have been
+  /// consumed. While every slot is held, this throws a
+  /// [ScreenshotException].
+  ///
+  /// Returns null if the operation was cancelled by the user.
+  ///
+  /// Example:
+  /// ```dart
+  /// final shot = await Screenshot.instance.captureShared(
+  ///   mode: ScreenshotMode.screen,
+  ///   format: CaptureFormat.rawBgra,
+  /// );
+  /// if (shot != null) {
+  ///   try {
+  ///     upload(shot.bytes);
+  ///   } finally {
+  ///     await shot.release();
+  ///   }
+  /// }
+  /// ```
+  Future<SharedCapture?> captureShared({
+    required ScreenshotMode mode,
+    bool includeCursor = false,
+    int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+  }) async {
+    final ScreenshotPlatform platform = ScreenshotPlatform.instance;
+    final SharedFrame? frame = await platform.captureShared(
+      mode: mode,
+      includeCursor: includeCursor,
+      displayId: displayId,
+      format: format,
+      quality: quality,
+      chromaSubsampling: chromaSubsampling,
+      maxWidth: maxWidth,
+      maxHeight: maxHeight,
+      scale: scale,
+    );
+    if (frame == null) return null;
+    final SharedMemoryView view;
+    try {
+      view = SharedMemoryView.map(handle: frame.handle, offset: frame.offset, length: frame.length);
+    } on OSError catch (e) {
+      await platform.releaseShared(frame.generation);
+      throw ScreenshotException(code: 'internal_error', message: 'Failed to map shared frame', details: e.message);
+    }
+    return SharedCapture(frame, view, platform.releaseShared);
+  }
+
+  /// List the displays of the virtual desktop, with their ids for
+  /// `displayId` and their positions.
+  ///
+  /// Throws [ScreenshotException] if the displays cannot be listed.
+  Future<List<DisplayInfo>> listDisplays() {
+    return ScreenshotPlatform.instance.listDisplays();
+  }
+
+  /// Capture every display, each into an image of its own.
+  ///
+  /// The displays are copied at the same moment, each on a thread of its
+  /// own, and then encoded concurrently, so this takes about as long as
+  /// capturing the largest display rather than all of them in turn. For
+  /// one image of the whole desktop use [capture] with
+  /// [ScreenshotMode.all].
+  ///
+  /// - [includeCursor], [format], [quality], [chromaSubsampling]: As for
+  ///   [capture]
+  ///
+  /// Returns one [DisplayCapture] per display, in [listDisplays] order.
+  ///
+  /// Throws [ScreenshotException] if the operation fails.
+  Future<List<DisplayCapture>> captureAllDisplays({
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+  }) {
+    return ScreenshotPlatform.instance.captureAllDisplays(
+      includeCursor: includeCursor,
+      format: format,
+      quality: quality,
+      chromaSubsampling: chromaSubsampling,
+    );
+  }
+
+  /// Capture the screen once and return several rectangles of it, such as
+  /// the elements of a UI under test.
+  ///
+  /// The screen is copied once and every rectangle is a view into that copy,
+  /// so the rectangles show the same moment; they are encoded concurrently.
+  /// This is much cheaper than calling [capture] for each of them.
+  ///
+  /// ```dart
+  /// final crops = await screenshot.captureBatch(<BatchRect>[
+  ///   const BatchRect(x: 16, y: 48, width: 320, height: 40),
+  ///   const BatchRect(x: 16, y: 96, width: 640, height: 480, format: CaptureFormat.jpeg),
+  /// ]);
+  /// ```
+  ///
+  /// - [rects]: 1-256 rectangles in pixels of the primary display; each is
+  ///   clipped to it and may set its own format and scaling
+  /// - [includeCursor], [format], [quality], [chromaSubsampling],
+  ///   [maxWidth], [maxHeight], [scale]: As for [capture], for every
+  ///   rectangle that does not set its own
+  ///
+  /// Returns one [BatchCapture] per rectangle, in order.
+  ///
+  /// Throws [ScreenshotException] with `invalid_argument` if a rectangle is
+  /// off the display, or if the operation fails.
+  Future<List<BatchCapture>> captureBatch(
+    List<BatchRect> rects, {
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+  }) {
+    return ScreenshotPlatform.instance.captureBatch(
+      rects,
+      includeCursor: includeCursor,
+      format: format,
+      quality: quality,
+      chromaSubsampling: chromaSubsampling,
+      maxWidth: maxWidth,
+      maxHeight: maxHeight,
+      scale: scale,
     );
   }
+
+  /// Capture the screen, or a rectangle of it, and return fingerprints of it
+  /// instead of an image.
+  ///
+  /// For deduplicating captures or noticing when part of the screen changes,
+  /// a hash is all that is needed, and computing one from the captured
+  /// pixels costs a few milliseconds even at 4K, where encoding a PNG to
+  /// hash costs far more.
+  ///
+  /// ```dart
+  /// final before = await screenshot.captureHash(rect: const Rectangle<int>(0, 0, 800, 600));
+  /// // ...
+  /// final after = await screenshot.captureHash(rect: const Rectangle<int>(0, 0, 800, 600));
+  /// if (after.xxh3 != before.xxh3 && CapturedHash.hammingDistance(after.pHash!, before.pHash!) > 8) {
+  ///   print('The view changed');
+  /// }
+  /// ```
+  ///
+  /// - [includeCursor]: Whether to include the cursor in the hashed pixels
+  /// - [rect]: Rectangle in pixels of the primary display to hash, clipped
+  ///   to it; null hashes the whole display
+  /// - [hashes]: Which hashes to compute; null computes every [ImageHashKind]
+  ///
+  /// Throws [ScreenshotException] with `invalid_argument` if [rect] is off
+  /// the display or [hashes] is empty, or if the operation fails.
+  Future<CapturedHash> captureHash({
+    bool includeCursor = false,
+    Rectangle<int>? rect,
+    Set<ImageHashKind>? hashes,
+  }) {
+    return ScreenshotPlatform.instance.captureHash(
+      includeCursor: includeCursor,
+      rect: rect,
+      hashes: hashes,
+    );
+  }
+
+  /// Capture the screen and return only the tiles that changed since the
+  /// previous call.
+  ///
+  /// The screen is compared with the previous [captureTiles] frame in a grid
+  /// of [tileSize] pixel tiles (64 by default), and only the tiles that
+  /// differ are encoded and returned. This is much cheaper than [capture]
+  /// for screen sharing or recording, where most of the screen stays the
+  /// same between frames.
+  ///
+  /// - [includeCursor]: Whether to include the cursor in the screenshot
+  /// - [format], [quality], [chromaSubsampling]: Encoding of each tile, as
+  ///   for [capture]
+  /// - [tileSize]: Edge length of the tile grid, 8-1024 pixels; null uses 64
+  /// - [keyframe]: Return every tile instead of only the changed ones, e.g.
+  ///   when a new viewer joins
+  ///
+  /// Throws [ScreenshotException] if the operation fails.
+  ///
+  /// Example:
+  /// ```dart
+  /// final frame = await Screenshot.instance.captureTiles(format: CaptureFormat.rawBgra);
+  /// for (final tile in frame.tiles) {
+  ///   canvas.update(tile.x, tile.y, tile.width, tile.height, tile.bytes);
+  /// }
+  /// ```
+  Future<CapturedTiles> captureTiles({
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? tileSize,
+    bool keyframe = false,
+  }) {
+    return ScreenshotPlatform.instance.captureTiles(
+      includeCursor: includeCursor,
+      format: format,
+      quality: quality,
+      chromaSubsampling: chromaSubsampling,
+      tileSize: tileSize,
+      keyframe: keyframe,
+    );
+  }
+
+  /// Start capturing the screen continuously at [fps] frames per second
+  /// (up to 240).
+  ///
+  /// Frames are captured on a dedicated native thread, encoded on another,
+  /// and delivered on [frames]. If encoding or the listener falls behind,
+  /// the oldest frames are dropped instead of queued, so latency stays
+  /// bounded; [CapturedFrame.sequence] skips the dropped frames. Frames
+  /// that fail to capture or encode are skipped as well and counted in
+  /// [CapturedFrame.failed].
+  ///
+  /// - [includeCursor]: Whether to include the cursor in each frame
+  /// - [format], [quality], [chromaSubsampling]: Encoding of each frame, as
+  ///   for [capture]
+  ///
+  /// Starting again replaces the running stream. Cancelling every
+  /// subscription to [frames] also stops it.
+  ///
+  /// Example:
+  /// ```dart
+  /// final subscription = Screenshot.instance.frames.listen((frame) {
+  ///   print('frame ${frame.sequence} at ${frame.timestamp}');
+  /// });
+  /// await Screenshot.instance.startStream(fps: 15, format: CaptureFormat.jpeg);
+  /// // ...
+  /// await Screenshot.instance.stopStream();
+  /// await subscription.cancel();
+  /// ```
+  Future<void> startStream({
+    double fps = 30,
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+  }) {
+    return ScreenshotPlatform.instance.startStream(
+      fps: fps,
+      includeCursor: includeCursor,
+      format: format,
+      quality: quality,
+      chromaSubsampling: chromaSubsampling,
+    );
+  }
+
+  /// Stop the stream started by [startStream], if any.
+  Future<void> stopStream() {
+    return ScreenshotPlatform.instance.stopStream();
+  }
+
+  /// Frames of the stream started by [startStream].
+  ///
+  /// Listen before starting the stream so no frame is missed.
+  Stream<CapturedFrame> get frames => ScreenshotPlatform.instance.frames;
+
+  /// Where captures have spent their time since the plugin started or the
+  /// last [resetStats]: latency percentiles of each stage (copying the
+  /// screen, drawing the cursor, scaling, encoding, and the whole capture),
+  /// byte counts, errors, and the native frame pool and stream counters.
+  ///
+  /// Example:
+  /// ```dart
+  /// final stats = await Screenshot.instance.getStats();
+  /// print('encode p99: ${stats.stage('encode').p99Us} us');
+  /// ```
+  Future<CaptureStats> getStats() {
+    return ScreenshotPlatform.instance.getStats();
+  }
+
+  /// Clear the stage statistics reported by [getStats].
+  Future<void> resetStats() {
+    return ScreenshotPlatform.instance.resetStats();
+  }
+
+  /// Start recording spans of the native capture pipeline (copying the
+  /// screen, drawing the cursor, the region overlay, converting, scaling,
+  /// encoding and replying) on every native thread, dropping any recorded
+  /// before. Each thread keeps its last few thousand spans.
+  ///
+  /// Tracing costs nothing measurable while it is off, and little while it
+  /// is on; use it to find out where an outlier capture spent its time.
+  Future<void> startTracing() {
+    return ScreenshotPlatform.instance.startTracing();
+  }
+
+  /// Stop recording spans and return them as Chrome trace_event JSON, which
+  /// chrome://tracing and Perfetto (ui.perfetto.dev) open as is.
+  ///
+  /// Example:
+  /// ```dart
+  /// await Screenshot.instance.startTracing();
+  /// await Screenshot.instance.capture(mode: ScreenshotMode.screen);
+  /// File('capture.json').writeAsStringSync(
+  ///   await Screenshot.instance.stopTracing(),
+  /// );
+  /// ```
+  Future<String> stopTracing() {
+    return ScreenshotPlatform.instance.stopTracing();
+  }
 }
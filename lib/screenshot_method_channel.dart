@@ -1,11 +1,27 @@
+import 'dart:math';
+
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
 import 'screenshot_platform_interface.dart';
+import 'src/models/batch_capture.dart';
+import 'src/models/batch_rect.dart';
+import 'src/models/capture_format.dart';
+import 'src/models/capture_stats.dart';
 import 'src/models/captured_data.dart';
+import 'src/models/captured_file.dart';
+import 'src/models/captured_frame.dart';
+import 'src/models/captured_hash.dart';
+import 'src/models/captured_tiles.dart';
+import 'src/models/chroma_subsampling.dart';
 import 'src/models/capture_request.dart';
+import 'src/models/display_capture.dart';
+import 'src/models/display_info.dart';
+import 'src/models/frame_message.dart';
+import 'src/models/image_hash_kind.dart';
 import 'src/models/screenshot_exception.dart';
 import 'src/models/screenshot_mode.dart';
+import 'src/models/shared_frame.dart';
 
 /// An implementation of [ScreenshotPlatform] that uses method channels.
 class MethodChannelScreenshot extends ScreenshotPlatform {
@@ -15,11 +31,39 @@ class MethodChannelScreenshot extends ScreenshotPlatform {
     'dev.flutter.screenshot',
   );
 
+  /// The event channel stream frames arrive on.
+  @visibleForTesting
+  final EventChannel eventChannel = const EventChannel(
+    'dev.flutter.screenshot/stream',
+  );
+
+  /// The channel `capture` requests go out on. Replies are binary frame
+  /// messages (see [FrameMessage]) whose payload becomes
+  /// [CapturedData.bytes] without a copy or a codec pass.
+  @visibleForTesting
+  final BasicMessageChannel<ByteData> frameChannel = const BasicMessageChannel<ByteData>(
+    'dev.flutter.screenshot/frame',
+    BinaryCodec(),
+  );
+
+  Stream<CapturedFrame>? _frames;
+
+  // Set once a frame channel request goes unanswered: the platform does not
+  // register the channel (Linux), so later captures go straight to the
+  // method channel instead of paying for a round trip that cannot succeed.
+  bool _frameChannelMissing = false;
+
   @override
   Future<CapturedData?> capture({
     required ScreenshotMode mode,
     bool includeCursor = false,
     int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
   }) async {
     try {
       // Create request and serialize to map
@@ -27,11 +71,25 @@ class MethodChannelScreenshot extends ScreenshotPlatform {
         mode: mode,
         includeCursor: includeCursor,
         displayId: displayId,
+        format: format,
+        quality: quality,
+        chromaSubsampling: chromaSubsampling,
+        maxWidth: maxWidth,
+        maxHeight: maxHeight,
+        scale: scale,
       );
 
       final Map<String, dynamic> arguments = request.toMap();
 
-      // Invoke platform method
+      if (!_frameChannelMissing) {
+        final ByteData? reply = await frameChannel.send(const StandardMessageCodec().encodeMessage(arguments)!);
+        if (reply != null) {
+          return _parseFrameReply(reply);
+        }
+        _frameChannelMissing = true;
+      }
+
+      // No frame channel on this platform; use the method channel
       final Map<Object?, Object?>? result = await methodChannel
           .invokeMethod<Map<Object?, Object?>>('capture', arguments);
 
@@ -51,4 +109,380 @@ class MethodChannelScreenshot extends ScreenshotPlatform {
       );
     }
   }
+
+  @override
+  Future<SharedFrame?> captureShared({
+    required ScreenshotMode mode,
+    bool includeCursor = false,
+    int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+  }) async {
+    try {
+      final CaptureRequest request = CaptureRequest(
+        mode: mode,
+        includeCursor: includeCursor,
+        displayId: displayId,
+        format: format,
+        quality: quality,
+        chromaSubsampling: chromaSubsampling,
+        maxWidth: maxWidth,
+        maxHeight: maxHeight,
+        scale: scale,
+      );
+      final Map<Object?, Object?>? result = await methodChannel
+          .invokeMethod<Map<Object?, Object?>>('captureShared', request.toMap());
+      return result == null ? null : SharedFrame.fromMap(result);
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<void> releaseShared(int generation) async {
+    try {
+      await methodChannel.invokeMethod<bool>('releaseShared', <String, dynamic>{'generation': generation});
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<CapturedFile?> captureToFile({
+    required String path,
+    required ScreenshotMode mode,
+    bool includeCursor = false,
+    int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+    bool fsync = false,
+    bool atomic = true,
+  }) async {
+    try {
+      final CaptureRequest request = CaptureRequest(
+        mode: mode,
+        includeCursor: includeCursor,
+        displayId: displayId,
+        format: format,
+        quality: quality,
+        chromaSubsampling: chromaSubsampling,
+        maxWidth: maxWidth,
+        maxHeight: maxHeight,
+        scale: scale,
+      );
+      final Map<Object?, Object?>? result = await methodChannel.invokeMethod<Map<Object?, Object?>>(
+        'captureToFile',
+        <String, dynamic>{...request.toMap(), 'path': path, 'fsync': fsync, 'atomic': atomic},
+      );
+      return result == null ? null : CapturedFile.fromMap(result);
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<List<DisplayInfo>> listDisplays() async {
+    try {
+      final List<Object?>? result = await methodChannel.invokeMethod<List<Object?>>('listDisplays');
+      if (result == null) {
+        throw const ScreenshotException(code: 'internal_error', message: 'listDisplays returned no result');
+      }
+      return result.map((Object? display) => DisplayInfo.fromMap(display! as Map<Object?, Object?>)).toList();
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<List<DisplayCapture>> captureAllDisplays({
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+  }) async {
+    try {
+      final List<Object?>? result = await methodChannel.invokeMethod<List<Object?>>(
+        'captureAllDisplays',
+        <String, dynamic>{
+          'includeCursor': includeCursor,
+          'format': format.toValue(),
+          if (quality != null) 'quality': quality,
+          if (chromaSubsampling != null) 'chromaSubsampling': chromaSubsampling.toValue(),
+        },
+      );
+      if (result == null) {
+        throw const ScreenshotException(code: 'internal_error', message: 'captureAllDisplays returned no result');
+      }
+      return result
+          .map((Object? capture) => DisplayCapture.fromMap(capture! as Map<Object?, Object?>))
+          .toList();
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<List<BatchCapture>> captureBatch(
+    List<BatchRect> rects, {
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+  }) async {
+    try {
+      final List<Object?>? result = await methodChannel.invokeMethod<List<Object?>>(
+        'captureBatch',
+        <String, dynamic>{
+          'rects': rects.map((BatchRect rect) => rect.toMap()).toList(),
+          'includeCursor': includeCursor,
+          'format': format.toValue(),
+          if (quality != null) 'quality': quality,
+          if (chromaSubsampling != null) 'chromaSubsampling': chromaSubsampling.toValue(),
+          if (maxWidth != null) 'maxWidth': maxWidth,
+          if (maxHeight != null) 'maxHeight': maxHeight,
+          if (scale != null) 'scale': scale,
+        },
+      );
+      if (result == null) {
+        throw const ScreenshotException(code: 'internal_error', message: 'captureBatch returned no result');
+      }
+      return result
+          .map((Object? capture) => BatchCapture.fromMap(capture! as Map<Object?, Object?>))
+          .toList();
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<CapturedHash> captureHash({
+    bool includeCursor = false,
+    Rectangle<int>? rect,
+    Set<ImageHashKind>? hashes,
+  }) async {
+    try {
+      final Map<Object?, Object?>? result = await methodChannel.invokeMethod<Map<Object?, Object?>>(
+        'captureHash',
+        <String, dynamic>{
+          'includeCursor': includeCursor,
+          if (rect != null)
+            'rect': <String, int>{'x': rect.left, 'y': rect.top, 'width': rect.width, 'height': rect.height},
+          if (hashes != null) 'hashes': hashes.map((ImageHashKind kind) => kind.toValue()).toList(),
+        },
+      );
+      if (result == null) {
+        throw const ScreenshotException(code: 'internal_error', message: 'captureHash returned no result');
+      }
+      return CapturedHash.fromMap(result);
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  CapturedData? _parseFrameReply(ByteData reply) {
+    final FrameMessage message;
+    try {
+      message = FrameMessage.parse(reply);
+    } on FormatException catch (e) {
+      throw ScreenshotException(code: 'internal_error', message: e.message);
+    }
+    switch (message.kind) {
+      case FrameMessageKind.frame:
+        return message.toCapturedData();
+      case FrameMessageKind.none:
+        return null;
+      case FrameMessageKind.error:
+        // Throws the PlatformException the envelope describes.
+        const StandardMethodCodec().decodeEnvelope(ByteData.sublistView(message.payload));
+        throw const ScreenshotException(code: 'internal_error', message: 'Malformed error reply');
+    }
+  }
+
+  @override
+  Future<CapturedTiles> captureTiles({
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? tileSize,
+    bool keyframe = false,
+  }) async {
+    try {
+      final Map<String, dynamic> arguments = <String, dynamic>{
+        'includeCursor': includeCursor,
+        'format': format.toValue(),
+        if (quality != null) 'quality': quality,
+        if (chromaSubsampling != null) 'chromaSubsampling': chromaSubsampling.toValue(),
+        if (tileSize != null) 'tileSize': tileSize,
+        'keyframe': keyframe,
+      };
+
+      final Map<Object?, Object?>? result = await methodChannel
+          .invokeMethod<Map<Object?, Object?>>('captureTiles', arguments);
+      if (result == null) {
+        throw const ScreenshotException(code: 'internal_error', message: 'captureTiles returned no result');
+      }
+      return CapturedTiles.fromMap(result);
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<void> startStream({
+    double fps = 30,
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+  }) async {
+    try {
+      await methodChannel.invokeMethod<void>('startStream', <String, dynamic>{
+        'fps': fps,
+        'includeCursor': includeCursor,
+        'format': format.toValue(),
+        if (quality != null) 'quality': quality,
+        if (chromaSubsampling != null) 'chromaSubsampling': chromaSubsampling.toValue(),
+      });
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<void> stopStream() async {
+    try {
+      await methodChannel.invokeMethod<void>('stopStream');
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Stream<CapturedFrame> get frames {
+    return _frames ??= eventChannel
+        .receiveBroadcastStream()
+        .handleError((Object error) {
+          if (error is PlatformException) {
+            throw ScreenshotException.fromPlatformException(
+              code: error.code,
+              message: error.message,
+              details: error.details,
+            );
+          }
+          throw error;
+        })
+        .map((dynamic event) => CapturedFrame.fromMap(event as Map<Object?, Object?>));
+  }
+
+  @override
+  Future<CaptureStats> getStats() async {
+    try {
+      final Map<Object?, Object?>? result = await methodChannel.invokeMethod<Map<Object?, Object?>>('getStats');
+      if (result == null) {
+        throw const ScreenshotException(code: 'internal_error', message: 'getStats returned no result');
+      }
+      return CaptureStats.fromMap(result);
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<void> resetStats() async {
+    try {
+      await methodChannel.invokeMethod<void>('resetStats');
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<void> startTracing() async {
+    try {
+      await methodChannel.invokeMethod<void>('startTracing');
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
+
+  @override
+  Future<String> stopTracing() async {
+    try {
+      final String? result = await methodChannel.invokeMethod<String>('stopTracing');
+      if (result == null) {
+        throw const ScreenshotException(code: 'internal_error', message: 'stopTracing returned no result');
+      }
+      return result;
+    } on PlatformException catch (e) {
+      throw ScreenshotException.fromPlatformException(
+        code: e.code,
+        message: e.message,
+        details: e.details,
+      );
+    }
+  }
 }
@@ -1,8 +1,23 @@
+import 'dart:math';
+
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
 import 'screenshot_method_channel.dart';
+import 'src/models/batch_capture.dart';
+import 'src/models/batch_rect.dart';
+import 'src/models/capture_format.dart';
+import 'src/models/capture_stats.dart';
 import 'src/models/captured_data.dart';
+import 'src/models/captured_file.dart';
+import 'src/models/captured_frame.dart';
+import 'src/models/captured_hash.dart';
+import 'src/models/captured_tiles.dart';
+import 'src/models/chroma_subsampling.dart';
+import 'src/models/display_capture.dart';
+import 'src/models/display_info.dart';
+import 'src/models/image_hash_kind.dart';
 import 'src/models/screenshot_mode.dart';
+import 'src/models/shared_frame.dart';
 
 /// The interface that platform-specific implementations of screenshot must implement.
 ///
@@ -32,11 +47,20 @@ abstract class ScreenshotPlatform extends PlatformInterface {
 
   /// Capture a screenshot.
   ///
-  /// - [mode]: Screenshot capture mode (screen or region)
+  /// - [mode]: Screenshot capture mode (screen, region or all)
   /// - [includeCursor]: Whether to include the cursor in the screenshot
-  /// - [displayId]: Optional display ID for multi-monitor setups (null = primary display)
+  /// - [displayId]: Display to capture in screen mode, an id from
+  ///   [listDisplays] (null = primary display)
+  /// - [format]: Format of the returned bytes; raw formats skip PNG encoding
+  /// - [quality]: Quality of lossy formats, 1 (smallest) to 100 (best);
+  ///   null uses the native default of 85
+  /// - [chromaSubsampling]: Chroma resolution of lossy formats; null uses 4:2:0
+  /// - [maxWidth], [maxHeight]: Largest size of the returned image; the capture
+  ///   is shrunk natively to fit, keeping its aspect ratio (null = no limit)
+  /// - [scale]: Factor in (0, 1] the capture is scaled by before [maxWidth] and
+  ///   [maxHeight] apply (null = 1). Captures are never enlarged.
   ///
-  /// Returns [CapturedData] with image dimensions and PNG-encoded bytes,
+  /// Returns [CapturedData] with image dimensions and bytes in [format],
   /// or null if the operation was cancelled by the user.
   ///
   /// Throws [ScreenshotException] if the operation fails.
@@ -44,7 +68,199 @@ abstract class ScreenshotPlatform extends PlatformInterface {
     required ScreenshotMode mode,
     bool includeCursor = false,
     int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
   }) {
     throw UnimplementedError('capture() has not been implemented.');
   }
+
+  /// Capture a screenshot into the plugin's shared memory.
+  ///
+  /// Parameters work as for [capture]. Returns where the bytes lie, or null
+  /// if the operation was cancelled by the user. The slot stays reserved
+  /// until [releaseShared] is called with [SharedFrame.generation].
+  ///
+  /// Throws [ScreenshotException] if the operation fails, including when
+  /// every slot is still reserved.
+  Future<SharedFrame?> captureShared({
+    required ScreenshotMode mode,
+    bool includeCursor = false,
+    int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+  }) {
+    throw UnimplementedError('captureShared() has not been implemented.');
+  }
+
+  /// Let the plugin reuse the slot of the [captureShared] result with
+  /// [generation]. Releasing a slot twice has no effect.
+  Future<void> releaseShared(int generation) {
+    throw UnimplementedError('releaseShared() has not been implemented.');
+  }
+
+  /// Capture a screenshot and stream it, encoded, straight into a file.
+  ///
+  /// Capture parameters work as for [capture]. The file at [path] is
+  /// replaced; with [atomic] it is written next to [path] and renamed over
+  /// it once complete, and with [fsync] it is flushed to disk before this
+  /// completes.
+  ///
+  /// Returns [CapturedFile] with the image dimensions, file size and the
+  /// time taken, or null if the operation was cancelled by the user.
+  ///
+  /// Throws [ScreenshotException] if the operation fails.
+  Future<CapturedFile?> captureToFile({
+    required String path,
+    required ScreenshotMode mode,
+    bool includeCursor = false,
+    int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+    bool fsync = false,
+    bool atomic = true,
+  }) {
+    throw UnimplementedError('captureToFile() has not been implemented.');
+  }
+
+  /// List the displays of the virtual desktop.
+  ///
+  /// Throws [ScreenshotException] if the displays cannot be listed.
+  Future<List<DisplayInfo>> listDisplays() {
+    throw UnimplementedError('listDisplays() has not been implemented.');
+  }
+
+  /// Capture every display, each into an image of its own.
+  ///
+  /// The displays are captured, and then encoded, concurrently. [format],
+  /// [quality] and [chromaSubsampling] work as for [capture]. Returns one
+  /// [DisplayCapture] per display, in [listDisplays] order.
+  ///
+  /// Throws [ScreenshotException] if the operation fails.
+  Future<List<DisplayCapture>> captureAllDisplays({
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+  }) {
+    throw UnimplementedError('captureAllDisplays() has not been implemented.');
+  }
+
+  /// Capture the screen once and return each of [rects] of it.
+  ///
+  /// The rectangles are cut from one copy of the screen and encoded
+  /// concurrently. [format], [quality], [chromaSubsampling], [maxWidth],
+  /// [maxHeight] and [scale] work as for [capture], for every rectangle that
+  /// does not set its own. Returns one [BatchCapture] per rectangle, in
+  /// order.
+  ///
+  /// Throws [ScreenshotException] if the operation fails.
+  Future<List<BatchCapture>> captureBatch(
+    List<BatchRect> rects, {
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+  }) {
+    throw UnimplementedError('captureBatch() has not been implemented.');
+  }
+
+  /// Capture the screen, or [rect] of it, and return fingerprints of the
+  /// pixels instead of an image.
+  ///
+  /// [hashes] picks which of [ImageHashKind] to compute; null computes them
+  /// all. Nothing is encoded.
+  ///
+  /// Throws [ScreenshotException] if the operation fails.
+  Future<CapturedHash> captureHash({
+    bool includeCursor = false,
+    Rectangle<int>? rect,
+    Set<ImageHashKind>? hashes,
+  }) {
+    throw UnimplementedError('captureHash() has not been implemented.');
+  }
+
+  /// Capture the screen and return the tiles that changed since the previous
+  /// call.
+  ///
+  /// - [includeCursor]: Whether to include the cursor in the screenshot
+  /// - [format], [quality], [chromaSubsampling]: Encoding of each tile, as
+  ///   for [capture]
+  /// - [tileSize]: Edge length of the tile grid, 8-1024 pixels; null uses 64
+  /// - [keyframe]: Return every tile instead of only the changed ones
+  ///
+  /// Throws [ScreenshotException] if the operation fails.
+  Future<CapturedTiles> captureTiles({
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? tileSize,
+    bool keyframe = false,
+  }) {
+    throw UnimplementedError('captureTiles() has not been implemented.');
+  }
+
+  /// Start capturing the screen continuously at [fps] frames per second.
+  ///
+  /// Frames are delivered on [frames]. [format], [quality] and
+  /// [chromaSubsampling] work as for [capture]. Starting again replaces the
+  /// running stream.
+  ///
+  /// Throws [ScreenshotException] if the stream cannot be started.
+  Future<void> startStream({
+    double fps = 30,
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+  }) {
+    throw UnimplementedError('startStream() has not been implemented.');
+  }
+
+  /// Stop the stream started by [startStream], if any.
+  Future<void> stopStream() {
+    throw UnimplementedError('stopStream() has not been implemented.');
+  }
+
+  /// Frames of the stream started by [startStream].
+  Stream<CapturedFrame> get frames {
+    throw UnimplementedError('frames has not been implemented.');
+  }
+
+  /// Where captures have spent their time since the plugin started or the
+  /// last [resetStats].
+  Future<CaptureStats> getStats() {
+    throw UnimplementedError('getStats() has not been implemented.');
+  }
+
+  /// Clear the stage statistics reported by [getStats].
+  Future<void> resetStats() {
+    throw UnimplementedError('resetStats() has not been implemented.');
+  }
+
+  /// Drop the spans recorded so far and start recording capture pipeline
+  /// spans on every native thread.
+  Future<void> startTracing() {
+    throw UnimplementedError('startTracing() has not been implemented.');
+  }
+
+  /// Stop recording spans and return them as Chrome trace_event JSON.
+  Future<String> stopTracing() {
+    throw UnimplementedError('stopTracing() has not been implemented.');
+  }
 }
@@ -0,0 +1,73 @@
+import 'captured_data.dart';
+
+/// One rectangle's image from `Screenshot.captureBatch`.
+class BatchCapture {
+  /// Creates a [BatchCapture] instance.
+  const BatchCapture({
+    required this.x,
+    required this.y,
+    required this.sourceWidth,
+    required this.sourceHeight,
+    required this.data,
+  });
+
+  /// Left edge of the captured rectangle, clipped to the screen.
+  final int x;
+
+  /// Top edge of the captured rectangle, clipped to the screen.
+  final int y;
+
+  /// Width of the captured rectangle on screen; the image's own width is
+  /// smaller when it was scaled.
+  final int sourceWidth;
+
+  /// Height of the captured rectangle on screen.
+  final int sourceHeight;
+
+  /// The rectangle's image.
+  final CapturedData data;
+
+  /// Create [BatchCapture] from a method channel response map: a capture
+  /// result with the rectangle's `x`, `y`, `sourceWidth` and `sourceHeight`
+  /// added.
+  factory BatchCapture.fromMap(Map<Object?, Object?> map) {
+    return BatchCapture(
+      x: map['x'] as int,
+      y: map['y'] as int,
+      sourceWidth: map['sourceWidth'] as int,
+      sourceHeight: map['sourceHeight'] as int,
+      data: CapturedData.fromMap(map),
+    );
+  }
+
+  /// Convert [BatchCapture] to map for method channel.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      ...data.toMap(),
+      'x': x,
+      'y': y,
+      'sourceWidth': sourceWidth,
+      'sourceHeight': sourceHeight,
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is BatchCapture &&
+        other.x == x &&
+        other.y == y &&
+        other.sourceWidth == sourceWidth &&
+        other.sourceHeight == sourceHeight &&
+        other.data == data;
+  }
+
+  @override
+  int get hashCode => Object.hash(x, y, sourceWidth, sourceHeight, data);
+
+  @override
+  String toString() {
+    return 'BatchCapture(x: $x, y: $y, sourceWidth: $sourceWidth, sourceHeight: $sourceHeight, data: $data)';
+  }
+}
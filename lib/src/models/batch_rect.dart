@@ -0,0 +1,113 @@
+import 'capture_format.dart';
+import 'chroma_subsampling.dart';
+
+/// One rectangle of a `Screenshot.captureBatch` call.
+///
+/// The encoding and scaling fields override the call's own for this
+/// rectangle; null keeps the call's.
+class BatchRect {
+  /// Creates a [BatchRect] instance.
+  const BatchRect({
+    required this.x,
+    required this.y,
+    required this.width,
+    required this.height,
+    this.format,
+    this.quality,
+    this.chromaSubsampling,
+    this.maxWidth,
+    this.maxHeight,
+    this.scale,
+  });
+
+  /// Left edge, in pixels of the primary display.
+  final int x;
+
+  /// Top edge, in pixels of the primary display.
+  final int y;
+
+  /// Width in pixels.
+  final int width;
+
+  /// Height in pixels.
+  final int height;
+
+  /// Format of this rectangle's bytes (null = the call's format).
+  final CaptureFormat? format;
+
+  /// Lossy encoding quality, 1-100 (null = the call's quality).
+  final int? quality;
+
+  /// Chroma subsampling for lossy formats (null = the call's).
+  final ChromaSubsampling? chromaSubsampling;
+
+  /// Largest width of the returned image (null = the call's limit).
+  final int? maxWidth;
+
+  /// Largest height of the returned image (null = the call's limit).
+  final int? maxHeight;
+
+  /// Factor in (0, 1] the rectangle is scaled by natively (null = the
+  /// call's).
+  final double? scale;
+
+  /// Convert [BatchRect] to map for method channel.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      'x': x,
+      'y': y,
+      'width': width,
+      'height': height,
+      if (format != null) 'format': format!.toValue(),
+      if (quality != null) 'quality': quality,
+      if (chromaSubsampling != null) 'chromaSubsampling': chromaSubsampling!.toValue(),
+      if (maxWidth != null) 'maxWidth': maxWidth,
+      if (maxHeight != null) 'maxHeight': maxHeight,
+      if (scale != null) 'scale': scale,
+    };
+  }
+
+  /// Create [BatchRect] from map.
+  factory BatchRect.fromMap(Map<Object?, Object?> map) {
+    return BatchRect(
+      x: map['x'] as int,
+      y: map['y'] as int,
+      width: map['width'] as int,
+      height: map['height'] as int,
+      format: map['format'] == null ? null : CaptureFormatExtension.fromValue(map['format'] as String),
+      quality: map['quality'] as int?,
+      chromaSubsampling: map['chromaSubsampling'] == null
+          ? null
+          : ChromaSubsamplingExtension.fromValue(map['chromaSubsampling'] as String),
+      maxWidth: map['maxWidth'] as int?,
+      maxHeight: map['maxHeight'] as int?,
+      scale: (map['scale'] as num?)?.toDouble(),
+    );
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is BatchRect &&
+        other.x == x &&
+        other.y == y &&
+        other.width == width &&
+        other.height == height &&
+        other.format == format &&
+        other.quality == quality &&
+        other.chromaSubsampling == chromaSubsampling &&
+        other.maxWidth == maxWidth &&
+        other.maxHeight == maxHeight &&
+        other.scale == scale;
+  }
+
+  @override
+  int get hashCode =>
+      Object.hash(x, y, width, height, format, quality, chromaSubsampling, maxWidth, maxHeight, scale);
+
+  @override
+  String toString() {
+    return 'BatchRect(x: $x, y: $y, width: $width, height: $height, format: $format, quality: $quality, chromaSubsampling: $chromaSubsampling, maxWidth: $maxWidth, maxHeight: $maxHeight, scale: $scale)';
+  }
+}
@@ -0,0 +1,84 @@
+/// Format of the bytes returned by a capture.
+enum CaptureFormat {
+  /// PNG-encoded image (default).
+  png,
+
+  /// Unencoded 8-bit BGRA pixels, top-down rows of [CapturedData.stride] bytes.
+  ///
+  /// This is the native Windows layout, so no conversion is done.
+  rawBgra,
+
+  /// Unencoded 8-bit RGBA pixels, top-down rows of [CapturedData.stride] bytes.
+  rawRgba,
+
+  /// QOI-encoded image (https://qoiformat.org): lossless, several times
+  /// faster to encode than PNG at a somewhat larger size.
+  qoi,
+
+  /// Standard LZ4 frame wrapping BGRA pixels laid out as for [rawBgra].
+  ///
+  /// The fastest lossless option for high-frequency pipelines; unpack with
+  /// any LZ4 frame decoder.
+  lz4Bgra,
+
+  /// Lossy baseline JPEG; see `quality` and `chromaSubsampling` on
+  /// `Screenshot.capture`.
+  jpeg,
+
+  /// Lossy WebP, usually smaller than [jpeg] at the same quality.
+  ///
+  /// Only available when the plugin was built with libwebp; otherwise the
+  /// capture fails with a `not_supported` `ScreenshotException`.
+  webp,
+}
+
+/// Extension methods for [CaptureFormat] serialization.
+extension CaptureFormatExtension on CaptureFormat {
+  /// Convert enum to string for method channel serialization.
+  String toValue() {
+    switch (this) {
+      case CaptureFormat.png:
+        return 'png';
+      case CaptureFormat.rawBgra:
+        return 'raw_bgra';
+      case CaptureFormat.rawRgba:
+        return 'raw_rgba';
+      case CaptureFormat.qoi:
+        return 'qoi';
+      case CaptureFormat.lz4Bgra:
+        return 'lz4_bgra';
+      case CaptureFormat.jpeg:
+        return 'jpeg';
+      case CaptureFormat.webp:
+        return 'webp';
+    }
+  }
+
+  /// Whether the bytes are unencoded pixels.
+  bool get isRaw => this == CaptureFormat.rawBgra || this == CaptureFormat.rawRgba;
+
+  /// Whether the format discards detail, as controlled by `quality`.
+  bool get isLossy => this == CaptureFormat.jpeg || this == CaptureFormat.webp;
+
+  /// Create [CaptureFormat] from string value.
+  static CaptureFormat fromValue(String value) {
+    switch (value) {
+      case 'png':
+        return CaptureFormat.png;
+      case 'raw_bgra':
+        return CaptureFormat.rawBgra;
+      case 'raw_rgba':
+        return CaptureFormat.rawRgba;
+      case 'qoi':
+        return CaptureFormat.qoi;
+      case 'lz4_bgra':
+        return CaptureFormat.lz4Bgra;
+      case 'jpeg':
+        return CaptureFormat.jpeg;
+      case 'webp':
+        return CaptureFormat.webp;
+      default:
+        throw ArgumentError('Invalid CaptureFormat value: $value');
+    }
+  }
+}
@@ -1,3 +1,5 @@
+import 'capture_format.dart';
+import 'chroma_subsampling.dart';
 import 'screenshot_mode.dart';
 
 /// Internal model for capture request parameters.
@@ -10,6 +12,12 @@ class CaptureRequest {
     required this.mode,
     this.includeCursor = false,
     this.displayId,
+    this.format = CaptureFormat.png,
+    this.quality,
+    this.chromaSubsampling,
+    this.maxWidth,
+    this.maxHeight,
+    this.scale,
   });
 
   /// Screenshot capture mode (screen or region).
@@ -21,12 +29,36 @@ class CaptureRequest {
   /// Optional display ID for multi-monitor setups (null = primary display).
   final int? displayId;
 
+  /// Format of the returned bytes (PNG or raw pixels).
+  final CaptureFormat format;
+
+  /// Lossy encoding quality, 1-100 (null = native default of 85).
+  final int? quality;
+
+  /// Chroma subsampling for lossy formats (null = native default of 4:2:0).
+  final ChromaSubsampling? chromaSubsampling;
+
+  /// Largest width of the returned image (null = no limit).
+  final int? maxWidth;
+
+  /// Largest height of the returned image (null = no limit).
+  final int? maxHeight;
+
+  /// Factor in (0, 1] the capture is scaled by natively (null = 1).
+  final double? scale;
+
   /// Convert [CaptureRequest] to map for method channel.
   Map<String, dynamic> toMap() {
     return <String, dynamic>{
       'mode': mode.toValue(),
       'includeCursor': includeCursor,
       if (displayId != null) 'displayId': displayId,
+      'format': format.toValue(),
+      if (quality != null) 'quality': quality,
+      if (chromaSubsampling != null) 'chromaSubsampling': chromaSubsampling!.toValue(),
+      if (maxWidth != null) 'maxWidth': maxWidth,
+      if (maxHeight != null) 'maxHeight': maxHeight,
+      if (scale != null) 'scale': scale,
     };
   }
 
@@ -36,6 +68,16 @@ class CaptureRequest {
       mode: ScreenshotModeExtension.fromValue(map['mode'] as String),
       includeCursor: map['includeCursor'] as bool? ?? false,
       displayId: map['displayId'] as int?,
+      format: map['format'] == null
+          ? CaptureFormat.png
+          : CaptureFormatExtension.fromValue(map['format'] as String),
+      quality: map['quality'] as int?,
+      chromaSubsampling: map['chromaSubsampling'] == null
+          ? null
+          : ChromaSubsamplingExtension.fromValue(map['chromaSubsampling'] as String),
+      maxWidth: map['maxWidth'] as int?,
+      maxHeight: map['maxHeight'] as int?,
+      scale: (map['scale'] as num?)?.toDouble(),
     );
   }
 
@@ -46,14 +88,21 @@ class CaptureRequest {
     return other is CaptureRequest &&
         other.mode == mode &&
         other.includeCursor == includeCursor &&
-        other.displayId == displayId;
+        other.displayId == displayId &&
+        other.format == format &&
+        other.quality == quality &&
+        other.chromaSubsampling == chromaSubsampling &&
+        other.maxWidth == maxWidth &&
+        other.maxHeight == maxHeight &&
+        other.scale == scale;
   }
 
   @override
-  int get hashCode => Object.hash(mode, includeCursor, displayId);
+  int get hashCode => Object.hash(
+      mode, includeCursor, displayId, format, quality, chromaSubsampling, maxWidth, maxHeight, scale);
 
   @override
   String toString() {
-    return 'CaptureRequest(mode: $mode, includeCursor: $includeCursor, displayId: $displayId)';
+    return 'CaptureRequest(mode: $mode, includeCursor: $includeCursor, displayId: $displayId, format: $format, quality: $quality, chromaSubsampling: $chromaSubsampling, maxWidth: $maxWidth, maxHeight: $maxHeight, scale: $scale)';
   }
 }
@@ -0,0 +1,212 @@
+/// Latency of one stage of the captures, as reported by
+/// `Screenshot.getStats`.
+///
+/// Times are in microseconds. Percentiles are within 1/16 of the true
+/// value; [maxUs] and [meanUs] are exact.
+class StageStats {
+  /// Creates a [StageStats] instance.
+  const StageStats({
+    this.count = 0,
+    this.errors = 0,
+    this.p50Us = 0,
+    this.p95Us = 0,
+    this.p99Us = 0,
+    this.maxUs = 0,
+    this.meanUs = 0,
+  });
+
+  /// Captures that went through this stage.
+  final int count;
+
+  /// Captures that failed in this stage; they are not in [count].
+  final int errors;
+
+  /// Median time.
+  final double p50Us;
+
+  /// 95th percentile time.
+  final double p95Us;
+
+  /// 99th percentile time.
+  final double p99Us;
+
+  /// Longest time.
+  final double maxUs;
+
+  /// Mean time.
+  final double meanUs;
+
+  /// Create [StageStats] from a method channel response map.
+  factory StageStats.fromMap(Map<Object?, Object?> map) {
+    return StageStats(
+      count: map['count'] as int? ?? 0,
+      errors: map['errors'] as int? ?? 0,
+      p50Us: (map['p50Us'] as num? ?? 0).toDouble(),
+      p95Us: (map['p95Us'] as num? ?? 0).toDouble(),
+      p99Us: (map['p99Us'] as num? ?? 0).toDouble(),
+      maxUs: (map['maxUs'] as num? ?? 0).toDouble(),
+      meanUs: (map['meanUs'] as num? ?? 0).toDouble(),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'StageStats(count: $count, errors: $errors, p50Us: $p50Us, '
+        'p95Us: $p95Us, p99Us: $p99Us, maxUs: $maxUs, meanUs: $meanUs)';
+  }
+}
+
+/// Counters of the native frame buffer pool captures are read into.
+class FramePoolStats {
+  /// Creates a [FramePoolStats] instance.
+  const FramePoolStats({
+    this.hits = 0,
+    this.misses = 0,
+    this.evictions = 0,
+    this.buffers = 0,
+    this.residentBytes = 0,
+    this.leasedBytes = 0,
+  });
+
+  /// Captures that reused a buffer.
+  final int hits;
+
+  /// Captures that had to allocate one.
+  final int misses;
+
+  /// Idle buffers freed to keep the pool under its size cap.
+  final int evictions;
+
+  /// Buffers held, in use or idle.
+  final int buffers;
+
+  /// Bytes held, in use or idle.
+  final int residentBytes;
+
+  /// Bytes of the buffers in use.
+  final int leasedBytes;
+
+  /// Create [FramePoolStats] from a method channel response map.
+  factory FramePoolStats.fromMap(Map<Object?, Object?> map) {
+    return FramePoolStats(
+      hits: map['hits'] as int? ?? 0,
+      misses: map['misses'] as int? ?? 0,
+      evictions: map['evictions'] as int? ?? 0,
+      buffers: map['buffers'] as int? ?? 0,
+      residentBytes: map['residentBytes'] as int? ?? 0,
+      leasedBytes: map['leasedBytes'] as int? ?? 0,
+    );
+  }
+
+  @override
+  String toString() {
+    return 'FramePoolStats(hits: $hits, misses: $misses, evictions: $evictions, '
+        'buffers: $buffers, residentBytes: $residentBytes, leasedBytes: $leasedBytes)';
+  }
+}
+
+/// Counters of the stream started by `Screenshot.startStream`, since it
+/// was last started.
+class StreamStats {
+  /// Creates a [StreamStats] instance.
+  const StreamStats({
+    this.captured = 0,
+    this.delivered = 0,
+    this.dropped = 0,
+    this.failed = 0,
+    this.skipped = 0,
+  });
+
+  /// Frames captured.
+  final int captured;
+
+  /// Frames encoded and sent.
+  final int delivered;
+
+  /// Frames replaced by a newer one before they could be encoded.
+  final int dropped;
+
+  /// Captures that failed.
+  final int failed;
+
+  /// Frames not captured because capturing fell behind the frame rate.
+  final int skipped;
+
+  /// Create [StreamStats] from a method channel response map.
+  factory StreamStats.fromMap(Map<Object?, Object?> map) {
+    return StreamStats(
+      captured: map['captured'] as int? ?? 0,
+      delivered: map['delivered'] as int? ?? 0,
+      dropped: map['dropped'] as int? ?? 0,
+      failed: map['failed'] as int? ?? 0,
+      skipped: map['skipped'] as int? ?? 0,
+    );
+  }
+
+  @override
+  String toString() {
+    return 'StreamStats(captured: $captured, delivered: $delivered, '
+        'dropped: $dropped, failed: $failed, skipped: $skipped)';
+  }
+}
+
+/// Where captures have spent their time, as reported by
+/// `Screenshot.getStats`.
+class CaptureStats {
+  /// Creates a [CaptureStats] instance.
+  const CaptureStats({
+    this.stages = const <String, StageStats>{},
+    this.capturedBytes = 0,
+    this.outputBytes = 0,
+    this.framePool = const FramePoolStats(),
+    this.stream = const StreamStats(),
+  });
+
+  /// Names of the stages in [stages], in the order a capture goes through
+  /// them. `total` runs from the start of the capture until its result is
+  /// sent.
+  static const List<String> stageNames = <String>['capture', 'cursor', 'scale', 'encode', 'total'];
+
+  /// Latency of each stage, by name (see [stageNames]).
+  final Map<String, StageStats> stages;
+
+  /// Bytes read from the screen.
+  final int capturedBytes;
+
+  /// Bytes of the results: encoded images, raw pixels or files.
+  final int outputBytes;
+
+  /// The native frame buffer pool.
+  final FramePoolStats framePool;
+
+  /// The capture stream.
+  final StreamStats stream;
+
+  /// The stage named [name], empty if no capture went through it.
+  StageStats stage(String name) => stages[name] ?? const StageStats();
+
+  /// Create [CaptureStats] from a method channel response map.
+  factory CaptureStats.fromMap(Map<Object?, Object?> map) {
+    final Map<Object?, Object?> stages = map['stages'] as Map<Object?, Object?>? ?? const <Object?, Object?>{};
+    return CaptureStats(
+      stages: <String, StageStats>{
+        for (final MapEntry<Object?, Object?> entry in stages.entries)
+          entry.key! as String: StageStats.fromMap(entry.value! as Map<Object?, Object?>),
+      },
+      capturedBytes: map['capturedBytes'] as int? ?? 0,
+      outputBytes: map['outputBytes'] as int? ?? 0,
+      framePool: map['framePool'] == null
+          ? const FramePoolStats()
+          : FramePoolStats.fromMap(map['framePool']! as Map<Object?, Object?>),
+      stream: map['stream'] == null
+          ? const StreamStats()
+          : StreamStats.fromMap(map['stream']! as Map<Object?, Object?>),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'CaptureStats(stages: $stages, capturedBytes: $capturedBytes, '
+        'outputBytes: $outputBytes, framePool: $framePool, stream: $stream)';
+  }
+}
@@ -1,5 +1,7 @@
 import 'dart:typed_data';
 
+import 'capture_format.dart';
+
 /// Represents captured screenshot data with dimensions and pixel bytes.
 ///
 /// This class is immutable and follows type safety principles.
@@ -11,9 +13,12 @@ class CapturedData {
     required this.width,
     required this.height,
     required this.bytes,
+    this.format = CaptureFormat.png,
+    this.stride = 0,
   }) : assert(width > 0, 'Width must be positive'),
        assert(height > 0, 'Height must be positive'),
-       assert(bytes.length > 0, 'Bytes must not be empty');
+       assert(bytes.length > 0, 'Bytes must not be empty'),
+       assert(stride >= 0, 'Stride must not be negative');
 
   /// Width of the captured image in pixels.
   final int width;
@@ -21,21 +26,39 @@ class CapturedData {
   /// Height of the captured image in pixels.
   final int height;
 
-  /// PNG-encoded image data as bytes.
+  /// Image data: PNG-encoded or raw pixels, depending on [format].
   final Uint8List bytes;
 
+  /// Format of [bytes].
+  final CaptureFormat format;
+
+  /// Bytes per row of raw (or LZ4-framed) pixels; 0 for image formats.
+  final int stride;
+
   /// Create [CapturedData] from method channel response map.
   factory CapturedData.fromMap(Map<Object?, Object?> map) {
     final int width = map['width'] as int;
     final int height = map['height'] as int;
     final Uint8List bytes = map['bytes'] as Uint8List;
+    // Older platform implementations only return PNG without these fields.
+    final String? pixelFormat = map['pixelFormat'] as String?;
+    final CaptureFormat format = pixelFormat == null
+        ? CaptureFormat.png
+        : CaptureFormatExtension.fromValue(pixelFormat);
+    final int stride = map['stride'] as int? ?? 0;
 
-    return CapturedData(width: width, height: height, bytes: bytes);
+    return CapturedData(width: width, height: height, bytes: bytes, format: format, stride: stride);
   }
 
   /// Convert [CapturedData] to map for method channel.
   Map<String, dynamic> toMap() {
-    return <String, dynamic>{'width': width, 'height': height, 'bytes': bytes};
+    return <String, dynamic>{
+      'width': width,
+      'height': height,
+      'stride': stride,
+      'pixelFormat': format.toValue(),
+      'bytes': bytes,
+    };
   }
 
   @override
@@ -45,6 +68,8 @@ class CapturedData {
     return other is CapturedData &&
         other.width == width &&
         other.height == height &&
+        other.format == format &&
+        other.stride == stride &&
         _listEquals(other.bytes, bytes);
   }
 
@@ -53,6 +78,8 @@ class CapturedData {
     int result = 17;
     result = 37 * result + width.hashCode;
     result = 37 * result + height.hashCode;
+    result = 37 * result + format.hashCode;
+    result = 37 * result + stride.hashCode;
     // Hash bytes content, not identity
     for (final int byte in bytes) {
       result = 37 * result + byte.hashCode;
@@ -71,6 +98,7 @@ class CapturedData {
 
   @override
   String toString() {
-    return 'CapturedData(width: $width, height: $height, bytes: ${bytes.length} bytes)';
+    return 'CapturedData(width: $width, height: $height, format: ${format.toValue()}, '
+        'stride: $stride, bytes: ${bytes.length} bytes)';
   }
 }
@@ -0,0 +1,84 @@
+import 'capture_format.dart';
+
+/// A screenshot written to disk by `Screenshot.captureToFile`.
+///
+/// The image itself never reaches Dart: it is encoded straight into the
+/// file, and only its size and what the write cost are reported back.
+class CapturedFile {
+  /// Creates a [CapturedFile] instance.
+  const CapturedFile({
+    required this.path,
+    required this.width,
+    required this.height,
+    required this.byteCount,
+    required this.elapsed,
+    this.format = CaptureFormat.png,
+  }) : assert(width > 0, 'Width must be positive'),
+       assert(height > 0, 'Height must be positive'),
+       assert(byteCount >= 0, 'Byte count must not be negative');
+
+  /// Path of the written file.
+  final String path;
+
+  /// Width of the captured image in pixels.
+  final int width;
+
+  /// Height of the captured image in pixels.
+  final int height;
+
+  /// Format of the file's contents.
+  final CaptureFormat format;
+
+  /// Size of the file in bytes.
+  final int byteCount;
+
+  /// Time from the start of the screen copy until the file was complete.
+  final Duration elapsed;
+
+  /// Create [CapturedFile] from a method channel response map.
+  factory CapturedFile.fromMap(Map<Object?, Object?> map) {
+    final String? pixelFormat = map['pixelFormat'] as String?;
+    return CapturedFile(
+      path: map['path'] as String,
+      width: map['width'] as int,
+      height: map['height'] as int,
+      format: pixelFormat == null ? CaptureFormat.png : CaptureFormatExtension.fromValue(pixelFormat),
+      byteCount: map['byteCount'] as int,
+      elapsed: Duration(microseconds: map['elapsedUs'] as int),
+    );
+  }
+
+  /// Convert [CapturedFile] to map for method channel.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      'path': path,
+      'width': width,
+      'height': height,
+      'pixelFormat': format.toValue(),
+      'byteCount': byteCount,
+      'elapsedUs': elapsed.inMicroseconds,
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is CapturedFile &&
+        other.path == path &&
+        other.width == width &&
+        other.height == height &&
+        other.format == format &&
+        other.byteCount == byteCount &&
+        other.elapsed == elapsed;
+  }
+
+  @override
+  int get hashCode => Object.hash(path, width, height, format, byteCount, elapsed);
+
+  @override
+  String toString() {
+    return 'CapturedFile(path: $path, width: $width, height: $height, format: ${format.toValue()}, '
+        'byteCount: $byteCount, elapsed: $elapsed)';
+  }
+}
@@ -0,0 +1,80 @@
+import 'captured_data.dart';
+
+/// A frame delivered by `Screenshot.frames` while a stream is running.
+///
+/// Frames arrive in capture order. When encoding or the listener cannot keep
+/// up, older frames are dropped rather than queued, so [sequence] may skip
+/// values; [dropped] counts the frames skipped so far. Frames that could not
+/// be captured or encoded are skipped too, and counted in [failed].
+class CapturedFrame {
+  /// Creates a [CapturedFrame] instance.
+  const CapturedFrame({
+    required this.sequence,
+    required this.timestamp,
+    required this.data,
+    this.dropped = 0,
+    this.failed = 0,
+  }) : assert(sequence >= 0, 'Sequence must not be negative'),
+       assert(dropped >= 0, 'Dropped must not be negative'),
+       assert(failed >= 0, 'Failed must not be negative');
+
+  /// Position of the frame in capture order, starting at 0 for each stream.
+  final int sequence;
+
+  /// Monotonic time the capture started.
+  ///
+  /// Only differences between timestamps are meaningful; they are not
+  /// related to wall-clock time.
+  final Duration timestamp;
+
+  /// The captured image, as returned by `Screenshot.capture`.
+  final CapturedData data;
+
+  /// Frames dropped since the stream started.
+  final int dropped;
+
+  /// Frames that failed to capture or encode since the stream started.
+  final int failed;
+
+  /// Create [CapturedFrame] from an event channel map.
+  factory CapturedFrame.fromMap(Map<Object?, Object?> map) {
+    return CapturedFrame(
+      sequence: map['sequence'] as int,
+      timestamp: Duration(microseconds: map['timestampUs'] as int),
+      data: CapturedData.fromMap(map),
+      dropped: map['dropped'] as int? ?? 0,
+      failed: map['failed'] as int? ?? 0,
+    );
+  }
+
+  /// Convert [CapturedFrame] to an event channel map.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      ...data.toMap(),
+      'sequence': sequence,
+      'timestampUs': timestamp.inMicroseconds,
+      'dropped': dropped,
+      'failed': failed,
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is CapturedFrame &&
+        other.sequence == sequence &&
+        other.timestamp == timestamp &&
+        other.dropped == dropped &&
+        other.failed == failed &&
+        other.data == data;
+  }
+
+  @override
+  int get hashCode => Object.hash(sequence, timestamp, dropped, failed, data);
+
+  @override
+  String toString() {
+    return 'CapturedFrame(sequence: $sequence, timestamp: $timestamp, dropped: $dropped, failed: $failed, data: $data)';
+  }
+}
@@ -0,0 +1,99 @@
+/// Fingerprints of a screen capture from `Screenshot.captureHash`.
+///
+/// Each hash is a 64-bit value held in a Dart int (so it may be negative);
+/// a hash that was not asked for is null.
+class CapturedHash {
+  /// Creates a [CapturedHash] instance.
+  const CapturedHash({
+    required this.x,
+    required this.y,
+    required this.width,
+    required this.height,
+    this.xxh3,
+    this.dHash,
+    this.pHash,
+  });
+
+  /// Left edge of the hashed rectangle, clipped to the screen.
+  final int x;
+
+  /// Top edge of the hashed rectangle, clipped to the screen.
+  final int y;
+
+  /// Width of the hashed rectangle.
+  final int width;
+
+  /// Height of the hashed rectangle.
+  final int height;
+
+  /// XXH3-64 of the pixels as `CaptureFormat.rawBgra` would return them.
+  /// Equal only for identical pixels.
+  final int? xxh3;
+
+  /// Difference hash; compare with [hammingDistance].
+  final int? dHash;
+
+  /// DCT-based perceptual hash; compare with [hammingDistance].
+  final int? pHash;
+
+  /// Number of bits that differ between two perceptual hashes: 0 for the
+  /// same picture, a handful for near-duplicates, around 32 for unrelated
+  /// ones.
+  static int hammingDistance(int a, int b) {
+    int bits = a ^ b;
+    int count = 0;
+    while (bits != 0) {
+      bits &= bits - 1;
+      count++;
+    }
+    return count;
+  }
+
+  /// Create [CapturedHash] from a method channel response map.
+  factory CapturedHash.fromMap(Map<Object?, Object?> map) {
+    return CapturedHash(
+      x: map['x'] as int,
+      y: map['y'] as int,
+      width: map['width'] as int,
+      height: map['height'] as int,
+      xxh3: map['xxh3'] as int?,
+      dHash: map['dhash'] as int?,
+      pHash: map['phash'] as int?,
+    );
+  }
+
+  /// Convert [CapturedHash] to map for method channel.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      'x': x,
+      'y': y,
+      'width': width,
+      'height': height,
+      if (xxh3 != null) 'xxh3': xxh3,
+      if (dHash != null) 'dhash': dHash,
+      if (pHash != null) 'phash': pHash,
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is CapturedHash &&
+        other.x == x &&
+        other.y == y &&
+        other.width == width &&
+        other.height == height &&
+        other.xxh3 == xxh3 &&
+        other.dHash == dHash &&
+        other.pHash == pHash;
+  }
+
+  @override
+  int get hashCode => Object.hash(x, y, width, height, xxh3, dHash, pHash);
+
+  @override
+  String toString() {
+    return 'CapturedHash(x: $x, y: $y, width: $width, height: $height, xxh3: $xxh3, dHash: $dHash, pHash: $pHash)';
+  }
+}
@@ -0,0 +1,186 @@
+import 'dart:typed_data';
+
+import 'capture_format.dart';
+
+/// One changed tile of a [CapturedTiles] result.
+///
+/// The tile covers [width] x [height] pixels at ([x], [y]) in the captured
+/// screen. Tiles on the right and bottom edges may be smaller than
+/// [CapturedTiles.tileSize].
+class CapturedTile {
+  /// Creates a [CapturedTile] instance.
+  const CapturedTile({
+    required this.x,
+    required this.y,
+    required this.width,
+    required this.height,
+    required this.bytes,
+    this.stride = 0,
+  }) : assert(x >= 0, 'X must not be negative'),
+       assert(y >= 0, 'Y must not be negative'),
+       assert(width > 0, 'Width must be positive'),
+       assert(height > 0, 'Height must be positive'),
+       assert(stride >= 0, 'Stride must not be negative');
+
+  /// Left edge of the tile in screen pixels.
+  final int x;
+
+  /// Top edge of the tile in screen pixels.
+  final int y;
+
+  /// Width of the tile in pixels.
+  final int width;
+
+  /// Height of the tile in pixels.
+  final int height;
+
+  /// The tile's pixels, in the [CapturedTiles.format] of the result.
+  final Uint8List bytes;
+
+  /// Bytes per row of raw (or LZ4-framed) pixels; 0 for image formats.
+  final int stride;
+
+  /// Create [CapturedTile] from a method channel tile map.
+  factory CapturedTile.fromMap(Map<Object?, Object?> map) {
+    return CapturedTile(
+      x: map['x'] as int,
+      y: map['y'] as int,
+      width: map['width'] as int,
+      height: map['height'] as int,
+      bytes: map['bytes'] as Uint8List,
+      stride: map['stride'] as int? ?? 0,
+    );
+  }
+
+  /// Convert [CapturedTile] to map for method channel.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      'x': x,
+      'y': y,
+      'width': width,
+      'height': height,
+      'stride': stride,
+      'bytes': bytes,
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is CapturedTile &&
+        other.x == x &&
+        other.y == y &&
+        other.width == width &&
+        other.height == height &&
+        other.stride == stride &&
+        _listEquals(other.bytes, bytes);
+  }
+
+  @override
+  int get hashCode => Object.hash(x, y, width, height, stride, Object.hashAll(bytes));
+
+  @override
+  String toString() {
+    return 'CapturedTile(x: $x, y: $y, width: $width, height: $height, '
+        'stride: $stride, bytes: ${bytes.length} bytes)';
+  }
+}
+
+/// The parts of the screen that changed since the previous
+/// `Screenshot.captureTiles` call.
+///
+/// Apply [tiles] on top of the previous frame to get the current one. When
+/// [keyframe] is true the tiles cover the whole screen and replace it.
+class CapturedTiles {
+  /// Creates a [CapturedTiles] instance.
+  const CapturedTiles({
+    required this.width,
+    required this.height,
+    required this.keyframe,
+    required this.tileSize,
+    required this.tiles,
+    this.format = CaptureFormat.png,
+  }) : assert(width > 0, 'Width must be positive'),
+       assert(height > 0, 'Height must be positive'),
+       assert(tileSize > 0, 'Tile size must be positive');
+
+  /// Width of the captured screen in pixels.
+  final int width;
+
+  /// Height of the captured screen in pixels.
+  final int height;
+
+  /// Whether [tiles] cover the whole screen rather than just the changes.
+  ///
+  /// The first capture, a capture after the screen size or [tileSize]
+  /// changed, and a capture that asked for a keyframe are keyframes.
+  final bool keyframe;
+
+  /// Edge length of the tile grid in pixels.
+  final int tileSize;
+
+  /// Changed tiles in row-major order; empty if nothing changed.
+  final List<CapturedTile> tiles;
+
+  /// Format of each tile's bytes.
+  final CaptureFormat format;
+
+  /// Create [CapturedTiles] from method channel response map.
+  factory CapturedTiles.fromMap(Map<Object?, Object?> map) {
+    final List<Object?> tiles = map['tiles'] as List<Object?>;
+    final String? pixelFormat = map['pixelFormat'] as String?;
+    return CapturedTiles(
+      width: map['width'] as int,
+      height: map['height'] as int,
+      keyframe: map['keyframe'] as bool,
+      tileSize: map['tileSize'] as int,
+      tiles: List<CapturedTile>.unmodifiable(
+        tiles.map((Object? tile) => CapturedTile.fromMap(tile! as Map<Object?, Object?>)),
+      ),
+      format: pixelFormat == null ? CaptureFormat.png : CaptureFormatExtension.fromValue(pixelFormat),
+    );
+  }
+
+  /// Convert [CapturedTiles] to map for method channel.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      'width': width,
+      'height': height,
+      'keyframe': keyframe,
+      'tileSize': tileSize,
+      'pixelFormat': format.toValue(),
+      'tiles': tiles.map((CapturedTile tile) => tile.toMap()).toList(),
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is CapturedTiles &&
+        other.width == width &&
+        other.height == height &&
+        other.keyframe == keyframe &&
+        other.tileSize == tileSize &&
+        other.format == format &&
+        _listEquals(other.tiles, tiles);
+  }
+
+  @override
+  int get hashCode => Object.hash(width, height, keyframe, tileSize, format, Object.hashAll(tiles));
+
+  @override
+  String toString() {
+    return 'CapturedTiles(width: $width, height: $height, keyframe: $keyframe, '
+        'tileSize: $tileSize, format: ${format.toValue()}, tiles: ${tiles.length})';
+  }
+}
+
+bool _listEquals<T>(List<T> a, List<T> b) {
+  if (a.length != b.length) return false;
+  for (int index = 0; index < a.length; index += 1) {
+    if (a[index] != b[index]) return false;
+  }
+  return true;
+}
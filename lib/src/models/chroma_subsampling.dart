@@ -0,0 +1,46 @@
+import 'capture_format.dart';
+
+/// Chroma resolution of lossy captures relative to luma.
+///
+/// Only [CaptureFormat.jpeg] stores chroma at every resolution; lossy WebP is
+/// always 4:2:0 and uses sharper RGB->YUV conversion when asked for more.
+enum ChromaSubsampling {
+  /// Full-resolution chroma (4:4:4): best for text and colored UI edges.
+  chroma444,
+
+  /// Half horizontal chroma resolution (4:2:2).
+  chroma422,
+
+  /// Half horizontal and vertical chroma resolution (4:2:0, default):
+  /// smallest output.
+  chroma420,
+}
+
+/// Extension methods for [ChromaSubsampling] serialization.
+extension ChromaSubsamplingExtension on ChromaSubsampling {
+  /// Convert enum to string for method channel serialization.
+  String toValue() {
+    switch (this) {
+      case ChromaSubsampling.chroma444:
+        return '444';
+      case ChromaSubsampling.chroma422:
+        return '422';
+      case ChromaSubsampling.chroma420:
+        return '420';
+    }
+  }
+
+  /// Create [ChromaSubsampling] from string value.
+  static ChromaSubsampling fromValue(String value) {
+    switch (value) {
+      case '444':
+        return ChromaSubsampling.chroma444;
+      case '422':
+        return ChromaSubsampling.chroma422;
+      case '420':
+        return ChromaSubsampling.chroma420;
+      default:
+        throw ArgumentError('Invalid ChromaSubsampling value: $value');
+    }
+  }
+}
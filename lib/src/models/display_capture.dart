@@ -0,0 +1,64 @@
+import 'captured_data.dart';
+
+/// One display's image from `Screenshot.captureAllDisplays`.
+class DisplayCapture {
+  /// Creates a [DisplayCapture] instance.
+  const DisplayCapture({
+    required this.displayId,
+    required this.x,
+    required this.y,
+    required this.data,
+  });
+
+  /// Id of the captured display, as in `Screenshot.listDisplays`.
+  final int displayId;
+
+  /// Left edge of the display on the virtual desktop.
+  final int x;
+
+  /// Top edge of the display on the virtual desktop.
+  final int y;
+
+  /// The display's image.
+  final CapturedData data;
+
+  /// Create [DisplayCapture] from a method channel response map: a capture
+  /// result with the display's `displayId`, `x` and `y` added.
+  factory DisplayCapture.fromMap(Map<Object?, Object?> map) {
+    return DisplayCapture(
+      displayId: map['displayId'] as int,
+      x: map['x'] as int,
+      y: map['y'] as int,
+      data: CapturedData.fromMap(map),
+    );
+  }
+
+  /// Convert [DisplayCapture] to map for method channel.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      ...data.toMap(),
+      'displayId': displayId,
+      'x': x,
+      'y': y,
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is DisplayCapture &&
+        other.displayId == displayId &&
+        other.x == x &&
+        other.y == y &&
+        other.data == data;
+  }
+
+  @override
+  int get hashCode => Object.hash(displayId, x, y, data);
+
+  @override
+  String toString() {
+    return 'DisplayCapture(displayId: $displayId, x: $x, y: $y, data: $data)';
+  }
+}
@@ -0,0 +1,88 @@
+/// A display of the virtual desktop, as listed by `Screenshot.listDisplays`.
+///
+/// Positions are in virtual-desktop pixels with the primary display's top
+/// left at (0, 0), so displays left of or above it have negative [x] or [y].
+class DisplayInfo {
+  /// Creates a [DisplayInfo] instance.
+  const DisplayInfo({
+    required this.id,
+    required this.x,
+    required this.y,
+    required this.width,
+    required this.height,
+    this.isPrimary = false,
+    this.name = '',
+  }) : assert(width > 0, 'Width must be positive'),
+       assert(height > 0, 'Height must be positive');
+
+  /// The id to pass as `displayId` to capture this display.
+  final int id;
+
+  /// Left edge of the display.
+  final int x;
+
+  /// Top edge of the display.
+  final int y;
+
+  /// Width of the display in pixels.
+  final int width;
+
+  /// Height of the display in pixels.
+  final int height;
+
+  /// Whether this is the primary display.
+  final bool isPrimary;
+
+  /// The platform's name for the display, such as `\\.\DISPLAY2`; may be
+  /// empty.
+  final String name;
+
+  /// Create [DisplayInfo] from a method channel response map.
+  factory DisplayInfo.fromMap(Map<Object?, Object?> map) {
+    return DisplayInfo(
+      id: map['id'] as int,
+      x: map['x'] as int,
+      y: map['y'] as int,
+      width: map['width'] as int,
+      height: map['height'] as int,
+      isPrimary: map['primary'] as bool? ?? false,
+      name: map['name'] as String? ?? '',
+    );
+  }
+
+  /// Convert [DisplayInfo] to map for method channel.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      'id': id,
+      'x': x,
+      'y': y,
+      'width': width,
+      'height': height,
+      'primary': isPrimary,
+      'name': name,
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is DisplayInfo &&
+        other.id == id &&
+        other.x == x &&
+        other.y == y &&
+        other.width == width &&
+        other.height == height &&
+        other.isPrimary == isPrimary &&
+        other.name == name;
+  }
+
+  @override
+  int get hashCode => Object.hash(id, x, y, width, height, isPrimary, name);
+
+  @override
+  String toString() {
+    return 'DisplayInfo(id: $id, x: $x, y: $y, width: $width, height: $height, '
+        'isPrimary: $isPrimary, name: $name)';
+  }
+}
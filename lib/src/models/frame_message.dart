@@ -0,0 +1,119 @@
+import 'dart:typed_data';
+
+import 'capture_format.dart';
+import 'captured_data.dart';
+
+/// What a [FrameMessage] carries.
+enum FrameMessageKind {
+  /// [FrameMessage.payload] is the captured image.
+  frame,
+
+  /// No result, e.g. a cancelled region selection.
+  none,
+
+  /// [FrameMessage.payload] is a `StandardMethodCodec` error envelope.
+  error,
+}
+
+/// A reply on the `dev.flutter.screenshot/frame` channel.
+///
+/// The native side sends a fixed little-endian header followed by the
+/// payload, instead of a map serialized by the method codec:
+///
+/// | offset | size | field                                   |
+/// |-------:|-----:|-----------------------------------------|
+/// |      0 |    4 | magic, `SSFM`                           |
+/// |      4 |    1 | kind ([FrameMessageKind] index)         |
+/// |      5 |    1 | format ([CaptureFormat] index)          |
+/// |      6 |    2 | header size in bytes                    |
+/// |      8 |    4 | width                                   |
+/// |     12 |    4 | height                                  |
+/// |     16 |    4 | stride                                  |
+/// |     20 |    4 | reserved                                |
+/// |     24 |    8 | sequence                                |
+/// |     32 |    8 | timestamp, monotonic microseconds       |
+///
+/// The payload starts at the header size given in the message.
+class FrameMessage {
+  /// Creates a [FrameMessage] instance.
+  const FrameMessage({
+    required this.kind,
+    required this.format,
+    required this.width,
+    required this.height,
+    required this.stride,
+    required this.sequence,
+    required this.timestamp,
+    required this.payload,
+  });
+
+  /// `SSFM`, read as a little-endian uint32.
+  static const int magic = 0x4D465353;
+
+  /// Size of the header this version writes.
+  static const int headerSize = 40;
+
+  /// What [payload] holds.
+  final FrameMessageKind kind;
+
+  /// Format of a [FrameMessageKind.frame] payload.
+  final CaptureFormat format;
+
+  /// Width of the captured image in pixels.
+  final int width;
+
+  /// Height of the captured image in pixels.
+  final int height;
+
+  /// Bytes per row of raw (or LZ4-framed) pixels; 0 for image formats.
+  final int stride;
+
+  /// Position of the capture among the requests on the frame channel.
+  final int sequence;
+
+  /// Monotonic time the capture started.
+  final Duration timestamp;
+
+  /// The bytes after the header, as a view into the received message.
+  final Uint8List payload;
+
+  /// Parses [data] without copying it: [payload] shares its buffer.
+  ///
+  /// Throws a [FormatException] if [data] is not a frame message.
+  factory FrameMessage.parse(ByteData data) {
+    if (data.lengthInBytes < headerSize || data.getUint32(0, Endian.little) != magic) {
+      throw const FormatException('Not a frame message');
+    }
+    final int kind = data.getUint8(4);
+    final int format = data.getUint8(5);
+    final int length = data.getUint16(6, Endian.little);
+    if (kind >= FrameMessageKind.values.length ||
+        format >= CaptureFormat.values.length ||
+        length < headerSize ||
+        length > data.lengthInBytes) {
+      throw const FormatException('Malformed frame message header');
+    }
+    return FrameMessage(
+      kind: FrameMessageKind.values[kind],
+      format: CaptureFormat.values[format],
+      width: data.getUint32(8, Endian.little),
+      height: data.getUint32(12, Endian.little),
+      stride: data.getUint32(16, Endian.little),
+      sequence: data.getInt64(24, Endian.little),
+      timestamp: Duration(microseconds: data.getInt64(32, Endian.little)),
+      payload: Uint8List.sublistView(data, length),
+    );
+  }
+
+  /// The captured image of a [FrameMessageKind.frame] message; [payload] is
+  /// used as the bytes without copying.
+  CapturedData toCapturedData() {
+    return CapturedData(width: width, height: height, bytes: payload, format: format, stride: stride);
+  }
+
+  @override
+  String toString() {
+    return 'FrameMessage(kind: ${kind.name}, format: ${format.toValue()}, width: $width, '
+        'height: $height, stride: $stride, sequence: $sequence, payload: ${payload.length} bytes)';
+  }
+}
@@ -0,0 +1,43 @@
+/// A fingerprint `Screenshot.captureHash` can compute.
+enum ImageHashKind {
+  /// Exact: XXH3-64 of the pixels. Any changed pixel changes it.
+  xxh3,
+
+  /// Perceptual difference hash: whether each of 8 x 8 samples of a shrunk
+  /// grayscale copy is darker than its right neighbour. Cheapest, and robust
+  /// to scaling and small color changes.
+  dHash,
+
+  /// Perceptual DCT hash: the 8 x 8 lowest frequencies of a 32 x 32
+  /// grayscale copy against their median. Robust to noise and compression.
+  pHash,
+}
+
+/// Extension methods for [ImageHashKind] serialization.
+extension ImageHashKindExtension on ImageHashKind {
+  /// Convert enum to string for method channel serialization.
+  String toValue() {
+    switch (this) {
+      case ImageHashKind.xxh3:
+        return 'xxh3';
+      case ImageHashKind.dHash:
+        return 'dhash';
+      case ImageHashKind.pHash:
+        return 'phash';
+    }
+  }
+
+  /// Create [ImageHashKind] from string value.
+  static ImageHashKind fromValue(String value) {
+    switch (value) {
+      case 'xxh3':
+        return ImageHashKind.xxh3;
+      case 'dhash':
+        return ImageHashKind.dHash;
+      case 'phash':
+        return ImageHashKind.pHash;
+      default:
+        throw ArgumentError('Invalid ImageHashKind value: $value');
+    }
+  }
+}
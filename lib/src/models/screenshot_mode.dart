@@ -5,6 +5,10 @@ enum ScreenshotMode {
 
   /// Select and capture a specific region interactively.
   region,
+
+  /// Capture the whole virtual desktop: every display, stitched together at
+  /// its place, with the gaps between displays black.
+  all,
 }
 
 /// Extension methods for [ScreenshotMode] serialization.
@@ -16,6 +20,8 @@ extension ScreenshotModeExtension on ScreenshotMode {
         return 'screen';
       case ScreenshotMode.region:
         return 'region';
+      case ScreenshotMode.all:
+        return 'all';
     }
   }
 
@@ -26,6 +32,8 @@ extension ScreenshotModeExtension on ScreenshotMode {
         return ScreenshotMode.screen;
       case 'region':
         return ScreenshotMode.region;
+      case 'all':
+        return ScreenshotMode.all;
       default:
         throw ArgumentError('Invalid ScreenshotMode value: $value');
     }
@@ -0,0 +1,102 @@
+import 'capture_format.dart';
+
+/// Where a `captureShared` result lies in the plugin's shared memory.
+///
+/// The bytes are [length] bytes at [offset] of the region [handle] (a file
+/// mapping `HANDLE` on Windows, a file descriptor elsewhere). The slot
+/// stays reserved for the caller until it is released with [generation];
+/// see `SharedCapture` for a mapped view that does both.
+class SharedFrame {
+  /// Creates a [SharedFrame] instance.
+  const SharedFrame({
+    required this.width,
+    required this.height,
+    required this.handle,
+    required this.offset,
+    required this.length,
+    required this.generation,
+    this.format = CaptureFormat.png,
+    this.stride = 0,
+  }) : assert(width > 0, 'Width must be positive'),
+       assert(height > 0, 'Height must be positive'),
+       assert(offset >= 0, 'Offset must not be negative'),
+       assert(length > 0, 'Length must be positive'),
+       assert(stride >= 0, 'Stride must not be negative');
+
+  /// Width of the captured image in pixels.
+  final int width;
+
+  /// Height of the captured image in pixels.
+  final int height;
+
+  /// Format of the bytes.
+  final CaptureFormat format;
+
+  /// Bytes per row of raw (or LZ4-framed) pixels; 0 for image formats.
+  final int stride;
+
+  /// The shared-memory region holding the bytes, valid in this process.
+  final int handle;
+
+  /// Start of the bytes in the region; a multiple of 64 KiB.
+  final int offset;
+
+  /// Number of bytes.
+  final int length;
+
+  /// Identifies this lease of the slot; pass it to `releaseShared`.
+  final int generation;
+
+  /// Create [SharedFrame] from a method channel response map.
+  factory SharedFrame.fromMap(Map<Object?, Object?> map) {
+    final String? pixelFormat = map['pixelFormat'] as String?;
+    return SharedFrame(
+      width: map['width'] as int,
+      height: map['height'] as int,
+      format: pixelFormat == null ? CaptureFormat.png : CaptureFormatExtension.fromValue(pixelFormat),
+      stride: map['stride'] as int? ?? 0,
+      handle: map['handle'] as int,
+      offset: map['offset'] as int,
+      length: map['length'] as int,
+      generation: map['generation'] as int,
+    );
+  }
+
+  /// Convert [SharedFrame] to map for method channel.
+  Map<String, dynamic> toMap() {
+    return <String, dynamic>{
+      'width': width,
+      'height': height,
+      'stride': stride,
+      'pixelFormat': format.toValue(),
+      'handle': handle,
+      'offset': offset,
+      'length': length,
+      'generation': generation,
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is SharedFrame &&
+        other.width == width &&
+        other.height == height &&
+        other.format == format &&
+        other.stride == stride &&
+        other.handle == handle &&
+        other.offset == offset &&
+        other.length == length &&
+        other.generation == generation;
+  }
+
+  @override
+  int get hashCode => Object.hash(width, height, format, stride, handle, offset, length, generation);
+
+  @override
+  String toString() {
+    return 'SharedFrame(width: $width, height: $height, format: ${format.toValue()}, '
+        'stride: $stride, handle: $handle, offset: $offset, length: $length, generation: $generation)';
+  }
+}
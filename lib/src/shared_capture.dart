@@ -0,0 +1,44 @@
+import 'dart:typed_data';
+
+import 'models/shared_frame.dart';
+import 'shared_memory.dart';
+
+/// A screenshot returned by `Screenshot.captureShared`, read in place from
+/// the plugin's shared memory.
+///
+/// [bytes] is valid until [release] is called. Release every capture once
+/// its bytes have been consumed: the plugin reuses a small, fixed set of
+/// slots, and captures fail while all of them are held.
+class SharedCapture {
+  /// Wraps [frame], already mapped as [view]. [onRelease] hands the slot
+  /// back to the plugin.
+  SharedCapture(this.frame, this._view, this._onRelease);
+
+  /// Where the capture lies, and its size and format.
+  final SharedFrame frame;
+
+  final SharedMemoryView _view;
+  final Future<void> Function(int generation) _onRelease;
+  bool _released = false;
+
+  /// The captured bytes, in [SharedFrame.format]. Not copied: this is a view
+  /// of the shared memory, and must not be used after [release].
+  Uint8List get bytes {
+    if (_released) {
+      throw StateError('SharedCapture used after release()');
+    }
+    return _view.bytes;
+  }
+
+  /// Whether [release] has been called.
+  bool get isReleased => _released;
+
+  /// Unmaps [bytes] and lets the plugin reuse the slot. Safe to call more
+  /// than once.
+  Future<void> release() async {
+    if (_released) return;
+    _released = true;
+    _view.unmap();
+    await _onRelease(frame.generation);
+  }
+}
@@ -0,0 +1,78 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+typedef _MapViewOfFileNative = Pointer<Void> Function(IntPtr, Uint32, Uint32, Uint32, IntPtr);
+typedef _MapViewOfFile = Pointer<Void> Function(int, int, int, int, int);
+typedef _UnmapViewOfFileNative = Int32 Function(Pointer<Void>);
+typedef _UnmapViewOfFile = int Function(Pointer<Void>);
+typedef _MmapNative = Pointer<Void> Function(Pointer<Void>, IntPtr, Int32, Int32, Int32, Int64);
+typedef _Mmap = Pointer<Void> Function(Pointer<Void>, int, int, int, int, int);
+typedef _MunmapNative = Int32 Function(Pointer<Void>, IntPtr);
+typedef _Munmap = int Function(Pointer<Void>, int);
+
+const int _fileMapRead = 0x0004;
+const int _protRead = 0x1;
+const int _mapShared = 0x01;
+
+/// A read-only mapping of part of a shared-memory region owned by the
+/// native side of the plugin.
+///
+/// [bytes] points straight at the shared memory; nothing is copied. It must
+/// not be used after [unmap].
+class SharedMemoryView {
+  SharedMemoryView._(this._address, this.bytes);
+
+  /// Maps [length] bytes at [offset] of the region identified by [handle]:
+  /// a file mapping `HANDLE` on Windows, a file descriptor elsewhere. Both
+  /// are only meaningful in the process that created them, which is the
+  /// one running this code. [offset] must be a multiple of 64 KiB.
+  ///
+  /// Throws an [OSError] if the region cannot be mapped.
+  factory SharedMemoryView.map({required int handle, required int offset, required int length}) {
+    if (length <= 0) {
+      throw ArgumentError.value(length, 'length', 'must be positive');
+    }
+    final Pointer<Void> address;
+    if (Platform.isWindows) {
+      address = _mapViewOfFile(handle, _fileMapRead, offset >> 32, offset & 0xFFFFFFFF, length);
+      if (address == nullptr) {
+        throw const OSError('MapViewOfFile failed');
+      }
+    } else {
+      address = _mmap(nullptr, length, _protRead, _mapShared, handle, offset);
+      if (address.address == -1) {
+        throw const OSError('mmap failed');
+      }
+    }
+    return SharedMemoryView._(address, address.cast<Uint8>().asTypedList(length));
+  }
+
+  final Pointer<Void> _address;
+  bool _mapped = true;
+
+  /// The mapped bytes.
+  final Uint8List bytes;
+
+  /// Whether [unmap] has not been called yet.
+  bool get isMapped => _mapped;
+
+  /// Removes the mapping. Safe to call more than once.
+  void unmap() {
+    if (!_mapped) return;
+    _mapped = false;
+    if (Platform.isWindows) {
+      _unmapViewOfFile(_address);
+    } else {
+      _munmap(_address, bytes.length);
+    }
+  }
+}
+
+final DynamicLibrary _kernel32 = DynamicLibrary.open('kernel32.dll');
+final _MapViewOfFile _mapViewOfFile = _kernel32.lookupFunction<_MapViewOfFileNative, _MapViewOfFile>('MapViewOfFile');
+final _UnmapViewOfFile _unmapViewOfFile = _kernel32.lookupFunction<_UnmapViewOfFileNative, _UnmapViewOfFile>(
+  'UnmapViewOfFile',
+);
+final _Mmap _mmap = DynamicLibrary.process().lookupFunction<_MmapNative, _Mmap>('mmap');
+final _Munmap _munmap = DynamicLibrary.process().lookupFunction<_MunmapNative, _Munmap>('munmap');
@@ -0,0 +1,95 @@
+// Capture throughput and latency of the X11 backend. Needs an X server;
+// headless, run it under Xvfb at the size to measure:
+//
+//   xvfb-run -s "-screen 0 1920x1080x24" ./build/x11_capture_bench
+//
+// "shm" reads the root window through the reused MIT-SHM segment, "getimage"
+// through XGetImage over the socket, "shm_copy" adds the copy into packed
+// rows that every plugin capture makes (X11DisplayBackend). items_per_second
+// is frames per second and the reported time is the per-frame latency;
+// bytes_per_second is over the captured pixels. Without a display every
+// benchmark reports an error and is skipped.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "display_capture.h"
+#include "image.h"
+#include "image_rect.h"
+#include "x11_display_backend.h"
+#include "x11_screen_capture.h"
+
+namespace screenshot {
+namespace {
+
+void RunCapture(benchmark::State& state, bool use_shm, bool include_cursor) {
+  X11ScreenCaptureOptions options;
+  options.use_shm = use_shm;
+  std::unique_ptr<X11ScreenCapture> capture =
+      X11ScreenCapture::Open(nullptr, options);
+  if (!capture || capture->uses_shm() != use_shm) {
+    state.SkipWithError(use_shm ? "No X display with MIT-SHM"
+                                : "No X display");
+    return;
+  }
+  const PixelRect root = capture->RootBounds();
+  ImageView view;
+  for (auto _ : state) {
+    if (!capture->Capture(root, include_cursor, &view)) {
+      state.SkipWithError("Capture failed");
+      return;
+    }
+    benchmark::DoNotOptimize(view.data);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          root.width * root.height * kBytesPerPixel);
+  state.SetLabel(std::to_string(root.width) + "x" +
+                 std::to_string(root.height));
+}
+
+void BM_X11Capture_Shm(benchmark::State& state) {
+  RunCapture(state, true, false);
+}
+BENCHMARK(BM_X11Capture_Shm)->UseRealTime();
+
+void BM_X11Capture_ShmCursor(benchmark::State& state) {
+  RunCapture(state, true, true);
+}
+BENCHMARK(BM_X11Capture_ShmCursor)->UseRealTime();
+
+void BM_X11Capture_GetImage(benchmark::State& state) {
+  RunCapture(state, false, false);
+}
+BENCHMARK(BM_X11Capture_GetImage)->UseRealTime();
+
+void BM_X11Capture_ShmCopy(benchmark::State& state) {
+  X11DisplayBackend backend;
+  std::vector<DisplayInfo> displays;
+  if (!backend.ListDisplays(&displays)) {
+    state.SkipWithError("No X display");
+    return;
+  }
+  const PixelRect& bounds = displays[0].bounds;
+  std::vector<uint8_t> pixels(static_cast<size_t>(bounds.width) *
+                              kBytesPerPixel *
+                              static_cast<size_t>(bounds.height));
+  for (auto _ : state) {
+    if (!backend.CaptureDisplay(displays[0], false, 0, pixels.data())) {
+      state.SkipWithError("Capture failed");
+      return;
+    }
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(pixels.size()));
+}
+BENCHMARK(BM_X11Capture_ShmCopy)->UseRealTime();
+
+}  // namespace
+}  // namespace screenshot
@@ -0,0 +1,1557 @@
+#include "include/just_screenshot/screenshot_plugin.h"
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "batch_encoder.h"
+#include "capture_pipeline.h"
+#include "capture_stats.h"
+#include "capture_stream.h"
+#include "display_capture.h"
+#include "encoder_session.h"
+#include "file_sink.h"
+#include "frame_diff.h"
+#include "frame_pool.h"
+#include "image.h"
+#include "image_hash.h"
+#include "image_rect.h"
+#include "image_resizer.h"
+#include "shared_frame_ring.h"
+#include "trace.h"
+#include "webp_encoder.h"
+#include "x11_display_backend.h"
+#include "x11_screen_capture.h"
+
+namespace screenshot {
+namespace {
+
+// Default "fps" of "startStream".
+constexpr double kDefaultStreamFps = 30.0;
+
+// Bounds of the "tileSize" argument of "captureTiles".
+constexpr int kMinTileSize = 8;
+constexpr int kMaxTileSize = 1024;
+
+// Most rectangles one "captureBatch" call may ask for.
+constexpr size_t kMaxBatchRects = 256;
+
+struct GObjectUnref {
+  void operator()(gpointer object) const { g_object_unref(object); }
+};
+
+struct FlValueUnref {
+  void operator()(FlValue* value) const { fl_value_unref(value); }
+};
+
+// A strong reference to a method call, answered once its job completes.
+using MethodCallRef = std::unique_ptr<FlMethodCall, GObjectUnref>;
+using FlValueRef = std::unique_ptr<FlValue, FlValueUnref>;
+
+void RespondError(FlMethodCall* method_call, const char* code,
+                  const std::string& message) {
+  fl_method_call_respond_error(method_call, code, message.c_str(), nullptr,
+                               nullptr);
+}
+
+// The value of |key| in the |arguments| map, or null if it is missing or
+// null.
+FlValue* LookupArgument(FlValue* arguments, const char* key) {
+  FlValue* value = fl_value_lookup_string(arguments, key);
+  if (!value || fl_value_get_type(value) == FL_VALUE_TYPE_NULL) return nullptr;
+  return value;
+}
+
+// The optional bool argument |key|, or |fallback| if it is missing or not a
+// bool.
+bool BoolArgument(FlValue* arguments, const char* key, bool fallback) {
+  FlValue* value = LookupArgument(arguments, key);
+  if (!value || fl_value_get_type(value) != FL_VALUE_TYPE_BOOL) {
+    return fallback;
+  }
+  return fl_value_get_bool(value);
+}
+
+// Reads the optional "format", "quality" and "chromaSubsampling" arguments
+// into |settings|. On a bad value responds with the error and returns
+// false.
+bool ParseEncodeSettings(FlValue* arguments, EncodeSettings* settings,
+                         FlMethodCall* method_call) {
+  // Get format parameter (optional, default "png")
+  if (FlValue* format = LookupArgument(arguments, "format")) {
+    if (fl_value_get_type(format) != FL_VALUE_TYPE_STRING) {
+      RespondError(method_call, "invalid_argument",
+                   "'format' must be a string");
+      return false;
+    }
+    const std::string name = fl_value_get_string(format);
+    if (!ParseCaptureFormat(name, &settings->format)) {
+      RespondError(method_call, "invalid_argument", "Invalid format: " + name);
+      return false;
+    }
+  }
+  if (settings->format == CaptureFormat::kWebp && !WebpEncoder::IsAvailable()) {
+    RespondError(method_call, "not_supported",
+                 "WebP encoding is not available in this build");
+    return false;
+  }
+
+  // Get quality parameter (optional, default 85; lossy formats only)
+  if (FlValue* quality = LookupArgument(arguments, "quality")) {
+    if (fl_value_get_type(quality) != FL_VALUE_TYPE_INT) {
+      RespondError(method_call, "invalid_argument", "'quality' must be an int");
+      return false;
+    }
+    const int64_t value = fl_value_get_int(quality);
+    if (value < 1 || value > 100) {
+      RespondError(method_call, "invalid_argument",
+                   "Invalid quality: " + std::to_string(value));
+      return false;
+    }
+    settings->quality = static_cast<int>(value);
+  }
+
+  // Get chromaSubsampling parameter (optional, default "420")
+  if (FlValue* chroma = LookupArgument(arguments, "chromaSubsampling")) {
+    if (fl_value_get_type(chroma) != FL_VALUE_TYPE_STRING) {
+      RespondError(method_call, "invalid_argument",
+                   "'chromaSubsampling' must be a string");
+      return false;
+    }
+    const std::string name = fl_value_get_string(chroma);
+    if (!ParseChromaSubsampling(name, &settings->subsampling)) {
+      RespondError(method_call, "invalid_argument",
+                   "Invalid chromaSubsampling: " + name);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Reads the optional "maxWidth", "maxHeight" and "scale" arguments into
+// |limits|. On a bad value responds with the error and returns false.
+bool ParseResizeLimits(FlValue* arguments, ResizeLimits* limits,
+                       FlMethodCall* method_call) {
+  for (const auto& [name, field] :
+       {std::pair<const char*, int*>("maxWidth", &limits->max_width),
+        std::pair<const char*, int*>("maxHeight", &limits->max_height)}) {
+    FlValue* value = LookupArgument(arguments, name);
+    if (!value) continue;
+    if (fl_value_get_type(value) != FL_VALUE_TYPE_INT) {
+      RespondError(method_call, "invalid_argument",
+                   std::string("'") + name + "' must be an int");
+      return false;
+    }
+    const int64_t size = fl_value_get_int(value);
+    if (size < 1 || size > INT32_MAX) {
+      RespondError(method_call, "invalid_argument",
+                   std::string("Invalid ") + name + ": " +
+                       std::to_string(size));
+      return false;
+    }
+    *field = static_cast<int>(size);
+  }
+
+  if (FlValue* scale = LookupArgument(arguments, "scale")) {
+    if (fl_value_get_type(scale) != FL_VALUE_TYPE_FLOAT) {
+      RespondError(method_call, "invalid_argument",
+                   "'scale' must be a double");
+      return false;
+    }
+    const double value = fl_value_get_float(scale);
+    // Also rejects NaN.
+    if (!(value > 0.0 && value <= 1.0)) {
+      RespondError(method_call, "invalid_argument",
+                   "Invalid scale: " + std::to_string(value));
+      return false;
+    }
+    limits->scale = value;
+  }
+  return true;
+}
+
+// Reads the int "x", "y", "width" and "height" entries of the map |rect|,
+// the argument |name|, into |out|. On a bad value responds with the error
+// and returns false.
+bool ParsePixelRect(FlValue* rect, const std::string& name, PixelRect* out,
+                    FlMethodCall* method_call) {
+  int values[4] = {};
+  const char* keys[4] = {"x", "y", "width", "height"};
+  for (int k = 0; k < 4; ++k) {
+    FlValue* value = LookupArgument(rect, keys[k]);
+    if (!value || fl_value_get_type(value) != FL_VALUE_TYPE_INT ||
+        fl_value_get_int(value) < INT32_MIN ||
+        fl_value_get_int(value) > INT32_MAX) {
+      RespondError(method_call, "invalid_argument",
+                   "'" + name + "." + keys[k] + "' must be an int");
+      return false;
+    }
+    values[k] = static_cast<int>(fl_value_get_int(value));
+  }
+  *out = PixelRect{values[0], values[1], values[2], values[3]};
+  return true;
+}
+
+// Encodes |image| (opaque BGRA, possibly a window into a larger frame) with
+// |session|, whose encoders and output buffer are reused from call to call,
+// into a new "bytes" value. |stride| receives the row size of the
+// (decompressed) pixels, or 0 for image formats. Returns null on failure.
+FlValue* EncodeCapture(const ImageView& image, const EncodeSettings& settings,
+                       EncoderSession* session, size_t* stride) {
+  *stride = 0;
+  if (!session->Encode(image, settings)) return nullptr;
+  // FlValue lists always copy their bytes, so raw formats are converted in
+  // the session too; this copy (sized exactly) is the only allocation once
+  // the session is warm.
+  *stride = session->stride();
+  TraceSpan span("marshal");
+  return fl_value_new_uint8_list(session->data(), session->size());
+}
+
+// Builds the success map returned by "capture", taking |bytes|.
+FlValue* MakeCaptureResult(int width, int height, CaptureFormat format,
+                           size_t stride, FlValue* bytes) {
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "width", fl_value_new_int(width));
+  fl_value_set_string_take(result, "height", fl_value_new_int(height));
+  fl_value_set_string_take(result, "stride",
+                           fl_value_new_int(static_cast<int64_t>(stride)));
+  fl_value_set_string_take(result, "pixelFormat",
+                           fl_value_new_string(CaptureFormatName(format)));
+  fl_value_set_string_take(result, "bytes", bytes);
+  return result;
+}
+
+// Steady-clock time in microseconds, as frames are timestamped.
+int64_t SteadyClockMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Runs tasks on the GLib main loop, which is Flutter's platform thread, in
+// the order they were posted. Post() may be called from any thread; one
+// idle source drains everything queued before it runs.
+//
+// Destroying the queue (on the platform thread) drops the tasks it has not
+// run yet, so that none of them runs after the plugin state it refers to
+// is gone.
+class MainThreadQueue {
+ public:
+  MainThreadQueue() : state_(std::make_shared<State>()) {}
+
+  ~MainThreadQueue() {
+    std::deque<std::function<void()>> dropped;
+    {
+      std::lock_guard<std::mutex> lock(state_->mutex);
+      state_->closed = true;
+      dropped.swap(state_->tasks);
+    }
+  }
+
+  MainThreadQueue(const MainThreadQueue&) = delete;
+  MainThreadQueue& operator=(const MainThreadQueue&) = delete;
+
+  // Queues |task|. Returns false (and drops it) once the queue is gone.
+  bool Post(std::function<void()> task) {
+    bool wake = false;
+    {
+      std::lock_guard<std::mutex> lock(state_->mutex);
+      if (state_->closed) return false;
+      wake = state_->tasks.empty();
+      state_->tasks.push_back(std::move(task));
+    }
+    if (wake) {
+      // The source holds the state, which outlives the queue until the
+      // source has run.
+      g_idle_add_full(G_PRIORITY_DEFAULT, Drain,
+                      new std::shared_ptr<State>(state_), [](gpointer data) {
+                        delete static_cast<std::shared_ptr<State>*>(data);
+                      });
+    }
+    return true;
+  }
+
+ private:
+  struct State {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+    bool closed = false;
+  };
+
+  static gboolean Drain(gpointer data) {
+    State* state = static_cast<std::shared_ptr<State>*>(data)->get();
+    std::deque<std::function<void()>> tasks;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      tasks.swap(state->tasks);
+    }
+    for (std::function<void()>& task : tasks) {
+      {
+        // A task may have destroyed the queue, and with it what the rest
+        // refer to.
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->closed) break;
+      }
+      task();
+    }
+    return G_SOURCE_REMOVE;
+  }
+
+  std::shared_ptr<State> state_;
+};
+
+// Nanoseconds as the fractional microseconds "getStats" reports.
+FlValue* NewMicros(int64_t nanos) {
+  return fl_value_new_float(static_cast<double>(nanos) / 1000.0);
+}
+
+// The outcome of a capture job, built on the pipeline's threads and sent on
+// the platform thread: a value, or an error when code is set. It also
+// carries the capture's CaptureSample, each stage timed on the thread it
+// runs on.
+class CaptureReply {
+ public:
+  // Takes |value|.
+  void Succeed(FlValue* value) { value_.reset(value); }
+
+  // Fails the capture in |stage|, for its error count.
+  void Fail(CaptureStage stage, const std::string& code,
+            const std::string& message) {
+    failed_stage_ = stage;
+    code_ = code;
+    message_ = message;
+  }
+
+  // Fails the capture in the encode stage.
+  void Fail(const std::string& code, const std::string& message) {
+    Fail(CaptureStage::kEncode, code, message);
+  }
+
+  CaptureSample* sample() { return &sample_; }
+
+  // Times the encode stage, which started at |start_nanos|, leaving out
+  // the scaling the encode function timed within it.
+  void EndEncode(int64_t start_nanos) {
+    if (!code_.empty()) return;
+    const int64_t scale = sample_.Get(CaptureStage::kScale);
+    sample_.Set(CaptureStage::kEncode, MonotonicNanos() - start_nanos -
+                                           (scale > 0 ? scale : 0));
+  }
+
+  // Ends the capture, which started at |start_nanos|, and records it in
+  // |stats|: its stages if it succeeded, or an error in the stage it
+  // failed in.
+  void Finish(CaptureStats* stats, int64_t start_nanos) {
+    if (!code_.empty()) {
+      stats->RecordError(failed_stage_);
+      return;
+    }
+    sample_.Set(CaptureStage::kTotal, MonotonicNanos() - start_nanos);
+    stats->Record(sample_);
+  }
+
+  void Send(FlMethodCall* method_call) {
+    if (!code_.empty()) {
+      RespondError(method_call, code_.c_str(), message_);
+    } else {
+      fl_method_call_respond_success(method_call, value_.get(), nullptr);
+    }
+  }
+
+ private:
+  FlValueRef value_;
+  std::string code_;
+  std::string message_;
+  CaptureStage failed_stage_ = CaptureStage::kEncode;
+  CaptureSample sample_;
+};
+
+// A "capture", "captureTiles", "captureAllDisplays", "captureBatch" or
+// "captureHash" request on the capture pipeline: copies |displays| through
+// |capture| (all at once, as one stitched frame or a frame per display; a
+// display's bounds may be just the part of the root window wanted), hands
+// the frames to |encode| and replies on the platform thread.
+class DisplaysCaptureJob : public PipelineJob {
+ public:
+  // Runs on the encode thread with the captured frames (one if stitched)
+  // and the steady-clock time their capture started, in microseconds.
+  using EncodeFn = std::function<void(const std::vector<ImageView>& frames,
+                                      int64_t timestamp_us,
+                                      CaptureReply* reply)>;
+
+  DisplaysCaptureJob(MultiDisplayCapture* capture,
+                     std::vector<DisplayInfo> displays, bool include_cursor,
+                     bool stitch, EncodeFn encode, FlMethodCall* method_call,
+                     CaptureStats* stats)
+      : capture_(capture),
+        displays_(std::move(displays)),
+        include_cursor_(include_cursor),
+        stitch_(stitch),
+        encode_(std::move(encode)),
+        method_call_(FL_METHOD_CALL(g_object_ref(method_call))),
+        stats_(stats) {}
+
+  bool Capture() override {
+    timestamp_us_ = SteadyClockMicros();
+    start_nanos_ = MonotonicNanos();
+    bool captured = false;
+    if (stitch_) {
+      FramePool::Lease desktop =
+          capture_->CaptureDesktop(displays_, include_cursor_);
+      captured = static_cast<bool>(desktop);
+      if (captured) frames_.push_back(std::move(desktop));
+    } else {
+      captured = capture_->Capture(displays_, include_cursor_, &frames_);
+    }
+    if (!captured) {
+      reply_.Fail(CaptureStage::kCapture, "internal_error",
+                  "Failed to capture screen");
+      return false;
+    }
+    // The cursor is composited as part of each display's capture.
+    CaptureSample* sample = reply_.sample();
+    sample->Set(CaptureStage::kCapture, MonotonicNanos() - start_nanos_);
+    for (const FramePool::Lease& frame : frames_) {
+      sample->captured_bytes += frame->size();
+    }
+    return true;
+  }
+
+  void Encode() override {
+    const int64_t encode_start = MonotonicNanos();
+    std::vector<ImageView> views;
+    views.reserve(frames_.size());
+    for (const FramePool::Lease& frame : frames_) {
+      views.push_back(frame->View());
+    }
+    encode_(views, timestamp_us_, &reply_);
+    reply_.EndEncode(encode_start);
+    // Back to the pool before the next capture needs them.
+    frames_.clear();
+  }
+
+  void Complete() override {
+    reply_.Finish(stats_, start_nanos_);
+    reply_.Send(method_call_.get());
+  }
+
+ private:
+  MultiDisplayCapture* capture_;
+  std::vector<DisplayInfo> displays_;
+  bool include_cursor_;
+  bool stitch_;
+  EncodeFn encode_;
+  MethodCallRef method_call_;
+  CaptureStats* stats_;
+  std::vector<FramePool::Lease> frames_;
+  int64_t timestamp_us_ = 0;
+  int64_t start_nanos_ = 0;
+  CaptureReply reply_;
+};
+
+// Captures the root window for "startStream" on the stream's capture
+// thread, through a connection of its own, into the frame's reusable
+// buffer.
+class RootFrameSource : public FrameSource {
+ public:
+  explicit RootFrameSource(bool include_cursor)
+      : include_cursor_(include_cursor) {}
+
+  bool Capture(StreamFrame* frame) override {
+    if (!capture_) {
+      capture_ = X11ScreenCapture::Open();
+      if (!capture_) return false;
+    }
+    ImageView view;
+    if (!capture_->Capture(capture_->RootBounds(), include_cursor_, &view)) {
+      return false;
+    }
+    // Out of the shared segment, which the next capture overwrites while
+    // this frame may still be encoding.
+    const size_t row_bytes = view.RowBytes();
+    frame->pixels.resize(row_bytes * static_cast<size_t>(view.height));
+    for (int y = 0; y < view.height; ++y) {
+      std::memcpy(frame->pixels.data() + static_cast<size_t>(y) * row_bytes,
+                  view.Row(y), row_bytes);
+    }
+    frame->width = view.width;
+    frame->height = view.height;
+    frame->stride = row_bytes;
+    frame->format = PixelFormat::kBgra8;
+    return true;
+  }
+
+ private:
+  bool include_cursor_;
+  // Owned by the capture thread.
+  std::unique_ptr<X11ScreenCapture> capture_;
+};
+
+// Linux (X11) implementation of the screenshot plugin: the method channel
+// contract of the Windows plugin, on the X server's root window.
+//
+// Core X11 sees the screen as one root window spanning every monitor, so
+// "listDisplays" reports that single display (id 0) and "screen" mode,
+// "all" mode and "captureAllDisplays" all capture it. Region mode is not
+// supported ("not_supported"), and there is no frame channel; the Dart side
+// falls back to "capture" on the method channel.
+//
+// Captures read the root window through MIT-SHM (see X11ScreenCapture) on
+// the pipeline's capture thread, copy it into a pooled frame and encode it
+// on the encode thread. Their results, including those of failed captures,
+// are delivered on the GLib main loop in call order; calls rejected before
+// reaching the pipeline (bad arguments, region mode) are answered right
+// away.
+class LinuxScreenshotPlugin {
+ public:
+  explicit LinuxScreenshotPlugin(FlEventChannel* event_channel)
+      : event_channel_(event_channel),
+        pipeline_(std::make_unique<CapturePipeline>(
+            [this](std::function<void()> task) {
+              return main_thread_.Post(std::move(task));
+            })) {}
+
+  ~LinuxScreenshotPlugin() {
+    // Join the stream and pipeline threads before the members they use go
+    // away. The replies and events they have queued for the main loop are
+    // dropped with main_thread_.
+    stream_.Stop();
+    pipeline_.reset();
+  }
+
+  LinuxScreenshotPlugin(const LinuxScreenshotPlugin&) = delete;
+  LinuxScreenshotPlugin& operator=(const LinuxScreenshotPlugin&) = delete;
+
+  void HandleMethodCall(FlMethodCall* method_call);
+
+  void OnListen() { listening_ = true; }
+
+  void OnCancel() {
+    // Nobody is listening any more.
+    stream_.Stop();
+    listening_ = false;
+  }
+
+ private:
+  // How a "capture" result is returned.
+  enum class CaptureOutput {
+    kMap,           // "capture" map on the method channel
+    kSharedMemory,  // "captureShared": a leased shared_ring_ slot
+    kFile,          // "captureToFile": streamed to a file
+  };
+
+  void HandleCapture(FlMethodCall* method_call, FlValue* arguments,
+                     CaptureOutput output);
+  void EncodeShared(const ImageView& frame, const EncodeSettings& settings,
+                    CaptureReply* reply);
+  void EncodeToFile(const ImageView& frame, const EncodeSettings& settings,
+                    const std::string& path, const FileSinkOptions& options,
+                    int64_t timestamp_us, CaptureReply* reply);
+
+  void HandleCaptureTiles(FlMethodCall* method_call, FlValue* arguments);
+  void EncodeTiles(const ImageView& frame, const EncodeSettings& settings,
+                   int tile_size, bool keyframe, CaptureReply* reply);
+
+  void HandleCaptureBatch(FlMethodCall* method_call, FlValue* arguments);
+  void HandleCaptureHash(FlMethodCall* method_call, FlValue* arguments);
+
+  void HandleListDisplays(FlMethodCall* method_call);
+  void HandleGetStats(FlMethodCall* method_call);
+  void HandleCaptureAllDisplays(FlMethodCall* method_call, FlValue* arguments);
+
+  void HandleStartStream(FlMethodCall* method_call, FlValue* arguments);
+  void HandleReleaseShared(FlMethodCall* method_call, FlValue* arguments);
+
+  // Hands an encoded stream frame to the platform thread, replacing one
+  // that has not been sent yet. Called on the stream's delivery thread.
+  void PostStreamEvent(FlValue* event);
+
+  // Sends the pending stream frame, if any. Platform thread only.
+  void SendStreamEvent();
+
+  FlEventChannel* event_channel_;
+  bool listening_ = false;
+
+  // Every capture copies the root window through display_capture_ into
+  // buffers leased from frame_pool_ on the pipeline's capture thread;
+  // resizer_, encoder_session_ and frame_differ_ are used only on its encode
+  // thread. All of them live as long as the plugin, so repeated captures
+  // reuse the X connections and shared-memory segments, frame buffers,
+  // filter taps and encoders' state.
+  X11DisplayBackend display_backend_;
+  FramePool frame_pool_;
+  MultiDisplayCapture display_capture_{&display_backend_, &frame_pool_};
+  ImageResizer resizer_;
+  EncoderSession encoder_session_;
+  // "captureShared" frames, leased to Dart until "releaseShared".
+  SharedFrameRing shared_ring_;
+  // Previous "captureTiles" frame.
+  FrameDiffer frame_differ_;
+  // Encodes "captureBatch" rectangles concurrently, on the encode thread.
+  BatchEncoder batch_encoder_;
+  // Hashes "captureHash" captures, on the encode thread.
+  ImageHasher image_hasher_;
+
+  // "startStream" state. The stream captures and encodes on its own
+  // threads; the newest encoded frame waits in pending_stream_event_ for
+  // the platform thread.
+  std::unique_ptr<FrameSource> stream_source_;
+  // Used only on the stream's delivery thread.
+  EncoderSession stream_session_;
+  std::mutex stream_event_mutex_;
+  FlValueRef pending_stream_event_;
+  uint64_t stream_events_dropped_ = 0;
+  CaptureStream stream_;
+
+  // Every capture's stage timings, recorded by the capture jobs as they
+  // complete, for "getStats".
+  CaptureStats stats_;
+
+  // Completions and stream events on their way to the main loop. They use
+  // the members above, so this is destroyed before them.
+  MainThreadQueue main_thread_;
+  std::unique_ptr<CapturePipeline> pipeline_;
+};
+
+void LinuxScreenshotPlugin::HandleMethodCall(FlMethodCall* method_call) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* arguments = fl_method_call_get_args(method_call);
+  const bool has_map =
+      arguments && fl_value_get_type(arguments) == FL_VALUE_TYPE_MAP;
+
+  if (method == "stopStream") {
+    stream_.Stop();
+    fl_method_call_respond_success(method_call, nullptr, nullptr);
+    return;
+  }
+  if (method == "listDisplays") {
+    HandleListDisplays(method_call);
+    return;
+  }
+  if (method == "getStats") {
+    HandleGetStats(method_call);
+    return;
+  }
+  if (method == "resetStats") {
+    stats_.Reset();
+    fl_method_call_respond_success(method_call, nullptr, nullptr);
+    return;
+  }
+  if (method == "startTracing") {
+    SetTraceThreadName("platform");
+    StartTracing();
+    fl_method_call_respond_success(method_call, nullptr, nullptr);
+    return;
+  }
+  if (method == "stopTracing") {
+    StopTracing();
+    const std::string trace = ExportChromeTrace();
+    g_autoptr(FlValue) result = fl_value_new_string(trace.c_str());
+    fl_method_call_respond_success(method_call, result, nullptr);
+    return;
+  }
+  if (method != "capture" && method != "captureShared" &&
+      method != "captureToFile" && method != "captureTiles" &&
+      method != "captureBatch" && method != "captureHash" &&
+      method != "captureAllDisplays" && method != "startStream" &&
+      method != "releaseShared") {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+    return;
+  }
+  if (!has_map) {
+    RespondError(method_call, "invalid_argument", "Arguments must be a map");
+    return;
+  }
+  if (method == "capture") {
+    HandleCapture(method_call, arguments, CaptureOutput::kMap);
+  } else if (method == "captureShared") {
+    HandleCapture(method_call, arguments, CaptureOutput::kSharedMemory);
+  } else if (method == "captureToFile") {
+    HandleCapture(method_call, arguments, CaptureOutput::kFile);
+  } else if (method == "captureTiles") {
+    HandleCaptureTiles(method_call, arguments);
+  } else if (method == "captureBatch") {
+    HandleCaptureBatch(method_call, arguments);
+  } else if (method == "captureHash") {
+    HandleCaptureHash(method_call, arguments);
+  } else if (method == "captureAllDisplays") {
+    HandleCaptureAllDisplays(method_call, arguments);
+  } else if (method == "startStream") {
+    HandleStartStream(method_call, arguments);
+  } else {
+    HandleReleaseShared(method_call, arguments);
+  }
+}
+
+void LinuxScreenshotPlugin::HandleCapture(FlMethodCall* method_call,
+                                          FlValue* arguments,
+                                          CaptureOutput output) {
+  // Get mode parameter
+  FlValue* mode_value = LookupArgument(arguments, "mode");
+  if (!mode_value) {
+    RespondError(method_call, "invalid_argument", "Missing 'mode' parameter");
+    return;
+  }
+  if (fl_value_get_type(mode_value) != FL_VALUE_TYPE_STRING) {
+    RespondError(method_call, "invalid_argument", "'mode' must be a string");
+    return;
+  }
+  const std::string mode = fl_value_get_string(mode_value);
+  if (mode == "region") {
+    RespondError(method_call, "not_supported",
+                 "Region selection is not supported on Linux");
+    return;
+  }
+  if (mode != "screen" && mode != "all") {
+    RespondError(method_call, "invalid_argument", "Invalid mode: " + mode);
+    return;
+  }
+
+  const bool include_cursor =
+      BoolArgument(arguments, "includeCursor", false);
+
+  // Get displayId parameter (optional; the root window is display 0)
+  if (FlValue* display = LookupArgument(arguments, "displayId")) {
+    if (fl_value_get_type(display) != FL_VALUE_TYPE_INT) {
+      RespondError(method_call, "invalid_argument",
+                   "'displayId' must be an int");
+      return;
+    }
+    if (fl_value_get_int(display) != 0) {
+      RespondError(method_call, "invalid_argument",
+                   "Invalid displayId: " +
+                       std::to_string(fl_value_get_int(display)));
+      return;
+    }
+  }
+
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, method_call)) return;
+  ResizeLimits limits;
+  if (!ParseResizeLimits(arguments, &limits, method_call)) return;
+
+  // Get path, fsync and atomic parameters ("captureToFile" only)
+  std::string path;
+  FileSinkOptions file_options;
+  if (output == CaptureOutput::kFile) {
+    FlValue* path_value = LookupArgument(arguments, "path");
+    if (!path_value ||
+        fl_value_get_type(path_value) != FL_VALUE_TYPE_STRING ||
+        fl_value_get_string(path_value)[0] == '\0') {
+      RespondError(method_call, "invalid_argument",
+                   "'path' must be a non-empty string");
+      return;
+    }
+    path = fl_value_get_string(path_value);
+    file_options.sync = BoolArgument(arguments, "fsync", file_options.sync);
+    file_options.atomic =
+        BoolArgument(arguments, "atomic", file_options.atomic);
+  }
+
+  // Listed for every request, so a resized screen is picked up.
+  std::vector<DisplayInfo> displays;
+  if (!display_backend_.ListDisplays(&displays)) {
+    RespondError(method_call, "internal_error", "Failed to open the X display");
+    return;
+  }
+
+  // Scales the captured frame down to |limits| and encodes it to the
+  // requested format (encode stage).
+  auto encode = [this, settings, limits, output, path, file_options](
+                    const std::vector<ImageView>& frames, int64_t timestamp_us,
+                    CaptureReply* reply) {
+    const int64_t scale_start = MonotonicNanos();
+    ImageView image = frames.front();
+    if (!resizer_.Fit(frames.front(), limits, &image)) {
+      reply->Fail(CaptureStage::kScale, "internal_error",
+                  "Failed to resize image");
+      return;
+    }
+    if (image.data != frames.front().data) {
+      reply->sample()->Set(CaptureStage::kScale,
+                           MonotonicNanos() - scale_start);
+    }
+    if (output == CaptureOutput::kSharedMemory) {
+      EncodeShared(image, settings, reply);
+      return;
+    }
+    if (output == CaptureOutput::kFile) {
+      EncodeToFile(image, settings, path, file_options, timestamp_us, reply);
+      return;
+    }
+    size_t stride = 0;
+    FlValue* bytes = EncodeCapture(image, settings, &encoder_session_, &stride);
+    if (!bytes) {
+      reply->Fail("internal_error", "Failed to encode image");
+      return;
+    }
+    reply->sample()->output_bytes = fl_value_get_length(bytes);
+    reply->Succeed(MakeCaptureResult(image.width, image.height,
+                                     settings.format, stride, bytes));
+  };
+  pipeline_->Submit(std::make_unique<DisplaysCaptureJob>(
+      &display_capture_, std::move(displays), include_cursor, true,
+      std::move(encode), method_call, &stats_));
+}
+
+void LinuxScreenshotPlugin::EncodeShared(const ImageView& frame,
+                                         const EncodeSettings& settings,
+                                         CaptureReply* reply) {
+  SharedFrameSlot slot;
+  size_t length = 0;
+  size_t stride = 0;
+  switch (EncodeSharedFrame(&encoder_session_, frame, settings, &shared_ring_,
+                            &slot, &length, &stride)) {
+    case SharedFrameStatus::kOk:
+      break;
+    case SharedFrameStatus::kEncodeFailed:
+      reply->Fail("internal_error", "Failed to encode image");
+      return;
+    case SharedFrameStatus::kNoFreeSlot:
+      reply->Fail("internal_error",
+                  "No free shared frame slot; release earlier frames first");
+      return;
+    case SharedFrameStatus::kMapFailed:
+      reply->Fail("internal_error",
+                  "Failed to create shared memory for the frame");
+      return;
+  }
+  reply->sample()->output_bytes = length;
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "width", fl_value_new_int(frame.width));
+  fl_value_set_string_take(result, "height", fl_value_new_int(frame.height));
+  fl_value_set_string_take(result, "stride",
+                           fl_value_new_int(static_cast<int64_t>(stride)));
+  fl_value_set_string_take(
+      result, "pixelFormat",
+      fl_value_new_string(CaptureFormatName(settings.format)));
+  fl_value_set_string_take(result, "handle",
+                           fl_value_new_int(static_cast<int64_t>(slot.handle)));
+  fl_value_set_string_take(result, "offset",
+                           fl_value_new_int(static_cast<int64_t>(slot.offset)));
+  fl_value_set_string_take(result, "length",
+                           fl_value_new_int(static_cast<int64_t>(length)));
+  fl_value_set_string_take(
+      result, "generation",
+      fl_value_new_int(static_cast<int64_t>(slot.generation)));
+  reply->Succeed(result);
+}
+
+void LinuxScreenshotPlugin::EncodeToFile(const ImageView& frame,
+                                         const EncodeSettings& settings,
+                                         const std::string& path,
+                                         const FileSinkOptions& options,
+                                         int64_t timestamp_us,
+                                         CaptureReply* reply) {
+  int error = 0;
+  std::unique_ptr<FileSink> sink = FileSink::Open(path, options, &error);
+  if (!sink) {
+    reply->Fail("internal_error",
+                "Failed to open " + path + ": " + g_strerror(error));
+    return;
+  }
+  if (!encoder_session_.Encode(frame, settings, sink.get())) {
+    if (sink->error() != 0) {
+      reply->Fail("internal_error",
+                  "Failed to write " + path + ": " + g_strerror(sink->error()));
+    } else {
+      reply->Fail("internal_error", "Failed to encode image");
+    }
+    return;
+  }
+  if (!sink->Commit()) {
+    reply->Fail("internal_error",
+                "Failed to write " + path + ": " + g_strerror(sink->error()));
+    return;
+  }
+  reply->sample()->output_bytes = sink->size();
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "path", fl_value_new_string(path.c_str()));
+  fl_value_set_string_take(result, "width", fl_value_new_int(frame.width));
+  fl_value_set_string_take(result, "height", fl_value_new_int(frame.height));
+  fl_value_set_string_take(
+      result, "pixelFormat",
+      fl_value_new_string(CaptureFormatName(settings.format)));
+  fl_value_set_string_take(
+      result, "byteCount",
+      fl_value_new_int(static_cast<int64_t>(sink->size())));
+  fl_value_set_string_take(
+      result, "elapsedUs",
+      fl_value_new_int(SteadyClockMicros() - timestamp_us));
+  reply->Succeed(result);
+}
+
+void LinuxScreenshotPlugin::HandleCaptureTiles(FlMethodCall* method_call,
+                                               FlValue* arguments) {
+  const bool include_cursor =
+      BoolArgument(arguments, "includeCursor", false);
+
+  // Get keyframe parameter (optional, default false)
+  bool keyframe = false;
+  if (FlValue* value = LookupArgument(arguments, "keyframe")) {
+    if (fl_value_get_type(value) != FL_VALUE_TYPE_BOOL) {
+      RespondError(method_call, "invalid_argument",
+                   "'keyframe' must be a bool");
+      return;
+    }
+    keyframe = fl_value_get_bool(value);
+  }
+
+  // Get tileSize parameter (optional, default 64). 0 keeps the current
+  // size; a new size drops the previous frame.
+  int tile_size = 0;
+  if (FlValue* value = LookupArgument(arguments, "tileSize")) {
+    if (fl_value_get_type(value) != FL_VALUE_TYPE_INT) {
+      RespondError(method_call, "invalid_argument",
+                   "'tileSize' must be an int");
+      return;
+    }
+    const int64_t size = fl_value_get_int(value);
+    if (size < kMinTileSize || size > kMaxTileSize) {
+      RespondError(method_call, "invalid_argument",
+                   "Invalid tileSize: " + std::to_string(size));
+      return;
+    }
+    tile_size = static_cast<int>(size);
+  }
+
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, method_call)) return;
+  // Tiles are small; banding each one costs more than it saves.
+  settings.threads = 1;
+
+  std::vector<DisplayInfo> displays;
+  if (!display_backend_.ListDisplays(&displays)) {
+    RespondError(method_call, "internal_error", "Failed to open the X display");
+    return;
+  }
+  pipeline_->Submit(std::make_unique<DisplaysCaptureJob>(
+      &display_capture_, std::move(displays), include_cursor, true,
+      [this, settings, tile_size, keyframe](
+          const std::vector<ImageView>& frames, int64_t timestamp_us,
+          CaptureReply* reply) {
+        EncodeTiles(frames.front(), settings, tile_size, keyframe, reply);
+      },
+      method_call, &stats_));
+}
+
+void LinuxScreenshotPlugin::EncodeTiles(const ImageView& frame,
+                                        const EncodeSettings& settings,
+                                        int tile_size, bool keyframe,
+                                        CaptureReply* reply) {
+  if (tile_size != 0 && tile_size != frame_differ_.options().tile_size) {
+    FrameDiffOptions diff_options = frame_differ_.options();
+    diff_options.tile_size = tile_size;
+    frame_differ_.set_options(diff_options);
+  }
+  FrameDiff diff;
+  if (!frame_differ_.Diff(frame, keyframe, &diff)) {
+    reply->Fail("internal_error", "Failed to compare frames");
+    return;
+  }
+
+  // Encode each changed tile from a view into the captured frame.
+  FlValue* tiles = fl_value_new_list();
+  for (const TileRect& tile : diff.tiles) {
+    ImageView view = frame;
+    view.data = frame.Row(tile.y) +
+                static_cast<size_t>(tile.x) * kBytesPerPixel;
+    view.width = tile.width;
+    view.height = tile.height;
+    size_t stride = 0;
+    FlValue* bytes = EncodeCapture(view, settings, &encoder_session_, &stride);
+    if (!bytes) {
+      fl_value_unref(tiles);
+      // The reference already holds this frame; start over next time.
+      frame_differ_.Reset();
+      reply->Fail("internal_error", "Failed to encode tile");
+      return;
+    }
+    reply->sample()->output_bytes += fl_value_get_length(bytes);
+    FlValue* entry = fl_value_new_map();
+    fl_value_set_string_take(entry, "x", fl_value_new_int(tile.x));
+    fl_value_set_string_take(entry, "y", fl_value_new_int(tile.y));
+    fl_value_set_string_take(entry, "width", fl_value_new_int(tile.width));
+    fl_value_set_string_take(entry, "height", fl_value_new_int(tile.height));
+    fl_value_set_string_take(entry, "stride",
+                             fl_value_new_int(static_cast<int64_t>(stride)));
+    fl_value_set_string_take(entry, "bytes", bytes);
+    fl_value_append_take(tiles, entry);
+  }
+
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "width", fl_value_new_int(frame.width));
+  fl_value_set_string_take(result, "height", fl_value_new_int(frame.height));
+  fl_value_set_string_take(result, "keyframe",
+                           fl_value_new_bool(diff.keyframe));
+  fl_value_set_string_take(
+      result, "tileSize", fl_value_new_int(frame_differ_.options().tile_size));
+  fl_value_set_string_take(
+      result, "pixelFormat",
+      fl_value_new_string(CaptureFormatName(settings.format)));
+  fl_value_set_string_take(result, "tiles", tiles);
+  reply->Succeed(result);
+}
+
+void LinuxScreenshotPlugin::HandleCaptureBatch(FlMethodCall* method_call,
+                                               FlValue* arguments) {
+  const bool include_cursor =
+      BoolArgument(arguments, "includeCursor", false);
+
+  // The defaults for every rectangle
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, method_call)) return;
+  ResizeLimits limits;
+  if (!ParseResizeLimits(arguments, &limits, method_call)) return;
+
+  // Get rects parameter
+  FlValue* rects = LookupArgument(arguments, "rects");
+  if (!rects || fl_value_get_type(rects) != FL_VALUE_TYPE_LIST ||
+      fl_value_get_length(rects) == 0) {
+    RespondError(method_call, "invalid_argument",
+                 "'rects' must be a non-empty list");
+    return;
+  }
+  const size_t count = fl_value_get_length(rects);
+  if (count > kMaxBatchRects) {
+    RespondError(method_call, "invalid_argument",
+                 "Too many rects: " + std::to_string(count) + " (at most " +
+                     std::to_string(kMaxBatchRects) + ")");
+    return;
+  }
+
+  std::vector<DisplayInfo> displays;
+  if (!display_backend_.ListDisplays(&displays)) {
+    RespondError(method_call, "internal_error", "Failed to open the X display");
+    return;
+  }
+
+  // Each rectangle is clipped to the root window here, so one outside it
+  // fails the call before anything is captured. Only the area the
+  // rectangles cover is copied off the screen; crops are taken from it.
+  const PixelRect screen = displays.front().bounds;
+  PixelRect area;
+  std::vector<BatchCrop> crops(count);
+  for (size_t i = 0; i < count; ++i) {
+    const std::string name = "rects[" + std::to_string(i) + "]";
+    FlValue* rect = fl_value_get_list_value(rects, i);
+    if (fl_value_get_type(rect) != FL_VALUE_TYPE_MAP) {
+      RespondError(method_call, "invalid_argument",
+                   "'" + name + "' must be a map");
+      return;
+    }
+    PixelRect requested;
+    if (!ParsePixelRect(rect, name, &requested, method_call)) return;
+    crops[i].rect = IntersectRects(requested, screen);
+    if (crops[i].rect.IsEmpty()) {
+      RespondError(method_call, "invalid_argument",
+                   "'" + name + "' is not on the screen");
+      return;
+    }
+    const PixelRect& crop = crops[i].rect;
+    if (i == 0) {
+      area = crop;
+    } else {
+      area = RectFromCorners(crop.x < area.x ? crop.x : area.x,
+                             crop.y < area.y ? crop.y : area.y,
+                             crop.right() > area.right() ? crop.right()
+                                                         : area.right(),
+                             crop.bottom() > area.bottom() ? crop.bottom()
+                                                           : area.bottom());
+    }
+    // Per-rectangle format, quality, chromaSubsampling and scaling
+    crops[i].settings = settings;
+    crops[i].limits = limits;
+    if (!ParseEncodeSettings(rect, &crops[i].settings, method_call) ||
+        !ParseResizeLimits(rect, &crops[i].limits, method_call)) {
+      return;
+    }
+  }
+  for (BatchCrop& crop : crops) {
+    crop.rect.x -= area.x;
+    crop.rect.y -= area.y;
+  }
+
+  DisplayInfo source = displays.front();
+  source.bounds = area;
+  pipeline_->Submit(std::make_unique<DisplaysCaptureJob>(
+      &display_capture_, std::vector<DisplayInfo>{source}, include_cursor,
+      false,
+      [this, crops, area](const std::vector<ImageView>& frames,
+                          int64_t timestamp_us, CaptureReply* reply) {
+        std::vector<BatchOutput> outputs;
+        if (!batch_encoder_.Encode(frames.front(), crops, &outputs)) {
+          reply->Fail("internal_error", "Failed to encode image");
+          return;
+        }
+        FlValue* list = fl_value_new_list();
+        for (size_t i = 0; i < outputs.size(); ++i) {
+          const BatchOutput& output = outputs[i];
+          reply->sample()->output_bytes += output.bytes.size();
+          FlValue* entry = MakeCaptureResult(
+              output.width, output.height, crops[i].settings.format,
+              output.stride,
+              fl_value_new_uint8_list(output.bytes.data(),
+                                      output.bytes.size()));
+          fl_value_set_string_take(entry, "x",
+                                   fl_value_new_int(output.rect.x + area.x));
+          fl_value_set_string_take(entry, "y",
+                                   fl_value_new_int(output.rect.y + area.y));
+          fl_value_set_string_take(entry, "sourceWidth",
+                                   fl_value_new_int(output.rect.width));
+          fl_value_set_string_take(entry, "sourceHeight",
+                                   fl_value_new_int(output.rect.height));
+          fl_value_append_take(list, entry);
+        }
+        reply->Succeed(list);
+      },
+      method_call, &stats_));
+}
+
+void LinuxScreenshotPlugin::HandleCaptureHash(FlMethodCall* method_call,
+                                              FlValue* arguments) {
+  const bool include_cursor =
+      BoolArgument(arguments, "includeCursor", false);
+
+  // Get hashes parameter (optional, default every hash)
+  ImageHashOptions options;
+  if (FlValue* hashes = LookupArgument(arguments, "hashes")) {
+    if (fl_value_get_type(hashes) != FL_VALUE_TYPE_LIST ||
+        fl_value_get_length(hashes) == 0) {
+      RespondError(method_call, "invalid_argument",
+                   "'hashes' must be a non-empty list");
+      return;
+    }
+    options.xxh3 = options.dhash = options.phash = false;
+    for (size_t i = 0; i < fl_value_get_length(hashes); ++i) {
+      FlValue* hash = fl_value_get_list_value(hashes, i);
+      const std::string name =
+          fl_value_get_type(hash) == FL_VALUE_TYPE_STRING
+              ? fl_value_get_string(hash)
+              : "";
+      if (name == "xxh3") {
+        options.xxh3 = true;
+      } else if (name == "dhash") {
+        options.dhash = true;
+      } else if (name == "phash") {
+        options.phash = true;
+      } else {
+        RespondError(method_call, "invalid_argument",
+                     "'hashes' must hold \"xxh3\", \"dhash\" or \"phash\"");
+        return;
+      }
+    }
+  }
+
+  std::vector<DisplayInfo> displays;
+  if (!display_backend_.ListDisplays(&displays)) {
+    RespondError(method_call, "internal_error", "Failed to open the X display");
+    return;
+  }
+
+  // Get rect parameter (optional, default the whole root window). It is
+  // clipped here, so one outside the root window fails the call before
+  // anything is captured.
+  const PixelRect screen = displays.front().bounds;
+  PixelRect rect = screen;
+  if (FlValue* rect_value = LookupArgument(arguments, "rect")) {
+    if (fl_value_get_type(rect_value) != FL_VALUE_TYPE_MAP) {
+      RespondError(method_call, "invalid_argument", "'rect' must be a map");
+      return;
+    }
+    PixelRect requested;
+    if (!ParsePixelRect(rect_value, "rect", &requested, method_call)) return;
+    rect = IntersectRects(requested, screen);
+    if (rect.IsEmpty()) {
+      RespondError(method_call, "invalid_argument",
+                   "'rect' is not on the screen");
+      return;
+    }
+  }
+
+  // Only the rect is copied off the screen and hashed: nothing is encoded.
+  DisplayInfo source = displays.front();
+  source.bounds = rect;
+  pipeline_->Submit(std::make_unique<DisplaysCaptureJob>(
+      &display_capture_, std::vector<DisplayInfo>{source}, include_cursor,
+      false,
+      [this, options, rect](const std::vector<ImageView>& frames,
+                            int64_t timestamp_us, CaptureReply* reply) {
+        ImageHashes hashes;
+        if (!image_hasher_.Hash(frames.front(), options, &hashes)) {
+          reply->Fail("internal_error", "Failed to hash image");
+          return;
+        }
+        FlValue* result = fl_value_new_map();
+        fl_value_set_string_take(result, "x", fl_value_new_int(rect.x));
+        fl_value_set_string_take(result, "y", fl_value_new_int(rect.y));
+        fl_value_set_string_take(result, "width",
+                                 fl_value_new_int(rect.width));
+        fl_value_set_string_take(result, "height",
+                                 fl_value_new_int(rect.height));
+        // Dart ints are signed 64-bit; the hashes keep their bits.
+        if (options.xxh3) {
+          fl_value_set_string_take(
+              result, "xxh3",
+              fl_value_new_int(static_cast<int64_t>(hashes.xxh3)));
+        }
+        if (options.dhash) {
+          fl_value_set_string_take(
+              result, "dhash",
+              fl_value_new_int(static_cast<int64_t>(hashes.dhash)));
+        }
+        if (options.phash) {
+          fl_value_set_string_take(
+              result, "phash",
+              fl_value_new_int(static_cast<int64_t>(hashes.phash)));
+        }
+        reply->Succeed(result);
+      },
+      method_call, &stats_));
+}
+
+void LinuxScreenshotPlugin::HandleListDisplays(FlMethodCall* method_call) {
+  std::vector<DisplayInfo> displays;
+  if (!display_backend_.ListDisplays(&displays)) {
+    RespondError(method_call, "internal_error", "Failed to open the X display");
+    return;
+  }
+  g_autoptr(FlValue) list = fl_value_new_list();
+  for (const DisplayInfo& display : displays) {
+    FlValue* entry = fl_value_new_map();
+    fl_value_set_string_take(entry, "id", fl_value_new_int(display.id));
+    fl_value_set_string_take(entry, "x", fl_value_new_int(display.bounds.x));
+    fl_value_set_string_take(entry, "y", fl_value_new_int(display.bounds.y));
+    fl_value_set_string_take(entry, "width",
+                             fl_value_new_int(display.bounds.width));
+    fl_value_set_string_take(entry, "height",
+                             fl_value_new_int(display.bounds.height));
+    fl_value_set_string_take(entry, "primary",
+                             fl_value_new_bool(display.primary));
+    fl_value_set_string_take(entry, "name",
+                             fl_value_new_string(display.name.c_str()));
+    fl_value_append_take(list, entry);
+  }
+  fl_method_call_respond_success(method_call, list, nullptr);
+}
+
+void LinuxScreenshotPlugin::HandleGetStats(FlMethodCall* method_call) {
+  const CaptureStatsSnapshot snapshot = stats_.Snapshot();
+  FlValue* stages = fl_value_new_map();
+  for (size_t i = 0; i < kCaptureStageCount; ++i) {
+    const StageStats& stage = snapshot.stages[i];
+    FlValue* entry = fl_value_new_map();
+    fl_value_set_string_take(
+        entry, "count",
+        fl_value_new_int(static_cast<int64_t>(stage.latency.count)));
+    fl_value_set_string_take(
+        entry, "errors", fl_value_new_int(static_cast<int64_t>(stage.errors)));
+    fl_value_set_string_take(entry, "p50Us", NewMicros(stage.latency.p50));
+    fl_value_set_string_take(entry, "p95Us", NewMicros(stage.latency.p95));
+    fl_value_set_string_take(entry, "p99Us", NewMicros(stage.latency.p99));
+    fl_value_set_string_take(entry, "maxUs", NewMicros(stage.latency.max));
+    fl_value_set_string_take(entry, "meanUs", NewMicros(stage.latency.mean));
+    fl_value_set_string_take(
+        stages, CaptureStageName(static_cast<CaptureStage>(i)), entry);
+  }
+
+  const FramePoolStats pool = frame_pool_.stats();
+  FlValue* pool_map = fl_value_new_map();
+  fl_value_set_string_take(pool_map, "hits",
+                           fl_value_new_int(static_cast<int64_t>(pool.hits)));
+  fl_value_set_string_take(
+      pool_map, "misses", fl_value_new_int(static_cast<int64_t>(pool.misses)));
+  fl_value_set_string_take(
+      pool_map, "evictions",
+      fl_value_new_int(static_cast<int64_t>(pool.evictions)));
+  fl_value_set_string_take(
+      pool_map, "buffers",
+      fl_value_new_int(static_cast<int64_t>(pool.buffers)));
+  fl_value_set_string_take(
+      pool_map, "residentBytes",
+      fl_value_new_int(static_cast<int64_t>(pool.resident_bytes)));
+  fl_value_set_string_take(
+      pool_map, "leasedBytes",
+      fl_value_new_int(static_cast<int64_t>(pool.leased_bytes)));
+
+  const CaptureStreamStats stream = stream_.stats();
+  FlValue* stream_map = fl_value_new_map();
+  fl_value_set_string_take(
+      stream_map, "captured",
+      fl_value_new_int(static_cast<int64_t>(stream.captured)));
+  fl_value_set_string_take(
+      stream_map, "delivered",
+      fl_value_new_int(static_cast<int64_t>(stream.delivered)));
+  fl_value_set_string_take(
+      stream_map, "dropped",
+      fl_value_new_int(static_cast<int64_t>(stream.dropped)));
+  fl_value_set_string_take(
+      stream_map, "failed",
+      fl_value_new_int(static_cast<int64_t>(stream.failed)));
+  fl_value_set_string_take(
+      stream_map, "skipped",
+      fl_value_new_int(static_cast<int64_t>(stream.skipped)));
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "stages", stages);
+  fl_value_set_string_take(
+      result, "capturedBytes",
+      fl_value_new_int(static_cast<int64_t>(snapshot.captured_bytes)));
+  fl_value_set_string_take(
+      result, "outputBytes",
+      fl_value_new_int(static_cast<int64_t>(snapshot.output_bytes)));
+  fl_value_set_string_take(result, "framePool", pool_map);
+  fl_value_set_string_take(result, "stream", stream_map);
+  fl_method_call_respond_success(method_call, result, nullptr);
+}
+
+void LinuxScreenshotPlugin::HandleCaptureAllDisplays(FlMethodCall* method_call,
+                                                     FlValue* arguments) {
+  const bool include_cursor =
+      BoolArgument(arguments, "includeCursor", false);
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, method_call)) return;
+
+  std::vector<DisplayInfo> displays;
+  if (!display_backend_.ListDisplays(&displays)) {
+    RespondError(method_call, "internal_error", "Failed to open the X display");
+    return;
+  }
+  // The encode stage needs the layout too, for the result.
+  std::vector<DisplayInfo> layout = displays;
+  pipeline_->Submit(std::make_unique<DisplaysCaptureJob>(
+      &display_capture_, std::move(displays), include_cursor, false,
+      [this, layout, settings](const std::vector<ImageView>& frames,
+                               int64_t timestamp_us, CaptureReply* reply) {
+        FlValue* list = fl_value_new_list();
+        for (size_t i = 0; i < frames.size(); ++i) {
+          size_t stride = 0;
+          FlValue* bytes =
+              EncodeCapture(frames[i], settings, &encoder_session_, &stride);
+          if (!bytes) {
+            fl_value_unref(list);
+            reply->Fail("internal_error", "Failed to encode image");
+            return;
+          }
+          reply->sample()->output_bytes += fl_value_get_length(bytes);
+          FlValue* entry = MakeCaptureResult(frames[i].width, frames[i].height,
+                                             settings.format, stride, bytes);
+          fl_value_set_string_take(entry, "displayId",
+                                   fl_value_new_int(layout[i].id));
+          fl_value_set_string_take(entry, "x",
+                                   fl_value_new_int(layout[i].bounds.x));
+          fl_value_set_string_take(entry, "y",
+                                   fl_value_new_int(layout[i].bounds.y));
+          fl_value_append_take(list, entry);
+        }
+        reply->Succeed(list);
+      },
+      method_call, &stats_));
+}
+
+void LinuxScreenshotPlugin::HandleStartStream(FlMethodCall* method_call,
+                                              FlValue* arguments) {
+  // Get fps parameter (optional, default 30)
+  CaptureStreamOptions options;
+  options.fps = kDefaultStreamFps;
+  if (FlValue* fps = LookupArgument(arguments, "fps")) {
+    if (fl_value_get_type(fps) == FL_VALUE_TYPE_FLOAT) {
+      options.fps = fl_value_get_float(fps);
+    } else if (fl_value_get_type(fps) == FL_VALUE_TYPE_INT) {
+      options.fps = static_cast<double>(fl_value_get_int(fps));
+    } else {
+      RespondError(method_call, "invalid_argument", "'fps' must be a number");
+      return;
+    }
+    if (!(options.fps > 0.0 && options.fps <= CaptureStream::kMaxFps)) {
+      RespondError(method_call, "invalid_argument",
+                   "Invalid fps: " + std::to_string(options.fps));
+      return;
+    }
+  }
+  const bool include_cursor =
+      BoolArgument(arguments, "includeCursor", false);
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, method_call)) return;
+
+  // A new startStream replaces the running stream.
+  stream_.Stop();
+  {
+    std::lock_guard<std::mutex> lock(stream_event_mutex_);
+    pending_stream_event_.reset();
+    stream_events_dropped_ = 0;
+  }
+  stream_source_ = std::make_unique<RootFrameSource>(include_cursor);
+  const bool started = stream_.Start(
+      stream_source_.get(), options,
+      [this, settings](const StreamFrame& frame) {
+        // Runs on the stream's delivery thread: encode here, send on the
+        // platform thread.
+        size_t stride = 0;
+        FlValue* bytes =
+            EncodeCapture(frame.View(), settings, &stream_session_, &stride);
+        if (!bytes) {
+          // Counted in the stream's "failed", which the next event carries.
+          stats_.RecordError(CaptureStage::kEncode);
+          return false;
+        }
+        FlValue* event = MakeCaptureResult(frame.width, frame.height,
+                                           settings.format, stride, bytes);
+        fl_value_set_string_take(
+            event, "sequence",
+            fl_value_new_int(static_cast<int64_t>(frame.sequence)));
+        fl_value_set_string_take(event, "timestampUs",
+                                 fl_value_new_int(frame.timestamp_us));
+        PostStreamEvent(event);
+        return true;
+      });
+  if (!started) {
+    RespondError(method_call, "internal_error",
+                 "Failed to start capture stream");
+    return;
+  }
+  fl_method_call_respond_success(method_call, nullptr, nullptr);
+}
+
+void LinuxScreenshotPlugin::HandleReleaseShared(FlMethodCall* method_call,
+                                                FlValue* arguments) {
+  FlValue* generation = LookupArgument(arguments, "generation");
+  if (!generation) {
+    RespondError(method_call, "invalid_argument",
+                 "Missing 'generation' parameter");
+    return;
+  }
+  if (fl_value_get_type(generation) != FL_VALUE_TYPE_INT) {
+    RespondError(method_call, "invalid_argument",
+                 "'generation' must be an int");
+    return;
+  }
+  // Releasing twice (or after the plugin restarted) is harmless.
+  g_autoptr(FlValue) released = fl_value_new_bool(shared_ring_.Release(
+      static_cast<uint64_t>(fl_value_get_int(generation))));
+  fl_method_call_respond_success(method_call, released, nullptr);
+}
+
+void LinuxScreenshotPlugin::PostStreamEvent(FlValue* event) {
+  bool post = false;
+  {
+    std::lock_guard<std::mutex> lock(stream_event_mutex_);
+    // Like the capture mailbox, keep only the newest frame if the platform
+    // thread has not sent the previous one yet.
+    if (pending_stream_event_) {
+      ++stream_events_dropped_;
+    } else {
+      post = true;
+    }
+    pending_stream_event_.reset(event);
+  }
+  if (post) main_thread_.Post([this] { SendStreamEvent(); });
+}
+
+void LinuxScreenshotPlugin::SendStreamEvent() {
+  FlValueRef event;
+  uint64_t dropped = 0;
+  {
+    std::lock_guard<std::mutex> lock(stream_event_mutex_);
+    event = std::move(pending_stream_event_);
+    dropped = stream_events_dropped_;
+  }
+  if (!event || !listening_) return;
+  const CaptureStreamStats stats = stream_.stats();
+  dropped += stats.dropped;
+  fl_value_set_string_take(event.get(), "dropped",
+                           fl_value_new_int(static_cast<int64_t>(dropped)));
+  fl_value_set_string_take(
+      event.get(), "failed",
+      fl_value_new_int(static_cast<int64_t>(stats.failed)));
+  fl_event_channel_send(event_channel_, event.get(), nullptr, nullptr);
+}
+
+}  // namespace
+}  // namespace screenshot
+
+#define SCREENSHOT_PLUGIN(obj)                                     \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), screenshot_plugin_get_type(), \
+                              ScreenshotPlugin))
+
+struct _ScreenshotPlugin {
+  GObject parent_instance;
+
+  FlEventChannel* event_channel;
+  screenshot::LinuxScreenshotPlugin* impl;
+};
+
+G_DEFINE_TYPE(ScreenshotPlugin, screenshot_plugin, g_object_get_type())
+
+static void screenshot_plugin_dispose(GObject* object) {
+  ScreenshotPlugin* self = SCREENSHOT_PLUGIN(object);
+  // The event channel does not hold the plugin, and may outlive it.
+  if (self->event_channel) {
+    fl_event_channel_set_stream_handlers(self->event_channel, nullptr,
+                                         nullptr, nullptr, nullptr);
+  }
+  delete self->impl;
+  self->impl = nullptr;
+  g_clear_object(&self->event_channel);
+
+  G_OBJECT_CLASS(screenshot_plugin_parent_class)->dispose(object);
+}
+
+static void screenshot_plugin_class_init(ScreenshotPluginClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = screenshot_plugin_dispose;
+}
+
+static void screenshot_plugin_init(ScreenshotPlugin* self) {}
+
+static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  ScreenshotPlugin* plugin = SCREENSHOT_PLUGIN(user_data);
+  plugin->impl->HandleMethodCall(method_call);
+}
+
+static FlMethodErrorResponse* listen_cb(FlEventChannel* channel,
+                                        FlValue* args, gpointer user_data) {
+  SCREENSHOT_PLUGIN(user_data)->impl->OnListen();
+  return nullptr;
+}
+
+static FlMethodErrorResponse* cancel_cb(FlEventChannel* channel,
+                                        FlValue* args, gpointer user_data) {
+  SCREENSHOT_PLUGIN(user_data)->impl->OnCancel();
+  return nullptr;
+}
+
+void screenshot_plugin_register_with_registrar(FlPluginRegistrar* registrar) {
+  ScreenshotPlugin* plugin =
+      SCREENSHOT_PLUGIN(g_object_new(screenshot_plugin_get_type(), nullptr));
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  FlBinaryMessenger* messenger = fl_plugin_registrar_get_messenger(registrar);
+  g_autoptr(FlMethodChannel) channel = fl_method_channel_new(
+      messenger, "dev.flutter.screenshot", FL_METHOD_CODEC(codec));
+  // Frames of "startStream" are sent on this channel.
+  plugin->event_channel = fl_event_channel_new(
+      messenger, "dev.flutter.screenshot/stream", FL_METHOD_CODEC(codec));
+  plugin->impl =
+      new screenshot::LinuxScreenshotPlugin(plugin->event_channel);
+
+  // The method channel holds the plugin, and it goes away with it. The
+  // plugin holds the event channel, so the event channel only borrows it;
+  // dispose removes the stream handlers.
+  fl_method_channel_set_method_call_handler(
+      channel, method_call_cb, g_object_ref(plugin), g_object_unref);
+  fl_event_channel_set_stream_handlers(plugin->event_channel, listen_cb,
+                                       cancel_cb, plugin, nullptr);
+
+  g_object_unref(plugin);
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+// After gtest: Xlib defines macros such as None and Bool.
+#include <X11/Xlib.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "image.h"
+#include "image_rect.h"
+#include "x11_display_backend.h"
+#include "x11_screen_capture.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+// These tests need an X server; run them under Xvfb, e.g.
+// xvfb-run -s "-screen 0 640x480x24" ctest. Without $DISPLAY they skip.
+class X11ScreenCaptureTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    display_ = XOpenDisplay(nullptr);
+    if (!display_) GTEST_SKIP() << "No X display";
+    capture_ = X11ScreenCapture::Open();
+    if (!capture_) GTEST_SKIP() << "Display is not 32-bit BGRX";
+  }
+
+  void TearDown() override {
+    capture_.reset();
+    if (display_) XCloseDisplay(display_);
+  }
+
+  // Paints the root window |rgb| through a separate connection, as another
+  // client would.
+  void FillRoot(uint32_t rgb) {
+    const Window root = DefaultRootWindow(display_);
+    XSetWindowBackground(display_, root, rgb);
+    XClearWindow(display_, root);
+    XSync(display_, False);
+  }
+
+  static uint32_t PixelAt(const ImageView& view, int x, int y) {
+    uint32_t bgrx = 0;
+    std::memcpy(&bgrx, view.Row(y) + static_cast<size_t>(x) * kBytesPerPixel,
+                sizeof(bgrx));
+    return bgrx & 0xFFFFFF;
+  }
+
+  Display* display_ = nullptr;
+  std::unique_ptr<X11ScreenCapture> capture_;
+};
+
+TEST_F(X11ScreenCaptureTest, CapturesRootPixels) {
+  FillRoot(0x3366CC);
+  const PixelRect root = capture_->RootBounds();
+  ASSERT_FALSE(root.IsEmpty());
+
+  ImageView view;
+  ASSERT_TRUE(capture_->Capture(root, false, &view));
+  EXPECT_EQ(view.width, root.width);
+  EXPECT_EQ(view.height, root.height);
+  EXPECT_EQ(view.format, PixelFormat::kBgra8);
+  EXPECT_EQ(PixelAt(view, 0, 0), 0x3366CCu);
+  EXPECT_EQ(PixelAt(view, root.width - 1, root.height - 1), 0x3366CCu);
+}
+
+TEST_F(X11ScreenCaptureTest, ShmAndFallbackAgree) {
+  FillRoot(0x80FF10);
+  X11ScreenCaptureOptions options;
+  options.use_shm = false;
+  std::unique_ptr<X11ScreenCapture> fallback =
+      X11ScreenCapture::Open(nullptr, options);
+  ASSERT_TRUE(fallback);
+  EXPECT_FALSE(fallback->uses_shm());
+
+  const PixelRect rect{5, 7, 64, 33};
+  ImageView shm_view;
+  ImageView fallback_view;
+  ASSERT_TRUE(capture_->Capture(rect, false, &shm_view));
+  ASSERT_TRUE(fallback->Capture(rect, false, &fallback_view));
+  ASSERT_EQ(shm_view.width, fallback_view.width);
+  ASSERT_EQ(shm_view.height, fallback_view.height);
+  for (int y = 0; y < rect.height; ++y) {
+    for (int x = 0; x < rect.width; ++x) {
+      ASSERT_EQ(PixelAt(shm_view, x, y), PixelAt(fallback_view, x, y))
+          << "at " << x << "," << y;
+    }
+  }
+}
+
+TEST_F(X11ScreenCaptureTest, ReusesSegmentForSmallerCaptures) {
+  if (!capture_->uses_shm()) GTEST_SKIP() << "No MIT-SHM";
+  ImageView large;
+  ASSERT_TRUE(capture_->Capture(PixelRect{0, 0, 128, 64}, false, &large));
+  ImageView small;
+  ASSERT_TRUE(capture_->Capture(PixelRect{10, 10, 32, 32}, false, &small));
+  // The same segment, not a new allocation.
+  EXPECT_EQ(large.data, small.data);
+  EXPECT_TRUE(capture_->uses_shm());
+}
+
+TEST_F(X11ScreenCaptureTest, FailsOutsideRootAndRecovers) {
+  const PixelRect root = capture_->RootBounds();
+  ImageView view;
+  EXPECT_FALSE(capture_->Capture(
+      PixelRect{root.width - 4, 0, 16, 16}, false, &view));
+  EXPECT_FALSE(capture_->Capture(PixelRect{0, 0, 0, 16}, false, &view));
+
+  FillRoot(0x102030);
+  ASSERT_TRUE(capture_->Capture(PixelRect{0, 0, 16, 16}, false, &view));
+  EXPECT_EQ(PixelAt(view, 15, 15), 0x102030u);
+}
+
+TEST_F(X11ScreenCaptureTest, CompositesCursor) {
+  if (!capture_->has_cursor()) GTEST_SKIP() << "No XFixes";
+  FillRoot(0x000000);
+  const Window root = DefaultRootWindow(display_);
+  XWarpPointer(display_, None, root, 0, 0, 0, 0, 40, 40);
+  XSync(display_, False);
+
+  const PixelRect rect{0, 0, 96, 96};
+  ImageView view;
+  ASSERT_TRUE(capture_->Capture(rect, false, &view));
+  std::vector<uint32_t> without_cursor;
+  for (int y = 0; y < rect.height; ++y) {
+    for (int x = 0; x < rect.width; ++x) {
+      without_cursor.push_back(PixelAt(view, x, y));
+    }
+  }
+  ASSERT_TRUE(capture_->Capture(rect, true, &view));
+  int changed = 0;
+  for (int y = 0; y < rect.height; ++y) {
+    for (int x = 0; x < rect.width; ++x) {
+      if (PixelAt(view, x, y) !=
+          without_cursor[static_cast<size_t>(y * rect.width + x)]) {
+        ++changed;
+      }
+    }
+  }
+  EXPECT_GT(changed, 0);
+}
+
+TEST_F(X11ScreenCaptureTest, BackendListsAndCapturesRoot) {
+  FillRoot(0xABCDEF);
+  X11DisplayBackend backend;
+  std::vector<DisplayInfo> displays;
+  ASSERT_TRUE(backend.ListDisplays(&displays));
+  ASSERT_EQ(displays.size(), 1u);
+  EXPECT_EQ(displays[0].id, 0);
+  EXPECT_TRUE(displays[0].primary);
+  EXPECT_EQ(displays[0].bounds.x, 0);
+  EXPECT_EQ(displays[0].bounds.y, 0);
+
+  const PixelRect& bounds = displays[0].bounds;
+  std::vector<uint8_t> pixels(static_cast<size_t>(bounds.width) *
+                              kBytesPerPixel *
+                              static_cast<size_t>(bounds.height));
+  ASSERT_TRUE(backend.CaptureDisplay(displays[0], false, 1, pixels.data()));
+  const ImageView view{pixels.data(), bounds.width, bounds.height,
+                       static_cast<size_t>(bounds.width) * kBytesPerPixel,
+                       PixelFormat::kBgra8};
+  EXPECT_EQ(PixelAt(view, bounds.width - 1, bounds.height - 1), 0xABCDEFu);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
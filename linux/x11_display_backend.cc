@@ -0,0 +1,56 @@
+#include "x11_display_backend.h"
+
+#include <cstring>
+#include <utility>
+
+namespace screenshot {
+
+X11DisplayBackend::X11DisplayBackend(std::string display_name)
+    : display_name_(std::move(display_name)) {}
+
+bool X11DisplayBackend::ListDisplays(std::vector<DisplayInfo>* displays) {
+  displays->clear();
+  std::lock_guard<std::mutex> lock(list_mutex_);
+  if (!list_capture_) {
+    list_capture_ = X11ScreenCapture::Open(
+        display_name_.empty() ? nullptr : display_name_.c_str());
+    if (!list_capture_) return false;
+  }
+  DisplayInfo display;
+  display.bounds = list_capture_->RootBounds();
+  if (display.bounds.IsEmpty()) return false;
+  display.primary = true;
+  display.name = list_capture_->name();
+  displays->push_back(display);
+  return true;
+}
+
+bool X11DisplayBackend::CaptureDisplay(const DisplayInfo& display,
+                                       bool include_cursor, int lane,
+                                       uint8_t* pixels) {
+  X11ScreenCapture* capture = Lane(lane);
+  ImageView view;
+  if (!capture || !capture->Capture(display.bounds, include_cursor, &view)) {
+    return false;
+  }
+  // Out of the segment the next capture reuses, into packed rows.
+  const size_t row_bytes = view.RowBytes();
+  for (int y = 0; y < view.height; ++y) {
+    std::memcpy(pixels + static_cast<size_t>(y) * row_bytes, view.Row(y),
+                row_bytes);
+  }
+  return true;
+}
+
+X11ScreenCapture* X11DisplayBackend::Lane(int lane) {
+  std::lock_guard<std::mutex> lock(lanes_mutex_);
+  const size_t index = static_cast<size_t>(lane);
+  if (lanes_.size() <= index) lanes_.resize(index + 1);
+  if (!lanes_[index]) {
+    lanes_[index] = X11ScreenCapture::Open(
+        display_name_.empty() ? nullptr : display_name_.c_str());
+  }
+  return lanes_[index].get();
+}
+
+}  // namespace screenshot
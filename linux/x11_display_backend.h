@@ -0,0 +1,50 @@
+#ifndef FLUTTER_PLUGIN_X11_DISPLAY_BACKEND_H_
+#define FLUTTER_PLUGIN_X11_DISPLAY_BACKEND_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "display_capture.h"
+#include "x11_screen_capture.h"
+
+namespace screenshot {
+
+// Displays as core X11 sees them: one display, the root window of the
+// default screen, which spans every monitor the server drives.
+//
+// Each capture lane opens an X11ScreenCapture (a connection and MIT-SHM
+// segment) of its own on first use and keeps it, so lanes never share a
+// connection and repeated captures reuse the segment.
+class X11DisplayBackend : public DisplayBackend {
+ public:
+  // Connects to |display_name|; empty uses $DISPLAY.
+  explicit X11DisplayBackend(std::string display_name = std::string());
+
+  X11DisplayBackend(const X11DisplayBackend&) = delete;
+  X11DisplayBackend& operator=(const X11DisplayBackend&) = delete;
+
+  bool ListDisplays(std::vector<DisplayInfo>* displays) override;
+
+  bool CaptureDisplay(const DisplayInfo& display, bool include_cursor,
+                      int lane, uint8_t* pixels) override;
+
+ private:
+  // The capture of |lane|, opened on first use; null if the display cannot
+  // be opened.
+  X11ScreenCapture* Lane(int lane);
+
+  std::string display_name_;
+
+  // Answers ListDisplays(), which runs on another thread than the captures.
+  std::mutex list_mutex_;
+  std::unique_ptr<X11ScreenCapture> list_capture_;
+
+  std::mutex lanes_mutex_;
+  std::vector<std::unique_ptr<X11ScreenCapture>> lanes_;
+};
+
+}  // namespace screenshot
+
+#endif  // FLUTTER_PLUGIN_X11_DISPLAY_BACKEND_H_
@@ -0,0 +1,273 @@
+#include "x11_screen_capture.h"
+
+// Ahead of Xlibint.h, whose min and max macros break the C++ headers.
+#include "trace.h"
+
+#include <X11/Xlibint.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/Xfixes.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+namespace screenshot {
+namespace {
+
+// The error code of the last X error on this thread's connection, 0 if
+// none. Xlib reports errors on the thread that waits for the reply.
+thread_local int g_x_error = 0;
+
+// Per-connection error hook (see XESetError): records the error and keeps
+// it from the process-wide handler, which GTK sets to abort.
+int RecordXError(Display*, xError* error, XExtCodes*, int* ret_code) {
+  g_x_error = error->errorCode;
+  *ret_code = 0;
+  return 1;
+}
+
+// Whether pixels of |visual| at |depth| are 32-bit little-endian BGRX.
+bool IsBgrx(Display* display, Visual* visual, int depth) {
+  return (depth == 24 || depth == 32) && visual->c_class == TrueColor &&
+         visual->red_mask == 0xFF0000 && visual->green_mask == 0xFF00 &&
+         visual->blue_mask == 0xFF && ImageByteOrder(display) == LSBFirst;
+}
+
+bool IsBgrxImage(const XImage* image) {
+  return image->bits_per_pixel == 32 && image->byte_order == LSBFirst;
+}
+
+// |cursor| as a CursorImage from |cache|, converted from its ARGB longs the
+// first time its serial is seen.
+const CursorImage* CachedCursor(const XFixesCursorImage* cursor,
+                                CursorCache* cache) {
+  const CursorImage* cached = cache->Find(cursor->cursor_serial);
+  if (cached) return cached;
+  CursorImage* image = cache->Insert(cursor->cursor_serial);
+  image->width = cursor->width;
+  image->height = cursor->height;
+  image->hotspot_x = cursor->xhot;
+  image->hotspot_y = cursor->yhot;
+  // Premultiplied ARGB, one pixel per (possibly 64-bit) long: BGRA bytes
+  // once narrowed to 32 bits.
+  const size_t count = static_cast<size_t>(cursor->width) * cursor->height;
+  image->pixels.resize(count * kBytesPerPixel);
+  for (size_t i = 0; i < count; ++i) {
+    const uint32_t argb = static_cast<uint32_t>(cursor->pixels[i]);
+    uint8_t* pixel = image->pixels.data() + i * kBytesPerPixel;
+    pixel[0] = static_cast<uint8_t>(argb);
+    pixel[1] = static_cast<uint8_t>(argb >> 8);
+    pixel[2] = static_cast<uint8_t>(argb >> 16);
+    pixel[3] = static_cast<uint8_t>(argb >> 24);
+  }
+  return image;
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<X11ScreenCapture> X11ScreenCapture::Open(
+    const char* display_name, const X11ScreenCaptureOptions& options) {
+  Display* display = XOpenDisplay(display_name);
+  if (!display) return nullptr;
+  const int screen = DefaultScreen(display);
+  if (!IsBgrx(display, DefaultVisual(display, screen),
+              DefaultDepth(display, screen))) {
+    XCloseDisplay(display);
+    return nullptr;
+  }
+  return std::unique_ptr<X11ScreenCapture>(
+      new X11ScreenCapture(display, options.use_shm));
+}
+
+X11ScreenCapture::X11ScreenCapture(Display* display, bool use_shm)
+    : display_(display),
+      root_(DefaultRootWindow(display)),
+      visual_(DefaultVisual(display, DefaultScreen(display))),
+      depth_(DefaultDepth(display, DefaultScreen(display))) {
+  XExtCodes* codes = XAddExtension(display_);
+  if (codes) XESetError(display_, codes->extension, RecordXError);
+
+  shm_available_ = use_shm && XShmQueryExtension(display_);
+  int event_base = 0;
+  int error_base = 0;
+  has_xfixes_ = XFixesQueryExtension(display_, &event_base, &error_base);
+}
+
+X11ScreenCapture::~X11ScreenCapture() {
+  DestroyShmImage();
+  DetachSegment();
+  if (fallback_image_) XDestroyImage(fallback_image_);
+  XCloseDisplay(display_);
+}
+
+PixelRect X11ScreenCapture::RootBounds() {
+  Window root = 0;
+  int x = 0;
+  int y = 0;
+  unsigned int width = 0;
+  unsigned int height = 0;
+  unsigned int border = 0;
+  unsigned int depth = 0;
+  if (!XGetGeometry(display_, root_, &root, &x, &y, &width, &height, &border,
+                    &depth)) {
+    return PixelRect();
+  }
+  return PixelRect{0, 0, static_cast<int>(width), static_cast<int>(height)};
+}
+
+bool X11ScreenCapture::Capture(const PixelRect& rect, bool include_cursor,
+                               ImageView* view) {
+  if (rect.IsEmpty()) return false;
+  bool captured = false;
+  if (shm_available_) {
+    captured = CaptureShm(rect, view);
+  }
+  // Not an else: CaptureShm() may have just found MIT-SHM unusable.
+  if (!shm_available_) {
+    captured = CaptureFallback(rect, view);
+  }
+  if (captured && include_cursor && has_xfixes_) {
+    CompositeCursor(rect, *view);
+  }
+  return captured;
+}
+
+bool X11ScreenCapture::PrepareShmImage(int width, int height) {
+  if (shm_image_ && shm_image_->width == width &&
+      shm_image_->height == height) {
+    return true;
+  }
+  DestroyShmImage();
+  // The header alone: its bytes_per_line says how large the segment must
+  // be.
+  XImage* image = XShmCreateImage(display_, visual_,
+                                  static_cast<unsigned int>(depth_), ZPixmap,
+                                  nullptr, &shm_info_,
+                                  static_cast<unsigned int>(width),
+                                  static_cast<unsigned int>(height));
+  if (!image) return false;
+  if (!IsBgrxImage(image)) {
+    XDestroyImage(image);
+    shm_available_ = false;
+    return false;
+  }
+  const size_t size = static_cast<size_t>(image->bytes_per_line) *
+                      static_cast<size_t>(height);
+  if (size > shm_size_) {
+    DetachSegment();
+    const int id = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    void* address = id >= 0 ? shmat(id, nullptr, 0) : reinterpret_cast<void*>(-1);
+    if (address == reinterpret_cast<void*>(-1)) {
+      if (id >= 0) shmctl(id, IPC_RMID, nullptr);
+      XDestroyImage(image);
+      shm_available_ = false;
+      return false;
+    }
+    shm_info_.shmid = id;
+    shm_info_.shmaddr = static_cast<char*>(address);
+    shm_info_.readOnly = False;
+    SyncFailed();
+    const bool attached = XShmAttach(display_, &shm_info_) && !SyncFailed();
+    // Marked for removal now, so the segment goes away with the last
+    // process detaching it, even after a crash.
+    shmctl(id, IPC_RMID, nullptr);
+    if (!attached) {
+      // Typically a display on another machine.
+      shmdt(shm_info_.shmaddr);
+      shm_info_ = {};
+      XDestroyImage(image);
+      shm_available_ = false;
+      return false;
+    }
+    shm_attached_ = true;
+    shm_size_ = size;
+  }
+  image->data = shm_info_.shmaddr;
+  shm_image_ = image;
+  return true;
+}
+
+void X11ScreenCapture::DestroyShmImage() {
+  if (!shm_image_) return;
+  // The data is the segment, which outlives the header.
+  shm_image_->data = nullptr;
+  XDestroyImage(shm_image_);
+  shm_image_ = nullptr;
+}
+
+void X11ScreenCapture::DetachSegment() {
+  if (!shm_attached_) return;
+  XShmDetach(display_, &shm_info_);
+  XSync(display_, False);
+  shmdt(shm_info_.shmaddr);
+  shm_info_ = {};
+  shm_attached_ = false;
+  shm_size_ = 0;
+}
+
+bool X11ScreenCapture::CaptureShm(const PixelRect& rect, ImageView* view) {
+  if (!PrepareShmImage(rect.width, rect.height)) return false;
+  TraceSpan span("XShmGetImage");
+  g_x_error = 0;
+  if (!XShmGetImage(display_, root_, shm_image_, rect.x, rect.y, AllPlanes) ||
+      g_x_error != 0) {
+    g_x_error = 0;
+    return false;
+  }
+  view->data = reinterpret_cast<const uint8_t*>(shm_image_->data);
+  view->width = rect.width;
+  view->height = rect.height;
+  view->stride = static_cast<size_t>(shm_image_->bytes_per_line);
+  view->format = PixelFormat::kBgra8;
+  return true;
+}
+
+bool X11ScreenCapture::CaptureFallback(const PixelRect& rect,
+                                       ImageView* view) {
+  if (fallback_image_) {
+    XDestroyImage(fallback_image_);
+    fallback_image_ = nullptr;
+  }
+  TraceSpan span("XGetImage");
+  g_x_error = 0;
+  fallback_image_ = XGetImage(display_, root_, rect.x, rect.y,
+                              static_cast<unsigned int>(rect.width),
+                              static_cast<unsigned int>(rect.height),
+                              AllPlanes, ZPixmap);
+  g_x_error = 0;
+  if (!fallback_image_) return false;
+  if (!IsBgrxImage(fallback_image_)) {
+    XDestroyImage(fallback_image_);
+    fallback_image_ = nullptr;
+    return false;
+  }
+  view->data = reinterpret_cast<const uint8_t*>(fallback_image_->data);
+  view->width = rect.width;
+  view->height = rect.height;
+  view->stride = static_cast<size_t>(fallback_image_->bytes_per_line);
+  view->format = PixelFormat::kBgra8;
+  return true;
+}
+
+void X11ScreenCapture::CompositeCursor(const PixelRect& rect,
+                                       const ImageView& view) {
+  TraceSpan span("cursor");
+  XFixesCursorImage* cursor = XFixesGetCursorImage(display_);
+  if (!cursor) return;
+  // The cursor image in capture coordinates; CompositeCursor clips it.
+  const CursorImage* image = CachedCursor(cursor, &cursors_);
+  // The view is read-only to callers; the pixels are ours to draw on.
+  ::screenshot::CompositeCursor(*image, cursor->x - cursor->xhot - rect.x,
+                                cursor->y - cursor->yhot - rect.y,
+                                const_cast<uint8_t*>(view.data), view.width,
+                                view.height, view.stride);
+  XFree(cursor);
+}
+
+bool X11ScreenCapture::SyncFailed() {
+  XSync(display_, False);
+  const bool failed = g_x_error != 0;
+  g_x_error = 0;
+  return failed;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,115 @@
+#ifndef FLUTTER_PLUGIN_X11_SCREEN_CAPTURE_H_
+#define FLUTTER_PLUGIN_X11_SCREEN_CAPTURE_H_
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "cursor_compositor.h"
+#include "image.h"
+#include "image_rect.h"
+
+namespace screenshot {
+
+struct X11ScreenCaptureOptions {
+  // Read through MIT-SHM when the server offers it. Off forces the
+  // XGetImage path, e.g. to compare the two.
+  bool use_shm = true;
+};
+
+// Captures the root window of an X11 screen (every monitor of it) or a
+// rectangle of it.
+//
+// With MIT-SHM the server writes the pixels straight into a shared-memory
+// segment attached once and reused by every capture, so a frame costs no
+// allocation and no copy through the socket; the segment only grows when a
+// larger rectangle is asked for. When the extension is missing or the
+// segment cannot be attached (a remote display), captures fall back to
+// XGetImage, which receives the pixels over the socket.
+//
+// The cursor, which X11 leaves out of captured pixels, is composited from
+// XFixes when asked for. X errors on the connection are caught per capture
+// and reported as failures, never through the process-wide error handler.
+//
+// Owns its own connection; use from one thread at a time.
+class X11ScreenCapture {
+ public:
+  // Connects to |display_name| (null uses $DISPLAY). Returns null if the
+  // display cannot be opened or its default visual is not 32-bit BGRX,
+  // the layout of every common 24- and 32-bit depth X server.
+  static std::unique_ptr<X11ScreenCapture> Open(
+      const char* display_name = nullptr,
+      const X11ScreenCaptureOptions& options = X11ScreenCaptureOptions());
+
+  ~X11ScreenCapture();
+
+  X11ScreenCapture(const X11ScreenCapture&) = delete;
+  X11ScreenCapture& operator=(const X11ScreenCapture&) = delete;
+
+  // Current size of the root window, at (0, 0); empty on failure. Queried
+  // from the server each time, so a resized screen is picked up.
+  PixelRect RootBounds();
+
+  // Captures |rect| of the root window, with the cursor drawn on top if
+  // |include_cursor| and XFixes is available. |view| receives BGRA pixels
+  // in a buffer the next capture reuses; alpha is undefined, as with GDI.
+  // Returns false if |rect| is not inside the root window or the server
+  // fails the request.
+  bool Capture(const PixelRect& rect, bool include_cursor, ImageView* view);
+
+  // Whether captures go through MIT-SHM (false after falling back).
+  bool uses_shm() const { return shm_available_; }
+
+  // Whether the cursor can be composited.
+  bool has_cursor() const { return has_xfixes_; }
+
+  // The display's name, such as ":0".
+  const char* name() const { return DisplayString(display_); }
+
+ private:
+  X11ScreenCapture(Display* display, bool use_shm);
+
+  // Makes |shm_image_| |width| x |height|, growing and attaching the
+  // segment as needed. Returns false, leaving shm_available_ false, if the
+  // segment cannot be attached.
+  bool PrepareShmImage(int width, int height);
+  void DestroyShmImage();
+  void DetachSegment();
+
+  bool CaptureShm(const PixelRect& rect, ImageView* view);
+  bool CaptureFallback(const PixelRect& rect, ImageView* view);
+
+  // Alpha-blends the XFixes cursor image into |view|, which shows |rect|.
+  void CompositeCursor(const PixelRect& rect, const ImageView& view);
+
+  // Flushes the connection and returns whether an X error arrived since
+  // the last call.
+  bool SyncFailed();
+
+  Display* display_;
+  Window root_;
+  Visual* visual_;
+  int depth_;
+  bool has_xfixes_ = false;
+
+  // MIT-SHM can be tried; cleared when attaching fails.
+  bool shm_available_ = false;
+  bool shm_attached_ = false;
+  XShmSegmentInfo shm_info_ = {};
+  size_t shm_size_ = 0;
+  // Header describing the segment at the last captured size.
+  XImage* shm_image_ = nullptr;
+
+  // The last XGetImage reply, kept until the next capture.
+  XImage* fallback_image_ = nullptr;
+
+  // Converted cursors by XFixes cursor serial.
+  CursorCache cursors_;
+};
+
+}  // namespace screenshot
+
+#endif  // FLUTTER_PLUGIN_X11_SCREEN_CAPTURE_H_
@@ -0,0 +1,97 @@
+#include "batch_encoder.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "trace.h"
+
+namespace screenshot {
+
+namespace {
+
+int64_t Area(const PixelRect& rect) {
+  return static_cast<int64_t>(rect.width) * rect.height;
+}
+
+}  // namespace
+
+BatchEncoder::BatchEncoder(const BatchEncoderOptions& options)
+    : options_(options) {}
+
+bool BatchEncoder::Encode(const ImageView& frame,
+                          const std::vector<BatchCrop>& crops,
+                          std::vector<BatchOutput>* outputs) {
+  outputs->clear();
+  if (!frame.IsValid()) return false;
+  const size_t count = crops.size();
+  const PixelRect bounds{0, 0, frame.width, frame.height};
+  views_.resize(count);
+  outputs->resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (!CropImage(frame, crops[i].rect, &views_[i])) {
+      outputs->clear();
+      return false;
+    }
+    (*outputs)[i].rect = IntersectRects(crops[i].rect, bounds);
+  }
+  order_.resize(count);
+  for (size_t i = 0; i < count; ++i) order_[i] = i;
+  std::stable_sort(order_.begin(), order_.end(),
+                   [outputs](size_t a, size_t b) {
+                     return Area((*outputs)[a].rect) >
+                            Area((*outputs)[b].rect);
+                   });
+
+  // The calling thread is a lane too.
+  const int workers = ThreadPool::ResolveThreadCount(options_.threads) - 1;
+  const size_t lanes =
+      std::max<size_t>(1, std::min(count, static_cast<size_t>(workers) + 1));
+  while (lanes_.size() < lanes) lanes_.push_back(std::make_unique<Lane>());
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  auto run_lane = [&](size_t lane) {
+    for (size_t k = next.fetch_add(1); k < count && !failed.load();
+         k = next.fetch_add(1)) {
+      const size_t i = order_[k];
+      if (!EncodeCrop(lanes_[lane].get(), views_[i], crops[i], lanes == 1,
+                      &(*outputs)[i])) {
+        failed.store(true);
+      }
+    }
+  };
+  if (lanes > 1) {
+    if (!pool_ || pool_->size() != workers) {
+      pool_ = std::make_unique<ThreadPool>(workers);
+    }
+    pool_->ParallelFor(lanes, run_lane);
+  } else {
+    run_lane(0);
+  }
+  if (failed.load()) {
+    outputs->clear();
+    return false;
+  }
+  return true;
+}
+
+bool BatchEncoder::EncodeCrop(Lane* lane, const ImageView& view,
+                              const BatchCrop& crop, bool alone,
+                              BatchOutput* output) {
+  TraceSpan span("batch crop");
+  ResizeOptions resize_options = lane->resizer.options();
+  resize_options.threads = alone ? 0 : 1;
+  lane->resizer.set_options(resize_options);
+  ImageView image = view;
+  if (!lane->resizer.Fit(view, crop.limits, &image)) return false;
+  EncodeSettings settings = crop.settings;
+  if (!alone) settings.threads = 1;
+  EncoderSession& session = lane->session;
+  if (!session.Encode(image, settings)) return false;
+  output->width = image.width;
+  output->height = image.height;
+  output->stride = session.stride();
+  output->bytes.assign(session.data(), session.data() + session.size());
+  return true;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,88 @@
+#ifndef SCREENSHOT_CORE_BATCH_ENCODER_H_
+#define SCREENSHOT_CORE_BATCH_ENCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "encoder_session.h"
+#include "image.h"
+#include "image_rect.h"
+#include "image_resizer.h"
+#include "thread_pool.h"
+
+namespace screenshot {
+
+// One rectangle of a batch and how it is returned.
+struct BatchCrop {
+  // In the frame's pixel coordinates; clipped to the frame.
+  PixelRect rect;
+  EncodeSettings settings;
+  ResizeLimits limits;
+};
+
+// An encoded BatchCrop.
+struct BatchOutput {
+  // The part of the frame that was encoded: the crop's rect, clipped.
+  PixelRect rect;
+  // Size of the encoded image; smaller than |rect| when it was scaled.
+  int width = 0;
+  int height = 0;
+  // Row size of the (decompressed) pixels for raw and LZ4 output; 0 for
+  // image formats.
+  size_t stride = 0;
+  std::vector<uint8_t> bytes;
+};
+
+struct BatchEncoderOptions {
+  // Crops encoded at once; 0 uses every core.
+  int threads = 0;
+};
+
+// Encodes many rectangles of one captured frame concurrently.
+//
+// Crops are views into the frame, never copies. They are handed out
+// largest first to lanes of a thread pool kept between calls, each lane
+// with an EncoderSession and ImageResizer of its own, so a batch of
+// element screenshots costs one capture plus about its largest crop's
+// encode per core. A lone crop is banded over every core instead, as a
+// plain capture would be. Not thread-safe.
+class BatchEncoder {
+ public:
+  explicit BatchEncoder(
+      const BatchEncoderOptions& options = BatchEncoderOptions());
+
+  BatchEncoder(const BatchEncoder&) = delete;
+  BatchEncoder& operator=(const BatchEncoder&) = delete;
+
+  // Scales and encodes each of |crops| of |frame| into |outputs|,
+  // outputs[i] for crops[i]. Returns false, leaving |outputs| empty, if
+  // |frame| is invalid, a crop is off the frame or one fails to encode.
+  bool Encode(const ImageView& frame, const std::vector<BatchCrop>& crops,
+              std::vector<BatchOutput>* outputs);
+
+ private:
+  // What one lane reuses from crop to crop.
+  struct Lane {
+    EncoderSession session;
+    ImageResizer resizer;
+  };
+
+  // Scales and encodes |view| as |crop| asks, on |lane|. |alone| lets the
+  // resizer and encoder use every core.
+  static bool EncodeCrop(Lane* lane, const ImageView& view,
+                         const BatchCrop& crop, bool alone,
+                         BatchOutput* output);
+
+  BatchEncoderOptions options_;
+  std::vector<std::unique_ptr<Lane>> lanes_;
+  std::unique_ptr<ThreadPool> pool_;
+  std::vector<ImageView> views_;
+  // Crop indices, largest first.
+  std::vector<size_t> order_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_BATCH_ENCODER_H_
@@ -0,0 +1,94 @@
+// Element screenshots from one frame, one by one against batched:
+//
+//   ./screenshot_core_bench --benchmark_filter=Batch
+//
+// Each iteration encodes 16 element-sized rectangles (buttons, fields and a
+// couple of panels) of a 1080p synthetic desktop as PNG. "Sequential" runs
+// them through one EncoderSession, each banded over every core, as repeated
+// capture calls do after the grab; "BatchEncoder" hands whole crops to
+// lanes with the given threads (0 uses every core). Neither includes the
+// grab, which captureBatch does once instead of 16 times.
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "batch_encoder.h"
+#include "bench/bench_frames.h"
+#include "encoder_session.h"
+#include "image.h"
+#include "image_rect.h"
+
+namespace screenshot {
+namespace {
+
+constexpr int kWidth = 1920;
+constexpr int kHeight = 1080;
+
+std::vector<BatchCrop> ElementCrops() {
+  std::vector<BatchCrop> crops;
+  for (int i = 0; i < 16; ++i) {
+    BatchCrop crop;
+    crop.settings.format = CaptureFormat::kPng;
+    if (i < 2) {
+      crop.rect = PixelRect{i * 900 + 40, 120, 800, 600};
+    } else if (i < 8) {
+      crop.rect = PixelRect{(i - 2) * 300 + 20, 760, 280, 40};
+    } else {
+      crop.rect = PixelRect{(i - 8) * 220 + 30, 880, 160, 48};
+    }
+    crops.push_back(crop);
+  }
+  return crops;
+}
+
+void BM_BatchSequential(benchmark::State& state) {
+  const std::vector<uint8_t> pixels = bench::SyntheticDesktop(kWidth, kHeight);
+  const ImageView frame{pixels.data(), kWidth, kHeight,
+                        static_cast<size_t>(kWidth) * kBytesPerPixel,
+                        PixelFormat::kBgra8};
+  const std::vector<BatchCrop> crops = ElementCrops();
+  EncoderSession session;
+  for (auto _ : state) {
+    for (const BatchCrop& crop : crops) {
+      ImageView view;
+      if (!CropImage(frame, crop.rect, &view) ||
+          !session.Encode(view, crop.settings)) {
+        state.SkipWithError("encode failed");
+        return;
+      }
+      benchmark::DoNotOptimize(session.data());
+    }
+  }
+}
+
+// Args: threads.
+void BM_BatchEncoder(benchmark::State& state) {
+  const std::vector<uint8_t> pixels = bench::SyntheticDesktop(kWidth, kHeight);
+  const ImageView frame{pixels.data(), kWidth, kHeight,
+                        static_cast<size_t>(kWidth) * kBytesPerPixel,
+                        PixelFormat::kBgra8};
+  const std::vector<BatchCrop> crops = ElementCrops();
+  BatchEncoderOptions options;
+  options.threads = static_cast<int>(state.range(0));
+  BatchEncoder encoder(options);
+  std::vector<BatchOutput> outputs;
+  for (auto _ : state) {
+    if (!encoder.Encode(frame, crops, &outputs)) {
+      state.SkipWithError("encode failed");
+      break;
+    }
+    benchmark::DoNotOptimize(outputs.data());
+  }
+}
+
+BENCHMARK(BM_BatchSequential)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_BatchEncoder)
+    ->ArgName("threads")
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace screenshot
@@ -0,0 +1,129 @@
+#include "bench/bench_frames.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <utility>
+
+namespace screenshot {
+namespace bench {
+
+namespace {
+
+// Reads a whitespace-separated header integer, skipping '#' comments.
+bool ReadPpmInt(std::FILE* file, int* value) {
+  int c = std::fgetc(file);
+  for (;;) {
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      c = std::fgetc(file);
+    }
+    if (c != '#') break;
+    while (c != '\n' && c != EOF) c = std::fgetc(file);
+  }
+  if (c < '0' || c > '9') return false;
+  *value = 0;
+  while (c >= '0' && c <= '9') {
+    *value = *value * 10 + (c - '0');
+    c = std::fgetc(file);
+  }
+  // c is the single whitespace byte that ends the header field.
+  return true;
+}
+
+bool LoadPpm(const std::filesystem::path& path, BenchFrame* frame) {
+  std::FILE* file = std::fopen(path.string().c_str(), "rb");
+  if (!file) return false;
+  int maxval = 0;
+  const bool ok = std::fgetc(file) == 'P' && std::fgetc(file) == '6' &&
+                  ReadPpmInt(file, &frame->width) &&
+                  ReadPpmInt(file, &frame->height) &&
+                  ReadPpmInt(file, &maxval) && maxval == 255 &&
+                  frame->width > 0 && frame->height > 0;
+  if (ok) {
+    const size_t pixels = static_cast<size_t>(frame->width) *
+                          static_cast<size_t>(frame->height);
+    std::vector<uint8_t> rgb(pixels * 3);
+    if (std::fread(rgb.data(), 1, rgb.size(), file) == rgb.size()) {
+      frame->bgra.resize(pixels * 4);
+      for (size_t i = 0; i < pixels; ++i) {
+        frame->bgra[i * 4 + 0] = rgb[i * 3 + 2];
+        frame->bgra[i * 4 + 1] = rgb[i * 3 + 1];
+        frame->bgra[i * 4 + 2] = rgb[i * 3 + 0];
+        frame->bgra[i * 4 + 3] = 0xFF;
+      }
+      frame->name = path.stem().string();
+    }
+  }
+  std::fclose(file);
+  return !frame->bgra.empty();
+}
+
+std::vector<BenchFrame> LoadFrames() {
+  std::vector<BenchFrame> frames;
+  if (const char* dir = std::getenv("SCREENSHOT_BENCH_CORPUS")) {
+    std::error_code error;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(dir, error)) {
+      if (entry.path().extension() != ".ppm") continue;
+      BenchFrame frame;
+      if (LoadPpm(entry.path(), &frame)) frames.push_back(std::move(frame));
+    }
+    if (frames.empty()) {
+      std::fprintf(stderr, "No P6 .ppm files in %s; using synthetic frames\n",
+                   dir);
+    }
+  }
+  if (frames.empty()) {
+    for (const auto& size : {std::pair<int, int>{1920, 1080},
+                             std::pair<int, int>{3840, 2160}}) {
+      BenchFrame frame;
+      frame.name = "synthetic_" + std::to_string(size.second) + "p";
+      frame.width = size.first;
+      frame.height = size.second;
+      frame.bgra = SyntheticDesktop(size.first, size.second);
+      frames.push_back(std::move(frame));
+    }
+  }
+  return frames;
+}
+
+}  // namespace
+
+std::vector<uint8_t> SyntheticDesktop(int width, int height) {
+  std::mt19937 rng(1);
+  const size_t stride = static_cast<size_t>(width) * 4;
+  std::vector<uint8_t> pixels(stride * static_cast<size_t>(height));
+  for (int y = 0; y < height; ++y) {
+    uint8_t* row = pixels.data() + static_cast<size_t>(y) * stride;
+    for (int x = 0; x < width; ++x) {
+      uint8_t* p = row + static_cast<size_t>(x) * 4;
+      if (y % 540 < 32) {
+        p[0] = 0x30; p[1] = 0x30; p[2] = 0x30;
+      } else if (x < width / 6) {
+        p[0] = static_cast<uint8_t>(x * 255 / (width / 6));
+        p[1] = static_cast<uint8_t>(y * 255 / height);
+        p[2] = 0x80;
+      } else if (x > width * 2 / 3 && y > height / 2) {
+        const int r = static_cast<int>(rng() & 0xFFF);
+        p[0] = static_cast<uint8_t>(x + (r & 15));
+        p[1] = static_cast<uint8_t>(y + ((r >> 4) & 15));
+        p[2] = static_cast<uint8_t>((x ^ y) + (r >> 8));
+      } else {
+        const bool ink = (rng() % 9) == 0 && (y % 18) < 12;
+        p[0] = p[1] = p[2] = ink ? 0x20 : 0xF4;
+      }
+      p[3] = 0xFF;
+    }
+  }
+  return pixels;
+}
+
+const std::vector<BenchFrame>& CorpusFrames() {
+  static const std::vector<BenchFrame> frames = LoadFrames();
+  return frames;
+}
+
+}  // namespace bench
+}  // namespace screenshot
@@ -0,0 +1,39 @@
+#ifndef SCREENSHOT_CORE_BENCH_BENCH_FRAMES_H_
+#define SCREENSHOT_CORE_BENCH_BENCH_FRAMES_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "image.h"
+
+namespace screenshot {
+namespace bench {
+
+// A packed BGRA frame to benchmark against.
+struct BenchFrame {
+  std::string name;
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> bgra;
+
+  ImageView View() const {
+    return ImageView{bgra.data(), width, height,
+                     static_cast<size_t>(width) * kBytesPerPixel,
+                     PixelFormat::kBgra8};
+  }
+};
+
+// BGRA desktop-like frame: title bars, flat panels with text-like noise, a
+// gradient sidebar and a photo-like region.
+std::vector<uint8_t> SyntheticDesktop(int width, int height);
+
+// Frames for codec benchmarks. If SCREENSHOT_BENCH_CORPUS names a directory,
+// every binary PPM (P6) file in it is loaded, so real desktop screenshots can
+// be measured; otherwise synthetic desktops at 1080p and 4K are used.
+const std::vector<BenchFrame>& CorpusFrames();
+
+}  // namespace bench
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_BENCH_BENCH_FRAMES_H_
@@ -0,0 +1,111 @@
+// What the per-stage capture statistics cost:
+//
+//   ./screenshot_core_bench --benchmark_filter=Stats
+//
+// "Clock" is one MonotonicNanos() read, of which a capture makes about two
+// per stage. "Record" adds one sample to a LatencyHistogram, from 1 and 4
+// threads at once (contended), and "RecordSample" a capture's worth: every
+// stage, plus its byte counts. "Capture" captures a synthetic 1080p frame
+// into a pooled buffer without and with the plugin's instrumentation
+// (instrumented:1 times each step and records the sample); the difference
+// is the overhead per capture, which should be lost in the noise of a
+// capture that takes milliseconds.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "capture_source.h"
+#include "capture_stats.h"
+#include "frame_pool.h"
+#include "synthetic_screen.h"
+
+namespace screenshot {
+namespace {
+
+void BM_StatsClock(benchmark::State& state) {
+  for (auto _ : state) benchmark::DoNotOptimize(MonotonicNanos());
+}
+
+// Shared by every thread of BM_StatsRecord.
+LatencyHistogram* g_histogram = nullptr;
+
+void BM_StatsRecord(benchmark::State& state) {
+  if (state.thread_index() == 0) g_histogram = new LatencyHistogram();
+  int64_t nanos = 1000000;
+  for (auto _ : state) {
+    g_histogram->Record(nanos);
+    // Spread the samples over a few dozen buckets, as real latencies are.
+    nanos = (nanos * 33) % 20000000 + 1000000;
+  }
+  if (state.thread_index() == 0) {
+    benchmark::DoNotOptimize(g_histogram->Summarize());
+    delete g_histogram;
+    g_histogram = nullptr;
+  }
+}
+
+void BM_StatsRecordSample(benchmark::State& state) {
+  CaptureStats stats;
+  CaptureSample sample;
+  for (size_t i = 0; i < kCaptureStageCount; ++i) {
+    sample.nanos[i] = static_cast<int64_t>(i + 1) * 1000000;
+  }
+  sample.captured_bytes = 1920 * 1080 * 4;
+  sample.output_bytes = 300000;
+  for (auto _ : state) {
+    stats.Record(sample);
+    ++sample.nanos[0];
+  }
+}
+
+void BM_StatsSnapshot(benchmark::State& state) {
+  CaptureStats stats;
+  CaptureSample sample;
+  sample.Set(CaptureStage::kCapture, 3000000);
+  for (int i = 0; i < 1000; ++i) stats.Record(sample);
+  for (auto _ : state) benchmark::DoNotOptimize(stats.Snapshot());
+}
+
+// Args: instrumented (0 or 1).
+void BM_StatsCapture(benchmark::State& state) {
+  const bool instrumented = state.range(0) != 0;
+  SyntheticScreen screen;
+  FramePool pool;
+  CaptureStats stats;
+  const PixelRect bounds = screen.Bounds();
+  for (auto _ : state) {
+    if (!instrumented) {
+      FramePool::Lease frame = CaptureToPool(&screen, &pool, bounds, true);
+      benchmark::DoNotOptimize(frame->data());
+      continue;
+    }
+    // As the plugin's capture jobs do.
+    CaptureSample sample;
+    const int64_t start = MonotonicNanos();
+    FramePool::Lease frame = CaptureToPool(&screen, &pool, bounds, true);
+    const int64_t captured = MonotonicNanos();
+    const int64_t cursor = screen.cursor_nanos();
+    sample.Set(CaptureStage::kCapture,
+               captured - start - (cursor > 0 ? cursor : 0));
+    sample.Set(CaptureStage::kCursor, cursor);
+    sample.captured_bytes = frame->size();
+    benchmark::DoNotOptimize(frame->data());
+    sample.Set(CaptureStage::kTotal, MonotonicNanos() - start);
+    stats.Record(sample);
+  }
+}
+
+BENCHMARK(BM_StatsClock);
+BENCHMARK(BM_StatsRecord)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(BM_StatsRecordSample);
+BENCHMARK(BM_StatsSnapshot)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StatsCapture)
+    ->ArgName("instrumented")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace screenshot
@@ -0,0 +1,111 @@
+// Codec comparison on desktop frames:
+//
+//   export SCREENSHOT_BENCH_CORPUS=/path/to/ppm/dir  # optional
+//   ./screenshot_core_bench --benchmark_filter=Codec
+//
+// bytes_per_second is encode throughput over the source pixels; "ratio" is
+// the encoded size as a fraction of the raw BGRA size. Lossy codecs are
+// listed by quality; see the JPEG encoder tests for PSNR/SSIM at each.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench/bench_frames.h"
+#include "jpeg_encoder.h"
+#include "lz4_frame_encoder.h"
+#include "png_encoder.h"
+#include "qoi_encoder.h"
+
+namespace screenshot {
+namespace {
+
+// Runs |encoder| (any of the core encoders) over |frame|.
+template <typename Encoder>
+void RunEncoder(benchmark::State& state, Encoder* encoder,
+                const bench::BenchFrame& frame) {
+  const ImageView image = frame.View();
+  std::vector<uint8_t> out(Encoder::MaxEncodedSize(frame.width, frame.height));
+  size_t size = 0;
+  for (auto _ : state) {
+    size = encoder->Encode(image, out.data(), out.size());
+    benchmark::DoNotOptimize(size);
+  }
+  if (size == 0) state.SkipWithError("encode failed");
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(frame.bgra.size()));
+  state.counters["ratio"] =
+      static_cast<double>(size) / static_cast<double>(frame.bgra.size());
+}
+
+void BM_CodecPng(benchmark::State& state, const bench::BenchFrame* frame) {
+  PngEncodeOptions options;
+  options.force_opaque = true;
+  options.level = static_cast<int>(state.range(0));
+  PngEncoder encoder(options);
+  RunEncoder(state, &encoder, *frame);
+}
+
+void BM_CodecQoi(benchmark::State& state, const bench::BenchFrame* frame) {
+  QoiEncodeOptions options;
+  options.force_opaque = true;
+  QoiEncoder encoder(options);
+  RunEncoder(state, &encoder, *frame);
+}
+
+void BM_CodecLz4(benchmark::State& state, const bench::BenchFrame* frame) {
+  Lz4FrameEncodeOptions options;
+  options.force_opaque = true;
+  options.threads = static_cast<int>(state.range(0));
+  Lz4FrameEncoder encoder(options);
+  RunEncoder(state, &encoder, *frame);
+}
+
+// range(0) is quality, range(1) the ChromaSubsampling value.
+void BM_CodecJpeg(benchmark::State& state, const bench::BenchFrame* frame) {
+  JpegEncodeOptions options;
+  options.quality = static_cast<int>(state.range(0));
+  options.subsampling = static_cast<ChromaSubsampling>(state.range(1));
+  options.threads = static_cast<int>(state.range(2));
+  JpegEncoder encoder(options);
+  RunEncoder(state, &encoder, *frame);
+}
+
+bool RegisterCodecBenchmarks() {
+  for (const bench::BenchFrame& frame : bench::CorpusFrames()) {
+    benchmark::RegisterBenchmark(("BM_CodecPng/" + frame.name).c_str(),
+                                 BM_CodecPng, &frame)
+        ->ArgName("level")
+        ->Arg(1)
+        ->Arg(3)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("BM_CodecQoi/" + frame.name).c_str(),
+                                 BM_CodecQoi, &frame)
+        ->Unit(benchmark::kMillisecond);
+    // threads:0 uses every core.
+    benchmark::RegisterBenchmark(("BM_CodecLz4/" + frame.name).c_str(),
+                                 BM_CodecLz4, &frame)
+        ->ArgName("threads")
+        ->Arg(1)
+        ->Arg(0)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+    benchmark::RegisterBenchmark(("BM_CodecJpeg/" + frame.name).c_str(),
+                                 BM_CodecJpeg, &frame)
+        ->ArgNames({"quality", "subsampling", "threads"})
+        ->Args({75, static_cast<int>(ChromaSubsampling::k420), 1})
+        ->Args({90, static_cast<int>(ChromaSubsampling::k420), 1})
+        ->Args({90, static_cast<int>(ChromaSubsampling::k444), 1})
+        ->Args({90, static_cast<int>(ChromaSubsampling::k420), 0})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+  return true;
+}
+
+const bool registered = RegisterCodecBenchmarks();
+
+}  // namespace
+}  // namespace screenshot
@@ -0,0 +1,105 @@
+// Cursor compositing, scalar against SIMD:
+//
+//   ./screenshot_core_bench --benchmark_filter=Cursor
+//
+// "Composite" blends a cursor of the given size onto a 1080p frame at a
+// different place each iteration, with the kernels limited to scalar
+// (simd:0), SSE2 (simd:1) or everything the host has (simd:2); "xor" adds
+// an inverting XOR mask, as the I-beam has. "Decode" builds the cursor from
+// its color bitmap and mask, the work CursorCache saves on every capture
+// after the cursor's first.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "cpu_features.h"
+#include "cursor_compositor.h"
+#include "image.h"
+
+namespace screenshot {
+namespace {
+
+constexpr int kWidth = 1920;
+constexpr int kHeight = 1080;
+
+// A white arrow with a black outline, straight alpha, in the top left of a
+// |size| x |size| image, as GetDIBits returns a cursor's color bitmap.
+std::vector<uint8_t> ArrowBitmap(int size) {
+  std::vector<uint8_t> bgra(static_cast<size_t>(size) *
+                            static_cast<size_t>(size) * kBytesPerPixel);
+  const int scale = size / 32;
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      const int cx = x / scale;
+      const int cy = y / scale;
+      if (cy >= 24 || cx > cy / 2 + 1) continue;
+      uint8_t* p = bgra.data() + static_cast<size_t>(y * size + x) * 4;
+      const bool outline = cx == 0 || cx == cy / 2 + 1 || cy == 23;
+      p[0] = p[1] = p[2] = outline ? 0 : 0xFF;
+      p[3] = 0xFF;
+    }
+  }
+  return bgra;
+}
+
+void LimitKernels(int simd) {
+  CpuFeatures features;
+  if (simd == 1) features.sse2 = GetCpuFeatures().sse2;
+  if (simd == 2) features = GetCpuFeatures();
+  OverrideCpuFeaturesForTesting(&features);
+}
+
+// Args: cursor size, simd (0 scalar, 1 SSE2, 2 host), xor (0 or 1).
+void BM_CursorComposite(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  CursorImage cursor;
+  const std::vector<uint8_t> bitmap = ArrowBitmap(size);
+  DecodeColorCursor(bitmap.data(), nullptr, size, size, &cursor);
+  if (state.range(2) != 0) {
+    cursor.xor_mask.assign(cursor.pixels.size(), 0);
+    for (size_t i = 0; i < cursor.xor_mask.size(); i += 4 * 3) {
+      cursor.xor_mask[i] = cursor.xor_mask[i + 1] = cursor.xor_mask[i + 2] =
+          0xFF;
+    }
+  }
+  const size_t stride = static_cast<size_t>(kWidth) * kBytesPerPixel;
+  std::vector<uint8_t> frame(stride * kHeight, 0x80);
+  LimitKernels(static_cast<int>(state.range(1)));
+  uint64_t i = 0;
+  for (auto _ : state) {
+    const int x =
+        static_cast<int>((i * 37) % static_cast<uint64_t>(kWidth - size));
+    const int y =
+        static_cast<int>((i * 23) % static_cast<uint64_t>(kHeight - size));
+    CompositeCursor(cursor, x, y, frame.data(), kWidth, kHeight, stride);
+    ++i;
+    benchmark::DoNotOptimize(frame.data());
+  }
+  OverrideCpuFeaturesForTesting(nullptr);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// Args: cursor size.
+void BM_CursorDecode(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  const std::vector<uint8_t> bitmap = ArrowBitmap(size);
+  const std::vector<uint8_t> mask(CursorMaskStride(size) *
+                                  static_cast<size_t>(size));
+  CursorImage cursor;
+  for (auto _ : state) {
+    DecodeColorCursor(bitmap.data(), mask.data(), size, size, &cursor);
+    benchmark::DoNotOptimize(cursor.pixels.data());
+  }
+}
+
+BENCHMARK(BM_CursorComposite)
+    ->ArgNames({"size", "simd", "xor"})
+    ->ArgsProduct({{32, 64, 128}, {0, 1, 2}, {0}})
+    ->Args({32, 0, 1})
+    ->Args({32, 2, 1});
+BENCHMARK(BM_CursorDecode)->ArgName("size")->Arg(32)->Arg(64)->Arg(128);
+
+}  // namespace
+}  // namespace screenshot
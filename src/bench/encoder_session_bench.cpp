@@ -0,0 +1,110 @@
+// Per-capture encoder setup cost:
+//
+//   ./screenshot_core_bench --benchmark_filter=EncoderSession
+//
+// "fresh" constructs the encoder and output vector for every frame, as the
+// plugin used to; "session" reuses one EncoderSession, which keeps the
+// encoders' scratch buffers, worker threads and output buffer. Frames are
+// 1080p synthetic desktops; args are the CaptureFormat and threads (0 uses
+// every core).
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "bench/bench_frames.h"
+#include "encoder_session.h"
+#include "image.h"
+#include "jpeg_encoder.h"
+#include "lz4_frame_encoder.h"
+#include "png_encoder.h"
+
+namespace screenshot {
+namespace {
+
+constexpr int kWidth = 1920;
+constexpr int kHeight = 1080;
+
+EncodeSettings SettingsFor(const benchmark::State& state) {
+  EncodeSettings settings;
+  settings.format = static_cast<CaptureFormat>(state.range(0));
+  settings.threads = static_cast<int>(state.range(1));
+  return settings;
+}
+
+// Encodes with encoders built from scratch, like a per-capture code path.
+bool EncodeFresh(const ImageView& image, const EncodeSettings& settings,
+                 std::vector<uint8_t>* out) {
+  switch (settings.format) {
+    case CaptureFormat::kLz4Bgra: {
+      Lz4FrameEncodeOptions options;
+      options.force_opaque = true;
+      options.threads = settings.threads;
+      return Lz4FrameEncoder(options).Encode(image, out);
+    }
+    case CaptureFormat::kJpeg: {
+      JpegEncodeOptions options;
+      options.quality = settings.quality;
+      options.threads = settings.threads;
+      return JpegEncoder(options).Encode(image, out);
+    }
+    case CaptureFormat::kPng:
+    default: {
+      PngEncodeOptions options;
+      options.force_opaque = true;
+      options.threads = settings.threads;
+      return PngEncoder(options).Encode(image, out);
+    }
+  }
+}
+
+void BM_EncoderSessionFresh(benchmark::State& state) {
+  const std::vector<uint8_t> pixels = bench::SyntheticDesktop(kWidth, kHeight);
+  const ImageView image{pixels.data(), kWidth, kHeight,
+                        static_cast<size_t>(kWidth) * kBytesPerPixel,
+                        PixelFormat::kBgra8};
+  const EncodeSettings settings = SettingsFor(state);
+  for (auto _ : state) {
+    std::vector<uint8_t> out;
+    if (!EncodeFresh(image, settings, &out)) {
+      state.SkipWithError("encode failed");
+      break;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+
+void BM_EncoderSession(benchmark::State& state) {
+  const std::vector<uint8_t> pixels = bench::SyntheticDesktop(kWidth, kHeight);
+  const ImageView image{pixels.data(), kWidth, kHeight,
+                        static_cast<size_t>(kWidth) * kBytesPerPixel,
+                        PixelFormat::kBgra8};
+  const EncodeSettings settings = SettingsFor(state);
+  EncoderSession session;
+  for (auto _ : state) {
+    if (!session.Encode(image, settings)) {
+      state.SkipWithError("encode failed");
+      break;
+    }
+    benchmark::DoNotOptimize(session.data());
+  }
+}
+
+void Formats(benchmark::internal::Benchmark* b) {
+  for (CaptureFormat format :
+       {CaptureFormat::kPng, CaptureFormat::kLz4Bgra, CaptureFormat::kJpeg}) {
+    for (int threads : {1, 0}) {
+      b->Args({static_cast<int>(format), threads});
+    }
+  }
+  b->ArgNames({"format", "threads"});
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+BENCHMARK(BM_EncoderSessionFresh)->Apply(Formats);
+BENCHMARK(BM_EncoderSession)->Apply(Formats);
+
+}  // namespace
+}  // namespace screenshot
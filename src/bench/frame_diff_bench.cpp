@@ -0,0 +1,121 @@
+// Dirty-tile detection on synthetic frame sequences:
+//
+//   ./screenshot_core_bench --benchmark_filter=FrameDiff
+//
+// Each iteration diffs the next frame of a sequence against the previous
+// one. "static" never changes, "typing" touches a few small spots per frame
+// (a caret and a line of text), "scroll" moves a ~5% strip, and "full"
+// changes every pixel. bytes_per_second is over the source pixels; "tiles"
+// is the mean number of changed tiles per frame.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bench/bench_frames.h"
+#include "frame_diff.h"
+#include "image.h"
+
+namespace screenshot {
+namespace {
+
+enum Sequence { kStatic, kTyping, kScroll, kFull };
+
+constexpr int kSequenceLength = 8;
+constexpr int kSize1080p[] = {1920, 1080};
+constexpr int kSize4k[] = {3840, 2160};
+
+// Frames of |sequence|, packed BGRA.
+std::vector<std::vector<uint8_t>> MakeSequence(int width, int height,
+                                               Sequence sequence) {
+  const std::vector<uint8_t> base = bench::SyntheticDesktop(width, height);
+  const size_t stride = static_cast<size_t>(width) * 4;
+  std::vector<std::vector<uint8_t>> frames(kSequenceLength, base);
+  for (int f = 0; f < kSequenceLength; ++f) {
+    std::vector<uint8_t>& frame = frames[static_cast<size_t>(f)];
+    switch (sequence) {
+      case kStatic:
+        break;
+      case kTyping: {
+        // A 2x20 caret and a 12x20 glyph advancing along a line.
+        const int x = 200 + f * 12;
+        for (int y = 300; y < 320; ++y) {
+          uint8_t* row = frame.data() + static_cast<size_t>(y) * stride;
+          std::memset(row + static_cast<size_t>(x + 12) * 4, f & 1 ? 0 : 255,
+                      2 * 4);
+          for (int i = 0; i < 12 * 4; ++i) {
+            row[static_cast<size_t>(x) * 4 + static_cast<size_t>(i)] ^=
+                static_cast<uint8_t>(i * 7 + y);
+          }
+        }
+        break;
+      }
+      case kScroll: {
+        // Content of a panel shifted up by f * 3 rows.
+        const int top = height / 2;
+        const int rows = height / 20;
+        for (int y = top; y < top + rows; ++y) {
+          std::memcpy(frame.data() + static_cast<size_t>(y) * stride,
+                      base.data() + static_cast<size_t>(y + f * 3) * stride,
+                      stride);
+        }
+        break;
+      }
+      case kFull:
+        for (size_t i = 0; i < frame.size(); ++i) {
+          frame[i] = static_cast<uint8_t>(frame[i] + f + 1);
+        }
+        break;
+    }
+  }
+  return frames;
+}
+
+// Args: width, height, Sequence, threads.
+void BM_FrameDiff(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  const std::vector<std::vector<uint8_t>> frames =
+      MakeSequence(width, height, static_cast<Sequence>(state.range(2)));
+  FrameDiffOptions options;
+  options.threads = static_cast<int>(state.range(3));
+  FrameDiffer differ(options);
+  FrameDiff diff;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  differ.Diff(ImageView{frames.back().data(), width, height, stride,
+                        PixelFormat::kBgra8},
+              false, &diff);
+  size_t index = 0;
+  size_t tiles = 0;
+  for (auto _ : state) {
+    const ImageView frame{frames[index].data(), width, height, stride,
+                          PixelFormat::kBgra8};
+    differ.Diff(frame, false, &diff);
+    tiles += diff.tiles.size();
+    index = (index + 1) % frames.size();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(stride) * height);
+  state.counters["tiles"] = benchmark::Counter(
+      static_cast<double>(tiles), benchmark::Counter::kAvgIterations);
+}
+
+void Sequences(benchmark::internal::Benchmark* b) {
+  for (const int* size : {kSize1080p, kSize4k}) {
+    for (int sequence : {kStatic, kTyping, kScroll, kFull}) {
+      for (int threads : {1, 4}) {
+        b->Args({size[0], size[1], sequence, threads});
+      }
+    }
+  }
+  b->ArgNames({"width", "height", "sequence", "threads"});
+  b->Unit(benchmark::kMicrosecond);
+  b->UseRealTime();
+}
+
+BENCHMARK(BM_FrameDiff)->Apply(Sequences);
+
+}  // namespace
+}  // namespace screenshot
@@ -0,0 +1,126 @@
+// Cost of turning a captured frame into the bytes handed to the Flutter
+// engine:
+//
+//   ./screenshot_core_bench --benchmark_filter=CaptureResponse
+//
+// "map" is the method channel path: the frame is encoded into a bytes
+// vector, wrapped in the {width, height, stride, pixelFormat, bytes} map
+// and serialized by StandardMethodCodec (reproduced by
+// bench::SerializeCaptureMap, since the codec is not available off
+// Windows). "binary" is EncodeFrameMessage, whose
+// output is sent as is on the frame channel. Both include encoding, so the
+// difference is the transport. "copied" is the payload bytes copied after
+// the encoder or pixel conversion wrote them; the engine's own copy of the
+// reply is the same for both and not counted.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench/bench_frames.h"
+#include "bench/method_codec.h"
+#include "encoder_session.h"
+#include "frame_message.h"
+#include "image.h"
+#include "pixel_convert.h"
+
+namespace screenshot {
+namespace {
+
+enum Transport { kMap, kBinary };
+
+constexpr int kSize1080p[] = {1920, 1080};
+constexpr int kSize4k[] = {3840, 2160};
+
+// What the plugin's map path does: raw formats are converted into a bytes
+// vector, others are encoded and copied out of the session.
+bool EncodeToMap(EncoderSession* session, const ImageView& image,
+                 const EncodeSettings& settings, std::vector<uint8_t>* out,
+                 size_t* copied) {
+  std::vector<uint8_t> bytes;
+  size_t stride = 0;
+  *copied = 0;
+  if (settings.format == CaptureFormat::kRawBgra) {
+    stride = image.RowBytes();
+    bytes.resize(stride * static_cast<size_t>(image.height));
+    if (!ConvertImage(image, PixelFormat::kBgra8, true, bytes.data(),
+                      stride)) {
+      return false;
+    }
+  } else {
+    if (!session->Encode(image, settings)) return false;
+    bytes.assign(session->data(), session->data() + session->size());
+    stride = session->stride();
+    *copied += bytes.size();
+  }
+  const char* name = settings.format == CaptureFormat::kRawBgra ? "raw_bgra"
+                     : settings.format == CaptureFormat::kLz4Bgra ? "lz4_bgra"
+                                                                  : "png";
+  bench::SerializeCaptureMap(image.width, image.height, stride, name, bytes,
+                             out);
+  *copied += bytes.size();
+  return true;
+}
+
+// Args: width, height, CaptureFormat, Transport.
+void BM_CaptureResponse(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  const std::vector<uint8_t> frame = bench::SyntheticDesktop(width, height);
+  const ImageView image{frame.data(), width, height,
+                        static_cast<size_t>(width) * kBytesPerPixel,
+                        PixelFormat::kBgra8};
+  EncodeSettings settings;
+  settings.format = static_cast<CaptureFormat>(state.range(2));
+  const Transport transport = static_cast<Transport>(state.range(3));
+  EncoderSession session;
+  size_t copied = 0;
+  size_t message_size = 0;
+  uint64_t sequence = 0;
+  for (auto _ : state) {
+    // A fresh vector each time, as each reply owns its buffer.
+    std::vector<uint8_t> message;
+    size_t message_copied = 0;
+    const bool ok =
+        transport == kMap
+            ? EncodeToMap(&session, image, settings, &message, &message_copied)
+            : EncodeFrameMessage(&session, image, settings, sequence++, 0,
+                                 &message);
+    if (!ok) {
+      state.SkipWithError("encode failed");
+      return;
+    }
+    if (transport == kBinary &&
+        settings.format != CaptureFormat::kRawBgra) {
+      message_copied = message.size() - kFrameMessageHeaderSize;
+    }
+    copied += message_copied;
+    message_size = message.size();
+    benchmark::DoNotOptimize(message.data());
+  }
+  state.counters["copied"] = benchmark::Counter(
+      static_cast<double>(copied), benchmark::Counter::kAvgIterations);
+  state.counters["message"] = static_cast<double>(message_size);
+}
+
+void Responses(benchmark::internal::Benchmark* b) {
+  for (const int* size : {kSize1080p, kSize4k}) {
+    for (CaptureFormat format : {CaptureFormat::kRawBgra,
+                                 CaptureFormat::kLz4Bgra,
+                                 CaptureFormat::kPng}) {
+      for (int transport : {kMap, kBinary}) {
+        b->Args({size[0], size[1], static_cast<int>(format), transport});
+      }
+    }
+  }
+  b->ArgNames({"width", "height", "format", "transport"});
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+BENCHMARK(BM_CaptureResponse)->Apply(Responses);
+
+}  // namespace
+}  // namespace screenshot
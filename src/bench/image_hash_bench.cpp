@@ -0,0 +1,109 @@
+// Fingerprinting a 4K frame, against encoding it to hash the bytes:
+//
+//   ./screenshot_core_bench --benchmark_filter=Hash
+//
+// "PixelHash" is the exact XxHash3 over the pixels with the given kernels
+// (simd 0 scalar, 1 SSE2, 2 host); "PerceptualHash" is dHash plus pHash,
+// whose cost is the downsample, with the given threads (0 uses every core);
+// "Png" is the PNG encode captureHash replaces. bytes_per_second is over
+// the source pixels.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "bench/bench_frames.h"
+#include "cpu_features.h"
+#include "encoder_session.h"
+#include "image.h"
+#include "image_hash.h"
+
+namespace screenshot {
+namespace {
+
+constexpr int kWidth = 3840;
+constexpr int kHeight = 2160;
+
+ImageView View(const std::vector<uint8_t>& pixels) {
+  return ImageView{pixels.data(), kWidth, kHeight,
+                   static_cast<size_t>(kWidth) * kBytesPerPixel,
+                   PixelFormat::kBgra8};
+}
+
+void SetFrameBytes(benchmark::State& state) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * kWidth *
+                          kHeight * kBytesPerPixel);
+}
+
+// Args: simd (0 scalar, 1 SSE2, 2 host).
+void BM_PixelHash(benchmark::State& state) {
+  const std::vector<uint8_t> pixels = bench::SyntheticDesktop(kWidth, kHeight);
+  CpuFeatures features;
+  if (state.range(0) == 1) features.sse2 = GetCpuFeatures().sse2;
+  if (state.range(0) == 2) features = GetCpuFeatures();
+  OverrideCpuFeaturesForTesting(&features);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(PixelHash(View(pixels)));
+  }
+  OverrideCpuFeaturesForTesting(nullptr);
+  SetFrameBytes(state);
+}
+
+// Args: threads.
+void BM_PerceptualHash(benchmark::State& state) {
+  const std::vector<uint8_t> pixels = bench::SyntheticDesktop(kWidth, kHeight);
+  ImageHashOptions options;
+  options.xxh3 = false;
+  options.threads = static_cast<int>(state.range(0));
+  ImageHasher hasher;
+  ImageHashes hashes;
+  for (auto _ : state) {
+    if (!hasher.Hash(View(pixels), options, &hashes)) {
+      state.SkipWithError("hash failed");
+      break;
+    }
+    benchmark::DoNotOptimize(hashes.phash);
+  }
+  SetFrameBytes(state);
+}
+
+// Args: threads.
+void BM_HashPngBaseline(benchmark::State& state) {
+  const std::vector<uint8_t> pixels = bench::SyntheticDesktop(kWidth, kHeight);
+  EncodeSettings settings;
+  settings.format = CaptureFormat::kPng;
+  settings.threads = static_cast<int>(state.range(0));
+  EncoderSession session;
+  for (auto _ : state) {
+    if (!session.Encode(View(pixels), settings)) {
+      state.SkipWithError("encode failed");
+      break;
+    }
+    benchmark::DoNotOptimize(session.data());
+  }
+  SetFrameBytes(state);
+}
+
+BENCHMARK(BM_PixelHash)
+    ->ArgName("simd")
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_PerceptualHash)
+    ->ArgName("threads")
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_HashPngBaseline)
+    ->ArgName("threads")
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace screenshot
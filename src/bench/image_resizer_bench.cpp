@@ -0,0 +1,68 @@
+// Downscaling a 4K capture before encoding:
+//
+//   ./screenshot_core_bench --benchmark_filter=Resize
+//
+// Each iteration resizes a synthetic 3840x2160 desktop. The targets are the
+// ones captures are usually shrunk to: 1920x1080 (a whole factor of 2, so
+// kAuto takes the box fast path), 256x144 (a factor of 15, also a box) and
+// 1600x900 and 512x288 (fractional factors, where kAuto uses Lanczos-3).
+// bytes_per_second is over the source pixels.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "bench/bench_frames.h"
+#include "image.h"
+#include "image_resizer.h"
+
+namespace screenshot {
+namespace {
+
+constexpr int kSourceWidth = 3840;
+constexpr int kSourceHeight = 2160;
+
+// Args: width, height, ResizeFilter, threads.
+void BM_Resize(benchmark::State& state) {
+  static const std::vector<uint8_t> pixels =
+      bench::SyntheticDesktop(kSourceWidth, kSourceHeight);
+  const size_t stride = static_cast<size_t>(kSourceWidth) * kBytesPerPixel;
+  const ImageView src{pixels.data(), kSourceWidth, kSourceHeight, stride,
+                      PixelFormat::kBgra8};
+  ResizeOptions options;
+  options.filter = static_cast<ResizeFilter>(state.range(2));
+  options.threads = static_cast<int>(state.range(3));
+  ImageResizer resizer(options);
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  for (auto _ : state) {
+    if (!resizer.Resize(src, width, height)) {
+      state.SkipWithError("resize failed");
+      break;
+    }
+    benchmark::DoNotOptimize(resizer.output().data);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(stride) * kSourceHeight);
+}
+
+void Targets(benchmark::internal::Benchmark* b) {
+  const int sizes[][2] = {{1920, 1080}, {256, 144}, {1600, 900}, {512, 288}};
+  for (const int* size : sizes) {
+    for (ResizeFilter filter : {ResizeFilter::kAuto, ResizeFilter::kBilinear,
+                                ResizeFilter::kLanczos3}) {
+      for (int threads : {1, 0}) {
+        b->Args({size[0], size[1], static_cast<int>(filter), threads});
+      }
+    }
+  }
+  b->ArgNames({"width", "height", "filter", "threads"});
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+BENCHMARK(BM_Resize)->Apply(Targets);
+
+}  // namespace
+}  // namespace screenshot
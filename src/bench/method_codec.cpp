@@ -0,0 +1,68 @@
+#include "bench/method_codec.h"
+
+namespace screenshot {
+namespace bench {
+
+namespace {
+
+// StandardMessageCodec type tags.
+constexpr uint8_t kInt32 = 3;
+constexpr uint8_t kString = 7;
+constexpr uint8_t kUint8List = 8;
+constexpr uint8_t kMap = 13;
+
+// StandardMessageCodec size prefix.
+void WriteSize(size_t size, std::vector<uint8_t>* out) {
+  if (size < 254) {
+    out->push_back(static_cast<uint8_t>(size));
+  } else if (size <= 0xFFFF) {
+    out->push_back(254);
+    out->push_back(static_cast<uint8_t>(size));
+    out->push_back(static_cast<uint8_t>(size >> 8));
+  } else {
+    out->push_back(255);
+    for (int i = 0; i < 4; ++i) {
+      out->push_back(static_cast<uint8_t>(size >> (8 * i)));
+    }
+  }
+}
+
+void WriteString(const std::string& value, std::vector<uint8_t>* out) {
+  out->push_back(kString);
+  WriteSize(value.size(), out);
+  out->insert(out->end(), value.begin(), value.end());
+}
+
+void WriteInt(const std::string& key, int32_t value,
+              std::vector<uint8_t>* out) {
+  WriteString(key, out);
+  out->push_back(kInt32);
+  for (int i = 0; i < 4; ++i) {
+    out->push_back(static_cast<uint8_t>(static_cast<uint32_t>(value) >>
+                                        (8 * i)));
+  }
+}
+
+}  // namespace
+
+void SerializeCaptureMap(int width, int height, size_t stride,
+                         const std::string& pixel_format,
+                         const std::vector<uint8_t>& bytes,
+                         std::vector<uint8_t>* out) {
+  out->clear();
+  out->push_back(0);  // success
+  out->push_back(kMap);
+  WriteSize(5, out);
+  WriteInt("width", width, out);
+  WriteInt("height", height, out);
+  WriteInt("stride", static_cast<int32_t>(stride), out);
+  WriteString("pixelFormat", out);
+  WriteString(pixel_format, out);
+  WriteString("bytes", out);
+  out->push_back(kUint8List);
+  WriteSize(bytes.size(), out);
+  out->insert(out->end(), bytes.begin(), bytes.end());
+}
+
+}  // namespace bench
+}  // namespace screenshot
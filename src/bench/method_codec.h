@@ -0,0 +1,25 @@
+#ifndef SCREENSHOT_CORE_BENCH_METHOD_CODEC_H_
+#define SCREENSHOT_CORE_BENCH_METHOD_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace screenshot {
+namespace bench {
+
+// Writes the success envelope Flutter's StandardMethodCodec produces for
+// the "capture" result map {width, height, stride, pixelFormat, bytes} into
+// |out|, so the method channel path can be measured where the codec is
+// not available (off Windows). Byte for byte what the codec writes,
+// including the copy of |bytes|.
+void SerializeCaptureMap(int width, int height, size_t stride,
+                         const std::string& pixel_format,
+                         const std::vector<uint8_t>& bytes,
+                         std::vector<uint8_t>* out);
+
+}  // namespace bench
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_BENCH_METHOD_CODEC_H_
@@ -0,0 +1,61 @@
+// PNG encoder throughput by thread count:
+//
+//   ./screenshot_core_bench --benchmark_filter=PngEncode
+//
+// Reports bytes_per_second over the source pixels and the compressed size as
+// a fraction of the raw RGBA size.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "bench/bench_frames.h"
+#include "image.h"
+#include "png_encoder.h"
+
+namespace screenshot {
+namespace {
+
+// Args: width, height, threads.
+void BM_PngEncode(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  const std::vector<uint8_t> pixels = bench::SyntheticDesktop(width, height);
+  const ImageView image{pixels.data(), width, height,
+                        static_cast<size_t>(width) * 4, PixelFormat::kBgra8};
+
+  PngEncodeOptions options;
+  options.force_opaque = true;
+  options.threads = static_cast<int>(state.range(2));
+  PngEncoder encoder(options);
+  std::vector<uint8_t> out(PngEncoder::MaxEncodedSize(width, height));
+  size_t size = 0;
+  for (auto _ : state) {
+    size = encoder.Encode(image, out.data(), out.size());
+    benchmark::DoNotOptimize(size);
+  }
+  if (size == 0) state.SkipWithError("encode failed");
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(pixels.size()));
+  state.counters["ratio"] =
+      static_cast<double>(size) / static_cast<double>(pixels.size());
+}
+
+void ThreadCounts(benchmark::internal::Benchmark* b) {
+  for (const auto& size : {std::pair<int, int>{3840, 2160},
+                           std::pair<int, int>{7680, 2160}}) {
+    for (int threads : {1, 2, 4, 8, 16}) {
+      b->Args({size.first, size.second, threads});
+    }
+  }
+  b->ArgNames({"width", "height", "threads"});
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+BENCHMARK(BM_PngEncode)->Apply(ThreadCounts);
+
+}  // namespace
+}  // namespace screenshot
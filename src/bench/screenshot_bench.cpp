@@ -0,0 +1,483 @@
+// Where a capture's time goes, stage by stage and end to end:
+//
+//   ./screenshot_bench > run.json
+//   ./screenshot_bench --benchmark_filter=EndToEnd --benchmark_out=run.json
+//
+// A "capture" request goes through five stages, each measured on its own
+// at 1080p, 1440p, 4K and 8K:
+//
+//   Acquire  copy the screen into a pooled frame buffer. Frames come from a
+//            SyntheticScreen, so every host measures the same content at
+//            every size; the Windows build also reads the real screen
+//            through GDI, at the display's size (AcquireGdi).
+//   Cursor   alpha-blend a premultiplied cursor image onto the frame with
+//            the SIMD compositor the plugins use (CompositeCursor).
+//   Convert  BGRA to RGBA, as "raw_rgba" does.
+//   Encode   EncoderSession, per format.
+//   Marshal  copy the payload into the result EncodableMap and serialize it
+//            with StandardMethodCodec ("map"), or build the frame channel
+//            message instead ("binary"). The Windows build uses Flutter's
+//            codec; elsewhere bench::SerializeCaptureMap writes the same
+//            bytes.
+//
+// EndToEnd runs the stages back to back for one request, as the plugin
+// does, and splits its time into acquire_ms, cursor_ms, encode_ms and
+// marshal_ms (encode_ms is the conversion for raw formats).
+//
+// Results are printed as JSON unless --benchmark_format says otherwise, so
+// runs can be compared across releases (e.g. with Google Benchmark's
+// tools/compare.py).
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "bench/method_codec.h"
+#include "capture_source.h"
+#include "cpu_features.h"
+#include "cursor_compositor.h"
+#include "encoder_session.h"
+#include "frame_message.h"
+#include "frame_pool.h"
+#include "image.h"
+#include "image_rect.h"
+#include "pixel_convert.h"
+#include "synthetic_screen.h"
+
+#if SCREENSHOT_BENCH_WITH_PLUGIN
+#include <flutter/encodable_value.h>
+#include <flutter/standard_method_codec.h>
+
+#include "gdi_capture_source.h"
+#endif
+
+namespace screenshot {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum Transport { kMap, kBinary };
+
+constexpr int kSizes[][2] = {{1920, 1080}, {2560, 1440}, {3840, 2160},
+                             {7680, 4320}};
+
+// The cursor is 32x32 at 1080p and grows with the screen, as it does with
+// display scaling.
+int CursorSize(int width, int height) {
+  return 32 * std::max(1, std::min(width / 1920, height / 1080));
+}
+
+// A premultiplied BGRA arrow: white with a black outline, over a
+// translucent drop shadow.
+CursorImage MakeCursor(int size) {
+  CursorImage cursor;
+  cursor.width = size;
+  cursor.height = size;
+  cursor.pixels.resize(static_cast<size_t>(size) * static_cast<size_t>(size) *
+                       kBytesPerPixel);
+  const int scale = size / 32;
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      const int cx = x / scale;
+      const int cy = y / scale;
+      uint8_t* p = cursor.pixels.data() +
+                   (static_cast<size_t>(y * size) + static_cast<size_t>(x)) *
+                       kBytesPerPixel;
+      const bool arrow = cy < 24 && cx <= cy / 2 + 1;
+      const bool outline = arrow && (cx == 0 || cx == cy / 2 + 1 || cy == 23);
+      const bool shadow =
+          !arrow && cy >= 2 && cy < 26 && cx >= 2 && cx <= (cy - 2) / 2 + 3;
+      if (outline) {
+        p[3] = 0xFF;
+      } else if (arrow) {
+        p[0] = p[1] = p[2] = p[3] = 0xFF;
+      } else if (shadow) {
+        p[3] = 0x50;
+      }
+    }
+  }
+  return cursor;
+}
+
+// Where the cursor is on the |i|th frame: moving, so it lands on different
+// content each time.
+int CursorPosition(uint64_t i, int extent, int size) {
+  return static_cast<int>((i * 37) % static_cast<uint64_t>(
+                                         std::max(1, extent - size)));
+}
+
+// The first frame of a SyntheticScreen, packed BGRA.
+std::vector<uint8_t> SyntheticFrame(int width, int height) {
+  SyntheticScreenOptions options;
+  options.width = width;
+  options.height = height;
+  SyntheticScreen screen(options);
+  const size_t stride = static_cast<size_t>(width) * kBytesPerPixel;
+  std::vector<uint8_t> frame(stride * static_cast<size_t>(height));
+  screen.Capture(screen.Bounds(), false, frame.data(), stride);
+  return frame;
+}
+
+// The method channel reply of "capture": |size| payload bytes copied into
+// the result map, which is serialized into |out|.
+void MarshalMap(int width, int height, size_t stride, CaptureFormat format,
+                const uint8_t* payload, size_t size,
+                std::vector<uint8_t>* out) {
+  std::vector<uint8_t> bytes(payload, payload + size);
+#if SCREENSHOT_BENCH_WITH_PLUGIN
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("width")] = flutter::EncodableValue(width);
+  map[flutter::EncodableValue("height")] = flutter::EncodableValue(height);
+  map[flutter::EncodableValue("stride")] =
+      flutter::EncodableValue(static_cast<int>(stride));
+  map[flutter::EncodableValue("pixelFormat")] =
+      flutter::EncodableValue(std::string(CaptureFormatName(format)));
+  map[flutter::EncodableValue("bytes")] =
+      flutter::EncodableValue(std::move(bytes));
+  const flutter::EncodableValue value(std::move(map));
+  *out = std::move(
+      *flutter::StandardMethodCodec::GetInstance().EncodeSuccessEnvelope(
+          &value));
+#else
+  bench::SerializeCaptureMap(width, height, stride, CaptureFormatName(format),
+                             bytes, out);
+#endif
+}
+
+// The frame channel reply: the header, then the payload copied in once.
+void MarshalBinary(int width, int height, size_t stride, CaptureFormat format,
+                   const uint8_t* payload, size_t size,
+                   std::vector<uint8_t>* out) {
+  FrameMessageHeader header;
+  header.format = format;
+  header.width = static_cast<uint32_t>(width);
+  header.height = static_cast<uint32_t>(height);
+  header.stride = static_cast<uint32_t>(stride);
+  std::memcpy(StartFrameMessage(header, size, out), payload, size);
+}
+
+bool IsRaw(CaptureFormat format) {
+  return format == CaptureFormat::kRawBgra ||
+         format == CaptureFormat::kRawRgba;
+}
+
+// Args: width, height.
+void BM_Acquire(benchmark::State& state) {
+  SyntheticScreenOptions options;
+  options.width = static_cast<int>(state.range(0));
+  options.height = static_cast<int>(state.range(1));
+  SyntheticScreen screen(options);
+  const PixelRect bounds = screen.Bounds();
+  FramePool pool;
+  for (auto _ : state) {
+    FramePool::Lease frame = CaptureToPool(&screen, &pool, bounds, false);
+    if (!frame) {
+      state.SkipWithError("capture failed");
+      return;
+    }
+    benchmark::DoNotOptimize(frame->data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          bounds.width * bounds.height * kBytesPerPixel);
+}
+
+#if SCREENSHOT_BENCH_WITH_PLUGIN
+// The primary display through GDI, with and without the cursor (Args).
+void BM_AcquireGdi(benchmark::State& state) {
+  const bool include_cursor = state.range(0) != 0;
+  GdiCaptureSource source;
+  const PixelRect bounds = source.Bounds();
+  FramePool pool;
+  for (auto _ : state) {
+    FramePool::Lease frame =
+        CaptureToPool(&source, &pool, bounds, include_cursor);
+    if (!frame) {
+      state.SkipWithError("capture failed");
+      return;
+    }
+    benchmark::DoNotOptimize(frame->data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          bounds.width * bounds.height * kBytesPerPixel);
+  state.SetLabel(std::to_string(bounds.width) + "x" +
+                 std::to_string(bounds.height));
+}
+#endif
+
+// Args: width, height.
+void BM_Cursor(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  std::vector<uint8_t> frame = SyntheticFrame(width, height);
+  const size_t stride = static_cast<size_t>(width) * kBytesPerPixel;
+  const int size = CursorSize(width, height);
+  const CursorImage cursor = MakeCursor(size);
+  uint64_t i = 0;
+  for (auto _ : state) {
+    CompositeCursor(cursor, CursorPosition(i, width, size),
+                    CursorPosition(i, height, size), frame.data(), width,
+                    height, stride);
+    ++i;
+    benchmark::DoNotOptimize(frame.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// Args: width, height.
+void BM_Convert(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  const std::vector<uint8_t> frame = SyntheticFrame(width, height);
+  const size_t stride = static_cast<size_t>(width) * kBytesPerPixel;
+  const ImageView image{frame.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  std::vector<uint8_t> rgba(frame.size());
+  for (auto _ : state) {
+    ConvertImage(image, PixelFormat::kRgba8, true, rgba.data(), stride);
+    benchmark::DoNotOptimize(rgba.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(frame.size()));
+}
+
+// Args: width, height, CaptureFormat.
+void BM_Encode(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  const std::vector<uint8_t> frame = SyntheticFrame(width, height);
+  const ImageView image{frame.data(), width, height,
+                        static_cast<size_t>(width) * kBytesPerPixel,
+                        PixelFormat::kBgra8};
+  EncodeSettings settings;
+  settings.format = static_cast<CaptureFormat>(state.range(2));
+  EncoderSession session;
+  for (auto _ : state) {
+    if (!session.Encode(image, settings)) {
+      state.SkipWithError("encode failed");
+      return;
+    }
+    benchmark::DoNotOptimize(session.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(frame.size()));
+  state.counters["encoded"] = static_cast<double>(session.size());
+}
+
+// Args: width, height, CaptureFormat of the payload, Transport.
+void BM_Marshal(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  const CaptureFormat format = static_cast<CaptureFormat>(state.range(2));
+  const Transport transport = static_cast<Transport>(state.range(3));
+  const std::vector<uint8_t> frame = SyntheticFrame(width, height);
+  const size_t stride = static_cast<size_t>(width) * kBytesPerPixel;
+  std::vector<uint8_t> payload = frame;
+  size_t payload_stride = stride;
+  if (!IsRaw(format)) {
+    EncodeSettings settings;
+    settings.format = format;
+    EncoderSession session;
+    if (!session.Encode(ImageView{frame.data(), width, height, stride,
+                                  PixelFormat::kBgra8},
+                        settings)) {
+      state.SkipWithError("encode failed");
+      return;
+    }
+    payload.assign(session.data(), session.data() + session.size());
+    payload_stride = session.stride();
+  }
+  size_t message_size = 0;
+  for (auto _ : state) {
+    // A fresh vector each time, as each reply owns its buffer.
+    std::vector<uint8_t> message;
+    if (transport == kMap) {
+      MarshalMap(width, height, payload_stride, format, payload.data(),
+                 payload.size(), &message);
+    } else {
+      MarshalBinary(width, height, payload_stride, format, payload.data(),
+                    payload.size(), &message);
+    }
+    message_size = message.size();
+    benchmark::DoNotOptimize(message.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(payload.size()));
+  state.counters["message"] = static_cast<double>(message_size);
+}
+
+// Args: width, height, CaptureFormat.
+void BM_EndToEnd(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  SyntheticScreenOptions options;
+  options.width = width;
+  options.height = height;
+  SyntheticScreen screen(options);
+  const PixelRect bounds = screen.Bounds();
+  EncodeSettings settings;
+  settings.format = static_cast<CaptureFormat>(state.range(2));
+  const int size = CursorSize(width, height);
+  const CursorImage cursor = MakeCursor(size);
+  FramePool pool;
+  EncoderSession session;
+  std::vector<uint8_t> converted;
+  Clock::duration stages[4] = {};
+  uint64_t i = 0;
+  for (auto _ : state) {
+    const Clock::time_point start = Clock::now();
+    FramePool::Lease frame = CaptureToPool(&screen, &pool, bounds, false);
+    if (!frame) {
+      state.SkipWithError("capture failed");
+      return;
+    }
+    const Clock::time_point acquired = Clock::now();
+    CompositeCursor(cursor, CursorPosition(i, width, size),
+                    CursorPosition(i, height, size), frame->data(), width,
+                    height, frame->stride());
+    ++i;
+    const Clock::time_point composited = Clock::now();
+    const uint8_t* payload = nullptr;
+    size_t payload_size = 0;
+    size_t stride = 0;
+    if (IsRaw(settings.format)) {
+      stride = static_cast<size_t>(width) * kBytesPerPixel;
+      converted.resize(stride * static_cast<size_t>(height));
+      ConvertImage(frame->View(),
+                   settings.format == CaptureFormat::kRawRgba
+                       ? PixelFormat::kRgba8
+                       : PixelFormat::kBgra8,
+                   true, converted.data(), stride);
+      payload = converted.data();
+      payload_size = converted.size();
+    } else {
+      if (!session.Encode(frame->View(), settings)) {
+        state.SkipWithError("encode failed");
+        return;
+      }
+      payload = session.data();
+      payload_size = session.size();
+      stride = session.stride();
+    }
+    const Clock::time_point encoded = Clock::now();
+    std::vector<uint8_t> message;
+    MarshalMap(width, height, stride, settings.format, payload, payload_size,
+               &message);
+    benchmark::DoNotOptimize(message.data());
+    const Clock::time_point marshaled = Clock::now();
+    stages[0] += acquired - start;
+    stages[1] += composited - acquired;
+    stages[2] += encoded - composited;
+    stages[3] += marshaled - encoded;
+  }
+  const char* names[] = {"acquire_ms", "cursor_ms", "encode_ms",
+                         "marshal_ms"};
+  for (int s = 0; s < 4; ++s) {
+    state.counters[names[s]] = benchmark::Counter(
+        std::chrono::duration<double, std::milli>(stages[s]).count(),
+        benchmark::Counter::kAvgIterations);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          width * height * kBytesPerPixel);
+}
+
+void Sizes(benchmark::internal::Benchmark* b) {
+  for (const auto& size : kSizes) b->Args({size[0], size[1]});
+  b->ArgNames({"width", "height"});
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+void Formats(benchmark::internal::Benchmark* b,
+             std::initializer_list<CaptureFormat> formats) {
+  for (const auto& size : kSizes) {
+    for (CaptureFormat format : formats) {
+      b->Args({size[0], size[1], static_cast<int>(format)});
+    }
+  }
+  b->ArgNames({"width", "height", "format"});
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+void EncodeFormats(benchmark::internal::Benchmark* b) {
+  Formats(b, {CaptureFormat::kPng, CaptureFormat::kQoi,
+              CaptureFormat::kLz4Bgra, CaptureFormat::kJpeg});
+}
+
+void EndToEndFormats(benchmark::internal::Benchmark* b) {
+  Formats(b, {CaptureFormat::kPng, CaptureFormat::kJpeg,
+              CaptureFormat::kRawRgba});
+}
+
+void Replies(benchmark::internal::Benchmark* b) {
+  for (const auto& size : kSizes) {
+    for (CaptureFormat format :
+         {CaptureFormat::kRawBgra, CaptureFormat::kPng}) {
+      for (int transport : {kMap, kBinary}) {
+        b->Args({size[0], size[1], static_cast<int>(format), transport});
+      }
+    }
+  }
+  b->ArgNames({"width", "height", "format", "transport"});
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+BENCHMARK(BM_Acquire)->Apply(Sizes);
+#if SCREENSHOT_BENCH_WITH_PLUGIN
+BENCHMARK(BM_AcquireGdi)
+    ->Arg(0)
+    ->Arg(1)
+    ->ArgName("cursor")
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#endif
+BENCHMARK(BM_Cursor)->Apply(Sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Convert)->Apply(Sizes);
+BENCHMARK(BM_Encode)->Apply(EncodeFormats);
+BENCHMARK(BM_Marshal)->Apply(Replies);
+BENCHMARK(BM_EndToEnd)->Apply(EndToEndFormats);
+
+// The SIMD paths the kernels can take here, for the run's context.
+std::string SimdLevel() {
+  const CpuFeatures& features = GetCpuFeatures();
+  if (features.avx2) return "avx2";
+  if (features.sse41) return "sse4.1";
+  if (features.ssse3) return "ssse3";
+  if (features.sse2) return "sse2";
+  return "scalar";
+}
+
+}  // namespace
+}  // namespace screenshot
+
+int main(int argc, char** argv) {
+  // JSON unless a format was asked for.
+  std::vector<char*> args(argv, argv + argc);
+  bool has_format = false;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--benchmark_format", 18) == 0) {
+      has_format = true;
+    }
+  }
+  char json[] = "--benchmark_format=json";
+  if (!has_format) args.insert(args.begin() + 1, json);
+  int count = static_cast<int>(args.size());
+  benchmark::Initialize(&count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(count, args.data())) return 1;
+  benchmark::AddCustomContext("simd", screenshot::SimdLevel());
+#if SCREENSHOT_BENCH_WITH_PLUGIN
+  benchmark::AddCustomContext("method_codec", "flutter");
+#else
+  benchmark::AddCustomContext("method_codec", "bench::SerializeCaptureMap");
+#endif
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
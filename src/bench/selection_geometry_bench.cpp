@@ -0,0 +1,75 @@
+// Damage computed for the region selection overlay while dragging:
+//
+//   ./screenshot_core_bench --benchmark_filter=SelectionDamage
+//
+// Replays a drag across a 3840x2160 screen, one mouse move per iteration,
+// with steps of a few pixels (arg 0) as a mouse reports them. Besides the
+// time per move, reports the rectangles and the share of the screen
+// repainted per move ("repainted", 1.0 being the full-screen repaint the
+// overlay used to do on every move).
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "image_rect.h"
+#include "selection_geometry.h"
+
+namespace screenshot {
+namespace {
+
+constexpr int kScreenWidth = 3840;
+constexpr int kScreenHeight = 2160;
+
+// Cursor positions of a drag from near the top left to the bottom right and
+// back, wobbling like a hand-held mouse.
+std::vector<PixelRect> DragPath(int step) {
+  std::vector<PixelRect> path;
+  const int anchor_x = 200;
+  const int anchor_y = 150;
+  int x = anchor_x;
+  int y = anchor_y;
+  int direction = 1;
+  for (int i = 0; i < 4000; ++i) {
+    x += direction * step;
+    y += direction * (step / 2 + (i % 3));
+    if (x >= kScreenWidth - 200 || y >= kScreenHeight - 150) direction = -1;
+    if (x <= anchor_x || y <= anchor_y) direction = 1;
+    path.push_back(RectFromCorners(anchor_x, anchor_y, x, y));
+  }
+  return path;
+}
+
+void BM_SelectionDamage(benchmark::State& state) {
+  const std::vector<PixelRect> path =
+      DragPath(static_cast<int>(state.range(0)));
+  const SelectionStyle style;
+  const PixelRect bounds{0, 0, kScreenWidth, kScreenHeight};
+  std::vector<PixelRect> damage;
+  size_t index = 0;
+  PixelRect before = path[0];
+  int64_t rects = 0;
+  int64_t pixels = 0;
+  for (auto _ : state) {
+    const PixelRect& after = path[index];
+    SelectionDamage(before, after, style, bounds, &damage);
+    benchmark::DoNotOptimize(damage.data());
+    rects += static_cast<int64_t>(damage.size());
+    for (const PixelRect& rect : damage) {
+      pixels += static_cast<int64_t>(rect.width) * rect.height;
+    }
+    before = after;
+    if (++index == path.size()) index = 0;
+  }
+  const double moves = static_cast<double>(state.iterations());
+  state.counters["rects"] = static_cast<double>(rects) / moves;
+  state.counters["repainted"] =
+      static_cast<double>(pixels) / moves /
+      (static_cast<double>(kScreenWidth) * kScreenHeight);
+}
+
+BENCHMARK(BM_SelectionDamage)->ArgName("step")->Arg(1)->Arg(4)->Arg(16);
+
+}  // namespace
+}  // namespace screenshot
@@ -0,0 +1,89 @@
+// The synthetic screen the pipeline benchmarks capture from:
+//
+//   ./screenshot_core_bench --benchmark_filter=SyntheticScreen
+//
+// "Capture" reads one whole frame, which should cost about a memcpy of it,
+// so that benchmarks built on SyntheticScreen measure the pipeline rather
+// than the generator. "Diff" captures and tile-diffs successive frames at
+// a given change rate (in percent): "tiles" is the mean number of changed
+// tiles per frame, which the rate should scale.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "frame_diff.h"
+#include "image.h"
+#include "synthetic_screen.h"
+
+namespace screenshot {
+namespace {
+
+constexpr int kSizes[][2] = {{1920, 1080}, {2560, 1440}, {3840, 2160},
+                             {7680, 4320}};
+
+SyntheticScreenOptions Options(const benchmark::State& state) {
+  SyntheticScreenOptions options;
+  options.width = static_cast<int>(state.range(0));
+  options.height = static_cast<int>(state.range(1));
+  return options;
+}
+
+// Args: width, height.
+void BM_SyntheticScreenCapture(benchmark::State& state) {
+  SyntheticScreen screen(Options(state));
+  const PixelRect bounds = screen.Bounds();
+  const size_t stride = static_cast<size_t>(bounds.width) * kBytesPerPixel;
+  std::vector<uint8_t> pixels(stride * static_cast<size_t>(bounds.height));
+  for (auto _ : state) {
+    screen.Capture(bounds, true, pixels.data(), stride);
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(pixels.size()));
+}
+
+// Args: width, height, change rate in percent.
+void BM_SyntheticScreenDiff(benchmark::State& state) {
+  SyntheticScreenOptions options = Options(state);
+  options.change_rate = static_cast<double>(state.range(2)) / 100.0;
+  SyntheticScreen screen(options);
+  const PixelRect bounds = screen.Bounds();
+  const size_t stride = static_cast<size_t>(bounds.width) * kBytesPerPixel;
+  std::vector<uint8_t> pixels(stride * static_cast<size_t>(bounds.height));
+  const ImageView view{pixels.data(), bounds.width, bounds.height, stride,
+                       PixelFormat::kBgra8};
+  FrameDiffer differ;
+  FrameDiff diff;
+  screen.Capture(bounds, false, pixels.data(), stride);
+  differ.Diff(view, false, &diff);
+  size_t tiles = 0;
+  for (auto _ : state) {
+    screen.Capture(bounds, false, pixels.data(), stride);
+    differ.Diff(view, false, &diff);
+    tiles += diff.tiles.size();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(pixels.size()));
+  state.counters["tiles"] = benchmark::Counter(
+      static_cast<double>(tiles), benchmark::Counter::kAvgIterations);
+}
+
+void Sizes(benchmark::internal::Benchmark* b) {
+  for (const auto& size : kSizes) b->Args({size[0], size[1]});
+  b->ArgNames({"width", "height"});
+  b->Unit(benchmark::kMicrosecond);
+}
+
+void Rates(benchmark::internal::Benchmark* b) {
+  for (int rate : {0, 25, 100}) b->Args({1920, 1080, rate});
+  b->ArgNames({"width", "height", "rate"});
+  b->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK(BM_SyntheticScreenCapture)->Apply(Sizes);
+BENCHMARK(BM_SyntheticScreenDiff)->Apply(Rates);
+
+}  // namespace
+}  // namespace screenshot
@@ -0,0 +1,46 @@
+#ifndef SCREENSHOT_CORE_BYTE_SINK_H_
+#define SCREENSHOT_CORE_BYTE_SINK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace screenshot {
+
+// Largest piece the streaming encoders hand to a ByteSink at once (except
+// for single rows or blocks that are larger on their own), and so about the
+// most encoded output they hold in memory per thread.
+constexpr size_t kSinkChunkSize = size_t{1} << 20;
+
+// Destination for output that is produced piece by piece, such as an
+// encoder streaming a file to disk instead of building it in memory.
+class ByteSink {
+ public:
+  virtual ~ByteSink() = default;
+
+  // Appends |size| bytes. Returns false if they could not be written; a
+  // sink that has failed keeps failing, so producers can stop at the first
+  // false.
+  virtual bool Write(const uint8_t* data, size_t size) = 0;
+};
+
+// Collects everything written into a vector.
+class VectorSink : public ByteSink {
+ public:
+  bool Write(const uint8_t* data, size_t size) override {
+    bytes_.insert(bytes_.end(), data, data + size);
+    ++writes_;
+    return true;
+  }
+
+  const std::vector<uint8_t>& bytes() const { return bytes_; }
+  size_t writes() const { return writes_; }
+
+ private:
+  std::vector<uint8_t> bytes_;
+  size_t writes_ = 0;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_BYTE_SINK_H_
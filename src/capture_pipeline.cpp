@@ -0,0 +1,110 @@
+#include "capture_pipeline.h"
+
+#include <utility>
+
+#include "trace.h"
+
+namespace screenshot {
+
+CapturePipeline::CapturePipeline(Dispatcher dispatcher,
+                                 const CapturePipelineOptions& options)
+    : dispatcher_(std::move(dispatcher)), options_(options) {
+  if (options_.max_captured == 0) options_.max_captured = 1;
+  encode_thread_ = std::thread([this] { EncodeLoop(); });
+  capture_thread_ = std::thread([this] { CaptureLoop(); });
+}
+
+CapturePipeline::~CapturePipeline() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  capture_cv_.notify_one();
+  encode_cv_.notify_one();
+  capture_thread_.join();
+  encode_thread_.join();
+}
+
+bool CapturePipeline::Submit(std::unique_ptr<PipelineJob> job) {
+  if (!job) return false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capture_queue_.push_back(std::shared_ptr<PipelineJob>(std::move(job)));
+  }
+  capture_cv_.notify_one();
+  return true;
+}
+
+size_t CapturePipeline::pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return capture_queue_.size() + capturing_ + encode_queue_.size() +
+         encoding_;
+}
+
+void CapturePipeline::CaptureLoop() {
+  SetTraceThreadName("capture");
+  for (;;) {
+    std::shared_ptr<PipelineJob> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // Jobs submitted before shutdown still run, so every one completes.
+      capture_cv_.wait(lock, [this] {
+        return (!capture_queue_.empty() &&
+                encode_queue_.size() < options_.max_captured) ||
+               (stopping_ && capture_queue_.empty());
+      });
+      if (capture_queue_.empty()) break;
+      job = std::move(capture_queue_.front());
+      capture_queue_.pop_front();
+      ++capturing_;
+    }
+    const bool captured = job->Capture();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --capturing_;
+      // A failed job still goes through the encode thread, so that it
+      // completes after the jobs ahead of it.
+      encode_queue_.push_back(CapturedJob{std::move(job), captured});
+    }
+    encode_cv_.notify_one();
+  }
+  // Lets the encode thread see that nothing more is coming.
+  encode_cv_.notify_one();
+}
+
+void CapturePipeline::EncodeLoop() {
+  SetTraceThreadName("encode");
+  for (;;) {
+    CapturedJob job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      encode_cv_.wait(lock, [this] {
+        return !encode_queue_.empty() ||
+               (stopping_ && capture_queue_.empty() && capturing_ == 0);
+      });
+      if (encode_queue_.empty()) break;
+      job = std::move(encode_queue_.front());
+      encode_queue_.pop_front();
+      ++encoding_;
+    }
+    // There is room for another capture now.
+    capture_cv_.notify_one();
+    if (job.captured) job.job->Encode();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --encoding_;
+    }
+    Finish(std::move(job.job));
+  }
+}
+
+void CapturePipeline::Finish(std::shared_ptr<PipelineJob> job) {
+  // std::function needs a copyable task, hence the shared_ptr.
+  // Complete() hands the result to the channel, which serializes it.
+  dispatcher_([job] {
+    TraceSpan span("reply");
+    job->Complete();
+  });
+}
+
+}  // namespace screenshot
@@ -0,0 +1,106 @@
+#ifndef SCREENSHOT_CORE_CAPTURE_PIPELINE_H_
+#define SCREENSHOT_CORE_CAPTURE_PIPELINE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace screenshot {
+
+// One request through a CapturePipeline: capture, encode, then complete.
+class PipelineJob {
+ public:
+  virtual ~PipelineJob() = default;
+
+  // Grabs the pixels, on the pipeline's capture thread. Returning false
+  // skips Encode().
+  virtual bool Capture() = 0;
+
+  // Turns the pixels into the result, on the pipeline's encode thread.
+  virtual void Encode() = 0;
+
+  // Delivers the result, on whatever thread the pipeline's dispatcher runs
+  // tasks on (the platform thread, in the plugin).
+  virtual void Complete() = 0;
+};
+
+struct CapturePipelineOptions {
+  // Captured frames allowed to wait for the encoder. The capture thread
+  // pauses at this depth, so memory stays bounded however many requests
+  // are queued, while one capture can still overlap the previous encode.
+  size_t max_captured = 2;
+};
+
+// Runs capture requests off the calling thread, in two stages with a thread
+// each, so that the capture of frame N+1 overlaps the encode of frame N.
+//
+// Jobs go through both stages in submission order, and their Complete() is
+// handed to the dispatcher, which runs it on the thread that owns the
+// results, in that same order. A job whose capture fails skips Encode() but
+// still waits its turn behind earlier jobs still encoding. Submit() never
+// blocks on capturing or encoding.
+class CapturePipeline {
+ public:
+  // Queues |task| to run on the completing thread. Complete() must only
+  // run there, so a dispatcher should accept every task while it exists
+  // and retry its own wake-ups rather than refuse. Returns false if it
+  // cannot; the job is then dropped without completing.
+  using Dispatcher = std::function<bool(std::function<void()> task)>;
+
+  explicit CapturePipeline(
+      Dispatcher dispatcher,
+      const CapturePipelineOptions& options = CapturePipelineOptions());
+
+  // Finishes the capture and encode stages of every submitted job, hands
+  // them to the dispatcher, then joins both threads.
+  ~CapturePipeline();
+
+  CapturePipeline(const CapturePipeline&) = delete;
+  CapturePipeline& operator=(const CapturePipeline&) = delete;
+
+  // Queues |job|. Returns false for a null job.
+  bool Submit(std::unique_ptr<PipelineJob> job);
+
+  // Jobs submitted that have not been handed to the dispatcher yet.
+  size_t pending() const;
+
+ private:
+  void CaptureLoop();
+  void EncodeLoop();
+
+  // Hands |job| to the dispatcher for completion.
+  void Finish(std::shared_ptr<PipelineJob> job);
+
+  Dispatcher dispatcher_;
+  CapturePipelineOptions options_;
+
+  mutable std::mutex mutex_;
+  // Wakes the capture thread on a new job, room in encode_queue_ or
+  // shutdown, and the encode thread on a captured job or shutdown.
+  std::condition_variable capture_cv_;
+  std::condition_variable encode_cv_;
+  std::deque<std::shared_ptr<PipelineJob>> capture_queue_;
+  // A job on its way to the encode thread, and whether its Capture()
+  // succeeded.
+  struct CapturedJob {
+    std::shared_ptr<PipelineJob> job;
+    bool captured = false;
+  };
+
+  std::deque<CapturedJob> encode_queue_;
+  // Popped from capture_queue_ but not yet in encode_queue_.
+  size_t capturing_ = 0;
+  size_t encoding_ = 0;
+  bool stopping_ = false;
+
+  std::thread capture_thread_;
+  std::thread encode_thread_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_CAPTURE_PIPELINE_H_
@@ -0,0 +1,37 @@
+#include "capture_source.h"
+
+#include "trace.h"
+
+namespace screenshot {
+
+FramePool::Lease CaptureToPool(CaptureSource* source, FramePool* pool,
+                               const PixelRect& rect, bool include_cursor) {
+  TraceSpan span("capture");
+  if (rect.IsEmpty()) return FramePool::Lease();
+  FramePool::Lease frame =
+      pool->Acquire(rect.width, rect.height, PixelFormat::kBgra8);
+  if (!frame ||
+      !source->Capture(rect, include_cursor, frame->data(), frame->stride())) {
+    return FramePool::Lease();
+  }
+  return frame;
+}
+
+bool CaptureSourceFrameSource::Capture(StreamFrame* frame) {
+  TraceSpan span("capture");
+  const PixelRect bounds = source_->Bounds();
+  if (bounds.IsEmpty()) return false;
+  const size_t stride = static_cast<size_t>(bounds.width) * kBytesPerPixel;
+  frame->pixels.resize(stride * static_cast<size_t>(bounds.height));
+  if (!source_->Capture(bounds, include_cursor_, frame->pixels.data(),
+                        stride)) {
+    return false;
+  }
+  frame->width = bounds.width;
+  frame->height = bounds.height;
+  frame->stride = stride;
+  frame->format = PixelFormat::kBgra8;
+  return true;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,66 @@
+#ifndef SCREENSHOT_CORE_CAPTURE_SOURCE_H_
+#define SCREENSHOT_CORE_CAPTURE_SOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "capture_stream.h"
+#include "frame_mailbox.h"
+#include "frame_pool.h"
+#include "image_rect.h"
+
+namespace screenshot {
+
+// Where captured pixels come from: the screen (GDI on Windows), or a
+// generated screen (SyntheticScreen) in tests and benchmarks.
+//
+// A source writes into buffers its caller provides, so the caller decides
+// where frames live (a pooled buffer, a stream frame, a shared-memory
+// slot) and no source allocates per capture.
+class CaptureSource {
+ public:
+  virtual ~CaptureSource() = default;
+
+  // The area "screen" captures read, in the source's coordinates: the
+  // primary display for the screen, at the origin. May be called from any
+  // thread, while a capture runs on another.
+  virtual PixelRect Bounds() = 0;
+
+  // Copies |rect| into |pixels|: rect.height top-down BGRA rows of
+  // rect.width * 4 bytes, |stride| bytes apart, with the cursor drawn on
+  // top if |include_cursor|. Alpha is undefined, as GDI leaves it. |rect|
+  // may extend past Bounds() where the source has more to show (other
+  // displays). Returns false if |rect| is empty or cannot be read.
+  virtual bool Capture(const PixelRect& rect, bool include_cursor,
+                       uint8_t* pixels, size_t stride) = 0;
+
+  // How long the last Capture() spent drawing the cursor, in nanoseconds,
+  // for sources that draw it as a step of their own; -1 if it drew none or
+  // cannot tell, in which case drawing it is part of the capture's time.
+  virtual int64_t cursor_nanos() const { return -1; }
+};
+
+// Captures |rect| from |source| into a buffer leased from |pool|. Returns
+// an empty lease on failure.
+FramePool::Lease CaptureToPool(CaptureSource* source, FramePool* pool,
+                               const PixelRect& rect, bool include_cursor);
+
+// Streams a CaptureSource: each frame is the source's Bounds() at the time,
+// read straight into the frame's reused buffer.
+class CaptureSourceFrameSource : public FrameSource {
+ public:
+  // |source| must outlive this object and is used only on the stream's
+  // capture thread.
+  CaptureSourceFrameSource(CaptureSource* source, bool include_cursor)
+      : source_(source), include_cursor_(include_cursor) {}
+
+  bool Capture(StreamFrame* frame) override;
+
+ private:
+  CaptureSource* source_;
+  bool include_cursor_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_CAPTURE_SOURCE_H_
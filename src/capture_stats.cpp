@@ -0,0 +1,192 @@
+#include "capture_stats.h"
+
+#include <chrono>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+constexpr int kSubBucketBits = 3;
+constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+
+inline int FloorLog2(uint64_t v) {
+#if defined(_MSC_VER)
+  unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+  _BitScanReverse64(&index, v);
+  return static_cast<int>(index);
+#else
+  if (v >> 32) {
+    _BitScanReverse(&index, static_cast<uint32_t>(v >> 32));
+    return static_cast<int>(index) + 32;
+  }
+  _BitScanReverse(&index, static_cast<uint32_t>(v));
+  return static_cast<int>(index);
+#endif
+#else
+  return 63 - __builtin_clzll(v);
+#endif
+}
+
+// The value reported for a percentile that falls in |bucket|: its middle,
+// which is within half a bucket, 1/16, of any value in it.
+int64_t BucketMiddle(size_t bucket) {
+  const uint64_t lower = LatencyHistogram::BucketLowerBound(bucket);
+  const uint64_t upper =
+      bucket + 1 < LatencyHistogram::kBucketCount
+          ? LatencyHistogram::BucketLowerBound(bucket + 1)
+          : std::numeric_limits<uint64_t>::max();
+  const uint64_t middle = lower + (upper - lower) / 2;
+  return middle > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())
+             ? std::numeric_limits<int64_t>::max()
+             : static_cast<int64_t>(middle);
+}
+
+}  // namespace
+
+int64_t MonotonicNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+const char* CaptureStageName(CaptureStage stage) {
+  switch (stage) {
+    case CaptureStage::kCapture:
+      return "capture";
+    case CaptureStage::kCursor:
+      return "cursor";
+    case CaptureStage::kScale:
+      return "scale";
+    case CaptureStage::kEncode:
+      return "encode";
+    case CaptureStage::kTotal:
+      return "total";
+  }
+  return "unknown";
+}
+
+LatencyHistogram::LatencyHistogram() {
+  for (std::atomic<uint64_t>& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+// static
+size_t LatencyHistogram::BucketFor(uint64_t nanos) {
+  if (nanos < kSubBuckets) return static_cast<size_t>(nanos);
+  // The top kSubBucketBits bits below the leading one pick the sub-bucket.
+  const int exponent = FloorLog2(nanos);
+  const uint64_t sub =
+      (nanos >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+  return static_cast<size_t>(
+      static_cast<uint64_t>(exponent - kSubBucketBits + 1) * kSubBuckets +
+      sub);
+}
+
+// static
+uint64_t LatencyHistogram::BucketLowerBound(size_t bucket) {
+  if (bucket < kSubBuckets) return bucket;
+  const int exponent =
+      static_cast<int>(bucket / kSubBuckets) + kSubBucketBits - 1;
+  const uint64_t sub = bucket % kSubBuckets;
+  return (kSubBuckets + sub) << (exponent - kSubBucketBits);
+}
+
+void LatencyHistogram::Record(int64_t nanos) {
+  if (nanos < 0) nanos = 0;
+  const uint64_t value = static_cast<uint64_t>(nanos);
+  buckets_[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  // Most samples are not a new max, and then this is a plain load.
+  int64_t max = max_.load(std::memory_order_relaxed);
+  while (nanos > max &&
+         !max_.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+  }
+}
+
+LatencySummary LatencyHistogram::Summarize() const {
+  uint64_t counts[kBucketCount];
+  uint64_t count = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    count += counts[i];
+  }
+  LatencySummary summary;
+  if (count == 0) return summary;
+  summary.count = count;
+  summary.max = max_.load(std::memory_order_relaxed);
+  summary.mean = static_cast<int64_t>(sum_.load(std::memory_order_relaxed) /
+                                      count);
+
+  // The smallest value at least |percent| of the samples are at or below.
+  auto percentile = [&](uint64_t percent) -> int64_t {
+    const uint64_t rank = (count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        // A bucket's middle can lie past the largest sample in it.
+        const int64_t value = BucketMiddle(i);
+        return value < summary.max ? value : summary.max;
+      }
+    }
+    return summary.max;
+  };
+  summary.p50 = percentile(50);
+  summary.p95 = percentile(95);
+  summary.p99 = percentile(99);
+  return summary;
+}
+
+void LatencyHistogram::Reset() {
+  for (std::atomic<uint64_t>& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+void CaptureStats::Record(const CaptureSample& sample) {
+  for (size_t i = 0; i < kCaptureStageCount; ++i) {
+    if (sample.nanos[i] >= 0) latency_[i].Record(sample.nanos[i]);
+  }
+  if (sample.captured_bytes != 0) {
+    captured_bytes_.fetch_add(sample.captured_bytes,
+                              std::memory_order_relaxed);
+  }
+  if (sample.output_bytes != 0) {
+    output_bytes_.fetch_add(sample.output_bytes, std::memory_order_relaxed);
+  }
+}
+
+void CaptureStats::RecordError(CaptureStage stage) {
+  errors_[static_cast<size_t>(stage)].fetch_add(1, std::memory_order_relaxed);
+}
+
+CaptureStatsSnapshot CaptureStats::Snapshot() const {
+  CaptureStatsSnapshot snapshot;
+  for (size_t i = 0; i < kCaptureStageCount; ++i) {
+    snapshot.stages[i].latency = latency_[i].Summarize();
+    snapshot.stages[i].errors = errors_[i].load(std::memory_order_relaxed);
+  }
+  snapshot.captured_bytes = captured_bytes_.load(std::memory_order_relaxed);
+  snapshot.output_bytes = output_bytes_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void CaptureStats::Reset() {
+  for (size_t i = 0; i < kCaptureStageCount; ++i) {
+    latency_[i].Reset();
+    errors_[i].store(0, std::memory_order_relaxed);
+  }
+  captured_bytes_.store(0, std::memory_order_relaxed);
+  output_bytes_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace screenshot
@@ -0,0 +1,143 @@
+#ifndef SCREENSHOT_CORE_CAPTURE_STATS_H_
+#define SCREENSHOT_CORE_CAPTURE_STATS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace screenshot {
+
+// Steady-clock time in nanoseconds: monotonic, and as fine as the platform
+// timer (QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere).
+int64_t MonotonicNanos();
+
+// Where a capture spends its time, in order.
+enum class CaptureStage {
+  kCapture,  // copying the screen (BitBlt, XShmGetImage)
+  kCursor,   // drawing the cursor, when the source times it on its own
+  kScale,    // fitting the frame to maxWidth/maxHeight/scale
+  kEncode,   // converting or encoding, into a map, shared memory or a file
+  kTotal,    // from the start of the capture until the reply is sent
+};
+
+constexpr size_t kCaptureStageCount = 5;
+
+// "capture", "cursor", ...; the names getStats reports stages under.
+const char* CaptureStageName(CaptureStage stage);
+
+// Percentiles of a LatencyHistogram, in nanoseconds. Percentiles are
+// within 1/16 of the true value; max is exact. All 0 without samples.
+struct LatencySummary {
+  uint64_t count = 0;
+  int64_t p50 = 0;
+  int64_t p95 = 0;
+  int64_t p99 = 0;
+  int64_t max = 0;
+  // Exact.
+  int64_t mean = 0;
+};
+
+// A latency distribution that any number of threads can add to at once
+// without a lock.
+//
+// Samples are counted in log-linear buckets (8 per power of two) of
+// relaxed atomic counters, so Record() is a handful of instructions and
+// never blocks or allocates, and the histogram has a fixed size however
+// many samples it holds. Summarize() may run while others record; it sees
+// each concurrent sample either fully or partly (counted but not yet in
+// the max, say), which skews nothing by more than that one sample.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  // Adds a sample; negative ones count as 0.
+  void Record(int64_t nanos);
+
+  LatencySummary Summarize() const;
+
+  // Drops every sample. Samples recorded concurrently may survive.
+  void Reset();
+
+  // 8 buckets each for [2^k, 2^(k+1)), k = 3..63, plus 8 for [0, 8).
+  static constexpr size_t kBucketCount = 62 * 8;
+
+  // The bucket |nanos| (>= 0) is counted in, and the smallest value that
+  // bucket holds; exposed for tests.
+  static size_t BucketFor(uint64_t nanos);
+  static uint64_t BucketLowerBound(size_t bucket);
+
+ private:
+  std::atomic<uint64_t> buckets_[kBucketCount];
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<int64_t> max_{0};
+};
+
+// What one capture measured, filled in stage by stage as it moves through
+// the pipeline's threads (each writing its own stages, in turn) and
+// recorded once it completes.
+struct CaptureSample {
+  // Set for each stage that ran; stages that were skipped (no cursor, no
+  // scaling) are not recorded, so they do not drag the percentiles to 0.
+  int64_t nanos[kCaptureStageCount] = {-1, -1, -1, -1, -1};
+  // Bytes read from the screen, and bytes of the result (encoded image,
+  // raw pixels or file).
+  uint64_t captured_bytes = 0;
+  uint64_t output_bytes = 0;
+
+  void Set(CaptureStage stage, int64_t stage_nanos) {
+    nanos[static_cast<size_t>(stage)] = stage_nanos;
+  }
+  int64_t Get(CaptureStage stage) const {
+    return nanos[static_cast<size_t>(stage)];
+  }
+};
+
+struct StageStats {
+  LatencySummary latency;
+  // Captures that failed in this stage.
+  uint64_t errors = 0;
+};
+
+struct CaptureStatsSnapshot {
+  StageStats stages[kCaptureStageCount];
+  uint64_t captured_bytes = 0;
+  uint64_t output_bytes = 0;
+
+  const StageStats& stage(CaptureStage s) const {
+    return stages[static_cast<size_t>(s)];
+  }
+};
+
+// Per-stage latency, byte and error counters of every capture, for
+// "getStats". Lock-free like LatencyHistogram: the pipeline's threads
+// record while the platform thread reads or resets.
+class CaptureStats {
+ public:
+  CaptureStats() = default;
+
+  CaptureStats(const CaptureStats&) = delete;
+  CaptureStats& operator=(const CaptureStats&) = delete;
+
+  // Adds the stages |sample| timed and its bytes.
+  void Record(const CaptureSample& sample);
+
+  // Counts a capture that failed in |stage|.
+  void RecordError(CaptureStage stage);
+
+  CaptureStatsSnapshot Snapshot() const;
+
+  void Reset();
+
+ private:
+  LatencyHistogram latency_[kCaptureStageCount];
+  std::atomic<uint64_t> errors_[kCaptureStageCount] = {};
+  std::atomic<uint64_t> captured_bytes_{0};
+  std::atomic<uint64_t> output_bytes_{0};
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_CAPTURE_STATS_H_
@@ -0,0 +1,143 @@
+#include "capture_stream.h"
+
+#include <cmath>
+#include <utility>
+
+#include "trace.h"
+
+namespace screenshot {
+
+namespace {
+
+using Clock = FramePacer::Clock;
+
+}  // namespace
+
+FramePacer::FramePacer(double fps)
+    : period_(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::nanoseconds(std::llround(1e9 / fps)))) {
+  if (period_ <= Clock::duration::zero()) period_ = Clock::duration(1);
+}
+
+Clock::time_point FramePacer::Start(Clock::time_point now) {
+  deadline_ = now;
+  skipped_ = 0;
+  return deadline_;
+}
+
+Clock::time_point FramePacer::Next(Clock::time_point now) {
+  deadline_ += period_;
+  if (deadline_ < now) {
+    const auto missed = (now - deadline_ + period_ - Clock::duration(1)) /
+                        period_;
+    deadline_ += missed * period_;
+    skipped_ += static_cast<uint64_t>(missed);
+  }
+  return deadline_;
+}
+
+CaptureStream::~CaptureStream() { Stop(); }
+
+bool CaptureStream::Start(FrameSource* source,
+                          const CaptureStreamOptions& options,
+                          FrameCallback on_frame) {
+  if (running_ || !source || !on_frame) return false;
+  if (!(options.fps > 0.0 && options.fps <= kMaxFps)) return false;
+
+  source_ = source;
+  on_frame_ = std::move(on_frame);
+  // Both threads are stopped, so this thread can drain a frame the last run
+  // left in the mailbox.
+  mailbox_.Acquire();
+  captured_ = 0;
+  delivered_ = 0;
+  dropped_ = 0;
+  failed_ = 0;
+  skipped_ = 0;
+  stopping_ = false;
+  running_ = true;
+  deliver_thread_ = std::thread([this] { DeliverLoop(); });
+  capture_thread_ = std::thread([this, fps = options.fps] { CaptureLoop(fps); });
+  return true;
+}
+
+void CaptureStream::Stop() {
+  if (!running_) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  capture_cv_.notify_one();
+  deliver_cv_.notify_one();
+  capture_thread_.join();
+  deliver_thread_.join();
+  running_ = false;
+  on_frame_ = nullptr;
+}
+
+CaptureStreamStats CaptureStream::stats() const {
+  CaptureStreamStats stats;
+  stats.captured = captured_.load(std::memory_order_relaxed);
+  stats.delivered = delivered_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.failed = failed_.load(std::memory_order_relaxed);
+  stats.skipped = skipped_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void CaptureStream::CaptureLoop(double fps) {
+  SetTraceThreadName("stream capture");
+  FramePacer pacer(fps);
+  Clock::time_point deadline = pacer.Start(Clock::now());
+  uint64_t sequence = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (capture_cv_.wait_until(lock, deadline,
+                                 [this] { return stopping_; })) {
+        return;
+      }
+    }
+    const Clock::time_point start = Clock::now();
+    StreamFrame* frame = mailbox_.back();
+    if (source_->Capture(frame)) {
+      frame->sequence = sequence++;
+      frame->timestamp_us =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              start.time_since_epoch())
+              .count();
+      captured_.fetch_add(1, std::memory_order_relaxed);
+      if (mailbox_.Publish()) dropped_.fetch_add(1, std::memory_order_relaxed);
+      // Taking the lock orders the publish before the delivery thread's
+      // predicate check, so the wakeup cannot be lost.
+      { std::lock_guard<std::mutex> lock(mutex_); }
+      deliver_cv_.notify_one();
+    } else {
+      failed_.fetch_add(1, std::memory_order_relaxed);
+    }
+    deadline = pacer.Next(Clock::now());
+    skipped_.store(pacer.skipped(), std::memory_order_relaxed);
+  }
+}
+
+void CaptureStream::DeliverLoop() {
+  SetTraceThreadName("stream deliver");
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      deliver_cv_.wait(lock,
+                       [this] { return stopping_ || mailbox_.HasFrame(); });
+      if (stopping_) return;
+    }
+    const StreamFrame* frame = mailbox_.Acquire();
+    if (!frame) continue;
+    TraceSpan span("deliver");
+    if (on_frame_(*frame)) {
+      delivered_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      failed_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace screenshot
@@ -0,0 +1,143 @@
+#ifndef SCREENSHOT_CORE_CAPTURE_STREAM_H_
+#define SCREENSHOT_CORE_CAPTURE_STREAM_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "frame_mailbox.h"
+
+namespace screenshot {
+
+// Fixed-rate capture deadlines on the steady clock.
+//
+// Deadlines are multiples of the period from the start, so they do not
+// drift with capture time. When a capture overruns, the ticks it missed are
+// skipped rather than captured back to back.
+class FramePacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // |fps| must be positive.
+  explicit FramePacer(double fps);
+
+  Clock::duration period() const { return period_; }
+
+  // Deadline of the first frame: |now|.
+  Clock::time_point Start(Clock::time_point now);
+
+  // Deadline of the next frame, given that the previous capture finished at
+  // |now|. Ticks that have already passed are skipped, and the first one at
+  // or after |now| is returned.
+  Clock::time_point Next(Clock::time_point now);
+
+  // Ticks skipped because a capture overran.
+  uint64_t skipped() const { return skipped_; }
+
+ private:
+  Clock::duration period_;
+  Clock::time_point deadline_;
+  uint64_t skipped_ = 0;
+};
+
+// Where a stream's frames come from: the screen on Windows, generated
+// frames in tests and benchmarks.
+class FrameSource {
+ public:
+  virtual ~FrameSource() = default;
+
+  // Captures the current image into |frame|, reusing frame->pixels, and
+  // sets its size, stride and format. Called on the capture thread only.
+  virtual bool Capture(StreamFrame* frame) = 0;
+};
+
+struct CaptureStreamOptions {
+  // Target capture rate.
+  double fps = 30.0;
+};
+
+struct CaptureStreamStats {
+  uint64_t captured = 0;
+  uint64_t delivered = 0;
+  // Captured frames replaced by a newer one before delivery.
+  uint64_t dropped = 0;
+  // Frames that could not be captured, or that the callback rejected (e.g.
+  // because encoding failed). Neither counts as delivered.
+  uint64_t failed = 0;
+  // Pacer ticks skipped because capturing took longer than the period.
+  uint64_t skipped = 0;
+};
+
+// Captures frames at a fixed rate on a dedicated thread and delivers the
+// newest one to a callback on a second thread.
+//
+// The threads meet in a FrameMailbox, so a slow consumer (e.g. encoding)
+// never stalls capture and frames never queue up: when the consumer falls
+// behind, the frames it had no time for are dropped and it continues with
+// the newest one. Latency is therefore bounded by one capture plus one
+// delivery.
+class CaptureStream {
+ public:
+  // Called on the delivery thread. |frame| is valid until it returns.
+  // Returns false if the frame could not be delivered, which counts it as
+  // failed instead of delivered.
+  using FrameCallback = std::function<bool(const StreamFrame& frame)>;
+
+  CaptureStream() = default;
+  ~CaptureStream();
+
+  CaptureStream(const CaptureStream&) = delete;
+  CaptureStream& operator=(const CaptureStream&) = delete;
+
+  // Starts capturing from |source|, which must outlive the stream. Returns
+  // false if the stream is already running, |source| or |on_frame| is
+  // missing, or the fps is not in (0, kMaxFps].
+  bool Start(FrameSource* source, const CaptureStreamOptions& options,
+             FrameCallback on_frame);
+
+  // Stops and joins both threads; a callback in progress finishes first.
+  // Must not be called from the callback.
+  void Stop();
+
+  // Start() and Stop() are called from one controlling thread, which can
+  // also check running().
+  bool running() const { return running_; }
+
+  // Counters since the last Start(); safe to read while running.
+  CaptureStreamStats stats() const;
+
+  static constexpr double kMaxFps = 240.0;
+
+ private:
+  void CaptureLoop(double fps);
+  void DeliverLoop();
+
+  FrameSource* source_ = nullptr;
+  FrameCallback on_frame_;
+  FrameMailbox mailbox_;
+
+  std::mutex mutex_;
+  // Wakes the capture thread early on Stop() and the delivery thread on a
+  // new frame or Stop().
+  std::condition_variable capture_cv_;
+  std::condition_variable deliver_cv_;
+  bool stopping_ = false;
+  bool running_ = false;
+
+  std::atomic<uint64_t> captured_{0};
+  std::atomic<uint64_t> delivered_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> failed_{0};
+  std::atomic<uint64_t> skipped_{0};
+
+  std::thread capture_thread_;
+  std::thread deliver_thread_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_CAPTURE_STREAM_H_
@@ -0,0 +1,696 @@
+#include "checksum.h"
+
+#include <cstring>
+
+#include "cpu_features.h"
+
+#if SCREENSHOT_ARCH_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <smmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+constexpr uint32_t kAdlerBase = 65521;
+// Largest n such that 255 * n * (n + 1) / 2 + (n + 1) * (kAdlerBase - 1)
+// fits in 32 bits, i.e. how many bytes can be summed before reducing.
+constexpr size_t kAdlerNmax = 5552;
+
+inline uint32_t LoadLe32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Slicing-by-8 tables for the reflected polynomial 0xEDB88320.
+struct CrcTables {
+  uint32_t t[8][256];
+
+  CrcTables() {
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      t[0][n] = c;
+    }
+    for (uint32_t n = 0; n < 256; ++n) {
+      for (int k = 1; k < 8; ++k) {
+        t[k][n] = (t[k - 1][n] >> 8) ^ t[0][t[k - 1][n] & 0xFF];
+      }
+    }
+  }
+};
+
+constexpr uint32_t kXxPrime1 = 2654435761u;
+constexpr uint32_t kXxPrime2 = 2246822519u;
+constexpr uint32_t kXxPrime3 = 3266489917u;
+constexpr uint32_t kXxPrime4 = 668265263u;
+constexpr uint32_t kXxPrime5 = 374761393u;
+
+inline uint32_t Rotl32(uint32_t v, int r) {
+  return (v << r) | (v >> (32 - r));
+}
+
+inline uint32_t XxRound(uint32_t acc, uint32_t input) {
+  acc += input * kXxPrime2;
+  return Rotl32(acc, 13) * kXxPrime1;
+}
+
+inline uint64_t LoadLe64(const uint8_t* p) {
+  return static_cast<uint64_t>(LoadLe32(p)) |
+         (static_cast<uint64_t>(LoadLe32(p + 4)) << 32);
+}
+
+inline uint64_t Rotl64(uint64_t v, int r) {
+  return (v << r) | (v >> (64 - r));
+}
+
+inline uint64_t ByteSwap64(uint64_t v) {
+  v = ((v & 0x00FF00FF00FF00FFull) << 8) | ((v >> 8) & 0x00FF00FF00FF00FFull);
+  v = ((v & 0x0000FFFF0000FFFFull) << 16) |
+      ((v >> 16) & 0x0000FFFF0000FFFFull);
+  return (v << 32) | (v >> 32);
+}
+
+constexpr uint64_t kXx3Prime32_1 = 0x9E3779B1u;
+constexpr uint64_t kXx3Prime32_2 = 0x85EBCA77u;
+constexpr uint64_t kXx3Prime32_3 = 0xC2B2AE3Du;
+constexpr uint64_t kXx3Prime64_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kXx3Prime64_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kXx3Prime64_3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kXx3Prime64_4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t kXx3Prime64_5 = 0x27D4EB2F165667C5ull;
+constexpr uint64_t kXx3PrimeMx1 = 0x165667919E3779F9ull;
+constexpr uint64_t kXx3PrimeMx2 = 0x9FB21C651E98DF25ull;
+
+constexpr size_t kXx3StripeLen = 64;
+constexpr size_t kXx3SecretSize = 192;
+constexpr size_t kXx3MidSizeMax = 240;
+// Each stripe of a block moves 8 bytes further into the secret.
+constexpr size_t kXx3BlockStripes = (kXx3SecretSize - kXx3StripeLen) / 8;
+
+alignas(64) constexpr uint8_t kXx3Secret[kXx3SecretSize] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+    0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+    0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+    0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+    0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+    0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+    0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+    0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+    0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+    0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+    0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+    0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+    0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+// The 128-bit product of a and b, its halves XORed together.
+inline uint64_t MulFold64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 Uint128;
+  const Uint128 product = static_cast<Uint128>(a) * b;
+  return static_cast<uint64_t>(product) ^
+         static_cast<uint64_t>(product >> 64);
+#else
+  const uint64_t lo_lo = (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu);
+  const uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFFu);
+  const uint64_t lo_hi = (a & 0xFFFFFFFFu) * (b >> 32);
+  const uint64_t hi_hi = (a >> 32) * (b >> 32);
+  const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+  const uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  const uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFFu);
+  return lower ^ upper;
+#endif
+}
+
+inline uint64_t Xx64Avalanche(uint64_t h) {
+  h ^= h >> 33;
+  h *= kXx3Prime64_2;
+  h ^= h >> 29;
+  h *= kXx3Prime64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+inline uint64_t Xx3Avalanche(uint64_t h) {
+  h ^= h >> 37;
+  h *= kXx3PrimeMx1;
+  h ^= h >> 32;
+  return h;
+}
+
+inline uint64_t Xx3Mix16(const uint8_t* input, const uint8_t* secret) {
+  return MulFold64(LoadLe64(input) ^ LoadLe64(secret),
+                   LoadLe64(input + 8) ^ LoadLe64(secret + 8));
+}
+
+// XXH3 of up to 240 bytes, which never touch the stripe kernels.
+uint64_t Xx3HashShort(const uint8_t* input, size_t len) {
+  const uint8_t* const secret = kXx3Secret;
+  if (len == 0) {
+    return Xx64Avalanche(LoadLe64(secret + 56) ^ LoadLe64(secret + 64));
+  }
+  if (len <= 3) {
+    const uint32_t combined = (static_cast<uint32_t>(input[0]) << 16) |
+                              (static_cast<uint32_t>(input[len >> 1]) << 24) |
+                              static_cast<uint32_t>(input[len - 1]) |
+                              (static_cast<uint32_t>(len) << 8);
+    const uint64_t bitflip = LoadLe32(secret) ^ LoadLe32(secret + 4);
+    return Xx64Avalanche(combined ^ bitflip);
+  }
+  if (len <= 8) {
+    const uint64_t bitflip = LoadLe64(secret + 8) ^ LoadLe64(secret + 16);
+    const uint64_t keyed =
+        (LoadLe32(input + len - 4) +
+         (static_cast<uint64_t>(LoadLe32(input)) << 32)) ^
+        bitflip;
+    uint64_t h = keyed ^ Rotl64(keyed, 49) ^ Rotl64(keyed, 24);
+    h *= kXx3PrimeMx2;
+    h ^= (h >> 35) + len;
+    h *= kXx3PrimeMx2;
+    return h ^ (h >> 28);
+  }
+  if (len <= 16) {
+    const uint64_t lo =
+        LoadLe64(input) ^ (LoadLe64(secret + 24) ^ LoadLe64(secret + 32));
+    const uint64_t hi = LoadLe64(input + len - 8) ^
+                        (LoadLe64(secret + 40) ^ LoadLe64(secret + 48));
+    return Xx3Avalanche(len + ByteSwap64(lo) + hi + MulFold64(lo, hi));
+  }
+  uint64_t acc = len * kXx3Prime64_1;
+  if (len <= 128) {
+    // Pairs of 16-byte lanes from both ends, as many as fit.
+    for (size_t i = 0; i < 4 && len > 32 * i; ++i) {
+      acc += Xx3Mix16(input + 16 * i, secret + 32 * i);
+      acc += Xx3Mix16(input + len - 16 * (i + 1), secret + 32 * i + 16);
+    }
+    return Xx3Avalanche(acc);
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    acc += Xx3Mix16(input + 16 * i, secret + 16 * i);
+  }
+  acc = Xx3Avalanche(acc);
+  for (size_t i = 8; i < len / 16; ++i) {
+    acc += Xx3Mix16(input + 16 * i, secret + 16 * (i - 8) + 3);
+  }
+  // 136 is the smallest secret XXH3 allows.
+  acc += Xx3Mix16(input + len - 16, secret + 136 - 17);
+  return Xx3Avalanche(acc);
+}
+
+// Accumulates |stripes| consecutive 64-byte stripes, the secret moving 8
+// bytes per stripe, with |mask| ORed into each 32-bit word of the input.
+using Xx3AccumulateFn = void (*)(uint64_t* acc, const uint8_t* input,
+                                 size_t stripes, const uint8_t* secret,
+                                 uint32_t mask);
+
+void Xx3AccumulateScalar(uint64_t* acc, const uint8_t* input, size_t stripes,
+                         const uint8_t* secret, uint32_t mask) {
+  const uint64_t mask64 = mask | (static_cast<uint64_t>(mask) << 32);
+  for (; stripes > 0; --stripes) {
+    for (size_t i = 0; i < 8; ++i) {
+      const uint64_t data = LoadLe64(input + 8 * i) | mask64;
+      const uint64_t key = data ^ LoadLe64(secret + 8 * i);
+      acc[i ^ 1] += data;
+      acc[i] += (key & 0xFFFFFFFFu) * (key >> 32);
+    }
+    input += kXx3StripeLen;
+    secret += 8;
+  }
+}
+
+#if SCREENSHOT_ARCH_X86
+// Two 64-bit lanes per register: the 32x32->64 multiply of each keyed lane's
+// halves, plus the neighbouring lane's input.
+void Xx3AccumulateSse2(uint64_t* acc, const uint8_t* input, size_t stripes,
+                       const uint8_t* secret, uint32_t mask) {
+  __m128i* const out = reinterpret_cast<__m128i*>(acc);
+  __m128i a[4];
+  for (int i = 0; i < 4; ++i) a[i] = _mm_loadu_si128(out + i);
+  const __m128i m = _mm_set1_epi32(static_cast<int>(mask));
+  for (; stripes > 0; --stripes) {
+    for (int i = 0; i < 4; ++i) {
+      const __m128i data = _mm_or_si128(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(input) + i), m);
+      const __m128i key = _mm_xor_si128(
+          data, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+      const __m128i product = _mm_mul_epu32(
+          key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+      a[i] = _mm_add_epi64(
+          a[i], _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+      a[i] = _mm_add_epi64(a[i], product);
+    }
+    input += kXx3StripeLen;
+    secret += 8;
+  }
+  for (int i = 0; i < 4; ++i) _mm_storeu_si128(out + i, a[i]);
+}
+
+SCREENSHOT_TARGET_AVX2
+void Xx3AccumulateAvx2(uint64_t* acc, const uint8_t* input, size_t stripes,
+                       const uint8_t* secret, uint32_t mask) {
+  __m256i* const out = reinterpret_cast<__m256i*>(acc);
+  __m256i a[2] = {_mm256_loadu_si256(out), _mm256_loadu_si256(out + 1)};
+  const __m256i m = _mm256_set1_epi32(static_cast<int>(mask));
+  for (; stripes > 0; --stripes) {
+    for (int i = 0; i < 2; ++i) {
+      const __m256i data = _mm256_or_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input) + i), m);
+      const __m256i key = _mm256_xor_si256(
+          data,
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i));
+      const __m256i product = _mm256_mul_epu32(
+          key, _mm256_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+      a[i] = _mm256_add_epi64(
+          a[i], _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+      a[i] = _mm256_add_epi64(a[i], product);
+    }
+    input += kXx3StripeLen;
+    secret += 8;
+  }
+  _mm256_storeu_si256(out, a[0]);
+  _mm256_storeu_si256(out + 1, a[1]);
+}
+#endif  // SCREENSHOT_ARCH_X86
+
+Xx3AccumulateFn PickXx3Accumulate() {
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& features = GetCpuFeatures();
+  if (features.avx2) return Xx3AccumulateAvx2;
+  if (features.sse2) return Xx3AccumulateSse2;
+#endif
+  return Xx3AccumulateScalar;
+}
+
+// Once per 1 KiB block, so it stays scalar.
+void Xx3Scramble(uint64_t* acc) {
+  const uint8_t* const secret = kXx3Secret + kXx3SecretSize - kXx3StripeLen;
+  for (size_t i = 0; i < 8; ++i) {
+    uint64_t a = acc[i];
+    a ^= a >> 47;
+    a ^= LoadLe64(secret + 8 * i);
+    acc[i] = a * kXx3Prime32_1;
+  }
+}
+
+// Accumulates whole stripes, scrambling at each block end.
+void Xx3ConsumeStripes(uint64_t* acc, size_t* block_stripes,
+                       const uint8_t* input, size_t stripes, uint32_t mask) {
+  const Xx3AccumulateFn accumulate = PickXx3Accumulate();
+  while (stripes > 0) {
+    size_t n = kXx3BlockStripes - *block_stripes;
+    if (n > stripes) n = stripes;
+    accumulate(acc, input, n, kXx3Secret + *block_stripes * 8, mask);
+    input += n * kXx3StripeLen;
+    stripes -= n;
+    *block_stripes += n;
+    if (*block_stripes == kXx3BlockStripes) {
+      Xx3Scramble(acc);
+      *block_stripes = 0;
+    }
+  }
+}
+
+uint64_t Xx3MergeAccs(const uint64_t* acc, uint64_t len) {
+  const uint8_t* const secret = kXx3Secret + 11;
+  uint64_t result = len * kXx3Prime64_1;
+  for (size_t i = 0; i < 4; ++i) {
+    result += MulFold64(acc[2 * i] ^ LoadLe64(secret + 16 * i),
+                        acc[2 * i + 1] ^ LoadLe64(secret + 16 * i + 8));
+  }
+  return Xx3Avalanche(result);
+}
+
+// memcpy with |mask| ORed into each little-endian 32-bit word.
+void CopyMasked(uint8_t* dst, const uint8_t* src, size_t len, uint32_t mask) {
+  if (mask == 0) {
+    std::memcpy(dst, src, len);
+    return;
+  }
+  const uint8_t m[4] = {static_cast<uint8_t>(mask),
+                        static_cast<uint8_t>(mask >> 8),
+                        static_cast<uint8_t>(mask >> 16),
+                        static_cast<uint8_t>(mask >> 24)};
+  for (size_t i = 0; i < len; ++i) dst[i] = src[i] | m[i & 3];
+}
+
+const CrcTables& GetCrcTables() {
+  static const CrcTables tables;
+  return tables;
+}
+
+// |crc| is the raw register (already inverted by the caller).
+uint32_t Crc32Scalar(uint32_t crc, const uint8_t* data, size_t len) {
+  const CrcTables& tables = GetCrcTables();
+  const auto& t = tables.t;
+  while (len >= 8) {
+    const uint32_t one = LoadLe32(data) ^ crc;
+    const uint32_t two = LoadLe32(data + 4);
+    crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^
+          t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^ t[3][two & 0xFF] ^
+          t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+    data += 8;
+    len -= 8;
+  }
+  while (len--) {
+    crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#if SCREENSHOT_ARCH_X86
+// Folds four 128-bit lanes at a time with carry-less multiplication, then
+// Barrett-reduces to 32 bits. Constants are x^(k) mod P(x) for the reflected
+// CRC-32 polynomial (see Intel's "Fast CRC Computation for Generic Polynomials
+// Using PCLMULQDQ Instruction"). Requires len >= 64 and len % 16 == 0.
+SCREENSHOT_TARGET_PCLMUL
+uint32_t Crc32Pclmul(uint32_t crc, const uint8_t* data, size_t len) {
+  alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+  alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+  alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+  alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+  x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+  x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+  x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+  x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+  data += 64;
+  len -= 64;
+
+  while (len >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+    y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+    y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+    y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+    data += 64;
+    len -= 64;
+  }
+
+  // Fold the four lanes into one.
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  // Remaining whole 16-byte blocks.
+  while (len >= 16) {
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    data += 16;
+    len -= 16;
+  }
+
+  // 128 -> 64 bits.
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+  x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett reduction to 32 bits.
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+#endif  // SCREENSHOT_ARCH_X86
+
+uint32_t Adler32Scalar(uint32_t adler, const uint8_t* data, size_t len) {
+  uint32_t s1 = adler & 0xFFFF;
+  uint32_t s2 = adler >> 16;
+  while (len > 0) {
+    size_t n = len < kAdlerNmax ? len : kAdlerNmax;
+    len -= n;
+    while (n >= 16) {
+      for (int i = 0; i < 16; ++i) {
+        s1 += data[i];
+        s2 += s1;
+      }
+      data += 16;
+      n -= 16;
+    }
+    while (n--) {
+      s1 += *data++;
+      s2 += s1;
+    }
+    s1 %= kAdlerBase;
+    s2 %= kAdlerBase;
+  }
+  return s1 | (s2 << 16);
+}
+
+#if SCREENSHOT_ARCH_X86
+// Sums 32-byte blocks: s1 with SAD against zero, s2 with a multiply-add by
+// the descending byte weights 32..1.
+SCREENSHOT_TARGET_SSSE3
+uint32_t Adler32Ssse3(uint32_t adler, const uint8_t* data, size_t len) {
+  constexpr size_t kBlockSize = 32;
+  uint32_t s1 = adler & 0xFFFF;
+  uint32_t s2 = adler >> 16;
+
+  size_t blocks = len / kBlockSize;
+  len -= blocks * kBlockSize;
+
+  const __m128i tap1 =
+      _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18,
+                    17);
+  const __m128i tap2 =
+      _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+
+  while (blocks > 0) {
+    size_t n = kAdlerNmax / kBlockSize;
+    if (n > blocks) n = blocks;
+    blocks -= n;
+
+    // v_ps accumulates s1 at the start of each block; every block adds it
+    // 32 times to s2.
+    __m128i v_ps = _mm_set_epi32(0, 0, 0, static_cast<int>(s1 * n));
+    __m128i v_s2 = _mm_set_epi32(0, 0, 0, static_cast<int>(s2));
+    __m128i v_s1 = _mm_setzero_si128();
+    do {
+      const __m128i bytes1 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+      const __m128i bytes2 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+      v_ps = _mm_add_epi32(v_ps, v_s1);
+      v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+      v_s2 = _mm_add_epi32(
+          v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+      v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+      v_s2 = _mm_add_epi32(
+          v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+      data += kBlockSize;
+    } while (--n);
+
+    v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+    v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+    v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+    s1 += static_cast<uint32_t>(_mm_cvtsi128_si32(v_s1));
+    v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+    v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+    s2 = static_cast<uint32_t>(_mm_cvtsi128_si32(v_s2));
+
+    s1 %= kAdlerBase;
+    s2 %= kAdlerBase;
+  }
+
+  return Adler32Scalar(s1 | (s2 << 16), data, len);
+}
+#endif  // SCREENSHOT_ARCH_X86
+
+}  // namespace
+
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+#if SCREENSHOT_ARCH_X86
+  if (len >= 64 && GetCpuFeatures().pclmul) {
+    const size_t chunk = len & ~static_cast<size_t>(15);
+    crc = Crc32Pclmul(crc, data, chunk);
+    data += chunk;
+    len -= chunk;
+  }
+#endif
+  return ~Crc32Scalar(crc, data, len);
+}
+
+uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t len) {
+#if SCREENSHOT_ARCH_X86
+  if (len >= 64 && GetCpuFeatures().ssse3) {
+    return Adler32Ssse3(adler, data, len);
+  }
+#endif
+  return Adler32Scalar(adler, data, len);
+}
+
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t len2) {
+  const uint64_t rem = len2 % kAdlerBase;
+  uint64_t sum1 = adler1 & 0xFFFF;
+  uint64_t sum2 = (rem * sum1) % kAdlerBase;
+  sum1 += (adler2 & 0xFFFF) + kAdlerBase - 1;
+  sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + kAdlerBase -
+          rem;
+  if (sum1 >= kAdlerBase) sum1 -= kAdlerBase;
+  if (sum1 >= kAdlerBase) sum1 -= kAdlerBase;
+  if (sum2 >= (static_cast<uint64_t>(kAdlerBase) << 1)) {
+    sum2 -= static_cast<uint64_t>(kAdlerBase) << 1;
+  }
+  if (sum2 >= kAdlerBase) sum2 -= kAdlerBase;
+  return static_cast<uint32_t>(sum1 | (sum2 << 16));
+}
+
+uint32_t XxHash32(const uint8_t* data, size_t len, uint32_t seed) {
+  const uint8_t* p = data;
+  const uint8_t* const end = data + len;
+  uint32_t h;
+  if (len >= 16) {
+    uint32_t v1 = seed + kXxPrime1 + kXxPrime2;
+    uint32_t v2 = seed + kXxPrime2;
+    uint32_t v3 = seed;
+    uint32_t v4 = seed - kXxPrime1;
+    const uint8_t* const limit = end - 16;
+    do {
+      v1 = XxRound(v1, LoadLe32(p));
+      v2 = XxRound(v2, LoadLe32(p + 4));
+      v3 = XxRound(v3, LoadLe32(p + 8));
+      v4 = XxRound(v4, LoadLe32(p + 12));
+      p += 16;
+    } while (p <= limit);
+    h = Rotl32(v1, 1) + Rotl32(v2, 7) + Rotl32(v3, 12) + Rotl32(v4, 18);
+  } else {
+    h = seed + kXxPrime5;
+  }
+  h += static_cast<uint32_t>(len);
+  for (; p + 4 <= end; p += 4) {
+    h = Rotl32(h + LoadLe32(p) * kXxPrime3, 17) * kXxPrime4;
+  }
+  for (; p < end; ++p) {
+    h = Rotl32(h + *p * kXxPrime5, 11) * kXxPrime1;
+  }
+  h ^= h >> 15;
+  h *= kXxPrime2;
+  h ^= h >> 13;
+  h *= kXxPrime3;
+  h ^= h >> 16;
+  return h;
+}
+
+uint64_t XxHash3(const uint8_t* data, size_t len) {
+  if (len <= kXx3MidSizeMax) return Xx3HashShort(data, len);
+  XxHash3Stream stream;
+  stream.Update(data, len);
+  return stream.Digest();
+}
+
+XxHash3Stream::XxHash3Stream(uint32_t word_mask) : mask_(word_mask) {
+  Reset();
+}
+
+void XxHash3Stream::Reset() {
+  const uint64_t init[8] = {kXx3Prime32_3, kXx3Prime64_1, kXx3Prime64_2,
+                            kXx3Prime64_3, kXx3Prime64_4, kXx3Prime32_2,
+                            kXx3Prime64_5, kXx3Prime32_1};
+  std::memcpy(acc_, init, sizeof(acc_));
+  block_stripes_ = 0;
+  total_len_ = 0;
+  buffered_ = 0;
+}
+
+void XxHash3Stream::Update(const uint8_t* data, size_t len) {
+  total_len_ += len;
+  if (len <= kBufferSize - buffered_) {
+    CopyMasked(buffer_ + buffered_, data, len, mask_);
+    buffered_ += len;
+    return;
+  }
+  // The buffer is only consumed once more input follows it, so at least one
+  // byte is always left for Digest().
+  if (buffered_ > 0) {
+    const size_t fill = kBufferSize - buffered_;
+    CopyMasked(buffer_ + buffered_, data, fill, mask_);
+    data += fill;
+    len -= fill;
+    Xx3ConsumeStripes(acc_, &block_stripes_, buffer_,
+                      kBufferSize / kXx3StripeLen, 0);
+    buffered_ = 0;
+  }
+  if (len > kBufferSize) {
+    const size_t stripes = (len - 1) / kXx3StripeLen;
+    Xx3ConsumeStripes(acc_, &block_stripes_, data, stripes, mask_);
+    data += stripes * kXx3StripeLen;
+    len -= stripes * kXx3StripeLen;
+    CopyMasked(buffer_ + kBufferSize - kXx3StripeLen, data - kXx3StripeLen,
+               kXx3StripeLen, mask_);
+  }
+  CopyMasked(buffer_, data, len, mask_);
+  buffered_ = len;
+}
+
+uint64_t XxHash3Stream::Digest() const {
+  if (total_len_ <= kXx3MidSizeMax) {
+    return Xx3HashShort(buffer_, static_cast<size_t>(total_len_));
+  }
+  uint64_t acc[8];
+  std::memcpy(acc, acc_, sizeof(acc));
+  size_t block_stripes = block_stripes_;
+  uint8_t last[kXx3StripeLen];
+  const uint8_t* last_stripe = last;
+  if (buffered_ >= kXx3StripeLen) {
+    Xx3ConsumeStripes(acc, &block_stripes, buffer_,
+                      (buffered_ - 1) / kXx3StripeLen, 0);
+    last_stripe = buffer_ + buffered_ - kXx3StripeLen;
+  } else {
+    // The last stripe reaches back into input already accumulated.
+    const size_t catch_up = kXx3StripeLen - buffered_;
+    std::memcpy(last, buffer_ + kBufferSize - catch_up, catch_up);
+    std::memcpy(last + catch_up, buffer_, buffered_);
+  }
+  PickXx3Accumulate()(acc, last_stripe, 1,
+                      kXx3Secret + kXx3SecretSize - kXx3StripeLen - 7, 0);
+  return Xx3MergeAccs(acc, total_len_);
+}
+
+}  // namespace screenshot
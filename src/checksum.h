@@ -0,0 +1,61 @@
+#ifndef SCREENSHOT_CORE_CHECKSUM_H_
+#define SCREENSHOT_CORE_CHECKSUM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace screenshot {
+
+// CRC-32 (ISO-HDLC, as used by PNG chunks and gzip) with zlib semantics: start
+// with crc = 0 and feed the previous result back in to continue a stream.
+// Uses carry-less multiplication (PCLMULQDQ) folding when available.
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t len);
+
+// Adler-32 (the zlib stream checksum). Start with adler = 1.
+uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t len);
+
+// Adler-32 of A followed by B, given adler1 = Adler32(1, A), adler2 =
+// Adler32(1, B) and the length of B. Lets independently checksummed pieces
+// of a stream be combined without another pass over the data.
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t len2);
+
+// XXH32 (xxHash, 32-bit variant), as used by LZ4 frame descriptors and
+// content checksums.
+uint32_t XxHash32(const uint8_t* data, size_t len, uint32_t seed);
+
+// XXH3 (xxHash3, the 64-bit XXH3_64bits variant) with seed 0 and the default
+// secret. Inputs past 240 bytes take 64-byte stripes with SSE2 or AVX2 when
+// available.
+uint64_t XxHash3(const uint8_t* data, size_t len);
+
+// XxHash3 of a stream fed in pieces: Digest() equals XxHash3 of everything
+// passed to Update() since construction or Reset(), however it was split.
+//
+// |word_mask| is ORed into every little-endian 32-bit word as it is read, so
+// 0xFF000000 hashes 32-bit pixels as if their alpha were opaque without
+// writing them. With a mask, every piece must be a whole number of words.
+class XxHash3Stream {
+ public:
+  explicit XxHash3Stream(uint32_t word_mask = 0);
+
+  void Reset();
+  void Update(const uint8_t* data, size_t len);
+  uint64_t Digest() const;
+
+ private:
+  static constexpr size_t kBufferSize = 256;
+
+  uint32_t mask_;
+  uint64_t acc_[8];
+  // Stripes accumulated into the current 1 KiB block.
+  size_t block_stripes_ = 0;
+  uint64_t total_len_ = 0;
+  // Input not yet accumulated; once anything has been, the 64 bytes before
+  // it sit at the end so Digest() can take a full last stripe.
+  uint8_t buffer_[kBufferSize];
+  size_t buffered_ = 0;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_CHECKSUM_H_
@@ -0,0 +1,55 @@
+#include "cpu_features.h"
+
+#if SCREENSHOT_ARCH_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+CpuFeatures DetectCpuFeatures() {
+  CpuFeatures features;
+#if SCREENSHOT_ARCH_X86
+#if defined(_MSC_VER)
+  int info[4] = {};
+  __cpuid(info, 0);
+  const int max_leaf = info[0];
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  features.sse2 = (info[3] & (1 << 26)) != 0;
+  features.ssse3 = (info[2] & (1 << 9)) != 0;
+  features.sse41 = (info[2] & (1 << 19)) != 0;
+  features.pclmul = (info[2] & (1 << 1)) != 0;
+  // AVX2 also needs the OS to save the upper YMM halves on context switch.
+  if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+    __cpuidex(info, 7, 0);
+    features.avx2 = (info[1] & (1 << 5)) != 0;
+  }
+#else
+  __builtin_cpu_init();
+  features.sse2 = __builtin_cpu_supports("sse2");
+  features.ssse3 = __builtin_cpu_supports("ssse3");
+  features.sse41 = __builtin_cpu_supports("sse4.1");
+  features.avx2 = __builtin_cpu_supports("avx2");
+  features.pclmul = __builtin_cpu_supports("pclmul");
+#endif
+#endif
+  return features;
+}
+
+const CpuFeatures* g_override = nullptr;
+
+}  // namespace
+
+const CpuFeatures& GetCpuFeatures() {
+  static const CpuFeatures detected = DetectCpuFeatures();
+  return g_override ? *g_override : detected;
+}
+
+void OverrideCpuFeaturesForTesting(const CpuFeatures* features) {
+  g_override = features;
+}
+
+}  // namespace screenshot
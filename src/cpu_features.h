@@ -0,0 +1,52 @@
+#ifndef SCREENSHOT_CORE_CPU_FEATURES_H_
+#define SCREENSHOT_CORE_CPU_FEATURES_H_
+
+// Runtime CPU feature detection and the macros used to compile SIMD kernels
+// without raising the baseline instruction set of the whole library.
+//
+// Kernels for an instruction set are guarded by SCREENSHOT_ARCH_X86 and marked
+// with the matching SCREENSHOT_TARGET_* attribute; callers pick one at run
+// time from GetCpuFeatures(). MSVC accepts any intrinsic without flags, so the
+// attributes expand to nothing there.
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || \
+    defined(__i386__)
+#define SCREENSHOT_ARCH_X86 1
+#else
+#define SCREENSHOT_ARCH_X86 0
+#endif
+
+#if SCREENSHOT_ARCH_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SCREENSHOT_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define SCREENSHOT_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SCREENSHOT_TARGET_AVX2 __attribute__((target("avx2")))
+#define SCREENSHOT_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#else
+#define SCREENSHOT_TARGET_SSSE3
+#define SCREENSHOT_TARGET_SSE41
+#define SCREENSHOT_TARGET_AVX2
+#define SCREENSHOT_TARGET_PCLMUL
+#endif
+
+namespace screenshot {
+
+struct CpuFeatures {
+  bool sse2 = false;
+  bool ssse3 = false;
+  bool sse41 = false;
+  bool avx2 = false;
+  bool pclmul = false;
+};
+
+// Features of the host CPU, detected once. Honors
+// OverrideCpuFeaturesForTesting.
+const CpuFeatures& GetCpuFeatures();
+
+// Forces the dispatchers onto a subset of the detected features so tests can
+// compare every kernel against the scalar reference. Pass nullptr to restore
+// detection. Not thread-safe; call only while no kernels are running.
+void OverrideCpuFeaturesForTesting(const CpuFeatures* features);
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_CPU_FEATURES_H_
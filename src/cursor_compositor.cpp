@@ -0,0 +1,309 @@
+#include "cursor_compositor.h"
+
+#include <algorithm>
+
+#include "cpu_features.h"
+#include "image.h"
+#include "image_rect.h"
+
+#if SCREENSHOT_ARCH_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+bool MaskBit(const uint8_t* row, int x) {
+  return (row[x / 8] >> (7 - x % 8)) & 1;
+}
+
+void ResetCursor(CursorImage* cursor) {
+  cursor->width = 0;
+  cursor->height = 0;
+  cursor->hotspot_x = 0;
+  cursor->hotspot_y = 0;
+  cursor->pixels.clear();
+  cursor->xor_mask.clear();
+}
+
+// Sizes |cursor| for |width| x |height| pixels, all transparent, with room
+// for an XOR mask the decoder drops again if nothing is XORed.
+void AllocateCursor(int width, int height, CursorImage* cursor) {
+  const size_t bytes = static_cast<size_t>(width) *
+                       static_cast<size_t>(height) * kBytesPerPixel;
+  cursor->width = width;
+  cursor->height = height;
+  cursor->pixels.assign(bytes, 0);
+  cursor->xor_mask.assign(bytes, 0);
+}
+
+void DropUnusedXorMask(CursorImage* cursor) {
+  const std::vector<uint8_t>& mask = cursor->xor_mask;
+  if (std::all_of(mask.begin(), mask.end(),
+                  [](uint8_t b) { return b == 0; })) {
+    cursor->xor_mask.clear();
+  }
+}
+
+void BlendScalar(const uint8_t* src, const uint8_t* xor_mask, uint8_t* dst,
+                 size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i) {
+    const int inverse = 255 - src[3];
+    for (int c = 0; c < 4; ++c) {
+      const int value = src[c] + (dst[c] * inverse + 127) / 255;
+      dst[c] = static_cast<uint8_t>(std::min(value, 255));
+      if (xor_mask) dst[c] ^= xor_mask[c];
+    }
+    src += kBytesPerPixel;
+    dst += kBytesPerPixel;
+    if (xor_mask) xor_mask += kBytesPerPixel;
+  }
+}
+
+#if SCREENSHOT_ARCH_X86
+// p / 255, rounded, for 16-bit products of two bytes: exact over
+// [0, 255 * 255] without a division.
+inline __m128i DivideBy255Sse2(__m128i p) {
+  p = _mm_add_epi16(p, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(p, _mm_srli_epi16(p, 8)), 8);
+}
+
+// Four pixels at a time. Cursors are mostly transparent, so groups with
+// nothing to blend or XOR are skipped without touching |dst|. Saturating
+// adds keep a cursor that is not properly premultiplied from wrapping.
+size_t BlendSse2(const uint8_t* src, const uint8_t* xor_mask, uint8_t* dst,
+                 size_t pixels) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 4 <= pixels; i += 4) {
+    const __m128i s =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+    const __m128i x = xor_mask ? _mm_loadu_si128(
+                                     reinterpret_cast<const __m128i*>(
+                                         xor_mask + i * 4))
+                               : zero;
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(s, x), zero)) ==
+        0xFFFF) {
+      continue;
+    }
+    __m128i* p = reinterpret_cast<__m128i*>(dst + i * 4);
+    const __m128i d = _mm_loadu_si128(p);
+    // 255 - alpha in every byte of its pixel.
+    __m128i a = _mm_srli_epi32(s, 24);
+    a = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+    a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+    const __m128i inverse = _mm_xor_si128(a, ones);
+    const __m128i lo = DivideBy255Sse2(_mm_mullo_epi16(
+        _mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(inverse, zero)));
+    const __m128i hi = DivideBy255Sse2(_mm_mullo_epi16(
+        _mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(inverse, zero)));
+    const __m128i out = _mm_adds_epu8(_mm_packus_epi16(lo, hi), s);
+    _mm_storeu_si128(p, _mm_xor_si128(out, x));
+  }
+  return i;
+}
+
+SCREENSHOT_TARGET_AVX2
+inline __m256i DivideBy255Avx2(__m256i p) {
+  p = _mm256_add_epi16(p, _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(p, _mm256_srli_epi16(p, 8)), 8);
+}
+
+// BlendSse2 eight pixels at a time. Unpacking and packing stay within each
+// 128-bit lane, so the pixels come back in order.
+SCREENSHOT_TARGET_AVX2
+size_t BlendAvx2(const uint8_t* src, const uint8_t* xor_mask, uint8_t* dst,
+                 size_t pixels) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    const __m256i s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+    const __m256i x = xor_mask ? _mm256_loadu_si256(
+                                     reinterpret_cast<const __m256i*>(
+                                         xor_mask + i * 4))
+                               : zero;
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_or_si256(s, x),
+                                               zero)) == -1) {
+      continue;
+    }
+    __m256i* p = reinterpret_cast<__m256i*>(dst + i * 4);
+    const __m256i d = _mm256_loadu_si256(p);
+    __m256i a = _mm256_srli_epi32(s, 24);
+    a = _mm256_or_si256(a, _mm256_slli_epi32(a, 8));
+    a = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+    const __m256i inverse = _mm256_xor_si256(a, ones);
+    const __m256i lo = DivideBy255Avx2(_mm256_mullo_epi16(
+        _mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(inverse, zero)));
+    const __m256i hi = DivideBy255Avx2(_mm256_mullo_epi16(
+        _mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(inverse, zero)));
+    const __m256i out = _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), s);
+    _mm256_storeu_si256(p, _mm256_xor_si256(out, x));
+  }
+  return i;
+}
+#endif  // SCREENSHOT_ARCH_X86
+
+}  // namespace
+
+bool DecodeColorCursor(const uint8_t* bgra, const uint8_t* and_mask,
+                       int width, int height, CursorImage* cursor) {
+  ResetCursor(cursor);
+  if (bgra == nullptr || width <= 0 || height <= 0) return false;
+  const size_t count =
+      static_cast<size_t>(width) * static_cast<size_t>(height);
+  bool has_alpha = false;
+  for (size_t i = 0; i < count && !has_alpha; ++i) {
+    has_alpha = bgra[i * kBytesPerPixel + 3] != 0;
+  }
+  AllocateCursor(width, height, cursor);
+  const size_t mask_stride = CursorMaskStride(width);
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* mask_row =
+        and_mask ? and_mask + static_cast<size_t>(y) * mask_stride : nullptr;
+    for (int x = 0; x < width; ++x) {
+      const size_t at =
+          (static_cast<size_t>(y) * static_cast<size_t>(width) +
+           static_cast<size_t>(x)) *
+          kBytesPerPixel;
+      const uint8_t* in = bgra + at;
+      uint8_t* out = cursor->pixels.data() + at;
+      if (has_alpha) {
+        const int alpha = in[3];
+        for (int c = 0; c < 3; ++c) {
+          out[c] = static_cast<uint8_t>((in[c] * alpha + 127) / 255);
+        }
+        out[3] = in[3];
+      } else if (mask_row && MaskBit(mask_row, x)) {
+        // (screen AND 1) XOR color: leave the pixel transparent and XOR
+        // the color in afterwards, alpha untouched.
+        uint8_t* flip = cursor->xor_mask.data() + at;
+        flip[0] = in[0];
+        flip[1] = in[1];
+        flip[2] = in[2];
+      } else {
+        out[0] = in[0];
+        out[1] = in[1];
+        out[2] = in[2];
+        out[3] = 0xFF;
+      }
+    }
+  }
+  DropUnusedXorMask(cursor);
+  return true;
+}
+
+bool DecodeMonochromeCursor(const uint8_t* mask, int width, int height,
+                            CursorImage* cursor) {
+  ResetCursor(cursor);
+  if (mask == nullptr || width <= 0 || height <= 0) return false;
+  AllocateCursor(width, height, cursor);
+  const size_t mask_stride = CursorMaskStride(width);
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* and_row = mask + static_cast<size_t>(y) * mask_stride;
+    const uint8_t* xor_row =
+        mask + static_cast<size_t>(height + y) * mask_stride;
+    for (int x = 0; x < width; ++x) {
+      const size_t at =
+          (static_cast<size_t>(y) * static_cast<size_t>(width) +
+           static_cast<size_t>(x)) *
+          kBytesPerPixel;
+      const bool and_bit = MaskBit(and_row, x);
+      const bool xor_bit = MaskBit(xor_row, x);
+      if (!and_bit) {
+        // Black or white, opaque.
+        const uint8_t value = xor_bit ? 0xFF : 0x00;
+        uint8_t* out = cursor->pixels.data() + at;
+        out[0] = out[1] = out[2] = value;
+        out[3] = 0xFF;
+      } else if (xor_bit) {
+        uint8_t* flip = cursor->xor_mask.data() + at;
+        flip[0] = flip[1] = flip[2] = 0xFF;
+      }
+    }
+  }
+  DropUnusedXorMask(cursor);
+  return true;
+}
+
+void BlendCursorRow(const uint8_t* src, const uint8_t* xor_mask,
+                    uint8_t* dst, size_t pixels) {
+  size_t done = 0;
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& cpu = GetCpuFeatures();
+  if (cpu.avx2) {
+    done = BlendAvx2(src, xor_mask, dst, pixels);
+  } else if (cpu.sse2) {
+    done = BlendSse2(src, xor_mask, dst, pixels);
+  }
+#endif
+  const size_t offset = done * kBytesPerPixel;
+  BlendScalar(src + offset, xor_mask ? xor_mask + offset : nullptr,
+              dst + offset, pixels - done);
+}
+
+void CompositeCursor(const CursorImage& cursor, int x, int y, uint8_t* frame,
+                     int width, int height, size_t stride) {
+  if (cursor.IsEmpty() || frame == nullptr) return;
+  const PixelRect area =
+      IntersectRects(PixelRect{x, y, cursor.width, cursor.height},
+                     PixelRect{0, 0, width, height});
+  if (area.IsEmpty()) return;
+  const size_t cursor_stride =
+      static_cast<size_t>(cursor.width) * kBytesPerPixel;
+  const size_t skip = static_cast<size_t>(area.x - x) * kBytesPerPixel;
+  const bool has_xor = !cursor.xor_mask.empty();
+  for (int row = area.y; row < area.bottom(); ++row) {
+    const size_t at = static_cast<size_t>(row - y) * cursor_stride + skip;
+    BlendCursorRow(cursor.pixels.data() + at,
+                   has_xor ? cursor.xor_mask.data() + at : nullptr,
+                   frame + static_cast<size_t>(row) * stride +
+                       static_cast<size_t>(area.x) * kBytesPerPixel,
+                   static_cast<size_t>(area.width));
+  }
+}
+
+const CursorImage* CursorCache::Find(uint64_t key) {
+  for (Entry& entry : entries_) {
+    if (entry.key == key) {
+      entry.last_used = ++clock_;
+      return &entry.image;
+    }
+  }
+  return nullptr;
+}
+
+CursorImage* CursorCache::Insert(uint64_t key) {
+  Entry* slot = nullptr;
+  for (Entry& entry : entries_) {
+    if (entry.key == key) slot = &entry;
+  }
+  if (slot == nullptr && entries_.size() < kCapacity) {
+    // Never reallocated, so images handed out earlier do not move.
+    entries_.reserve(kCapacity);
+    entries_.emplace_back();
+    slot = &entries_.back();
+  }
+  if (slot == nullptr) {
+    slot = &*std::min_element(entries_.begin(), entries_.end(),
+                              [](const Entry& a, const Entry& b) {
+                                return a.last_used < b.last_used;
+                              });
+  }
+  slot->key = key;
+  slot->last_used = ++clock_;
+  // Keeps the vectors' capacity for the next cursor of the same size.
+  ResetCursor(&slot->image);
+  return &slot->image;
+}
+
+void CursorCache::Clear() {
+  entries_.clear();
+  clock_ = 0;
+}
+
+}  // namespace screenshot
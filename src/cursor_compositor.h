@@ -0,0 +1,102 @@
+#ifndef SCREENSHOT_CORE_CURSOR_COMPOSITOR_H_
+#define SCREENSHOT_CORE_CURSOR_COMPOSITOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace screenshot {
+
+// A cursor decoded once and composited onto many captures.
+//
+// |pixels| are premultiplied BGRA rows, width * 4 bytes apart. Cursors that
+// invert what is under them (the I-beam, monochrome cursors) also carry an
+// |xor_mask| of the same size, XORed into the frame after the blend;
+// elsewhere it is empty. The hotspot is the pixel that sits at the pointer
+// position.
+struct CursorImage {
+  int width = 0;
+  int height = 0;
+  int hotspot_x = 0;
+  int hotspot_y = 0;
+  std::vector<uint8_t> pixels;
+  std::vector<uint8_t> xor_mask;
+
+  bool IsEmpty() const { return width <= 0 || height <= 0; }
+};
+
+// Bytes per row of a 1-bit mask |width| pixels wide: rows are padded to 32
+// bits, as GetDIBits writes them. Bits are most significant first.
+inline size_t CursorMaskStride(int width) {
+  return static_cast<size_t>((width + 31) / 32) * 4;
+}
+
+// Decodes a color cursor: |bgra| is |width| x |height| top-down BGRA with
+// straight alpha, |and_mask| its 1-bit AND mask (may be null). Cursors with
+// any alpha are blended by alpha and the mask is ignored, as DrawIconEx
+// does; cursors without alpha are opaque where the mask is clear and XOR
+// their color into the screen where it is set. The hotspot is left at 0.
+// Returns false, leaving |cursor| empty, if the size is invalid.
+bool DecodeColorCursor(const uint8_t* bgra, const uint8_t* and_mask,
+                       int width, int height, CursorImage* cursor);
+
+// Decodes a monochrome cursor from its mask bitmap: 2 * |height| rows, the
+// AND mask over the XOR mask. Per pixel (AND, XOR): (0, 0) is black, (0, 1)
+// white, (1, 0) transparent and (1, 1) inverts the screen. The hotspot is
+// left at 0. Returns false, leaving |cursor| empty, if the size is invalid.
+bool DecodeMonochromeCursor(const uint8_t* mask, int width, int height,
+                            CursorImage* cursor);
+
+// Blends |pixels| premultiplied pixels of |src| over |dst|,
+// dst = src + dst * (255 - src alpha) / 255 rounded, then XORs in
+// |xor_mask| if it is not null. Every channel, alpha included, is blended.
+void BlendCursorRow(const uint8_t* src, const uint8_t* xor_mask,
+                    uint8_t* dst, size_t pixels);
+
+// Composites |cursor| onto the |width| x |height| BGRA |frame| (rows
+// |stride| bytes apart) with its top left at (|x|, |y|), clipped to the
+// frame.
+void CompositeCursor(const CursorImage& cursor, int x, int y, uint8_t* frame,
+                     int width, int height, size_t stride);
+
+// The last few cursors decoded, by the handle (or serial) the platform
+// identifies them with, so a cursor is decoded when it changes instead of
+// on every capture. Images that failed to decode stay cached empty, so a
+// broken cursor is not retried every frame either.
+//
+// Use from one thread at a time.
+class CursorCache {
+ public:
+  static constexpr size_t kCapacity = 8;
+
+  CursorCache() = default;
+
+  CursorCache(const CursorCache&) = delete;
+  CursorCache& operator=(const CursorCache&) = delete;
+
+  // The cursor cached under |key|, or nullptr. The image stays where it is
+  // until Insert() replaces it or Clear().
+  const CursorImage* Find(uint64_t key);
+
+  // An empty image to decode the cursor |key| into, replacing the least
+  // recently used entry once the cache is full.
+  CursorImage* Insert(uint64_t key);
+
+  void Clear();
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    uint64_t key = 0;
+    uint64_t last_used = 0;
+    CursorImage image;
+  };
+
+  std::vector<Entry> entries_;
+  uint64_t clock_ = 0;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_CURSOR_COMPOSITOR_H_
@@ -0,0 +1,697 @@
+#include "deflate.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+constexpr uint32_t kWindowSize = 32768;
+constexpr uint32_t kWindowMask = kWindowSize - 1;
+// One less than the format allows so a candidate's prev_ slot can never have
+// been overwritten by a newer position sharing the same ring index.
+constexpr uint32_t kMaxDistance = kWindowSize - 1;
+constexpr uint32_t kMinMatch = 4;
+constexpr uint32_t kMaxMatch = 258;
+constexpr int kHashBits = 16;
+constexpr size_t kHashSize = size_t{1} << kHashBits;
+constexpr size_t kBlockTokens = size_t{1} << 15;
+// Lazy matching may emit a run of literals before it settles on a match; no
+// more than one per possible match length.
+constexpr size_t kTokenSlack = kMaxMatch + 2;
+constexpr size_t kMaxStoredBlock = 65535;
+
+constexpr int kLitLenCodes = 286;
+constexpr int kDistCodes = 30;
+constexpr int kCodeLengthCodes = 19;
+constexpr int kMaxCodeBits = 15;
+constexpr int kMaxCodeLengthBits = 7;
+constexpr int kEndOfBlock = 256;
+
+struct LevelParams {
+  uint32_t max_chain;    // Hash chain entries examined per position.
+  uint32_t nice_length;  // Stop searching once a match this long is found.
+  uint32_t lazy_length;  // Look one byte ahead for matches shorter than this;
+                         // 0 means greedy.
+  uint32_t max_insert;   // Longer matches only hash their first position.
+};
+
+constexpr LevelParams kLevels[DeflateEncoder::kMaxLevel + 1] = {
+    {0, 0, 0, 0},                                  // 0: stored
+    {2, 16, 0, 8},                                 // 1
+    {4, 32, 0, 16},                                // 2
+    {8, 64, 0, 32},                                // 3
+    {16, 128, 16, kMaxMatch},                      // 4
+    {32, 128, 32, kMaxMatch},                      // 5
+    {128, kMaxMatch, 128, kMaxMatch},              // 6
+    {256, kMaxMatch, kMaxMatch, kMaxMatch},        // 7
+    {1024, kMaxMatch, kMaxMatch, kMaxMatch},       // 8
+    {4096, kMaxMatch, kMaxMatch, kMaxMatch},       // 9
+};
+
+constexpr uint16_t kLengthBase[29] = {3,  4,  5,  6,   7,   8,   9,   10,
+                                      11, 13, 15, 17,  19,  23,  27,  31,
+                                      35, 43, 51, 59,  67,  83,  99,  115,
+                                      131, 163, 195, 227, 258};
+constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                      1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                      4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistBase[kDistCodes] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,    25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513,   769,
+    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+constexpr uint8_t kDistExtra[kDistCodes] = {0, 0, 0,  0,  1,  1,  2,  2,
+                                            3, 3, 4,  4,  5,  5,  6,  6,
+                                            7, 7, 8,  8,  9,  9,  10, 10,
+                                            11, 11, 12, 12, 13, 13};
+constexpr uint8_t kCodeLengthOrder[kCodeLengthCodes] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// Maps a match length (3..258) to its index in kLengthBase.
+struct LengthTable {
+  uint8_t index[kMaxMatch + 1] = {};
+
+  LengthTable() {
+    for (uint8_t code = 0; code < 28; ++code) {
+      const uint32_t span = 1u << kLengthExtra[code];
+      for (uint32_t i = 0; i < span; ++i) {
+        const uint32_t length = kLengthBase[code] + i;
+        if (length <= kMaxMatch) index[length] = code;
+      }
+    }
+    index[kMaxMatch] = 28;
+  }
+};
+
+const LengthTable& GetLengthTable() {
+  static const LengthTable table;
+  return table;
+}
+
+inline uint32_t LoadLe32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t Load64(const uint8_t* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline int FloorLog2(uint32_t v) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse(&index, v);
+  return static_cast<int>(index);
+#else
+  return 31 - __builtin_clz(v);
+#endif
+}
+
+inline int CountTrailingZeros64(uint64_t v) {
+#if defined(_MSC_VER)
+  unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+  _BitScanForward64(&index, v);
+  return static_cast<int>(index);
+#else
+  if (static_cast<uint32_t>(v) != 0) {
+    _BitScanForward(&index, static_cast<uint32_t>(v));
+    return static_cast<int>(index);
+  }
+  _BitScanForward(&index, static_cast<uint32_t>(v >> 32));
+  return static_cast<int>(index) + 32;
+#endif
+#else
+  return __builtin_ctzll(v);
+#endif
+}
+
+inline int DistanceCode(uint32_t distance) {
+  if (distance <= 4) return static_cast<int>(distance) - 1;
+  const uint32_t v = distance - 1;
+  const int bits = FloorLog2(v);
+  return 2 * bits + static_cast<int>((v >> (bits - 1)) & 1);
+}
+
+inline uint32_t Hash4(const uint8_t* p) {
+  return (LoadLe32(p) * 0x9E3779B1u) >> (32 - kHashBits);
+}
+
+// Length of the common prefix of |a| and |b|, at most |max_len|. Compares
+// eight bytes at a time; the first differing byte is the lowest set byte of
+// the XOR on little-endian targets.
+inline uint32_t MatchLength(const uint8_t* a, const uint8_t* b,
+                            uint32_t max_len) {
+  uint32_t len = 0;
+  while (len + 8 <= max_len) {
+    const uint64_t diff = Load64(a + len) ^ Load64(b + len);
+    if (diff != 0) {
+      return len + static_cast<uint32_t>(CountTrailingZeros64(diff) >> 3);
+    }
+    len += 8;
+  }
+  while (len < max_len && a[len] == b[len]) ++len;
+  return len;
+}
+
+// Computes length-limited Huffman code lengths for |n| symbols. Uses the
+// in-place Moffat-Katajainen construction, then rebalances lengths above
+// |max_bits| while keeping the code complete (the approach miniz uses).
+// Symbols with zero frequency get length 0; at least two symbols always get
+// codes so every tree is complete and decodable.
+void BuildCodeLengths(const uint32_t* freqs, int n, int max_bits,
+                      uint8_t* lengths) {
+  struct SymbolFreq {
+    uint32_t freq;
+    uint16_t symbol;
+  };
+  SymbolFreq used[kLitLenCodes + 2];
+  int count = 0;
+  for (int i = 0; i < n; ++i) {
+    lengths[i] = 0;
+    if (freqs[i] != 0) {
+      used[count++] = {freqs[i], static_cast<uint16_t>(i)};
+    }
+  }
+  for (int filler = 0; count < 2; ++filler) {
+    if (freqs[filler] == 0) {
+      used[count++] = {1, static_cast<uint16_t>(filler)};
+    }
+  }
+  std::sort(used, used + count, [](const SymbolFreq& a, const SymbolFreq& b) {
+    return a.freq != b.freq ? a.freq < b.freq : a.symbol < b.symbol;
+  });
+
+  uint32_t a[kLitLenCodes + 2];
+  for (int i = 0; i < count; ++i) a[i] = used[i].freq;
+
+  // Moffat & Katajainen, "In-Place Calculation of Minimum-Redundancy Codes".
+  {
+    int root = 0;
+    int leaf = 2;
+    a[0] += a[1];
+    for (int next = 1; next < count - 1; ++next) {
+      if (leaf >= count || a[root] < a[leaf]) {
+        a[next] = a[root];
+        a[root++] = static_cast<uint32_t>(next);
+      } else {
+        a[next] = a[leaf++];
+      }
+      if (leaf >= count || (root < next && a[root] < a[leaf])) {
+        a[next] += a[root];
+        a[root++] = static_cast<uint32_t>(next);
+      } else {
+        a[next] += a[leaf++];
+      }
+    }
+    a[count - 2] = 0;
+    for (int next = count - 3; next >= 0; --next) {
+      a[next] = a[a[next]] + 1;
+    }
+    int available = 1;
+    int used_nodes = 0;
+    uint32_t depth = 0;
+    root = count - 2;
+    int next = count - 1;
+    while (available > 0) {
+      while (root >= 0 && a[root] == depth) {
+        ++used_nodes;
+        --root;
+      }
+      while (available > used_nodes) {
+        a[next--] = depth;
+        --available;
+      }
+      available = 2 * used_nodes;
+      ++depth;
+      used_nodes = 0;
+    }
+  }
+
+  constexpr int kMaxDepth = 32;
+  int num_codes[kMaxDepth + 1] = {};
+  for (int i = 0; i < count; ++i) {
+    const uint32_t depth = a[i] > kMaxDepth ? kMaxDepth : a[i];
+    ++num_codes[depth];
+  }
+  for (int i = max_bits + 1; i <= kMaxDepth; ++i) {
+    num_codes[max_bits] += num_codes[i];
+    num_codes[i] = 0;
+  }
+  uint32_t total = 0;
+  for (int i = max_bits; i > 0; --i) {
+    total += static_cast<uint32_t>(num_codes[i]) << (max_bits - i);
+  }
+  while (total != (1u << max_bits)) {
+    --num_codes[max_bits];
+    for (int i = max_bits - 1; i > 0; --i) {
+      if (num_codes[i] != 0) {
+        --num_codes[i];
+        num_codes[i + 1] += 2;
+        break;
+      }
+    }
+    --total;
+  }
+
+  // Most frequent symbols (end of the sorted list) get the shortest codes.
+  int index = count - 1;
+  for (int bits = 1; bits <= max_bits; ++bits) {
+    for (int k = num_codes[bits]; k > 0; --k) {
+      lengths[used[index--].symbol] = static_cast<uint8_t>(bits);
+    }
+  }
+}
+
+// Assigns canonical codes for |lengths|, bit-reversed because DEFLATE packs
+// Huffman codes starting from their most significant bit.
+void BuildCodes(const uint8_t* lengths, int n, uint16_t* codes) {
+  uint32_t bl_count[kMaxCodeBits + 1] = {};
+  for (int i = 0; i < n; ++i) ++bl_count[lengths[i]];
+  bl_count[0] = 0;
+  uint32_t next_code[kMaxCodeBits + 1] = {};
+  uint32_t code = 0;
+  for (int bits = 1; bits <= kMaxCodeBits; ++bits) {
+    code = (code + bl_count[bits - 1]) << 1;
+    next_code[bits] = code;
+  }
+  for (int i = 0; i < n; ++i) {
+    const int len = lengths[i];
+    if (len == 0) {
+      codes[i] = 0;
+      continue;
+    }
+    uint32_t c = next_code[len]++;
+    uint32_t reversed = 0;
+    for (int b = 0; b < len; ++b) {
+      reversed = (reversed << 1) | (c & 1);
+      c >>= 1;
+    }
+    codes[i] = static_cast<uint16_t>(reversed);
+  }
+}
+
+struct FixedCodes {
+  uint8_t litlen_lengths[288];
+  uint8_t dist_lengths[kDistCodes];
+  uint16_t litlen_codes[288];
+  uint16_t dist_codes[kDistCodes];
+
+  FixedCodes() {
+    for (int i = 0; i < 288; ++i) {
+      litlen_lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    }
+    for (int i = 0; i < kDistCodes; ++i) dist_lengths[i] = 5;
+    BuildCodes(litlen_lengths, 288, litlen_codes);
+    BuildCodes(dist_lengths, kDistCodes, dist_codes);
+  }
+};
+
+const FixedCodes& GetFixedCodes() {
+  static const FixedCodes codes;
+  return codes;
+}
+
+}  // namespace
+
+// Little-endian bit packer writing straight into the output buffer.
+class DeflateEncoder::BitWriter {
+ public:
+  explicit BitWriter(uint8_t* out) : out_(out) {}
+
+  // |count| <= 32 and |bits| has no bits set above |count|.
+  void Put(uint32_t bits, int count) {
+    accumulator_ |= static_cast<uint64_t>(bits) << bit_count_;
+    bit_count_ += count;
+    if (bit_count_ >= 32) {
+      out_[size_ + 0] = static_cast<uint8_t>(accumulator_);
+      out_[size_ + 1] = static_cast<uint8_t>(accumulator_ >> 8);
+      out_[size_ + 2] = static_cast<uint8_t>(accumulator_ >> 16);
+      out_[size_ + 3] = static_cast<uint8_t>(accumulator_ >> 24);
+      size_ += 4;
+      accumulator_ >>= 32;
+      bit_count_ -= 32;
+    }
+  }
+
+  void AlignToByte() {
+    while (bit_count_ > 0) {
+      out_[size_++] = static_cast<uint8_t>(accumulator_);
+      accumulator_ >>= 8;
+      bit_count_ = bit_count_ > 8 ? bit_count_ - 8 : 0;
+    }
+    accumulator_ = 0;
+  }
+
+  // Only valid when byte-aligned.
+  void WriteBytes(const uint8_t* data, size_t len) {
+    if (len == 0) return;
+    std::memcpy(out_ + size_, data, len);
+    size_ += len;
+  }
+
+  size_t size() const { return size_; }
+
+ private:
+  uint8_t* out_;
+  size_t size_ = 0;
+  uint64_t accumulator_ = 0;
+  int bit_count_ = 0;
+};
+
+DeflateEncoder::DeflateEncoder(int level) { set_level(level); }
+
+void DeflateEncoder::set_level(int level) {
+  level_ = std::clamp(level, kMinLevel, kMaxLevel);
+}
+
+size_t DeflateEncoder::CompressBound(size_t len) {
+  // Every block is at most its stored size: 5 header bytes (plus up to one
+  // alignment byte) per 64 KiB chunk, and chunks split at both the stored
+  // block limit and the token block limit. Add the sync flush marker and the
+  // closing empty block.
+  const size_t chunks = len / kMaxStoredBlock + len / kBlockTokens + 2;
+  return len + 6 * chunks + 16;
+}
+
+void DeflateEncoder::InsertHash(const uint8_t* base, uint32_t pos) {
+  const uint32_t h = Hash4(base + pos);
+  prev_[pos & kWindowMask] = head_[h];
+  head_[h] = static_cast<int32_t>(pos);
+}
+
+uint32_t DeflateEncoder::LongestMatch(const uint8_t* base, uint32_t pos,
+                                      uint32_t end, uint32_t* match_pos,
+                                      uint32_t prev_length) const {
+  const LevelParams& params = kLevels[level_];
+  const uint32_t max_len = std::min(kMaxMatch, end - pos);
+  const uint32_t nice = std::min(params.nice_length, max_len);
+  const uint32_t limit = pos > kMaxDistance ? pos - kMaxDistance : 0;
+  const uint8_t* scan = base + pos;
+  const uint32_t scan_start = LoadLe32(scan);
+
+  uint32_t best = prev_length;
+  if (best >= max_len) return 0;
+  uint32_t chain = params.max_chain;
+  int32_t candidate = head_[Hash4(scan)];
+  while (candidate >= 0 && static_cast<uint32_t>(candidate) >= limit &&
+         chain-- > 0) {
+    const uint8_t* match = base + candidate;
+    // Cheap rejects first: the byte that would extend the best match, then
+    // the hashed prefix (hash collisions are common).
+    if (match[best] == scan[best] && LoadLe32(match) == scan_start) {
+      const uint32_t len = MatchLength(scan, match, max_len);
+      if (len > best) {
+        best = len;
+        *match_pos = static_cast<uint32_t>(candidate);
+        if (len >= nice) break;
+      }
+    }
+    candidate = prev_[static_cast<uint32_t>(candidate) & kWindowMask];
+  }
+  return best > prev_length && best >= kMinMatch ? best : 0;
+}
+
+void DeflateEncoder::WriteStored(const uint8_t* data, size_t len, bool final,
+                                 BitWriter* writer) {
+  do {
+    const size_t chunk = std::min(len, kMaxStoredBlock);
+    len -= chunk;
+    writer->Put(final && len == 0 ? 1 : 0, 1);
+    writer->Put(0, 2);
+    writer->AlignToByte();
+    writer->Put(static_cast<uint32_t>(chunk), 16);
+    writer->Put(static_cast<uint32_t>(~chunk & 0xFFFF), 16);
+    writer->WriteBytes(data, chunk);
+    data += chunk;
+  } while (len > 0);
+}
+
+void DeflateEncoder::FlushBlock(const uint8_t* block_start, size_t block_len,
+                                bool final, BitWriter* writer) {
+  const LengthTable& length_table = GetLengthTable();
+
+  uint32_t litlen_freq[kLitLenCodes] = {};
+  uint32_t dist_freq[kDistCodes] = {};
+  uint64_t extra_bits = 0;
+  for (const Token& token : tokens_) {
+    if (token.distance == 0) {
+      ++litlen_freq[token.length];
+    } else {
+      const int li = length_table.index[token.length];
+      const int dc = DistanceCode(token.distance);
+      ++litlen_freq[257 + li];
+      ++dist_freq[dc];
+      extra_bits += kLengthExtra[li] + kDistExtra[dc];
+    }
+  }
+  litlen_freq[kEndOfBlock] = 1;
+
+  // Dynamic trees.
+  uint8_t litlen_lengths[kLitLenCodes];
+  uint8_t dist_lengths[kDistCodes];
+  BuildCodeLengths(litlen_freq, kLitLenCodes, kMaxCodeBits, litlen_lengths);
+  BuildCodeLengths(dist_freq, kDistCodes, kMaxCodeBits, dist_lengths);
+
+  int hlit = kLitLenCodes;
+  while (hlit > 257 && litlen_lengths[hlit - 1] == 0) --hlit;
+  int hdist = kDistCodes;
+  while (hdist > 1 && dist_lengths[hdist - 1] == 0) --hdist;
+
+  // Run-length encode the concatenated code lengths (symbols 16/17/18).
+  uint8_t all_lengths[kLitLenCodes + kDistCodes];
+  std::memcpy(all_lengths, litlen_lengths, static_cast<size_t>(hlit));
+  std::memcpy(all_lengths + hlit, dist_lengths, static_cast<size_t>(hdist));
+  const int total_lengths = hlit + hdist;
+  struct RleSymbol {
+    uint8_t symbol;
+    uint8_t extra;
+  };
+  RleSymbol rle[kLitLenCodes + kDistCodes];
+  int rle_count = 0;
+  uint32_t clen_freq[kCodeLengthCodes] = {};
+  for (int i = 0; i < total_lengths;) {
+    const uint8_t value = all_lengths[i];
+    int run = 1;
+    while (i + run < total_lengths && all_lengths[i + run] == value) ++run;
+    i += run;
+    if (value == 0) {
+      while (run >= 11) {
+        const int r = std::min(run, 138);
+        rle[rle_count++] = {18, static_cast<uint8_t>(r - 11)};
+        run -= r;
+      }
+      if (run >= 3) {
+        rle[rle_count++] = {17, static_cast<uint8_t>(run - 3)};
+        run = 0;
+      }
+    } else {
+      rle[rle_count++] = {value, 0};
+      --run;
+      while (run >= 3) {
+        const int r = std::min(run, 6);
+        rle[rle_count++] = {16, static_cast<uint8_t>(r - 3)};
+        run -= r;
+      }
+    }
+    while (run-- > 0) rle[rle_count++] = {value, 0};
+  }
+  for (int i = 0; i < rle_count; ++i) ++clen_freq[rle[i].symbol];
+
+  uint8_t clen_lengths[kCodeLengthCodes];
+  BuildCodeLengths(clen_freq, kCodeLengthCodes, kMaxCodeLengthBits,
+                   clen_lengths);
+  int hclen = kCodeLengthCodes;
+  while (hclen > 4 && clen_lengths[kCodeLengthOrder[hclen - 1]] == 0) --hclen;
+
+  // Cost of each block type in bits.
+  uint64_t dynamic_bits = 3 + 5 + 5 + 4 + 3 * static_cast<uint64_t>(hclen);
+  for (int i = 0; i < rle_count; ++i) {
+    const uint8_t s = rle[i].symbol;
+    const uint32_t extra = s == 16 ? 2 : s == 17 ? 3 : s == 18 ? 7 : 0;
+    dynamic_bits += clen_lengths[s] + extra;
+  }
+  const FixedCodes& fixed = GetFixedCodes();
+  uint64_t fixed_bits = 3 + extra_bits;
+  dynamic_bits += extra_bits;
+  for (int i = 0; i < kLitLenCodes; ++i) {
+    dynamic_bits += static_cast<uint64_t>(litlen_freq[i]) * litlen_lengths[i];
+    fixed_bits += static_cast<uint64_t>(litlen_freq[i]) * fixed.litlen_lengths[i];
+  }
+  for (int i = 0; i < kDistCodes; ++i) {
+    dynamic_bits += static_cast<uint64_t>(dist_freq[i]) * dist_lengths[i];
+    fixed_bits += static_cast<uint64_t>(dist_freq[i]) * fixed.dist_lengths[i];
+  }
+  const uint64_t stored_chunks =
+      block_len == 0 ? 1 : (block_len + kMaxStoredBlock - 1) / kMaxStoredBlock;
+  const uint64_t stored_bits =
+      stored_chunks * (3 + 7 + 32) + 8 * static_cast<uint64_t>(block_len);
+
+  if (stored_bits <= dynamic_bits && stored_bits <= fixed_bits) {
+    WriteStored(block_start, block_len, final, writer);
+    return;
+  }
+
+  const uint8_t* lit_lengths;
+  const uint8_t* d_lengths;
+  uint16_t dyn_litlen_codes[kLitLenCodes];
+  uint16_t dyn_dist_codes[kDistCodes];
+  const uint16_t* lit_codes;
+  const uint16_t* d_codes;
+  writer->Put(final ? 1 : 0, 1);
+  if (fixed_bits <= dynamic_bits) {
+    writer->Put(1, 2);
+    lit_lengths = fixed.litlen_lengths;
+    d_lengths = fixed.dist_lengths;
+    lit_codes = fixed.litlen_codes;
+    d_codes = fixed.dist_codes;
+  } else {
+    writer->Put(2, 2);
+    BuildCodes(litlen_lengths, kLitLenCodes, dyn_litlen_codes);
+    BuildCodes(dist_lengths, kDistCodes, dyn_dist_codes);
+    uint16_t clen_codes[kCodeLengthCodes];
+    BuildCodes(clen_lengths, kCodeLengthCodes, clen_codes);
+    writer->Put(static_cast<uint32_t>(hlit - 257), 5);
+    writer->Put(static_cast<uint32_t>(hdist - 1), 5);
+    writer->Put(static_cast<uint32_t>(hclen - 4), 4);
+    for (int i = 0; i < hclen; ++i) {
+      writer->Put(clen_lengths[kCodeLengthOrder[i]], 3);
+    }
+    for (int i = 0; i < rle_count; ++i) {
+      const uint8_t s = rle[i].symbol;
+      writer->Put(clen_codes[s], clen_lengths[s]);
+      if (s == 16) writer->Put(rle[i].extra, 2);
+      if (s == 17) writer->Put(rle[i].extra, 3);
+      if (s == 18) writer->Put(rle[i].extra, 7);
+    }
+    lit_lengths = litlen_lengths;
+    d_lengths = dist_lengths;
+    lit_codes = dyn_litlen_codes;
+    d_codes = dyn_dist_codes;
+  }
+
+  for (const Token& token : tokens_) {
+    if (token.distance == 0) {
+      writer->Put(lit_codes[token.length], lit_lengths[token.length]);
+    } else {
+      const int li = length_table.index[token.length];
+      const int sym = 257 + li;
+      writer->Put(lit_codes[sym], lit_lengths[sym]);
+      writer->Put(static_cast<uint32_t>(token.length - kLengthBase[li]),
+                  kLengthExtra[li]);
+      const int dc = DistanceCode(token.distance);
+      writer->Put(d_codes[dc], d_lengths[dc]);
+      writer->Put(static_cast<uint32_t>(token.distance - kDistBase[dc]),
+                  kDistExtra[dc]);
+    }
+  }
+  writer->Put(lit_codes[kEndOfBlock], lit_lengths[kEndOfBlock]);
+}
+
+size_t DeflateEncoder::Compress(const uint8_t* data, size_t len, bool final,
+                                uint8_t* out, size_t history) {
+  BitWriter writer(out);
+
+  if (level_ == 0) {
+    if (len > 0 || final) WriteStored(data, len, final, &writer);
+  } else {
+    const LevelParams& params = kLevels[level_];
+    const uint32_t hist = static_cast<uint32_t>(std::min<size_t>(history, kWindowSize));
+    const uint8_t* base = data - hist;
+    const uint32_t end = hist + static_cast<uint32_t>(len);
+
+    head_.assign(kHashSize, -1);
+    prev_.resize(kWindowSize);
+    tokens_.clear();
+    tokens_.reserve(kBlockTokens + kTokenSlack);
+
+    for (uint32_t p = 0; p < hist && p + kMinMatch <= end; ++p) {
+      InsertHash(base, p);
+    }
+
+    const auto insert_range = [&](uint32_t from, uint32_t to) {
+      for (uint32_t p = from; p < to && p + kMinMatch <= end; ++p) {
+        InsertHash(base, p);
+      }
+    };
+
+    uint32_t pos = hist;
+    uint32_t block_start = hist;
+    bool have_pending = false;
+    uint32_t pending_length = 0;
+    uint32_t pending_distance = 0;
+
+    while (pos < end) {
+      if (!have_pending && tokens_.size() >= kBlockTokens) {
+        FlushBlock(base + block_start, pos - block_start, false, &writer);
+        tokens_.clear();
+        block_start = pos;
+      }
+
+      uint32_t length = 0;
+      uint32_t match_pos = 0;
+      if (end - pos >= kMinMatch) {
+        if (!have_pending || pending_length < params.lazy_length) {
+          length = LongestMatch(base, pos, end, &match_pos,
+                                have_pending ? pending_length : kMinMatch - 1);
+        }
+        InsertHash(base, pos);
+      }
+
+      if (have_pending) {
+        if (length > pending_length) {
+          // The match starting here beats the one starting a byte earlier:
+          // emit that byte as a literal and keep the new match pending.
+          tokens_.push_back({base[pos - 1], 0});
+          pending_length = length;
+          pending_distance = pos - match_pos;
+          ++pos;
+        } else {
+          const uint32_t match_end = pos - 1 + pending_length;
+          tokens_.push_back({static_cast<uint16_t>(pending_length),
+                             static_cast<uint16_t>(pending_distance)});
+          insert_range(pos + 1, match_end);
+          pos = match_end;
+          have_pending = false;
+        }
+      } else if (length >= kMinMatch) {
+        if (length < params.lazy_length) {
+          have_pending = true;
+          pending_length = length;
+          pending_distance = pos - match_pos;
+          ++pos;
+        } else {
+          tokens_.push_back({static_cast<uint16_t>(length),
+                             static_cast<uint16_t>(pos - match_pos)});
+          if (length <= params.max_insert) insert_range(pos + 1, pos + length);
+          pos += length;
+        }
+      } else {
+        tokens_.push_back({base[pos], 0});
+        ++pos;
+      }
+    }
+    if (!tokens_.empty() || final) {
+      FlushBlock(base + block_start, end - block_start, final, &writer);
+      tokens_.clear();
+    }
+  }
+
+  if (final) {
+    writer.AlignToByte();
+  } else {
+    // Sync flush: an empty stored block leaves the stream byte-aligned.
+    WriteStored(nullptr, 0, false, &writer);
+  }
+  return writer.size();
+}
+
+}  // namespace screenshot
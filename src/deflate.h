@@ -0,0 +1,69 @@
+#ifndef SCREENSHOT_CORE_DEFLATE_H_
+#define SCREENSHOT_CORE_DEFLATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace screenshot {
+
+// Raw DEFLATE (RFC 1951) compressor.
+//
+// Each call compresses one contiguous segment into a caller-provided buffer
+// of at least CompressBound() bytes; nothing is allocated per call once the
+// encoder's scratch tables have grown to the largest segment seen. Every block
+// is emitted as whichever of dynamic Huffman, fixed Huffman or stored is
+// smallest, so the output never expands by more than the stored-block
+// overhead.
+//
+// A segment may reference up to 32 KiB of |history| that precedes it in
+// memory without emitting it. Segments that are not final end with a sync
+// flush (an empty stored block), leaving the stream byte-aligned so that
+// independently compressed segments can be concatenated into one stream.
+class DeflateEncoder {
+ public:
+  static constexpr int kMinLevel = 0;
+  static constexpr int kMaxLevel = 9;
+  static constexpr int kDefaultLevel = 6;
+
+  // |level| trades speed for ratio the same way zlib's does: 0 stores,
+  // 1 is fastest, 9 searches hardest. Out-of-range values are clamped.
+  explicit DeflateEncoder(int level = kDefaultLevel);
+
+  void set_level(int level);
+  int level() const { return level_; }
+
+  // Upper bound on the compressed size of a |len|-byte segment.
+  static size_t CompressBound(size_t len);
+
+  // Compresses data[0, len) into |out| and returns the number of bytes
+  // written. data[-history, 0) must be readable and is used as the match
+  // dictionary (only the last 32 KiB are consulted).
+  size_t Compress(const uint8_t* data, size_t len, bool final, uint8_t* out,
+                  size_t history = 0);
+
+ private:
+  struct Token {
+    uint16_t length;    // Literal byte value when distance == 0.
+    uint16_t distance;  // 0 for literals.
+  };
+
+  class BitWriter;
+
+  void InsertHash(const uint8_t* base, uint32_t pos);
+  uint32_t LongestMatch(const uint8_t* base, uint32_t pos, uint32_t end,
+                        uint32_t* match_pos, uint32_t prev_length) const;
+  void FlushBlock(const uint8_t* block_start, size_t block_len, bool final,
+                  BitWriter* writer);
+  void WriteStored(const uint8_t* data, size_t len, bool final,
+                   BitWriter* writer);
+
+  int level_;
+  std::vector<int32_t> head_;
+  std::vector<int32_t> prev_;
+  std::vector<Token> tokens_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_DEFLATE_H_
@@ -0,0 +1,173 @@
+#include "display_capture.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "trace.h"
+
+namespace screenshot {
+namespace {
+
+// Fills |count| pixels with opaque black.
+void FillBlack(uint8_t* pixels, int count) {
+  for (int i = 0; i < count; ++i) {
+    pixels[0] = 0;
+    pixels[1] = 0;
+    pixels[2] = 0;
+    pixels[3] = 0xFF;
+    pixels += kBytesPerPixel;
+  }
+}
+
+}  // namespace
+
+PixelRect DesktopBounds(const std::vector<DisplayInfo>& displays) {
+  PixelRect bounds;
+  for (const DisplayInfo& display : displays) {
+    const PixelRect& rect = display.bounds;
+    if (rect.IsEmpty()) continue;
+    if (bounds.IsEmpty()) {
+      bounds = rect;
+      continue;
+    }
+    const int left = std::min(bounds.x, rect.x);
+    const int top = std::min(bounds.y, rect.y);
+    const int right = std::max(bounds.right(), rect.right());
+    const int bottom = std::max(bounds.bottom(), rect.bottom());
+    bounds = PixelRect{left, top, right - left, bottom - top};
+  }
+  return bounds;
+}
+
+bool StitchDisplays(const std::vector<DisplayInfo>& displays,
+                    const std::vector<ImageView>& frames,
+                    const PixelRect& desktop, uint8_t* out, size_t stride) {
+  if (frames.size() != displays.size() || desktop.IsEmpty() ||
+      stride < static_cast<size_t>(desktop.width) * kBytesPerPixel) {
+    return false;
+  }
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (!frames[i].IsValid() || frames[i].width != displays[i].bounds.width ||
+        frames[i].height != displays[i].bounds.height) {
+      return false;
+    }
+  }
+  // Left to right, so each row is written in one pass with the gaps
+  // between displays filled as they come up.
+  std::vector<size_t> order(displays.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return displays[a].bounds.x < displays[b].bounds.x;
+  });
+
+  for (int y = desktop.y; y < desktop.bottom(); ++y) {
+    uint8_t* row = out + static_cast<size_t>(y - desktop.y) * stride;
+    int filled = desktop.x;
+    for (size_t i : order) {
+      const PixelRect part = IntersectRects(displays[i].bounds, desktop);
+      if (y < part.y || y >= part.bottom() || part.right() <= filled) {
+        continue;
+      }
+      // Where an earlier display already covers the row, keep it.
+      const int left = std::max(part.x, filled);
+      if (left > filled) {
+        FillBlack(row + static_cast<size_t>(filled - desktop.x) *
+                            kBytesPerPixel,
+                  left - filled);
+      }
+      const ImageView& frame = frames[i];
+      const uint8_t* source =
+          frame.Row(y - displays[i].bounds.y) +
+          static_cast<size_t>(left - displays[i].bounds.x) * kBytesPerPixel;
+      std::memcpy(row + static_cast<size_t>(left - desktop.x) * kBytesPerPixel,
+                  source,
+                  static_cast<size_t>(part.right() - left) * kBytesPerPixel);
+      filled = part.right();
+    }
+    if (filled < desktop.right()) {
+      FillBlack(row + static_cast<size_t>(filled - desktop.x) * kBytesPerPixel,
+                desktop.right() - filled);
+    }
+  }
+  return true;
+}
+
+MultiDisplayCapture::MultiDisplayCapture(
+    DisplayBackend* backend, FramePool* pool,
+    const MultiDisplayCaptureOptions& options)
+    : backend_(backend), pool_(pool), options_(options) {}
+
+bool MultiDisplayCapture::Capture(const std::vector<DisplayInfo>& displays,
+                                  bool include_cursor,
+                                  std::vector<FramePool::Lease>* frames) {
+  frames->clear();
+  const size_t count = displays.size();
+  if (count == 0) return false;
+  frames->resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const PixelRect& bounds = displays[i].bounds;
+    if (!bounds.IsEmpty()) {
+      (*frames)[i] =
+          pool_->Acquire(bounds.width, bounds.height, PixelFormat::kBgra8);
+    }
+    if (!(*frames)[i]) {
+      frames->clear();
+      return false;
+    }
+  }
+
+  size_t lanes = count;
+  if (options_.threads > 0) {
+    lanes = std::min(lanes, static_cast<size_t>(options_.threads));
+  }
+  std::atomic<bool> failed(false);
+  auto capture_lane = [&](size_t lane) {
+    for (size_t i = lane; i < count; i += lanes) {
+      TraceSpan span("capture display");
+      if (!backend_->CaptureDisplay(displays[i], include_cursor,
+                                    static_cast<int>(lane),
+                                    (*frames)[i]->data())) {
+        failed.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+  if (lanes > 1) {
+    // The calling thread takes a lane too.
+    const int workers = static_cast<int>(lanes) - 1;
+    if (!threads_ || threads_->size() < workers) {
+      threads_ = std::make_unique<ThreadPool>(workers);
+    }
+    threads_->ParallelFor(lanes, capture_lane);
+  } else {
+    capture_lane(0);
+  }
+  if (failed.load(std::memory_order_relaxed)) {
+    frames->clear();
+    return false;
+  }
+  return true;
+}
+
+FramePool::Lease MultiDisplayCapture::CaptureDesktop(
+    const std::vector<DisplayInfo>& displays, bool include_cursor) {
+  if (!Capture(displays, include_cursor, &scratch_)) return FramePool::Lease();
+  TraceSpan span("stitch");
+  const PixelRect desktop = DesktopBounds(displays);
+  FramePool::Lease out =
+      pool_->Acquire(desktop.width, desktop.height, PixelFormat::kBgra8);
+  views_.clear();
+  for (const FramePool::Lease& frame : scratch_) {
+    views_.push_back(frame->View());
+  }
+  const bool stitched =
+      out && StitchDisplays(displays, views_, desktop, out->data(),
+                            out->stride());
+  // The display frames go back to the pool right away.
+  scratch_.clear();
+  views_.clear();
+  if (!stitched) return FramePool::Lease();
+  return out;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,101 @@
+#ifndef SCREENSHOT_CORE_DISPLAY_CAPTURE_H_
+#define SCREENSHOT_CORE_DISPLAY_CAPTURE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame_pool.h"
+#include "image.h"
+#include "image_rect.h"
+#include "thread_pool.h"
+
+namespace screenshot {
+
+// A display of the virtual desktop. |bounds| are in virtual-desktop pixels,
+// with the primary display's top left at the origin, so displays left of or
+// above it have negative coordinates.
+struct DisplayInfo {
+  // Position in the backend's list.
+  int id = 0;
+  PixelRect bounds;
+  bool primary = false;
+  // The platform's name for the display (such as \\.\DISPLAY2); may be
+  // empty.
+  std::string name;
+};
+
+// Where displays and their pixels come from: GDI on Windows, synthetic
+// displays in tests.
+class DisplayBackend {
+ public:
+  virtual ~DisplayBackend() = default;
+
+  // Replaces |displays| with the current displays, ids counting up from 0.
+  // Returns false if they cannot be listed.
+  virtual bool ListDisplays(std::vector<DisplayInfo>* displays) = 0;
+
+  // Copies what |display| shows into |pixels|: packed top-down BGRA rows,
+  // display.bounds.width * 4 bytes each, with the cursor drawn on top if
+  // |include_cursor|. Called for several displays at once, each on its own
+  // |lane| (0, 1, ...), so per-capture state can be kept per lane.
+  virtual bool CaptureDisplay(const DisplayInfo& display, bool include_cursor,
+                              int lane, uint8_t* pixels) = 0;
+};
+
+// Smallest rectangle holding every display; empty without displays.
+PixelRect DesktopBounds(const std::vector<DisplayInfo>& displays);
+
+// Copies each of |frames| into |out| at its display's place in |desktop|:
+// frames[i] shows displays[i] and must be its size. |out| holds
+// desktop.width x desktop.height BGRA pixels, |stride| bytes per row.
+// Pixels no display covers are opaque black; where displays overlap, the
+// one further left is shown. Returns false on a mismatched frame.
+bool StitchDisplays(const std::vector<DisplayInfo>& displays,
+                    const std::vector<ImageView>& frames,
+                    const PixelRect& desktop, uint8_t* out, size_t stride);
+
+struct MultiDisplayCaptureOptions {
+  // Displays captured at once; 0 captures all of them at once.
+  int threads = 0;
+};
+
+// Captures several displays concurrently into frames leased from a pool.
+//
+// Each display is read on its own lane of a thread pool kept between
+// calls, so capturing every display of a desktop takes about as long as
+// the slowest one rather than the sum. Not thread-safe.
+class MultiDisplayCapture {
+ public:
+  MultiDisplayCapture(
+      DisplayBackend* backend, FramePool* pool,
+      const MultiDisplayCaptureOptions& options = MultiDisplayCaptureOptions());
+
+  MultiDisplayCapture(const MultiDisplayCapture&) = delete;
+  MultiDisplayCapture& operator=(const MultiDisplayCapture&) = delete;
+
+  // Captures |displays| into |frames|, frames[i] showing displays[i].
+  // Returns false, leaving |frames| empty, if any capture fails or a
+  // display has no pixels.
+  bool Capture(const std::vector<DisplayInfo>& displays, bool include_cursor,
+               std::vector<FramePool::Lease>* frames);
+
+  // Captures |displays| and stitches them into one frame of
+  // DesktopBounds(displays). Returns an empty lease on failure.
+  FramePool::Lease CaptureDesktop(const std::vector<DisplayInfo>& displays,
+                                  bool include_cursor);
+
+ private:
+  DisplayBackend* backend_;
+  FramePool* pool_;
+  MultiDisplayCaptureOptions options_;
+  std::unique_ptr<ThreadPool> threads_;
+  std::vector<FramePool::Lease> scratch_;
+  std::vector<ImageView> views_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_DISPLAY_CAPTURE_H_
@@ -0,0 +1,268 @@
+#include "encoder_session.h"
+
+#include "pixel_convert.h"
+#include "trace.h"
+
+namespace screenshot {
+
+namespace {
+
+// Passes writes through, counting the bytes.
+class CountingSink : public ByteSink {
+ public:
+  explicit CountingSink(ByteSink* sink) : sink_(sink) {}
+
+  bool Write(const uint8_t* data, size_t size) override {
+    written_ += size;
+    return sink_->Write(data, size);
+  }
+
+  size_t written() const { return written_; }
+
+ private:
+  ByteSink* sink_;
+  size_t written_ = 0;
+};
+
+}  // namespace
+
+bool ParseCaptureFormat(const std::string& value, CaptureFormat* format) {
+  if (value == "png") {
+    *format = CaptureFormat::kPng;
+  } else if (value == "raw_bgra") {
+    *format = CaptureFormat::kRawBgra;
+  } else if (value == "raw_rgba") {
+    *format = CaptureFormat::kRawRgba;
+  } else if (value == "qoi") {
+    *format = CaptureFormat::kQoi;
+  } else if (value == "lz4_bgra") {
+    *format = CaptureFormat::kLz4Bgra;
+  } else if (value == "jpeg") {
+    *format = CaptureFormat::kJpeg;
+  } else if (value == "webp") {
+    *format = CaptureFormat::kWebp;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* CaptureFormatName(CaptureFormat format) {
+  switch (format) {
+    case CaptureFormat::kRawBgra:
+      return "raw_bgra";
+    case CaptureFormat::kRawRgba:
+      return "raw_rgba";
+    case CaptureFormat::kQoi:
+      return "qoi";
+    case CaptureFormat::kLz4Bgra:
+      return "lz4_bgra";
+    case CaptureFormat::kJpeg:
+      return "jpeg";
+    case CaptureFormat::kWebp:
+      return "webp";
+    case CaptureFormat::kPng:
+    default:
+      return "png";
+  }
+}
+
+bool ParseChromaSubsampling(const std::string& value,
+                            ChromaSubsampling* subsampling) {
+  if (value == "444") {
+    *subsampling = ChromaSubsampling::k444;
+  } else if (value == "422") {
+    *subsampling = ChromaSubsampling::k422;
+  } else if (value == "420") {
+    *subsampling = ChromaSubsampling::k420;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool EncoderSession::Encode(const ImageView& image,
+                            const EncodeSettings& settings) {
+  TraceSpan span("encode");
+  data_ = nullptr;
+  size_ = 0;
+  stride_ = 0;
+  if (!image.IsValid()) return false;
+
+  size_t size = 0;
+  size_t stride = 0;
+  switch (settings.format) {
+    case CaptureFormat::kRawBgra:
+    case CaptureFormat::kRawRgba: {
+      const PixelFormat target = settings.format == CaptureFormat::kRawRgba
+                                     ? PixelFormat::kRgba8
+                                     : PixelFormat::kBgra8;
+      stride = image.RowBytes();
+      const size_t bytes = stride * static_cast<size_t>(image.height);
+      if (ConvertImage(image, target, true, Reserve(bytes), stride)) {
+        size = bytes;
+      }
+      break;
+    }
+    case CaptureFormat::kQoi: {
+      if (!qoi_.options().force_opaque) {
+        QoiEncodeOptions options;
+        options.force_opaque = true;
+        qoi_.set_options(options);
+      }
+      const size_t bound = QoiEncoder::MaxEncodedSize(image.width,
+                                                      image.height);
+      if (bound != 0) size = qoi_.Encode(image, Reserve(bound), bound);
+      break;
+    }
+    case CaptureFormat::kLz4Bgra: {
+      ConfigureLz4(settings);
+      const size_t bound = Lz4FrameEncoder::MaxEncodedSize(image.width,
+                                                           image.height);
+      if (bound != 0) size = lz4_.Encode(image, Reserve(bound), bound);
+      stride = image.RowBytes();
+      break;
+    }
+    case CaptureFormat::kJpeg: {
+      ConfigureJpeg(settings);
+      const size_t bound = JpegEncoder::MaxEncodedSize(image.width,
+                                                       image.height);
+      if (bound != 0) size = jpeg_.Encode(image, Reserve(bound), bound);
+      break;
+    }
+    case CaptureFormat::kWebp: {
+      ConfigureWebp(settings);
+      if (!webp_.Encode(image, &webp_output_)) return false;
+      data_ = webp_output_.data();
+      size_ = webp_output_.size();
+      return true;
+    }
+    case CaptureFormat::kPng:
+    default: {
+      ConfigurePng(settings);
+      const size_t bound = PngEncoder::MaxEncodedSize(image.width,
+                                                      image.height);
+      if (bound != 0) size = png_.Encode(image, Reserve(bound), bound);
+      break;
+    }
+  }
+  if (size == 0) return false;
+  data_ = output_.data();
+  size_ = size;
+  stride_ = stride;
+  return true;
+}
+
+bool EncoderSession::Encode(const ImageView& image,
+                            const EncodeSettings& settings, ByteSink* sink) {
+  TraceSpan span("encode");
+  data_ = nullptr;
+  size_ = 0;
+  stride_ = 0;
+  if (!image.IsValid()) return false;
+
+  CountingSink counter(sink);
+  bool ok = false;
+  size_t stride = 0;
+  switch (settings.format) {
+    case CaptureFormat::kRawBgra:
+    case CaptureFormat::kRawRgba: {
+      const PixelFormat target = settings.format == CaptureFormat::kRawRgba
+                                     ? PixelFormat::kRgba8
+                                     : PixelFormat::kBgra8;
+      stride = image.RowBytes();
+      const int rows_per_chunk =
+          stride >= kSinkChunkSize
+              ? 1
+              : static_cast<int>(kSinkChunkSize / stride);
+      uint8_t* chunk = Reserve(stride * static_cast<size_t>(rows_per_chunk));
+      ok = true;
+      for (int y = 0; ok && y < image.height; y += rows_per_chunk) {
+        ImageView rows = image;
+        rows.data = image.Row(y);
+        rows.height = image.height - y < rows_per_chunk ? image.height - y
+                                                        : rows_per_chunk;
+        ok = ConvertImage(rows, target, true, chunk, stride) &&
+             counter.Write(chunk, stride * static_cast<size_t>(rows.height));
+      }
+      break;
+    }
+    case CaptureFormat::kQoi: {
+      if (!qoi_.options().force_opaque) {
+        QoiEncodeOptions options;
+        options.force_opaque = true;
+        qoi_.set_options(options);
+      }
+      ok = qoi_.Encode(image, &counter);
+      break;
+    }
+    case CaptureFormat::kLz4Bgra:
+      ConfigureLz4(settings);
+      ok = lz4_.Encode(image, &counter);
+      stride = image.RowBytes();
+      break;
+    case CaptureFormat::kJpeg:
+      ConfigureJpeg(settings);
+      ok = jpeg_.Encode(image, &counter);
+      break;
+    case CaptureFormat::kWebp:
+      ConfigureWebp(settings);
+      ok = webp_.Encode(image, &counter);
+      break;
+    case CaptureFormat::kPng:
+    default:
+      ConfigurePng(settings);
+      ok = png_.Encode(image, &counter);
+      break;
+  }
+  if (!ok) return false;
+  size_ = counter.written();
+  stride_ = stride;
+  return true;
+}
+
+uint8_t* EncoderSession::Reserve(size_t size) {
+  if (output_.size() < size) output_.resize(size);
+  return output_.data();
+}
+
+void EncoderSession::ConfigurePng(const EncodeSettings& settings) {
+  const PngEncodeOptions& current = png_.options();
+  if (current.force_opaque && current.threads == settings.threads) return;
+  PngEncodeOptions options = current;
+  options.force_opaque = true;
+  options.threads = settings.threads;
+  png_.set_options(options);
+}
+
+void EncoderSession::ConfigureLz4(const EncodeSettings& settings) {
+  const Lz4FrameEncodeOptions& current = lz4_.options();
+  if (current.force_opaque && current.threads == settings.threads) return;
+  Lz4FrameEncodeOptions options = current;
+  options.force_opaque = true;
+  options.threads = settings.threads;
+  lz4_.set_options(options);
+}
+
+void EncoderSession::ConfigureJpeg(const EncodeSettings& settings) {
+  const JpegEncodeOptions& current = jpeg_.options();
+  if (current.quality == settings.quality &&
+      current.subsampling == settings.subsampling &&
+      current.threads == settings.threads) {
+    return;
+  }
+  JpegEncodeOptions options = current;
+  options.quality = settings.quality;
+  options.subsampling = settings.subsampling;
+  options.threads = settings.threads;
+  jpeg_.set_options(options);
+}
+
+void EncoderSession::ConfigureWebp(const EncodeSettings& settings) {
+  WebpEncodeOptions options = webp_.options();
+  options.quality = settings.quality;
+  options.sharp_yuv = settings.subsampling != ChromaSubsampling::k420;
+  webp_.set_options(options);
+}
+
+}  // namespace screenshot
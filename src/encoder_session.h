@@ -0,0 +1,120 @@
+#ifndef SCREENSHOT_CORE_ENCODER_SESSION_H_
+#define SCREENSHOT_CORE_ENCODER_SESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "byte_sink.h"
+#include "image.h"
+#include "jpeg_encoder.h"
+#include "lz4_frame_encoder.h"
+#include "png_encoder.h"
+#include "qoi_encoder.h"
+#include "webp_encoder.h"
+
+namespace screenshot {
+
+// Output formats of a capture.
+enum class CaptureFormat {
+  kPng,      // PNG-encoded image
+  kRawBgra,  // unencoded 8-bit BGRA rows
+  kRawRgba,  // unencoded 8-bit RGBA rows
+  kQoi,      // QOI-encoded image
+  kLz4Bgra,  // LZ4 frame of packed BGRA rows
+  kJpeg,     // lossy baseline JPEG
+  kWebp,     // lossy WebP (only when built with libwebp)
+};
+
+// Parses a "format" argument value of the method channel ("png",
+// "raw_bgra", "raw_rgba", "qoi", "lz4_bgra", "jpeg" or "webp"). Returns
+// false for unknown values.
+bool ParseCaptureFormat(const std::string& value, CaptureFormat* format);
+
+// Value of the "pixelFormat" result field for |format|.
+const char* CaptureFormatName(CaptureFormat format);
+
+// Parses a "chromaSubsampling" argument value ("444", "422" or "420").
+// Returns false for unknown values.
+bool ParseChromaSubsampling(const std::string& value,
+                            ChromaSubsampling* subsampling);
+
+// Output format plus the lossy-codec knobs that go with it.
+struct EncodeSettings {
+  CaptureFormat format = CaptureFormat::kPng;
+  // 1-100, used by JPEG and WebP.
+  int quality = 85;
+  // JPEG chroma resolution. Lossy WebP is always 4:2:0; asking it for more
+  // chroma detail enables sharp RGB->YUV.
+  ChromaSubsampling subsampling = ChromaSubsampling::k420;
+  // Threads the encoder may use; 0 uses every core.
+  int threads = 0;
+};
+
+// Encodes captures of any CaptureFormat with encoders and an output buffer
+// that outlive the individual frames.
+//
+// Constructing an encoder per capture throws away its scratch buffers,
+// deflate/entropy state and worker threads, and a fresh output vector is
+// allocated (and zeroed) each time. A session keeps all of them: after the
+// first frame of a given size and format, Encode() does not touch the heap
+// (except for WebP, which libwebp manages itself). Images are always
+// written as opaque, since screen pixels carry no meaningful alpha.
+//
+// Not thread-safe; use one session per encoding thread.
+class EncoderSession {
+ public:
+  EncoderSession() = default;
+
+  EncoderSession(const EncoderSession&) = delete;
+  EncoderSession& operator=(const EncoderSession&) = delete;
+
+  // Encodes |image| as |settings| asks. Returns false if the image is
+  // invalid or cannot be encoded in that format.
+  bool Encode(const ImageView& image, const EncodeSettings& settings);
+
+  // Streams the encoding to |sink| as it is produced instead of building it
+  // in the output buffer: raw rows are converted a chunk at a time and the
+  // encoders write as they go (see their ByteSink overloads), so at most a
+  // few kSinkChunkSize pieces of output are held at once. Afterwards size()
+  // is the number of bytes written and data() is null. Returns false if the
+  // image cannot be encoded or |sink| fails.
+  bool Encode(const ImageView& image, const EncodeSettings& settings,
+              ByteSink* sink);
+
+  // Output of the last successful Encode(), valid until the next call.
+  // data() is null after streaming to a sink.
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // Row size of the (decompressed) pixels for raw and LZ4 output; 0 for
+  // image formats.
+  size_t stride() const { return stride_; }
+
+ private:
+  // Grows output_ to at least |size| bytes; it never shrinks.
+  uint8_t* Reserve(size_t size);
+
+  // Bring each encoder's options in line with |settings|, leaving it alone
+  // when nothing changed.
+  void ConfigurePng(const EncodeSettings& settings);
+  void ConfigureLz4(const EncodeSettings& settings);
+  void ConfigureJpeg(const EncodeSettings& settings);
+  void ConfigureWebp(const EncodeSettings& settings);
+
+  PngEncoder png_;
+  QoiEncoder qoi_;
+  Lz4FrameEncoder lz4_;
+  JpegEncoder jpeg_;
+  WebpEncoder webp_;
+  std::vector<uint8_t> output_;
+  std::vector<uint8_t> webp_output_;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  size_t stride_ = 0;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_ENCODER_SESSION_H_
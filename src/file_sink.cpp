@@ -0,0 +1,246 @@
+#include "file_sink.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+// Name of the temporary file an atomic write goes to: next to the target
+// (so the rename stays on one file system) and unique within the process.
+std::string TemporaryPath(const std::string& path) {
+  static std::atomic<unsigned> counter{0};
+#if defined(_WIN32)
+  const unsigned long pid = GetCurrentProcessId();
+#else
+  const long pid = static_cast<long>(getpid());
+#endif
+  return path + ".tmp-" + std::to_string(pid) + "-" +
+         std::to_string(counter.fetch_add(1));
+}
+
+#if defined(_WIN32)
+std::wstring Widen(const std::string& utf8) {
+  if (utf8.empty()) return std::wstring();
+  const int length = MultiByteToWideChar(CP_UTF8, 0, utf8.data(),
+                                         static_cast<int>(utf8.size()),
+                                         nullptr, 0);
+  if (length <= 0) return std::wstring();
+  std::wstring wide(static_cast<size_t>(length), L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()),
+                      &wide[0], length);
+  return wide;
+}
+
+int LastError() { return static_cast<int>(GetLastError()); }
+
+intptr_t OpenForWriting(const std::string& path) {
+  HANDLE file = CreateFileW(Widen(path).c_str(), GENERIC_WRITE, 0, nullptr,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  return file == INVALID_HANDLE_VALUE ? -1 : reinterpret_cast<intptr_t>(file);
+}
+
+void RemoveFile(const std::string& path) { DeleteFileW(Widen(path).c_str()); }
+#else
+int LastError() { return errno; }
+
+intptr_t OpenForWriting(const std::string& path) {
+  int fd;
+  do {
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  } while (fd < 0 && errno == EINTR);
+  return fd;
+}
+
+void RemoveFile(const std::string& path) { unlink(path.c_str()); }
+
+// Makes a rename in the directory holding |path| durable.
+bool SyncDirectory(const std::string& path) {
+  const size_t slash = path.rfind('/');
+  const std::string directory = slash == std::string::npos ? "."
+                                : slash == 0 ? "/"
+                                             : path.substr(0, slash);
+  const int fd = open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  const bool ok = fsync(fd) == 0;
+  close(fd);
+  return ok;
+}
+#endif
+
+}  // namespace
+
+std::unique_ptr<FileSink> FileSink::Open(const std::string& path,
+                                         const FileSinkOptions& options,
+                                         int* error) {
+  if (error) *error = 0;
+  if (path.empty() || options.chunk_size == 0) {
+#if defined(_WIN32)
+    if (error) *error = ERROR_INVALID_PARAMETER;
+#else
+    if (error) *error = EINVAL;
+#endif
+    return nullptr;
+  }
+  const std::string write_path = options.atomic ? TemporaryPath(path) : path;
+  const intptr_t file = OpenForWriting(write_path);
+  if (file < 0) {
+    if (error) *error = LastError();
+    return nullptr;
+  }
+  return std::unique_ptr<FileSink>(
+      new FileSink(path, write_path, file, options));
+}
+
+FileSink::FileSink(const std::string& path, const std::string& write_path,
+                   intptr_t file, const FileSinkOptions& options)
+    : path_(path),
+      write_path_(write_path),
+      file_(file),
+      options_(options),
+      chunk_(options.chunk_size) {}
+
+FileSink::~FileSink() {
+  if (committed_) return;
+  Close();
+  RemoveFile(write_path_);
+}
+
+bool FileSink::Write(const uint8_t* data, size_t size) {
+  if (error_ != 0 || file_ < 0) return false;
+  size_ += size;
+  // Fill up the pending chunk first, so the file is written in whole
+  // chunks; spans of whole chunks then go straight through.
+  if (buffered_ != 0) {
+    const size_t room = chunk_.size() - buffered_;
+    const size_t take = size < room ? size : room;
+    std::memcpy(chunk_.data() + buffered_, data, take);
+    buffered_ += take;
+    data += take;
+    size -= take;
+    if (buffered_ < chunk_.size()) return true;
+    if (!WriteOut(chunk_.data(), buffered_)) return false;
+    buffered_ = 0;
+  }
+  const size_t direct = size / chunk_.size() * chunk_.size();
+  if (direct != 0 && !WriteOut(data, direct)) return false;
+  buffered_ = size - direct;
+  if (buffered_ != 0) std::memcpy(chunk_.data(), data + direct, buffered_);
+  return true;
+}
+
+bool FileSink::Commit() {
+  if (committed_) return true;
+  bool ok = error_ == 0 && file_ >= 0;
+  if (ok && buffered_ != 0) ok = WriteOut(chunk_.data(), buffered_);
+  buffered_ = 0;
+#if defined(_WIN32)
+  if (ok && options_.sync &&
+      !FlushFileBuffers(reinterpret_cast<HANDLE>(file_))) {
+    Fail();
+    ok = false;
+  }
+#else
+  if (ok && options_.sync && fsync(static_cast<int>(file_)) != 0) {
+    Fail();
+    ok = false;
+  }
+#endif
+  if (!Close()) ok = false;
+  if (ok && options_.atomic) {
+#if defined(_WIN32)
+    DWORD flags = MOVEFILE_REPLACE_EXISTING;
+    if (options_.sync) flags |= MOVEFILE_WRITE_THROUGH;
+    if (!MoveFileExW(Widen(write_path_).c_str(), Widen(path_).c_str(),
+                     flags)) {
+      Fail();
+      ok = false;
+    }
+#else
+    if (rename(write_path_.c_str(), path_.c_str()) != 0) {
+      Fail();
+      ok = false;
+    } else if (options_.sync && !SyncDirectory(path_)) {
+      // The file is complete and in place; only its durability across a
+      // crash is in doubt, and removing it now would not improve on that.
+      Fail();
+      committed_ = true;
+      return false;
+    }
+#endif
+  }
+  if (!ok) {
+    RemoveFile(write_path_);
+    return false;
+  }
+  committed_ = true;
+  return true;
+}
+
+bool FileSink::WriteOut(const uint8_t* data, size_t size) {
+#if defined(_WIN32)
+  HANDLE file = reinterpret_cast<HANDLE>(file_);
+  while (size != 0) {
+    const DWORD request =
+        size > 0x40000000u ? 0x40000000u : static_cast<DWORD>(size);
+    DWORD written = 0;
+    if (!::WriteFile(file, data, request, &written, nullptr) ||
+        written == 0) {
+      Fail();
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+#else
+  while (size != 0) {
+    const ssize_t written = write(static_cast<int>(file_), data, size);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) {
+      Fail();
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+#endif
+  return true;
+}
+
+void FileSink::Fail() {
+  if (error_ == 0) error_ = LastError();
+  // An error that left no code still counts as a failure.
+#if defined(_WIN32)
+  if (error_ == 0) error_ = ERROR_WRITE_FAULT;
+#else
+  if (error_ == 0) error_ = EIO;
+#endif
+}
+
+bool FileSink::Close() {
+  if (file_ < 0) return true;
+#if defined(_WIN32)
+  const bool ok = CloseHandle(reinterpret_cast<HANDLE>(file_)) != 0;
+#else
+  // close() may report a deferred write error, but must not be retried.
+  const bool ok = close(static_cast<int>(file_)) == 0;
+#endif
+  file_ = -1;
+  if (!ok) Fail();
+  return ok;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,87 @@
+#ifndef SCREENSHOT_CORE_FILE_SINK_H_
+#define SCREENSHOT_CORE_FILE_SINK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "byte_sink.h"
+
+namespace screenshot {
+
+struct FileSinkOptions {
+  // Bytes handed to the OS per write; smaller writes are gathered until a
+  // chunk is full.
+  size_t chunk_size = kSinkChunkSize;
+  // Flush the file (and, for an atomic write, its directory) to stable
+  // storage before Commit() returns.
+  bool sync = false;
+  // Write to a temporary file next to the target and rename it over the
+  // target in Commit(), so readers see either the old file or the complete
+  // new one, never a partial write.
+  bool atomic = true;
+};
+
+// Streams bytes to a file in fixed-size chunks.
+//
+// Nothing is final until Commit(): a sink destroyed without a successful
+// Commit() deletes what it wrote (the temporary file for an atomic write,
+// the target itself otherwise). Not thread-safe.
+class FileSink : public ByteSink {
+ public:
+  // Opens |path| (UTF-8) for writing, replacing any existing file. Returns
+  // null on failure, with the OS error code in |error| if given.
+  static std::unique_ptr<FileSink> Open(
+      const std::string& path,
+      const FileSinkOptions& options = FileSinkOptions(),
+      int* error = nullptr);
+
+  ~FileSink() override;
+
+  FileSink(const FileSink&) = delete;
+  FileSink& operator=(const FileSink&) = delete;
+
+  bool Write(const uint8_t* data, size_t size) override;
+
+  // Writes out buffered bytes, syncs and closes the file and, for an atomic
+  // write, renames it into place. Returns false if any step (or an earlier
+  // Write()) failed, in which case nothing is left at the target.
+  bool Commit();
+
+  // Bytes accepted by Write() so far.
+  uint64_t size() const { return size_; }
+
+  // OS error code (errno, or GetLastError() on Windows) of the first
+  // failure; 0 if nothing failed.
+  int error() const { return error_; }
+
+ private:
+  FileSink(const std::string& path, const std::string& write_path,
+           intptr_t file, const FileSinkOptions& options);
+
+  // Writes |size| bytes straight to the file.
+  bool WriteOut(const uint8_t* data, size_t size);
+
+  // Records the current OS error as the first failure.
+  void Fail();
+
+  // Closes the file if it is open.
+  bool Close();
+
+  std::string path_;
+  // Where bytes are written: a temporary file for an atomic write.
+  std::string write_path_;
+  intptr_t file_;
+  FileSinkOptions options_;
+  std::vector<uint8_t> chunk_;
+  size_t buffered_ = 0;
+  uint64_t size_ = 0;
+  int error_ = 0;
+  bool committed_ = false;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_FILE_SINK_H_
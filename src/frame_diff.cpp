@@ -0,0 +1,240 @@
+#include "frame_diff.h"
+
+#include <cstring>
+
+#include "cpu_features.h"
+
+#if SCREENSHOT_ARCH_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+constexpr int kDefaultTileSize = 64;
+
+bool PixelsEqualScalar(const uint8_t* a, const uint8_t* b, size_t pixels,
+                       bool ignore_alpha) {
+  const uint32_t mask = ignore_alpha ? 0x00FFFFFFu : 0xFFFFFFFFu;
+  for (size_t i = 0; i < pixels; ++i) {
+    uint32_t pa;
+    uint32_t pb;
+    std::memcpy(&pa, a + i * kBytesPerPixel, sizeof(pa));
+    std::memcpy(&pb, b + i * kBytesPerPixel, sizeof(pb));
+    if (((pa ^ pb) & mask) != 0) return false;
+  }
+  return true;
+}
+
+#if SCREENSHOT_ARCH_X86
+// Each kernel compares as many whole vectors as it can and returns how many
+// pixels it covered, or SIZE_MAX on the first difference.
+constexpr size_t kDifferent = ~size_t{0};
+
+size_t PixelsEqualSse2(const uint8_t* a, const uint8_t* b, size_t pixels,
+                       bool ignore_alpha) {
+  const __m128i mask =
+      _mm_set1_epi32(ignore_alpha ? 0x00FFFFFF : static_cast<int>(~0u));
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  // 64 bytes per iteration, OR-ing the differences before testing.
+  for (; i + 16 <= pixels; i += 16) {
+    const __m128i* pa = reinterpret_cast<const __m128i*>(a + i * 4);
+    const __m128i* pb = reinterpret_cast<const __m128i*>(b + i * 4);
+    __m128i x = _mm_xor_si128(_mm_loadu_si128(pa), _mm_loadu_si128(pb));
+    x = _mm_or_si128(x, _mm_xor_si128(_mm_loadu_si128(pa + 1),
+                                      _mm_loadu_si128(pb + 1)));
+    x = _mm_or_si128(x, _mm_xor_si128(_mm_loadu_si128(pa + 2),
+                                      _mm_loadu_si128(pb + 2)));
+    x = _mm_or_si128(x, _mm_xor_si128(_mm_loadu_si128(pa + 3),
+                                      _mm_loadu_si128(pb + 3)));
+    x = _mm_and_si128(x, mask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero)) != 0xFFFF) {
+      return kDifferent;
+    }
+  }
+  for (; i + 4 <= pixels; i += 4) {
+    const __m128i x = _mm_and_si128(
+        _mm_xor_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i * 4)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i * 4))),
+        mask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero)) != 0xFFFF) {
+      return kDifferent;
+    }
+  }
+  return i;
+}
+
+SCREENSHOT_TARGET_AVX2
+size_t PixelsEqualAvx2(const uint8_t* a, const uint8_t* b, size_t pixels,
+                       bool ignore_alpha) {
+  const __m256i mask =
+      _mm256_set1_epi32(ignore_alpha ? 0x00FFFFFF : static_cast<int>(~0u));
+  size_t i = 0;
+  for (; i + 32 <= pixels; i += 32) {
+    const __m256i* pa = reinterpret_cast<const __m256i*>(a + i * 4);
+    const __m256i* pb = reinterpret_cast<const __m256i*>(b + i * 4);
+    __m256i x = _mm256_xor_si256(_mm256_loadu_si256(pa),
+                                 _mm256_loadu_si256(pb));
+    x = _mm256_or_si256(x, _mm256_xor_si256(_mm256_loadu_si256(pa + 1),
+                                            _mm256_loadu_si256(pb + 1)));
+    x = _mm256_or_si256(x, _mm256_xor_si256(_mm256_loadu_si256(pa + 2),
+                                            _mm256_loadu_si256(pb + 2)));
+    x = _mm256_or_si256(x, _mm256_xor_si256(_mm256_loadu_si256(pa + 3),
+                                            _mm256_loadu_si256(pb + 3)));
+    if (!_mm256_testz_si256(x, mask)) return kDifferent;
+  }
+  for (; i + 8 <= pixels; i += 8) {
+    const __m256i x = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i * 4)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i * 4)));
+    if (!_mm256_testz_si256(x, mask)) return kDifferent;
+  }
+  return i;
+}
+#endif  // SCREENSHOT_ARCH_X86
+
+}  // namespace
+
+bool PixelsEqual(const uint8_t* a, const uint8_t* b, size_t pixels,
+                 bool ignore_alpha) {
+  size_t done = 0;
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& cpu = GetCpuFeatures();
+  if (cpu.avx2) {
+    done = PixelsEqualAvx2(a, b, pixels, ignore_alpha);
+  } else if (cpu.sse2) {
+    done = PixelsEqualSse2(a, b, pixels, ignore_alpha);
+  }
+  if (done == kDifferent) return false;
+#endif
+  return PixelsEqualScalar(a + done * kBytesPerPixel, b + done * kBytesPerPixel,
+                           pixels - done, ignore_alpha);
+}
+
+FrameDiffer::FrameDiffer(const FrameDiffOptions& options) : options_(options) {
+  if (options_.tile_size <= 0) options_.tile_size = kDefaultTileSize;
+}
+
+void FrameDiffer::set_options(const FrameDiffOptions& options) {
+  options_ = options;
+  if (options_.tile_size <= 0) options_.tile_size = kDefaultTileSize;
+  Reset();
+}
+
+void FrameDiffer::Reset() { has_reference_ = false; }
+
+ImageView FrameDiffer::reference() const {
+  if (!has_reference_) return ImageView();
+  return ImageView{reference_.data(), width_, height_,
+                   static_cast<size_t>(width_) * kBytesPerPixel, format_};
+}
+
+TileRect FrameDiffer::TileAt(int tx, int ty) const {
+  const int tile = options_.tile_size;
+  TileRect rect;
+  rect.x = tx * tile;
+  rect.y = ty * tile;
+  rect.width = width_ - rect.x < tile ? width_ - rect.x : tile;
+  rect.height = height_ - rect.y < tile ? height_ - rect.y : tile;
+  return rect;
+}
+
+int FrameDiffer::ThreadCount() const {
+  return ThreadPool::ResolveThreadCount(options_.threads);
+}
+
+void FrameDiffer::DiffTileRow(const ImageView& frame, int row) {
+  const int tile = options_.tile_size;
+  const int tiles_x = (width_ + tile - 1) / tile;
+  const int y0 = row * tile;
+  const int rows = height_ - y0 < tile ? height_ - y0 : tile;
+  const size_t ref_stride = static_cast<size_t>(width_) * kBytesPerPixel;
+  uint8_t* changed = changed_.data() + static_cast<size_t>(row) *
+                                           static_cast<size_t>(tiles_x);
+  for (int tx = 0; tx < tiles_x; ++tx) {
+    const int x0 = tx * tile;
+    const size_t pixels = static_cast<size_t>(
+        width_ - x0 < tile ? width_ - x0 : tile);
+    const size_t offset = static_cast<size_t>(x0) * kBytesPerPixel;
+    int r = 0;
+    for (; r < rows; ++r) {
+      const uint8_t* src = frame.Row(y0 + r) + offset;
+      const uint8_t* ref =
+          reference_.data() + static_cast<size_t>(y0 + r) * ref_stride + offset;
+      if (!PixelsEqual(src, ref, pixels, options_.ignore_alpha)) break;
+    }
+    changed[tx] = r < rows ? 1 : 0;
+    // Rows above the first difference already match.
+    for (; r < rows; ++r) {
+      std::memcpy(
+          reference_.data() + static_cast<size_t>(y0 + r) * ref_stride + offset,
+          frame.Row(y0 + r) + offset, pixels * kBytesPerPixel);
+    }
+  }
+}
+
+bool FrameDiffer::Diff(const ImageView& frame, bool keyframe,
+                       FrameDiff* diff) {
+  diff->tiles.clear();
+  diff->keyframe = false;
+  if (!frame.IsValid()) {
+    Reset();
+    return false;
+  }
+  const int tile = options_.tile_size;
+  const int tiles_x = (frame.width + tile - 1) / tile;
+  const int tiles_y = (frame.height + tile - 1) / tile;
+  const bool comparable = has_reference_ && frame.width == width_ &&
+                          frame.height == height_ && frame.format == format_;
+
+  if (keyframe || !comparable) {
+    width_ = frame.width;
+    height_ = frame.height;
+    format_ = frame.format;
+    const size_t row_bytes = frame.RowBytes();
+    reference_.resize(row_bytes * static_cast<size_t>(height_));
+    for (int y = 0; y < height_; ++y) {
+      std::memcpy(reference_.data() + static_cast<size_t>(y) * row_bytes,
+                  frame.Row(y), row_bytes);
+    }
+    has_reference_ = true;
+    diff->keyframe = true;
+    for (int ty = 0; ty < tiles_y; ++ty) {
+      for (int tx = 0; tx < tiles_x; ++tx) {
+        diff->tiles.push_back(TileAt(tx, ty));
+      }
+    }
+    return true;
+  }
+
+  changed_.resize(static_cast<size_t>(tiles_x) * static_cast<size_t>(tiles_y));
+  int threads = ThreadCount();
+  if (threads > tiles_y) threads = tiles_y;
+  if (threads > 1) {
+    const int workers = threads - 1;
+    if (!pool_ || pool_->size() != workers) {
+      pool_ = std::make_unique<ThreadPool>(workers);
+    }
+    pool_->ParallelFor(static_cast<size_t>(tiles_y), [&](size_t row) {
+      DiffTileRow(frame, static_cast<int>(row));
+    });
+  } else {
+    for (int ty = 0; ty < tiles_y; ++ty) DiffTileRow(frame, ty);
+  }
+
+  for (int ty = 0; ty < tiles_y; ++ty) {
+    for (int tx = 0; tx < tiles_x; ++tx) {
+      const size_t index = static_cast<size_t>(ty) *
+                               static_cast<size_t>(tiles_x) +
+                           static_cast<size_t>(tx);
+      if (changed_[index]) diff->tiles.push_back(TileAt(tx, ty));
+    }
+  }
+  return true;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,99 @@
+#ifndef SCREENSHOT_CORE_FRAME_DIFF_H_
+#define SCREENSHOT_CORE_FRAME_DIFF_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "image.h"
+#include "thread_pool.h"
+
+namespace screenshot {
+
+struct FrameDiffOptions {
+  // Edge length of the square tiles frames are compared in. Tiles in the
+  // last column and row are clipped to the frame.
+  int tile_size = 64;
+  // Compare only the color bytes; GDI leaves screen alpha undefined, so it
+  // can differ between otherwise identical captures.
+  bool ignore_alpha = true;
+  // Threads comparing rows of tiles; 0 uses every core.
+  int threads = 1;
+};
+
+// A tile of the frame, in pixels.
+struct TileRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+struct FrameDiff {
+  // Every tile is listed: there was no comparable previous frame or one was
+  // requested.
+  bool keyframe = false;
+  // Changed tiles in row-major order.
+  std::vector<TileRect> tiles;
+};
+
+// Returns the tiles of a frame that differ from the previous frame.
+//
+// Keeps a packed copy of the last frame it was given and compares new frames
+// against it tile by tile with an early-out SIMD compare, so unchanged
+// content (usually most of a desktop) costs one read of each frame and no
+// writes. Changed tiles are copied into the reference as they are found.
+// Buffers are reused, so steady-state calls at a fixed size allocate nothing.
+// Not thread-safe.
+class FrameDiffer {
+ public:
+  explicit FrameDiffer(const FrameDiffOptions& options = FrameDiffOptions());
+
+  const FrameDiffOptions& options() const { return options_; }
+  // Changing the options drops the reference frame.
+  void set_options(const FrameDiffOptions& options);
+
+  // Compares |frame| with the previous frame, writes the changed tiles to
+  // |diff| and makes |frame| the new reference. The result is a keyframe
+  // (every tile) for the first frame, after Reset(), when the size or pixel
+  // format changes, or when |keyframe| is set. Returns false (and drops the
+  // reference) if |frame| is invalid.
+  bool Diff(const ImageView& frame, bool keyframe, FrameDiff* diff);
+
+  // Forgets the reference frame; the next Diff() is a keyframe.
+  void Reset();
+
+  // The current reference frame; invalid before the first Diff().
+  ImageView reference() const;
+
+ private:
+  // Compares and refreshes the tiles of tile row |row|, recording changes in
+  // changed_.
+  void DiffTileRow(const ImageView& frame, int row);
+
+  // Tile (tx, ty) of the reference frame, clipped to it.
+  TileRect TileAt(int tx, int ty) const;
+
+  // Worker count for options_.threads.
+  int ThreadCount() const;
+
+  FrameDiffOptions options_;
+  std::vector<uint8_t> reference_;
+  int width_ = 0;
+  int height_ = 0;
+  PixelFormat format_ = PixelFormat::kBgra8;
+  bool has_reference_ = false;
+  // One flag per tile, row-major.
+  std::vector<uint8_t> changed_;
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+// Whether |pixels| 4-byte pixels at |a| and |b| are equal, optionally
+// ignoring the fourth byte of each.
+bool PixelsEqual(const uint8_t* a, const uint8_t* b, size_t pixels,
+                 bool ignore_alpha);
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_FRAME_DIFF_H_
@@ -0,0 +1,28 @@
+#include "frame_mailbox.h"
+
+namespace screenshot {
+
+bool FrameMailbox::Publish() {
+  // Release makes the frame's contents visible to the consumer; acquire
+  // makes sure the consumer is done with the slot we get back.
+  const uint8_t previous = middle_.exchange(
+      static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel);
+  back_ = static_cast<uint8_t>(previous & kIndexMask);
+  return (previous & kFresh) != 0;
+}
+
+StreamFrame* FrameMailbox::Acquire() {
+  // Only the consumer clears kFresh, so once it is seen it stays set until
+  // the exchange below, even if the producer publishes in between.
+  if (!HasFrame()) return nullptr;
+  const uint8_t previous =
+      middle_.exchange(front_, std::memory_order_acq_rel);
+  front_ = static_cast<uint8_t>(previous & kIndexMask);
+  return &slots_[front_];
+}
+
+bool FrameMailbox::HasFrame() const {
+  return (middle_.load(std::memory_order_relaxed) & kFresh) != 0;
+}
+
+}  // namespace screenshot
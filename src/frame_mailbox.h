@@ -0,0 +1,78 @@
+#ifndef SCREENSHOT_CORE_FRAME_MAILBOX_H_
+#define SCREENSHOT_CORE_FRAME_MAILBOX_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image.h"
+
+namespace screenshot {
+
+// A captured frame and the buffer that holds it. The buffer is reused from
+// frame to frame, so once it has grown to the screen size capturing into it
+// does not allocate.
+struct StreamFrame {
+  std::vector<uint8_t> pixels;
+  int width = 0;
+  int height = 0;
+  size_t stride = 0;
+  PixelFormat format = PixelFormat::kBgra8;
+  // Position in the capture order, starting at 0. Dropped frames leave gaps.
+  uint64_t sequence = 0;
+  // Monotonic (steady clock) time the capture started, in microseconds.
+  int64_t timestamp_us = 0;
+
+  ImageView View() const {
+    return ImageView{pixels.data(), width, height, stride, format};
+  }
+};
+
+// Lock-free triple buffer handing frames from one producer thread to one
+// consumer thread.
+//
+// The producer fills back(), then Publish() swaps it with the shared middle
+// slot; the consumer's Acquire() swaps the middle slot with its front slot.
+// Neither side ever waits for the other, and the consumer always gets the
+// newest frame: if the producer publishes twice before the consumer looks,
+// the older frame is overwritten (dropped) rather than queued.
+class FrameMailbox {
+ public:
+  FrameMailbox() = default;
+
+  FrameMailbox(const FrameMailbox&) = delete;
+  FrameMailbox& operator=(const FrameMailbox&) = delete;
+
+  // Producer: the slot to fill next.
+  StreamFrame* back() { return &slots_[back_]; }
+
+  // Producer: makes back() the newest frame and hands the producer a free
+  // slot. Returns true if this replaced a frame the consumer never took.
+  bool Publish();
+
+  // Consumer: takes the newest published frame, or returns null if nothing
+  // was published since the last call. The frame stays valid until the next
+  // Acquire().
+  StreamFrame* Acquire();
+
+  // Consumer: whether a frame is waiting to be acquired.
+  bool HasFrame() const;
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  // Set in middle_ while the middle slot holds a frame not yet acquired.
+  static constexpr uint8_t kFresh = 0x4;
+
+  StreamFrame slots_[3];
+  // Owned by the producer.
+  uint8_t back_ = 0;
+  // Shared: middle slot index plus kFresh.
+  std::atomic<uint8_t> middle_{1};
+  // Owned by the consumer.
+  uint8_t front_ = 2;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_FRAME_MAILBOX_H_
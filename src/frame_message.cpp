@@ -0,0 +1,113 @@
+#include "frame_message.h"
+
+#include <cstring>
+
+#include "pixel_convert.h"
+#include "trace.h"
+
+namespace screenshot {
+
+namespace {
+
+// Byte-wise, so the layout does not depend on the host's endianness.
+void PutLe(uint64_t value, size_t bytes, uint8_t* out) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint64_t GetLe(const uint8_t* in, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+void WriteFrameMessageHeader(const FrameMessageHeader& header, uint8_t* out) {
+  PutLe(kFrameMessageMagic, 4, out);
+  out[4] = static_cast<uint8_t>(header.kind);
+  out[5] = static_cast<uint8_t>(header.format);
+  PutLe(kFrameMessageHeaderSize, 2, out + 6);
+  PutLe(header.width, 4, out + 8);
+  PutLe(header.height, 4, out + 12);
+  PutLe(header.stride, 4, out + 16);
+  PutLe(0, 4, out + 20);
+  PutLe(header.sequence, 8, out + 24);
+  PutLe(static_cast<uint64_t>(header.timestamp_us), 8, out + 32);
+}
+
+bool ReadFrameMessageHeader(const uint8_t* data, size_t size,
+                            FrameMessageHeader* header,
+                            size_t* payload_offset) {
+  if (size < kFrameMessageHeaderSize) return false;
+  if (GetLe(data, 4) != kFrameMessageMagic) return false;
+  const size_t header_size = static_cast<size_t>(GetLe(data + 6, 2));
+  if (header_size < kFrameMessageHeaderSize || header_size > size) {
+    return false;
+  }
+  if (data[4] > static_cast<uint8_t>(FrameMessageKind::kError) ||
+      data[5] > static_cast<uint8_t>(CaptureFormat::kWebp)) {
+    return false;
+  }
+  header->kind = static_cast<FrameMessageKind>(data[4]);
+  header->format = static_cast<CaptureFormat>(data[5]);
+  header->width = static_cast<uint32_t>(GetLe(data + 8, 4));
+  header->height = static_cast<uint32_t>(GetLe(data + 12, 4));
+  header->stride = static_cast<uint32_t>(GetLe(data + 16, 4));
+  header->sequence = GetLe(data + 24, 8);
+  header->timestamp_us = static_cast<int64_t>(GetLe(data + 32, 8));
+  *payload_offset = header_size;
+  return true;
+}
+
+uint8_t* StartFrameMessage(const FrameMessageHeader& header,
+                           size_t payload_size, std::vector<uint8_t>* message) {
+  message->resize(kFrameMessageHeaderSize + payload_size);
+  WriteFrameMessageHeader(header, message->data());
+  return message->data() + kFrameMessageHeaderSize;
+}
+
+bool EncodeFrameMessage(EncoderSession* session, const ImageView& image,
+                        const EncodeSettings& settings, uint64_t sequence,
+                        int64_t timestamp_us, std::vector<uint8_t>* message) {
+  TraceSpan span("frame message");
+  message->clear();
+  if (!image.IsValid()) return false;
+  FrameMessageHeader header;
+  header.format = settings.format;
+  header.width = static_cast<uint32_t>(image.width);
+  header.height = static_cast<uint32_t>(image.height);
+  header.sequence = sequence;
+  header.timestamp_us = timestamp_us;
+
+  if (settings.format == CaptureFormat::kRawBgra ||
+      settings.format == CaptureFormat::kRawRgba) {
+    const PixelFormat format = settings.format == CaptureFormat::kRawRgba
+                                   ? PixelFormat::kRgba8
+                                   : PixelFormat::kBgra8;
+    const size_t stride = image.RowBytes();
+    header.stride = static_cast<uint32_t>(stride);
+    uint8_t* payload = StartFrameMessage(
+        header, stride * static_cast<size_t>(image.height), message);
+    if (!ConvertImage(image, format, true, payload, stride)) {
+      message->clear();
+      return false;
+    }
+    return true;
+  }
+
+  if (!session->Encode(image, settings)) return false;
+  header.stride = static_cast<uint32_t>(session->stride());
+  // Appending rather than resizing skips zero-filling the payload.
+  message->reserve(kFrameMessageHeaderSize + session->size());
+  message->resize(kFrameMessageHeaderSize);
+  WriteFrameMessageHeader(header, message->data());
+  message->insert(message->end(), session->data(),
+                  session->data() + session->size());
+  return true;
+}
+
+}  // namespace screenshot
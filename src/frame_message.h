@@ -0,0 +1,80 @@
+#ifndef SCREENSHOT_CORE_FRAME_MESSAGE_H_
+#define SCREENSHOT_CORE_FRAME_MESSAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "encoder_session.h"
+#include "image.h"
+
+namespace screenshot {
+
+// Binary replies of the "dev.flutter.screenshot/frame" channel: a fixed
+// little-endian header followed by the payload, so frames reach Dart
+// without being wrapped in an EncodableMap and serialized by the method
+// codec.
+//
+//   offset  size  field
+//        0     4  magic, "SSFM"
+//        4     1  kind (FrameMessageKind)
+//        5     1  format (CaptureFormat, in declaration order)
+//        6     2  header size in bytes (kFrameMessageHeaderSize)
+//        8     4  width
+//       12     4  height
+//       16     4  stride (0 for image formats)
+//       20     4  reserved, 0
+//       24     8  sequence
+//       32     8  timestamp, microseconds on the steady clock
+//       40        payload
+//
+// Readers skip to the header size given in the message, so fields can be
+// appended later without breaking them.
+enum class FrameMessageKind : uint8_t {
+  // The payload holds the pixels or encoded image.
+  kFrame = 0,
+  // No frame and no payload (e.g. a cancelled region selection).
+  kNull = 1,
+  // The payload is a StandardMethodCodec error envelope.
+  kError = 2,
+};
+
+struct FrameMessageHeader {
+  FrameMessageKind kind = FrameMessageKind::kFrame;
+  CaptureFormat format = CaptureFormat::kPng;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t stride = 0;
+  uint64_t sequence = 0;
+  int64_t timestamp_us = 0;
+};
+
+constexpr uint32_t kFrameMessageMagic = 0x4D465353;  // "SSFM"
+constexpr size_t kFrameMessageHeaderSize = 40;
+
+// Writes |header| into the first kFrameMessageHeaderSize bytes of |out|.
+void WriteFrameMessageHeader(const FrameMessageHeader& header, uint8_t* out);
+
+// Reads the header of a |size|-byte message. |payload_offset| receives
+// where the payload starts. Returns false if the message is too short, has
+// the wrong magic or an unknown kind or format.
+bool ReadFrameMessageHeader(const uint8_t* data, size_t size,
+                            FrameMessageHeader* header,
+                            size_t* payload_offset);
+
+// Replaces |message| with |header| followed by |payload_size| bytes and
+// returns the payload, for the caller to fill in.
+uint8_t* StartFrameMessage(const FrameMessageHeader& header,
+                           size_t payload_size, std::vector<uint8_t>* message);
+
+// Builds the message for a captured frame. Raw formats are converted
+// straight into the payload; the others are encoded with |session| and
+// copied in once. Returns false if |image| cannot be encoded as |settings|
+// asks.
+bool EncodeFrameMessage(EncoderSession* session, const ImageView& image,
+                        const EncodeSettings& settings, uint64_t sequence,
+                        int64_t timestamp_us, std::vector<uint8_t>* message);
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_FRAME_MESSAGE_H_
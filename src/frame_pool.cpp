@@ -0,0 +1,175 @@
+#include "frame_pool.h"
+
+#include <cstdlib>
+#include <utility>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+// Uninitialized, unlike std::vector, which would zero a whole frame.
+uint8_t* AllocateAligned(size_t size) {
+  size = (size + FramePool::kAlignment - 1) / FramePool::kAlignment *
+         FramePool::kAlignment;
+#ifdef _WIN32
+  return static_cast<uint8_t*>(_aligned_malloc(size, FramePool::kAlignment));
+#else
+  return static_cast<uint8_t*>(std::aligned_alloc(FramePool::kAlignment, size));
+#endif
+}
+
+void FreeAligned(uint8_t* data) {
+#ifdef _WIN32
+  _aligned_free(data);
+#else
+  std::free(data);
+#endif
+}
+
+}  // namespace
+
+FrameBuffer::~FrameBuffer() { FreeAligned(data_); }
+
+FramePool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), buffer_(other.buffer_) {
+  other.pool_ = nullptr;
+  other.buffer_ = nullptr;
+}
+
+FramePool::Lease& FramePool::Lease::operator=(Lease&& other) noexcept {
+  if (this != &other) {
+    Reset();
+    std::swap(pool_, other.pool_);
+    std::swap(buffer_, other.buffer_);
+  }
+  return *this;
+}
+
+void FramePool::Lease::Reset() {
+  if (buffer_) pool_->Release(buffer_);
+  pool_ = nullptr;
+  buffer_ = nullptr;
+}
+
+FramePool::FramePool(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+FramePool::~FramePool() = default;
+
+FramePool::Lease FramePool::Acquire(int width, int height,
+                                    PixelFormat format) {
+  if (width <= 0 || height <= 0) return Lease();
+  const size_t stride = static_cast<size_t>(width) * kBytesPerPixel;
+  if (stride / kBytesPerPixel != static_cast<size_t>(width) ||
+      stride > static_cast<size_t>(-1) / static_cast<size_t>(height)) {
+    return Lease();
+  }
+  const size_t size = stride * static_cast<size_t>(height);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (FrameBuffer* buffer = newest_idle_; buffer; buffer = buffer->older_) {
+    if (buffer->width_ == width && buffer->height_ == height &&
+        buffer->format_ == format) {
+      UnlinkLocked(buffer);
+      ++stats_.hits;
+      stats_.leased_bytes += buffer->size_;
+      return Lease(this, buffer);
+    }
+  }
+
+  ++stats_.misses;
+  // Make room among the idle buffers first; if that is not enough (or the
+  // allocation fails) give up every idle buffer before failing.
+  EvictLocked(max_bytes_ > size ? max_bytes_ - size : 0);
+  uint8_t* data = AllocateAligned(size);
+  if (!data && oldest_idle_) {
+    EvictLocked(0);
+    data = AllocateAligned(size);
+  }
+  if (!data) return Lease();
+
+  std::unique_ptr<FrameBuffer> buffer(new FrameBuffer());
+  buffer->data_ = data;
+  buffer->size_ = size;
+  buffer->width_ = width;
+  buffer->height_ = height;
+  buffer->format_ = format;
+  stats_.resident_bytes += size;
+  stats_.leased_bytes += size;
+  buffers_.push_back(std::move(buffer));
+  return Lease(this, buffers_.back().get());
+}
+
+size_t FramePool::max_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_bytes_;
+}
+
+void FramePool::set_max_bytes(size_t max_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_bytes_ = max_bytes;
+  EvictLocked(max_bytes_);
+}
+
+void FramePool::Trim() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  EvictLocked(0);
+}
+
+FramePoolStats FramePool::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FramePoolStats stats = stats_;
+  stats.buffers = buffers_.size();
+  return stats;
+}
+
+void FramePool::Release(FrameBuffer* buffer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.leased_bytes -= buffer->size_;
+  buffer->newer_ = nullptr;
+  buffer->older_ = newest_idle_;
+  if (newest_idle_) newest_idle_->newer_ = buffer;
+  newest_idle_ = buffer;
+  if (!oldest_idle_) oldest_idle_ = buffer;
+  EvictLocked(max_bytes_);
+}
+
+void FramePool::UnlinkLocked(FrameBuffer* buffer) {
+  if (buffer->newer_) {
+    buffer->newer_->older_ = buffer->older_;
+  } else {
+    newest_idle_ = buffer->older_;
+  }
+  if (buffer->older_) {
+    buffer->older_->newer_ = buffer->newer_;
+  } else {
+    oldest_idle_ = buffer->newer_;
+  }
+  buffer->newer_ = nullptr;
+  buffer->older_ = nullptr;
+}
+
+void FramePool::EvictLocked(size_t max_bytes) {
+  while (stats_.resident_bytes > max_bytes && oldest_idle_) {
+    FrameBuffer* buffer = oldest_idle_;
+    UnlinkLocked(buffer);
+    FreeLocked(buffer);
+    ++stats_.evictions;
+  }
+}
+
+void FramePool::FreeLocked(FrameBuffer* buffer) {
+  stats_.resident_bytes -= buffer->size_;
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    if (buffers_[i].get() == buffer) {
+      buffers_[i] = std::move(buffers_.back());
+      buffers_.pop_back();
+      return;
+    }
+  }
+}
+
+}  // namespace screenshot
@@ -0,0 +1,144 @@
+#ifndef SCREENSHOT_CORE_FRAME_POOL_H_
+#define SCREENSHOT_CORE_FRAME_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "image.h"
+
+namespace screenshot {
+
+// A frame-sized pixel buffer owned by a FramePool. Rows are packed
+// (stride == width * 4), as GetDIBits writes them, and the first row starts
+// on a kAlignment boundary. Contents are left over from the previous lease.
+class FrameBuffer {
+ public:
+  ~FrameBuffer();
+
+  FrameBuffer(const FrameBuffer&) = delete;
+  FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+  uint8_t* data() { return data_; }
+  const uint8_t* data() const { return data_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  size_t stride() const { return static_cast<size_t>(width_) * kBytesPerPixel; }
+  PixelFormat format() const { return format_; }
+  size_t size() const { return size_; }
+
+  ImageView View() const {
+    return ImageView{data_, width_, height_, stride(), format_};
+  }
+
+ private:
+  friend class FramePool;
+
+  FrameBuffer() = default;
+
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+  PixelFormat format_ = PixelFormat::kBgra8;
+  // Idle list links, most recently released at the head.
+  FrameBuffer* newer_ = nullptr;
+  FrameBuffer* older_ = nullptr;
+};
+
+struct FramePoolStats {
+  // Acquire() calls served by an idle buffer, and those that allocated.
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // Idle buffers freed to stay under the cap or by Trim().
+  uint64_t evictions = 0;
+  // Bytes held by the pool, leased or idle, and the leased part of it.
+  size_t resident_bytes = 0;
+  size_t leased_bytes = 0;
+  size_t buffers = 0;
+};
+
+// Recycles frame buffers so that capturing the same screen over and over
+// does not allocate (and zero) a full frame each time.
+//
+// Buffers are keyed by width, height and pixel format. A released buffer
+// stays in the pool until it is reused by an Acquire() with the same key or
+// evicted, least recently released first, when the resident size would
+// exceed the cap. Leased buffers are never evicted, so the cap can be
+// exceeded while they are out; the excess is freed as they come back.
+//
+// Thread-safe. Leases must be released before the pool is destroyed.
+class FramePool {
+ public:
+  static constexpr size_t kAlignment = 64;
+  static constexpr size_t kDefaultMaxBytes = size_t{256} << 20;
+
+  // Exclusive use of a buffer until destroyed or Reset().
+  class Lease {
+   public:
+    Lease() = default;
+    ~Lease() { Reset(); }
+
+    Lease(Lease&& other) noexcept;
+    Lease& operator=(Lease&& other) noexcept;
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    // Hands the buffer back to the pool.
+    void Reset();
+
+    FrameBuffer* get() const { return buffer_; }
+    FrameBuffer* operator->() const { return buffer_; }
+    FrameBuffer& operator*() const { return *buffer_; }
+    explicit operator bool() const { return buffer_ != nullptr; }
+
+   private:
+    friend class FramePool;
+    Lease(FramePool* pool, FrameBuffer* buffer)
+        : pool_(pool), buffer_(buffer) {}
+
+    FramePool* pool_ = nullptr;
+    FrameBuffer* buffer_ = nullptr;
+  };
+
+  explicit FramePool(size_t max_bytes = kDefaultMaxBytes);
+  ~FramePool();
+
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  // Leases a |width| x |height| buffer, reusing an idle one with the same
+  // dimensions and format if there is one. Returns an empty lease if the
+  // dimensions are not positive or the memory cannot be allocated.
+  Lease Acquire(int width, int height, PixelFormat format);
+
+  size_t max_bytes() const;
+  // Changes the cap, evicting idle buffers that no longer fit.
+  void set_max_bytes(size_t max_bytes);
+
+  // Frees every idle buffer.
+  void Trim();
+
+  FramePoolStats stats() const;
+
+ private:
+  void Release(FrameBuffer* buffer);
+
+  // Idle list and eviction; require mutex_.
+  void UnlinkLocked(FrameBuffer* buffer);
+  void EvictLocked(size_t max_bytes);
+  void FreeLocked(FrameBuffer* buffer);
+
+  mutable std::mutex mutex_;
+  size_t max_bytes_;
+  std::vector<std::unique_ptr<FrameBuffer>> buffers_;
+  FrameBuffer* newest_idle_ = nullptr;
+  FrameBuffer* oldest_idle_ = nullptr;
+  FramePoolStats stats_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_FRAME_POOL_H_
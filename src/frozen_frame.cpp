@@ -0,0 +1,39 @@
+#include "frozen_frame.h"
+
+#include <utility>
+
+namespace screenshot {
+
+FrozenFrame::FrozenFrame(FramePool::Lease frame, int origin_x, int origin_y,
+                         int64_t timestamp_us)
+    : frame_(std::move(frame)),
+      origin_x_(origin_x),
+      origin_y_(origin_y),
+      timestamp_us_(timestamp_us) {}
+
+PixelRect FrozenFrame::bounds() const {
+  if (!frame_) return PixelRect();
+  return PixelRect{origin_x_, origin_y_, frame_->width(), frame_->height()};
+}
+
+ImageView FrozenFrame::View() const {
+  if (!frame_) return ImageView();
+  return frame_->View();
+}
+
+bool FrozenFrame::Crop(const PixelRect& rect, ImageView* out) const {
+  if (!frame_) return false;
+  // Into the frame's own pixel coordinates.
+  const PixelRect local{rect.x - origin_x_, rect.y - origin_y_, rect.width,
+                        rect.height};
+  return CropImage(frame_->View(), local, out);
+}
+
+void FrozenFrame::Reset() {
+  frame_.Reset();
+  origin_x_ = 0;
+  origin_y_ = 0;
+  timestamp_us_ = 0;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,61 @@
+#ifndef SCREENSHOT_CORE_FROZEN_FRAME_H_
+#define SCREENSHOT_CORE_FROZEN_FRAME_H_
+
+#include <cstdint>
+
+#include "frame_pool.h"
+#include "image.h"
+#include "image_rect.h"
+
+namespace screenshot {
+
+// A frame captured before the user picks the part of it they want, such as
+// the screen under a region selection overlay, kept until that part has
+// been encoded.
+//
+// Selections are cut out of it as views into the pooled buffer, so
+// finishing a selection neither touches the screen again nor copies pixels,
+// and the result is what was on screen when the frame was taken. Movable,
+// not copyable; the buffer goes back to its pool on Reset() or destruction.
+class FrozenFrame {
+ public:
+  FrozenFrame() = default;
+
+  // |frame| holds the pixels of the area at (|origin_x|, |origin_y|) in the
+  // coordinates crops are given in (screen coordinates, for a capture),
+  // taken at |timestamp_us|.
+  FrozenFrame(FramePool::Lease frame, int origin_x, int origin_y,
+              int64_t timestamp_us);
+
+  FrozenFrame(FrozenFrame&& other) noexcept = default;
+  FrozenFrame& operator=(FrozenFrame&& other) noexcept = default;
+  FrozenFrame(const FrozenFrame&) = delete;
+  FrozenFrame& operator=(const FrozenFrame&) = delete;
+
+  explicit operator bool() const { return static_cast<bool>(frame_); }
+
+  // The area the frame covers; empty without a frame.
+  PixelRect bounds() const;
+  int64_t timestamp_us() const { return timestamp_us_; }
+
+  // The whole frame; invalid without one.
+  ImageView View() const;
+
+  // Points |out| at the part of the frame inside |rect|, clipped to
+  // bounds(), without copying. The view is valid until Reset(). Returns
+  // false if there is no frame or |rect| does not overlap it.
+  bool Crop(const PixelRect& rect, ImageView* out) const;
+
+  // Hands the buffer back to its pool.
+  void Reset();
+
+ private:
+  FramePool::Lease frame_;
+  int origin_x_ = 0;
+  int origin_y_ = 0;
+  int64_t timestamp_us_ = 0;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_FROZEN_FRAME_H_
@@ -0,0 +1,46 @@
+#ifndef SCREENSHOT_CORE_IMAGE_H_
+#define SCREENSHOT_CORE_IMAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace screenshot {
+
+// Byte order of a 32-bit pixel in memory.
+//
+// kBgra8 is what GDI (BitBlt/GetDIBits) produces on Windows; kRgba8 is the
+// order PNG and most GPU upload paths expect.
+enum class PixelFormat {
+  kBgra8,
+  kRgba8,
+};
+
+constexpr int kBytesPerPixel = 4;
+
+// Non-owning view of 8-bit-per-channel, 4-channel pixel rows.
+//
+// Rows are |stride| bytes apart; stride may be larger than width * 4 when the
+// rows are padded or the view is a window into a larger frame.
+struct ImageView {
+  const uint8_t* data = nullptr;
+  int width = 0;
+  int height = 0;
+  size_t stride = 0;
+  PixelFormat format = PixelFormat::kBgra8;
+
+  const uint8_t* Row(int y) const {
+    return data + static_cast<size_t>(y) * stride;
+  }
+
+  size_t RowBytes() const {
+    return static_cast<size_t>(width) * kBytesPerPixel;
+  }
+
+  bool IsValid() const {
+    return data != nullptr && width > 0 && height > 0 && stride >= RowBytes();
+  }
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_IMAGE_H_
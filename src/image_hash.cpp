@@ -0,0 +1,161 @@
+#include "image_hash.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "checksum.h"
+#include "trace.h"
+
+namespace screenshot {
+
+namespace {
+
+// Low frequencies kept by pHash along each axis.
+constexpr int kPHashFrequencies = 8;
+
+// DCT-II basis, cos(pi * u * (2x + 1) / 2N) at [x][u]. Leaving out the
+// usual per-frequency scale keeps the coefficients in ImageHash's
+// proportions, which the median comparison depends on.
+struct DctTable {
+  float c[kPHashSize][kPHashFrequencies];
+
+  DctTable() {
+    const double pi = std::acos(-1.0);
+    for (int x = 0; x < kPHashSize; ++x) {
+      for (int u = 0; u < kPHashFrequencies; ++u) {
+        c[x][u] = static_cast<float>(
+            std::cos(pi * u * (2 * x + 1) / (2.0 * kPHashSize)));
+      }
+    }
+  }
+};
+
+const DctTable& GetDctTable() {
+  static const DctTable table;
+  return table;
+}
+
+}  // namespace
+
+uint64_t PixelHash(const ImageView& image) {
+  if (!image.IsValid()) return 0;
+  XxHash3Stream stream(0xFF000000u);
+  const size_t row_bytes = image.RowBytes();
+  if (image.stride == row_bytes) {
+    stream.Update(image.data, row_bytes * static_cast<size_t>(image.height));
+  } else {
+    for (int y = 0; y < image.height; ++y) {
+      stream.Update(image.Row(y), row_bytes);
+    }
+  }
+  return stream.Digest();
+}
+
+uint64_t DifferenceHash(const float* luma) {
+  uint64_t hash = 0;
+  for (int y = 0; y < kDHashHeight; ++y) {
+    const float* row = luma + y * kDHashWidth;
+    for (int x = 0; x + 1 < kDHashWidth; ++x) {
+      hash = (hash << 1) | (row[x] < row[x + 1] ? 1u : 0u);
+    }
+  }
+  return hash;
+}
+
+uint64_t PerceptualHash(const float* luma) {
+  const DctTable& table = GetDctTable();
+  // Both passes are 8-wide multiply-adds into independent sums, which the
+  // compiler vectorizes without reassociating anything.
+  float rows[kPHashSize][kPHashFrequencies];
+  for (int y = 0; y < kPHashSize; ++y) {
+    float sum[kPHashFrequencies] = {};
+    const float* row = luma + y * kPHashSize;
+    for (int x = 0; x < kPHashSize; ++x) {
+      for (int u = 0; u < kPHashFrequencies; ++u) {
+        sum[u] += row[x] * table.c[x][u];
+      }
+    }
+    std::copy(sum, sum + kPHashFrequencies, rows[y]);
+  }
+  float coefficients[kPHashFrequencies * kPHashFrequencies];
+  for (int v = 0; v < kPHashFrequencies; ++v) {
+    float sum[kPHashFrequencies] = {};
+    for (int y = 0; y < kPHashSize; ++y) {
+      const float w = table.c[y][v];
+      for (int u = 0; u < kPHashFrequencies; ++u) {
+        sum[u] += w * rows[y][u];
+      }
+    }
+    std::copy(sum, sum + kPHashFrequencies,
+              coefficients + v * kPHashFrequencies);
+  }
+
+  constexpr int kCount = kPHashFrequencies * kPHashFrequencies;
+  float sorted[kCount];
+  std::copy(coefficients, coefficients + kCount, sorted);
+  std::nth_element(sorted, sorted + kCount / 2, sorted + kCount);
+  const float upper = sorted[kCount / 2];
+  const float lower = *std::max_element(sorted, sorted + kCount / 2);
+  const float median = (lower + upper) / 2;
+  uint64_t hash = 0;
+  for (int i = 0; i < kCount; ++i) {
+    hash = (hash << 1) | (coefficients[i] > median ? 1u : 0u);
+  }
+  return hash;
+}
+
+int HammingDistance(uint64_t a, uint64_t b) {
+  uint64_t x = a ^ b;
+  x -= (x >> 1) & 0x5555555555555555ull;
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+  return static_cast<int>((x * 0x0101010101010101ull) >> 56);
+}
+
+ImageHasher::ImageHasher() {
+  ResizeOptions options;
+  options.filter = ResizeFilter::kBox;
+  options.threads = 1;
+  dhash_resizer_.set_options(options);
+}
+
+bool ImageHasher::Hash(const ImageView& image, const ImageHashOptions& options,
+                       ImageHashes* hashes) {
+  *hashes = ImageHashes();
+  if (!image.IsValid()) return false;
+  TraceSpan span("hash");
+  if (options.xxh3) hashes->xxh3 = PixelHash(image);
+  if (!options.dhash && !options.phash) return true;
+
+  ResizeOptions resize_options;
+  resize_options.filter = ResizeFilter::kBox;
+  resize_options.threads = options.threads;
+  resizer_.set_options(resize_options);
+  if (!resizer_.Resize(image, kPHashSize, kPHashSize)) return false;
+  const ImageView small = resizer_.output();
+  if (options.phash) {
+    ToLuma(small, kPHashSize * kPHashSize, phash_luma_);
+    hashes->phash = PerceptualHash(phash_luma_);
+  }
+  if (options.dhash) {
+    if (!dhash_resizer_.Resize(small, kDHashWidth, kDHashHeight)) {
+      return false;
+    }
+    ToLuma(dhash_resizer_.output(), kDHashWidth * kDHashHeight, dhash_luma_);
+    hashes->dhash = DifferenceHash(dhash_luma_);
+  }
+  return true;
+}
+
+void ImageHasher::ToLuma(const ImageView& image, size_t count, float* luma) {
+  // BT.601 weights, as ImageHash's grayscale conversion uses.
+  const bool bgra = image.format == PixelFormat::kBgra8;
+  const float wb = bgra ? 0.114f : 0.299f;
+  const float wr = bgra ? 0.299f : 0.114f;
+  const uint8_t* p = image.data;
+  for (size_t i = 0; i < count; ++i, p += kBytesPerPixel) {
+    luma[i] = wb * p[0] + 0.587f * p[1] + wr * p[2];
+  }
+}
+
+}  // namespace screenshot
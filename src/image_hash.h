@@ -0,0 +1,87 @@
+#ifndef SCREENSHOT_CORE_IMAGE_HASH_H_
+#define SCREENSHOT_CORE_IMAGE_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "image.h"
+#include "image_resizer.h"
+
+namespace screenshot {
+
+// Which hashes ImageHasher::Hash() computes.
+struct ImageHashOptions {
+  bool xxh3 = true;
+  bool dhash = true;
+  bool phash = true;
+  // Threads downsampling the image for dHash and pHash; 0 uses every core.
+  int threads = 0;
+};
+
+// Fingerprints of an image. A hash that was not asked for is 0.
+struct ImageHashes {
+  // Exact: PixelHash(). Any changed pixel changes it.
+  uint64_t xxh3 = 0;
+  // Perceptual: DifferenceHash() and PerceptualHash() of the image shrunk
+  // to luma. Near-identical images differ in few bits; compare them with
+  // HammingDistance().
+  uint64_t dhash = 0;
+  uint64_t phash = 0;
+};
+
+// Sides of the luma images the perceptual hashes are computed from.
+constexpr int kDHashWidth = 9;
+constexpr int kDHashHeight = 8;
+constexpr int kPHashSize = 32;
+
+// XxHash3 of |image|'s pixels row by row, without row padding and with
+// alpha read as 0xFF: the XxHash3 of a raw_bgra (or raw_rgba) capture of
+// them, whatever the view's stride. 0 for an invalid image.
+uint64_t PixelHash(const ImageView& image);
+
+// dHash of a kDHashWidth x kDHashHeight luma image, rows packed: bit
+// 63 - (8 * y + x) is set when pixel (x, y) is darker than (x + 1, y).
+uint64_t DifferenceHash(const float* luma);
+
+// pHash of a kPHashSize x kPHashSize luma image, rows packed: the 8 x 8
+// lowest frequencies of its 2-D DCT-II, bit 63 - (8 * v + u) set when
+// frequency (u, v) is above their median.
+uint64_t PerceptualHash(const float* luma);
+
+// Bits that differ between two hashes.
+int HammingDistance(uint64_t a, uint64_t b);
+
+// Fingerprints captured frames without encoding them.
+//
+// The exact hash streams the pixels through XxHash3 once, masking alpha as
+// it reads instead of copying. The perceptual hashes shrink the image to
+// kPHashSize square with ImageResizer's box filter (its SIMD kernels,
+// banded over threads), convert that to luma, and take dHash from a
+// further shrink and pHash from a separable DCT of which only the 8 x 8
+// low frequencies are computed. Scratch buffers are kept, so repeated calls
+// do not allocate. Not thread-safe.
+class ImageHasher {
+ public:
+  ImageHasher();
+
+  ImageHasher(const ImageHasher&) = delete;
+  ImageHasher& operator=(const ImageHasher&) = delete;
+
+  // Computes the hashes |options| asks for. Returns false, leaving
+  // |hashes| zero, if |image| is invalid.
+  bool Hash(const ImageView& image, const ImageHashOptions& options,
+            ImageHashes* hashes);
+
+ private:
+  // Writes the luma of |image|, which has |count| packed pixels, to |luma|.
+  static void ToLuma(const ImageView& image, size_t count, float* luma);
+
+  ImageResizer resizer_;
+  ImageResizer dhash_resizer_;
+  float phash_luma_[kPHashSize * kPHashSize];
+  float dhash_luma_[kDHashWidth * kDHashHeight];
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_IMAGE_HASH_H_
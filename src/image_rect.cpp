@@ -0,0 +1,42 @@
+#include "image_rect.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace screenshot {
+
+PixelRect RectFromCorners(int x0, int y0, int x1, int y1) {
+  PixelRect rect;
+  rect.x = std::min(x0, x1);
+  rect.y = std::min(y0, y1);
+  rect.width = std::max(x0, x1) - rect.x;
+  rect.height = std::max(y0, y1) - rect.y;
+  return rect;
+}
+
+PixelRect IntersectRects(const PixelRect& a, const PixelRect& b) {
+  const int left = std::max(a.x, b.x);
+  const int top = std::max(a.y, b.y);
+  const int right = std::min(a.right(), b.right());
+  const int bottom = std::min(a.bottom(), b.bottom());
+  if (a.IsEmpty() || b.IsEmpty() || right <= left || bottom <= top) {
+    return PixelRect();
+  }
+  return PixelRect{left, top, right - left, bottom - top};
+}
+
+bool CropImage(const ImageView& image, const PixelRect& rect, ImageView* out) {
+  if (!image.IsValid()) return false;
+  const PixelRect clipped =
+      IntersectRects(rect, PixelRect{0, 0, image.width, image.height});
+  if (clipped.IsEmpty()) return false;
+  out->data = image.Row(clipped.y) +
+              static_cast<size_t>(clipped.x) * kBytesPerPixel;
+  out->width = clipped.width;
+  out->height = clipped.height;
+  out->stride = image.stride;
+  out->format = image.format;
+  return true;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,44 @@
+#ifndef SCREENSHOT_CORE_IMAGE_RECT_H_
+#define SCREENSHOT_CORE_IMAGE_RECT_H_
+
+#include "image.h"
+
+namespace screenshot {
+
+// A rectangle of pixels. x and y may be negative (screen coordinates left
+// of or above the primary display); an empty rectangle has no pixels.
+struct PixelRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+
+  int right() const { return x + width; }
+  int bottom() const { return y + height; }
+  bool IsEmpty() const { return width <= 0 || height <= 0; }
+
+  bool operator==(const PixelRect& other) const {
+    return x == other.x && y == other.y && width == other.width &&
+           height == other.height;
+  }
+  bool operator!=(const PixelRect& other) const { return !(*this == other); }
+};
+
+// The rectangle between two corners given in either order, such as where a
+// drag was pressed and released. The far corner itself is outside it, so
+// equal corners give an empty rectangle.
+PixelRect RectFromCorners(int x0, int y0, int x1, int y1);
+
+// The part of |a| inside |b|; empty (and at the origin) if they do not
+// overlap.
+PixelRect IntersectRects(const PixelRect& a, const PixelRect& b);
+
+// Points |out| at the part of |image| under |rect| (in the image's pixel
+// coordinates) without copying: the rows stay where they are, with the
+// image's stride. |rect| is clipped to the image. Returns false, leaving
+// |out| alone, if |image| is invalid or nothing of |rect| is on it.
+bool CropImage(const ImageView& image, const PixelRect& rect, ImageView* out);
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_IMAGE_RECT_H_
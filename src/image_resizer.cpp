@@ -0,0 +1,785 @@
+#include "image_resizer.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "cpu_features.h"
+#include "trace.h"
+
+#if SCREENSHOT_ARCH_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+// Filter weights are Q14 fixed point, so a weight fits an int16 and a
+// weighted pair of bytes is one _mm_madd_epi16 lane.
+constexpr int kWeightBits = 14;
+constexpr int kWeightOne = 1 << kWeightBits;
+constexpr int kWeightRound = 1 << (kWeightBits - 1);
+
+// The box fast path sums columns of source bytes in uint16 (at most 257
+// rows of 255) and divides each block sum with a 32-bit reciprocal, which
+// rounds exactly for blocks of fewer than 4096 pixels.
+constexpr int kMaxBoxRows = 257;
+constexpr int kMaxBoxArea = 4096;
+
+constexpr double kPi = 3.14159265358979323846;
+
+double Sinc(double x) {
+  if (x == 0.0) return 1.0;
+  x *= kPi;
+  return std::sin(x) / x;
+}
+
+double FilterSupport(ResizeFilter filter) {
+  switch (filter) {
+    case ResizeFilter::kBox:
+      return 0.5;
+    case ResizeFilter::kBilinear:
+      return 1.0;
+    case ResizeFilter::kAuto:
+    case ResizeFilter::kLanczos3:
+      break;
+  }
+  return 3.0;
+}
+
+double FilterWeight(ResizeFilter filter, double x) {
+  switch (filter) {
+    case ResizeFilter::kBox:
+      return x >= -0.5 && x < 0.5 ? 1.0 : 0.0;
+    case ResizeFilter::kBilinear:
+      x = std::fabs(x);
+      return x < 1.0 ? 1.0 - x : 0.0;
+    case ResizeFilter::kAuto:
+    case ResizeFilter::kLanczos3:
+      break;
+  }
+  return x > -3.0 && x < 3.0 ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+}
+
+uint8_t Clamp255(int value) {
+  return static_cast<uint8_t>(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+// Filter taps along one axis as the kernels read them: destination pixel i
+// takes count[i] source pixels from first[i], weighted by
+// weights[i * stride ...]. |stride| is even and unused weights are zero, so
+// weights can always be read in pairs.
+struct TapTable {
+  const int* first;
+  const int* count;
+  const int16_t* weights;
+  size_t stride;
+};
+
+// Weights |w[0]| and |w[1]| as the int16 pair _mm_madd_epi16 multiplies a
+// byte pair with.
+int32_t LoadPair(const int16_t* w) {
+  int32_t pair;
+  std::memcpy(&pair, w, sizeof(pair));
+  return pair;
+}
+
+// Kernels. Horizontal ones write |width| destination pixels of a row;
+// vertical ones combine |count| rows |stride| bytes apart into |bytes|
+// bytes and return how many they covered (the scalar loop does the rest).
+
+void HorizontalScalar(const uint8_t* src, const TapTable& taps, int width,
+                      uint8_t* dst) {
+  for (int x = 0; x < width; ++x) {
+    const size_t index = static_cast<size_t>(x);
+    const uint8_t* p =
+        src + static_cast<size_t>(taps.first[index]) * kBytesPerPixel;
+    const int16_t* w = taps.weights + index * taps.stride;
+    int sum[4] = {kWeightRound, kWeightRound, kWeightRound, kWeightRound};
+    for (int k = 0; k < taps.count[index]; ++k) {
+      for (int c = 0; c < 4; ++c) sum[c] += p[k * 4 + c] * w[k];
+    }
+    for (int c = 0; c < 4; ++c) dst[x * 4 + c] = Clamp255(sum[c] >> kWeightBits);
+  }
+}
+
+void VerticalScalar(const uint8_t* rows, size_t stride, int count,
+                    const int16_t* weights, size_t begin, size_t bytes,
+                    uint8_t* dst) {
+  for (size_t i = begin; i < bytes; ++i) {
+    int sum = kWeightRound;
+    for (int k = 0; k < count; ++k) {
+      sum += rows[static_cast<size_t>(k) * stride + i] * weights[k];
+    }
+    dst[i] = Clamp255(sum >> kWeightBits);
+  }
+}
+
+void AddRowScalar(const uint8_t* src, uint16_t* sums, size_t begin,
+                  size_t bytes) {
+  for (size_t i = begin; i < bytes; ++i) {
+    sums[i] = static_cast<uint16_t>(sums[i] + src[i]);
+  }
+}
+
+// Averages blocks of |factor| summed pixels, from pixel |begin| on:
+// (sum + area / 2) / area via the reciprocal |inverse| = ceil(2^32 / area).
+void AverageScalar(const uint16_t* sums, int factor, int begin, int width,
+                   uint32_t area, uint32_t inverse, uint8_t* dst) {
+  const uint32_t half = area / 2;
+  for (int x = begin; x < width; ++x) {
+    const uint16_t* p = sums + static_cast<size_t>(x) *
+                                   static_cast<size_t>(factor) * 4;
+    for (int c = 0; c < 4; ++c) {
+      uint32_t sum = half;
+      for (int k = 0; k < factor; ++k) sum += p[k * 4 + c];
+      dst[x * 4 + c] = static_cast<uint8_t>(
+          (static_cast<uint64_t>(sum) * inverse) >> 32);
+    }
+  }
+}
+
+#if SCREENSHOT_ARCH_X86
+// Interleaves the two pixels in the low 8 bytes of |v| per channel
+// (b0 b1 g0 g1 r0 r1 a0 a1, widened to int16) for _mm_madd_epi16.
+inline __m128i PairPixelsSse2(__m128i v, __m128i zero) {
+  const __m128i wide = _mm_unpacklo_epi8(v, zero);
+  return _mm_unpacklo_epi16(wide, _mm_srli_si128(wide, 8));
+}
+
+void HorizontalSse2(const uint8_t* src, const TapTable& taps, int width,
+                    uint8_t* dst) {
+  const __m128i zero = _mm_setzero_si128();
+  for (int x = 0; x < width; ++x) {
+    const size_t index = static_cast<size_t>(x);
+    const uint8_t* p =
+        src + static_cast<size_t>(taps.first[index]) * kBytesPerPixel;
+    const int16_t* w = taps.weights + index * taps.stride;
+    const int n = taps.count[index];
+    __m128i sum = _mm_set1_epi32(kWeightRound);
+    int k = 0;
+    for (; k + 2 <= n; k += 2) {
+      const __m128i v =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + k * 4));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(PairPixelsSse2(v, zero),
+                                              _mm_set1_epi32(LoadPair(w + k))));
+    }
+    if (k < n) {
+      int32_t pixel;
+      std::memcpy(&pixel, p + k * 4, sizeof(pixel));
+      sum = _mm_add_epi32(
+          sum, _mm_madd_epi16(PairPixelsSse2(_mm_cvtsi32_si128(pixel), zero),
+                              _mm_set1_epi32(LoadPair(w + k))));
+    }
+    sum = _mm_srai_epi32(sum, kWeightBits);
+    sum = _mm_packs_epi32(sum, sum);
+    const int32_t out = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+    std::memcpy(dst + x * 4, &out, sizeof(out));
+  }
+}
+
+// pshufb masks pairing pixels 0/1 and 2/3 of 16 bytes per channel,
+// widened to int16.
+#define SCREENSHOT_PAIR_MASK(p)                                              \
+  (p) * 4, -1, (p) * 4 + 4, -1, (p) * 4 + 1, -1, (p) * 4 + 5, -1,            \
+      (p) * 4 + 2, -1, (p) * 4 + 6, -1, (p) * 4 + 3, -1, (p) * 4 + 7, -1
+
+SCREENSHOT_TARGET_SSSE3
+void HorizontalSsse3(const uint8_t* src, const TapTable& taps, int width,
+                     uint8_t* dst) {
+  const __m128i pair01 = _mm_setr_epi8(SCREENSHOT_PAIR_MASK(0));
+  const __m128i pair23 = _mm_setr_epi8(SCREENSHOT_PAIR_MASK(2));
+  for (int x = 0; x < width; ++x) {
+    const size_t index = static_cast<size_t>(x);
+    const uint8_t* p =
+        src + static_cast<size_t>(taps.first[index]) * kBytesPerPixel;
+    const int16_t* w = taps.weights + index * taps.stride;
+    const int n = taps.count[index];
+    __m128i sum = _mm_set1_epi32(kWeightRound);
+    int k = 0;
+    for (; k + 4 <= n; k += 4) {
+      const __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k * 4));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_shuffle_epi8(v, pair01),
+                                              _mm_set1_epi32(LoadPair(w + k))));
+      sum = _mm_add_epi32(
+          sum, _mm_madd_epi16(_mm_shuffle_epi8(v, pair23),
+                              _mm_set1_epi32(LoadPair(w + k + 2))));
+    }
+    if (k + 2 <= n) {
+      const __m128i v =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + k * 4));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_shuffle_epi8(v, pair01),
+                                              _mm_set1_epi32(LoadPair(w + k))));
+      k += 2;
+    }
+    if (k < n) {
+      int32_t pixel;
+      std::memcpy(&pixel, p + k * 4, sizeof(pixel));
+      sum = _mm_add_epi32(
+          sum, _mm_madd_epi16(_mm_shuffle_epi8(_mm_cvtsi32_si128(pixel), pair01),
+                              _mm_set1_epi32(LoadPair(w + k))));
+    }
+    sum = _mm_srai_epi32(sum, kWeightBits);
+    sum = _mm_packs_epi32(sum, sum);
+    const int32_t out = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+    std::memcpy(dst + x * 4, &out, sizeof(out));
+  }
+}
+
+// Two rows at once, one per 128-bit lane, sharing the weights.
+SCREENSHOT_TARGET_AVX2
+void HorizontalAvx2(const uint8_t* src0, const uint8_t* src1,
+                    const TapTable& taps, int width, uint8_t* dst0,
+                    uint8_t* dst1) {
+  const __m256i pair01 = _mm256_setr_epi8(SCREENSHOT_PAIR_MASK(0),
+                                          SCREENSHOT_PAIR_MASK(0));
+  const __m256i pair23 = _mm256_setr_epi8(SCREENSHOT_PAIR_MASK(2),
+                                          SCREENSHOT_PAIR_MASK(2));
+  for (int x = 0; x < width; ++x) {
+    const size_t index = static_cast<size_t>(x);
+    const size_t offset =
+        static_cast<size_t>(taps.first[index]) * kBytesPerPixel;
+    const uint8_t* p0 = src0 + offset;
+    const uint8_t* p1 = src1 + offset;
+    const int16_t* w = taps.weights + index * taps.stride;
+    const int n = taps.count[index];
+    __m256i sum = _mm256_set1_epi32(kWeightRound);
+    int k = 0;
+    for (; k + 4 <= n; k += 4) {
+      const __m256i v = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + k * 4))),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + k * 4)), 1);
+      sum = _mm256_add_epi32(
+          sum, _mm256_madd_epi16(_mm256_shuffle_epi8(v, pair01),
+                                 _mm256_set1_epi32(LoadPair(w + k))));
+      sum = _mm256_add_epi32(
+          sum, _mm256_madd_epi16(_mm256_shuffle_epi8(v, pair23),
+                                 _mm256_set1_epi32(LoadPair(w + k + 2))));
+    }
+    for (; k < n; k += 2) {
+      // One or two pixels; a lone last pixel is paired with zeros.
+      int64_t pixels0 = 0;
+      int64_t pixels1 = 0;
+      const size_t size = k + 1 < n ? 8 : 4;
+      std::memcpy(&pixels0, p0 + k * 4, size);
+      std::memcpy(&pixels1, p1 + k * 4, size);
+      const __m256i v = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(
+              _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pixels0))),
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pixels1)), 1);
+      sum = _mm256_add_epi32(
+          sum, _mm256_madd_epi16(_mm256_shuffle_epi8(v, pair01),
+                                 _mm256_set1_epi32(LoadPair(w + k))));
+    }
+    sum = _mm256_srai_epi32(sum, kWeightBits);
+    sum = _mm256_packs_epi32(sum, sum);
+    sum = _mm256_packus_epi16(sum, sum);
+    const int32_t out0 = _mm_cvtsi128_si32(_mm256_castsi256_si128(sum));
+    const int32_t out1 = _mm_cvtsi128_si32(_mm256_extracti128_si256(sum, 1));
+    std::memcpy(dst0 + x * 4, &out0, sizeof(out0));
+    std::memcpy(dst1 + x * 4, &out1, sizeof(out1));
+  }
+}
+
+#undef SCREENSHOT_PAIR_MASK
+
+size_t VerticalSse2(const uint8_t* rows, size_t stride, int count,
+                    const int16_t* weights, size_t bytes, uint8_t* dst) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= bytes; i += 16) {
+    __m128i sum0 = _mm_set1_epi32(kWeightRound);
+    __m128i sum1 = sum0;
+    __m128i sum2 = sum0;
+    __m128i sum3 = sum0;
+    for (int k = 0; k < count; k += 2) {
+      const uint8_t* row = rows + static_cast<size_t>(k) * stride + i;
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+      // An odd last row is paired with zeros.
+      const __m128i b =
+          k + 1 < count
+              ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + stride))
+              : zero;
+      const __m128i w = _mm_set1_epi32(LoadPair(weights + k));
+      const __m128i lo = _mm_unpacklo_epi8(a, b);
+      const __m128i hi = _mm_unpackhi_epi8(a, b);
+      sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+      sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+      sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+      sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+    }
+    const __m128i lo = _mm_packs_epi32(_mm_srai_epi32(sum0, kWeightBits),
+                                       _mm_srai_epi32(sum1, kWeightBits));
+    const __m128i hi = _mm_packs_epi32(_mm_srai_epi32(sum2, kWeightBits),
+                                       _mm_srai_epi32(sum3, kWeightBits));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(lo, hi));
+  }
+  return i;
+}
+
+// The AVX2 unpacks and packs both work within 128-bit lanes, so the bytes
+// come back out in their original order.
+SCREENSHOT_TARGET_AVX2
+size_t VerticalAvx2(const uint8_t* rows, size_t stride, int count,
+                    const int16_t* weights, size_t bytes, uint8_t* dst) {
+  const __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= bytes; i += 32) {
+    __m256i sum0 = _mm256_set1_epi32(kWeightRound);
+    __m256i sum1 = sum0;
+    __m256i sum2 = sum0;
+    __m256i sum3 = sum0;
+    for (int k = 0; k < count; k += 2) {
+      const uint8_t* row = rows + static_cast<size_t>(k) * stride + i;
+      const __m256i a =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+      const __m256i b =
+          k + 1 < count ? _mm256_loadu_si256(
+                              reinterpret_cast<const __m256i*>(row + stride))
+                        : zero;
+      const __m256i w = _mm256_set1_epi32(LoadPair(weights + k));
+      const __m256i lo = _mm256_unpacklo_epi8(a, b);
+      const __m256i hi = _mm256_unpackhi_epi8(a, b);
+      sum0 = _mm256_add_epi32(
+          sum0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), w));
+      sum1 = _mm256_add_epi32(
+          sum1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), w));
+      sum2 = _mm256_add_epi32(
+          sum2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), w));
+      sum3 = _mm256_add_epi32(
+          sum3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), w));
+    }
+    const __m256i lo = _mm256_packs_epi32(_mm256_srai_epi32(sum0, kWeightBits),
+                                          _mm256_srai_epi32(sum1, kWeightBits));
+    const __m256i hi = _mm256_packs_epi32(_mm256_srai_epi32(sum2, kWeightBits),
+                                          _mm256_srai_epi32(sum3, kWeightBits));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_packus_epi16(lo, hi));
+  }
+  return i;
+}
+
+size_t AddRowSse2(const uint8_t* src, uint16_t* sums, size_t bytes) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= bytes; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i* s = reinterpret_cast<__m128i*>(sums + i);
+    _mm_storeu_si128(s, _mm_add_epi16(_mm_loadu_si128(s),
+                                      _mm_unpacklo_epi8(v, zero)));
+    _mm_storeu_si128(s + 1, _mm_add_epi16(_mm_loadu_si128(s + 1),
+                                          _mm_unpackhi_epi8(v, zero)));
+  }
+  return i;
+}
+
+SCREENSHOT_TARGET_AVX2
+size_t AddRowAvx2(const uint8_t* src, uint16_t* sums, size_t bytes) {
+  size_t i = 0;
+  for (; i + 32 <= bytes; i += 32) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m256i* s = reinterpret_cast<__m256i*>(sums + i);
+    _mm256_storeu_si256(
+        s, _mm256_add_epi16(_mm256_loadu_si256(s),
+                            _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v))));
+    _mm256_storeu_si256(
+        s + 1,
+        _mm256_add_epi16(_mm256_loadu_si256(s + 1),
+                         _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1))));
+  }
+  return i;
+}
+
+// Small blocks (up to about 4x4) sum to at most 16 bits, and a 16-bit
+// reciprocal still rounds them exactly; two destination pixels then share
+// one vector. Larger blocks take one pixel per iteration with a 32x32->64
+// multiply for lanes 0/2 and 1/3. Returns the pixels covered.
+int AverageSse2(const uint16_t* sums, int factor, int width, uint32_t area,
+                uint32_t inverse, uint8_t* dst) {
+  const __m128i zero = _mm_setzero_si128();
+  const uint32_t inverse16 = ((1u << 16) + area - 1) / area;
+  const uint32_t excess = inverse16 * area - (1u << 16);
+  const uint32_t largest = 255 * area + area / 2;
+  if (largest <= 0xFFFF && static_cast<uint64_t>(largest) * excess < 0x10000) {
+    const __m128i half = _mm_set1_epi16(static_cast<int16_t>(area / 2));
+    const __m128i scale = _mm_set1_epi16(static_cast<int16_t>(inverse16));
+    const size_t step = static_cast<size_t>(factor) * 4;
+    int x = 0;
+    for (; x + 2 <= width; x += 2) {
+      const uint16_t* p0 = sums + static_cast<size_t>(x) * step;
+      const uint16_t* p1 = p0 + step;
+      __m128i sum = half;
+      for (int k = 0; k < factor; ++k) {
+        sum = _mm_add_epi16(
+            sum, _mm_unpacklo_epi64(
+                     _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p0 + k * 4)),
+                     _mm_loadl_epi64(
+                         reinterpret_cast<const __m128i*>(p1 + k * 4))));
+      }
+      const __m128i out = _mm_mulhi_epu16(sum, scale);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4),
+                       _mm_packus_epi16(out, out));
+    }
+    return x;
+  }
+
+  const __m128i half = _mm_set1_epi32(static_cast<int>(area / 2));
+  const __m128i scale = _mm_set1_epi32(static_cast<int>(inverse));
+  const __m128i high = _mm_set_epi32(-1, 0, -1, 0);
+  for (int x = 0; x < width; ++x) {
+    const uint16_t* p = sums + static_cast<size_t>(x) *
+                                   static_cast<size_t>(factor) * 4;
+    __m128i sum = half;
+    int k = 0;
+    for (; k + 2 <= factor; k += 2) {
+      const __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k * 4));
+      sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(v, zero));
+      sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(v, zero));
+    }
+    if (k < factor) {
+      const __m128i v =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + k * 4));
+      sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(v, zero));
+    }
+    const __m128i even = _mm_srli_epi64(_mm_mul_epu32(sum, scale), 32);
+    const __m128i odd =
+        _mm_and_si128(_mm_mul_epu32(_mm_srli_epi64(sum, 32), scale), high);
+    __m128i out = _mm_or_si128(even, odd);
+    out = _mm_packs_epi32(out, out);
+    const int32_t pixel = _mm_cvtsi128_si32(_mm_packus_epi16(out, out));
+    std::memcpy(dst + x * 4, &pixel, sizeof(pixel));
+  }
+  return width;
+}
+#endif  // SCREENSHOT_ARCH_X86
+
+// Filters |src0| into |dst0| and, if given, |src1| into |dst1|.
+void Horizontal(const uint8_t* src0, const uint8_t* src1,
+                const TapTable& taps, int width, uint8_t* dst0,
+                uint8_t* dst1) {
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& cpu = GetCpuFeatures();
+  if (cpu.avx2 && src1 != nullptr) {
+    HorizontalAvx2(src0, src1, taps, width, dst0, dst1);
+    return;
+  }
+  if (cpu.ssse3) {
+    HorizontalSsse3(src0, taps, width, dst0);
+    if (src1 != nullptr) HorizontalSsse3(src1, taps, width, dst1);
+    return;
+  }
+  if (cpu.sse2) {
+    HorizontalSse2(src0, taps, width, dst0);
+    if (src1 != nullptr) HorizontalSse2(src1, taps, width, dst1);
+    return;
+  }
+#endif
+  HorizontalScalar(src0, taps, width, dst0);
+  if (src1 != nullptr) HorizontalScalar(src1, taps, width, dst1);
+}
+
+void Vertical(const uint8_t* rows, size_t stride, int count,
+              const int16_t* weights, size_t bytes, uint8_t* dst) {
+  size_t done = 0;
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& cpu = GetCpuFeatures();
+  if (cpu.avx2) {
+    done = VerticalAvx2(rows, stride, count, weights, bytes, dst);
+  } else if (cpu.sse2) {
+    done = VerticalSse2(rows, stride, count, weights, bytes, dst);
+  }
+#endif
+  VerticalScalar(rows, stride, count, weights, done, bytes, dst);
+}
+
+void AddRow(const uint8_t* src, uint16_t* sums, size_t bytes) {
+  size_t done = 0;
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& cpu = GetCpuFeatures();
+  if (cpu.avx2) {
+    done = AddRowAvx2(src, sums, bytes);
+  } else if (cpu.sse2) {
+    done = AddRowSse2(src, sums, bytes);
+  }
+#endif
+  AddRowScalar(src, sums, done, bytes);
+}
+
+void Average(const uint16_t* sums, int factor, int width, uint32_t area,
+             uint32_t inverse, uint8_t* dst) {
+  int done = 0;
+#if SCREENSHOT_ARCH_X86
+  if (GetCpuFeatures().sse2) {
+    done = AverageSse2(sums, factor, width, area, inverse, dst);
+  }
+#endif
+  AverageScalar(sums, factor, done, width, area, inverse, dst);
+}
+
+int ClampSize(long value, int limit) {
+  if (value < 1) return 1;
+  return value > limit ? limit : static_cast<int>(value);
+}
+
+}  // namespace
+
+void FitSize(int width, int height, const ResizeLimits& limits,
+             int* out_width, int* out_height) {
+  double factor = limits.scale > 0.0 && limits.scale < 1.0 ? limits.scale : 1.0;
+  if (limits.max_width > 0 && width * factor > limits.max_width) {
+    factor = static_cast<double>(limits.max_width) / width;
+  }
+  if (limits.max_height > 0 && height * factor > limits.max_height) {
+    factor = static_cast<double>(limits.max_height) / height;
+  }
+  int max_width = width;
+  int max_height = height;
+  if (limits.max_width > 0 && limits.max_width < max_width) {
+    max_width = limits.max_width;
+  }
+  if (limits.max_height > 0 && limits.max_height < max_height) {
+    max_height = limits.max_height;
+  }
+  *out_width = ClampSize(std::lround(width * factor), max_width);
+  *out_height = ClampSize(std::lround(height * factor), max_height);
+}
+
+ImageResizer::ImageResizer(const ResizeOptions& options) : options_(options) {}
+
+ImageView ImageResizer::output() const {
+  return ImageView{output_.data(), width_, height_,
+                   static_cast<size_t>(width_) * kBytesPerPixel, format_};
+}
+
+int ImageResizer::ThreadCount() const {
+  return ThreadPool::ResolveThreadCount(options_.threads);
+}
+
+void ImageResizer::BuildTaps(int src_size, int dst_size, ResizeFilter filter,
+                             Taps* taps) {
+  if (taps->src_size == src_size && taps->dst_size == dst_size &&
+      taps->filter == filter) {
+    return;
+  }
+  // Shrinking widens the filter by the scale factor so every source pixel
+  // contributes; enlarging samples it at its natural width.
+  const double scale = static_cast<double>(src_size) / dst_size;
+  const double filter_scale = scale > 1.0 ? scale : 1.0;
+  const double support = FilterSupport(filter) * filter_scale;
+  // Room for every tap, rounded up to an even count for the paired reads.
+  const int stride = static_cast<int>(std::ceil(support)) * 2 + 2;
+  const size_t dst = static_cast<size_t>(dst_size);
+  taps->src_size = src_size;
+  taps->dst_size = dst_size;
+  taps->filter = filter;
+  taps->stride = stride;
+  taps->first.resize(dst);
+  taps->count.resize(dst);
+  taps->weights.assign(dst * static_cast<size_t>(stride), 0);
+  std::vector<double> exact(static_cast<size_t>(stride));
+
+  for (size_t i = 0; i < dst; ++i) {
+    const double center = (static_cast<double>(i) + 0.5) * scale;
+    int begin = static_cast<int>(center - support + 0.5);
+    int end = static_cast<int>(center + support + 0.5);
+    if (begin < 0) begin = 0;
+    if (end > src_size) end = src_size;
+    if (end - begin > stride) end = begin + stride;
+    double total = 0.0;
+    for (int x = begin; x < end; ++x) {
+      const double w =
+          FilterWeight(filter, (x - center + 0.5) / filter_scale);
+      exact[static_cast<size_t>(x - begin)] = w;
+      total += w;
+    }
+    if (total == 0.0) total = 1.0;
+
+    int16_t* weights = taps->weights.data() + i * static_cast<size_t>(stride);
+    const int n = end - begin;
+    for (int k = 0; k < n; ++k) {
+      weights[k] = static_cast<int16_t>(
+          std::lround(exact[static_cast<size_t>(k)] / total * kWeightOne));
+    }
+    // Drop zero weights at either end, then make the rest sum to exactly
+    // one so flat areas stay flat.
+    int lead = 0;
+    while (lead < n - 1 && weights[lead] == 0) ++lead;
+    int taps_used = n - lead;
+    while (taps_used > 1 && weights[lead + taps_used - 1] == 0) --taps_used;
+    if (lead != 0) {
+      std::memmove(weights, weights + lead,
+                   static_cast<size_t>(taps_used) * sizeof(int16_t));
+    }
+    for (int k = taps_used; k < n; ++k) weights[k] = 0;
+    int sum = 0;
+    int largest = 0;
+    for (int k = 0; k < taps_used; ++k) {
+      sum += weights[k];
+      if (weights[k] > weights[largest]) largest = k;
+    }
+    weights[largest] = static_cast<int16_t>(weights[largest] + kWeightOne - sum);
+    taps->first[i] = begin + lead;
+    taps->count[i] = taps_used;
+  }
+}
+
+bool ImageResizer::Resize(const ImageView& src, int width, int height) {
+  if (!src.IsValid() || width <= 0 || height <= 0) return false;
+  TraceSpan span("scale");
+  width_ = width;
+  height_ = height;
+  format_ = src.format;
+  const size_t out_stride = static_cast<size_t>(width) * kBytesPerPixel;
+  output_.resize(out_stride * static_cast<size_t>(height));
+
+  if (width == src.width && height == src.height) {
+    for (int y = 0; y < height; ++y) {
+      std::memcpy(output_.data() + static_cast<size_t>(y) * out_stride,
+                  src.Row(y), out_stride);
+    }
+    return true;
+  }
+
+  ResizeFilter filter = options_.filter;
+  const bool whole = src.width % width == 0 && src.height % height == 0;
+  const int factor_x = src.width / width;
+  const int factor_y = src.height / height;
+  const bool box = whole &&
+                   (filter == ResizeFilter::kAuto ||
+                    filter == ResizeFilter::kBox) &&
+                   factor_y <= kMaxBoxRows && factor_x < kMaxBoxArea &&
+                   factor_x * factor_y < kMaxBoxArea;
+  if (!box) {
+    // Whole factors too large for the fast path still get an area average.
+    if (filter == ResizeFilter::kAuto) {
+      filter = whole ? ResizeFilter::kBox : ResizeFilter::kLanczos3;
+    }
+    BuildTaps(src.width, width, filter, &horizontal_);
+    BuildTaps(src.height, height, filter, &vertical_);
+  }
+
+  int bands = ThreadCount();
+  if (bands > height) bands = height;
+  if (bands_.size() < static_cast<size_t>(bands)) {
+    bands_.resize(static_cast<size_t>(bands));
+  }
+  auto run = [&](size_t band) {
+    const int y0 = static_cast<int>(static_cast<int64_t>(height) *
+                                    static_cast<int64_t>(band) / bands);
+    const int y1 = static_cast<int>(static_cast<int64_t>(height) *
+                                    static_cast<int64_t>(band + 1) / bands);
+    if (box) {
+      BoxBand(src, y0, y1, &bands_[band]);
+    } else {
+      FilterBand(src, y0, y1, &bands_[band]);
+    }
+  };
+  if (bands > 1) {
+    const int workers = bands - 1;
+    if (!pool_ || pool_->size() != workers) {
+      pool_ = std::make_unique<ThreadPool>(workers);
+    }
+    pool_->ParallelFor(static_cast<size_t>(bands), run);
+  } else {
+    run(0);
+  }
+  return true;
+}
+
+bool ImageResizer::Fit(const ImageView& src, const ResizeLimits& limits,
+                       ImageView* out) {
+  if (!src.IsValid()) return false;
+  int width = 0;
+  int height = 0;
+  FitSize(src.width, src.height, limits, &width, &height);
+  if (width == src.width && height == src.height) {
+    *out = src;
+    return true;
+  }
+  if (!Resize(src, width, height)) return false;
+  *out = output();
+  return true;
+}
+
+void ImageResizer::BoxBand(const ImageView& src, int y0, int y1, Band* band) {
+  const int factor_x = src.width / width_;
+  const int factor_y = src.height / height_;
+  const uint32_t area = static_cast<uint32_t>(factor_x * factor_y);
+  const uint32_t inverse =
+      static_cast<uint32_t>(((uint64_t{1} << 32) + area - 1) / area);
+  // Only the columns that make up whole blocks are summed.
+  const size_t bytes = static_cast<size_t>(width_) *
+                       static_cast<size_t>(factor_x) * kBytesPerPixel;
+  const size_t out_stride = static_cast<size_t>(width_) * kBytesPerPixel;
+  band->sums.resize(bytes);
+  for (int y = y0; y < y1; ++y) {
+    std::memset(band->sums.data(), 0, bytes * sizeof(uint16_t));
+    for (int r = 0; r < factor_y; ++r) {
+      AddRow(src.Row(y * factor_y + r), band->sums.data(), bytes);
+    }
+    Average(band->sums.data(), factor_x, width_, area, inverse,
+            output_.data() + static_cast<size_t>(y) * out_stride);
+  }
+}
+
+void ImageResizer::FilterBand(const ImageView& src, int y0, int y1,
+                              Band* band) {
+  const TapTable h{horizontal_.first.data(), horizontal_.count.data(),
+                   horizontal_.weights.data(),
+                   static_cast<size_t>(horizontal_.stride)};
+  const Taps& v = vertical_;
+  const size_t out_stride = static_cast<size_t>(width_) * kBytesPerPixel;
+  uint8_t* out = output_.data();
+  if (src.height == height_) {
+    for (int y = y0; y < y1; y += 2) {
+      const bool two = y + 1 < y1;
+      Horizontal(src.Row(y), two ? src.Row(y + 1) : nullptr, h, width_,
+                 out + static_cast<size_t>(y) * out_stride,
+                 out + static_cast<size_t>(y + 1) * out_stride);
+    }
+    return;
+  }
+
+  // Source rows the band's taps reach, scaled horizontally unless the width
+  // is unchanged. Trimming zero weights can leave |first| out of order.
+  int begin = v.first[static_cast<size_t>(y0)];
+  int end = begin;
+  for (int y = y0; y < y1; ++y) {
+    const int first = v.first[static_cast<size_t>(y)];
+    const int last = first + v.count[static_cast<size_t>(y)];
+    if (first < begin) begin = first;
+    if (last > end) end = last;
+  }
+  const uint8_t* rows;
+  size_t rows_stride;
+  if (src.width == width_) {
+    rows = src.Row(begin);
+    rows_stride = src.stride;
+  } else {
+    rows_stride = out_stride;
+    band->rows.resize(rows_stride * static_cast<size_t>(end - begin));
+    uint8_t* scaled = band->rows.data();
+    for (int r = begin; r < end; r += 2) {
+      const bool two = r + 1 < end;
+      const size_t row = static_cast<size_t>(r - begin);
+      Horizontal(src.Row(r), two ? src.Row(r + 1) : nullptr, h, width_,
+                 scaled + row * rows_stride, scaled + (row + 1) * rows_stride);
+    }
+    rows = scaled;
+  }
+  for (int y = y0; y < y1; ++y) {
+    const size_t index = static_cast<size_t>(y);
+    Vertical(rows + static_cast<size_t>(v.first[index] - begin) * rows_stride,
+             rows_stride, v.count[index],
+             v.weights.data() + index * static_cast<size_t>(v.stride),
+             out_stride, out + index * out_stride);
+  }
+}
+
+}  // namespace screenshot
@@ -0,0 +1,123 @@
+#ifndef SCREENSHOT_CORE_IMAGE_RESIZER_H_
+#define SCREENSHOT_CORE_IMAGE_RESIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "image.h"
+#include "thread_pool.h"
+
+namespace screenshot {
+
+// Resampling kernels.
+enum class ResizeFilter {
+  kAuto,      // kBox when both axes shrink by a whole factor, else kLanczos3
+  kBox,       // area average
+  kBilinear,  // triangle filter, widened to the scale factor when shrinking
+  kLanczos3,  // three-lobed Lanczos; sharpest, and the slowest
+};
+
+struct ResizeOptions {
+  ResizeFilter filter = ResizeFilter::kAuto;
+  // Threads resampling bands of output rows; 0 uses every core.
+  int threads = 0;
+};
+
+// How far a capture may be scaled down. The defaults leave it alone.
+struct ResizeLimits {
+  // Largest width and height of the result; 0 means no limit.
+  int max_width = 0;
+  int max_height = 0;
+  // Factor applied to both dimensions first, in (0, 1].
+  double scale = 1.0;
+};
+
+// Size a |width| x |height| image is reduced to by |limits|: multiplied by
+// |limits.scale|, then shrunk further as needed to fit within the maximum
+// width and height, keeping the aspect ratio. Never enlarges, and never
+// returns less than 1 x 1.
+void FitSize(int width, int height, const ResizeLimits& limits,
+             int* out_width, int* out_height);
+
+// Resamples 4-channel images (BGRA or RGBA; every channel is treated alike).
+//
+// Scaling runs in two separable passes with fixed-point SSE2/AVX2 kernels:
+// horizontally into a strip of intermediate rows, then vertically into the
+// output. Whole-number shrink factors (4K to 1080p, or to 256 x 144) take a
+// box-filter fast path instead that sums source rows and averages each
+// block in one pass. Either way the output rows are split into bands that
+// are resampled concurrently. Filter taps, scratch rows and the output
+// buffer are kept, so repeated resizes between the same sizes do not
+// allocate. Not thread-safe.
+class ImageResizer {
+ public:
+  explicit ImageResizer(const ResizeOptions& options = ResizeOptions());
+
+  ImageResizer(const ImageResizer&) = delete;
+  ImageResizer& operator=(const ImageResizer&) = delete;
+
+  const ResizeOptions& options() const { return options_; }
+  void set_options(const ResizeOptions& options) { options_ = options; }
+
+  // Resamples |src| to |width| x |height| into output(). Returns false if
+  // |src| is invalid or the size is not positive.
+  bool Resize(const ImageView& src, int width, int height);
+
+  // Scales |src| down to FitSize() and points |out| at the result: output(),
+  // or |src| itself when the limits leave it alone.
+  bool Fit(const ImageView& src, const ResizeLimits& limits, ImageView* out);
+
+  // Result of the last successful Resize(), packed; valid until the next
+  // call.
+  ImageView output() const;
+
+ private:
+  // Fixed-point filter taps along one axis: destination pixel i is the sum
+  // of |count[i]| source pixels from |first[i]|, weighted by
+  // weights[i * stride ...]. |stride| is even and unused weights are zero,
+  // so the kernels can read weights in pairs.
+  struct Taps {
+    int src_size = 0;
+    int dst_size = 0;
+    ResizeFilter filter = ResizeFilter::kAuto;
+    int stride = 0;
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<int16_t> weights;
+  };
+
+  // Scratch rows of one band.
+  struct Band {
+    std::vector<uint8_t> rows;
+    std::vector<uint16_t> sums;
+  };
+
+  // Recomputes |taps| unless they already map |src_size| to |dst_size|.
+  static void BuildTaps(int src_size, int dst_size, ResizeFilter filter,
+                        Taps* taps);
+
+  // Box-filters output rows [y0, y1) of |src|.
+  void BoxBand(const ImageView& src, int y0, int y1, Band* band);
+
+  // Resamples output rows [y0, y1) of |src| with the filter taps.
+  void FilterBand(const ImageView& src, int y0, int y1, Band* band);
+
+  // Worker count for options_.threads.
+  int ThreadCount() const;
+
+  ResizeOptions options_;
+  Taps horizontal_;
+  Taps vertical_;
+  std::vector<Band> bands_;
+  std::unique_ptr<ThreadPool> pool_;
+  std::vector<uint8_t> output_;
+  int width_ = 0;
+  int height_ = 0;
+  PixelFormat format_ = PixelFormat::kBgra8;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_IMAGE_RESIZER_H_
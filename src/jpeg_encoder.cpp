@@ -0,0 +1,779 @@
+#include "jpeg_encoder.h"
+
+#include <cstring>
+
+#include "cpu_features.h"
+
+#if SCREENSHOT_ARCH_X86
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+// JPEG frames store dimensions as 16-bit values.
+constexpr int kMaxDimension = 65535;
+// Restart intervals are 16-bit as well.
+constexpr int kMaxRestartInterval = 65535;
+// Upper bound on the number of bands (and so threads) per image.
+constexpr size_t kMaxBands = 64;
+// Smallest band worth handing to another thread, in pixels.
+constexpr size_t kMinBandPixels = 128 * 1024;
+// SOI through SOS, with room to spare; see WriteHeaders().
+constexpr size_t kHeaderBound = 1024;
+// Worst case for one entropy-coded block: a 22-bit DC symbol and 63 26-bit
+// AC symbols, every byte stuffed.
+constexpr size_t kMaxBlockBytes = 2 * ((22 + 63 * 26 + 7) / 8);
+
+// Annex K.1 quantization tables, natural (row-major) order.
+constexpr uint8_t kLumaQuant[64] = {
+    16, 11, 10, 16, 24,  40,  51,  61,   //
+    12, 12, 14, 19, 26,  58,  60,  55,   //
+    14, 13, 16, 24, 40,  57,  69,  56,   //
+    14, 17, 22, 29, 51,  87,  80,  62,   //
+    18, 22, 37, 56, 68,  109, 103, 77,   //
+    24, 35, 55, 64, 81,  104, 113, 92,   //
+    49, 64, 78, 87, 103, 121, 120, 101,  //
+    72, 92, 95, 98, 112, 100, 103, 99,
+};
+constexpr uint8_t kChromaQuant[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,  //
+    18, 21, 26, 66, 99, 99, 99, 99,  //
+    24, 26, 56, 99, 99, 99, 99, 99,  //
+    47, 66, 99, 99, 99, 99, 99, 99,  //
+    99, 99, 99, 99, 99, 99, 99, 99,  //
+    99, 99, 99, 99, 99, 99, 99, 99,  //
+    99, 99, 99, 99, 99, 99, 99, 99,  //
+    99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+// Natural index of the k-th coefficient in zigzag order.
+constexpr uint8_t kZigzag[64] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// Annex K.3 Huffman tables: code counts per length (1-16), then symbols.
+constexpr uint8_t kDcLumaBits[16] = {0, 1, 5, 1, 1, 1, 1, 1,
+                                     1, 0, 0, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcChromaBits[16] = {0, 3, 1, 1, 1, 1, 1, 1,
+                                       1, 1, 1, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcValues[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+constexpr uint8_t kAcLumaBits[16] = {0, 2, 1, 3, 3, 2, 4, 3,
+                                     5, 5, 4, 4, 0, 0, 1, 0x7d};
+constexpr uint8_t kAcLumaValues[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06,
+    0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+    0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+    0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+    0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+    0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+    0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9,
+    0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+constexpr uint8_t kAcChromaBits[16] = {0, 2, 1, 2, 4, 4, 3, 4,
+                                       7, 5, 4, 4, 0, 1, 2, 0x77};
+constexpr uint8_t kAcChromaValues[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41,
+    0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+    0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1,
+    0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44,
+    0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+    0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+// Per-frequency output gain of the AAN DCT.
+constexpr float kAanScale[8] = {1.0f,         1.387039845f, 1.306562965f,
+                                1.175875602f, 1.0f,         0.785694958f,
+                                0.541196100f, 0.275899379f};
+
+struct HuffmanCode {
+  uint16_t code[256];
+  uint8_t length[256];
+};
+
+HuffmanCode BuildHuffmanCode(const uint8_t* bits, const uint8_t* values) {
+  HuffmanCode table = {};
+  uint32_t code = 0;
+  size_t k = 0;
+  for (int length = 1; length <= 16; ++length) {
+    for (int i = 0; i < bits[length - 1]; ++i, ++k) {
+      table.code[values[k]] = static_cast<uint16_t>(code++);
+      table.length[values[k]] = static_cast<uint8_t>(length);
+    }
+    code <<= 1;
+  }
+  return table;
+}
+
+struct HuffmanTables {
+  HuffmanCode dc_luma;
+  HuffmanCode ac_luma;
+  HuffmanCode dc_chroma;
+  HuffmanCode ac_chroma;
+};
+
+const HuffmanTables& StandardTables() {
+  static const HuffmanTables tables = {
+      BuildHuffmanCode(kDcLumaBits, kDcValues),
+      BuildHuffmanCode(kAcLumaBits, kAcLumaValues),
+      BuildHuffmanCode(kDcChromaBits, kDcValues),
+      BuildHuffmanCode(kAcChromaBits, kAcChromaValues),
+  };
+  return tables;
+}
+
+// Luma blocks per MCU, horizontally and vertically.
+void SamplingFactors(ChromaSubsampling subsampling, int* h, int* v) {
+  *h = subsampling == ChromaSubsampling::k444 ? 1 : 2;
+  *v = subsampling == ChromaSubsampling::k420 ? 2 : 1;
+}
+
+inline int BitLength(uint32_t v) {
+  if (v == 0) return 0;
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse(&index, v);
+  return static_cast<int>(index) + 1;
+#elif defined(__GNUC__)
+  return 32 - __builtin_clz(v);
+#else
+  int n = 0;
+  while (v != 0) {
+    v >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+// MSB-first bit packer with JPEG byte stuffing (0xFF -> 0xFF 0x00).
+class BitWriter {
+ public:
+  explicit BitWriter(uint8_t* out) : out_(out) {}
+
+  size_t size() const { return pos_; }
+  void set_buffer(uint8_t* out) { out_ = out; }
+
+  // Appends the low |length| (at most 27) bits of |bits|.
+  void Put(uint32_t bits, int length) {
+    acc_ = (acc_ << length) | bits;
+    count_ += length;
+    if (count_ >= 32) Drain32();
+  }
+
+  // Pads the last byte with 1 bits and writes out everything buffered.
+  void Flush() {
+    const int pad = (8 - (count_ & 7)) & 7;
+    acc_ = (acc_ << pad) | ((1u << pad) - 1);
+    count_ += pad;
+    while (count_ >= 8) EmitByte();
+  }
+
+  void PutMarker(uint8_t marker) {
+    out_[pos_++] = 0xFF;
+    out_[pos_++] = marker;
+  }
+
+ private:
+  void EmitByte() {
+    count_ -= 8;
+    const uint8_t byte = static_cast<uint8_t>(acc_ >> count_);
+    out_[pos_++] = byte;
+    if (byte == 0xFF) out_[pos_++] = 0;
+  }
+
+  void Drain32() {
+    const uint32_t word = static_cast<uint32_t>(acc_ >> (count_ - 32));
+    // Fast path when none of the four bytes needs stuffing.
+    const uint32_t inverted = ~word;
+    if (((inverted - 0x01010101u) & ~inverted & 0x80808080u) == 0) {
+      out_[pos_] = static_cast<uint8_t>(word >> 24);
+      out_[pos_ + 1] = static_cast<uint8_t>(word >> 16);
+      out_[pos_ + 2] = static_cast<uint8_t>(word >> 8);
+      out_[pos_ + 3] = static_cast<uint8_t>(word);
+      pos_ += 4;
+      count_ -= 32;
+      return;
+    }
+    for (int i = 0; i < 4; ++i) EmitByte();
+  }
+
+  uint8_t* out_;
+  size_t pos_ = 0;
+  uint64_t acc_ = 0;
+  int count_ = 0;
+};
+
+// One 1-D AAN forward DCT (jfdctflt.c) over each of the 8 columns of |d|:
+// element k of column i is d[k * 8 + i]. Columns are independent, so the
+// loop vectorizes across them.
+void Fdct8Columns(float* d) {
+  for (int i = 0; i < 8; ++i) {
+    float* p = d + i;
+    const float tmp0 = p[0] + p[56];
+    const float tmp7 = p[0] - p[56];
+    const float tmp1 = p[8] + p[48];
+    const float tmp6 = p[8] - p[48];
+    const float tmp2 = p[16] + p[40];
+    const float tmp5 = p[16] - p[40];
+    const float tmp3 = p[24] + p[32];
+    const float tmp4 = p[24] - p[32];
+
+    // Even part.
+    float tmp10 = tmp0 + tmp3;
+    const float tmp13 = tmp0 - tmp3;
+    float tmp11 = tmp1 + tmp2;
+    float tmp12 = tmp1 - tmp2;
+    p[0] = tmp10 + tmp11;
+    p[32] = tmp10 - tmp11;
+    const float z1 = (tmp12 + tmp13) * 0.707106781f;
+    p[16] = tmp13 + z1;
+    p[48] = tmp13 - z1;
+
+    // Odd part.
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+    const float z5 = (tmp10 - tmp12) * 0.382683433f;
+    const float z2 = 0.541196100f * tmp10 + z5;
+    const float z4 = 1.306562965f * tmp12 + z5;
+    const float z3 = tmp11 * 0.707106781f;
+    const float z11 = tmp7 + z3;
+    const float z13 = tmp7 - z3;
+    p[40] = z13 + z2;
+    p[24] = z13 - z2;
+    p[8] = z11 + z4;
+    p[56] = z11 - z4;
+  }
+}
+
+void Transpose8x8(float* d) {
+  for (int r = 0; r < 8; ++r) {
+    for (int c = r + 1; c < 8; ++c) {
+      const float t = d[r * 8 + c];
+      d[r * 8 + c] = d[c * 8 + r];
+      d[c * 8 + r] = t;
+    }
+  }
+}
+
+// 2-D DCT of a row-major block. The result is left transposed: coefficient
+// (v, u) ends up at d[u * 8 + v], which the quantizer tables account for.
+void ForwardDct(float* d) {
+  Fdct8Columns(d);
+  Transpose8x8(d);
+  Fdct8Columns(d);
+}
+
+// Position of natural coefficient |n| in ForwardDct's output.
+inline int Transposed(int n) { return (n & 7) * 8 + (n >> 3); }
+
+// Y, Cb and Cr of |pixels| pixels, level-shifted to be centered on zero.
+void RgbToYccScalar(const uint8_t* src, int r_at, size_t pixels, float* y,
+                    float* cb, float* cr) {
+  const int b_at = 2 - r_at;
+  for (size_t i = 0; i < pixels; ++i, src += kBytesPerPixel) {
+    const float r = static_cast<float>(src[r_at]);
+    const float g = static_cast<float>(src[1]);
+    const float b = static_cast<float>(src[b_at]);
+    y[i] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+    cb[i] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+    cr[i] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+  }
+}
+
+#if SCREENSHOT_ARCH_X86
+size_t RgbToYccSse2(const uint8_t* src, int r_at, size_t pixels, float* y,
+                    float* cb, float* cr) {
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  const __m128 bias = _mm_set1_ps(128.0f);
+  size_t i = 0;
+  for (; i + 4 <= pixels; i += 4) {
+    const __m128i v = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + i * kBytesPerPixel));
+    const __m128 c0 = _mm_cvtepi32_ps(_mm_and_si128(v, mask));
+    const __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 8), mask));
+    const __m128 c2 =
+        _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 16), mask));
+    const __m128 r = r_at == 0 ? c0 : c2;
+    const __m128 b = r_at == 0 ? c2 : c0;
+    __m128 luma = _mm_mul_ps(r, _mm_set1_ps(0.299f));
+    luma = _mm_add_ps(luma, _mm_mul_ps(g, _mm_set1_ps(0.587f)));
+    luma = _mm_add_ps(luma, _mm_mul_ps(b, _mm_set1_ps(0.114f)));
+    _mm_storeu_ps(y + i, _mm_sub_ps(luma, bias));
+    __m128 blue = _mm_mul_ps(r, _mm_set1_ps(-0.168736f));
+    blue = _mm_sub_ps(blue, _mm_mul_ps(g, _mm_set1_ps(0.331264f)));
+    blue = _mm_add_ps(blue, _mm_mul_ps(b, _mm_set1_ps(0.5f)));
+    _mm_storeu_ps(cb + i, blue);
+    __m128 red = _mm_mul_ps(r, _mm_set1_ps(0.5f));
+    red = _mm_sub_ps(red, _mm_mul_ps(g, _mm_set1_ps(0.418688f)));
+    red = _mm_sub_ps(red, _mm_mul_ps(b, _mm_set1_ps(0.081312f)));
+    _mm_storeu_ps(cr + i, red);
+  }
+  return i;
+}
+#endif
+
+void RgbToYcc(const uint8_t* src, int r_at, size_t pixels, float* y,
+              float* cb, float* cr) {
+  size_t done = 0;
+#if SCREENSHOT_ARCH_X86
+  if (GetCpuFeatures().sse2) done = RgbToYccSse2(src, r_at, pixels, y, cb, cr);
+#endif
+  RgbToYccScalar(src + done * kBytesPerPixel, r_at, pixels - done, y + done,
+                 cb + done, cr + done);
+}
+
+// Averages 2 x |v| cells of the |width| x |height| plane |src| into |dst|
+// (every subsampling mode halves the horizontal resolution).
+void Downsample(const float* src, int width, int height, int v, float* dst) {
+  const int out_width = width / 2;
+  const size_t w = static_cast<size_t>(width);
+  const float weight = v == 2 ? 0.25f : 0.5f;
+  for (int y = 0; y < height / v; ++y) {
+    const float* row0 = src + static_cast<size_t>(y * v) * w;
+    float* out = dst + static_cast<size_t>(y) * static_cast<size_t>(out_width);
+    if (v == 2) {
+      const float* row1 = row0 + w;
+      for (int x = 0; x < out_width; ++x) {
+        out[x] = weight * (row0[2 * x] + row0[2 * x + 1] + row1[2 * x] +
+                           row1[2 * x + 1]);
+      }
+    } else {
+      for (int x = 0; x < out_width; ++x) {
+        out[x] = weight * (row0[2 * x] + row0[2 * x + 1]);
+      }
+    }
+  }
+}
+
+// Transforms, quantizes and entropy-codes the 8x8 block at |src|.
+void EncodeBlock(const float* src, size_t stride, const float* scale,
+                 const HuffmanCode& dc_code, const HuffmanCode& ac_code,
+                 int* dc_pred, BitWriter* writer) {
+  float block[64];
+  for (int r = 0; r < 8; ++r) {
+    std::memcpy(block + r * 8, src + static_cast<size_t>(r) * stride,
+                8 * sizeof(float));
+  }
+  ForwardDct(block);
+  int coef[64];
+  for (int i = 0; i < 64; ++i) {
+    const float q = block[i] * scale[i];
+    coef[i] = static_cast<int>(q >= 0.0f ? q + 0.5f : q - 0.5f);
+  }
+
+  // Baseline limits DC differences to 11 bits and AC values to 10.
+  int diff = coef[0] - *dc_pred;
+  diff = diff < -2047 ? -2047 : (diff > 2047 ? 2047 : diff);
+  *dc_pred += diff;
+  {
+    const uint32_t magnitude = static_cast<uint32_t>(diff < 0 ? -diff : diff);
+    const int size = BitLength(magnitude);
+    const uint32_t bits = static_cast<uint32_t>(diff < 0 ? diff - 1 : diff) &
+                          ((1u << size) - 1);
+    writer->Put(dc_code.code[size], dc_code.length[size]);
+    if (size != 0) writer->Put(bits, size);
+  }
+
+  static const struct ZigzagTransposed {
+    uint8_t index[64];
+    ZigzagTransposed() {
+      for (int k = 0; k < 64; ++k) {
+        index[k] = static_cast<uint8_t>(Transposed(kZigzag[k]));
+      }
+    }
+  } zigzag;
+  int run = 0;
+  for (int k = 1; k < 64; ++k) {
+    int value = coef[zigzag.index[k]];
+    if (value == 0) {
+      ++run;
+      continue;
+    }
+    value = value < -1023 ? -1023 : (value > 1023 ? 1023 : value);
+    while (run > 15) {
+      writer->Put(ac_code.code[0xF0], ac_code.length[0xF0]);
+      run -= 16;
+    }
+    const uint32_t magnitude =
+        static_cast<uint32_t>(value < 0 ? -value : value);
+    const int size = BitLength(magnitude);
+    const uint32_t bits = static_cast<uint32_t>(value < 0 ? value - 1 : value) &
+                          ((1u << size) - 1);
+    const int symbol = (run << 4) | size;
+    writer->Put((static_cast<uint32_t>(ac_code.code[symbol]) << size) | bits,
+                ac_code.length[symbol] + size);
+    run = 0;
+  }
+  if (run > 0) writer->Put(ac_code.code[0x00], ac_code.length[0x00]);
+}
+
+inline void StoreBe16(uint8_t* p, int v) {
+  p[0] = static_cast<uint8_t>(v >> 8);
+  p[1] = static_cast<uint8_t>(v);
+}
+
+}  // namespace
+
+JpegEncoder::JpegEncoder(const JpegEncodeOptions& options)
+    : options_(options) {
+  BuildTables();
+}
+
+void JpegEncoder::set_options(const JpegEncodeOptions& options) {
+  options_ = options;
+  BuildTables();
+}
+
+void JpegEncoder::BuildTables() {
+  int quality = options_.quality;
+  quality = quality < 1 ? 1 : (quality > 100 ? 100 : quality);
+  const int percent = quality < 50 ? 5000 / quality : 200 - quality * 2;
+  for (int k = 0; k < 64; ++k) {
+    const int n = kZigzag[k];
+    const float aan = kAanScale[n >> 3] * kAanScale[n & 7] * 8.0f;
+    for (int table = 0; table < 2; ++table) {
+      const int base = table == 0 ? kLumaQuant[n] : kChromaQuant[n];
+      int q = (base * percent + 50) / 100;
+      q = q < 1 ? 1 : (q > 255 ? 255 : q);
+      uint8_t* quant = table == 0 ? luma_quant_ : chroma_quant_;
+      float* scale = table == 0 ? luma_scale_ : chroma_scale_;
+      quant[k] = static_cast<uint8_t>(q);
+      scale[Transposed(n)] = 1.0f / (static_cast<float>(q) * aan);
+    }
+  }
+}
+
+size_t JpegEncoder::MaxEncodedSize(int width, int height) {
+  if (width <= 0 || height <= 0 || width > kMaxDimension ||
+      height > kMaxDimension) {
+    return 0;
+  }
+  // Every subsampling needs at most three blocks per 8x8 pixels.
+  const size_t blocks = static_cast<size_t>((width + 15) / 16) * 2 *
+                        static_cast<size_t>((height + 15) / 16) * 2 * 3;
+  // Each band may end with a padding byte and a restart marker.
+  return kHeaderBound + blocks * kMaxBlockBytes + kMaxBands * 3 + 2;
+}
+
+int JpegEncoder::ThreadCount() const {
+  const int threads = ThreadPool::ResolveThreadCount(options_.threads);
+  return threads < static_cast<int>(kMaxBands) ? threads
+                                               : static_cast<int>(kMaxBands);
+}
+
+int JpegEncoder::PlanBands(const ImageView& image) {
+  int h = 1;
+  int v = 1;
+  SamplingFactors(options_.subsampling, &h, &v);
+  const int mcus_per_row = (image.width + 8 * h - 1) / (8 * h);
+  const int mcu_rows = (image.height + 8 * v - 1) / (8 * v);
+
+  size_t count = static_cast<size_t>(ThreadCount());
+  const size_t max_by_size = static_cast<size_t>(image.width) *
+                             static_cast<size_t>(image.height) /
+                             kMinBandPixels;
+  if (count > max_by_size) count = max_by_size;
+  if (count > static_cast<size_t>(mcu_rows)) {
+    count = static_cast<size_t>(mcu_rows);
+  }
+  if (count == 0) count = 1;
+
+  // Bands share one restart interval, so all but the last have the same
+  // number of MCU rows.
+  int rows_per_band = static_cast<int>(
+      (static_cast<size_t>(mcu_rows) + count - 1) / count);
+  const int max_rows = kMaxRestartInterval / mcus_per_row;
+  if (count > 1 && rows_per_band > max_rows) {
+    rows_per_band = max_rows > 0 ? max_rows : 1;
+  }
+  count = static_cast<size_t>((mcu_rows + rows_per_band - 1) / rows_per_band);
+  if (count > kMaxBands) {
+    // Too wide for a restart interval per band; fall back to one band.
+    count = 1;
+    rows_per_band = mcu_rows;
+  }
+
+  while (bands_.size() < count) bands_.push_back(std::make_unique<Band>());
+  bands_.resize(count);
+  const size_t padded_width = static_cast<size_t>(mcus_per_row * 8 * h);
+  const size_t plane = padded_width * static_cast<size_t>(8 * v);
+  const size_t chroma_plane = plane / static_cast<size_t>(h * v);
+  for (size_t i = 0; i < count; ++i) {
+    Band* band = bands_[i].get();
+    band->first_mcu_row = static_cast<int>(i) * rows_per_band;
+    band->end_mcu_row = band->first_mcu_row + rows_per_band;
+    if (band->end_mcu_row > mcu_rows) band->end_mcu_row = mcu_rows;
+    band->planes.resize(3 * plane + (h * v > 1 ? 2 * chroma_plane : 0));
+  }
+
+  if (count > 1) {
+    const int workers = static_cast<int>(count) - 1;
+    if (!pool_ || pool_->size() != workers) {
+      pool_ = std::make_unique<ThreadPool>(workers);
+    }
+  }
+  return count > 1 ? rows_per_band * mcus_per_row : 0;
+}
+
+void JpegEncoder::EncodeBand(const ImageView& image, size_t index,
+                             Band* band) {
+  const HuffmanTables& huffman = StandardTables();
+  int h = 1;
+  int v = 1;
+  SamplingFactors(options_.subsampling, &h, &v);
+  const int mcu_width = 8 * h;
+  const int mcu_height = 8 * v;
+  const int mcus_per_row = (image.width + mcu_width - 1) / mcu_width;
+  const int padded_width = mcus_per_row * mcu_width;
+  const size_t stride = static_cast<size_t>(padded_width);
+  const size_t plane = stride * static_cast<size_t>(mcu_height);
+  const int chroma_width = padded_width / h;
+  const size_t chroma_stride = static_cast<size_t>(chroma_width);
+  float* y_plane = band->planes.data();
+  float* cb_plane = y_plane + plane;
+  float* cr_plane = cb_plane + plane;
+  float* cb_blocks = cb_plane;
+  float* cr_blocks = cr_plane;
+  if (h * v > 1) {
+    cb_blocks = cr_plane + plane;
+    cr_blocks = cb_blocks + plane / static_cast<size_t>(h * v);
+  }
+
+  const int r_at = image.format == PixelFormat::kBgra8 ? 2 : 0;
+  const size_t width = static_cast<size_t>(image.width);
+  const size_t mcu_bytes = static_cast<size_t>(h * v + 2) * kMaxBlockBytes;
+  // Room for the last MCU's flush plus a restart marker.
+  const size_t tail_bytes = 16;
+
+  BitWriter writer(band->entropy.data());
+  int dc[3] = {0, 0, 0};
+  for (int mcu_row = band->first_mcu_row; mcu_row < band->end_mcu_row;
+       ++mcu_row) {
+    for (int r = 0; r < mcu_height; ++r) {
+      int src_row = mcu_row * mcu_height + r;
+      if (src_row >= image.height) src_row = image.height - 1;
+      const size_t offset = static_cast<size_t>(r) * stride;
+      float* y = y_plane + offset;
+      float* cb = cb_plane + offset;
+      float* cr = cr_plane + offset;
+      RgbToYcc(image.Row(src_row), r_at, width, y, cb, cr);
+      // Replicate the last column into the MCU padding.
+      for (size_t x = width; x < stride; ++x) {
+        y[x] = y[width - 1];
+        cb[x] = cb[width - 1];
+        cr[x] = cr[width - 1];
+      }
+    }
+    if (h * v > 1) {
+      Downsample(cb_plane, padded_width, mcu_height, v, cb_blocks);
+      Downsample(cr_plane, padded_width, mcu_height, v, cr_blocks);
+    }
+
+    for (int mcu = 0; mcu < mcus_per_row; ++mcu) {
+      if (band->entropy.size() < writer.size() + mcu_bytes + tail_bytes) {
+        size_t grown = band->entropy.size() * 2;
+        if (grown < writer.size() + mcu_bytes + tail_bytes) {
+          grown = writer.size() + mcu_bytes + tail_bytes;
+        }
+        band->entropy.resize(grown);
+        writer.set_buffer(band->entropy.data());
+      }
+      const size_t x = static_cast<size_t>(mcu * mcu_width);
+      for (int by = 0; by < v; ++by) {
+        for (int bx = 0; bx < h; ++bx) {
+          EncodeBlock(y_plane + static_cast<size_t>(by * 8) * stride + x +
+                          static_cast<size_t>(bx * 8),
+                      stride, luma_scale_, huffman.dc_luma, huffman.ac_luma,
+                      &dc[0], &writer);
+        }
+      }
+      const size_t chroma_x = static_cast<size_t>(mcu * 8);
+      EncodeBlock(cb_blocks + chroma_x, chroma_stride, chroma_scale_,
+                  huffman.dc_chroma, huffman.ac_chroma, &dc[1], &writer);
+      EncodeBlock(cr_blocks + chroma_x, chroma_stride, chroma_scale_,
+                  huffman.dc_chroma, huffman.ac_chroma, &dc[2], &writer);
+    }
+  }
+  writer.Flush();
+  if (index + 1 < bands_.size()) {
+    writer.PutMarker(static_cast<uint8_t>(0xD0 + (index & 7)));
+  }
+  band->entropy_size = writer.size();
+}
+
+size_t JpegEncoder::WriteHeaders(const ImageView& image, int restart_interval,
+                                 uint8_t* out) const {
+  int h = 1;
+  int v = 1;
+  SamplingFactors(options_.subsampling, &h, &v);
+  uint8_t* p = out;
+
+  // SOI, then a JFIF APP0 segment: version 1.01, no density units, 1:1.
+  static constexpr uint8_t kJfif[] = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10,
+                                      'J',  'F',  'I',  'F',  0x00, 0x01,
+                                      0x01, 0x00, 0x00, 0x01, 0x00, 0x01,
+                                      0x00, 0x00};
+  std::memcpy(p, kJfif, sizeof(kJfif));
+  p += sizeof(kJfif);
+
+  // DQT: 8-bit tables 0 (luma) and 1 (chroma), zigzag order.
+  *p++ = 0xFF;
+  *p++ = 0xDB;
+  StoreBe16(p, 2 + 2 * 65);
+  p += 2;
+  *p++ = 0;
+  std::memcpy(p, luma_quant_, 64);
+  p += 64;
+  *p++ = 1;
+  std::memcpy(p, chroma_quant_, 64);
+  p += 64;
+
+  // SOF0: baseline, 8-bit, three components.
+  *p++ = 0xFF;
+  *p++ = 0xC0;
+  StoreBe16(p, 8 + 3 * 3);
+  p += 2;
+  *p++ = 8;
+  StoreBe16(p, image.height);
+  p += 2;
+  StoreBe16(p, image.width);
+  p += 2;
+  *p++ = 3;
+  for (int c = 1; c <= 3; ++c) {
+    *p++ = static_cast<uint8_t>(c);
+    *p++ = static_cast<uint8_t>(c == 1 ? (h << 4) | v : 0x11);
+    *p++ = static_cast<uint8_t>(c == 1 ? 0 : 1);
+  }
+
+  // DHT: class/id, then counts and symbols, for each of the four tables.
+  struct Table {
+    uint8_t class_id;
+    const uint8_t* bits;
+    const uint8_t* values;
+    size_t count;
+  };
+  static constexpr Table kTables[4] = {
+      {0x00, kDcLumaBits, kDcValues, sizeof(kDcValues)},
+      {0x10, kAcLumaBits, kAcLumaValues, sizeof(kAcLumaValues)},
+      {0x01, kDcChromaBits, kDcValues, sizeof(kDcValues)},
+      {0x11, kAcChromaBits, kAcChromaValues, sizeof(kAcChromaValues)},
+  };
+  size_t dht_length = 2;
+  for (const Table& table : kTables) dht_length += 1 + 16 + table.count;
+  *p++ = 0xFF;
+  *p++ = 0xC4;
+  StoreBe16(p, static_cast<int>(dht_length));
+  p += 2;
+  for (const Table& table : kTables) {
+    *p++ = table.class_id;
+    std::memcpy(p, table.bits, 16);
+    p += 16;
+    std::memcpy(p, table.values, table.count);
+    p += table.count;
+  }
+
+  if (restart_interval > 0) {
+    *p++ = 0xFF;
+    *p++ = 0xDD;
+    StoreBe16(p, 4);
+    p += 2;
+    StoreBe16(p, restart_interval);
+    p += 2;
+  }
+
+  // SOS: all three components interleaved, full spectral range.
+  static constexpr uint8_t kSos[] = {0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01,
+                                     0x00, 0x02, 0x11, 0x03, 0x11, 0x00,
+                                     0x3F, 0x00};
+  std::memcpy(p, kSos, sizeof(kSos));
+  p += sizeof(kSos);
+  return static_cast<size_t>(p - out);
+}
+
+size_t JpegEncoder::EncodeBands(const ImageView& image,
+                                int* restart_interval) {
+  if (!image.IsValid() || MaxEncodedSize(image.width, image.height) == 0) {
+    return 0;
+  }
+  *restart_interval = PlanBands(image);
+  const size_t band_count = bands_.size();
+  if (band_count == 1) {
+    EncodeBand(image, 0, bands_[0].get());
+  } else {
+    pool_->ParallelFor(band_count, [&](size_t i) {
+      EncodeBand(image, i, bands_[i].get());
+    });
+  }
+  size_t size = kHeaderBound + 2;
+  for (const auto& band : bands_) size += band->entropy_size;
+  return size;
+}
+
+size_t JpegEncoder::Assemble(const ImageView& image, int restart_interval,
+                             uint8_t* out) const {
+  uint8_t* p = out + WriteHeaders(image, restart_interval, out);
+  for (const auto& band : bands_) {
+    std::memcpy(p, band->entropy.data(), band->entropy_size);
+    p += band->entropy_size;
+  }
+  *p++ = 0xFF;
+  *p++ = 0xD9;  // EOI
+  return static_cast<size_t>(p - out);
+}
+
+size_t JpegEncoder::Encode(const ImageView& image, uint8_t* out,
+                           size_t capacity) {
+  int restart_interval = 0;
+  const size_t bound = EncodeBands(image, &restart_interval);
+  if (bound == 0 || capacity < bound) return 0;
+  return Assemble(image, restart_interval, out);
+}
+
+bool JpegEncoder::Encode(const ImageView& image, std::vector<uint8_t>* out) {
+  int restart_interval = 0;
+  const size_t bound = EncodeBands(image, &restart_interval);
+  if (bound == 0) return false;
+  out->resize(bound);
+  out->resize(Assemble(image, restart_interval, out->data()));
+  return true;
+}
+
+bool JpegEncoder::Encode(const ImageView& image, ByteSink* sink) {
+  int restart_interval = 0;
+  if (EncodeBands(image, &restart_interval) == 0) return false;
+  uint8_t headers[kHeaderBound];
+  if (!sink->Write(headers, WriteHeaders(image, restart_interval, headers))) {
+    return false;
+  }
+  for (const auto& band : bands_) {
+    if (!sink->Write(band->entropy.data(), band->entropy_size)) return false;
+  }
+  const uint8_t eoi[2] = {0xFF, 0xD9};
+  return sink->Write(eoi, sizeof(eoi));
+}
+
+}  // namespace screenshot
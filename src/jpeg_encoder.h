@@ -0,0 +1,118 @@
+#ifndef SCREENSHOT_CORE_JPEG_ENCODER_H_
+#define SCREENSHOT_CORE_JPEG_ENCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "byte_sink.h"
+#include "image.h"
+#include "thread_pool.h"
+
+namespace screenshot {
+
+// Resolution of the chroma (Cb/Cr) planes relative to luma.
+enum class ChromaSubsampling {
+  k444,  // full resolution; best for text and UI edges
+  k422,  // half horizontal resolution
+  k420,  // half horizontal and vertical resolution; smallest
+};
+
+struct JpegEncodeOptions {
+  // 1 (smallest) to 100 (best); scales the Annex K quantization tables the
+  // same way libjpeg's jpeg_set_quality() does, so sizes and artifacts are
+  // comparable to other encoders at the same setting.
+  int quality = 85;
+  ChromaSubsampling subsampling = ChromaSubsampling::k420;
+  // Threads used to transform and entropy-code; 0 uses every core. With
+  // more than one thread the image is split into bands of MCU rows separated
+  // by restart markers, which every baseline decoder handles.
+  int threads = 1;
+};
+
+// Encodes 8-bit BGRA/RGBA pixels (alpha is ignored) as a baseline JFIF JPEG
+// with the standard Huffman tables.
+//
+// Keeps its plane and entropy buffers (and its worker threads) between calls,
+// so reusing one instance for frames of the same size allocates nothing after
+// the first frame. Not thread-safe.
+class JpegEncoder {
+ public:
+  explicit JpegEncoder(const JpegEncodeOptions& options = JpegEncodeOptions());
+
+  const JpegEncodeOptions& options() const { return options_; }
+  void set_options(const JpegEncodeOptions& options);
+
+  // Worst-case size of a |width| x |height| image; 0 if the dimensions are
+  // not positive or exceed the format's 65535 limit. Real output is usually
+  // one to two orders of magnitude smaller.
+  static size_t MaxEncodedSize(int width, int height);
+
+  // Encodes |image| into |out|. Returns the encoded size, or 0 if the image
+  // is invalid or |capacity| is too small for this frame (never the case
+  // when it is at least MaxEncodedSize).
+  size_t Encode(const ImageView& image, uint8_t* out, size_t capacity);
+
+  // Convenience overload that sizes |out| to the encoded size. Returns false
+  // on failure.
+  bool Encode(const ImageView& image, std::vector<uint8_t>* out);
+
+  // Writes the headers and each band's entropy-coded data straight to
+  // |sink|, skipping the worst-case output buffer and the copy into it.
+  // Returns false if the image is invalid or |sink| fails.
+  bool Encode(const ImageView& image, ByteSink* sink);
+
+ private:
+  // Consecutive MCU rows, transformed and entropy-coded independently.
+  struct Band {
+    int first_mcu_row = 0;
+    int end_mcu_row = 0;
+    // One MCU row of level-shifted Y, Cb and Cr samples, plus the
+    // subsampled Cb and Cr.
+    std::vector<float> planes;
+    std::vector<uint8_t> entropy;
+    size_t entropy_size = 0;
+  };
+
+  // Rebuilds the scaled quantization tables from options_.quality.
+  void BuildTables();
+
+  // Splits |image| into bands_ according to options_.threads. Returns the
+  // restart interval in MCUs, 0 for a single band.
+  int PlanBands(const ImageView& image);
+
+  // Entropy-codes the band into band->entropy, ending with a restart marker
+  // unless it is the last band.
+  void EncodeBand(const ImageView& image, size_t index, Band* band);
+
+  // Writes SOI through SOS to |out| (at least kHeaderBound bytes).
+  size_t WriteHeaders(const ImageView& image, int restart_interval,
+                      uint8_t* out) const;
+
+  // Encodes every band and returns the total size of the stream, or 0 if
+  // |image| cannot be encoded.
+  size_t EncodeBands(const ImageView& image, int* restart_interval);
+
+  // Copies headers, entropy-coded bands and EOI to |out|.
+  size_t Assemble(const ImageView& image, int restart_interval,
+                  uint8_t* out) const;
+
+  // Worker count for options_.threads.
+  int ThreadCount() const;
+
+  JpegEncodeOptions options_;
+  // Quantizers in zigzag order, as written to DQT.
+  uint8_t luma_quant_[64];
+  uint8_t chroma_quant_[64];
+  // Reciprocal step sizes folded with the DCT's output scaling, in the
+  // (transposed) order the DCT leaves coefficients in.
+  float luma_scale_[64];
+  float chroma_scale_[64];
+  std::vector<std::unique_ptr<Band>> bands_;
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_JPEG_ENCODER_H_
@@ -0,0 +1,180 @@
+#include "lz4.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+// 4096 entries (16 KiB) stay in L1; larger tables gain little ratio on screen
+// content and lose a lot of speed to cache misses.
+constexpr int kHashBits = 12;
+constexpr size_t kMinMatch = 4;
+// The last match must start at least this many bytes before the end of the
+// block, and the last this-many bytes are always literals (LZ4 block format
+// end-of-block conditions).
+constexpr size_t kMatchFindLimit = 12;
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMaxDistance = 65535;
+// After 2^kSkipTrigger failed probes the search starts skipping ahead, so
+// incompressible input is passed through quickly.
+constexpr int kSkipTrigger = 6;
+
+inline uint32_t Load32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t Load64(const uint8_t* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t Hash(const uint8_t* p) {
+  return (Load32(p) * 2654435761u) >> (32 - kHashBits);
+}
+
+// Index of the lowest set bit of a non-zero |v|.
+inline size_t CountTrailingZeros64(uint64_t v) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index;
+  _BitScanForward64(&index, v);
+  return index;
+#elif defined(__GNUC__)
+  return static_cast<size_t>(__builtin_ctzll(v));
+#else
+  size_t n = 0;
+  while ((v & 1) == 0) {
+    v >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+// Number of equal bytes at |a| and |b|, not reading past |a_end|. Assumes a
+// little-endian host, like every platform the plugin builds for.
+inline size_t MatchLength(const uint8_t* a, const uint8_t* b,
+                          const uint8_t* a_end) {
+  const uint8_t* const start = a;
+  while (a + 8 <= a_end) {
+    const uint64_t diff = Load64(a) ^ Load64(b);
+    if (diff != 0) {
+      return static_cast<size_t>(a - start) + CountTrailingZeros64(diff) / 8;
+    }
+    a += 8;
+    b += 8;
+  }
+  while (a < a_end && *a == *b) {
+    ++a;
+    ++b;
+  }
+  return static_cast<size_t>(a - start);
+}
+
+// Writes the 255-run length extension for a length field that saturated at
+// 15 in the token.
+inline uint8_t* WriteLength(uint8_t* op, size_t len) {
+  while (len >= 255) {
+    *op++ = 255;
+    len -= 255;
+  }
+  *op++ = static_cast<uint8_t>(len);
+  return op;
+}
+
+inline uint8_t* WriteLiterals(uint8_t* op, uint8_t* token,
+                              const uint8_t* literals, size_t count) {
+  if (count >= 15) {
+    *token = 15 << 4;
+    op = WriteLength(op, count - 15);
+  } else {
+    *token = static_cast<uint8_t>(count << 4);
+  }
+  if (count == 0) return op;  // |literals| may be null for empty input.
+  std::memcpy(op, literals, count);
+  return op + count;
+}
+
+}  // namespace
+
+Lz4Encoder::Lz4Encoder() : table_(size_t{1} << kHashBits) {}
+
+size_t Lz4Encoder::CompressBound(size_t len) { return len + len / 255 + 16; }
+
+size_t Lz4Encoder::Compress(const uint8_t* data, size_t len, uint8_t* out) {
+  uint8_t* op = out;
+  const uint8_t* anchor = data;
+  const uint8_t* const end = data + len;
+
+  if (len > kMatchFindLimit) {
+    // Candidates are range-checked and verified anyway; clearing keeps the
+    // output independent of earlier blocks.
+    std::fill(table_.begin(), table_.end(), 0u);
+    uint32_t* const table = table_.data();
+    const uint8_t* const match_limit = end - kMatchFindLimit;
+    const uint8_t* const match_end = end - kLastLiterals;
+    const uint8_t* ip = data + 1;
+
+    for (;;) {
+      // Find a match.
+      const uint8_t* match;
+      uint32_t probes = 1u << kSkipTrigger;
+      for (;;) {
+        if (ip > match_limit) goto last_literals;
+        const uint32_t h = Hash(ip);
+        const uint32_t pos = static_cast<uint32_t>(ip - data);
+        match = data + table[h];
+        table[h] = pos;
+        if (match < ip && static_cast<size_t>(ip - match) <= kMaxDistance &&
+            Load32(match) == Load32(ip)) {
+          break;
+        }
+        ip += probes++ >> kSkipTrigger;
+      }
+
+      // Extend backwards over pending literals.
+      while (ip > anchor && match > data && ip[-1] == match[-1]) {
+        --ip;
+        --match;
+      }
+
+      uint8_t* token = op++;
+      op = WriteLiterals(op, token, anchor, static_cast<size_t>(ip - anchor));
+
+      const size_t distance = static_cast<size_t>(ip - match);
+      *op++ = static_cast<uint8_t>(distance);
+      *op++ = static_cast<uint8_t>(distance >> 8);
+
+      const size_t length =
+          kMinMatch + MatchLength(ip + kMinMatch, match + kMinMatch, match_end);
+      const size_t code = length - kMinMatch;
+      if (code >= 15) {
+        *token |= 15;
+        op = WriteLength(op, code - 15);
+      } else {
+        *token |= static_cast<uint8_t>(code);
+      }
+
+      ip += length;
+      anchor = ip;
+      if (ip > match_limit) break;
+      // Seed the table with a position inside the match, which helps on runs.
+      table[Hash(ip - 2)] = static_cast<uint32_t>(ip - 2 - data);
+    }
+  }
+
+last_literals:
+  uint8_t* token = op++;
+  op = WriteLiterals(op, token, anchor, static_cast<size_t>(end - anchor));
+  return static_cast<size_t>(op - out);
+}
+
+}  // namespace screenshot
@@ -0,0 +1,34 @@
+#ifndef SCREENSHOT_CORE_LZ4_H_
+#define SCREENSHOT_CORE_LZ4_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace screenshot {
+
+// LZ4 block compressor (the raw block format, without frame headers).
+//
+// Greedy single-probe hash matching like the reference LZ4_compress_fast():
+// a few hundred MB/s to several GB/s depending on how repetitive the input is,
+// at a much lower ratio than DeflateEncoder. The hash table is kept between
+// calls, so compressing many blocks allocates nothing after the first one.
+class Lz4Encoder {
+ public:
+  Lz4Encoder();
+
+  // Upper bound on the compressed size of a |len|-byte block.
+  static size_t CompressBound(size_t len);
+
+  // Compresses data[0, len) into |out|, which must hold CompressBound(len)
+  // bytes, and returns the compressed size. Blocks are independent: matches
+  // never reach before |data|.
+  size_t Compress(const uint8_t* data, size_t len, uint8_t* out);
+
+ private:
+  std::vector<uint32_t> table_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_LZ4_H_
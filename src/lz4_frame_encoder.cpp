@@ -0,0 +1,232 @@
+#include "lz4_frame_encoder.h"
+
+#include <cstring>
+
+#include "checksum.h"
+#include "pixel_convert.h"
+
+namespace screenshot {
+
+namespace {
+
+constexpr uint32_t kFrameMagic = 0x184D2204;
+// FLG: version 01, independent blocks, content size present.
+constexpr uint8_t kFrameFlags = 0x40 | 0x20 | 0x08;
+// BD: maximum block size 1 MiB.
+constexpr uint8_t kBlockDescriptor = 6 << 4;
+constexpr size_t kFrameHeaderSize = 4 + 2 + 8 + 1;
+constexpr size_t kBlockHeaderSize = 4;
+constexpr size_t kEndMarkSize = 4;
+// Block size field flag for blocks stored uncompressed.
+constexpr uint32_t kUncompressedBit = 0x80000000u;
+
+inline void StoreLe32(uint8_t* p, uint32_t v) {
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+  p[2] = static_cast<uint8_t>(v >> 16);
+  p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+inline void StoreLe64(uint8_t* p, uint64_t v) {
+  StoreLe32(p, static_cast<uint32_t>(v));
+  StoreLe32(p + 4, static_cast<uint32_t>(v >> 32));
+}
+
+size_t ContentSize(int width, int height) {
+  return static_cast<size_t>(width) * static_cast<size_t>(height) *
+         kBytesPerPixel;
+}
+
+size_t BlockCount(size_t content_size) {
+  return (content_size + Lz4FrameEncoder::kBlockSize - 1) /
+         Lz4FrameEncoder::kBlockSize;
+}
+
+void WriteFrameHeader(size_t content_size, uint8_t* p) {
+  StoreLe32(p, kFrameMagic);
+  uint8_t* descriptor = p + 4;
+  descriptor[0] = kFrameFlags;
+  descriptor[1] = kBlockDescriptor;
+  StoreLe64(descriptor + 2, content_size);
+  descriptor[10] =
+      static_cast<uint8_t>(XxHash32(descriptor, 10, 0) >> 8);
+}
+
+}  // namespace
+
+Lz4FrameEncoder::Lz4FrameEncoder(const Lz4FrameEncodeOptions& options)
+    : options_(options) {}
+
+size_t Lz4FrameEncoder::MaxEncodedSize(int width, int height) {
+  if (width <= 0 || height <= 0) return 0;
+  const size_t content = ContentSize(width, height);
+  const size_t full_blocks = content / kBlockSize;
+  const size_t tail = content % kBlockSize;
+  size_t size = kFrameHeaderSize + kEndMarkSize +
+                full_blocks * (kBlockHeaderSize +
+                               Lz4Encoder::CompressBound(kBlockSize));
+  if (tail != 0) size += kBlockHeaderSize + Lz4Encoder::CompressBound(tail);
+  return size;
+}
+
+size_t Lz4FrameEncoder::ThreadCount(size_t block_count) const {
+  const size_t threads =
+      static_cast<size_t>(ThreadPool::ResolveThreadCount(options_.threads));
+  return threads < block_count ? threads : block_count;
+}
+
+ThreadPool* Lz4FrameEncoder::Pool(size_t threads) {
+  if (threads <= 1) return nullptr;
+  const int workers = static_cast<int>(threads) - 1;
+  if (!pool_ || pool_->size() != workers) {
+    pool_ = std::make_unique<ThreadPool>(workers);
+  }
+  return pool_.get();
+}
+
+const uint8_t* Lz4FrameEncoder::Pack(const ImageView& image,
+                                     ThreadPool* pool, size_t bands) {
+  const size_t row_bytes = image.RowBytes();
+  if (image.format == PixelFormat::kBgra8 && !options_.force_opaque &&
+      image.stride == row_bytes) {
+    return image.data;
+  }
+  packed_.resize(ContentSize(image.width, image.height));
+  const size_t height = static_cast<size_t>(image.height);
+  auto convert_band = [&](size_t band) {
+    const size_t first = height * band / bands;
+    const size_t last = height * (band + 1) / bands;
+    for (size_t y = first; y < last; ++y) {
+      ConvertRow(image.Row(static_cast<int>(y)), image.format,
+                 packed_.data() + y * row_bytes, PixelFormat::kBgra8,
+                 static_cast<size_t>(image.width), options_.force_opaque);
+    }
+  };
+  if (pool) {
+    pool->ParallelFor(bands, convert_band);
+  } else {
+    for (size_t band = 0; band < bands; ++band) convert_band(band);
+  }
+  return packed_.data();
+}
+
+size_t Lz4FrameEncoder::CompressBlock(const uint8_t* content,
+                                      size_t content_size, size_t index,
+                                      Block* block, uint8_t* out) {
+  const size_t begin = index * kBlockSize;
+  const size_t len =
+      content_size - begin < kBlockSize ? content_size - begin : kBlockSize;
+  const uint8_t* src = content + begin;
+  const size_t compressed =
+      block->lz4.Compress(src, len, out + kBlockHeaderSize);
+  if (compressed < len) {
+    StoreLe32(out, static_cast<uint32_t>(compressed));
+    return kBlockHeaderSize + compressed;
+  }
+  // Incompressible: store the block as-is.
+  StoreLe32(out, static_cast<uint32_t>(len) | kUncompressedBit);
+  std::memcpy(out + kBlockHeaderSize, src, len);
+  return kBlockHeaderSize + len;
+}
+
+size_t Lz4FrameEncoder::Encode(const ImageView& image, uint8_t* out,
+                               size_t capacity) {
+  if (!image.IsValid()) return 0;
+  const size_t max_size = MaxEncodedSize(image.width, image.height);
+  if (capacity < max_size) return 0;
+
+  const size_t content_size = ContentSize(image.width, image.height);
+  const size_t block_count = BlockCount(content_size);
+  const size_t threads = ThreadCount(block_count);
+  ThreadPool* pool = Pool(threads);
+  const size_t block_slots = threads > 1 ? block_count : 1;
+  while (blocks_.size() < block_slots) {
+    blocks_.push_back(std::make_unique<Block>());
+  }
+
+  const uint8_t* content = Pack(image, pool, pool ? threads : 1);
+
+  uint8_t* p = out;
+  WriteFrameHeader(content_size, p);
+  p += kFrameHeaderSize;
+
+  if (!pool) {
+    for (size_t i = 0; i < block_count; ++i) {
+      p += CompressBlock(content, content_size, i, blocks_[0].get(), p);
+    }
+  } else {
+    pool->ParallelFor(block_count, [&](size_t i) {
+      Block* block = blocks_[i].get();
+      block->compressed.resize(kBlockHeaderSize +
+                               Lz4Encoder::CompressBound(kBlockSize));
+      block->compressed_size = CompressBlock(content, content_size, i, block,
+                                             block->compressed.data());
+    });
+    for (size_t i = 0; i < block_count; ++i) {
+      const Block* block = blocks_[i].get();
+      std::memcpy(p, block->compressed.data(), block->compressed_size);
+      p += block->compressed_size;
+    }
+  }
+
+  StoreLe32(p, 0);  // end mark
+  p += kEndMarkSize;
+  return static_cast<size_t>(p - out);
+}
+
+bool Lz4FrameEncoder::Encode(const ImageView& image,
+                             std::vector<uint8_t>* out) {
+  const size_t max_size = MaxEncodedSize(image.width, image.height);
+  if (!image.IsValid() || max_size == 0) return false;
+  out->resize(max_size);
+  const size_t size = Encode(image, out->data(), out->size());
+  out->resize(size);
+  return size != 0;
+}
+
+bool Lz4FrameEncoder::Encode(const ImageView& image, ByteSink* sink) {
+  if (!image.IsValid()) return false;
+  const size_t content_size = ContentSize(image.width, image.height);
+  const size_t block_count = BlockCount(content_size);
+  const size_t threads = ThreadCount(block_count);
+  ThreadPool* pool = Pool(threads);
+  while (blocks_.size() < threads) {
+    blocks_.push_back(std::make_unique<Block>());
+  }
+
+  const uint8_t* content = Pack(image, pool, pool ? threads : 1);
+
+  uint8_t header[kFrameHeaderSize];
+  WriteFrameHeader(content_size, header);
+  if (!sink->Write(header, sizeof(header))) return false;
+
+  // One block per thread at a time, written in order as each round ends.
+  for (size_t first = 0; first < block_count; first += threads) {
+    const size_t round =
+        block_count - first < threads ? block_count - first : threads;
+    auto compress = [&](size_t i) {
+      Block* block = blocks_[i].get();
+      block->compressed.resize(kBlockHeaderSize +
+                               Lz4Encoder::CompressBound(kBlockSize));
+      block->compressed_size = CompressBlock(
+          content, content_size, first + i, block, block->compressed.data());
+    };
+    if (round == 1) {
+      compress(0);
+    } else {
+      pool->ParallelFor(round, compress);
+    }
+    for (size_t i = 0; i < round; ++i) {
+      const Block* block = blocks_[i].get();
+      if (!sink->Write(block->compressed.data(), block->compressed_size)) {
+        return false;
+      }
+    }
+  }
+
+  uint8_t end_mark[kEndMarkSize];
+  StoreLe32(end_mark, 0);
+  return sink->Write(end_mark, sizeof(end_mark));
+}
+
+}  // namespace screenshot
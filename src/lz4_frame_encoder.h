@@ -0,0 +1,92 @@
+#ifndef SCREENSHOT_CORE_LZ4_FRAME_ENCODER_H_
+#define SCREENSHOT_CORE_LZ4_FRAME_ENCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "byte_sink.h"
+#include "image.h"
+#include "lz4.h"
+#include "thread_pool.h"
+
+namespace screenshot {
+
+struct Lz4FrameEncodeOptions {
+  // Write alpha as 0xFF regardless of the source.
+  bool force_opaque = false;
+  // Threads compressing blocks; 0 uses every core. Blocks are independent,
+  // so the output is byte-identical for any thread count.
+  int threads = 1;
+};
+
+// Packs 8-bit BGRA/RGBA pixels as top-down BGRA rows (stride width * 4) and
+// wraps them in a standard LZ4 frame (https://github.com/lz4/lz4, frame
+// format v1.6): independent 1 MiB blocks and the content size in the header,
+// so `lz4 -d` or any LZ4 library can unpack it. Dimensions travel separately.
+//
+// Meant for high-frequency pipelines where CPU time matters more than size.
+// Keeps its scratch buffers and worker threads between calls. Not
+// thread-safe.
+class Lz4FrameEncoder {
+ public:
+  static constexpr size_t kBlockSize = size_t{1} << 20;
+
+  explicit Lz4FrameEncoder(
+      const Lz4FrameEncodeOptions& options = Lz4FrameEncodeOptions());
+
+  const Lz4FrameEncodeOptions& options() const { return options_; }
+  void set_options(const Lz4FrameEncodeOptions& options) {
+    options_ = options;
+  }
+
+  // Size of the buffer Encode() needs for a |width| x |height| image; 0 if
+  // the dimensions are not positive.
+  static size_t MaxEncodedSize(int width, int height);
+
+  // Encodes |image| into |out|, which must hold at least
+  // MaxEncodedSize(image.width, image.height) bytes. Returns the encoded
+  // size, or 0 if the image is invalid or |capacity| is too small.
+  size_t Encode(const ImageView& image, uint8_t* out, size_t capacity);
+
+  // Convenience overload that sizes |out| to fit. Returns false on failure.
+  bool Encode(const ImageView& image, std::vector<uint8_t>* out);
+
+  // Streams the frame to |sink| block by block, holding one compressed block
+  // per thread instead of the whole frame. The output is byte-identical to
+  // the other overloads. Returns false if the image is invalid or |sink|
+  // fails.
+  bool Encode(const ImageView& image, ByteSink* sink);
+
+ private:
+  struct Block {
+    Lz4Encoder lz4;
+    std::vector<uint8_t> compressed;
+    size_t compressed_size = 0;
+  };
+
+  // Threads worth using for |block_count| blocks.
+  size_t ThreadCount(size_t block_count) const;
+
+  // The worker pool for |threads| threads, or null for one.
+  ThreadPool* Pool(size_t threads);
+
+  // Returns |image| as packed BGRA, converting into packed_ (in |bands| row
+  // bands on |pool|, if given) when the source is not already in that layout.
+  const uint8_t* Pack(const ImageView& image, ThreadPool* pool, size_t bands);
+
+  // Writes block |index| of |content| (size and data) to |out|; returns the
+  // bytes written.
+  size_t CompressBlock(const uint8_t* content, size_t content_size,
+                       size_t index, Block* block, uint8_t* out);
+
+  Lz4FrameEncodeOptions options_;
+  std::vector<uint8_t> packed_;
+  std::vector<std::unique_ptr<Block>> blocks_;
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_LZ4_FRAME_ENCODER_H_
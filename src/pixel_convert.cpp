@@ -0,0 +1,172 @@
+#include "pixel_convert.h"
+
+#include <cstring>
+
+#include "cpu_features.h"
+#include "trace.h"
+
+#if SCREENSHOT_ARCH_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <tmmintrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+void SwizzleScalar(const uint8_t* src, uint8_t* dst, size_t pixels,
+                   bool force_opaque) {
+  for (size_t i = 0; i < pixels; ++i) {
+    const uint8_t b = src[0];
+    const uint8_t g = src[1];
+    const uint8_t r = src[2];
+    const uint8_t a = src[3];
+    dst[0] = r;
+    dst[1] = g;
+    dst[2] = b;
+    dst[3] = force_opaque ? 0xFF : a;
+    src += 4;
+    dst += 4;
+  }
+}
+
+#if SCREENSHOT_ARCH_X86
+// SSE2 has no byte shuffle, so move the red/blue bytes with 32-bit shifts.
+size_t SwizzleSse2(const uint8_t* src, uint8_t* dst, size_t pixels,
+                   bool force_opaque) {
+  const __m128i keep = _mm_set1_epi32(
+      force_opaque ? 0x0000FF00 : static_cast<int>(0xFF00FF00u));
+  const __m128i alpha =
+      _mm_set1_epi32(force_opaque ? static_cast<int>(0xFF000000u) : 0);
+  const __m128i low = _mm_set1_epi32(0x000000FF);
+  const __m128i high = _mm_set1_epi32(0x00FF0000);
+  size_t i = 0;
+  for (; i + 4 <= pixels; i += 4) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+    __m128i out = _mm_or_si128(_mm_and_si128(v, keep), alpha);
+    out = _mm_or_si128(out, _mm_and_si128(_mm_srli_epi32(v, 16), low));
+    out = _mm_or_si128(out, _mm_and_si128(_mm_slli_epi32(v, 16), high));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), out);
+  }
+  return i;
+}
+
+SCREENSHOT_TARGET_SSSE3
+size_t SwizzleSsse3(const uint8_t* src, uint8_t* dst, size_t pixels,
+                    bool force_opaque) {
+  const __m128i shuffle =
+      _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  const __m128i alpha =
+      _mm_set1_epi32(force_opaque ? static_cast<int>(0xFF000000u) : 0);
+  size_t i = 0;
+  for (; i + 4 <= pixels; i += 4) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4),
+                     _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+  }
+  return i;
+}
+
+SCREENSHOT_TARGET_AVX2
+size_t SwizzleAvx2(const uint8_t* src, uint8_t* dst, size_t pixels,
+                   bool force_opaque) {
+  const __m256i shuffle = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5,
+      4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  const __m256i alpha =
+      _mm256_set1_epi32(force_opaque ? static_cast<int>(0xFF000000u) : 0);
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4),
+                        _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha));
+  }
+  return i;
+}
+
+size_t SetOpaqueSse2(uint8_t* data, size_t pixels) {
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+  size_t i = 0;
+  for (; i + 4 <= pixels; i += 4) {
+    __m128i* p = reinterpret_cast<__m128i*>(data + i * 4);
+    _mm_storeu_si128(p, _mm_or_si128(_mm_loadu_si128(p), alpha));
+  }
+  return i;
+}
+
+SCREENSHOT_TARGET_AVX2
+size_t SetOpaqueAvx2(uint8_t* data, size_t pixels) {
+  const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    __m256i* p = reinterpret_cast<__m256i*>(data + i * 4);
+    _mm256_storeu_si256(p, _mm256_or_si256(_mm256_loadu_si256(p), alpha));
+  }
+  return i;
+}
+#endif  // SCREENSHOT_ARCH_X86
+
+}  // namespace
+
+void SwizzleRedBlue(const uint8_t* src, uint8_t* dst, size_t pixels,
+                    bool force_opaque) {
+  size_t done = 0;
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& cpu = GetCpuFeatures();
+  if (cpu.avx2) {
+    done = SwizzleAvx2(src, dst, pixels, force_opaque);
+  } else if (cpu.ssse3) {
+    done = SwizzleSsse3(src, dst, pixels, force_opaque);
+  } else if (cpu.sse2) {
+    done = SwizzleSse2(src, dst, pixels, force_opaque);
+  }
+#endif
+  SwizzleScalar(src + done * 4, dst + done * 4, pixels - done, force_opaque);
+}
+
+void SetOpaque(uint8_t* data, size_t pixels) {
+  size_t done = 0;
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& cpu = GetCpuFeatures();
+  if (cpu.avx2) {
+    done = SetOpaqueAvx2(data, pixels);
+  } else if (cpu.sse2) {
+    done = SetOpaqueSse2(data, pixels);
+  }
+#endif
+  for (size_t i = done; i < pixels; ++i) data[i * kBytesPerPixel + 3] = 0xFF;
+}
+
+void ConvertRow(const uint8_t* src, PixelFormat src_format, uint8_t* dst,
+                PixelFormat dst_format, size_t pixels, bool force_opaque) {
+  if (src_format != dst_format) {
+    SwizzleRedBlue(src, dst, pixels, force_opaque);
+    return;
+  }
+  if (src != dst) std::memcpy(dst, src, pixels * kBytesPerPixel);
+  if (force_opaque) SetOpaque(dst, pixels);
+}
+
+bool ConvertImage(const ImageView& src, PixelFormat dst_format,
+                  bool force_opaque, uint8_t* dst, size_t dst_stride) {
+  if (!src.IsValid() || dst == nullptr || dst_stride < src.RowBytes()) {
+    return false;
+  }
+  if (src.format == dst_format && !force_opaque && src.data == dst &&
+      src.stride == dst_stride) {
+    return true;
+  }
+  TraceSpan span("convert");
+  const size_t pixels = static_cast<size_t>(src.width);
+  for (int y = 0; y < src.height; ++y) {
+    ConvertRow(src.Row(y), src.format, dst + static_cast<size_t>(y) * dst_stride,
+               dst_format, pixels, force_opaque);
+  }
+  return true;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,41 @@
+#ifndef SCREENSHOT_CORE_PIXEL_CONVERT_H_
+#define SCREENSHOT_CORE_PIXEL_CONVERT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "image.h"
+
+namespace screenshot {
+
+// Swaps the first and third byte of each of |pixels| 4-byte pixels
+// (BGRA <-> RGBA). |src| and |dst| may be the same buffer but must not
+// otherwise overlap. When |force_opaque| is set the alpha byte is written as
+// 0xFF, which is what GDI screen captures need: their alpha channel is
+// undefined.
+void SwizzleRedBlue(const uint8_t* src, uint8_t* dst, size_t pixels,
+                    bool force_opaque);
+
+// Sets the alpha byte of each of |pixels| 4-byte pixels to 0xFF.
+void SetOpaque(uint8_t* data, size_t pixels);
+
+// Writes |pixels| pixels of |src| (in |src_format|) to |dst| in |dst_format|.
+// |src| and |dst| may be the same buffer.
+void ConvertRow(const uint8_t* src, PixelFormat src_format, uint8_t* dst,
+                PixelFormat dst_format, size_t pixels, bool force_opaque);
+
+// Writes |pixels| pixels of |src| (in |format|) to |dst| as RGBA.
+inline void ConvertRowToRgba(const uint8_t* src, PixelFormat format,
+                             uint8_t* dst, size_t pixels, bool force_opaque) {
+  ConvertRow(src, format, dst, PixelFormat::kRgba8, pixels, force_opaque);
+}
+
+// Converts every row of |src| into |dst|, |dst_stride| bytes apart. The
+// conversion may run in place (dst == src.data with the same stride).
+// Returns false if |src| is invalid or |dst_stride| is too small.
+bool ConvertImage(const ImageView& src, PixelFormat dst_format,
+                  bool force_opaque, uint8_t* dst, size_t dst_stride);
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_PIXEL_CONVERT_H_
@@ -0,0 +1,377 @@
+#include "png_encoder.h"
+
+#include <cstring>
+
+#include "checksum.h"
+#include "pixel_convert.h"
+
+namespace screenshot {
+
+namespace {
+
+constexpr uint8_t kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A,
+                                      '\n'};
+constexpr size_t kChunkOverhead = 12;  // length + type + CRC
+constexpr size_t kIhdrDataSize = 13;
+constexpr size_t kZlibOverhead = 6;  // 2-byte header + Adler-32
+// PNG chunk lengths are limited to 2^31 - 1.
+constexpr size_t kMaxChunkData = 0x7FFFFFFF;
+// Upper bound on the number of row bands (and so threads) per image.
+constexpr size_t kMaxBands = 64;
+// Smallest slice of filtered data worth deflating on its own thread.
+constexpr size_t kMinBandBytes = 256 * 1024;
+
+inline void StoreBe32(uint8_t* p, uint32_t v) {
+  p[0] = static_cast<uint8_t>(v >> 24);
+  p[1] = static_cast<uint8_t>(v >> 16);
+  p[2] = static_cast<uint8_t>(v >> 8);
+  p[3] = static_cast<uint8_t>(v);
+}
+
+// Writes the chunk length and type at |p|; the caller fills in the data.
+inline uint8_t* BeginChunk(uint8_t* p, const char* type, size_t length) {
+  StoreBe32(p, static_cast<uint32_t>(length));
+  std::memcpy(p + 4, type, 4);
+  return p + 8;
+}
+
+// Appends the CRC of the chunk that starts at |chunk| and returns the end.
+inline uint8_t* EndChunk(uint8_t* chunk, size_t length) {
+  const uint32_t crc = Crc32(0, chunk + 4, length + 4);
+  StoreBe32(chunk + 8 + length, crc);
+  return chunk + 8 + length + 4;
+}
+
+// Writes an IDAT chunk holding |prefix|, |data| and |suffix| to |sink|
+// without gathering them in one buffer.
+bool WriteIdat(ByteSink* sink, const uint8_t* prefix, size_t prefix_size,
+               const uint8_t* data, size_t size, const uint8_t* suffix,
+               size_t suffix_size) {
+  uint8_t head[8];
+  BeginChunk(head, "IDAT", prefix_size + size + suffix_size);
+  uint32_t crc = Crc32(0, head + 4, 4);
+  crc = Crc32(crc, prefix, prefix_size);
+  crc = Crc32(crc, data, size);
+  crc = Crc32(crc, suffix, suffix_size);
+  uint8_t tail[4];
+  StoreBe32(tail, crc);
+  return sink->Write(head, sizeof(head)) &&
+         (prefix_size == 0 || sink->Write(prefix, prefix_size)) &&
+         sink->Write(data, size) &&
+         (suffix_size == 0 || sink->Write(suffix, suffix_size)) &&
+         sink->Write(tail, sizeof(tail));
+}
+
+// Writes the signature and IHDR to |out| and returns the end.
+uint8_t* WriteHeader(const ImageView& image, uint8_t* out) {
+  uint8_t* p = out;
+  std::memcpy(p, kPngSignature, sizeof(kPngSignature));
+  p += sizeof(kPngSignature);
+
+  uint8_t* chunk = p;
+  uint8_t* data = BeginChunk(chunk, "IHDR", kIhdrDataSize);
+  StoreBe32(data, static_cast<uint32_t>(image.width));
+  StoreBe32(data + 4, static_cast<uint32_t>(image.height));
+  data[8] = 8;   // bit depth
+  data[9] = 6;   // color type: truecolor with alpha
+  data[10] = 0;  // compression: deflate
+  data[11] = 0;  // filter method: adaptive
+  data[12] = 0;  // interlace: none
+  return EndChunk(chunk, kIhdrDataSize);
+}
+
+size_t FilteredSize(int width, int height) {
+  return static_cast<size_t>(height) *
+         (1 + static_cast<size_t>(width) * kBytesPerPixel);
+}
+
+// zlib FLEVEL hint for the header (informational only).
+uint8_t ZlibFlags(int level) {
+  uint8_t flevel = 2;
+  if (level <= 1) {
+    flevel = 0;
+  } else if (level <= 5) {
+    flevel = 1;
+  } else if (level >= 7) {
+    flevel = 3;
+  }
+  const uint32_t cmf = 0x78;
+  uint32_t flg = static_cast<uint32_t>(flevel) << 6;
+  flg += 31 - ((cmf << 8) + flg) % 31;
+  return static_cast<uint8_t>(flg);
+}
+
+}  // namespace
+
+PngEncoder::PngEncoder(const PngEncodeOptions& options) : options_(options) {}
+
+void PngEncoder::set_options(const PngEncodeOptions& options) {
+  options_ = options;
+}
+
+size_t PngEncoder::MaxEncodedSize(int width, int height) {
+  if (width <= 0 || height <= 0) return 0;
+  const size_t filtered = FilteredSize(width, height);
+  // Each band after the first adds at most one segment's fixed overhead.
+  const size_t idat = kZlibOverhead + DeflateEncoder::CompressBound(filtered) +
+                      kMaxBands * DeflateEncoder::CompressBound(0);
+  if (idat > kMaxChunkData) return 0;
+  return sizeof(kPngSignature) + (kChunkOverhead + kIhdrDataSize) +
+         (kChunkOverhead + idat) + kChunkOverhead;
+}
+
+int PngEncoder::ThreadCount() const {
+  const int threads = ThreadPool::ResolveThreadCount(options_.threads);
+  return threads < static_cast<int>(kMaxBands) ? threads
+                                               : static_cast<int>(kMaxBands);
+}
+
+void PngEncoder::PlanBands(const ImageView& image) {
+  const size_t line = image.RowBytes() + 1;
+  size_t count = static_cast<size_t>(ThreadCount());
+  // Bands much smaller than the deflate window compress noticeably worse and
+  // are not worth a thread hand-off.
+  const size_t max_by_size = FilteredSize(image.width, image.height) /
+                             kMinBandBytes;
+  if (count > max_by_size) count = max_by_size;
+  if (count > static_cast<size_t>(image.height)) {
+    count = static_cast<size_t>(image.height);
+  }
+  if (count == 0) count = 1;
+
+  while (bands_.size() < count) bands_.push_back(std::make_unique<Band>());
+  bands_.resize(count);
+
+  const size_t height = static_cast<size_t>(image.height);
+  for (size_t i = 0; i < count; ++i) {
+    Band* band = bands_[i].get();
+    band->first_row = static_cast<int>(height * i / count);
+    band->end_row = static_cast<int>(height * (i + 1) / count);
+    band->deflate.set_level(options_.level);
+    band->row_scratch.resize(3 * (line - 1));
+  }
+
+  if (count > 1) {
+    const int workers = static_cast<int>(count) - 1;
+    if (!pool_ || pool_->size() != workers) {
+      pool_ = std::make_unique<ThreadPool>(workers);
+    }
+  }
+}
+
+void PngEncoder::FilterBand(const ImageView& image, Band* band) {
+  const size_t row_bytes = image.RowBytes();
+  const size_t line = row_bytes + 1;
+  // [current row | previous row | zero row]
+  uint8_t* scratch = band->row_scratch.data();
+  uint8_t* zero_row = scratch + 2 * row_bytes;
+  std::memset(zero_row, 0, row_bytes);
+
+  // RGBA input that needs no alpha fix-up can be filtered in place.
+  const bool convert =
+      image.format != PixelFormat::kRgba8 || options_.force_opaque;
+  auto rgba_row = [&](int y) {
+    const uint8_t* row = image.Row(y);
+    if (!convert) return row;
+    uint8_t* dst = scratch + static_cast<size_t>(y & 1) * row_bytes;
+    ConvertRowToRgba(row, image.format, dst, static_cast<size_t>(image.width),
+                     options_.force_opaque);
+    return static_cast<const uint8_t*>(dst);
+  };
+
+  // The first row of a band is filtered against the last row of the band
+  // above, exactly as it would be in a single pass.
+  const uint8_t* prior =
+      band->first_row > 0 ? rgba_row(band->first_row - 1) : zero_row;
+  for (int y = band->first_row; y < band->end_row; ++y) {
+    const uint8_t* row = rgba_row(y);
+
+    PngFilter filter;
+    switch (options_.filter) {
+      case PngFilterStrategy::kNone:
+        filter = PngFilter::kNone;
+        break;
+      case PngFilterStrategy::kSub:
+        filter = PngFilter::kSub;
+        break;
+      case PngFilterStrategy::kUp:
+        filter = PngFilter::kUp;
+        break;
+      case PngFilterStrategy::kAverage:
+        filter = PngFilter::kAverage;
+        break;
+      case PngFilterStrategy::kPaeth:
+        filter = PngFilter::kPaeth;
+        break;
+      case PngFilterStrategy::kAdaptive:
+      default:
+        filter = SelectPngFilter(row, prior, row_bytes);
+        break;
+    }
+
+    uint8_t* out = filtered_.data() + static_cast<size_t>(y) * line;
+    out[0] = static_cast<uint8_t>(filter);
+    ApplyPngFilter(filter, row, prior, row_bytes, out + 1);
+    prior = row;
+  }
+}
+
+void PngEncoder::CompressBand(const ImageView& image, Band* band, bool final,
+                              uint8_t* out) {
+  const size_t line = image.RowBytes() + 1;
+  const size_t begin = static_cast<size_t>(band->first_row) * line;
+  const size_t len =
+      static_cast<size_t>(band->end_row - band->first_row) * line;
+  CompressRange(begin, len, final, band, out);
+}
+
+void PngEncoder::CompressRange(size_t begin, size_t len, bool final,
+                               Band* band, uint8_t* out) {
+  const uint8_t* data = filtered_.data() + begin;
+  // The rows above the range are the dictionary, so matches that cross the
+  // boundary are still found (up to the 32 KiB window).
+  band->compressed_size = band->deflate.Compress(data, len, final, out, begin);
+  band->adler = Adler32(1, data, len);
+}
+
+size_t PngEncoder::Encode(const ImageView& image, uint8_t* out,
+                          size_t capacity) {
+  if (!image.IsValid()) return 0;
+  const size_t max_size = MaxEncodedSize(image.width, image.height);
+  if (max_size == 0 || capacity < max_size) return 0;
+
+  filtered_.resize(FilteredSize(image.width, image.height));
+  PlanBands(image);
+  const size_t band_count = bands_.size();
+
+  uint8_t* p = WriteHeader(image, out);
+
+  uint8_t* chunk = p;
+  uint8_t* data = chunk + 8;
+  data[0] = 0x78;
+  data[1] = ZlibFlags(options_.level);
+  uint8_t* stream = data + 2;
+  size_t deflated = 0;
+  uint32_t adler = 1;
+  if (band_count == 1) {
+    Band* band = bands_[0].get();
+    FilterBand(image, band);
+    CompressBand(image, band, true, stream);
+    deflated = band->compressed_size;
+    adler = band->adler;
+  } else {
+    // Every band has to be filtered before any is deflated, since a band's
+    // dictionary is the tail of the band above it.
+    pool_->ParallelFor(band_count, [&](size_t i) {
+      FilterBand(image, bands_[i].get());
+    });
+    const size_t line = image.RowBytes() + 1;
+    pool_->ParallelFor(band_count, [&](size_t i) {
+      Band* band = bands_[i].get();
+      const size_t len =
+          static_cast<size_t>(band->end_row - band->first_row) * line;
+      band->compressed.resize(DeflateEncoder::CompressBound(len));
+      CompressBand(image, band, i + 1 == band_count,
+                   band->compressed.data());
+    });
+    // Non-final bands end with a sync flush, so the segments concatenate
+    // into one valid stream.
+    for (size_t i = 0; i < band_count; ++i) {
+      const Band* band = bands_[i].get();
+      std::memcpy(stream + deflated, band->compressed.data(),
+                  band->compressed_size);
+      deflated += band->compressed_size;
+      const size_t len =
+          static_cast<size_t>(band->end_row - band->first_row) * line;
+      adler = i == 0 ? band->adler : Adler32Combine(adler, band->adler, len);
+    }
+  }
+  StoreBe32(stream + deflated, adler);
+  const size_t idat_length = 2 + deflated + 4;
+  BeginChunk(chunk, "IDAT", idat_length);
+  p = EndChunk(chunk, idat_length);
+
+  chunk = p;
+  BeginChunk(chunk, "IEND", 0);
+  p = EndChunk(chunk, 0);
+
+  return static_cast<size_t>(p - out);
+}
+
+bool PngEncoder::Encode(const ImageView& image, std::vector<uint8_t>* out) {
+  const size_t max_size = MaxEncodedSize(image.width, image.height);
+  if (!image.IsValid() || max_size == 0) return false;
+  out->resize(max_size);
+  const size_t size = Encode(image, out->data(), out->size());
+  out->resize(size);
+  return size != 0;
+}
+
+bool PngEncoder::Encode(const ImageView& image, ByteSink* sink) {
+  if (!image.IsValid() || MaxEncodedSize(image.width, image.height) == 0) {
+    return false;
+  }
+  filtered_.resize(FilteredSize(image.width, image.height));
+  PlanBands(image);
+  const size_t band_count = bands_.size();
+  if (band_count == 1) {
+    FilterBand(image, bands_[0].get());
+  } else {
+    pool_->ParallelFor(band_count, [&](size_t i) {
+      FilterBand(image, bands_[i].get());
+    });
+  }
+
+  uint8_t header[sizeof(kPngSignature) + kChunkOverhead + kIhdrDataSize];
+  WriteHeader(image, header);
+  if (!sink->Write(header, sizeof(header))) return false;
+
+  // Segments are deflated a band's worth of threads at a time and written
+  // in order; each band's encoder and buffer take one segment per round.
+  const size_t total = filtered_.size();
+  const size_t segments = (total + kSinkChunkSize - 1) / kSinkChunkSize;
+  const uint8_t zlib_header[2] = {0x78, ZlibFlags(options_.level)};
+  uint32_t adler = 1;
+  for (size_t first = 0; first < segments; first += band_count) {
+    const size_t round =
+        segments - first < band_count ? segments - first : band_count;
+    auto compress = [&](size_t i) {
+      const size_t begin = (first + i) * kSinkChunkSize;
+      const size_t len =
+          total - begin < kSinkChunkSize ? total - begin : kSinkChunkSize;
+      Band* band = bands_[i].get();
+      band->compressed.resize(DeflateEncoder::CompressBound(len));
+      CompressRange(begin, len, first + i + 1 == segments, band,
+                    band->compressed.data());
+    };
+    if (round == 1) {
+      compress(0);
+    } else {
+      pool_->ParallelFor(round, compress);
+    }
+    for (size_t i = 0; i < round; ++i) {
+      const size_t segment = first + i;
+      const Band* band = bands_[i].get();
+      const size_t len = segment + 1 == segments
+                             ? total - segment * kSinkChunkSize
+                             : kSinkChunkSize;
+      adler = segment == 0 ? band->adler
+                           : Adler32Combine(adler, band->adler, len);
+      const bool last = segment + 1 == segments;
+      uint8_t trailer[4];
+      StoreBe32(trailer, adler);
+      if (!WriteIdat(sink, zlib_header, segment == 0 ? 2 : 0,
+                     band->compressed.data(), band->compressed_size, trailer,
+                     last ? 4 : 0)) {
+        return false;
+      }
+    }
+  }
+
+  uint8_t end[kChunkOverhead];
+  BeginChunk(end, "IEND", 0);
+  EndChunk(end, 0);
+  return sink->Write(end, sizeof(end));
+}
+
+}  // namespace screenshot
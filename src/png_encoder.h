@@ -0,0 +1,116 @@
+#ifndef SCREENSHOT_CORE_PNG_ENCODER_H_
+#define SCREENSHOT_CORE_PNG_ENCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "byte_sink.h"
+#include "deflate.h"
+#include "image.h"
+#include "png_filter.h"
+#include "thread_pool.h"
+
+namespace screenshot {
+
+// How scanline filters are chosen.
+enum class PngFilterStrategy {
+  // Score every filter per row and keep the cheapest (libpng's heuristic).
+  kAdaptive,
+  // Use the same filter for every row.
+  kNone,
+  kSub,
+  kUp,
+  kAverage,
+  kPaeth,
+};
+
+struct PngEncodeOptions {
+  // Speed/ratio knob, passed to DeflateEncoder: 0 stores the filtered rows
+  // uncompressed, 1 is fastest, 9 is smallest.
+  int level = 3;
+  PngFilterStrategy filter = PngFilterStrategy::kAdaptive;
+  // Write alpha as 0xFF regardless of the source; screen captures carry no
+  // meaningful alpha.
+  bool force_opaque = false;
+  // Threads used to filter and deflate; 0 uses every core. With more than
+  // one thread the image is split into row bands that are filtered and
+  // deflated concurrently (like pigz) and spliced into a single IDAT stream.
+  // The decoded image is identical for any thread count.
+  int threads = 1;
+};
+
+// Encodes 8-bit BGRA/RGBA pixels as an 8-bit RGBA, non-interlaced PNG.
+//
+// The encoder keeps its filter and deflate scratch buffers (and its worker
+// threads) between calls, so reusing one instance for frames of the same size
+// allocates nothing after the first frame. Not thread-safe.
+class PngEncoder {
+ public:
+  explicit PngEncoder(const PngEncodeOptions& options = PngEncodeOptions());
+
+  const PngEncodeOptions& options() const { return options_; }
+  void set_options(const PngEncodeOptions& options);
+
+  // Size of the buffer Encode() needs for a |width| x |height| image; 0 if
+  // the image is too large to encode as a single IDAT chunk.
+  static size_t MaxEncodedSize(int width, int height);
+
+  // Encodes |image| into |out|, which must hold at least
+  // MaxEncodedSize(image.width, image.height) bytes. Returns the encoded
+  // size, or 0 if the image is invalid or |capacity| is too small.
+  size_t Encode(const ImageView& image, uint8_t* out, size_t capacity);
+
+  // Convenience overload that sizes |out| to fit. Returns false on failure.
+  bool Encode(const ImageView& image, std::vector<uint8_t>* out);
+
+  // Streams the PNG to |sink| as it is produced: the filtered rows are
+  // deflated in kSinkChunkSize segments (one per thread at a time), each
+  // written out as its own IDAT chunk, so only a few segments of compressed
+  // output are held in memory instead of the whole file. Decodes to the
+  // same pixels as the other overloads. Returns false if the image is
+  // invalid or |sink| fails.
+  bool Encode(const ImageView& image, ByteSink* sink);
+
+ private:
+  // A horizontal slice of the image, filtered and deflated independently.
+  struct Band {
+    int first_row = 0;
+    int end_row = 0;
+    DeflateEncoder deflate;
+    std::vector<uint8_t> row_scratch;
+    std::vector<uint8_t> compressed;
+    size_t compressed_size = 0;
+    uint32_t adler = 1;
+  };
+
+  // Splits |image| into bands_ according to options_.threads.
+  void PlanBands(const ImageView& image);
+
+  // Converts and filters the band's rows into filtered_.
+  void FilterBand(const ImageView& image, Band* band);
+
+  // Deflates the band's slice of filtered_ into |out| (which must hold
+  // CompressBound of the slice) and records its Adler-32.
+  void CompressBand(const ImageView& image, Band* band, bool final,
+                    uint8_t* out);
+
+  // Deflates filtered_[begin, begin + len) into |out| (which must hold
+  // CompressBound(len)), with the data before it as the dictionary, and
+  // records its size and Adler-32 in |band|.
+  void CompressRange(size_t begin, size_t len, bool final, Band* band,
+                     uint8_t* out);
+
+  // Worker count for options_.threads.
+  int ThreadCount() const;
+
+  PngEncodeOptions options_;
+  std::vector<uint8_t> filtered_;
+  std::vector<std::unique_ptr<Band>> bands_;
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_PNG_ENCODER_H_
@@ -0,0 +1,359 @@
+#include "png_filter.h"
+
+#include <cstring>
+
+#include "cpu_features.h"
+
+#if SCREENSHOT_ARCH_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace screenshot {
+
+namespace {
+
+constexpr size_t kBpp = 4;
+
+inline uint8_t PaethPredictor(int a, int b, int c) {
+  const int p = a + b - c;
+  const int pa = p > a ? p - a : a - p;
+  const int pb = p > b ? p - b : b - p;
+  const int pc = p > c ? p - c : c - p;
+  if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+  if (pb <= pc) return static_cast<uint8_t>(b);
+  return static_cast<uint8_t>(c);
+}
+
+inline uint8_t FilterByte(PngFilter filter, const uint8_t* row,
+                          const uint8_t* prior, size_t i) {
+  const int x = row[i];
+  const int a = i >= kBpp ? row[i - kBpp] : 0;
+  const int b = prior[i];
+  const int c = i >= kBpp ? prior[i - kBpp] : 0;
+  switch (filter) {
+    case PngFilter::kNone:
+      return static_cast<uint8_t>(x);
+    case PngFilter::kSub:
+      return static_cast<uint8_t>(x - a);
+    case PngFilter::kUp:
+      return static_cast<uint8_t>(x - b);
+    case PngFilter::kAverage:
+      return static_cast<uint8_t>(x - ((a + b) >> 1));
+    case PngFilter::kPaeth:
+      return static_cast<uint8_t>(x - PaethPredictor(a, b, c));
+  }
+  return static_cast<uint8_t>(x);
+}
+
+// Magnitude of a filtered byte read as a signed value.
+inline uint32_t SignedMagnitude(uint8_t v) {
+  return v < 128 ? v : 256u - v;
+}
+
+void ApplyScalar(PngFilter filter, const uint8_t* row, const uint8_t* prior,
+                 size_t begin, size_t end, uint8_t* out) {
+  for (size_t i = begin; i < end; ++i) {
+    out[i] = FilterByte(filter, row, prior, i);
+  }
+}
+
+void ScoreScalar(const uint8_t* row, const uint8_t* prior, size_t begin,
+                 size_t end, uint64_t scores[kPngFilterCount]) {
+  for (size_t i = begin; i < end; ++i) {
+    for (int f = 0; f < kPngFilterCount; ++f) {
+      scores[f] +=
+          SignedMagnitude(FilterByte(static_cast<PngFilter>(f), row, prior, i));
+    }
+  }
+}
+
+#if SCREENSHOT_ARCH_X86
+// --- SSE2 -----------------------------------------------------------------
+
+inline __m128i Abs16Sse2(__m128i x) {
+  return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+// Paeth predictor on eight 16-bit lanes. With p = a + b - c the distances
+// reduce to |b - c|, |a - c| and |a + b - 2c|.
+inline __m128i Paeth16Sse2(__m128i a, __m128i b, __m128i c) {
+  const __m128i bc = _mm_sub_epi16(b, c);
+  const __m128i ac = _mm_sub_epi16(a, c);
+  const __m128i pa = Abs16Sse2(bc);
+  const __m128i pb = Abs16Sse2(ac);
+  const __m128i pc = Abs16Sse2(_mm_add_epi16(bc, ac));
+  const __m128i not_a =
+      _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+  const __m128i use_c = _mm_cmpgt_epi16(pb, pc);
+  const __m128i b_or_c =
+      _mm_or_si128(_mm_and_si128(use_c, c), _mm_andnot_si128(use_c, b));
+  return _mm_or_si128(_mm_andnot_si128(not_a, a), _mm_and_si128(not_a, b_or_c));
+}
+
+inline __m128i PaethSse2(__m128i a, __m128i b, __m128i c) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lo = Paeth16Sse2(_mm_unpacklo_epi8(a, zero),
+                                 _mm_unpacklo_epi8(b, zero),
+                                 _mm_unpacklo_epi8(c, zero));
+  const __m128i hi = Paeth16Sse2(_mm_unpackhi_epi8(a, zero),
+                                 _mm_unpackhi_epi8(b, zero),
+                                 _mm_unpackhi_epi8(c, zero));
+  return _mm_packus_epi16(lo, hi);
+}
+
+// floor((a + b) / 2); pavgb rounds up, so subtract the carried low bit.
+inline __m128i AverageSse2(__m128i a, __m128i b) {
+  return _mm_sub_epi8(
+      _mm_avg_epu8(a, b),
+      _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+}
+
+inline __m128i SumMagnitudeSse2(__m128i v) {
+  const __m128i zero = _mm_setzero_si128();
+  return _mm_sad_epu8(_mm_min_epu8(v, _mm_sub_epi8(zero, v)), zero);
+}
+
+inline uint64_t HorizontalSumSse2(__m128i v) {
+  alignas(16) uint64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+  return lanes[0] + lanes[1];
+}
+
+size_t ApplySse2(PngFilter filter, const uint8_t* row, const uint8_t* prior,
+                 size_t len, uint8_t* out) {
+  size_t i = kBpp;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i));
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i - kBpp));
+    __m128i r;
+    switch (filter) {
+      case PngFilter::kSub:
+        r = _mm_sub_epi8(x, a);
+        break;
+      case PngFilter::kUp:
+        r = _mm_sub_epi8(x, b);
+        break;
+      case PngFilter::kAverage:
+        r = _mm_sub_epi8(x, AverageSse2(a, b));
+        break;
+      case PngFilter::kPaeth: {
+        const __m128i c =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i - kBpp));
+        r = _mm_sub_epi8(x, PaethSse2(a, b, c));
+        break;
+      }
+      default:
+        r = x;
+        break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r);
+  }
+  return i;
+}
+
+size_t ScoreSse2(const uint8_t* row, const uint8_t* prior, size_t len,
+                 uint64_t scores[kPngFilterCount]) {
+  __m128i sum[kPngFilterCount];
+  for (int f = 0; f < kPngFilterCount; ++f) sum[f] = _mm_setzero_si128();
+  size_t i = kBpp;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i));
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i - kBpp));
+    const __m128i c =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i - kBpp));
+    sum[0] = _mm_add_epi64(sum[0], SumMagnitudeSse2(x));
+    sum[1] = _mm_add_epi64(sum[1], SumMagnitudeSse2(_mm_sub_epi8(x, a)));
+    sum[2] = _mm_add_epi64(sum[2], SumMagnitudeSse2(_mm_sub_epi8(x, b)));
+    sum[3] = _mm_add_epi64(
+        sum[3], SumMagnitudeSse2(_mm_sub_epi8(x, AverageSse2(a, b))));
+    sum[4] = _mm_add_epi64(
+        sum[4], SumMagnitudeSse2(_mm_sub_epi8(x, PaethSse2(a, b, c))));
+  }
+  for (int f = 0; f < kPngFilterCount; ++f) {
+    scores[f] += HorizontalSumSse2(sum[f]);
+  }
+  return i;
+}
+
+// --- AVX2 -----------------------------------------------------------------
+
+SCREENSHOT_TARGET_AVX2
+inline __m256i Abs16Avx2(__m256i x) {
+  return _mm256_abs_epi16(x);
+}
+
+SCREENSHOT_TARGET_AVX2
+inline __m256i Paeth16Avx2(__m256i a, __m256i b, __m256i c) {
+  const __m256i bc = _mm256_sub_epi16(b, c);
+  const __m256i ac = _mm256_sub_epi16(a, c);
+  const __m256i pa = Abs16Avx2(bc);
+  const __m256i pb = Abs16Avx2(ac);
+  const __m256i pc = Abs16Avx2(_mm256_add_epi16(bc, ac));
+  const __m256i not_a =
+      _mm256_or_si256(_mm256_cmpgt_epi16(pa, pb), _mm256_cmpgt_epi16(pa, pc));
+  const __m256i use_c = _mm256_cmpgt_epi16(pb, pc);
+  const __m256i b_or_c = _mm256_blendv_epi8(b, c, use_c);
+  return _mm256_blendv_epi8(a, b_or_c, not_a);
+}
+
+// unpack and packus both work within 128-bit lanes, so the round trip keeps
+// byte order.
+SCREENSHOT_TARGET_AVX2
+inline __m256i PaethAvx2(__m256i a, __m256i b, __m256i c) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i lo = Paeth16Avx2(_mm256_unpacklo_epi8(a, zero),
+                                 _mm256_unpacklo_epi8(b, zero),
+                                 _mm256_unpacklo_epi8(c, zero));
+  const __m256i hi = Paeth16Avx2(_mm256_unpackhi_epi8(a, zero),
+                                 _mm256_unpackhi_epi8(b, zero),
+                                 _mm256_unpackhi_epi8(c, zero));
+  return _mm256_packus_epi16(lo, hi);
+}
+
+SCREENSHOT_TARGET_AVX2
+inline __m256i AverageAvx2(__m256i a, __m256i b) {
+  return _mm256_sub_epi8(
+      _mm256_avg_epu8(a, b),
+      _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_set1_epi8(1)));
+}
+
+SCREENSHOT_TARGET_AVX2
+inline __m256i SumMagnitudeAvx2(__m256i v) {
+  const __m256i zero = _mm256_setzero_si256();
+  return _mm256_sad_epu8(_mm256_abs_epi8(v), zero);
+}
+
+SCREENSHOT_TARGET_AVX2
+inline uint64_t HorizontalSumAvx2(__m256i v) {
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+SCREENSHOT_TARGET_AVX2
+size_t ApplyAvx2(PngFilter filter, const uint8_t* row, const uint8_t* prior,
+                 size_t len, uint8_t* out) {
+  size_t i = kBpp;
+  for (; i + 32 <= len; i += 32) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+    const __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prior + i));
+    const __m256i a =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i - kBpp));
+    __m256i r;
+    switch (filter) {
+      case PngFilter::kSub:
+        r = _mm256_sub_epi8(x, a);
+        break;
+      case PngFilter::kUp:
+        r = _mm256_sub_epi8(x, b);
+        break;
+      case PngFilter::kAverage:
+        r = _mm256_sub_epi8(x, AverageAvx2(a, b));
+        break;
+      case PngFilter::kPaeth: {
+        const __m256i c = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(prior + i - kBpp));
+        r = _mm256_sub_epi8(x, PaethAvx2(a, b, c));
+        break;
+      }
+      default:
+        r = x;
+        break;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+  }
+  return i;
+}
+
+SCREENSHOT_TARGET_AVX2
+size_t ScoreAvx2(const uint8_t* row, const uint8_t* prior, size_t len,
+                 uint64_t scores[kPngFilterCount]) {
+  __m256i sum[kPngFilterCount];
+  for (int f = 0; f < kPngFilterCount; ++f) sum[f] = _mm256_setzero_si256();
+  size_t i = kBpp;
+  for (; i + 32 <= len; i += 32) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+    const __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prior + i));
+    const __m256i a =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i - kBpp));
+    const __m256i c =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prior + i - kBpp));
+    sum[0] = _mm256_add_epi64(sum[0], SumMagnitudeAvx2(x));
+    sum[1] = _mm256_add_epi64(sum[1], SumMagnitudeAvx2(_mm256_sub_epi8(x, a)));
+    sum[2] = _mm256_add_epi64(sum[2], SumMagnitudeAvx2(_mm256_sub_epi8(x, b)));
+    sum[3] = _mm256_add_epi64(
+        sum[3], SumMagnitudeAvx2(_mm256_sub_epi8(x, AverageAvx2(a, b))));
+    sum[4] = _mm256_add_epi64(
+        sum[4], SumMagnitudeAvx2(_mm256_sub_epi8(x, PaethAvx2(a, b, c))));
+  }
+  for (int f = 0; f < kPngFilterCount; ++f) {
+    scores[f] += HorizontalSumAvx2(sum[f]);
+  }
+  return i;
+}
+#endif  // SCREENSHOT_ARCH_X86
+
+}  // namespace
+
+void ApplyPngFilter(PngFilter filter, const uint8_t* row, const uint8_t* prior,
+                    size_t len, uint8_t* out) {
+  if (filter == PngFilter::kNone) {
+    std::memcpy(out, row, len);
+    return;
+  }
+  const size_t head = len < kBpp ? len : kBpp;
+  ApplyScalar(filter, row, prior, 0, head, out);
+  size_t done = head;
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& cpu = GetCpuFeatures();
+  if (cpu.avx2) {
+    done = ApplyAvx2(filter, row, prior, len, out);
+  } else if (cpu.sse2) {
+    done = ApplySse2(filter, row, prior, len, out);
+  }
+  if (done < head) done = head;
+#endif
+  ApplyScalar(filter, row, prior, done, len, out);
+}
+
+void ScorePngFilters(const uint8_t* row, const uint8_t* prior, size_t len,
+                     uint64_t scores[kPngFilterCount]) {
+  for (int f = 0; f < kPngFilterCount; ++f) scores[f] = 0;
+  const size_t head = len < kBpp ? len : kBpp;
+  ScoreScalar(row, prior, 0, head, scores);
+  size_t done = head;
+#if SCREENSHOT_ARCH_X86
+  const CpuFeatures& cpu = GetCpuFeatures();
+  if (cpu.avx2) {
+    done = ScoreAvx2(row, prior, len, scores);
+  } else if (cpu.sse2) {
+    done = ScoreSse2(row, prior, len, scores);
+  }
+  if (done < head) done = head;
+#endif
+  ScoreScalar(row, prior, done, len, scores);
+}
+
+PngFilter SelectPngFilter(const uint8_t* row, const uint8_t* prior,
+                          size_t len) {
+  uint64_t scores[kPngFilterCount];
+  ScorePngFilters(row, prior, len, scores);
+  int best = 0;
+  for (int f = 1; f < kPngFilterCount; ++f) {
+    if (scores[f] < scores[best]) best = f;
+  }
+  return static_cast<PngFilter>(best);
+}
+
+}  // namespace screenshot
@@ -0,0 +1,41 @@
+#ifndef SCREENSHOT_CORE_PNG_FILTER_H_
+#define SCREENSHOT_CORE_PNG_FILTER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace screenshot {
+
+// PNG scanline filter types (PNG spec, section 9.2). Values are the filter
+// byte written at the start of each scanline.
+enum class PngFilter : uint8_t {
+  kNone = 0,
+  kSub = 1,
+  kUp = 2,
+  kAverage = 3,
+  kPaeth = 4,
+};
+
+constexpr int kPngFilterCount = 5;
+
+// The filter kernels work on 4-byte pixels (8-bit RGBA). |row| and |prior|
+// are |len| bytes; |prior| is the unfiltered previous scanline, or all zeros
+// for the first one. Vectorized with SSE2/AVX2 where available.
+
+// Writes |row| filtered with |filter| to |out| (|len| bytes, no filter byte).
+void ApplyPngFilter(PngFilter filter, const uint8_t* row, const uint8_t* prior,
+                    size_t len, uint8_t* out);
+
+// Scores every filter for |row| using the minimum-sum-of-absolute-differences
+// heuristic: each filtered byte counts as its magnitude when read as a signed
+// value. scores[i] belongs to PngFilter(i).
+void ScorePngFilters(const uint8_t* row, const uint8_t* prior, size_t len,
+                     uint64_t scores[kPngFilterCount]);
+
+// Returns the filter with the lowest score, preferring lower filter types on
+// ties.
+PngFilter SelectPngFilter(const uint8_t* row, const uint8_t* prior, size_t len);
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_PNG_FILTER_H_
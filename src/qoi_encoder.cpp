@@ -0,0 +1,213 @@
+#include "qoi_encoder.h"
+
+#include <cstring>
+
+namespace screenshot {
+
+namespace {
+
+constexpr uint8_t kOpIndex = 0x00;  // 00xxxxxx
+constexpr uint8_t kOpDiff = 0x40;   // 01xxxxxx
+constexpr uint8_t kOpLuma = 0x80;   // 10xxxxxx
+constexpr uint8_t kOpRun = 0xC0;    // 11xxxxxx
+constexpr uint8_t kOpRgb = 0xFE;
+constexpr uint8_t kOpRgba = 0xFF;
+constexpr int kMaxRun = 62;
+
+constexpr size_t kHeaderSize = 14;
+constexpr uint8_t kEndMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+// Worst case after the last row: a pending run and the end marker.
+constexpr size_t kTrailerBytes = 1 + sizeof(kEndMarker);
+// The reference decoder refuses images with more pixels than this.
+constexpr uint64_t kMaxPixels = 400000000;
+
+inline void StoreBe32(uint8_t* p, uint32_t v) {
+  p[0] = static_cast<uint8_t>(v >> 24);
+  p[1] = static_cast<uint8_t>(v >> 16);
+  p[2] = static_cast<uint8_t>(v >> 8);
+  p[3] = static_cast<uint8_t>(v);
+}
+
+// Pixels are handled as RGBA packed little-endian into a uint32_t.
+inline uint32_t Channel(uint32_t px, int shift) { return (px >> shift) & 0xFF; }
+
+// Worst case for a row: a run left over from the row above, then a
+// QOI_OP_RGBA (5 bytes) per pixel.
+inline size_t MaxRowBytes(int width) {
+  return 1 + static_cast<size_t>(width) * 5;
+}
+
+inline uint32_t IndexPosition(uint32_t px) {
+  return (Channel(px, 0) * 3 + Channel(px, 8) * 5 + Channel(px, 16) * 7 +
+          Channel(px, 24) * 11) %
+         64;
+}
+
+inline uint8_t* WriteHeader(const ImageView& image, bool force_opaque,
+                            uint8_t* p) {
+  std::memcpy(p, "qoif", 4);
+  StoreBe32(p + 4, static_cast<uint32_t>(image.width));
+  StoreBe32(p + 8, static_cast<uint32_t>(image.height));
+  p[12] = force_opaque ? 3 : 4;  // channels
+  p[13] = 0;                     // sRGB with linear alpha
+  return p + kHeaderSize;
+}
+
+// Encoder state carried from one row to the next.
+struct QoiState {
+  QoiState(const ImageView& image, bool force_opaque)
+      : r_at(image.format == PixelFormat::kBgra8 ? 2 : 0),
+        alpha_mask(force_opaque ? 0xFF000000u : 0) {}
+
+  // Byte offsets of red and blue in the source pixels.
+  const int r_at;
+  const uint32_t alpha_mask;
+  uint32_t index[64] = {};
+  uint32_t prev = 0xFF000000u;  // r = g = b = 0, a = 255
+  int run = 0;
+};
+
+// Encodes one row of |width| pixels at |p|, which must have room for
+// MaxRowBytes(width), and returns the end. A run may be left open for the
+// next row.
+inline uint8_t* EncodeRow(const uint8_t* src, int width, QoiState* state,
+                          uint8_t* p) {
+  const int r_at = state->r_at;
+  const int b_at = 2 - r_at;
+  const uint32_t alpha_mask = state->alpha_mask;
+  uint32_t* index = state->index;
+  uint32_t prev = state->prev;
+  int run = state->run;
+  for (int x = 0; x < width; ++x, src += kBytesPerPixel) {
+    const uint32_t px = (static_cast<uint32_t>(src[r_at]) |
+                         (static_cast<uint32_t>(src[1]) << 8) |
+                         (static_cast<uint32_t>(src[b_at]) << 16) |
+                         (static_cast<uint32_t>(src[3]) << 24)) |
+                        alpha_mask;
+    if (px == prev) {
+      if (++run == kMaxRun) {
+        *p++ = static_cast<uint8_t>(kOpRun | (run - 1));
+        run = 0;
+      }
+      continue;
+    }
+    if (run > 0) {
+      *p++ = static_cast<uint8_t>(kOpRun | (run - 1));
+      run = 0;
+    }
+
+    const uint32_t slot = IndexPosition(px);
+    if (index[slot] == px) {
+      *p++ = static_cast<uint8_t>(kOpIndex | slot);
+    } else {
+      index[slot] = px;
+      if ((px ^ prev) >> 24 == 0) {
+        // Differences wrap around, as the format specifies.
+        const int8_t dr = static_cast<int8_t>(Channel(px, 0) - Channel(prev, 0));
+        const int8_t dg = static_cast<int8_t>(Channel(px, 8) - Channel(prev, 8));
+        const int8_t db =
+            static_cast<int8_t>(Channel(px, 16) - Channel(prev, 16));
+        const int dr_dg = dr - dg;
+        const int db_dg = db - dg;
+        if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 &&
+            db <= 1) {
+          *p++ = static_cast<uint8_t>(kOpDiff | (dr + 2) << 4 |
+                                      (dg + 2) << 2 | (db + 2));
+        } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 &&
+                   db_dg >= -8 && db_dg <= 7) {
+          *p++ = static_cast<uint8_t>(kOpLuma | (dg + 32));
+          *p++ = static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8));
+        } else {
+          p[0] = kOpRgb;
+          p[1] = static_cast<uint8_t>(Channel(px, 0));
+          p[2] = static_cast<uint8_t>(Channel(px, 8));
+          p[3] = static_cast<uint8_t>(Channel(px, 16));
+          p += 4;
+        }
+      } else {
+        p[0] = kOpRgba;
+        p[1] = static_cast<uint8_t>(Channel(px, 0));
+        p[2] = static_cast<uint8_t>(Channel(px, 8));
+        p[3] = static_cast<uint8_t>(Channel(px, 16));
+        p[4] = static_cast<uint8_t>(Channel(px, 24));
+        p += 5;
+      }
+    }
+    prev = px;
+  }
+  state->prev = prev;
+  state->run = run;
+  return p;
+}
+
+// Closes an open run and writes the end marker; needs kTrailerBytes.
+inline uint8_t* FinishStream(QoiState* state, uint8_t* p) {
+  if (state->run > 0) *p++ = static_cast<uint8_t>(kOpRun | (state->run - 1));
+  state->run = 0;
+  std::memcpy(p, kEndMarker, sizeof(kEndMarker));
+  return p + sizeof(kEndMarker);
+}
+
+}  // namespace
+
+QoiEncoder::QoiEncoder(const QoiEncodeOptions& options) : options_(options) {}
+
+size_t QoiEncoder::MaxEncodedSize(int width, int height) {
+  if (width <= 0 || height <= 0) return 0;
+  const uint64_t pixels =
+      static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+  if (pixels > kMaxPixels) return 0;
+  // Worst case is a full QOI_OP_RGBA (5 bytes) per pixel.
+  return kHeaderSize + static_cast<size_t>(pixels) * 5 + sizeof(kEndMarker);
+}
+
+size_t QoiEncoder::Encode(const ImageView& image, uint8_t* out,
+                          size_t capacity) {
+  if (!image.IsValid()) return 0;
+  const size_t max_size = MaxEncodedSize(image.width, image.height);
+  if (max_size == 0 || capacity < max_size) return 0;
+
+  uint8_t* p = WriteHeader(image, options_.force_opaque, out);
+  QoiState state(image, options_.force_opaque);
+  for (int y = 0; y < image.height; ++y) {
+    p = EncodeRow(image.Row(y), image.width, &state, p);
+  }
+  p = FinishStream(&state, p);
+  return static_cast<size_t>(p - out);
+}
+
+bool QoiEncoder::Encode(const ImageView& image, std::vector<uint8_t>* out) {
+  const size_t max_size = MaxEncodedSize(image.width, image.height);
+  if (!image.IsValid() || max_size == 0) return false;
+  out->resize(max_size);
+  const size_t size = Encode(image, out->data(), out->size());
+  out->resize(size);
+  return size != 0;
+}
+
+bool QoiEncoder::Encode(const ImageView& image, ByteSink* sink) {
+  if (!image.IsValid() || MaxEncodedSize(image.width, image.height) == 0) {
+    return false;
+  }
+  const size_t row_bound = MaxRowBytes(image.width);
+  const size_t capacity =
+      kHeaderSize + (kSinkChunkSize > row_bound ? kSinkChunkSize : row_bound) +
+      kTrailerBytes;
+  if (chunk_.size() < capacity) chunk_.resize(capacity);
+
+  uint8_t* const begin = chunk_.data();
+  uint8_t* const limit = begin + capacity - kTrailerBytes;
+  uint8_t* p = WriteHeader(image, options_.force_opaque, begin);
+  QoiState state(image, options_.force_opaque);
+  for (int y = 0; y < image.height; ++y) {
+    if (static_cast<size_t>(limit - p) < row_bound) {
+      if (!sink->Write(begin, static_cast<size_t>(p - begin))) return false;
+      p = begin;
+    }
+    p = EncodeRow(image.Row(y), image.width, &state, p);
+  }
+  p = FinishStream(&state, p);
+  return sink->Write(begin, static_cast<size_t>(p - begin));
+}
+
+}  // namespace screenshot
@@ -0,0 +1,54 @@
+#ifndef SCREENSHOT_CORE_QOI_ENCODER_H_
+#define SCREENSHOT_CORE_QOI_ENCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "byte_sink.h"
+#include "image.h"
+
+namespace screenshot {
+
+struct QoiEncodeOptions {
+  // Write alpha as 0xFF regardless of the source (and mark the image as
+  // 3-channel in the header).
+  bool force_opaque = false;
+};
+
+// Encodes 8-bit BGRA/RGBA pixels as QOI ("Quite OK Image", qoiformat.org
+// v1.0): a single pass, lossless, typically several times faster than PNG at
+// a somewhat lower ratio on screen content. Stateless apart from its options
+// and the chunk buffer used for streaming. Not thread-safe.
+class QoiEncoder {
+ public:
+  explicit QoiEncoder(const QoiEncodeOptions& options = QoiEncodeOptions());
+
+  const QoiEncodeOptions& options() const { return options_; }
+  void set_options(const QoiEncodeOptions& options) { options_ = options; }
+
+  // Size of the buffer Encode() needs for a |width| x |height| image; 0 if
+  // the image is too large for the format.
+  static size_t MaxEncodedSize(int width, int height);
+
+  // Encodes |image| into |out|, which must hold at least
+  // MaxEncodedSize(image.width, image.height) bytes. Returns the encoded
+  // size, or 0 if the image is invalid or |capacity| is too small.
+  size_t Encode(const ImageView& image, uint8_t* out, size_t capacity);
+
+  // Convenience overload that sizes |out| to fit. Returns false on failure.
+  bool Encode(const ImageView& image, std::vector<uint8_t>* out);
+
+  // Streams the encoding to |sink| in pieces of about kSinkChunkSize instead
+  // of sizing a buffer for the worst case. Returns false if the image is
+  // invalid or |sink| fails.
+  bool Encode(const ImageView& image, ByteSink* sink);
+
+ private:
+  QoiEncodeOptions options_;
+  std::vector<uint8_t> chunk_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_QOI_ENCODER_H_
@@ -0,0 +1,160 @@
+#include "selection_geometry.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace screenshot {
+namespace {
+
+// Distinct x (or y) edges of SelectionDamage(): the outer and inner edges of
+// both selections, plus the bounds.
+constexpr int kMaxEdges = 10;
+
+// |rect| grown by |amount| on every side (shrunk if negative); empty if
+// nothing is left.
+PixelRect Inflate(const PixelRect& rect, int amount) {
+  const PixelRect grown{rect.x - amount, rect.y - amount,
+                        rect.width + 2 * amount, rect.height + 2 * amount};
+  return grown.IsEmpty() ? PixelRect() : grown;
+}
+
+// The selection including the outside of its border.
+PixelRect SelectionOuter(const PixelRect& selection,
+                         const SelectionStyle& style) {
+  if (selection.IsEmpty()) return PixelRect();
+  return Inflate(selection, style.border_outside);
+}
+
+bool Contains(const PixelRect& rect, int x, int y) {
+  return x >= rect.x && x < rect.right() && y >= rect.y && y < rect.bottom();
+}
+
+// Adds the vertical and horizontal edges of |rect|, if it has any pixels.
+void AddEdges(const PixelRect& rect, int* xs, int* x_count, int* ys,
+              int* y_count) {
+  if (rect.IsEmpty()) return;
+  xs[(*x_count)++] = rect.x;
+  xs[(*x_count)++] = rect.right();
+  ys[(*y_count)++] = rect.y;
+  ys[(*y_count)++] = rect.bottom();
+}
+
+// Clamps |edges| to [lo, hi], sorts them and drops duplicates. Returns the
+// number left. There are at most kMaxEdges, so an insertion sort will do.
+int NormalizeEdges(int* edges, int count, int lo, int hi) {
+  int unique = 0;
+  for (int i = 0; i < count; ++i) {
+    const int edge = std::min(std::max(edges[i], lo), hi);
+    int j = unique;
+    while (j > 0 && edges[j - 1] > edge) --j;
+    if (j > 0 && edges[j - 1] == edge) continue;
+    for (int k = unique; k > j; --k) edges[k] = edges[k - 1];
+    edges[j] = edge;
+    ++unique;
+  }
+  return unique;
+}
+
+}  // namespace
+
+SelectionLayer SelectionLayerAt(const PixelRect& selection,
+                                const SelectionStyle& style, int x, int y) {
+  if (!Contains(SelectionOuter(selection, style), x, y)) {
+    return SelectionLayer::kBackground;
+  }
+  return Contains(SelectionInterior(selection, style), x, y)
+             ? SelectionLayer::kInterior
+             : SelectionLayer::kBorder;
+}
+
+PixelRect SelectionInterior(const PixelRect& selection,
+                            const SelectionStyle& style) {
+  if (selection.IsEmpty()) return PixelRect();
+  return Inflate(selection, -style.border_inside);
+}
+
+int SelectionBorder(const PixelRect& selection, const SelectionStyle& style,
+                    PixelRect strips[4]) {
+  const PixelRect outer = SelectionOuter(selection, style);
+  if (outer.IsEmpty()) return 0;
+  const PixelRect inner = SelectionInterior(selection, style);
+  if (inner.IsEmpty()) {
+    strips[0] = outer;
+    return 1;
+  }
+  const PixelRect candidates[4] = {
+      {outer.x, outer.y, outer.width, inner.y - outer.y},
+      {outer.x, inner.bottom(), outer.width, outer.bottom() - inner.bottom()},
+      {outer.x, inner.y, inner.x - outer.x, inner.height},
+      {inner.right(), inner.y, outer.right() - inner.right(), inner.height},
+  };
+  int count = 0;
+  for (const PixelRect& strip : candidates) {
+    if (!strip.IsEmpty()) strips[count++] = strip;
+  }
+  return count;
+}
+
+void SelectionDamage(const PixelRect& before, const PixelRect& after,
+                     const SelectionStyle& style, const PixelRect& bounds,
+                     std::vector<PixelRect>* damage) {
+  damage->clear();
+  if (bounds.IsEmpty()) return;
+
+  // Every edge of both drawings splits bounds into a grid of cells, each
+  // drawn with a single layer before and after. Changed cells are joined
+  // into runs along each band of rows, and a band whose runs match the band
+  // above extends its rectangles instead of starting new ones.
+  int xs[kMaxEdges];
+  int ys[kMaxEdges];
+  int x_count = 0;
+  int y_count = 0;
+  AddEdges(bounds, xs, &x_count, ys, &y_count);
+  for (const PixelRect* selection : {&before, &after}) {
+    AddEdges(SelectionOuter(*selection, style), xs, &x_count, ys, &y_count);
+    AddEdges(SelectionInterior(*selection, style), xs, &x_count, ys,
+             &y_count);
+  }
+  x_count = NormalizeEdges(xs, x_count, bounds.x, bounds.right());
+  y_count = NormalizeEdges(ys, y_count, bounds.y, bounds.bottom());
+
+  size_t previous_first = 0;
+  int previous_count = 0;
+  for (int j = 0; j + 1 < y_count; ++j) {
+    const int y = ys[j];
+    const int band_height = ys[j + 1] - y;
+    PixelRect runs[kMaxEdges];
+    int run_count = 0;
+    for (int i = 0; i + 1 < x_count; ++i) {
+      const int x = xs[i];
+      if (SelectionLayerAt(before, style, x, y) ==
+          SelectionLayerAt(after, style, x, y)) {
+        continue;
+      }
+      if (run_count > 0 && runs[run_count - 1].right() == x) {
+        runs[run_count - 1].width += xs[i + 1] - x;
+      } else {
+        runs[run_count++] = PixelRect{x, y, xs[i + 1] - x, band_height};
+      }
+    }
+
+    bool extends = run_count > 0 && run_count == previous_count;
+    for (int k = 0; extends && k < run_count; ++k) {
+      const PixelRect& above =
+          (*damage)[previous_first + static_cast<size_t>(k)];
+      extends = above.x == runs[k].x && above.width == runs[k].width;
+    }
+    if (extends) {
+      for (int k = 0; k < run_count; ++k) {
+        (*damage)[previous_first + static_cast<size_t>(k)].height +=
+            band_height;
+      }
+    } else {
+      previous_first = damage->size();
+      previous_count = run_count;
+      damage->insert(damage->end(), runs, runs + run_count);
+    }
+  }
+}
+
+}  // namespace screenshot
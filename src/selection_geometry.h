@@ -0,0 +1,54 @@
+#ifndef SCREENSHOT_CORE_SELECTION_GEOMETRY_H_
+#define SCREENSHOT_CORE_SELECTION_GEOMETRY_H_
+
+#include <vector>
+
+#include "image_rect.h"
+
+namespace screenshot {
+
+// How a region selection is drawn: the selected rectangle is filled, with a
+// border centred on its edge, over a background covering everything else.
+struct SelectionStyle {
+  // Border pixels outside and inside the selected rectangle.
+  int border_outside = 1;
+  int border_inside = 1;
+};
+
+// What a pixel of the selection overlay shows.
+enum class SelectionLayer {
+  kBackground,
+  kInterior,
+  kBorder,
+};
+
+// The layer drawn at (|x|, |y|) for |selection|. An empty selection draws
+// nothing but background.
+SelectionLayer SelectionLayerAt(const PixelRect& selection,
+                                const SelectionStyle& style, int x, int y);
+
+// The interior fill of |selection|: the selection without its border.
+// Empty when the border covers all of it, or for an empty selection.
+PixelRect SelectionInterior(const PixelRect& selection,
+                            const SelectionStyle& style);
+
+// Writes the border of |selection| to |strips| as up to four disjoint
+// rectangles (top, bottom, left, right) and returns how many.
+int SelectionBorder(const PixelRect& selection, const SelectionStyle& style,
+                    PixelRect strips[4]);
+
+// Replaces |damage| with the parts of |bounds| that look different once the
+// selection changes from |before| to |after|: the strips exposed or covered
+// by the move, and the old and new borders where they do not coincide.
+//
+// The rectangles are disjoint and cover exactly the changed pixels, so
+// repainting just them is enough, and nothing is repainted that did not
+// change. Dragging one corner typically yields a handful of thin strips.
+// Does not allocate once |damage| has grown to fit.
+void SelectionDamage(const PixelRect& before, const PixelRect& after,
+                     const SelectionStyle& style, const PixelRect& bounds,
+                     std::vector<PixelRect>* damage);
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_SELECTION_GEOMETRY_H_
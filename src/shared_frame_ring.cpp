@@ -0,0 +1,211 @@
+#include "shared_frame_ring.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(__linux__)
+#include <atomic>
+#include <string>
+#endif
+#endif
+
+#include "pixel_convert.h"
+
+namespace screenshot {
+
+namespace {
+
+size_t RoundUp(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+#if !defined(_WIN32)
+// A file descriptor for |size| bytes of anonymous shared memory, or -1.
+int CreateSharedMemoryFd(size_t size) {
+#if defined(__linux__)
+  const int fd = memfd_create("screenshot-frames", MFD_CLOEXEC);
+#else
+  // Named only for the moment it takes to open it.
+  static std::atomic<unsigned> counter{0};
+  const std::string name = "/screenshot-frames-" +
+                           std::to_string(getpid()) + "-" +
+                           std::to_string(counter.fetch_add(1));
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd >= 0) shm_unlink(name.c_str());
+#endif
+  if (fd < 0) return -1;
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+#endif
+
+}  // namespace
+
+std::unique_ptr<SharedMemoryRegion> SharedMemoryRegion::Create(size_t size) {
+  if (size == 0) return nullptr;
+  std::unique_ptr<SharedMemoryRegion> region(new SharedMemoryRegion());
+#if defined(_WIN32)
+  const uint64_t size64 = size;
+  HANDLE mapping = CreateFileMappingW(
+      INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+      static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), nullptr);
+  if (mapping == nullptr) return nullptr;
+  void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+  if (data == nullptr) {
+    CloseHandle(mapping);
+    return nullptr;
+  }
+  region->handle_ = reinterpret_cast<intptr_t>(mapping);
+#else
+  const int fd = CreateSharedMemoryFd(size);
+  if (fd < 0) return nullptr;
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return nullptr;
+  }
+  region->handle_ = fd;
+#endif
+  region->data_ = static_cast<uint8_t*>(data);
+  region->size_ = size;
+  return region;
+}
+
+SharedMemoryRegion::~SharedMemoryRegion() {
+#if defined(_WIN32)
+  UnmapViewOfFile(data_);
+  CloseHandle(reinterpret_cast<HANDLE>(handle_));
+#else
+  munmap(data_, size_);
+  close(static_cast<int>(handle_));
+#endif
+}
+
+SharedFrameRing::SharedFrameRing(const SharedFrameRingOptions& options)
+    : options_(options) {
+  if (options_.slots == 0) options_.slots = 1;
+}
+
+SharedFrameRing::~SharedFrameRing() = default;
+
+SharedFrameStatus SharedFrameRing::Acquire(size_t size,
+                                           SharedFrameSlot* slot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (regions_.empty() || regions_.back()->slot_size < size) {
+    constexpr size_t kAlignment = SharedMemoryRegion::kMapAlignment;
+    if (size > SIZE_MAX - kAlignment ||
+        RoundUp(size, kAlignment) > SIZE_MAX / options_.slots) {
+      return SharedFrameStatus::kMapFailed;
+    }
+    const size_t slot_size = RoundUp(size == 0 ? 1 : size, kAlignment);
+    auto region = std::make_unique<Region>();
+    region->memory = SharedMemoryRegion::Create(slot_size * options_.slots);
+    if (!region->memory) return SharedFrameStatus::kMapFailed;
+    region->slot_size = slot_size;
+    region->leases.assign(options_.slots, 0);
+    // Regions nobody reads from any more can go now.
+    for (size_t i = regions_.size(); i-- > 0;) {
+      if (regions_[i]->leased == 0) {
+        regions_.erase(regions_.begin() + static_cast<std::ptrdiff_t>(i));
+      }
+    }
+    regions_.push_back(std::move(region));
+  }
+  Region& region = *regions_.back();
+  for (size_t i = 0; i < region.leases.size(); ++i) {
+    if (region.leases[i] != 0) continue;
+    region.leases[i] = next_generation_++;
+    ++region.leased;
+    slot->offset = i * region.slot_size;
+    slot->data = region.memory->data() + slot->offset;
+    slot->handle = region.memory->handle();
+    slot->capacity = region.slot_size;
+    slot->generation = region.leases[i];
+    return SharedFrameStatus::kOk;
+  }
+  return SharedFrameStatus::kNoFreeSlot;
+}
+
+bool SharedFrameRing::Release(uint64_t generation) {
+  if (generation == 0) return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t r = 0; r < regions_.size(); ++r) {
+    Region& region = *regions_[r];
+    for (uint64_t& lease : region.leases) {
+      if (lease != generation) continue;
+      lease = 0;
+      --region.leased;
+      // A retired region goes with its last lease.
+      if (region.leased == 0 && r + 1 != regions_.size()) {
+        regions_.erase(regions_.begin() + static_cast<std::ptrdiff_t>(r));
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t SharedFrameRing::leased() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t leased = 0;
+  for (const auto& region : regions_) leased += region->leased;
+  return leased;
+}
+
+size_t SharedFrameRing::regions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return regions_.size();
+}
+
+SharedFrameStatus EncodeSharedFrame(EncoderSession* session,
+                                    const ImageView& image,
+                                    const EncodeSettings& settings,
+                                    SharedFrameRing* ring,
+                                    SharedFrameSlot* slot, size_t* length,
+                                    size_t* stride) {
+  *length = 0;
+  *stride = 0;
+  if (!image.IsValid()) return SharedFrameStatus::kEncodeFailed;
+
+  if (settings.format == CaptureFormat::kRawBgra ||
+      settings.format == CaptureFormat::kRawRgba) {
+    const PixelFormat format = settings.format == CaptureFormat::kRawRgba
+                                   ? PixelFormat::kRgba8
+                                   : PixelFormat::kBgra8;
+    const size_t row_bytes = image.RowBytes();
+    const size_t size = row_bytes * static_cast<size_t>(image.height);
+    const SharedFrameStatus status = ring->Acquire(size, slot);
+    if (status != SharedFrameStatus::kOk) return status;
+    if (!ConvertImage(image, format, true, slot->data, row_bytes)) {
+      ring->Release(slot->generation);
+      return SharedFrameStatus::kEncodeFailed;
+    }
+    *length = size;
+    *stride = row_bytes;
+    return SharedFrameStatus::kOk;
+  }
+
+  if (!session->Encode(image, settings)) {
+    return SharedFrameStatus::kEncodeFailed;
+  }
+  const SharedFrameStatus status = ring->Acquire(session->size(), slot);
+  if (status != SharedFrameStatus::kOk) return status;
+  std::memcpy(slot->data, session->data(), session->size());
+  *length = session->size();
+  *stride = session->stride();
+  return SharedFrameStatus::kOk;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,141 @@
+#ifndef SCREENSHOT_CORE_SHARED_FRAME_RING_H_
+#define SCREENSHOT_CORE_SHARED_FRAME_RING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "encoder_session.h"
+#include "image.h"
+
+namespace screenshot {
+
+// Anonymous shared memory that can be mapped again through its handle: a
+// memfd on Linux, a POSIX shared memory object on other Unix systems and a
+// pagefile-backed file mapping on Windows.
+class SharedMemoryRegion {
+ public:
+  // Offsets that are multiples of this can be mapped on their own on every
+  // platform (it is the Windows allocation granularity).
+  static constexpr size_t kMapAlignment = 64 * 1024;
+
+  // Creates a zero-filled region of |size| bytes, mapped read-write. Returns
+  // null on failure.
+  static std::unique_ptr<SharedMemoryRegion> Create(size_t size);
+
+  ~SharedMemoryRegion();
+
+  SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+  SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+  uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // The file descriptor (POSIX) or HANDLE (Windows) to map the region with.
+  // Valid in this process until the region is destroyed; mappings made
+  // from it stay valid after that.
+  intptr_t handle() const { return handle_; }
+
+ private:
+  SharedMemoryRegion() = default;
+
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  intptr_t handle_ = -1;
+};
+
+enum class SharedFrameStatus {
+  kOk,
+  kEncodeFailed,
+  // Every slot is leased; releasing one makes room.
+  kNoFreeSlot,
+  // The shared memory for a new region could not be created or mapped.
+  kMapFailed,
+};
+
+struct SharedFrameRingOptions {
+  // Frames that can be leased at once.
+  size_t slots = 3;
+};
+
+// A leased slot of a SharedFrameRing.
+struct SharedFrameSlot {
+  uint8_t* data = nullptr;
+  // Where the slot is: the region's handle and the slot's offset in it, a
+  // multiple of SharedMemoryRegion::kMapAlignment.
+  intptr_t handle = -1;
+  size_t offset = 0;
+  size_t capacity = 0;
+  // Identifies this lease; never reused.
+  uint64_t generation = 0;
+};
+
+// Fixed slots in shared memory that frames are written into and leased to
+// a reader in another runtime (Dart, through FFI), which maps them by
+// handle and offset instead of receiving a copy.
+//
+// A slot stays leased until Release() is called with its generation, so
+// the reader decides when it can be overwritten; nothing is copied or
+// recycled behind its back. Slots are as large as the biggest frame
+// requested so far, rounded up to kMapAlignment. A frame that does not fit
+// moves the ring to a new, larger region; the old one is kept until its
+// last lease is released.
+//
+// Thread-safe.
+class SharedFrameRing {
+ public:
+  explicit SharedFrameRing(
+      const SharedFrameRingOptions& options = SharedFrameRingOptions());
+  ~SharedFrameRing();
+
+  SharedFrameRing(const SharedFrameRing&) = delete;
+  SharedFrameRing& operator=(const SharedFrameRing&) = delete;
+
+  // Leases a slot of at least |size| bytes. Returns kNoFreeSlot if every
+  // slot is leased and kMapFailed if a region large enough cannot be
+  // created; |slot| is set only on kOk.
+  SharedFrameStatus Acquire(size_t size, SharedFrameSlot* slot);
+
+  // Ends the lease of |generation|. Returns false if there is no such lease
+  // (it was released already, or never existed).
+  bool Release(uint64_t generation);
+
+  // Slots currently leased.
+  size_t leased() const;
+
+  // Regions alive, including ones kept only for outstanding leases.
+  size_t regions() const;
+
+ private:
+  struct Region {
+    std::unique_ptr<SharedMemoryRegion> memory;
+    size_t slot_size = 0;
+    // Generation leasing each slot, 0 when free.
+    std::vector<uint64_t> leases;
+    size_t leased = 0;
+  };
+
+  SharedFrameRingOptions options_;
+  mutable std::mutex mutex_;
+  // back() is the region new leases come from.
+  std::vector<std::unique_ptr<Region>> regions_;
+  uint64_t next_generation_ = 1;
+};
+
+// Writes a captured frame into a slot leased from |ring|: raw formats are
+// converted straight into the slot, the others are encoded with |session|
+// and copied in once. |length| receives the bytes written and |stride| the
+// row size of raw (or LZ4-framed) pixels, 0 for image formats. The slot is
+// leased only when kOk is returned.
+SharedFrameStatus EncodeSharedFrame(EncoderSession* session,
+                                    const ImageView& image,
+                                    const EncodeSettings& settings,
+                                    SharedFrameRing* ring,
+                                    SharedFrameSlot* slot, size_t* length,
+                                    size_t* stride);
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_SHARED_FRAME_RING_H_
@@ -0,0 +1,616 @@
+#include "synthetic_screen.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "capture_stats.h"
+#include "image.h"
+#include "trace.h"
+
+namespace screenshot {
+
+namespace {
+
+// Distinct lines of text the scrolling document is made of.
+constexpr int kDocumentLines = 32;
+
+// Glyphs are kGlyphWidth x kGlyphHeight bitmaps drawn at unit scale, one
+// per kAdvance columns, on lines kLineHeight rows apart.
+constexpr int kGlyphCount = 64;
+constexpr int kGlyphWidth = 6;
+constexpr int kGlyphHeight = 9;
+constexpr int kAdvance = 7;
+constexpr int kLineHeight = 16;
+
+// Frames the media player's progress bar takes to fill.
+constexpr uint64_t kProgressPeriod = 600;
+
+// Colors, 0xRRGGBB.
+constexpr uint32_t kAccent = 0x2B579A;
+constexpr uint32_t kInactiveTitle = 0xE6E6E6;
+constexpr uint32_t kWindowBorder = 0x6E6E6E;
+constexpr uint32_t kMenuBar = 0xF3F3F3;
+constexpr uint32_t kToolbar = 0xEAEAEA;
+constexpr uint32_t kPaper = 0xFFFFFF;
+constexpr uint32_t kGutter = 0xF0F0F0;
+constexpr uint32_t kCurrentLine = 0xDDEBFF;
+constexpr uint32_t kInk = 0x1E1E1E;
+constexpr uint32_t kComment = 0x008000;
+constexpr uint32_t kTaskbar = 0x1F1F1F;
+constexpr uint32_t kPlayerControls = 0x181818;
+constexpr uint32_t kProgress = 0xE81123;
+constexpr uint32_t kProgressTrack = 0x5A5A5A;
+// Default text, keywords, strings and function names.
+constexpr uint32_t kSyntaxColors[] = {0x1E1E1E, 0x0000FF, 0xA31515, 0x795E26};
+constexpr uint32_t kIconColors[] = {0xF2C811, 0x107C10, 0xD83B01, 0x0078D4,
+                                    0x5C2D91, 0x008272, 0xE3008C, 0x767676};
+
+// The classic arrow: 'X' outline, '.' fill. The hotspot is the top left.
+constexpr int kCursorWidth = 12;
+constexpr int kCursorHeight = 19;
+constexpr const char* kCursorShape[kCursorHeight] = {
+    "X           ", "XX          ", "X.X         ", "X..X        ",
+    "X...X       ", "X....X      ", "X.....X     ", "X......X    ",
+    "X.......X   ", "X........X  ", "X.........X ", "X......XXXXX",
+    "X...X..X    ", "X..XX..X    ", "X.X  X..X   ", "XX   X..X   ",
+    "X     X..X  ", "      X..X  ", "       XX   ",
+};
+
+// A well-mixed 32-bit hash (lowbias32).
+uint32_t Hash(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352Du;
+  x ^= x >> 15;
+  x *= 0x846CA68Bu;
+  x ^= x >> 16;
+  return x;
+}
+
+uint32_t Hash(uint32_t a, uint32_t b) {
+  return Hash(a ^ Hash(b + 0x9E3779B9u));
+}
+
+uint32_t Hash(uint32_t a, uint32_t b, uint32_t c) {
+  return Hash(Hash(a, b), c);
+}
+
+// A triangle wave: t rises from 0 to |span| and falls back, repeatedly.
+int64_t Triangle(uint64_t t, int64_t span) {
+  if (span <= 0) return 0;
+  const int64_t phase =
+      static_cast<int64_t>(t % static_cast<uint64_t>(2 * span));
+  return phase <= span ? phase : 2 * span - phase;
+}
+
+// A triangle wave from 0 up to 255 and back down, every 512.
+int TriangleByte(uint32_t t) {
+  t &= 511;
+  return static_cast<int>(t < 256 ? t : 511 - t);
+}
+
+uint8_t ClampByte(int value) {
+  return static_cast<uint8_t>(std::min(255, std::max(0, value)));
+}
+
+void PutPixel(uint8_t* p, uint32_t rgb) {
+  p[0] = static_cast<uint8_t>(rgb);
+  p[1] = static_cast<uint8_t>(rgb >> 8);
+  p[2] = static_cast<uint8_t>(rgb >> 16);
+  p[3] = 0xFF;
+}
+
+uint32_t Rgb(int r, int g, int b) {
+  return static_cast<uint32_t>(ClampByte(r)) << 16 |
+         static_cast<uint32_t>(ClampByte(g)) << 8 | ClampByte(b);
+}
+
+// Smooth noise in [0, 255]: random values on a lattice |cell| pixels
+// apart, interpolated bilinearly.
+int ValueNoise(uint32_t seed, int x, int y, int cell) {
+  const int gx = x / cell;
+  const int gy = y / cell;
+  const int fx = x % cell;
+  const int fy = y % cell;
+  auto corner = [&](int cx, int cy) {
+    return static_cast<int>(Hash(seed, static_cast<uint32_t>(cx),
+                                 static_cast<uint32_t>(cy)) &
+                            0xFF);
+  };
+  const int top = corner(gx, gy) * (cell - fx) + corner(gx + 1, gy) * fx;
+  const int bottom =
+      corner(gx, gy + 1) * (cell - fx) + corner(gx + 1, gy + 1) * fx;
+  return (top * (cell - fy) + bottom * fy) / (cell * cell);
+}
+
+// Where the cursor is after |changes| changes: it wanders the middle of
+// the screen.
+PixelRect CursorAt(uint64_t changes, int width, int height, int unit) {
+  const uint64_t step = static_cast<uint64_t>(unit);
+  const int x = width / 8 + static_cast<int>(Triangle(changes * 7 * step,
+                                                      width * 3 / 4));
+  const int y = height / 8 + static_cast<int>(Triangle(changes * 5 * step,
+                                                       height * 3 / 4));
+  return PixelRect{x, y, kCursorWidth * unit, kCursorHeight * unit};
+}
+
+PixelRect NonNegative(PixelRect rect) {
+  rect.width = std::max(0, rect.width);
+  rect.height = std::max(0, rect.height);
+  return rect;
+}
+
+// The glyph shapes: rows of kGlyphWidth-bit masks, letter-like in that
+// each has a stem, a few bars, and an x-height, ascender or descender.
+using Glyph = std::array<uint8_t, kGlyphHeight>;
+
+std::array<Glyph, kGlyphCount> MakeGlyphs(uint32_t seed) {
+  std::array<Glyph, kGlyphCount> glyphs = {};
+  for (int g = 0; g < kGlyphCount; ++g) {
+    const uint32_t h = Hash(seed, 0x61797068u, static_cast<uint32_t>(g));
+    const int stem = static_cast<int>(h % 5);
+    const int top = (h >> 3) & 1 ? 0 : 3;
+    const int bottom = (h >> 4) % 5 == 0 ? kGlyphHeight : 7;
+    const int middle = (top + bottom) / 2;
+    Glyph& glyph = glyphs[static_cast<size_t>(g)];
+    for (int row = top; row < bottom; ++row) {
+      uint32_t mask = 1u << stem;
+      const uint32_t bits = Hash(h, static_cast<uint32_t>(row));
+      if (row == top || row == middle || row == bottom - 1) {
+        // A bar between two columns.
+        const int a = static_cast<int>(bits % 5);
+        const int b = static_cast<int>((bits >> 8) % 5);
+        for (int c = std::min(a, b); c <= std::max(a, b); ++c) mask |= 1u << c;
+      } else if ((h >> 7) & 1) {
+        // A second stem.
+        mask |= 1u << (4 - stem);
+      }
+      glyph[static_cast<size_t>(row)] = static_cast<uint8_t>(mask);
+    }
+  }
+  return glyphs;
+}
+
+// Packed BGRA pixels being drawn into; every drawing call clips.
+class Canvas {
+ public:
+  Canvas(uint8_t* data, int width, int height, int unit,
+         const std::array<Glyph, kGlyphCount>* glyphs)
+      : data_(data),
+        width_(width),
+        height_(height),
+        unit_(unit),
+        glyphs_(glyphs) {}
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  uint8_t* At(int x, int y) {
+    return data_ + (static_cast<size_t>(y) * static_cast<size_t>(width_) +
+                    static_cast<size_t>(x)) *
+                       kBytesPerPixel;
+  }
+
+  void Fill(const PixelRect& rect, uint32_t rgb) {
+    const PixelRect area =
+        IntersectRects(rect, PixelRect{0, 0, width_, height_});
+    for (int y = area.y; y < area.bottom(); ++y) {
+      uint8_t* p = At(area.x, y);
+      for (int x = 0; x < area.width; ++x, p += kBytesPerPixel) {
+        PutPixel(p, rgb);
+      }
+    }
+  }
+
+  void Character(int x, int y, int index, uint32_t rgb) {
+    const auto& glyph = (*glyphs_)[static_cast<size_t>(index % kGlyphCount)];
+    for (int row = 0; row < kGlyphHeight; ++row) {
+      const uint8_t mask = glyph[static_cast<size_t>(row)];
+      for (int col = 0; col < kGlyphWidth; ++col) {
+        if (mask & (1u << col)) {
+          Fill(PixelRect{x + col * unit_, y + row * unit_, unit_, unit_}, rgb);
+        }
+      }
+    }
+  }
+
+  // Words of 2-9 glyphs from |seed|, one color each from |colors|, starting
+  // at (|x|, |y|) and stopping before |right| or after |max_words|.
+  // Returns where the text ends.
+  int Words(int x, int y, int right, uint32_t seed, int max_words,
+            const uint32_t* colors, size_t color_count) {
+    const int advance = kAdvance * unit_;
+    for (int w = 0; w < max_words; ++w) {
+      const uint32_t h = Hash(seed, static_cast<uint32_t>(w));
+      const int length = 2 + static_cast<int>(h % 8);
+      if (x + length * advance > right) break;
+      const uint32_t rgb = colors[(h >> 8) % color_count];
+      for (int i = 0; i < length; ++i) {
+        Character(x, y,
+                  static_cast<int>(Hash(h, static_cast<uint32_t>(i)) %
+                                   kGlyphCount),
+                  rgb);
+        x += advance;
+      }
+      x += advance;
+    }
+    return x;
+  }
+
+  // Text centered vertically in a bar |height| rows tall at |y|.
+  int Label(int x, int y, int height, int right, uint32_t seed, int words,
+            uint32_t rgb) {
+    return Words(x, y + (height - kGlyphHeight * unit_) / 2, right, seed,
+                 words, &rgb, 1);
+  }
+
+ private:
+  uint8_t* data_;
+  int width_;
+  int height_;
+  int unit_;
+  const std::array<Glyph, kGlyphCount>* glyphs_;
+};
+
+}  // namespace
+
+SyntheticScreen::SyntheticScreen(const SyntheticScreenOptions& options)
+    : options_(options) {
+  options_.width = std::max(1, options_.width);
+  options_.height = std::max(1, options_.height);
+  // Also maps NaN to 0.
+  if (!(options_.change_rate > 0.0)) options_.change_rate = 0.0;
+  options_.change_rate = std::min(1.0, options_.change_rate);
+  options_.scroll_step = std::max(0, options_.scroll_step);
+  unit_ = std::max(1, std::min(options_.width / 1920, options_.height / 1080));
+  DrawDesktop();
+}
+
+PixelRect SyntheticScreen::Bounds() {
+  return PixelRect{0, 0, options_.width, options_.height};
+}
+
+uint64_t SyntheticScreen::ChangesAt(uint64_t frame) const {
+  return static_cast<uint64_t>(
+      std::floor(static_cast<double>(frame) * options_.change_rate));
+}
+
+PixelRect SyntheticScreen::CursorRect(uint64_t frame) const {
+  return CursorAt(ChangesAt(frame), options_.width, options_.height, unit_);
+}
+
+bool SyntheticScreen::Capture(const PixelRect& rect, bool include_cursor,
+                              uint8_t* pixels, size_t stride) {
+  if (rect.IsEmpty() || rect.x < 0 || rect.y < 0 ||
+      rect.right() > options_.width || rect.bottom() > options_.height) {
+    return false;
+  }
+  const uint64_t changes = ChangesAt(frame_);
+  const size_t base_stride =
+      static_cast<size_t>(options_.width) * kBytesPerPixel;
+  for (int y = rect.y; y < rect.bottom(); ++y) {
+    uint8_t* out = pixels + static_cast<size_t>(y - rect.y) * stride;
+    std::memcpy(out,
+                base_.data() + static_cast<size_t>(y) * base_stride +
+                    static_cast<size_t>(rect.x) * kBytesPerPixel,
+                static_cast<size_t>(rect.width) * kBytesPerPixel);
+    for (const PixelRect* area : {&scroll_area_, &animation_area_}) {
+      if (y < area->y || y >= area->bottom()) continue;
+      const int x0 = std::max(rect.x, area->x);
+      const int x1 = std::min(rect.right(), area->right());
+      if (x0 >= x1) continue;
+      uint8_t* span = out + static_cast<size_t>(x0 - rect.x) * kBytesPerPixel;
+      if (area == &scroll_area_) {
+        DrawScrollRow(y, x0, x1, changes, span);
+      } else {
+        DrawAnimationRow(y, x0, x1, changes, span);
+      }
+    }
+  }
+  cursor_nanos_ = -1;
+  if (include_cursor) {
+    const int64_t start = MonotonicNanos();
+    DrawCursor(rect, changes, pixels, stride);
+    cursor_nanos_ = MonotonicNanos() - start;
+  }
+  ++frame_;
+  return true;
+}
+
+void SyntheticScreen::DrawDesktop() {
+  const int width = options_.width;
+  const int height = options_.height;
+  const int u = unit_;
+  const uint32_t seed = options_.seed;
+  const std::array<Glyph, kGlyphCount> glyphs = MakeGlyphs(seed);
+  base_.assign(static_cast<size_t>(width) * static_cast<size_t>(height) *
+                   kBytesPerPixel,
+               0);
+  Canvas canvas(base_.data(), width, height, u, &glyphs);
+
+  // Wallpaper: a diagonal gradient.
+  const int diagonal = std::max(1, width + height);
+  for (int y = 0; y < height; ++y) {
+    uint8_t* p = canvas.At(0, y);
+    for (int x = 0; x < width; ++x, p += kBytesPerPixel) {
+      const int t = (x + y) * 256 / diagonal;
+      PutPixel(p,
+               Rgb(20 + t * 70 / 256, 60 + t * 90 / 256, 110 + t * 90 / 256));
+    }
+  }
+
+  // Taskbar: start button, pinned icons and a clock.
+  const int taskbar_height = std::min(40 * u, height / 8);
+  const int desk_height = height - taskbar_height;
+  const PixelRect taskbar{0, desk_height, width, taskbar_height};
+  canvas.Fill(taskbar, kTaskbar);
+  const int icon = std::min(24 * u, taskbar_height * 3 / 5);
+  const int icon_top = taskbar.y + (taskbar_height - icon) / 2;
+  canvas.Fill(PixelRect{8 * u, icon_top, icon, icon}, kAccent);
+  for (int i = 0; i < 8; ++i) {
+    canvas.Fill(PixelRect{(56 + 40 * i) * u, icon_top, icon, icon},
+                kIconColors[i]);
+  }
+  canvas.Label(width - 90 * u, taskbar.y, taskbar_height, width, seed + 1, 2,
+               0xFFFFFF);
+
+  // Windows: a title bar with caption buttons, inside a 1-pixel border.
+  const int title_height = 30 * u;
+  auto draw_window = [&](const PixelRect& frame, bool active,
+                         uint32_t title_seed) {
+    canvas.Fill(frame, kWindowBorder);
+    const PixelRect title = NonNegative(
+        {frame.x + 1, frame.y + 1, frame.width - 2,
+         std::min(title_height, frame.height - 2)});
+    canvas.Fill(title, active ? kAccent : kInactiveTitle);
+    const uint32_t text = active ? 0xFFFFFF : kInk;
+    canvas.Label(title.x + 10 * u, title.y, title.height,
+                 title.right() - 150 * u, title_seed, 4, text);
+    for (int i = 0; i < 3; ++i) {
+      const PixelRect button{title.right() - (i + 1) * 46 * u, title.y,
+                             46 * u, title.height};
+      if (i == 0 && active) canvas.Fill(button, 0xC42B1C);
+      canvas.Fill(PixelRect{button.x + 18 * u, button.y + title.height / 2,
+                            10 * u, u},
+                  text);
+    }
+    return NonNegative({frame.x + 1, title.bottom(), frame.width - 2,
+                        frame.bottom() - 1 - title.bottom()});
+  };
+
+  const int margin = std::max(1, std::min(width, height) / 40);
+  const PixelRect editor_frame = NonNegative(
+      {margin, margin, width * 11 / 20 - margin, desk_height - 2 * margin});
+  const PixelRect photo_frame =
+      NonNegative({editor_frame.right() + margin, margin,
+                   width - editor_frame.right() - 2 * margin,
+                   desk_height * 9 / 20 - margin});
+  const PixelRect player_frame =
+      NonNegative({photo_frame.x, photo_frame.bottom() + margin,
+                   photo_frame.width,
+                   desk_height - photo_frame.bottom() - 2 * margin});
+
+  // Editor: menu bar, toolbar, the text (scroll_area_) and a status bar.
+  PixelRect client = draw_window(editor_frame, true, seed + 2);
+  const int menu_height = std::min(22 * u, client.height / 4);
+  const PixelRect menu{client.x, client.y, client.width, menu_height};
+  canvas.Fill(menu, kMenuBar);
+  int x = menu.x + 8 * u;
+  for (int i = 0; i < 6; ++i) {
+    x = canvas.Label(x, menu.y, menu.height, menu.right(),
+                     seed + 10 + static_cast<uint32_t>(i), 1, kInk) +
+        8 * u;
+  }
+  const int toolbar_height = std::min(32 * u, client.height / 4);
+  const PixelRect toolbar{client.x, menu.bottom(), client.width,
+                          toolbar_height};
+  canvas.Fill(toolbar, kToolbar);
+  const int tool = std::min(20 * u, toolbar_height * 3 / 4);
+  for (int i = 0; i * 28 * u + tool < toolbar.width && i < 16; ++i) {
+    canvas.Fill(PixelRect{toolbar.x + (6 + 28 * i) * u,
+                          toolbar.y + (toolbar_height - tool) / 2, tool, tool},
+                kIconColors[Hash(seed, static_cast<uint32_t>(i)) % 8]);
+  }
+  const int status_height = std::min(22 * u, client.height / 4);
+  const PixelRect status{client.x, client.bottom() - status_height,
+                         client.width, status_height};
+  canvas.Fill(status, kAccent);
+  canvas.Label(status.x + 8 * u, status.y, status.height, status.right(),
+               seed + 3, 6, 0xFFFFFF);
+  scroll_area_ = NonNegative({client.x, toolbar.bottom(), client.width,
+                              status.y - toolbar.bottom()});
+
+  // Photo viewer: a landscape with sky, clouds, hills and sensor grain.
+  client = draw_window(photo_frame, false, seed + 4);
+  const int cloud_cell = 48 * u;
+  const int detail_cell = 12 * u;
+  for (int y = client.y; y < client.bottom(); ++y) {
+    const int py = y - client.y;
+    uint8_t* p = canvas.At(client.x, y);
+    for (int px = 0; px < client.width; ++px, p += kBytesPerPixel) {
+      const int horizon =
+          client.height * 2 / 5 +
+          (ValueNoise(seed + 5, px, 0, 64 * u) - 128) * client.height / 1280;
+      const int coarse = ValueNoise(seed + 6, px, py, cloud_cell);
+      const int fine = ValueNoise(seed + 7, px, py, detail_cell);
+      const int grain =
+          static_cast<int>(Hash(seed + 8, static_cast<uint32_t>(px),
+                                static_cast<uint32_t>(py)) &
+                           15) -
+          8;
+      int r = 0;
+      int g = 0;
+      int b = 0;
+      if (py < horizon) {
+        // Sky brightening toward the horizon, with clouds.
+        const int t = horizon > 0 ? py * 255 / horizon : 0;
+        const int cloud = std::max(0, coarse - 150) * 2;
+        r = 70 + t * 90 / 255 + cloud;
+        g = 120 + t * 80 / 255 + cloud;
+        b = 200 + t * 40 / 255 + cloud;
+      } else {
+        // Fields and trees.
+        r = 40 + coarse / 4 + fine / 6;
+        g = 90 + coarse / 3 + fine / 5;
+        b = 30 + fine / 8;
+      }
+      PutPixel(p, Rgb(r + grain, g + grain, b + grain));
+    }
+  }
+
+  // Media player: the picture and controls are animation_area_, drawn
+  // per frame.
+  animation_area_ = draw_window(player_frame, false, seed + 9);
+
+  // The document's lines: a gutter, then indented, syntax-colored code,
+  // with blank lines, comments and the occasional highlighted line.
+  line_height_ = kLineHeight * u;
+  const int line_width = scroll_area_.width;
+  const int gutter = std::min(48 * u, line_width / 4);
+  const int text_top = (line_height_ - kGlyphHeight * u) / 2;
+  lines_.assign(kDocumentLines, std::vector<uint8_t>());
+  for (int i = 0; i < kDocumentLines; ++i) {
+    std::vector<uint8_t>& line = lines_[static_cast<size_t>(i)];
+    line.assign(static_cast<size_t>(line_width) *
+                    static_cast<size_t>(line_height_) * kBytesPerPixel,
+                0);
+    if (line_width == 0) continue;
+    Canvas text(line.data(), line_width, line_height_, u, &glyphs);
+    const uint32_t h = Hash(seed, 0x656E696Cu, static_cast<uint32_t>(i));
+    text.Fill(PixelRect{0, 0, line_width, line_height_},
+              h % 11 == 0 ? kCurrentLine : kPaper);
+    text.Fill(PixelRect{0, 0, gutter, line_height_}, kGutter);
+    // A line number.
+    const uint32_t gray = 0x858585;
+    text.Words(gutter - 4 * kAdvance * u, text_top, gutter, Hash(h), 1, &gray,
+               1);
+    if (h % 7 == 0) continue;
+    const int indent = static_cast<int>((h >> 4) % 4) * 4 * kAdvance * u;
+    const int right = gutter + 8 * u + indent +
+                      static_cast<int>((h >> 8) % 100 + 20) *
+                          (line_width - gutter) / 140;
+    const bool comment = h % 9 == 0;
+    text.Words(gutter + 8 * u + indent, text_top,
+               std::min(right, line_width - 4 * u), h, 24,
+               comment ? &kComment : kSyntaxColors,
+               comment ? 1 : sizeof(kSyntaxColors) / sizeof(kSyntaxColors[0]));
+  }
+}
+
+void SyntheticScreen::DrawScrollRow(int y, int x0, int x1, uint64_t changes,
+                                    uint8_t* out) const {
+  const uint64_t document_y = static_cast<uint64_t>(y - scroll_area_.y) +
+                              changes *
+                                  static_cast<uint64_t>(options_.scroll_step);
+  const uint64_t line_number =
+      document_y / static_cast<uint64_t>(line_height_);
+  const int row = static_cast<int>(document_y %
+                                   static_cast<uint64_t>(line_height_));
+  const std::vector<uint8_t>& line =
+      lines_[Hash(options_.seed, static_cast<uint32_t>(line_number),
+                  static_cast<uint32_t>(line_number >> 32)) %
+             kDocumentLines];
+  const size_t offset =
+      (static_cast<size_t>(row) * static_cast<size_t>(scroll_area_.width) +
+       static_cast<size_t>(x0 - scroll_area_.x)) *
+      kBytesPerPixel;
+  std::memcpy(out, line.data() + offset,
+              static_cast<size_t>(x1 - x0) * kBytesPerPixel);
+}
+
+void SyntheticScreen::DrawAnimationRow(int y, int x0, int x1,
+                                       uint64_t changes, uint8_t* out) const {
+  const PixelRect& area = animation_area_;
+  const int u = unit_;
+  const int controls_height = std::min(28 * u, area.height / 4);
+  const int picture_height = area.height - controls_height;
+  const int ay = y - area.y;
+
+  if (ay >= picture_height) {
+    // Controls: a progress bar filling up over kProgressPeriod changes.
+    const int track_left = area.x + 8 * u;
+    const int track_right = area.right() - 8 * u;
+    const int filled =
+        track_left + static_cast<int>(
+                         static_cast<int64_t>(track_right - track_left) *
+                         static_cast<int64_t>(changes % kProgressPeriod) /
+                         static_cast<int64_t>(kProgressPeriod));
+    const int band = ay - picture_height - controls_height / 2;
+    const bool on_track = band >= -u && band < u;
+    for (int x = x0; x < x1; ++x, out += kBytesPerPixel) {
+      uint32_t rgb = kPlayerControls;
+      if (on_track && x >= track_left && x < track_right) {
+        rgb = x < filled ? kProgress : kProgressTrack;
+      }
+      PutPixel(out, rgb);
+    }
+    return;
+  }
+
+  // The picture: drifting color waves with a bouncing ball in front.
+  const int width = std::max(1, area.width);
+  const int height = std::max(1, picture_height);
+  const uint32_t shift = static_cast<uint32_t>(changes);
+  const int green = TriangleByte(
+      static_cast<uint32_t>(ay * 512 / height) + shift * 3);
+  const int radius = std::max(1, std::min(width, height) / 8);
+  const int ball_x =
+      area.x + radius +
+      static_cast<int>(Triangle(changes * 5 * static_cast<uint64_t>(u),
+                                width - 2 * radius));
+  const int ball_y =
+      radius + static_cast<int>(Triangle(changes * 3 * static_cast<uint64_t>(u),
+                                         height - 2 * radius));
+  int ball_left = 0;
+  int ball_right = 0;
+  const int dy = ay - ball_y;
+  if (dy > -radius && dy < radius) {
+    // sqrt() of an exact integer is correctly rounded everywhere.
+    const int dx = static_cast<int>(
+        std::sqrt(static_cast<double>(radius * radius - dy * dy)));
+    ball_left = ball_x - dx;
+    ball_right = ball_x + dx;
+  }
+  // Red runs twice across the width, blue once along the diagonal; both
+  // stepped in 16.16 fixed point.
+  const uint32_t red_step = (512u << 16) / static_cast<uint32_t>(width);
+  const uint32_t blue_step =
+      (256u << 16) / static_cast<uint32_t>(width + height);
+  const uint32_t ax0 = static_cast<uint32_t>(x0 - area.x);
+  uint32_t red = ax0 * red_step + ((shift * 4) << 16);
+  uint32_t blue = (ax0 + static_cast<uint32_t>(ay)) * blue_step +
+                  ((shift * 2) << 16);
+  for (int x = x0; x < x1; ++x, out += kBytesPerPixel) {
+    if (x >= ball_left && x < ball_right) {
+      PutPixel(out, 0xF0F0F0);
+    } else {
+      out[0] = static_cast<uint8_t>(64 + TriangleByte(blue >> 16) / 2);
+      out[1] = static_cast<uint8_t>(green);
+      out[2] = static_cast<uint8_t>(TriangleByte(red >> 16));
+      out[3] = 0xFF;
+    }
+    red += red_step;
+    blue += blue_step;
+  }
+}
+
+void SyntheticScreen::DrawCursor(const PixelRect& rect, uint64_t changes,
+                                 uint8_t* pixels, size_t stride) const {
+  TraceSpan span("cursor");
+  const PixelRect cursor =
+      CursorAt(changes, options_.width, options_.height, unit_);
+  const PixelRect area = IntersectRects(cursor, rect);
+  for (int py = area.y; py < area.bottom(); ++py) {
+    const char* shape = kCursorShape[(py - cursor.y) / unit_];
+    uint8_t* out = pixels + static_cast<size_t>(py - rect.y) * stride;
+    for (int px = area.x; px < area.right(); ++px) {
+      const char c = shape[(px - cursor.x) / unit_];
+      if (c == ' ') continue;
+      PutPixel(out + static_cast<size_t>(px - rect.x) * kBytesPerPixel,
+               c == 'X' ? 0x000000 : 0xFFFFFF);
+    }
+  }
+}
+
+}  // namespace screenshot
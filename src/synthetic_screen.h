@@ -0,0 +1,113 @@
+#ifndef SCREENSHOT_CORE_SYNTHETIC_SCREEN_H_
+#define SCREENSHOT_CORE_SYNTHETIC_SCREEN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "capture_source.h"
+#include "image_rect.h"
+
+namespace screenshot {
+
+struct SyntheticScreenOptions {
+  int width = 1920;
+  int height = 1080;
+  // Fraction of frames on which the screen changes: 0 keeps it static, 1
+  // changes it on every frame, 0.25 on every fourth.
+  double change_rate = 1.0;
+  // Rows the text document scrolls by per change.
+  int scroll_step = 3;
+  // Seeds the generated content.
+  uint32_t seed = 1;
+};
+
+// A generated desktop to capture from in tests and benchmarks: frames look
+// like a real screen to the encoders and the frame differ, but are the
+// same on every machine and every run.
+//
+// The desktop has a gradient wallpaper, a taskbar, and three windows with
+// title bars, menus and toolbars: an editor whose syntax-colored text
+// scrolls, a photo viewer, and a media player whose picture and progress
+// bar animate. Everything else stays put, so how much of each frame
+// changes is known. Each Capture() shows the next frame; frames are a pure
+// function of the options and the frame number, and content is generated
+// with integer arithmetic only, so it does not depend on the platform's
+// math library.
+//
+// The static parts are drawn once, at construction; a capture copies rows
+// of them and draws only the moving parts, so it costs about as much as
+// copying the frame, like reading the screen does. Use from one thread at
+// a time.
+class SyntheticScreen : public CaptureSource {
+ public:
+  explicit SyntheticScreen(
+      const SyntheticScreenOptions& options = SyntheticScreenOptions());
+
+  SyntheticScreen(const SyntheticScreen&) = delete;
+  SyntheticScreen& operator=(const SyntheticScreen&) = delete;
+
+  // The whole screen, at the origin.
+  PixelRect Bounds() override;
+
+  // Draws |rect| of the current frame, then moves on to the next frame.
+  // Returns false if |rect| is empty or not inside Bounds().
+  bool Capture(const PixelRect& rect, bool include_cursor, uint8_t* pixels,
+               size_t stride) override;
+
+  int64_t cursor_nanos() const override { return cursor_nanos_; }
+
+  // The frame the next Capture() shows, counting from 0.
+  uint64_t frame() const { return frame_; }
+  void set_frame(uint64_t frame) { frame_ = frame; }
+
+  // Changes shown up to and including |frame|; frames with the same count
+  // are identical.
+  uint64_t ChangesAt(uint64_t frame) const;
+
+  // Where frames differ from each other, apart from the cursor: the
+  // scrolling text and the animated picture.
+  const PixelRect& scroll_area() const { return scroll_area_; }
+  const PixelRect& animation_area() const { return animation_area_; }
+
+  // The cursor's bounding box in |frame|.
+  PixelRect CursorRect(uint64_t frame) const;
+
+  const SyntheticScreenOptions& options() const { return options_; }
+
+ private:
+  // Draws the wallpaper, taskbar and windows into base_, and the document
+  // lines.
+  void DrawDesktop();
+
+  // Row |y| of the scrolled document after |changes| changes, clipped to
+  // [x0, x1) of the screen, into |out|.
+  void DrawScrollRow(int y, int x0, int x1, uint64_t changes,
+                     uint8_t* out) const;
+
+  // Row |y| of the media player's picture after |changes| changes.
+  void DrawAnimationRow(int y, int x0, int x1, uint64_t changes,
+                        uint8_t* out) const;
+
+  void DrawCursor(const PixelRect& rect, uint64_t changes, uint8_t* pixels,
+                  size_t stride) const;
+
+  SyntheticScreenOptions options_;
+  // Scale of chrome, text and cursor: 1 up to 1440p, 2 at 4K, 4 at 8K.
+  int unit_ = 1;
+  // Static content, packed BGRA.
+  std::vector<uint8_t> base_;
+  PixelRect scroll_area_;
+  PixelRect animation_area_;
+  // Pre-drawn lines of text, scroll_area_.width x line_height_ packed BGRA
+  // each; the document is an endless sequence of them picked by hashing
+  // the line number.
+  int line_height_ = 0;
+  std::vector<std::vector<uint8_t>> lines_;
+  uint64_t frame_ = 0;
+  int64_t cursor_nanos_ = -1;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_SYNTHETIC_SCREEN_H_
@@ -0,0 +1,17 @@
+#ifndef SCREENSHOT_CORE_TEST_ALLOCATION_COUNTER_H_
+#define SCREENSHOT_CORE_TEST_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace screenshot {
+namespace test {
+
+// Heap allocations (calls to any global operator new) made by any thread of
+// the test binary so far. allocation_counter.cpp replaces the global
+// operators to count them.
+uint64_t AllocationCount();
+
+}  // namespace test
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_TEST_ALLOCATION_COUNTER_H_
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "batch_encoder.h"
+#include "encoder_session.h"
+#include "image.h"
+#include "image_rect.h"
+#include "image_resizer.h"
+#include "test/png_test_decoder.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+constexpr int kWidth = 320;
+constexpr int kHeight = 200;
+
+class BatchEncoderTest : public ::testing::Test {
+ protected:
+  BatchEncoderTest()
+      : pixels_(TestPattern(kWidth, kHeight, kStride, 42)) {
+    frame_.data = pixels_.data();
+    frame_.width = kWidth;
+    frame_.height = kHeight;
+    frame_.stride = kStride;
+  }
+
+  static BatchCrop Crop(int x, int y, int width, int height,
+                        CaptureFormat format = CaptureFormat::kRawBgra) {
+    BatchCrop crop;
+    crop.rect = PixelRect{x, y, width, height};
+    crop.settings.format = format;
+    return crop;
+  }
+
+  // The crop's pixels, packed and opaque, as raw_bgra returns them.
+  std::vector<uint8_t> Expected(const PixelRect& rect) const {
+    std::vector<uint8_t> out;
+    for (int y = rect.y; y < rect.bottom(); ++y) {
+      const uint8_t* row = frame_.Row(y) +
+                           static_cast<size_t>(rect.x) * kBytesPerPixel;
+      for (int x = 0; x < rect.width; ++x) {
+        out.insert(out.end(), {row[0], row[1], row[2], 0xFF});
+        row += kBytesPerPixel;
+      }
+    }
+    return out;
+  }
+
+  // Row padding, so views into the frame are not packed.
+  static constexpr size_t kStride = kWidth * kBytesPerPixel + 64;
+
+  std::vector<uint8_t> pixels_;
+  ImageView frame_;
+};
+
+TEST_F(BatchEncoderTest, EncodesEveryCropInRequestOrder) {
+  std::vector<BatchCrop> crops;
+  for (int i = 0; i < 20; ++i) {
+    crops.push_back(Crop(i * 13, i * 7, 10 + i * 3, 5 + i));
+  }
+  for (const int threads : {1, 3, 0}) {
+    BatchEncoderOptions options;
+    options.threads = threads;
+    BatchEncoder encoder(options);
+    std::vector<BatchOutput> outputs;
+    ASSERT_TRUE(encoder.Encode(frame_, crops, &outputs));
+    ASSERT_EQ(crops.size(), outputs.size());
+    for (size_t i = 0; i < crops.size(); ++i) {
+      const BatchOutput& output = outputs[i];
+      EXPECT_EQ(crops[i].rect, output.rect);
+      EXPECT_EQ(crops[i].rect.width, output.width);
+      EXPECT_EQ(crops[i].rect.height, output.height);
+      EXPECT_EQ(static_cast<size_t>(output.width) * kBytesPerPixel,
+                output.stride);
+      EXPECT_EQ(Expected(crops[i].rect), output.bytes)
+          << "crop " << i << ", " << threads << " threads";
+    }
+  }
+}
+
+TEST_F(BatchEncoderTest, EachCropHasItsOwnFormatAndScale) {
+  std::vector<BatchCrop> crops = {Crop(0, 0, 64, 48, CaptureFormat::kPng),
+                                  Crop(100, 50, 120, 80),
+                                  Crop(10, 120, 40, 40, CaptureFormat::kQoi)};
+  crops[1].limits.scale = 0.5;
+  BatchEncoder encoder;
+  std::vector<BatchOutput> outputs;
+  ASSERT_TRUE(encoder.Encode(frame_, crops, &outputs));
+  ASSERT_EQ(3u, outputs.size());
+
+  DecodedPng png;
+  ASSERT_TRUE(DecodePng(outputs[0].bytes, &png));
+  EXPECT_EQ(64, png.width);
+  EXPECT_EQ(48, png.height);
+  EXPECT_EQ(ExpectedRgba(frame_.Row(0), 64, 48, kStride, true), png.rgba);
+  EXPECT_EQ(0u, outputs[0].stride);
+
+  // Scaled exactly as a capture of that rectangle would be.
+  ImageView view;
+  ASSERT_TRUE(CropImage(frame_, crops[1].rect, &view));
+  ImageResizer resizer;
+  ImageView scaled;
+  ASSERT_TRUE(resizer.Fit(view, crops[1].limits, &scaled));
+  EXPECT_EQ(60, outputs[1].width);
+  EXPECT_EQ(40, outputs[1].height);
+  EXPECT_EQ(crops[1].rect, outputs[1].rect);
+  EncoderSession session;
+  EncodeSettings raw;
+  raw.format = CaptureFormat::kRawBgra;
+  ASSERT_TRUE(session.Encode(scaled, raw));
+  EXPECT_EQ(std::vector<uint8_t>(session.data(),
+                                 session.data() + session.size()),
+            outputs[1].bytes);
+
+  EXPECT_EQ(0, std::memcmp("qoif", outputs[2].bytes.data(), 4));
+}
+
+TEST_F(BatchEncoderTest, ClipsCropsToTheFrame) {
+  const std::vector<BatchCrop> crops = {Crop(-10, -5, 30, 20),
+                                        Crop(300, 190, 50, 50)};
+  BatchEncoder encoder;
+  std::vector<BatchOutput> outputs;
+  ASSERT_TRUE(encoder.Encode(frame_, crops, &outputs));
+  ASSERT_EQ(2u, outputs.size());
+  EXPECT_EQ((PixelRect{0, 0, 20, 15}), outputs[0].rect);
+  EXPECT_EQ(Expected(outputs[0].rect), outputs[0].bytes);
+  EXPECT_EQ((PixelRect{300, 190, 20, 10}), outputs[1].rect);
+  EXPECT_EQ(20, outputs[1].width);
+  EXPECT_EQ(Expected(outputs[1].rect), outputs[1].bytes);
+}
+
+TEST_F(BatchEncoderTest, FailsTheBatchForACropOffTheFrame) {
+  const std::vector<BatchCrop> crops = {Crop(0, 0, 10, 10),
+                                        Crop(kWidth, 0, 10, 10)};
+  BatchEncoder encoder;
+  std::vector<BatchOutput> outputs(1);
+  EXPECT_FALSE(encoder.Encode(frame_, crops, &outputs));
+  EXPECT_TRUE(outputs.empty());
+  EXPECT_FALSE(encoder.Encode(ImageView(), {Crop(0, 0, 1, 1)}, &outputs));
+
+  // The encoder is still usable.
+  ASSERT_TRUE(encoder.Encode(frame_, {Crop(1, 2, 3, 4)}, &outputs));
+  EXPECT_EQ(Expected(PixelRect{1, 2, 3, 4}), outputs[0].bytes);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,259 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "capture_pipeline.h"
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+// Stands in for the Flutter platform thread: the test thread runs the
+// dispatched tasks from RunFor().
+class FakePlatformThread {
+ public:
+  CapturePipeline::Dispatcher Dispatcher() {
+    return [this](std::function<void()> task) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+      }
+      cv_.notify_one();
+      return true;
+    };
+  }
+
+  // Runs tasks until |done| or the timeout, like an event loop that also
+  // has to stay responsive. Returns the longest time one iteration of the
+  // loop was held up.
+  Clock::duration RunUntil(const std::function<bool()>& done,
+                           Clock::duration timeout = std::chrono::seconds(5)) {
+    const Clock::time_point deadline = Clock::now() + timeout;
+    Clock::duration longest{0};
+    while (!done() && Clock::now() < deadline) {
+      const Clock::time_point start = Clock::now();
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, milliseconds(1), [this] { return !tasks_.empty(); });
+        if (!tasks_.empty()) {
+          task = std::move(tasks_.front());
+          tasks_.pop_front();
+        }
+      }
+      if (task) task();
+      longest = std::max(longest, Clock::now() - start);
+    }
+    return longest;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+};
+
+// What happened to each job, in the order it happened.
+struct Trace {
+  std::mutex mutex;
+  std::vector<int> completed;
+  std::vector<std::thread::id> completed_on;
+  std::vector<Clock::time_point> capture_start;
+  std::vector<Clock::time_point> encode_end;
+  int awaiting_encode = 0;
+  int max_awaiting_encode = 0;
+  int encoded = 0;
+};
+
+class SlowJob : public PipelineJob {
+ public:
+  SlowJob(int id, Trace* trace, milliseconds capture, milliseconds encode,
+          bool fail = false)
+      : id_(id),
+        trace_(trace),
+        capture_(capture),
+        encode_(encode),
+        fail_(fail) {}
+
+  bool Capture() override {
+    {
+      std::lock_guard<std::mutex> lock(trace_->mutex);
+      trace_->capture_start[static_cast<size_t>(id_)] = Clock::now();
+    }
+    std::this_thread::sleep_for(capture_);
+    if (fail_) return false;
+    std::lock_guard<std::mutex> lock(trace_->mutex);
+    trace_->max_awaiting_encode =
+        std::max(trace_->max_awaiting_encode, ++trace_->awaiting_encode);
+    return true;
+  }
+
+  void Encode() override {
+    std::this_thread::sleep_for(encode_);
+    std::lock_guard<std::mutex> lock(trace_->mutex);
+    --trace_->awaiting_encode;
+    ++trace_->encoded;
+    trace_->encode_end[static_cast<size_t>(id_)] = Clock::now();
+  }
+
+  void Complete() override {
+    std::lock_guard<std::mutex> lock(trace_->mutex);
+    trace_->completed.push_back(id_);
+    trace_->completed_on.push_back(std::this_thread::get_id());
+  }
+
+ private:
+  int id_;
+  Trace* trace_;
+  milliseconds capture_;
+  milliseconds encode_;
+  bool fail_;
+};
+
+size_t Completed(Trace* trace) {
+  std::lock_guard<std::mutex> lock(trace->mutex);
+  return trace->completed.size();
+}
+
+void Resize(Trace* trace, size_t jobs) {
+  trace->capture_start.resize(jobs);
+  trace->encode_end.resize(jobs);
+}
+
+}  // namespace
+
+TEST(CapturePipelineTest, PlatformThreadStaysResponsiveWhileJobsAreInFlight) {
+  FakePlatformThread platform;
+  Trace trace;
+  Resize(&trace, 4);
+  CapturePipeline pipeline(platform.Dispatcher());
+
+  const Clock::time_point start = Clock::now();
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(pipeline.Submit(std::make_unique<SlowJob>(
+        i, &trace, milliseconds(30), milliseconds(60))));
+  }
+  // Submitting is just queueing.
+  EXPECT_LT(Clock::now() - start, milliseconds(20));
+  EXPECT_EQ(4u, pipeline.pending());
+
+  const Clock::duration longest =
+      platform.RunUntil([&] { return Completed(&trace) == 4; });
+  ASSERT_EQ(4u, Completed(&trace));
+  // The loop never waited on a capture (30 ms) or an encode (60 ms).
+  EXPECT_LT(longest, milliseconds(20));
+  EXPECT_EQ(0u, pipeline.pending());
+
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), trace.completed);
+  for (std::thread::id id : trace.completed_on) {
+    EXPECT_EQ(std::this_thread::get_id(), id);
+  }
+}
+
+TEST(CapturePipelineTest, OverlapsCaptureOfNextFrameWithEncode) {
+  FakePlatformThread platform;
+  Trace trace;
+  Resize(&trace, 4);
+  CapturePipeline pipeline(platform.Dispatcher());
+
+  const Clock::time_point start = Clock::now();
+  for (int i = 0; i < 4; ++i) {
+    pipeline.Submit(std::make_unique<SlowJob>(i, &trace, milliseconds(30),
+                                              milliseconds(30)));
+  }
+  platform.RunUntil([&] { return Completed(&trace) == 4; });
+  ASSERT_EQ(4u, Completed(&trace));
+  const Clock::duration elapsed = Clock::now() - start;
+
+  for (size_t i = 1; i < 4; ++i) {
+    EXPECT_LT(trace.capture_start[i], trace.encode_end[i - 1]) << i;
+  }
+  // Serially this takes 4 * (30 + 30) = 240 ms; pipelined about 150 ms.
+  EXPECT_LT(elapsed, milliseconds(225));
+}
+
+TEST(CapturePipelineTest, BoundsFramesWaitingForTheEncoder) {
+  FakePlatformThread platform;
+  Trace trace;
+  Resize(&trace, 6);
+  CapturePipelineOptions options;
+  options.max_captured = 1;
+  CapturePipeline pipeline(platform.Dispatcher(), options);
+  for (int i = 0; i < 6; ++i) {
+    pipeline.Submit(std::make_unique<SlowJob>(i, &trace, milliseconds(0),
+                                              milliseconds(15)));
+  }
+  platform.RunUntil([&] { return Completed(&trace) == 6; });
+  ASSERT_EQ(6u, Completed(&trace));
+  // One frame queued plus the one being encoded, never all six.
+  EXPECT_LE(trace.max_awaiting_encode, 2);
+}
+
+TEST(CapturePipelineTest, FailedCaptureSkipsEncodeButCompletes) {
+  FakePlatformThread platform;
+  Trace trace;
+  Resize(&trace, 3);
+  CapturePipeline pipeline(platform.Dispatcher());
+  pipeline.Submit(std::make_unique<SlowJob>(0, &trace, milliseconds(0),
+                                            milliseconds(0)));
+  pipeline.Submit(std::make_unique<SlowJob>(1, &trace, milliseconds(0),
+                                            milliseconds(0), true));
+  pipeline.Submit(std::make_unique<SlowJob>(2, &trace, milliseconds(0),
+                                            milliseconds(0)));
+  EXPECT_FALSE(pipeline.Submit(nullptr));
+  platform.RunUntil([&] { return Completed(&trace) == 3; });
+  EXPECT_EQ(3u, Completed(&trace));
+  EXPECT_EQ(2, trace.encoded);
+}
+
+TEST(CapturePipelineTest, FailedCaptureCompletesInSubmissionOrder) {
+  FakePlatformThread platform;
+  Trace trace;
+  Resize(&trace, 3);
+  CapturePipeline pipeline(platform.Dispatcher());
+  pipeline.Submit(std::make_unique<SlowJob>(0, &trace, milliseconds(0),
+                                            milliseconds(50)));
+  pipeline.Submit(std::make_unique<SlowJob>(1, &trace, milliseconds(0),
+                                            milliseconds(0), true));
+  pipeline.Submit(std::make_unique<SlowJob>(2, &trace, milliseconds(0),
+                                            milliseconds(0)));
+  platform.RunUntil([&] { return Completed(&trace) == 3; });
+  // Job 1 fails long before job 0 finishes encoding, but waits for it.
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), trace.completed);
+  EXPECT_EQ(2, trace.encoded);
+}
+
+TEST(CapturePipelineTest, DestructorFinishesSubmittedJobs) {
+  FakePlatformThread platform;
+  Trace trace;
+  Resize(&trace, 3);
+  {
+    CapturePipeline pipeline(platform.Dispatcher());
+    for (int i = 0; i < 3; ++i) {
+      pipeline.Submit(std::make_unique<SlowJob>(i, &trace, milliseconds(5),
+                                                milliseconds(5)));
+    }
+  }
+  EXPECT_EQ(3, trace.encoded);
+  // Completions were handed over; they run when the platform thread gets
+  // to them.
+  EXPECT_EQ(0u, Completed(&trace));
+  platform.RunUntil([&] { return Completed(&trace) == 3; });
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), trace.completed);
+}
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "capture_source.h"
+#include "frame_mailbox.h"
+#include "frame_pool.h"
+#include "image.h"
+#include "image_rect.h"
+#include "synthetic_screen.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+// A source that fails every capture.
+class FailingSource : public CaptureSource {
+ public:
+  PixelRect Bounds() override { return PixelRect{0, 0, 32, 16}; }
+  bool Capture(const PixelRect&, bool, uint8_t*, size_t) override {
+    ++captures_;
+    return false;
+  }
+
+  int captures_ = 0;
+};
+
+SyntheticScreenOptions Small() {
+  SyntheticScreenOptions options;
+  options.width = 320;
+  options.height = 200;
+  return options;
+}
+
+TEST(CaptureSourceTest, CapturesIntoAPooledFrame) {
+  SyntheticScreen screen(Small());
+  SyntheticScreen reference(Small());
+  FramePool pool;
+  const PixelRect rect{10, 20, 100, 50};
+  FramePool::Lease frame = CaptureToPool(&screen, &pool, rect, true);
+  ASSERT_TRUE(frame);
+  EXPECT_EQ(100, frame->width());
+  EXPECT_EQ(50, frame->height());
+
+  std::vector<uint8_t> expected(100 * 4 * 50);
+  ASSERT_TRUE(reference.Capture(rect, true, expected.data(), 100 * 4));
+  for (int y = 0; y < 50; ++y) {
+    ASSERT_EQ(0, std::memcmp(frame->data() + static_cast<size_t>(y) *
+                                                 frame->stride(),
+                             expected.data() + static_cast<size_t>(y) * 400,
+                             400));
+  }
+
+  // The buffer goes back to the pool for the next capture.
+  uint8_t* data = frame->data();
+  frame.Reset();
+  FramePool::Lease next = CaptureToPool(&screen, &pool, rect, true);
+  ASSERT_TRUE(next);
+  EXPECT_EQ(data, next->data());
+  EXPECT_EQ(1u, pool.stats().hits);
+}
+
+TEST(CaptureSourceTest, PoolCaptureFailsCleanly) {
+  FailingSource failing;
+  FramePool pool;
+  EXPECT_FALSE(CaptureToPool(&failing, &pool, PixelRect{0, 0, 8, 8}, false));
+  EXPECT_EQ(1, failing.captures_);
+  EXPECT_EQ(0u, pool.stats().leased_bytes);
+
+  SyntheticScreen screen(Small());
+  EXPECT_FALSE(CaptureToPool(&screen, &pool, PixelRect{0, 0, 0, 8}, false));
+  EXPECT_FALSE(
+      CaptureToPool(&screen, &pool, PixelRect{300, 0, 64, 8}, false));
+}
+
+TEST(CaptureSourceTest, StreamsTheWholeSource) {
+  SyntheticScreen screen(Small());
+  SyntheticScreen reference(Small());
+  CaptureSourceFrameSource source(&screen, false);
+  StreamFrame frame;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(source.Capture(&frame));
+    EXPECT_EQ(320, frame.width);
+    EXPECT_EQ(200, frame.height);
+    EXPECT_EQ(320u * 4, frame.stride);
+    EXPECT_EQ(PixelFormat::kBgra8, frame.format);
+    std::vector<uint8_t> expected(320 * 4 * 200);
+    ASSERT_TRUE(reference.Capture(reference.Bounds(), false, expected.data(),
+                                  320 * 4));
+    EXPECT_EQ(expected, frame.pixels) << "frame " << i;
+  }
+
+  FailingSource failing;
+  CaptureSourceFrameSource failing_source(&failing, false);
+  EXPECT_FALSE(failing_source.Capture(&frame));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
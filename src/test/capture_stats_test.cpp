@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "capture_stats.h"
+#include "synthetic_screen.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+// Whether |actual| is within the histogram's 1/16 of |expected|.
+bool Near(int64_t expected, int64_t actual) {
+  return std::llabs(actual - expected) * 16 <= expected;
+}
+
+TEST(LatencyHistogramTest, BucketsCoverEveryValueInOrder) {
+  EXPECT_EQ(0u, LatencyHistogram::BucketFor(0));
+  EXPECT_EQ(7u, LatencyHistogram::BucketFor(7));
+  EXPECT_EQ(LatencyHistogram::kBucketCount - 1,
+            LatencyHistogram::BucketFor(UINT64_MAX));
+  for (size_t bucket = 0; bucket < LatencyHistogram::kBucketCount; ++bucket) {
+    const uint64_t lower = LatencyHistogram::BucketLowerBound(bucket);
+    EXPECT_EQ(bucket, LatencyHistogram::BucketFor(lower)) << lower;
+    if (bucket + 1 < LatencyHistogram::kBucketCount) {
+      const uint64_t next = LatencyHistogram::BucketLowerBound(bucket + 1);
+      ASSERT_LT(lower, next);
+      EXPECT_EQ(bucket, LatencyHistogram::BucketFor(next - 1)) << next - 1;
+      // At most 1/8 of the values a bucket holds.
+      EXPECT_LE((next - lower) * 8, std::max<uint64_t>(lower, 8));
+    }
+  }
+}
+
+TEST(LatencyHistogramTest, EmptySummaryIsZero) {
+  LatencyHistogram histogram;
+  const LatencySummary summary = histogram.Summarize();
+  EXPECT_EQ(0u, summary.count);
+  EXPECT_EQ(0, summary.p50);
+  EXPECT_EQ(0, summary.p99);
+  EXPECT_EQ(0, summary.max);
+}
+
+TEST(LatencyHistogramTest, PercentilesAreWithinASixteenth) {
+  LatencyHistogram histogram;
+  // 1..10000 microseconds, shuffled by a stride coprime to the count.
+  for (int64_t i = 0; i < 10000; ++i) {
+    histogram.Record(((i * 7919) % 10000 + 1) * 1000);
+  }
+  const LatencySummary summary = histogram.Summarize();
+  EXPECT_EQ(10000u, summary.count);
+  EXPECT_TRUE(Near(5000000, summary.p50)) << summary.p50;
+  EXPECT_TRUE(Near(9500000, summary.p95)) << summary.p95;
+  EXPECT_TRUE(Near(9900000, summary.p99)) << summary.p99;
+  EXPECT_EQ(10000000, summary.max);
+  EXPECT_EQ(5000500, summary.mean);
+}
+
+TEST(LatencyHistogramTest, TailIsNotHiddenByTheMedian) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 98; ++i) histogram.Record(2000000);
+  histogram.Record(40000000);
+  histogram.Record(90000000);
+  const LatencySummary summary = histogram.Summarize();
+  EXPECT_TRUE(Near(2000000, summary.p50));
+  EXPECT_TRUE(Near(2000000, summary.p95));
+  EXPECT_TRUE(Near(40000000, summary.p99)) << summary.p99;
+  EXPECT_EQ(90000000, summary.max);
+  // Percentiles never exceed the largest sample.
+  LatencyHistogram one;
+  one.Record(1000);
+  EXPECT_LE(one.Summarize().p99, 1000);
+}
+
+TEST(LatencyHistogramTest, NegativeSamplesCountAsZero) {
+  LatencyHistogram histogram;
+  histogram.Record(-5);
+  const LatencySummary summary = histogram.Summarize();
+  EXPECT_EQ(1u, summary.count);
+  EXPECT_EQ(0, summary.max);
+}
+
+TEST(LatencyHistogramTest, RecordsFromManyThreadsWithoutLosingSamples) {
+  LatencyHistogram histogram;
+  constexpr int kThreads = 4;
+  constexpr int kSamples = 50000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&histogram, t] {
+      for (int i = 0; i < kSamples; ++i) histogram.Record(1000 * (t + 1) + i);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  const LatencySummary summary = histogram.Summarize();
+  EXPECT_EQ(static_cast<uint64_t>(kThreads * kSamples), summary.count);
+  EXPECT_EQ(1000 * kThreads + kSamples - 1, summary.max);
+
+  histogram.Reset();
+  EXPECT_EQ(0u, histogram.Summarize().count);
+  EXPECT_EQ(0, histogram.Summarize().max);
+}
+
+TEST(CaptureStatsTest, RecordsOnlyTheStagesThatRan) {
+  CaptureStats stats;
+  CaptureSample sample;
+  sample.Set(CaptureStage::kCapture, 3000000);
+  sample.Set(CaptureStage::kEncode, 9000000);
+  sample.Set(CaptureStage::kTotal, 13000000);
+  sample.captured_bytes = 1920 * 1080 * 4;
+  sample.output_bytes = 500000;
+  stats.Record(sample);
+  stats.Record(sample);
+  stats.RecordError(CaptureStage::kCapture);
+
+  CaptureStatsSnapshot snapshot = stats.Snapshot();
+  EXPECT_EQ(2u, snapshot.stage(CaptureStage::kCapture).latency.count);
+  EXPECT_EQ(1u, snapshot.stage(CaptureStage::kCapture).errors);
+  EXPECT_EQ(0u, snapshot.stage(CaptureStage::kCursor).latency.count);
+  EXPECT_EQ(0u, snapshot.stage(CaptureStage::kScale).latency.count);
+  EXPECT_EQ(9000000, snapshot.stage(CaptureStage::kEncode).latency.max);
+  EXPECT_EQ(0u, snapshot.stage(CaptureStage::kEncode).errors);
+  EXPECT_EQ(2u * 1920 * 1080 * 4, snapshot.captured_bytes);
+  EXPECT_EQ(1000000u, snapshot.output_bytes);
+
+  stats.Reset();
+  snapshot = stats.Snapshot();
+  for (const StageStats& stage : snapshot.stages) {
+    EXPECT_EQ(0u, stage.latency.count);
+    EXPECT_EQ(0u, stage.errors);
+  }
+  EXPECT_EQ(0u, snapshot.captured_bytes);
+  EXPECT_EQ(0u, snapshot.output_bytes);
+}
+
+TEST(CaptureStatsTest, StagesHaveStableNames) {
+  EXPECT_STREQ("capture", CaptureStageName(CaptureStage::kCapture));
+  EXPECT_STREQ("cursor", CaptureStageName(CaptureStage::kCursor));
+  EXPECT_STREQ("scale", CaptureStageName(CaptureStage::kScale));
+  EXPECT_STREQ("encode", CaptureStageName(CaptureStage::kEncode));
+  EXPECT_STREQ("total", CaptureStageName(CaptureStage::kTotal));
+}
+
+TEST(CaptureStatsTest, SourcesTimeTheCursorOnTheirOwn) {
+  SyntheticScreenOptions options;
+  options.width = 320;
+  options.height = 200;
+  SyntheticScreen screen(options);
+  std::vector<uint8_t> pixels(320 * 200 * 4);
+  ASSERT_TRUE(screen.Capture(screen.Bounds(), false, pixels.data(), 320 * 4));
+  EXPECT_EQ(-1, screen.cursor_nanos());
+  ASSERT_TRUE(screen.Capture(screen.Bounds(), true, pixels.data(), 320 * 4));
+  EXPECT_GE(screen.cursor_nanos(), 0);
+
+  const int64_t start = MonotonicNanos();
+  EXPECT_GE(MonotonicNanos(), start);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "capture_stream.h"
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+using Clock = FramePacer::Clock;
+using std::chrono::milliseconds;
+
+// Generates small frames whose first pixel counts the captures, so a
+// delivered frame can be matched to the capture that produced it.
+class SyntheticSource : public FrameSource {
+ public:
+  bool Capture(StreamFrame* frame) override {
+    const uint32_t n = count_++;
+    if (fail_) return false;
+    frame->width = 8;
+    frame->height = 2;
+    frame->stride = 32;
+    frame->format = PixelFormat::kBgra8;
+    frame->pixels.resize(64);
+    for (size_t i = 0; i < frame->pixels.size(); ++i) {
+      frame->pixels[i] = static_cast<uint8_t>(n + i);
+    }
+    return true;
+  }
+
+  std::atomic<uint32_t> count_{0};
+  bool fail_ = false;
+};
+
+struct Delivery {
+  uint64_t sequence;
+  int64_t timestamp_us;
+  uint8_t first_pixel;
+};
+
+// Records deliveries, optionally taking |delay| per frame to simulate a slow
+// encoder, or rejecting every frame to simulate a failing one.
+class Recorder {
+ public:
+  explicit Recorder(milliseconds delay = milliseconds(0)) : delay_(delay) {}
+
+  bool reject_ = false;
+
+  CaptureStream::FrameCallback Callback() {
+    return [this](const StreamFrame& frame) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deliveries_.push_back(
+            Delivery{frame.sequence, frame.timestamp_us, frame.pixels[0]});
+      }
+      if (delay_.count() > 0) std::this_thread::sleep_for(delay_);
+      return !reject_;
+    };
+  }
+
+  std::vector<Delivery> deliveries() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return deliveries_;
+  }
+
+  // Waits until |count| frames have been delivered or |timeout| passes.
+  bool WaitFor(size_t count, milliseconds timeout) {
+    const Clock::time_point end = Clock::now() + timeout;
+    while (Clock::now() < end) {
+      if (deliveries().size() >= count) return true;
+      std::this_thread::sleep_for(milliseconds(2));
+    }
+    return false;
+  }
+
+ private:
+  milliseconds delay_;
+  std::mutex mutex_;
+  std::vector<Delivery> deliveries_;
+};
+
+}  // namespace
+
+TEST(FramePacerTest, DeadlinesFollowTheGridAndSkipMissedTicks) {
+  FramePacer pacer(50.0);
+  EXPECT_EQ(milliseconds(20), pacer.period());
+  const Clock::time_point t0 = Clock::time_point() + milliseconds(1000);
+  EXPECT_EQ(t0, pacer.Start(t0));
+
+  // A fast capture waits for the next tick; capture time does not drift it.
+  EXPECT_EQ(t0 + milliseconds(20), pacer.Next(t0 + milliseconds(3)));
+  EXPECT_EQ(t0 + milliseconds(40), pacer.Next(t0 + milliseconds(25)));
+  // Finishing exactly on a tick captures on it.
+  EXPECT_EQ(t0 + milliseconds(60), pacer.Next(t0 + milliseconds(60)));
+  EXPECT_EQ(0u, pacer.skipped());
+
+  // An overrun to 135 ms skips the ticks at 80-120 and resumes at 140.
+  EXPECT_EQ(t0 + milliseconds(140), pacer.Next(t0 + milliseconds(135)));
+  EXPECT_EQ(3u, pacer.skipped());
+  EXPECT_EQ(t0 + milliseconds(160), pacer.Next(t0 + milliseconds(141)));
+}
+
+TEST(CaptureStreamTest, DeliversSequencedTimestampedFrames) {
+  SyntheticSource source;
+  Recorder recorder;
+  CaptureStream stream;
+  CaptureStreamOptions options;
+  options.fps = 100.0;
+  ASSERT_TRUE(stream.Start(&source, options, recorder.Callback()));
+  EXPECT_TRUE(stream.running());
+  EXPECT_TRUE(recorder.WaitFor(5, milliseconds(5000)));
+  stream.Stop();
+  EXPECT_FALSE(stream.running());
+
+  const std::vector<Delivery> deliveries = recorder.deliveries();
+  ASSERT_GE(deliveries.size(), 5u);
+  for (size_t i = 1; i < deliveries.size(); ++i) {
+    EXPECT_GT(deliveries[i].sequence, deliveries[i - 1].sequence);
+    EXPECT_GT(deliveries[i].timestamp_us, deliveries[i - 1].timestamp_us);
+  }
+  // Frames are paced on a 10 ms grid. A single capture can start late, so
+  // only the whole run is checked, allowing one period of wake-up jitter.
+  const Delivery& first = deliveries.front();
+  const Delivery& last = deliveries.back();
+  EXPECT_GE(last.timestamp_us - first.timestamp_us,
+            10000 * (static_cast<int64_t>(last.sequence - first.sequence) - 1));
+  for (const Delivery& delivery : deliveries) {
+    // The pixels are those of the capture the sequence number names.
+    EXPECT_EQ(static_cast<uint8_t>(delivery.sequence), delivery.first_pixel);
+  }
+  const CaptureStreamStats stats = stream.stats();
+  EXPECT_EQ(deliveries.size(), stats.delivered);
+  EXPECT_LE(stats.delivered + stats.dropped, stats.captured);
+  EXPECT_EQ(0u, stats.failed);
+}
+
+// A consumer slower than the capture rate gets the newest frames with gaps
+// in between instead of a growing backlog.
+TEST(CaptureStreamTest, SlowConsumerDropsOldestInsteadOfQueueing) {
+  SyntheticSource source;
+  Recorder recorder(milliseconds(40));
+  CaptureStream stream;
+  CaptureStreamOptions options;
+  options.fps = 200.0;
+  ASSERT_TRUE(stream.Start(&source, options, recorder.Callback()));
+  EXPECT_TRUE(recorder.WaitFor(6, milliseconds(10000)));
+  stream.Stop();
+
+  const std::vector<Delivery> deliveries = recorder.deliveries();
+  const CaptureStreamStats stats = stream.stats();
+  EXPECT_GT(stats.dropped, 0u);
+  EXPECT_GT(stats.captured, stats.delivered);
+  // Every capture was either delivered, dropped, or is the one still in the
+  // mailbox when the stream stopped.
+  EXPECT_LE(stats.captured - (stats.delivered + stats.dropped), 2u);
+  bool gaps = false;
+  for (size_t i = 1; i < deliveries.size(); ++i) {
+    EXPECT_GT(deliveries[i].sequence, deliveries[i - 1].sequence);
+    if (deliveries[i].sequence > deliveries[i - 1].sequence + 1) gaps = true;
+  }
+  EXPECT_TRUE(gaps);
+}
+
+TEST(CaptureStreamTest, RejectsBadStartsAndRestarts) {
+  SyntheticSource source;
+  Recorder recorder;
+  CaptureStream stream;
+  CaptureStreamOptions options;
+  options.fps = 0.0;
+  EXPECT_FALSE(stream.Start(&source, options, recorder.Callback()));
+  options.fps = CaptureStream::kMaxFps + 1.0;
+  EXPECT_FALSE(stream.Start(&source, options, recorder.Callback()));
+  options.fps = 100.0;
+  EXPECT_FALSE(stream.Start(nullptr, options, recorder.Callback()));
+  EXPECT_FALSE(stream.Start(&source, options, nullptr));
+  stream.Stop();  // not running: no-op
+
+  ASSERT_TRUE(stream.Start(&source, options, recorder.Callback()));
+  EXPECT_FALSE(stream.Start(&source, options, recorder.Callback()));
+  EXPECT_TRUE(recorder.WaitFor(2, milliseconds(5000)));
+  stream.Stop();
+  stream.Stop();
+
+  // A restart counts from zero again.
+  Recorder second;
+  ASSERT_TRUE(stream.Start(&source, options, second.Callback()));
+  EXPECT_TRUE(second.WaitFor(1, milliseconds(5000)));
+  stream.Stop();
+  EXPECT_EQ(0u, second.deliveries().front().sequence);
+}
+
+TEST(CaptureStreamTest, CountsFailedCaptures) {
+  SyntheticSource source;
+  source.fail_ = true;
+  Recorder recorder;
+  CaptureStream stream;
+  CaptureStreamOptions options;
+  options.fps = 200.0;
+  ASSERT_TRUE(stream.Start(&source, options, recorder.Callback()));
+  const Clock::time_point end = Clock::now() + milliseconds(5000);
+  while (stream.stats().failed < 3 && Clock::now() < end) {
+    std::this_thread::sleep_for(milliseconds(2));
+  }
+  stream.Stop();
+  EXPECT_GE(stream.stats().failed, 3u);
+  EXPECT_EQ(0u, stream.stats().captured);
+  EXPECT_TRUE(recorder.deliveries().empty());
+}
+
+// Frames the callback rejects count as failed, not delivered.
+TEST(CaptureStreamTest, CountsRejectedFramesAsFailed) {
+  SyntheticSource source;
+  Recorder recorder;
+  recorder.reject_ = true;
+  CaptureStream stream;
+  CaptureStreamOptions options;
+  options.fps = 100.0;
+  ASSERT_TRUE(stream.Start(&source, options, recorder.Callback()));
+  EXPECT_TRUE(recorder.WaitFor(3, milliseconds(5000)));
+  stream.Stop();
+  const CaptureStreamStats stats = stream.stats();
+  EXPECT_EQ(0u, stats.delivered);
+  EXPECT_EQ(recorder.deliveries().size(), stats.failed);
+  EXPECT_GE(stats.failed, 3u);
+}
+
+// Stop() returns promptly even at a very low frame rate.
+TEST(CaptureStreamTest, StopInterruptsTheWaitForTheNextTick) {
+  SyntheticSource source;
+  Recorder recorder;
+  CaptureStream stream;
+  CaptureStreamOptions options;
+  options.fps = 0.1;
+  ASSERT_TRUE(stream.Start(&source, options, recorder.Callback()));
+  EXPECT_TRUE(recorder.WaitFor(1, milliseconds(5000)));
+  const Clock::time_point start = Clock::now();
+  stream.Stop();
+  EXPECT_LT(Clock::now() - start, milliseconds(1000));
+}
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,285 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "cursor_compositor.h"
+#include "image.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+// dst = src + dst * (255 - src alpha) / 255, rounded, then XOR.
+void ReferenceBlend(const uint8_t* src, const uint8_t* xor_mask,
+                    uint8_t* dst, size_t pixels) {
+  for (size_t i = 0; i < pixels * 4; ++i) {
+    const int alpha = src[i / 4 * 4 + 3];
+    const double blended = src[i] + dst[i] * (255 - alpha) / 255.0;
+    int value = std::min(255, static_cast<int>(blended + 0.5));
+    if (xor_mask) value ^= xor_mask[i];
+    dst[i] = static_cast<uint8_t>(value);
+  }
+}
+
+// Random premultiplied pixels; a third of them fully transparent, as most
+// of a cursor is.
+std::vector<uint8_t> RandomPremultiplied(size_t pixels, uint32_t seed) {
+  std::vector<uint8_t> bytes = RandomBytes(pixels * 4, seed);
+  for (size_t i = 0; i < pixels; ++i) {
+    uint8_t* p = &bytes[i * 4];
+    if (p[3] % 3 == 0) {
+      p[0] = p[1] = p[2] = p[3] = 0;
+      continue;
+    }
+    for (int c = 0; c < 3; ++c) {
+      p[c] = static_cast<uint8_t>(p[c] * p[3] / 255);
+    }
+  }
+  return bytes;
+}
+
+// A mask with the listed bits set, rows CursorMaskStride(width) apart.
+std::vector<uint8_t> Mask(int width, int height,
+                          const std::vector<std::pair<int, int>>& set) {
+  std::vector<uint8_t> mask(CursorMaskStride(width) *
+                            static_cast<size_t>(height));
+  for (const auto& bit : set) {
+    mask[static_cast<size_t>(bit.second) * CursorMaskStride(width) +
+         static_cast<size_t>(bit.first / 8)] |=
+        static_cast<uint8_t>(0x80 >> (bit.first % 8));
+  }
+  return mask;
+}
+
+std::vector<uint8_t> Pixel(uint8_t b, uint8_t g, uint8_t r, uint8_t a) {
+  return {b, g, r, a};
+}
+
+// The pixel at (|x|, |y|) of a packed |width|-wide image.
+std::vector<uint8_t> PixelAt(const std::vector<uint8_t>& image, int width,
+                             int x, int y) {
+  const size_t at = (static_cast<size_t>(y) * static_cast<size_t>(width) +
+                     static_cast<size_t>(x)) *
+                    4;
+  return std::vector<uint8_t>(image.begin() + static_cast<long>(at),
+                              image.begin() + static_cast<long>(at + 4));
+}
+
+TEST(CursorCompositorTest, BlendIsExactForEveryAlphaAndScreenValue) {
+  // One pixel per (alpha, screen byte) pair, with the brightest color the
+  // alpha allows.
+  std::vector<uint8_t> src;
+  std::vector<uint8_t> screen;
+  for (int alpha = 0; alpha < 256; ++alpha) {
+    for (int value = 0; value < 256; ++value) {
+      const uint8_t a = static_cast<uint8_t>(alpha);
+      const uint8_t v = static_cast<uint8_t>(value);
+      src.insert(src.end(), {a, static_cast<uint8_t>(a / 2), 0, a});
+      screen.insert(screen.end(), {v, v, v, v});
+    }
+  }
+  const size_t pixels = src.size() / 4;
+  std::vector<uint8_t> expected = screen;
+  ReferenceBlend(src.data(), nullptr, expected.data(), pixels);
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    std::vector<uint8_t> dst = screen;
+    BlendCursorRow(src.data(), nullptr, dst.data(), pixels);
+    EXPECT_EQ(expected, dst) << "avx2=" << features.avx2
+                             << " sse2=" << features.sse2;
+  }
+}
+
+TEST(CursorCompositorTest, BlendMatchesTheReferenceAtEveryLength) {
+  for (size_t pixels = 0; pixels < 40; ++pixels) {
+    const std::vector<uint8_t> src =
+        RandomPremultiplied(pixels, static_cast<uint32_t>(pixels));
+    std::vector<uint8_t> xor_mask = RandomBytes(pixels * 4, 99);
+    for (size_t i = 0; i < xor_mask.size(); i += 3) xor_mask[i] = 0;
+    const std::vector<uint8_t> screen = RandomBytes(pixels * 4, 7);
+    for (const bool with_xor : {false, true}) {
+      const uint8_t* flip = with_xor ? xor_mask.data() : nullptr;
+      std::vector<uint8_t> expected = screen;
+      ReferenceBlend(src.data(), flip, expected.data(), pixels);
+      for (const CpuFeatures& features : FeatureLevels()) {
+        ScopedCpuFeatures scoped(features);
+        std::vector<uint8_t> dst = screen;
+        BlendCursorRow(src.data(), flip, dst.data(), pixels);
+        EXPECT_EQ(expected, dst) << pixels << " pixels, xor=" << with_xor
+                                 << " avx2=" << features.avx2;
+      }
+    }
+  }
+}
+
+TEST(CursorCompositorTest, BlendSaturatesColorBrighterThanItsAlpha) {
+  const std::vector<uint8_t> src = {200, 200, 200, 100};
+  std::vector<uint8_t> dst = {250, 10, 250, 250};
+  std::vector<uint8_t> expected = dst;
+  ReferenceBlend(src.data(), nullptr, expected.data(), 1);
+  std::vector<uint8_t> src8;
+  std::vector<uint8_t> dst8;
+  for (int i = 0; i < 8; ++i) {
+    src8.insert(src8.end(), src.begin(), src.end());
+    dst8.insert(dst8.end(), dst.begin(), dst.end());
+  }
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    std::vector<uint8_t> out = dst8;
+    BlendCursorRow(src8.data(), nullptr, out.data(), 8);
+    for (int i = 0; i < 8; ++i) EXPECT_EQ(expected, PixelAt(out, 8, i, 0));
+  }
+}
+
+TEST(CursorCompositorTest, MonochromeCursorDrawsBlackWhiteAndInverts) {
+  // Four pixels: black, white, transparent and inverting.
+  const int width = 4;
+  const int height = 1;
+  std::vector<uint8_t> mask = Mask(width, height, {{2, 0}, {3, 0}});
+  const std::vector<uint8_t> xor_rows = Mask(width, height, {{1, 0}, {3, 0}});
+  mask.insert(mask.end(), xor_rows.begin(), xor_rows.end());
+  CursorImage cursor;
+  ASSERT_TRUE(DecodeMonochromeCursor(mask.data(), width, height, &cursor));
+  EXPECT_EQ(width, cursor.width);
+  EXPECT_EQ(height, cursor.height);
+  ASSERT_FALSE(cursor.xor_mask.empty());
+
+  std::vector<uint8_t> frame(width * 4u);
+  for (size_t i = 0; i < frame.size(); ++i) {
+    frame[i] = static_cast<uint8_t>(10 * (i % 4 + 1));
+  }
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    std::vector<uint8_t> out = frame;
+    CompositeCursor(cursor, 0, 0, out.data(), width, height, width * 4u);
+    EXPECT_EQ(Pixel(0, 0, 0, 0xFF), PixelAt(out, width, 0, 0));
+    EXPECT_EQ(Pixel(0xFF, 0xFF, 0xFF, 0xFF), PixelAt(out, width, 1, 0));
+    EXPECT_EQ(Pixel(10, 20, 30, 40), PixelAt(out, width, 2, 0));
+    EXPECT_EQ(Pixel(245, 235, 225, 40), PixelAt(out, width, 3, 0));
+  }
+}
+
+TEST(CursorCompositorTest, MonochromeCursorWithoutInversionHasNoXorMask) {
+  std::vector<uint8_t> mask = Mask(8, 2, {{0, 0}});
+  const std::vector<uint8_t> xor_rows = Mask(8, 2, {{5, 1}});
+  mask.insert(mask.end(), xor_rows.begin(), xor_rows.end());
+  CursorImage cursor;
+  ASSERT_TRUE(DecodeMonochromeCursor(mask.data(), 8, 2, &cursor));
+  EXPECT_TRUE(cursor.xor_mask.empty());
+  EXPECT_EQ(Pixel(0, 0, 0, 0), PixelAt(cursor.pixels, 8, 0, 0));
+  EXPECT_EQ(Pixel(0xFF, 0xFF, 0xFF, 0xFF), PixelAt(cursor.pixels, 8, 5, 1));
+}
+
+TEST(CursorCompositorTest, ColorCursorWithAlphaIsPremultiplied) {
+  const std::vector<uint8_t> bgra = {200, 100, 50, 128, 255, 255, 255, 0,
+                                     10, 20, 30, 255, 0, 0, 0, 0};
+  // The mask would make every pixel XOR; with alpha it is ignored.
+  const std::vector<uint8_t> mask =
+      Mask(2, 2, {{0, 0}, {1, 0}, {0, 1}, {1, 1}});
+  CursorImage cursor;
+  ASSERT_TRUE(DecodeColorCursor(bgra.data(), mask.data(), 2, 2, &cursor));
+  EXPECT_TRUE(cursor.xor_mask.empty());
+  EXPECT_EQ(Pixel(100, 50, 25, 128), PixelAt(cursor.pixels, 2, 0, 0));
+  EXPECT_EQ(Pixel(0, 0, 0, 0), PixelAt(cursor.pixels, 2, 1, 0));
+  EXPECT_EQ(Pixel(10, 20, 30, 255), PixelAt(cursor.pixels, 2, 0, 1));
+}
+
+TEST(CursorCompositorTest, ColorCursorWithoutAlphaUsesItsMask) {
+  // Opaque red where the mask is clear, XOR blue where it is set.
+  const std::vector<uint8_t> bgra = {0, 0, 255, 0, 255, 0, 0, 0};
+  const std::vector<uint8_t> mask = Mask(2, 1, {{1, 0}});
+  CursorImage cursor;
+  ASSERT_TRUE(DecodeColorCursor(bgra.data(), mask.data(), 2, 1, &cursor));
+  ASSERT_FALSE(cursor.xor_mask.empty());
+  std::vector<uint8_t> frame = {1, 2, 3, 4, 1, 2, 3, 4};
+  CompositeCursor(cursor, 0, 0, frame.data(), 2, 1, 8);
+  EXPECT_EQ(Pixel(0, 0, 255, 0xFF), PixelAt(frame, 2, 0, 0));
+  EXPECT_EQ(Pixel(254, 2, 3, 4), PixelAt(frame, 2, 1, 0));
+
+  // Without a mask the whole image is opaque.
+  ASSERT_TRUE(DecodeColorCursor(bgra.data(), nullptr, 2, 1, &cursor));
+  EXPECT_TRUE(cursor.xor_mask.empty());
+  EXPECT_EQ(Pixel(255, 0, 0, 0xFF), PixelAt(cursor.pixels, 2, 1, 0));
+}
+
+TEST(CursorCompositorTest, DecodingAnInvalidSizeLeavesTheImageEmpty) {
+  const std::vector<uint8_t> bytes(64, 0xFF);
+  CursorImage cursor;
+  ASSERT_TRUE(DecodeColorCursor(bytes.data(), nullptr, 2, 2, &cursor));
+  EXPECT_FALSE(DecodeColorCursor(bytes.data(), nullptr, 0, 2, &cursor));
+  EXPECT_TRUE(cursor.IsEmpty());
+  EXPECT_TRUE(cursor.pixels.empty());
+  EXPECT_FALSE(DecodeMonochromeCursor(nullptr, 2, 2, &cursor));
+  EXPECT_TRUE(cursor.IsEmpty());
+}
+
+TEST(CursorCompositorTest, CompositeClipsToTheFrame) {
+  const int size = 21;
+  CursorImage cursor;
+  cursor.width = size;
+  cursor.height = size;
+  cursor.pixels = RandomPremultiplied(size * size, 5);
+  cursor.xor_mask = RandomBytes(size * size * 4, 6);
+  const int width = 50;
+  const int height = 30;
+  const size_t stride = width * 4 + 12;
+  const std::vector<uint8_t> frame =
+      RandomBytes(stride * static_cast<size_t>(height), 8);
+  const int positions[][2] = {{-7, -3}, {40, 20}, {10, -20}, {-20, 5},
+                              {14, 4},  {50, 0},  {0, 30},   {-21, -21}};
+  for (const auto& at : positions) {
+    std::vector<uint8_t> expected = frame;
+    for (int y = 0; y < size; ++y) {
+      for (int x = 0; x < size; ++x) {
+        const int fx = at[0] + x;
+        const int fy = at[1] + y;
+        if (fx < 0 || fy < 0 || fx >= width || fy >= height) continue;
+        const size_t from = static_cast<size_t>(y * size + x) * 4;
+        const size_t to = static_cast<size_t>(fy) * stride +
+                          static_cast<size_t>(fx) * 4;
+        ReferenceBlend(&cursor.pixels[from], &cursor.xor_mask[from],
+                       &expected[to], 1);
+      }
+    }
+    for (const CpuFeatures& features : FeatureLevels()) {
+      ScopedCpuFeatures scoped(features);
+      std::vector<uint8_t> out = frame;
+      CompositeCursor(cursor, at[0], at[1], out.data(), width, height,
+                      stride);
+      EXPECT_EQ(expected, out) << "at " << at[0] << "," << at[1];
+    }
+  }
+}
+
+TEST(CursorCacheTest, EvictsTheLeastRecentlyUsedCursor) {
+  CursorCache cache;
+  EXPECT_EQ(nullptr, cache.Find(1));
+  for (uint64_t key = 1; key <= CursorCache::kCapacity; ++key) {
+    CursorImage* image = cache.Insert(key);
+    image->width = static_cast<int>(key);
+  }
+  const CursorImage* first = cache.Find(1);
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(1, first->width);
+
+  // Key 2 is now the oldest.
+  cache.Insert(100)->width = 100;
+  EXPECT_EQ(CursorCache::kCapacity, cache.size());
+  EXPECT_EQ(nullptr, cache.Find(2));
+  EXPECT_EQ(first, cache.Find(1));
+  EXPECT_EQ(100, cache.Find(100)->width);
+
+  // Inserting a cached key again starts it over, empty.
+  EXPECT_TRUE(cache.Insert(1)->IsEmpty());
+  EXPECT_EQ(CursorCache::kCapacity, cache.size());
+  cache.Clear();
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(nullptr, cache.Find(100));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
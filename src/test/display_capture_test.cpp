@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "display_capture.h"
+#include "frame_pool.h"
+#include "image.h"
+#include "image_rect.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+// The colour every synthetic display shows at desktop position (x, y), so
+// a stitched desktop can be checked without knowing which display drew it.
+void DesktopPixel(int x, int y, uint8_t* pixel) {
+  pixel[0] = static_cast<uint8_t>(x);
+  pixel[1] = static_cast<uint8_t>(y);
+  pixel[2] = static_cast<uint8_t>((x >> 8) ^ (y >> 4));
+  pixel[3] = 0x80;
+}
+
+// Displays that draw DesktopPixel(), recording how they are captured.
+class SyntheticDisplayBackend : public DisplayBackend {
+ public:
+  explicit SyntheticDisplayBackend(std::vector<PixelRect> layout) {
+    for (size_t i = 0; i < layout.size(); ++i) {
+      DisplayInfo display;
+      display.id = static_cast<int>(i);
+      display.bounds = layout[i];
+      display.primary = layout[i].x == 0 && layout[i].y == 0;
+      display.name = "SYNTH" + std::to_string(i);
+      displays_.push_back(display);
+    }
+  }
+
+  bool ListDisplays(std::vector<DisplayInfo>* displays) override {
+    *displays = displays_;
+    return true;
+  }
+
+  bool CaptureDisplay(const DisplayInfo& display, bool include_cursor,
+                      int lane, uint8_t* pixels) override {
+    const int now = ++running_;
+    int seen = max_running_.load();
+    while (now > seen && !max_running_.compare_exchange_weak(seen, now)) {
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      lanes_.insert(lane);
+      cursor_ = include_cursor;
+    }
+    // Long enough for the other lanes to start.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    --running_;
+    if (display.id == fail_id_) return false;
+    const PixelRect& bounds = display.bounds;
+    for (int y = 0; y < bounds.height; ++y) {
+      for (int x = 0; x < bounds.width; ++x) {
+        DesktopPixel(bounds.x + x, bounds.y + y,
+                     pixels + (static_cast<size_t>(y) *
+                                   static_cast<size_t>(bounds.width) +
+                               static_cast<size_t>(x)) *
+                                  kBytesPerPixel);
+      }
+    }
+    return true;
+  }
+
+  void set_fail_id(int id) { fail_id_ = id; }
+  int max_running() const { return max_running_.load(); }
+  std::set<int> lanes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lanes_;
+  }
+  bool cursor() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cursor_;
+  }
+
+ private:
+  std::vector<DisplayInfo> displays_;
+  int fail_id_ = -1;
+  std::atomic<int> running_{0};
+  std::atomic<int> max_running_{0};
+  mutable std::mutex mutex_;
+  std::set<int> lanes_;
+  bool cursor_ = false;
+};
+
+// A primary display with one to its left (and lower) and a taller one to
+// its right, leaving gaps in the virtual desktop.
+std::vector<PixelRect> ThreeDisplays() {
+  return {PixelRect{0, 0, 320, 200}, PixelRect{-160, 40, 160, 120},
+          PixelRect{320, -50, 100, 300}};
+}
+
+TEST(DisplayCaptureTest, DesktopBoundsCoverEveryDisplay) {
+  SyntheticDisplayBackend backend(ThreeDisplays());
+  std::vector<DisplayInfo> displays;
+  ASSERT_TRUE(backend.ListDisplays(&displays));
+  EXPECT_EQ(DesktopBounds(displays), (PixelRect{-160, -50, 580, 300}));
+  EXPECT_TRUE(DesktopBounds({}).IsEmpty());
+  EXPECT_EQ(DesktopBounds({displays[1]}), displays[1].bounds);
+}
+
+TEST(DisplayCaptureTest, CapturesDisplaysConcurrently) {
+  SyntheticDisplayBackend backend(ThreeDisplays());
+  std::vector<DisplayInfo> displays;
+  ASSERT_TRUE(backend.ListDisplays(&displays));
+  FramePool pool;
+  MultiDisplayCapture capture(&backend, &pool);
+
+  std::vector<FramePool::Lease> frames;
+  ASSERT_TRUE(capture.Capture(displays, true, &frames));
+  ASSERT_EQ(frames.size(), displays.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const PixelRect& bounds = displays[i].bounds;
+    ASSERT_TRUE(frames[i]);
+    EXPECT_EQ(frames[i]->width(), bounds.width);
+    EXPECT_EQ(frames[i]->height(), bounds.height);
+    uint8_t expected[4];
+    DesktopPixel(bounds.x + 5, bounds.y + 7, expected);
+    EXPECT_EQ(std::memcmp(frames[i]->View().Row(7) + 5 * kBytesPerPixel,
+                          expected, sizeof(expected)),
+              0);
+  }
+  EXPECT_TRUE(backend.cursor());
+  // One lane per display, all running together.
+  EXPECT_EQ(backend.lanes(), (std::set<int>{0, 1, 2}));
+  EXPECT_EQ(backend.max_running(), 3);
+}
+
+TEST(DisplayCaptureTest, LimitsLanesToTheThreadCount) {
+  SyntheticDisplayBackend backend(ThreeDisplays());
+  std::vector<DisplayInfo> displays;
+  ASSERT_TRUE(backend.ListDisplays(&displays));
+  FramePool pool;
+  MultiDisplayCaptureOptions options;
+  options.threads = 2;
+  MultiDisplayCapture capture(&backend, &pool, options);
+  std::vector<FramePool::Lease> frames;
+  ASSERT_TRUE(capture.Capture(displays, false, &frames));
+  EXPECT_EQ(frames.size(), 3u);
+  EXPECT_EQ(backend.lanes(), (std::set<int>{0, 1}));
+  EXPECT_LE(backend.max_running(), 2);
+}
+
+TEST(DisplayCaptureTest, OneFailedDisplayFailsTheCapture) {
+  SyntheticDisplayBackend backend(ThreeDisplays());
+  backend.set_fail_id(1);
+  std::vector<DisplayInfo> displays;
+  ASSERT_TRUE(backend.ListDisplays(&displays));
+  FramePool pool;
+  MultiDisplayCapture capture(&backend, &pool);
+  std::vector<FramePool::Lease> frames;
+  EXPECT_FALSE(capture.Capture(displays, false, &frames));
+  EXPECT_TRUE(frames.empty());
+  EXPECT_FALSE(capture.CaptureDesktop(displays, false));
+  EXPECT_FALSE(capture.Capture({}, false, &frames));
+  // Nothing is left leased.
+  EXPECT_EQ(pool.stats().leased_bytes, 0u);
+}
+
+TEST(DisplayCaptureTest, StitchesTheVirtualDesktop) {
+  SyntheticDisplayBackend backend(ThreeDisplays());
+  std::vector<DisplayInfo> displays;
+  ASSERT_TRUE(backend.ListDisplays(&displays));
+  FramePool pool;
+  MultiDisplayCapture capture(&backend, &pool);
+
+  FramePool::Lease desktop = capture.CaptureDesktop(displays, false);
+  ASSERT_TRUE(desktop);
+  const PixelRect bounds = DesktopBounds(displays);
+  ASSERT_EQ(desktop->width(), bounds.width);
+  ASSERT_EQ(desktop->height(), bounds.height);
+  const ImageView view = desktop->View();
+  for (int y = 0; y < bounds.height; ++y) {
+    for (int x = 0; x < bounds.width; ++x) {
+      const int desktop_x = bounds.x + x;
+      const int desktop_y = bounds.y + y;
+      bool covered = false;
+      for (const DisplayInfo& display : displays) {
+        covered |= !IntersectRects(display.bounds,
+                                   PixelRect{desktop_x, desktop_y, 1, 1})
+                        .IsEmpty();
+      }
+      uint8_t expected[4] = {0, 0, 0, 0xFF};
+      if (covered) DesktopPixel(desktop_x, desktop_y, expected);
+      ASSERT_EQ(std::memcmp(view.Row(y) + static_cast<size_t>(x) *
+                                              kBytesPerPixel,
+                            expected, sizeof(expected)),
+                0)
+          << "at " << desktop_x << "," << desktop_y;
+    }
+  }
+  // Only the stitched frame is still leased.
+  EXPECT_EQ(pool.stats().leased_bytes, desktop->size());
+}
+
+TEST(DisplayCaptureTest, StitchHandlesOverlapAndRejectsMismatches) {
+  // The second display overlaps the right half of the first.
+  const std::vector<PixelRect> layout = {PixelRect{0, 0, 64, 32},
+                                         PixelRect{32, 0, 64, 32}};
+  SyntheticDisplayBackend backend(layout);
+  std::vector<DisplayInfo> displays;
+  ASSERT_TRUE(backend.ListDisplays(&displays));
+  FramePool pool;
+  MultiDisplayCapture capture(&backend, &pool);
+  FramePool::Lease desktop = capture.CaptureDesktop(displays, false);
+  ASSERT_TRUE(desktop);
+  EXPECT_EQ(desktop->width(), 96);
+  uint8_t expected[4];
+  DesktopPixel(50, 10, expected);
+  EXPECT_EQ(std::memcmp(desktop->View().Row(10) + 50 * kBytesPerPixel,
+                        expected, sizeof(expected)),
+            0);
+
+  std::vector<uint8_t> out(96 * 32 * kBytesPerPixel);
+  const ImageView wrong_size{out.data(), 10, 10, 10 * kBytesPerPixel,
+                             PixelFormat::kBgra8};
+  EXPECT_FALSE(StitchDisplays(displays, {wrong_size, wrong_size},
+                              DesktopBounds(displays), out.data(),
+                              96 * kBytesPerPixel));
+  EXPECT_FALSE(StitchDisplays(displays, {wrong_size}, DesktopBounds(displays),
+                              out.data(), 96 * kBytesPerPixel));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "encoder_session.h"
+#include "image.h"
+#include "jpeg_encoder.h"
+#include "lz4_frame_encoder.h"
+#include "pixel_convert.h"
+#include "png_encoder.h"
+#include "qoi_encoder.h"
+#include "test/allocation_counter.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+constexpr CaptureFormat kBuiltInFormats[] = {
+    CaptureFormat::kPng,  CaptureFormat::kRawBgra, CaptureFormat::kRawRgba,
+    CaptureFormat::kQoi,  CaptureFormat::kLz4Bgra, CaptureFormat::kJpeg,
+};
+
+// What a freshly constructed encoder produces for |settings|.
+std::vector<uint8_t> EncodeFresh(const ImageView& image,
+                                 const EncodeSettings& settings,
+                                 size_t* stride) {
+  std::vector<uint8_t> out;
+  *stride = 0;
+  switch (settings.format) {
+    case CaptureFormat::kRawBgra:
+    case CaptureFormat::kRawRgba:
+      *stride = image.RowBytes();
+      out.resize(*stride * static_cast<size_t>(image.height));
+      EXPECT_TRUE(ConvertImage(image,
+                               settings.format == CaptureFormat::kRawRgba
+                                   ? PixelFormat::kRgba8
+                                   : PixelFormat::kBgra8,
+                               true, out.data(), *stride));
+      break;
+    case CaptureFormat::kQoi: {
+      QoiEncodeOptions options;
+      options.force_opaque = true;
+      EXPECT_TRUE(QoiEncoder(options).Encode(image, &out));
+      break;
+    }
+    case CaptureFormat::kLz4Bgra: {
+      Lz4FrameEncodeOptions options;
+      options.force_opaque = true;
+      options.threads = settings.threads;
+      EXPECT_TRUE(Lz4FrameEncoder(options).Encode(image, &out));
+      *stride = image.RowBytes();
+      break;
+    }
+    case CaptureFormat::kJpeg: {
+      JpegEncodeOptions options;
+      options.quality = settings.quality;
+      options.subsampling = settings.subsampling;
+      options.threads = settings.threads;
+      EXPECT_TRUE(JpegEncoder(options).Encode(image, &out));
+      break;
+    }
+    case CaptureFormat::kPng:
+    default: {
+      PngEncodeOptions options;
+      options.force_opaque = true;
+      options.threads = settings.threads;
+      EXPECT_TRUE(PngEncoder(options).Encode(image, &out));
+      break;
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(EncoderSessionTest, MatchesStandaloneEncoders) {
+  const int width = 301;
+  const int height = 97;
+  const size_t stride = static_cast<size_t>(width) * 4 + 12;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 8);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+
+  EncoderSession session;
+  for (int threads : {1, 3}) {
+    for (CaptureFormat format : kBuiltInFormats) {
+      EncodeSettings settings;
+      settings.format = format;
+      settings.quality = 70;
+      settings.subsampling = ChromaSubsampling::k444;
+      settings.threads = threads;
+      SCOPED_TRACE(static_cast<int>(format));
+      SCOPED_TRACE(threads);
+      size_t expected_stride = 0;
+      const std::vector<uint8_t> expected =
+          EncodeFresh(image, settings, &expected_stride);
+      ASSERT_TRUE(session.Encode(image, settings));
+      EXPECT_EQ(expected_stride, session.stride());
+      EXPECT_EQ(expected, std::vector<uint8_t>(session.data(),
+                                               session.data() + session.size()));
+    }
+  }
+}
+
+TEST(EncoderSessionTest, SteadyStateEncodeDoesNotAllocate) {
+  const int width = 640;
+  const int height = 360;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> first = TestPattern(width, height, stride, 1);
+  const std::vector<uint8_t> second = TestPattern(width, height, stride, 2);
+  const ImageView frames[] = {
+      {first.data(), width, height, stride, PixelFormat::kBgra8},
+      {second.data(), width, height, stride, PixelFormat::kBgra8},
+  };
+
+  for (int threads : {1, 4}) {
+    for (CaptureFormat format : kBuiltInFormats) {
+      SCOPED_TRACE(static_cast<int>(format));
+      SCOPED_TRACE(threads);
+      EncodeSettings settings;
+      settings.format = format;
+      settings.threads = threads;
+      EncoderSession session;
+      // Warm-up sizes the buffers and starts the workers.
+      ASSERT_TRUE(session.Encode(frames[0], settings));
+      ASSERT_TRUE(session.Encode(frames[1], settings));
+
+      const uint64_t before = AllocationCount();
+      for (int i = 0; i < 4; ++i) {
+        if (!session.Encode(frames[i % 2], settings)) break;
+      }
+      const uint64_t allocations = AllocationCount() - before;
+      EXPECT_EQ(0u, allocations);
+      EXPECT_NE(0u, session.size());
+    }
+  }
+}
+
+TEST(EncoderSessionTest, SwitchingFormatsKeepsEncodersWarm) {
+  const int width = 320;
+  const int height = 200;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 3);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+
+  EncoderSession session;
+  EncodeSettings settings;
+  settings.threads = 2;
+  for (int round = 0; round < 2; ++round) {
+    for (CaptureFormat format : kBuiltInFormats) {
+      settings.format = format;
+      ASSERT_TRUE(session.Encode(image, settings));
+    }
+  }
+
+  const uint64_t before = AllocationCount();
+  for (CaptureFormat format : kBuiltInFormats) {
+    settings.format = format;
+    if (!session.Encode(image, settings)) break;
+  }
+  const uint64_t allocations = AllocationCount() - before;
+  EXPECT_EQ(0u, allocations);
+}
+
+TEST(EncoderSessionTest, RejectsInvalidImages) {
+  EncoderSession session;
+  EncodeSettings settings;
+  EXPECT_FALSE(session.Encode(ImageView(), settings));
+  EXPECT_EQ(nullptr, session.data());
+  EXPECT_EQ(0u, session.size());
+
+  const std::vector<uint8_t> pixels(4 * 4 * 4, 0x80);
+  const ImageView image{pixels.data(), 4, 4, 16, PixelFormat::kBgra8};
+  ASSERT_TRUE(session.Encode(image, settings));
+  // A failure clears the previous output.
+  const ImageView bad{pixels.data(), 4, 4, 8, PixelFormat::kBgra8};
+  EXPECT_FALSE(session.Encode(bad, settings));
+  EXPECT_EQ(0u, session.size());
+}
+
+TEST(EncoderSessionTest, FormatNamesRoundTrip) {
+  for (CaptureFormat format :
+       {CaptureFormat::kPng, CaptureFormat::kRawBgra, CaptureFormat::kRawRgba,
+        CaptureFormat::kQoi, CaptureFormat::kLz4Bgra, CaptureFormat::kJpeg,
+        CaptureFormat::kWebp}) {
+    CaptureFormat parsed = CaptureFormat::kPng;
+    ASSERT_TRUE(ParseCaptureFormat(CaptureFormatName(format), &parsed));
+    EXPECT_EQ(format, parsed);
+  }
+  CaptureFormat format = CaptureFormat::kJpeg;
+  EXPECT_FALSE(ParseCaptureFormat("bmp", &format));
+  EXPECT_FALSE(ParseCaptureFormat("PNG", &format));
+  EXPECT_EQ(CaptureFormat::kJpeg, format);
+
+  ChromaSubsampling subsampling = ChromaSubsampling::k420;
+  EXPECT_TRUE(ParseChromaSubsampling("444", &subsampling));
+  EXPECT_EQ(ChromaSubsampling::k444, subsampling);
+  EXPECT_TRUE(ParseChromaSubsampling("422", &subsampling));
+  EXPECT_EQ(ChromaSubsampling::k422, subsampling);
+  EXPECT_FALSE(ParseChromaSubsampling("411", &subsampling));
+  EXPECT_EQ(ChromaSubsampling::k422, subsampling);
+}
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,310 @@
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "encoder_session.h"
+#include "file_sink.h"
+#include "image.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+#if !defined(_WIN32)
+// A fresh directory under the test temp dir, removed with its files.
+class TempDirectory {
+ public:
+  TempDirectory() {
+    std::string pattern = ::testing::TempDir() + "file_sink_XXXXXX";
+    if (mkdtemp(&pattern[0]) != nullptr) path_ = pattern;
+  }
+
+  ~TempDirectory() {
+    for (const std::string& name : Files()) {
+      unlink((path_ + "/" + name).c_str());
+    }
+    rmdir(path_.c_str());
+  }
+
+  const std::string& path() const { return path_; }
+
+  std::string File(const std::string& name) const {
+    return path_ + "/" + name;
+  }
+
+  std::vector<std::string> Files() const {
+    std::vector<std::string> names;
+    DIR* dir = opendir(path_.c_str());
+    if (dir == nullptr) return names;
+    while (const dirent* entry = readdir(dir)) {
+      const std::string name = entry->d_name;
+      if (name != "." && name != "..") names.push_back(name);
+    }
+    closedir(dir);
+    return names;
+  }
+
+ private:
+  std::string path_;
+};
+
+std::vector<uint8_t> ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file),
+                              std::istreambuf_iterator<char>());
+}
+
+void WriteWholeFile(const std::string& path, const std::vector<uint8_t>& data) {
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(data.data()),
+             static_cast<std::streamsize>(data.size()));
+}
+
+// Fails every write after the first |allowed| bytes.
+class FailingSink : public ByteSink {
+ public:
+  explicit FailingSink(size_t allowed) : allowed_(allowed) {}
+
+  bool Write(const uint8_t*, size_t size) override {
+    if (failed_) {
+      ++writes_after_failure_;
+      return false;
+    }
+    if (size > allowed_) {
+      failed_ = true;
+      return false;
+    }
+    allowed_ -= size;
+    return true;
+  }
+
+  bool failed() const { return failed_; }
+  size_t writes_after_failure() const { return writes_after_failure_; }
+
+ private:
+  size_t allowed_;
+  size_t writes_after_failure_ = 0;
+  bool failed_ = false;
+};
+
+TEST(FileSinkTest, GathersWritesOfAnySizeIntoChunks) {
+  TempDirectory dir;
+  ASSERT_FALSE(dir.path().empty());
+  const std::string path = dir.File("out.bin");
+  const std::vector<uint8_t> data = RandomBytes(10000, 4);
+
+  FileSinkOptions options;
+  options.chunk_size = 1000;
+  std::unique_ptr<FileSink> sink = FileSink::Open(path, options);
+  ASSERT_NE(sink, nullptr);
+  // Pieces smaller than, equal to and spanning several chunks.
+  size_t offset = 0;
+  for (size_t piece : {1u, 999u, 1000u, 1u, 3500u, 0u, 4499u}) {
+    ASSERT_TRUE(sink->Write(data.data() + offset, piece));
+    offset += piece;
+  }
+  ASSERT_EQ(offset, data.size());
+  EXPECT_EQ(sink->size(), data.size());
+  ASSERT_TRUE(sink->Commit());
+  EXPECT_EQ(sink->error(), 0);
+  EXPECT_EQ(ReadFile(path), data);
+}
+
+TEST(FileSinkTest, AtomicWriteReplacesTargetOnlyOnCommit) {
+  TempDirectory dir;
+  ASSERT_FALSE(dir.path().empty());
+  const std::string path = dir.File("shot.png");
+  const std::vector<uint8_t> old_contents = RandomBytes(100, 1);
+  const std::vector<uint8_t> new_contents = RandomBytes(5000, 2);
+  WriteWholeFile(path, old_contents);
+
+  std::unique_ptr<FileSink> sink = FileSink::Open(path);
+  ASSERT_NE(sink, nullptr);
+  ASSERT_TRUE(sink->Write(new_contents.data(), new_contents.size()));
+  // Until the commit, readers still see the old file.
+  EXPECT_EQ(ReadFile(path), old_contents);
+  EXPECT_EQ(dir.Files().size(), 2u);
+
+  ASSERT_TRUE(sink->Commit());
+  EXPECT_EQ(ReadFile(path), new_contents);
+  EXPECT_EQ(dir.Files(), std::vector<std::string>{"shot.png"});
+  // Committing again changes nothing.
+  EXPECT_TRUE(sink->Commit());
+  sink.reset();
+  EXPECT_EQ(ReadFile(path), new_contents);
+}
+
+TEST(FileSinkTest, AbandonedAtomicWriteLeavesTargetAlone) {
+  TempDirectory dir;
+  ASSERT_FALSE(dir.path().empty());
+  const std::string path = dir.File("shot.png");
+  const std::vector<uint8_t> old_contents = RandomBytes(100, 1);
+  WriteWholeFile(path, old_contents);
+
+  std::unique_ptr<FileSink> sink = FileSink::Open(path);
+  ASSERT_NE(sink, nullptr);
+  const std::vector<uint8_t> partial = RandomBytes(3 << 20, 3);
+  ASSERT_TRUE(sink->Write(partial.data(), partial.size()));
+  sink.reset();
+
+  EXPECT_EQ(ReadFile(path), old_contents);
+  EXPECT_EQ(dir.Files(), std::vector<std::string>{"shot.png"});
+}
+
+TEST(FileSinkTest, AbandonedDirectWriteRemovesPartialFile) {
+  TempDirectory dir;
+  ASSERT_FALSE(dir.path().empty());
+  const std::string path = dir.File("direct.bin");
+  FileSinkOptions options;
+  options.atomic = false;
+
+  std::unique_ptr<FileSink> sink = FileSink::Open(path, options);
+  ASSERT_NE(sink, nullptr);
+  const uint8_t byte = 7;
+  ASSERT_TRUE(sink->Write(&byte, 1));
+  // Written in place: the target exists before the commit.
+  EXPECT_EQ(dir.Files(), std::vector<std::string>{"direct.bin"});
+  sink.reset();
+  EXPECT_TRUE(dir.Files().empty());
+
+  sink = FileSink::Open(path, options);
+  ASSERT_NE(sink, nullptr);
+  ASSERT_TRUE(sink->Write(&byte, 1));
+  ASSERT_TRUE(sink->Commit());
+  sink.reset();
+  EXPECT_EQ(ReadFile(path), std::vector<uint8_t>{7});
+}
+
+TEST(FileSinkTest, SyncedCommitWritesEverything) {
+  TempDirectory dir;
+  ASSERT_FALSE(dir.path().empty());
+  const std::vector<uint8_t> data = RandomBytes(300000, 5);
+  for (bool atomic : {true, false}) {
+    SCOPED_TRACE(atomic);
+    const std::string path = dir.File(atomic ? "atomic" : "direct");
+    FileSinkOptions options;
+    options.sync = true;
+    options.atomic = atomic;
+    std::unique_ptr<FileSink> sink = FileSink::Open(path, options);
+    ASSERT_NE(sink, nullptr);
+    ASSERT_TRUE(sink->Write(data.data(), data.size()));
+    ASSERT_TRUE(sink->Commit());
+    EXPECT_EQ(ReadFile(path), data);
+  }
+}
+
+TEST(FileSinkTest, ReportsOpenErrors) {
+  TempDirectory dir;
+  ASSERT_FALSE(dir.path().empty());
+  int error = 0;
+  EXPECT_EQ(FileSink::Open(dir.File("missing/shot.png"), FileSinkOptions(),
+                           &error),
+            nullptr);
+  EXPECT_EQ(error, ENOENT);
+  EXPECT_EQ(FileSink::Open("", FileSinkOptions(), &error), nullptr);
+  EXPECT_EQ(error, EINVAL);
+  FileSinkOptions options;
+  options.chunk_size = 0;
+  EXPECT_EQ(FileSink::Open(dir.File("shot.png"), options, &error), nullptr);
+  EXPECT_TRUE(dir.Files().empty());
+}
+
+TEST(FileSinkTest, FailedCommitLeavesNothingBehind) {
+  TempDirectory dir;
+  ASSERT_FALSE(dir.path().empty());
+  // The rename fails: the target is a non-empty directory.
+  const std::string path = dir.File("taken");
+  ASSERT_EQ(mkdir(path.c_str(), 0700), 0);
+  const std::string blocker = path + "/file";
+  WriteWholeFile(blocker, {1});
+
+  std::unique_ptr<FileSink> sink = FileSink::Open(path);
+  ASSERT_NE(sink, nullptr);
+  const uint8_t byte = 1;
+  ASSERT_TRUE(sink->Write(&byte, 1));
+  EXPECT_FALSE(sink->Commit());
+  EXPECT_NE(sink->error(), 0);
+  EXPECT_FALSE(sink->Write(&byte, 1));
+  sink.reset();
+  EXPECT_EQ(dir.Files(), std::vector<std::string>{"taken"});
+  unlink(blocker.c_str());
+  rmdir(path.c_str());
+}
+
+TEST(FileSinkTest, StreamsEncodedCapturesToDisk) {
+  TempDirectory dir;
+  ASSERT_FALSE(dir.path().empty());
+  const int width = 700;
+  const int height = 520;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 6);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+
+  EncoderSession session;
+  for (CaptureFormat format : {CaptureFormat::kRawBgra, CaptureFormat::kQoi,
+                               CaptureFormat::kLz4Bgra,
+                               CaptureFormat::kJpeg}) {
+    SCOPED_TRACE(static_cast<int>(format));
+    EncodeSettings settings;
+    settings.format = format;
+    settings.threads = 2;
+    const std::string path = dir.File("capture");
+    std::unique_ptr<FileSink> sink = FileSink::Open(path);
+    ASSERT_NE(sink, nullptr);
+    ASSERT_TRUE(session.Encode(image, settings, sink.get()));
+    ASSERT_TRUE(sink->Commit());
+    EXPECT_EQ(session.data(), nullptr);
+    EXPECT_EQ(session.size(), sink->size());
+
+    const size_t streamed_stride = session.stride();
+    ASSERT_TRUE(session.Encode(image, settings));
+    EXPECT_EQ(streamed_stride, session.stride());
+    EXPECT_EQ(ReadFile(path),
+              std::vector<uint8_t>(session.data(),
+                                   session.data() + session.size()));
+  }
+}
+
+TEST(FileSinkTest, EncodersStopAtTheFirstFailedWrite) {
+  const int width = 640;
+  const int height = 480;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 7);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  EncoderSession session;
+  for (CaptureFormat format :
+       {CaptureFormat::kPng, CaptureFormat::kRawRgba, CaptureFormat::kQoi,
+        CaptureFormat::kLz4Bgra, CaptureFormat::kJpeg}) {
+    SCOPED_TRACE(static_cast<int>(format));
+    EncodeSettings settings;
+    settings.format = format;
+    for (size_t allowed : {size_t{0}, size_t{40}, size_t{70000}}) {
+      FailingSink sink(allowed);
+      EXPECT_FALSE(session.Encode(image, settings, &sink));
+      EXPECT_EQ(session.size(), 0u);
+      EXPECT_TRUE(sink.failed());
+      EXPECT_EQ(sink.writes_after_failure(), 0u);
+    }
+  }
+}
+#endif
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "frame_diff.h"
+#include "image.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+// Packed BGRA frame with a stride, so tests can mutate pixels in place.
+struct Frame {
+  Frame(int w, int h, uint32_t seed)
+      : width(w),
+        height(h),
+        stride(static_cast<size_t>(w) * 4 + 8),
+        pixels(TestPattern(w, h, stride, seed)) {}
+
+  ImageView View() const {
+    return ImageView{pixels.data(), width, height, stride,
+                     PixelFormat::kBgra8};
+  }
+
+  uint8_t* At(int x, int y) {
+    return pixels.data() + static_cast<size_t>(y) * stride +
+           static_cast<size_t>(x) * 4;
+  }
+
+  int width;
+  int height;
+  size_t stride;
+  std::vector<uint8_t> pixels;
+};
+
+bool Contains(const FrameDiff& diff, int x, int y) {
+  for (const TileRect& tile : diff.tiles) {
+    if (tile.x == x && tile.y == y) return true;
+  }
+  return false;
+}
+
+// Copies the listed tiles of |frame| into the packed |canvas|.
+void ApplyTiles(const FrameDiff& diff, const ImageView& frame,
+                std::vector<uint8_t>* canvas) {
+  const size_t canvas_stride = frame.RowBytes();
+  for (const TileRect& tile : diff.tiles) {
+    for (int y = tile.y; y < tile.y + tile.height; ++y) {
+      std::memcpy(canvas->data() + static_cast<size_t>(y) * canvas_stride +
+                      static_cast<size_t>(tile.x) * 4,
+                  frame.Row(y) + static_cast<size_t>(tile.x) * 4,
+                  static_cast<size_t>(tile.width) * 4);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(FrameDiffTest, FirstFrameIsAKeyframeWithClippedEdgeTiles) {
+  Frame frame(150, 70, 1);
+  FrameDiffer differ;
+  FrameDiff diff;
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  EXPECT_TRUE(diff.keyframe);
+  ASSERT_EQ(6u, diff.tiles.size());  // 3 x 2 tiles of 64
+  const TileRect& last = diff.tiles.back();
+  EXPECT_EQ(128, last.x);
+  EXPECT_EQ(64, last.y);
+  EXPECT_EQ(22, last.width);
+  EXPECT_EQ(6, last.height);
+}
+
+TEST(FrameDiffTest, IdenticalFrameHasNoTiles) {
+  Frame frame(200, 130, 2);
+  FrameDiffer differ;
+  FrameDiff diff;
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  EXPECT_FALSE(diff.keyframe);
+  EXPECT_TRUE(diff.tiles.empty());
+}
+
+TEST(FrameDiffTest, ReportsOnlyChangedTiles) {
+  Frame frame(300, 200, 3);
+  FrameDiffer differ;
+  FrameDiff diff;
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+
+  frame.At(70, 10)[1] ^= 0x40;    // tile (64, 0)
+  frame.At(299, 199)[0] ^= 0x01;  // last pixel, clipped tile (256, 192)
+  frame.At(127, 127)[2] ^= 0x80;  // tile (64, 64), last pixel of the tile
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  EXPECT_FALSE(diff.keyframe);
+  ASSERT_EQ(3u, diff.tiles.size());
+  EXPECT_TRUE(Contains(diff, 64, 0));
+  EXPECT_TRUE(Contains(diff, 64, 64));
+  EXPECT_TRUE(Contains(diff, 256, 192));
+  // Row-major order.
+  EXPECT_EQ(0, diff.tiles[0].y);
+  EXPECT_EQ(192, diff.tiles[2].y);
+  EXPECT_EQ(44, diff.tiles[2].width);
+  EXPECT_EQ(8, diff.tiles[2].height);
+
+  // The changes are now part of the reference.
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  EXPECT_TRUE(diff.tiles.empty());
+}
+
+TEST(FrameDiffTest, AlphaIsIgnoredUnlessRequested) {
+  Frame frame(64, 64, 4);
+  FrameDiffer differ;
+  FrameDiff diff;
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  frame.At(5, 5)[3] ^= 0xFF;
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  EXPECT_TRUE(diff.tiles.empty());
+
+  FrameDiffOptions options;
+  options.ignore_alpha = false;
+  differ.set_options(options);
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  EXPECT_TRUE(diff.keyframe);
+  frame.At(5, 5)[3] ^= 0xFF;
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  EXPECT_EQ(1u, diff.tiles.size());
+}
+
+TEST(FrameDiffTest, KeyframeOnRequestSizeChangeAndReset) {
+  Frame frame(128, 128, 5);
+  FrameDiffer differ;
+  FrameDiff diff;
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  ASSERT_TRUE(differ.Diff(frame.View(), true, &diff));
+  EXPECT_TRUE(diff.keyframe);
+  EXPECT_EQ(4u, diff.tiles.size());
+
+  Frame smaller(100, 128, 5);
+  ASSERT_TRUE(differ.Diff(smaller.View(), false, &diff));
+  EXPECT_TRUE(diff.keyframe);
+  EXPECT_EQ(100, differ.reference().width);
+
+  differ.Reset();
+  EXPECT_FALSE(differ.reference().IsValid());
+  ASSERT_TRUE(differ.Diff(smaller.View(), false, &diff));
+  EXPECT_TRUE(diff.keyframe);
+
+  EXPECT_FALSE(differ.Diff(ImageView(), false, &diff));
+  EXPECT_TRUE(diff.tiles.empty());
+  ASSERT_TRUE(differ.Diff(smaller.View(), false, &diff));
+  EXPECT_TRUE(diff.keyframe);
+}
+
+TEST(FrameDiffTest, CustomTileSize) {
+  Frame frame(100, 50, 6);
+  FrameDiffOptions options;
+  options.tile_size = 16;
+  FrameDiffer differ(options);
+  FrameDiff diff;
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  EXPECT_EQ(7u * 4u, diff.tiles.size());
+  frame.At(33, 49)[0] ^= 1;
+  ASSERT_TRUE(differ.Diff(frame.View(), false, &diff));
+  ASSERT_EQ(1u, diff.tiles.size());
+  EXPECT_EQ(32, diff.tiles[0].x);
+  EXPECT_EQ(48, diff.tiles[0].y);
+  EXPECT_EQ(2, diff.tiles[0].height);
+}
+
+// Applying each diff to a canvas must reproduce every frame of a synthetic
+// sequence, for every kernel and thread count.
+TEST(FrameDiffTest, AppliedDiffsReconstructSequence) {
+  const int width = 517;
+  const int height = 301;
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    for (int threads : {1, 3}) {
+      FrameDiffOptions options;
+      options.threads = threads;
+      options.ignore_alpha = false;
+      FrameDiffer differ(options);
+      Frame frame(width, height, 7);
+      std::vector<uint8_t> canvas(static_cast<size_t>(width) * height * 4);
+      const std::vector<uint8_t> noise = RandomBytes(4096, 8);
+      FrameDiff diff;
+      for (int step = 0; step < 12; ++step) {
+        // Scatter a few edits: single bytes, a "typed" run and a block.
+        for (int i = 0; i < 5; ++i) {
+          const size_t n = static_cast<size_t>(step * 5 + i) * 3;
+          const int x = (noise[n] * 7 + noise[n + 1]) % width;
+          const int y = (noise[n + 2] * 3 + step) % height;
+          frame.At(x, y)[i % 4] ^= static_cast<uint8_t>(1 + step);
+        }
+        for (int x = step * 9; x < step * 9 + 40 && x < width; ++x) {
+          frame.At(x, 200)[0] ^= 0x10;
+        }
+        ASSERT_TRUE(differ.Diff(frame.View(), step == 6, &diff));
+        EXPECT_EQ(step == 0 || step == 6, diff.keyframe);
+        ApplyTiles(diff, frame.View(), &canvas);
+        for (int y = 0; y < height; ++y) {
+          ASSERT_EQ(0, std::memcmp(canvas.data() + static_cast<size_t>(y) *
+                                                       width * 4,
+                                   frame.At(0, y),
+                                   static_cast<size_t>(width) * 4))
+              << "step " << step << " row " << y;
+        }
+        if (!diff.keyframe) {
+          EXPECT_LT(diff.tiles.size(), 12u) << "step " << step;
+        }
+      }
+    }
+  }
+}
+
+TEST(FrameDiffTest, PixelsEqualKernelsAgree) {
+  std::vector<uint8_t> a = RandomBytes(4 * 301, 9);
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    for (size_t pixels : {0u, 1u, 7u, 8u, 31u, 32u, 33u, 301u}) {
+      for (size_t at = 0; at < pixels; at += 5) {
+        std::vector<uint8_t> b = a;
+        EXPECT_TRUE(PixelsEqual(a.data(), b.data(), pixels, false));
+        b[at * 4 + 3] ^= 0x01;
+        EXPECT_TRUE(PixelsEqual(a.data(), b.data(), pixels, true));
+        EXPECT_FALSE(PixelsEqual(a.data(), b.data(), pixels, false));
+        b[at * 4 + 2] ^= 0x01;
+        EXPECT_FALSE(PixelsEqual(a.data(), b.data(), pixels, true))
+            << pixels << " pixels, difference at " << at;
+      }
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "frame_mailbox.h"
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+// Fills |frame| with a pattern derived from |sequence|.
+void Fill(StreamFrame* frame, uint64_t sequence) {
+  frame->width = 16;
+  frame->height = 4;
+  frame->stride = 64;
+  frame->pixels.resize(256);
+  for (size_t i = 0; i < frame->pixels.size(); ++i) {
+    frame->pixels[i] = static_cast<uint8_t>(sequence * 31 + i);
+  }
+  frame->sequence = sequence;
+}
+
+bool Matches(const StreamFrame& frame) {
+  for (size_t i = 0; i < frame.pixels.size(); ++i) {
+    if (frame.pixels[i] != static_cast<uint8_t>(frame.sequence * 31 + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(FrameMailboxTest, HandsOverTheNewestFrame) {
+  FrameMailbox mailbox;
+  EXPECT_FALSE(mailbox.HasFrame());
+  EXPECT_EQ(nullptr, mailbox.Acquire());
+
+  Fill(mailbox.back(), 0);
+  EXPECT_FALSE(mailbox.Publish());
+  EXPECT_TRUE(mailbox.HasFrame());
+  StreamFrame* frame = mailbox.Acquire();
+  ASSERT_NE(nullptr, frame);
+  EXPECT_EQ(0u, frame->sequence);
+  EXPECT_TRUE(Matches(*frame));
+  EXPECT_EQ(nullptr, mailbox.Acquire());
+
+  // The producer never writes into the frame the consumer holds.
+  EXPECT_NE(frame, mailbox.back());
+}
+
+TEST(FrameMailboxTest, DropsOldestWhenConsumerFallsBehind) {
+  FrameMailbox mailbox;
+  for (uint64_t sequence = 0; sequence < 5; ++sequence) {
+    Fill(mailbox.back(), sequence);
+    EXPECT_EQ(sequence > 0, mailbox.Publish()) << sequence;
+  }
+  StreamFrame* frame = mailbox.Acquire();
+  ASSERT_NE(nullptr, frame);
+  EXPECT_EQ(4u, frame->sequence);
+  EXPECT_TRUE(Matches(*frame));
+  EXPECT_EQ(nullptr, mailbox.Acquire());
+}
+
+TEST(FrameMailboxTest, BuffersAreReusedAfterWarmUp) {
+  FrameMailbox mailbox;
+  const uint8_t* seen[3] = {};
+  for (uint64_t sequence = 0; sequence < 30; ++sequence) {
+    Fill(mailbox.back(), sequence);
+    mailbox.Publish();
+    StreamFrame* frame = mailbox.Acquire();
+    ASSERT_NE(nullptr, frame);
+    if (sequence < 3) {
+      seen[sequence] = frame->pixels.data();
+    } else {
+      const uint8_t* data = frame->pixels.data();
+      EXPECT_TRUE(data == seen[0] || data == seen[1] || data == seen[2]);
+    }
+  }
+}
+
+// One producer and one consumer at full speed: the consumer sees strictly
+// increasing sequences, never a torn frame, and every frame is either
+// delivered or reported dropped.
+TEST(FrameMailboxTest, ConcurrentProducerAndConsumer) {
+  constexpr uint64_t kFrames = 20000;
+  FrameMailbox mailbox;
+  std::atomic<bool> done{false};
+  uint64_t dropped = 0;
+  std::thread producer([&] {
+    for (uint64_t sequence = 0; sequence < kFrames; ++sequence) {
+      Fill(mailbox.back(), sequence);
+      if (mailbox.Publish()) ++dropped;
+    }
+    done = true;
+  });
+
+  uint64_t delivered = 0;
+  uint64_t last = 0;
+  bool ordered = true;
+  bool intact = true;
+  for (;;) {
+    const bool finished = done.load();
+    StreamFrame* frame = mailbox.Acquire();
+    if (frame) {
+      if (delivered > 0 && frame->sequence <= last) ordered = false;
+      if (!Matches(*frame)) intact = false;
+      last = frame->sequence;
+      ++delivered;
+    } else if (finished) {
+      break;
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(ordered);
+  EXPECT_TRUE(intact);
+  EXPECT_EQ(kFrames - 1, last);
+  EXPECT_EQ(kFrames, delivered + dropped);
+}
+
+}  // namespace test
+}  // namespace screenshot
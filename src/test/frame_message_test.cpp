@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "encoder_session.h"
+#include "frame_message.h"
+#include "image.h"
+#include "pixel_convert.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+TEST(FrameMessageTest, HeaderRoundTrips) {
+  FrameMessageHeader header;
+  header.kind = FrameMessageKind::kFrame;
+  header.format = CaptureFormat::kLz4Bgra;
+  header.width = 3840;
+  header.height = 2160;
+  header.stride = 3840 * 4;
+  header.sequence = 0x0123456789ABCDEFull;
+  header.timestamp_us = -42;
+  std::vector<uint8_t> message;
+  uint8_t* payload = StartFrameMessage(header, 5, &message);
+  ASSERT_EQ(message.size(), kFrameMessageHeaderSize + 5);
+  EXPECT_EQ(payload, message.data() + kFrameMessageHeaderSize);
+
+  FrameMessageHeader read;
+  size_t offset = 0;
+  ASSERT_TRUE(ReadFrameMessageHeader(message.data(), message.size(), &read,
+                                     &offset));
+  EXPECT_EQ(offset, kFrameMessageHeaderSize);
+  EXPECT_EQ(read.kind, header.kind);
+  EXPECT_EQ(read.format, header.format);
+  EXPECT_EQ(read.width, header.width);
+  EXPECT_EQ(read.height, header.height);
+  EXPECT_EQ(read.stride, header.stride);
+  EXPECT_EQ(read.sequence, header.sequence);
+  EXPECT_EQ(read.timestamp_us, header.timestamp_us);
+}
+
+TEST(FrameMessageTest, LayoutIsLittleEndian) {
+  FrameMessageHeader header;
+  header.kind = FrameMessageKind::kNull;
+  header.format = CaptureFormat::kJpeg;
+  header.width = 0x01020304;
+  header.sequence = 7;
+  std::vector<uint8_t> message;
+  StartFrameMessage(header, 0, &message);
+  ASSERT_EQ(message.size(), kFrameMessageHeaderSize);
+  EXPECT_EQ(message[0], 'S');
+  EXPECT_EQ(message[1], 'S');
+  EXPECT_EQ(message[2], 'F');
+  EXPECT_EQ(message[3], 'M');
+  EXPECT_EQ(message[4], 1);  // kNull
+  EXPECT_EQ(message[5], 5);  // kJpeg
+  EXPECT_EQ(message[6], kFrameMessageHeaderSize);
+  EXPECT_EQ(message[7], 0);
+  EXPECT_EQ(message[8], 0x04);
+  EXPECT_EQ(message[11], 0x01);
+  EXPECT_EQ(message[24], 7);
+}
+
+TEST(FrameMessageTest, ReaderSkipsLongerHeaders) {
+  std::vector<uint8_t> message;
+  StartFrameMessage(FrameMessageHeader(), 0, &message);
+  message[6] = 48;
+  message.resize(48 + 3, 0xAB);
+  FrameMessageHeader header;
+  size_t offset = 0;
+  ASSERT_TRUE(
+      ReadFrameMessageHeader(message.data(), message.size(), &header, &offset));
+  EXPECT_EQ(offset, 48u);
+}
+
+TEST(FrameMessageTest, RejectsMalformedHeaders) {
+  std::vector<uint8_t> valid;
+  StartFrameMessage(FrameMessageHeader(), 0, &valid);
+  FrameMessageHeader header;
+  size_t offset = 0;
+
+  EXPECT_FALSE(ReadFrameMessageHeader(valid.data(), valid.size() - 1, &header,
+                                      &offset));
+  std::vector<uint8_t> message = valid;
+  message[0] = 'X';
+  EXPECT_FALSE(ReadFrameMessageHeader(message.data(), message.size(), &header,
+                                      &offset));
+  message = valid;
+  message[4] = 3;
+  EXPECT_FALSE(ReadFrameMessageHeader(message.data(), message.size(), &header,
+                                      &offset));
+  message = valid;
+  message[5] = 7;
+  EXPECT_FALSE(ReadFrameMessageHeader(message.data(), message.size(), &header,
+                                      &offset));
+  message = valid;
+  message[6] = 16;
+  EXPECT_FALSE(ReadFrameMessageHeader(message.data(), message.size(), &header,
+                                      &offset));
+  message = valid;
+  message[6] = 64;
+  EXPECT_FALSE(ReadFrameMessageHeader(message.data(), message.size(), &header,
+                                      &offset));
+}
+
+TEST(FrameMessageTest, CarriesRawPixelsAfterTheHeader) {
+  const int width = 37;
+  const int height = 11;
+  const size_t stride = 37 * 4 + 12;
+  const std::vector<uint8_t> screen = TestPattern(width, height, stride, 3);
+  const ImageView image{screen.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  EncoderSession session;
+  for (CaptureFormat format : {CaptureFormat::kRawBgra,
+                               CaptureFormat::kRawRgba}) {
+    EncodeSettings settings;
+    settings.format = format;
+    std::vector<uint8_t> message;
+    ASSERT_TRUE(
+        EncodeFrameMessage(&session, image, settings, 9, 1234, &message));
+
+    FrameMessageHeader header;
+    size_t offset = 0;
+    ASSERT_TRUE(ReadFrameMessageHeader(message.data(), message.size(),
+                                       &header, &offset));
+    EXPECT_EQ(header.kind, FrameMessageKind::kFrame);
+    EXPECT_EQ(header.format, format);
+    EXPECT_EQ(header.width, static_cast<uint32_t>(width));
+    EXPECT_EQ(header.height, static_cast<uint32_t>(height));
+    EXPECT_EQ(header.stride, width * 4u);
+    EXPECT_EQ(header.sequence, 9u);
+    EXPECT_EQ(header.timestamp_us, 1234);
+
+    ASSERT_TRUE(session.Encode(image, settings));
+    EXPECT_EQ(std::vector<uint8_t>(message.begin() +
+                                       static_cast<std::ptrdiff_t>(offset),
+                                   message.end()),
+              std::vector<uint8_t>(session.data(),
+                                   session.data() + session.size()));
+  }
+}
+
+TEST(FrameMessageTest, CarriesEncodedBytesAfterTheHeader) {
+  const int width = 64;
+  const int height = 40;
+  const size_t stride = 64 * 4;
+  const std::vector<uint8_t> screen = TestPattern(width, height, stride, 5);
+  const ImageView image{screen.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  for (CaptureFormat format : {CaptureFormat::kPng, CaptureFormat::kQoi,
+                               CaptureFormat::kLz4Bgra, CaptureFormat::kJpeg}) {
+    EncodeSettings settings;
+    settings.format = format;
+    EncoderSession session;
+    std::vector<uint8_t> message;
+    ASSERT_TRUE(
+        EncodeFrameMessage(&session, image, settings, 0, 0, &message));
+    // The session still holds the encoded bytes that were copied in.
+    ASSERT_EQ(message.size(), kFrameMessageHeaderSize + session.size());
+    EXPECT_EQ(std::vector<uint8_t>(
+                  message.begin() +
+                      static_cast<std::ptrdiff_t>(kFrameMessageHeaderSize),
+                  message.end()),
+              std::vector<uint8_t>(session.data(),
+                                   session.data() + session.size()));
+
+    FrameMessageHeader header;
+    size_t offset = 0;
+    ASSERT_TRUE(ReadFrameMessageHeader(message.data(), message.size(),
+                                       &header, &offset));
+    EXPECT_EQ(header.format, format);
+    EXPECT_EQ(header.stride, static_cast<uint32_t>(session.stride()));
+  }
+}
+
+TEST(FrameMessageTest, RejectsInvalidImages) {
+  EncoderSession session;
+  std::vector<uint8_t> message(3);
+  EXPECT_FALSE(EncodeFrameMessage(&session, ImageView(), EncodeSettings(), 0,
+                                  0, &message));
+  EXPECT_TRUE(message.empty());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "frame_pool.h"
+#include "image.h"
+#include "test/allocation_counter.h"
+
+namespace screenshot {
+namespace test {
+
+TEST(FramePoolTest, ReusesReleasedBufferWithTheSameKey) {
+  FramePool pool;
+  uint8_t* first = nullptr;
+  {
+    FramePool::Lease lease = pool.Acquire(320, 200, PixelFormat::kBgra8);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(320, lease->width());
+    EXPECT_EQ(200, lease->height());
+    EXPECT_EQ(320u * 4, lease->stride());
+    EXPECT_EQ(320u * 4 * 200, lease->size());
+    std::memset(lease->data(), 0x5A, lease->size());
+    first = lease->data();
+  }
+  FramePool::Lease again = pool.Acquire(320, 200, PixelFormat::kBgra8);
+  ASSERT_TRUE(again);
+  EXPECT_EQ(first, again->data());
+  // Contents are not cleared between leases.
+  EXPECT_EQ(0x5A, again->data()[again->size() - 1]);
+
+  const FramePoolStats stats = pool.stats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.buffers);
+  EXPECT_EQ(again->size(), stats.resident_bytes);
+  EXPECT_EQ(again->size(), stats.leased_bytes);
+}
+
+TEST(FramePoolTest, KeysOnDimensionsAndFormat) {
+  FramePool pool;
+  pool.Acquire(64, 32, PixelFormat::kBgra8).Reset();
+  EXPECT_TRUE(pool.Acquire(32, 64, PixelFormat::kBgra8));
+  EXPECT_TRUE(pool.Acquire(64, 32, PixelFormat::kRgba8));
+  EXPECT_TRUE(pool.Acquire(64, 32, PixelFormat::kBgra8));
+  const FramePoolStats stats = pool.stats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(3u, stats.misses);
+  EXPECT_EQ(3u, stats.buffers);
+  EXPECT_EQ(0u, stats.leased_bytes);
+}
+
+TEST(FramePoolTest, ConcurrentLeasesGetDistinctBuffers) {
+  FramePool pool;
+  FramePool::Lease a = pool.Acquire(16, 16, PixelFormat::kBgra8);
+  FramePool::Lease b = pool.Acquire(16, 16, PixelFormat::kBgra8);
+  ASSERT_TRUE(a && b);
+  EXPECT_NE(a->data(), b->data());
+  EXPECT_EQ(2u, pool.stats().misses);
+}
+
+TEST(FramePoolTest, BuffersAreAligned) {
+  FramePool pool;
+  std::vector<FramePool::Lease> leases;
+  for (int width : {1, 3, 17, 333, 1921}) {
+    leases.push_back(pool.Acquire(width, 7, PixelFormat::kBgra8));
+    ASSERT_TRUE(leases.back());
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(leases.back()->data()) %
+                      FramePool::kAlignment)
+        << width;
+  }
+}
+
+TEST(FramePoolTest, EvictsLeastRecentlyReleasedOverTheCap) {
+  // Three differently shaped buffers of the same size; the cap holds two.
+  const size_t frame = 64 * 64 * 4;
+  FramePool pool(frame * 2 + frame / 2);
+  FramePool::Lease a = pool.Acquire(64, 64, PixelFormat::kBgra8);
+  FramePool::Lease b = pool.Acquire(32, 128, PixelFormat::kBgra8);
+  FramePool::Lease c = pool.Acquire(128, 32, PixelFormat::kBgra8);
+  // Leased buffers are never evicted, even over the cap.
+  EXPECT_EQ(frame * 3, pool.stats().resident_bytes);
+
+  a.Reset();
+  b.Reset();
+  c.Reset();
+  FramePoolStats stats = pool.stats();
+  EXPECT_EQ(1u, stats.evictions);
+  EXPECT_EQ(frame * 2, stats.resident_bytes);
+
+  // |a| was released first, so it went; |b| and |c| are still there.
+  EXPECT_TRUE(pool.Acquire(32, 128, PixelFormat::kBgra8));
+  EXPECT_TRUE(pool.Acquire(128, 32, PixelFormat::kBgra8));
+  stats = pool.stats();
+  EXPECT_EQ(2u, stats.hits);
+  EXPECT_TRUE(pool.Acquire(64, 64, PixelFormat::kBgra8));
+  EXPECT_EQ(4u, pool.stats().misses);
+}
+
+TEST(FramePoolTest, MissEvictsIdleBuffersToMakeRoom) {
+  const size_t frame = 64 * 64 * 4;
+  FramePool pool(frame * 2);
+  pool.Acquire(64, 64, PixelFormat::kBgra8).Reset();
+  pool.Acquire(32, 128, PixelFormat::kBgra8).Reset();
+  EXPECT_EQ(frame * 2, pool.stats().resident_bytes);
+  FramePool::Lease lease = pool.Acquire(128, 32, PixelFormat::kBgra8);
+  const FramePoolStats stats = pool.stats();
+  EXPECT_EQ(1u, stats.evictions);
+  EXPECT_EQ(frame * 2, stats.resident_bytes);
+}
+
+TEST(FramePoolTest, CapAndTrimFreeIdleBuffers) {
+  FramePool pool;
+  FramePool::Lease kept = pool.Acquire(100, 100, PixelFormat::kBgra8);
+  pool.Acquire(50, 50, PixelFormat::kBgra8).Reset();
+  pool.Acquire(60, 60, PixelFormat::kBgra8).Reset();
+  EXPECT_EQ(3u, pool.stats().buffers);
+
+  pool.set_max_bytes(kept->size() + 60 * 60 * 4);
+  EXPECT_EQ(pool.stats().resident_bytes, kept->size() + 60 * 60 * 4);
+  pool.Trim();
+  FramePoolStats stats = pool.stats();
+  EXPECT_EQ(1u, stats.buffers);
+  EXPECT_EQ(kept->size(), stats.resident_bytes);
+
+  // With no room at all, a buffer lives only while it is leased.
+  pool.set_max_bytes(0);
+  kept.Reset();
+  stats = pool.stats();
+  EXPECT_EQ(0u, stats.buffers);
+  EXPECT_EQ(0u, stats.resident_bytes);
+}
+
+TEST(FramePoolTest, RejectsInvalidDimensions) {
+  FramePool pool;
+  EXPECT_FALSE(pool.Acquire(0, 10, PixelFormat::kBgra8));
+  EXPECT_FALSE(pool.Acquire(10, -1, PixelFormat::kBgra8));
+  EXPECT_EQ(0u, pool.stats().misses);
+}
+
+TEST(FramePoolTest, LeasesMoveOwnership) {
+  FramePool pool;
+  FramePool::Lease a = pool.Acquire(8, 8, PixelFormat::kBgra8);
+  FramePool::Lease b = std::move(a);
+  EXPECT_FALSE(a);
+  ASSERT_TRUE(b);
+  EXPECT_EQ(b->size(), pool.stats().leased_bytes);
+  b = FramePool::Lease();
+  EXPECT_EQ(0u, pool.stats().leased_bytes);
+}
+
+TEST(FramePoolTest, SteadyStateAcquireDoesNotAllocate) {
+  FramePool pool;
+  pool.Acquire(1920, 1080, PixelFormat::kBgra8).Reset();
+  const uint64_t before = AllocationCount();
+  for (int i = 0; i < 10; ++i) {
+    FramePool::Lease lease = pool.Acquire(1920, 1080, PixelFormat::kBgra8);
+    if (!lease) break;
+    lease->data()[0] = static_cast<uint8_t>(i);
+  }
+  const uint64_t allocations = AllocationCount() - before;
+  EXPECT_EQ(0u, allocations);
+  EXPECT_EQ(10u, pool.stats().hits);
+}
+
+TEST(FramePoolTest, IsSafeToShareBetweenThreads) {
+  FramePool pool(64 * 64 * 4 * 3);
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool, &failures, t] {
+      for (int i = 0; i < 500; ++i) {
+        const int width = 32 + ((i + t) % 3) * 16;
+        FramePool::Lease lease = pool.Acquire(width, 64, PixelFormat::kBgra8);
+        if (!lease) {
+          failures.fetch_add(1);
+          continue;
+        }
+        std::memset(lease->data(), t, lease->size());
+        for (size_t j = 0; j < lease->size(); j += 97) {
+          if (lease->data()[j] != t) failures.fetch_add(1);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(0, failures.load());
+  const FramePoolStats stats = pool.stats();
+  EXPECT_EQ(2000u, stats.hits + stats.misses);
+  EXPECT_EQ(0u, stats.leased_bytes);
+  EXPECT_LE(stats.resident_bytes, pool.max_bytes());
+}
+
+}  // namespace test
+}  // namespace screenshot
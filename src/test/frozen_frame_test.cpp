@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "encoder_session.h"
+#include "frame_pool.h"
+#include "frozen_frame.h"
+#include "image.h"
+#include "image_rect.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+// A pooled |width| x |height| frame filled with TestPattern().
+FramePool::Lease SyntheticFrame(FramePool* pool, int width, int height,
+                                uint32_t seed) {
+  FramePool::Lease frame = pool->Acquire(width, height, PixelFormat::kBgra8);
+  if (!frame) return frame;
+  const std::vector<uint8_t> pixels =
+      TestPattern(width, height, frame->stride(), seed);
+  std::memcpy(frame->data(), pixels.data(), frame->size());
+  return frame;
+}
+
+TEST(FrozenFrameTest, CropsInTheCoordinatesItWasCapturedIn) {
+  FramePool pool;
+  FramePool::Lease lease = SyntheticFrame(&pool, 320, 200, 1);
+  ASSERT_TRUE(lease);
+  const uint8_t* pixels = lease->data();
+  // As if captured from a display left of the primary one.
+  const FrozenFrame frame(std::move(lease), -320, 0, 1234);
+  ASSERT_TRUE(frame);
+  EXPECT_EQ(frame.bounds(), (PixelRect{-320, 0, 320, 200}));
+  EXPECT_EQ(frame.timestamp_us(), 1234);
+  EXPECT_EQ(frame.View().data, pixels);
+
+  ImageView crop;
+  ASSERT_TRUE(frame.Crop(PixelRect{-300, 10, 100, 50}, &crop));
+  EXPECT_EQ(crop.data, pixels + 10 * 320 * kBytesPerPixel + 20 * kBytesPerPixel);
+  EXPECT_EQ(crop.width, 100);
+  EXPECT_EQ(crop.height, 50);
+  EXPECT_EQ(crop.stride, 320u * kBytesPerPixel);
+
+  // A selection dragged past the frame's edge is clipped to it.
+  ASSERT_TRUE(frame.Crop(PixelRect{-50, 150, 200, 200}, &crop));
+  EXPECT_EQ(crop.width, 50);
+  EXPECT_EQ(crop.height, 50);
+  EXPECT_FALSE(frame.Crop(PixelRect{0, 0, 10, 10}, &crop));
+}
+
+TEST(FrozenFrameTest, ReturnsItsBufferToThePool) {
+  FramePool pool;
+  FrozenFrame frame(SyntheticFrame(&pool, 64, 64, 2), 0, 0, 0);
+  ASSERT_TRUE(frame);
+  EXPECT_GT(pool.stats().leased_bytes, 0u);
+
+  FrozenFrame moved = std::move(frame);
+  EXPECT_TRUE(moved);
+  EXPECT_FALSE(frame);
+  EXPECT_GT(pool.stats().leased_bytes, 0u);
+
+  moved.Reset();
+  EXPECT_FALSE(moved);
+  EXPECT_EQ(pool.stats().leased_bytes, 0u);
+  EXPECT_TRUE(moved.bounds().IsEmpty());
+  EXPECT_FALSE(moved.View().IsValid());
+  ImageView crop;
+  EXPECT_FALSE(moved.Crop(PixelRect{0, 0, 8, 8}, &crop));
+}
+
+// A crop goes straight into the encoders: the bytes match encoding a packed
+// copy of the same pixels.
+TEST(FrozenFrameTest, CropsEncodeLikePackedCopies) {
+  FramePool pool;
+  const int width = 500;
+  const int height = 300;
+  const FrozenFrame frame(SyntheticFrame(&pool, width, height, 3), 0, 0, 0);
+  ASSERT_TRUE(frame);
+  const PixelRect selection{37, 21, 203, 150};
+  ImageView crop;
+  ASSERT_TRUE(frame.Crop(selection, &crop));
+
+  std::vector<uint8_t> packed(static_cast<size_t>(selection.width) *
+                              kBytesPerPixel *
+                              static_cast<size_t>(selection.height));
+  for (int y = 0; y < selection.height; ++y) {
+    std::memcpy(&packed[static_cast<size_t>(y) * crop.RowBytes()], crop.Row(y),
+                crop.RowBytes());
+  }
+  const ImageView copy{packed.data(), selection.width, selection.height,
+                       crop.RowBytes(), PixelFormat::kBgra8};
+
+  EncoderSession session;
+  for (CaptureFormat format : {CaptureFormat::kPng, CaptureFormat::kQoi,
+                               CaptureFormat::kLz4Bgra, CaptureFormat::kJpeg}) {
+    SCOPED_TRACE(static_cast<int>(format));
+    EncodeSettings settings;
+    settings.format = format;
+    ASSERT_TRUE(session.Encode(crop, settings));
+    const std::vector<uint8_t> from_crop(session.data(),
+                                         session.data() + session.size());
+    ASSERT_TRUE(session.Encode(copy, settings));
+    EXPECT_EQ(from_crop, std::vector<uint8_t>(session.data(),
+                                              session.data() + session.size()));
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,244 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "checksum.h"
+#include "cpu_features.h"
+#include "image.h"
+#include "image_hash.h"
+#include "image_rect.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+struct Xxh3Vector {
+  size_t len;
+  uint64_t hash;
+};
+
+// XXH3_64bits() of the first |len| bytes of RandomBytes(20000, 7), from the
+// reference implementation. The lengths cover every short-input path and
+// both sides of the stripe, buffer and block boundaries.
+constexpr Xxh3Vector kXxh3Vectors[] = {
+    {0, 0x2D06800538D394C2ull},     {1, 0x56C67CD7BDE2AA02ull},
+    {3, 0x7FEEBD462CEB400Full},     {4, 0xD005D656782896B4ull},
+    {7, 0xDE0A8A928BC7E331ull},     {8, 0x037FA8DB32F3BAA9ull},
+    {9, 0x9C6E3F5889209B77ull},     {16, 0xBA87666C8647D68Eull},
+    {17, 0x0BEC738716989BC7ull},    {32, 0xDC11BC64EC4A37A6ull},
+    {33, 0x510E828CD1B02493ull},    {64, 0xB1BEA632D0F8EA3Cull},
+    {65, 0xD1A9078267B8F9B0ull},    {96, 0x9902803481567177ull},
+    {97, 0x10BFB94E9974F6F6ull},    {128, 0x9471BE826DAE0B52ull},
+    {129, 0x0B7D00FA4160AF9Cull},   {200, 0x4F295CFAD9189FDDull},
+    {240, 0x9364336D91808C84ull},   {241, 0x6B415F07568FBF06ull},
+    {255, 0x0CB8CCC469C0B797ull},   {256, 0xD2037EF52735CCA0ull},
+    {257, 0x49985C8815ABC468ull},   {1024, 0x94030D055C11706Dull},
+    {1025, 0xEC433EFD114D9B78ull},  {2048, 0xA22801B497F42879ull},
+    {4097, 0x99918E39A444A104ull},  {20000, 0xFFC82B5E73D82A20ull},
+};
+
+TEST(ImageHashTest, XxHash3MatchesTheReference) {
+  const std::vector<uint8_t> data = RandomBytes(20000, 7);
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    for (const Xxh3Vector& vector : kXxh3Vectors) {
+      EXPECT_EQ(vector.hash, XxHash3(data.data(), vector.len))
+          << vector.len << " bytes, avx2 " << features.avx2;
+      XxHash3Stream stream;
+      stream.Update(data.data(), vector.len);
+      EXPECT_EQ(vector.hash, stream.Digest()) << vector.len << " bytes";
+    }
+  }
+}
+
+TEST(ImageHashTest, XxHash3StreamIgnoresHowInputIsSplit) {
+  const std::vector<uint8_t> data = RandomBytes(9000, 11);
+  std::mt19937 rng(5);
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    for (const size_t len : {100u, 240u, 300u, 1024u, 1100u, 9000u}) {
+      const uint64_t expected = XxHash3(data.data(), len);
+      for (const size_t max_piece : {1u, 63u, 64u, 255u, 257u, 3000u}) {
+        XxHash3Stream stream;
+        for (size_t at = 0; at < len;) {
+          size_t piece = 1 + rng() % max_piece;
+          if (piece > len - at) piece = len - at;
+          stream.Update(data.data() + at, piece);
+          at += piece;
+          // Digest() leaves the stream as it was.
+          EXPECT_EQ(XxHash3(data.data(), at), stream.Digest());
+        }
+        EXPECT_EQ(expected, stream.Digest())
+            << len << " bytes in pieces up to " << max_piece;
+        stream.Reset();
+        stream.Update(data.data(), len);
+        EXPECT_EQ(expected, stream.Digest());
+      }
+    }
+  }
+}
+
+TEST(ImageHashTest, XxHash3StreamMasksWordsAsItReads) {
+  const std::vector<uint8_t> data = RandomBytes(6000, 13);
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    for (const size_t len : {0u, 4u, 16u, 132u, 240u, 244u, 1028u, 6000u}) {
+      std::vector<uint8_t> opaque(data.data(), data.data() + len);
+      for (size_t i = 3; i < len; i += 4) opaque[i] = 0xFF;
+      const uint64_t expected = XxHash3(opaque.data(), len);
+      for (const size_t piece : {4u, 60u, 68u, 400u, 6000u}) {
+        XxHash3Stream stream(0xFF000000u);
+        for (size_t at = 0; at < len; at += piece) {
+          stream.Update(data.data() + at, piece < len - at ? piece : len - at);
+        }
+        EXPECT_EQ(expected, stream.Digest())
+            << len << " bytes in pieces of " << piece;
+      }
+    }
+  }
+}
+
+TEST(ImageHashTest, PixelHashIsTheHashOfTheRawCapture) {
+  constexpr int kWidth = 203;
+  constexpr int kHeight = 61;
+  constexpr size_t kStride = kWidth * kBytesPerPixel + 36;
+  const std::vector<uint8_t> pixels =
+      TestPattern(kWidth, kHeight, kStride, 3);
+  const ImageView frame{pixels.data(), kWidth, kHeight, kStride,
+                        PixelFormat::kBgra8};
+  const PixelRect rect{17, 5, 150, 40};
+  ImageView view;
+  ASSERT_TRUE(CropImage(frame, rect, &view));
+
+  std::vector<uint8_t> raw;
+  for (int y = rect.y; y < rect.bottom(); ++y) {
+    const uint8_t* row =
+        frame.Row(y) + static_cast<size_t>(rect.x) * kBytesPerPixel;
+    for (int x = 0; x < rect.width; ++x, row += kBytesPerPixel) {
+      raw.insert(raw.end(), {row[0], row[1], row[2], 0xFF});
+    }
+  }
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    EXPECT_EQ(XxHash3(raw.data(), raw.size()), PixelHash(view));
+  }
+  const ImageView packed{raw.data(), rect.width, rect.height,
+                         static_cast<size_t>(rect.width) * kBytesPerPixel,
+                         PixelFormat::kBgra8};
+  EXPECT_EQ(PixelHash(packed), PixelHash(view));
+  EXPECT_EQ(0u, PixelHash(ImageView()));
+}
+
+TEST(ImageHashTest, DifferenceHashComparesNeighbours) {
+  float luma[kDHashWidth * kDHashHeight];
+  for (int y = 0; y < kDHashHeight; ++y) {
+    for (int x = 0; x < kDHashWidth; ++x) {
+      // Brightening left to right, except darkening on the first row.
+      luma[y * kDHashWidth + x] = static_cast<float>(y == 0 ? -x : x);
+    }
+  }
+  EXPECT_EQ(0x00FFFFFFFFFFFFFFull, DifferenceHash(luma));
+  EXPECT_EQ(8, HammingDistance(0, 0xFF));
+  EXPECT_EQ(64, HammingDistance(0, ~uint64_t{0}));
+}
+
+class ImageHasherTest : public ::testing::Test {
+ protected:
+  static constexpr int kWidth = 640;
+  static constexpr int kHeight = 400;
+  static constexpr size_t kStride = kWidth * kBytesPerPixel;
+
+  static ImageView View(const std::vector<uint8_t>& pixels) {
+    return ImageView{pixels.data(), kWidth, kHeight, kStride,
+                     PixelFormat::kBgra8};
+  }
+
+  ImageHashes Hash(const std::vector<uint8_t>& pixels) {
+    ImageHashes hashes;
+    EXPECT_TRUE(hasher_.Hash(View(pixels), ImageHashOptions(), &hashes));
+    return hashes;
+  }
+
+  ImageHasher hasher_;
+};
+
+TEST_F(ImageHasherTest, PerceptualHashesTolerateNoiseButNotNewContent) {
+  const std::vector<uint8_t> screen = TestPattern(kWidth, kHeight, kStride, 21);
+  std::vector<uint8_t> noisy = screen;
+  std::mt19937 rng(4);
+  for (size_t i = 0; i < noisy.size(); ++i) {
+    if (i % 4 == 3) continue;
+    const int v = noisy[i] + static_cast<int>(rng() % 5) - 2;
+    noisy[i] = static_cast<uint8_t>(v < 0 ? 0 : v > 255 ? 255 : v);
+  }
+  // The same kind of content, laid out differently.
+  std::vector<uint8_t> other(screen.size());
+  for (size_t y = 0; y < kHeight; ++y) {
+    std::memcpy(other.data() + (kHeight - 1 - y) * kStride,
+                screen.data() + y * kStride, kStride);
+  }
+
+  const ImageHashes a = Hash(screen);
+  const ImageHashes b = Hash(noisy);
+  const ImageHashes c = Hash(other);
+  EXPECT_NE(a.xxh3, b.xxh3);
+  EXPECT_LE(HammingDistance(a.dhash, b.dhash), 4);
+  EXPECT_LE(HammingDistance(a.phash, b.phash), 4);
+  EXPECT_GE(HammingDistance(a.dhash, c.dhash), 10);
+  EXPECT_GE(HammingDistance(a.phash, c.phash), 10);
+
+  // Alpha is not part of any hash.
+  std::vector<uint8_t> alpha = screen;
+  for (size_t i = 3; i < alpha.size(); i += 4) alpha[i] ^= 0x5A;
+  const ImageHashes d = Hash(alpha);
+  EXPECT_EQ(a.xxh3, d.xxh3);
+  EXPECT_EQ(a.dhash, d.dhash);
+  EXPECT_EQ(a.phash, d.phash);
+}
+
+TEST_F(ImageHasherTest, ComputesOnlyTheHashesAskedFor) {
+  const std::vector<uint8_t> screen = TestPattern(kWidth, kHeight, kStride, 30);
+  const ImageHashes all = Hash(screen);
+  EXPECT_NE(0u, all.xxh3);
+  EXPECT_NE(0u, all.dhash);
+  EXPECT_NE(0u, all.phash);
+
+  for (const int threads : {1, 3}) {
+    ImageHashOptions options;
+    options.xxh3 = false;
+    options.dhash = false;
+    options.threads = threads;
+    ImageHashes hashes;
+    ASSERT_TRUE(hasher_.Hash(View(screen), options, &hashes));
+    EXPECT_EQ(0u, hashes.xxh3);
+    EXPECT_EQ(0u, hashes.dhash);
+    EXPECT_EQ(all.phash, hashes.phash);
+
+    options.phash = false;
+    options.dhash = true;
+    ASSERT_TRUE(hasher_.Hash(View(screen), options, &hashes));
+    EXPECT_EQ(all.dhash, hashes.dhash);
+    EXPECT_EQ(0u, hashes.phash);
+  }
+
+  ImageHashes hashes = all;
+  EXPECT_FALSE(hasher_.Hash(ImageView(), ImageHashOptions(), &hashes));
+  EXPECT_EQ(0u, hashes.xxh3);
+  EXPECT_EQ(0u, hashes.phash);
+}
+
+TEST_F(ImageHasherTest, HashesImagesSmallerThanTheDownsample) {
+  const std::vector<uint8_t> pixels = TestPattern(5, 3, 20, 8);
+  const ImageView tiny{pixels.data(), 5, 3, 20, PixelFormat::kBgra8};
+  ImageHashes hashes;
+  ASSERT_TRUE(hasher_.Hash(tiny, ImageHashOptions(), &hashes));
+  EXPECT_EQ(PixelHash(tiny), hashes.xxh3);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
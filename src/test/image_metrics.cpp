@@ -0,0 +1,96 @@
+#include "test/image_metrics.h"
+
+#include <cmath>
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+std::vector<double> Luma(const std::vector<uint8_t>& rgb, size_t pixels) {
+  std::vector<double> luma(pixels);
+  for (size_t i = 0; i < pixels; ++i) {
+    luma[i] = 0.299 * rgb[i * 3] + 0.587 * rgb[i * 3 + 1] +
+              0.114 * rgb[i * 3 + 2];
+  }
+  return luma;
+}
+
+}  // namespace
+
+std::vector<uint8_t> ExpectedRgb(const uint8_t* bgra, int width, int height,
+                                 size_t stride) {
+  std::vector<uint8_t> rgb(static_cast<size_t>(width) *
+                           static_cast<size_t>(height) * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const size_t i = static_cast<size_t>(y) * static_cast<size_t>(width) +
+                       static_cast<size_t>(x);
+      const uint8_t* s = bgra + static_cast<size_t>(y) * stride +
+                         static_cast<size_t>(x) * 4;
+      uint8_t* d = &rgb[i * 3];
+      d[0] = s[2];
+      d[1] = s[1];
+      d[2] = s[0];
+    }
+  }
+  return rgb;
+}
+
+double Psnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+  if (a.size() != b.size() || a.empty()) return 0.0;
+  double sum = 0.0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    const double d = static_cast<double>(a[i]) - static_cast<double>(b[i]);
+    sum += d * d;
+  }
+  if (sum == 0.0) return 99.0;
+  const double mse = sum / static_cast<double>(a.size());
+  return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+double SsimLuma(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b,
+                int width, int height) {
+  const size_t pixels =
+      static_cast<size_t>(width) * static_cast<size_t>(height);
+  if (a.size() != pixels * 3 || b.size() != a.size()) return 0.0;
+  const std::vector<double> la = Luma(a, pixels);
+  const std::vector<double> lb = Luma(b, pixels);
+  const double c1 = (0.01 * 255) * (0.01 * 255);
+  const double c2 = (0.03 * 255) * (0.03 * 255);
+  constexpr size_t kWindow = 8;
+  double total = 0.0;
+  int windows = 0;
+  for (int y = 0; y + 8 <= height; y += 4) {
+    for (int x = 0; x + 8 <= width; x += 4) {
+      double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+      for (size_t j = 0; j < kWindow; ++j) {
+        const size_t row = (static_cast<size_t>(y) + j) *
+                               static_cast<size_t>(width) +
+                           static_cast<size_t>(x);
+        for (size_t i = 0; i < kWindow; ++i) {
+          const double va = la[row + i];
+          const double vb = lb[row + i];
+          sa += va;
+          sb += vb;
+          saa += va * va;
+          sbb += vb * vb;
+          sab += va * vb;
+        }
+      }
+      const double n = kWindow * kWindow;
+      const double ma = sa / n;
+      const double mb = sb / n;
+      const double va = saa / n - ma * ma;
+      const double vb = sbb / n - mb * mb;
+      const double cov = sab / n - ma * mb;
+      total += ((2 * ma * mb + c1) * (2 * cov + c2)) /
+               ((ma * ma + mb * mb + c1) * (va + vb + c2));
+      ++windows;
+    }
+  }
+  return windows == 0 ? 1.0 : total / windows;
+}
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,28 @@
+#ifndef SCREENSHOT_CORE_TEST_IMAGE_METRICS_H_
+#define SCREENSHOT_CORE_TEST_IMAGE_METRICS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace screenshot {
+namespace test {
+
+// Packed RGB copy of a BGRA image (alpha dropped).
+std::vector<uint8_t> ExpectedRgb(const uint8_t* bgra, int width, int height,
+                                 size_t stride);
+
+// Peak signal-to-noise ratio in dB over all channels of two packed images of
+// the same size; 99 for identical images.
+double Psnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b);
+
+// Mean structural similarity (Wang et al. 2004, the usual K1 = 0.01,
+// K2 = 0.03) of the BT.601 luma of two packed RGB images, over 8x8 windows
+// with stride 4. 1 for identical images.
+double SsimLuma(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b,
+                int width, int height);
+
+}  // namespace test
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_TEST_IMAGE_METRICS_H_
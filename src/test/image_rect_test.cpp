@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "image.h"
+#include "image_rect.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+TEST(ImageRectTest, CornersInAnyOrderGiveTheSameRect) {
+  const PixelRect expected{10, 20, 30, 40};
+  EXPECT_EQ(RectFromCorners(10, 20, 40, 60), expected);
+  EXPECT_EQ(RectFromCorners(40, 60, 10, 20), expected);
+  EXPECT_EQ(RectFromCorners(40, 20, 10, 60), expected);
+  EXPECT_EQ(RectFromCorners(10, 60, 40, 20), expected);
+  EXPECT_EQ(RectFromCorners(-5, -5, 5, 5), (PixelRect{-5, -5, 10, 10}));
+  // A click without a drag selects nothing.
+  EXPECT_TRUE(RectFromCorners(7, 8, 7, 8).IsEmpty());
+  EXPECT_TRUE(RectFromCorners(7, 8, 9, 8).IsEmpty());
+}
+
+TEST(ImageRectTest, IntersectsOverlappingRects) {
+  const PixelRect screen{0, 0, 1920, 1080};
+  EXPECT_EQ(IntersectRects(PixelRect{100, 100, 50, 50}, screen),
+            (PixelRect{100, 100, 50, 50}));
+  EXPECT_EQ(IntersectRects(PixelRect{-10, 1000, 100, 200}, screen),
+            (PixelRect{0, 1000, 90, 80}));
+  EXPECT_EQ(IntersectRects(screen, PixelRect{1900, -5, 100, 10}),
+            (PixelRect{1900, 0, 20, 5}));
+  // Touching edges do not overlap.
+  EXPECT_TRUE(IntersectRects(PixelRect{1920, 0, 10, 10}, screen).IsEmpty());
+  EXPECT_TRUE(IntersectRects(PixelRect{0, -10, 10, 10}, screen).IsEmpty());
+  EXPECT_TRUE(IntersectRects(PixelRect{5, 5, 0, 10}, screen).IsEmpty());
+  EXPECT_EQ(IntersectRects(PixelRect{5000, 5000, 1, 1}, screen), PixelRect());
+}
+
+TEST(ImageRectTest, CropPointsIntoTheImageWithoutCopying) {
+  const int width = 64;
+  const int height = 48;
+  const size_t stride = 300;  // Padded rows.
+  std::vector<uint8_t> pixels(stride * height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      uint8_t* pixel = &pixels[static_cast<size_t>(y) * stride +
+                               static_cast<size_t>(x) * kBytesPerPixel];
+      pixel[0] = static_cast<uint8_t>(x);
+      pixel[1] = static_cast<uint8_t>(y);
+    }
+  }
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kRgba8};
+
+  ImageView crop;
+  ASSERT_TRUE(CropImage(image, PixelRect{5, 7, 20, 10}, &crop));
+  EXPECT_EQ(crop.data, pixels.data() + 7 * stride + 5 * kBytesPerPixel);
+  EXPECT_EQ(crop.width, 20);
+  EXPECT_EQ(crop.height, 10);
+  EXPECT_EQ(crop.stride, stride);
+  EXPECT_EQ(crop.format, PixelFormat::kRgba8);
+  EXPECT_TRUE(crop.IsValid());
+  for (int y = 0; y < crop.height; ++y) {
+    for (int x = 0; x < crop.width; ++x) {
+      const uint8_t* pixel =
+          crop.Row(y) + static_cast<size_t>(x) * kBytesPerPixel;
+      ASSERT_EQ(pixel[0], 5 + x);
+      ASSERT_EQ(pixel[1], 7 + y);
+    }
+  }
+
+  // Clipped to the image.
+  ASSERT_TRUE(CropImage(image, PixelRect{-3, 40, 10, 100}, &crop));
+  EXPECT_EQ(crop.data, image.Row(40));
+  EXPECT_EQ(crop.width, 7);
+  EXPECT_EQ(crop.height, 8);
+
+  // The whole image is the image.
+  ASSERT_TRUE(CropImage(image, PixelRect{0, 0, width, height}, &crop));
+  EXPECT_EQ(crop.data, image.data);
+  EXPECT_EQ(crop.width, width);
+  EXPECT_EQ(crop.height, height);
+}
+
+TEST(ImageRectTest, CropRejectsRectsOffTheImage) {
+  std::vector<uint8_t> pixels(16 * 16 * kBytesPerPixel);
+  const ImageView image{pixels.data(), 16, 16, 16 * kBytesPerPixel,
+                        PixelFormat::kBgra8};
+  ImageView crop;
+  EXPECT_FALSE(CropImage(image, PixelRect{16, 0, 4, 4}, &crop));
+  EXPECT_FALSE(CropImage(image, PixelRect{-4, -4, 4, 4}, &crop));
+  EXPECT_FALSE(CropImage(image, PixelRect{2, 2, 0, 4}, &crop));
+  EXPECT_FALSE(CropImage(ImageView(), PixelRect{0, 0, 4, 4}, &crop));
+  EXPECT_EQ(crop.data, nullptr);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
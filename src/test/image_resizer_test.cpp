@@ -0,0 +1,302 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "image.h"
+#include "image_resizer.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+struct Size {
+  int width;
+  int height;
+};
+
+Size Fit(int width, int height, int max_width, int max_height,
+         double scale = 1.0) {
+  ResizeLimits limits;
+  limits.max_width = max_width;
+  limits.max_height = max_height;
+  limits.scale = scale;
+  Size size{0, 0};
+  FitSize(width, height, limits, &size.width, &size.height);
+  return size;
+}
+
+// Packed copy of |image|.
+std::vector<uint8_t> Pixels(const ImageView& image) {
+  std::vector<uint8_t> pixels;
+  for (int y = 0; y < image.height; ++y) {
+    pixels.insert(pixels.end(), image.Row(y), image.Row(y) + image.RowBytes());
+  }
+  return pixels;
+}
+
+// Rounded mean of each |fx| x |fy| block.
+std::vector<uint8_t> ReferenceBox(const ImageView& src, int fx, int fy) {
+  const int width = src.width / fx;
+  const int height = src.height / fy;
+  std::vector<uint8_t> out;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      for (int c = 0; c < 4; ++c) {
+        int sum = 0;
+        for (int by = 0; by < fy; ++by) {
+          const uint8_t* row = src.Row(y * fy + by);
+          for (int bx = 0; bx < fx; ++bx) sum += row[(x * fx + bx) * 4 + c];
+        }
+        const int area = fx * fy;
+        out.push_back(static_cast<uint8_t>((sum + area / 2) / area));
+      }
+    }
+  }
+  return out;
+}
+
+// A smooth image: a horizontal and a vertical ramp plus a gentle wave, so a
+// good resampler reproduces it within rounding.
+std::vector<uint8_t> Smooth(int width, int height) {
+  std::vector<uint8_t> pixels(static_cast<size_t>(width * height) * 4);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const double fx = static_cast<double>(x) / width;
+      const double fy = static_cast<double>(y) / height;
+      uint8_t* p = &pixels[static_cast<size_t>(y * width + x) * 4];
+      p[0] = static_cast<uint8_t>(std::lround(255 * fx));
+      p[1] = static_cast<uint8_t>(std::lround(255 * fy));
+      p[2] = static_cast<uint8_t>(
+          std::lround(127.5 + 100 * std::sin(fx * 6.0) * std::cos(fy * 4.0)));
+      p[3] = 255;
+    }
+  }
+  return pixels;
+}
+
+// Value of a Smooth() image of |width| x |height| at continuous position
+// (x, y), in source pixel units.
+double SmoothAt(int width, int height, double x, double y, int channel) {
+  const double fx = x / width;
+  const double fy = y / height;
+  switch (channel) {
+    case 0:
+      return 255 * fx;
+    case 1:
+      return 255 * fy;
+    case 2:
+      return 127.5 + 100 * std::sin(fx * 6.0) * std::cos(fy * 4.0);
+  }
+  return 255;
+}
+
+TEST(FitSizeTest, KeepsAspectRatioAndNeverEnlarges) {
+  const Size half = Fit(3840, 2160, 1920, 0);
+  EXPECT_EQ(half.width, 1920);
+  EXPECT_EQ(half.height, 1080);
+  const Size thumb = Fit(3840, 2160, 256, 256);
+  EXPECT_EQ(thumb.width, 256);
+  EXPECT_EQ(thumb.height, 144);
+  const Size tall = Fit(1080, 1920, 512, 512);
+  EXPECT_EQ(tall.width, 288);
+  EXPECT_EQ(tall.height, 512);
+  const Size scaled = Fit(2560, 1440, 0, 0, 0.3);
+  EXPECT_EQ(scaled.width, 768);
+  EXPECT_EQ(scaled.height, 432);
+  // The limits and the scale combine; the tighter one wins.
+  const Size both = Fit(2560, 1440, 1000, 0, 0.5);
+  EXPECT_EQ(both.width, 1000);
+  EXPECT_EQ(both.height, 563);
+
+  const Size same = Fit(800, 600, 1920, 1080, 1.5);
+  EXPECT_EQ(same.width, 800);
+  EXPECT_EQ(same.height, 600);
+  const Size sliver = Fit(4000, 3, 100, 0);
+  EXPECT_EQ(sliver.width, 100);
+  EXPECT_EQ(sliver.height, 1);
+}
+
+TEST(ImageResizerTest, WholeFactorsAverageBlocksExactly) {
+  const int width = 390;
+  const int height = 150;
+  const size_t stride = static_cast<size_t>(width) * 4 + 20;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 1);
+  const ImageView src{pixels.data(), width, height, stride,
+                      PixelFormat::kBgra8};
+  const Size factors[] = {{2, 2}, {3, 5}, {15, 15}, {1, 2}, {5, 1}, {78, 50}};
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    for (const Size& f : factors) {
+      SCOPED_TRACE(testing::Message() << f.width << "x" << f.height);
+      ImageResizer resizer;
+      ASSERT_TRUE(resizer.Resize(src, width / f.width, height / f.height));
+      const ImageView out = resizer.output();
+      EXPECT_EQ(out.width, width / f.width);
+      EXPECT_EQ(out.height, height / f.height);
+      EXPECT_EQ(Pixels(out), ReferenceBox(src, f.width, f.height));
+    }
+  }
+}
+
+TEST(ImageResizerTest, FiltersFollowTheUnderlyingImage) {
+  const int width = 1000;
+  const int height = 700;
+  const std::vector<uint8_t> pixels = Smooth(width, height);
+  const ImageView src{pixels.data(), width, height,
+                      static_cast<size_t>(width) * 4, PixelFormat::kBgra8};
+  for (ResizeFilter filter : {ResizeFilter::kBox, ResizeFilter::kBilinear,
+                              ResizeFilter::kLanczos3}) {
+    for (const Size& size : {Size{333, 233}, Size{640, 480}, Size{1000, 350},
+                             Size{97, 700}, Size{1500, 900}}) {
+      SCOPED_TRACE(testing::Message() << static_cast<int>(filter) << " to "
+                                      << size.width << "x" << size.height);
+      ResizeOptions options;
+      options.filter = filter;
+      ImageResizer resizer(options);
+      ASSERT_TRUE(resizer.Resize(src, size.width, size.height));
+      const ImageView out = resizer.output();
+      const double sx = static_cast<double>(width) / size.width;
+      const double sy = static_cast<double>(height) / size.height;
+      int worst = 0;
+      // Away from the edges, where the filters see a clamped image.
+      for (int y = 8; y < size.height - 8; y += 3) {
+        for (int x = 8; x < size.width - 8; x += 3) {
+          for (int c = 0; c < 4; ++c) {
+            const double expected =
+                SmoothAt(width, height, (x + 0.5) * sx, (y + 0.5) * sy, c);
+            const int error = std::abs(out.Row(y)[x * 4 + c] -
+                                       static_cast<int>(std::lround(expected)));
+            if (error > worst) worst = error;
+          }
+        }
+      }
+      EXPECT_LE(worst, 2);
+    }
+  }
+}
+
+TEST(ImageResizerTest, FlatImagesStayFlat) {
+  const int width = 123;
+  const int height = 77;
+  std::vector<uint8_t> pixels(static_cast<size_t>(width * height) * 4);
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    pixels[i] = 0;
+    pixels[i + 1] = 255;
+    pixels[i + 2] = 91;
+    pixels[i + 3] = 255;
+  }
+  const ImageView src{pixels.data(), width, height,
+                      static_cast<size_t>(width) * 4, PixelFormat::kRgba8};
+  for (ResizeFilter filter : {ResizeFilter::kAuto, ResizeFilter::kBox,
+                              ResizeFilter::kBilinear,
+                              ResizeFilter::kLanczos3}) {
+    ResizeOptions options;
+    options.filter = filter;
+    ImageResizer resizer(options);
+    ASSERT_TRUE(resizer.Resize(src, 50, 31));
+    const ImageView out = resizer.output();
+    EXPECT_EQ(out.format, PixelFormat::kRgba8);
+    const std::vector<uint8_t> resized = Pixels(out);
+    for (size_t i = 0; i < resized.size(); i += 4) {
+      ASSERT_EQ(resized[i], 0);
+      ASSERT_EQ(resized[i + 1], 255);
+      ASSERT_EQ(resized[i + 2], 91);
+      ASSERT_EQ(resized[i + 3], 255);
+    }
+  }
+}
+
+TEST(ImageResizerTest, KernelsAndBandsMatchTheScalarPath) {
+  const int width = 517;
+  const int height = 389;
+  const size_t stride = static_cast<size_t>(width) * 4 + 12;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 2);
+  const ImageView src{pixels.data(), width, height, stride,
+                      PixelFormat::kBgra8};
+  const Size sizes[] = {{200, 150}, {517, 100}, {99, 389}, {31, 7}, {700, 401}};
+  for (ResizeFilter filter : {ResizeFilter::kBox, ResizeFilter::kBilinear,
+                              ResizeFilter::kLanczos3}) {
+    for (const Size& size : sizes) {
+      SCOPED_TRACE(testing::Message() << static_cast<int>(filter) << " to "
+                                      << size.width << "x" << size.height);
+      std::vector<uint8_t> reference;
+      {
+        ScopedCpuFeatures scalar{CpuFeatures()};
+        ResizeOptions options;
+        options.filter = filter;
+        options.threads = 1;
+        ImageResizer resizer(options);
+        ASSERT_TRUE(resizer.Resize(src, size.width, size.height));
+        reference = Pixels(resizer.output());
+      }
+      for (const CpuFeatures& features : FeatureLevels()) {
+        ScopedCpuFeatures scoped(features);
+        for (int threads : {1, 3, 8}) {
+          ResizeOptions options;
+          options.filter = filter;
+          options.threads = threads;
+          ImageResizer resizer(options);
+          ASSERT_TRUE(resizer.Resize(src, size.width, size.height));
+          ASSERT_EQ(Pixels(resizer.output()), reference) << threads;
+        }
+      }
+    }
+  }
+}
+
+TEST(ImageResizerTest, ReusesBuffersAcrossSizes) {
+  const int width = 640;
+  const int height = 360;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 3);
+  const ImageView src{pixels.data(), width, height, stride,
+                      PixelFormat::kBgra8};
+  ImageResizer resizer;
+  ImageResizer fresh;
+  for (const Size& size :
+       {Size{320, 180}, Size{300, 200}, Size{320, 180}, Size{64, 36}}) {
+    ASSERT_TRUE(resizer.Resize(src, size.width, size.height));
+    ASSERT_TRUE(fresh.Resize(src, size.width, size.height));
+    EXPECT_EQ(Pixels(resizer.output()), Pixels(fresh.output()));
+    ImageResizer once;
+    ASSERT_TRUE(once.Resize(src, size.width, size.height));
+    EXPECT_EQ(Pixels(resizer.output()), Pixels(once.output()));
+  }
+}
+
+TEST(ImageResizerTest, FitLeavesSmallImagesAlone) {
+  const std::vector<uint8_t> pixels = RandomBytes(64 * 48 * 4, 4);
+  const ImageView src{pixels.data(), 64, 48, 64 * 4, PixelFormat::kBgra8};
+  ImageResizer resizer;
+  ImageView out;
+  ResizeLimits limits;
+  limits.max_width = 100;
+  ASSERT_TRUE(resizer.Fit(src, limits, &out));
+  EXPECT_EQ(out.data, src.data);
+
+  limits.max_width = 32;
+  ASSERT_TRUE(resizer.Fit(src, limits, &out));
+  EXPECT_NE(out.data, src.data);
+  EXPECT_EQ(out.width, 32);
+  EXPECT_EQ(out.height, 24);
+  EXPECT_EQ(Pixels(out), ReferenceBox(src, 2, 2));
+}
+
+TEST(ImageResizerTest, RejectsInvalidInput) {
+  const std::vector<uint8_t> pixels(16 * 16 * 4);
+  const ImageView src{pixels.data(), 16, 16, 16 * 4, PixelFormat::kBgra8};
+  ImageResizer resizer;
+  EXPECT_FALSE(resizer.Resize(ImageView(), 8, 8));
+  EXPECT_FALSE(resizer.Resize(src, 0, 8));
+  EXPECT_FALSE(resizer.Resize(src, 8, -1));
+  ImageView out;
+  EXPECT_FALSE(resizer.Fit(ImageView(), ResizeLimits(), &out));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
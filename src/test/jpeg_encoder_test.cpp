@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "image.h"
+#include "jpeg_encoder.h"
+#include "test/image_metrics.h"
+#include "test/jpeg_test_decoder.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+struct Encoded {
+  std::vector<uint8_t> jpeg;
+  DecodedJpeg decoded;
+};
+
+Encoded EncodeAndDecode(const ImageView& image,
+                        const JpegEncodeOptions& options) {
+  Encoded result;
+  JpegEncoder encoder(options);
+  EXPECT_TRUE(encoder.Encode(image, &result.jpeg));
+  EXPECT_TRUE(DecodeJpeg(result.jpeg, &result.decoded));
+  EXPECT_EQ(image.width, result.decoded.width);
+  EXPECT_EQ(image.height, result.decoded.height);
+  return result;
+}
+
+}  // namespace
+
+TEST(JpegEncoderTest, WritesMarkersAndFitsMaxEncodedSize) {
+  const int width = 97;
+  const int height = 41;
+  const size_t stride = static_cast<size_t>(width) * 4 + 12;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 1);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  JpegEncoder encoder;
+  std::vector<uint8_t> jpeg;
+  ASSERT_TRUE(encoder.Encode(image, &jpeg));
+  ASSERT_GT(jpeg.size(), 4u);
+  EXPECT_EQ(0xFF, jpeg[0]);
+  EXPECT_EQ(0xD8, jpeg[1]);
+  EXPECT_EQ(0xFF, jpeg[jpeg.size() - 2]);
+  EXPECT_EQ(0xD9, jpeg[jpeg.size() - 1]);
+  EXPECT_LE(jpeg.size(), JpegEncoder::MaxEncodedSize(width, height));
+
+  // The pointer overload produces the same bytes, and refuses a buffer that
+  // is too small instead of overrunning it.
+  std::vector<uint8_t> out(JpegEncoder::MaxEncodedSize(width, height));
+  EXPECT_EQ(jpeg.size(), encoder.Encode(image, out.data(), out.size()));
+  out.resize(jpeg.size());
+  EXPECT_EQ(jpeg, out);
+  EXPECT_EQ(0u, encoder.Encode(image, out.data(), 16));
+}
+
+TEST(JpegEncoderTest, RejectsInvalidImages) {
+  uint8_t pixel[4] = {};
+  JpegEncoder encoder;
+  std::vector<uint8_t> jpeg;
+  EXPECT_FALSE(encoder.Encode(ImageView{pixel, 0, 1, 4}, &jpeg));
+  EXPECT_FALSE(encoder.Encode(ImageView{nullptr, 1, 1, 4}, &jpeg));
+  EXPECT_FALSE(encoder.Encode(ImageView{pixel, 70000, 1, 280000}, &jpeg));
+  EXPECT_EQ(0u, JpegEncoder::MaxEncodedSize(65536, 1));
+  EXPECT_NE(0u, JpegEncoder::MaxEncodedSize(65535, 1));
+}
+
+TEST(JpegEncoderTest, DecodesAtOddSizesAndEverySubsampling) {
+  if (!HaveJpegDecoder()) GTEST_SKIP() << "libjpeg not found";
+  const int sizes[][2] = {{1, 1}, {7, 3}, {17, 9}, {33, 65}, {250, 31}};
+  for (const auto& size : sizes) {
+    const int width = size[0];
+    const int height = size[1];
+    const size_t stride = static_cast<size_t>(width) * 4;
+    const std::vector<uint8_t> pixels =
+        TestPattern(width, height, stride, 2);
+    const ImageView image{pixels.data(), width, height, stride,
+                          PixelFormat::kBgra8};
+    for (ChromaSubsampling subsampling :
+         {ChromaSubsampling::k444, ChromaSubsampling::k422,
+          ChromaSubsampling::k420}) {
+      SCOPED_TRACE(::testing::Message() << width << "x" << height << " mode "
+                                        << static_cast<int>(subsampling));
+      JpegEncodeOptions options;
+      options.quality = 95;
+      options.subsampling = subsampling;
+      const Encoded encoded = EncodeAndDecode(image, options);
+      EXPECT_GT(Psnr(ExpectedRgb(pixels.data(), width, height, stride),
+                     encoded.decoded.rgb),
+                20.0);
+    }
+  }
+}
+
+TEST(JpegEncoderTest, RgbaAndBgraSourcesDecodeAlike) {
+  if (!HaveJpegDecoder()) GTEST_SKIP() << "libjpeg not found";
+  const int width = 64;
+  const int height = 48;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> bgra = TestPattern(width, height, stride, 3);
+  const std::vector<uint8_t> rgba =
+      ExpectedRgba(bgra.data(), width, height, stride, false);
+  JpegEncoder encoder;
+  std::vector<uint8_t> from_bgra;
+  std::vector<uint8_t> from_rgba;
+  ASSERT_TRUE(encoder.Encode(
+      ImageView{bgra.data(), width, height, stride, PixelFormat::kBgra8},
+      &from_bgra));
+  ASSERT_TRUE(encoder.Encode(
+      ImageView{rgba.data(), width, height, stride, PixelFormat::kRgba8},
+      &from_rgba));
+  EXPECT_EQ(from_bgra, from_rgba);
+}
+
+// Size, PSNR and SSIM against the source pixels across the quality range:
+// all three must improve with quality, and the defaults must look good.
+TEST(JpegEncoderTest, QualityTradesSizeForFidelity) {
+  if (!HaveJpegDecoder()) GTEST_SKIP() << "libjpeg not found";
+  const int width = 320;
+  const int height = 240;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 4);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  const std::vector<uint8_t> expected =
+      ExpectedRgb(pixels.data(), width, height, stride);
+
+  size_t last_size = 0;
+  double last_psnr = 0.0;
+  double last_ssim = 0.0;
+  for (int quality : {10, 30, 50, 75, 90, 100}) {
+    JpegEncodeOptions options;
+    options.quality = quality;
+    options.subsampling = ChromaSubsampling::k444;
+    const Encoded encoded = EncodeAndDecode(image, options);
+    const double psnr = Psnr(expected, encoded.decoded.rgb);
+    const double ssim = SsimLuma(expected, encoded.decoded.rgb, width, height);
+    EXPECT_GT(encoded.jpeg.size(), last_size) << "quality " << quality;
+    EXPECT_GT(psnr, last_psnr) << "quality " << quality;
+    EXPECT_GE(ssim, last_ssim) << "quality " << quality;
+    if (quality >= 90) {
+      EXPECT_GT(psnr, 32.0) << "quality " << quality;
+      EXPECT_GT(ssim, 0.97) << "quality " << quality;
+    }
+    if (quality == 100) {
+      EXPECT_GT(psnr, 40.0) << "quality " << quality;
+    }
+    last_size = encoded.jpeg.size();
+    last_psnr = psnr;
+    last_ssim = ssim;
+  }
+}
+
+TEST(JpegEncoderTest, ChromaSubsamplingTradesSizeForColorFidelity) {
+  if (!HaveJpegDecoder()) GTEST_SKIP() << "libjpeg not found";
+  const int width = 256;
+  const int height = 192;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 5);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  const std::vector<uint8_t> expected =
+      ExpectedRgb(pixels.data(), width, height, stride);
+
+  size_t last_size = SIZE_MAX;
+  double last_psnr = 100.0;
+  for (ChromaSubsampling subsampling :
+       {ChromaSubsampling::k444, ChromaSubsampling::k422,
+        ChromaSubsampling::k420}) {
+    JpegEncodeOptions options;
+    options.quality = 90;
+    options.subsampling = subsampling;
+    const Encoded encoded = EncodeAndDecode(image, options);
+    const double psnr = Psnr(expected, encoded.decoded.rgb);
+    EXPECT_LT(encoded.jpeg.size(), last_size);
+    EXPECT_LT(psnr, last_psnr);
+    last_size = encoded.jpeg.size();
+    last_psnr = psnr;
+  }
+}
+
+TEST(JpegEncoderTest, FlatImageIsTinyAndExact) {
+  if (!HaveJpegDecoder()) GTEST_SKIP() << "libjpeg not found";
+  const int width = 640;
+  const int height = 480;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  std::vector<uint8_t> pixels(stride * height);
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    pixels[i] = 0x20;      // B
+    pixels[i + 1] = 0x80;  // G
+    pixels[i + 2] = 0xC0;  // R
+    pixels[i + 3] = 0xFF;
+  }
+  const Encoded encoded = EncodeAndDecode(
+      ImageView{pixels.data(), width, height, stride, PixelFormat::kBgra8},
+      JpegEncodeOptions());
+  EXPECT_LT(encoded.jpeg.size(), 8000u);
+  EXPECT_GT(Psnr(ExpectedRgb(pixels.data(), width, height, stride),
+                 encoded.decoded.rgb),
+            40.0);
+}
+
+// Bands only add restart markers; the decoded pixels must not change.
+TEST(JpegEncoderTest, BandedEncodeDecodesIdentically) {
+  if (!HaveJpegDecoder()) GTEST_SKIP() << "libjpeg not found";
+  const int width = 1024;
+  const int height = 700;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 6);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  for (ChromaSubsampling subsampling :
+       {ChromaSubsampling::k444, ChromaSubsampling::k420}) {
+    JpegEncodeOptions options;
+    options.subsampling = subsampling;
+    const Encoded single = EncodeAndDecode(image, options);
+    for (int threads : {2, 3, 5}) {
+      options.threads = threads;
+      const Encoded banded = EncodeAndDecode(image, options);
+      EXPECT_NE(single.jpeg, banded.jpeg) << "expected restart markers";
+      EXPECT_EQ(single.decoded.rgb, banded.decoded.rgb)
+          << threads << " threads";
+    }
+  }
+}
+
+// The SIMD color conversion must match the scalar one exactly.
+TEST(JpegEncoderTest, KernelsMatchScalar) {
+  const int width = 203;
+  const int height = 37;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 7);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  std::vector<uint8_t> reference;
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    JpegEncoder encoder;
+    std::vector<uint8_t> jpeg;
+    ASSERT_TRUE(encoder.Encode(image, &jpeg));
+    if (reference.empty()) {
+      reference = jpeg;
+    } else {
+      EXPECT_EQ(reference, jpeg);
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace screenshot
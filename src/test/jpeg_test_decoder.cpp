@@ -0,0 +1,78 @@
+#include "test/jpeg_test_decoder.h"
+
+#if SCREENSHOT_CORE_TEST_HAVE_LIBJPEG
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+#endif
+
+namespace screenshot {
+namespace test {
+
+#if SCREENSHOT_CORE_TEST_HAVE_LIBJPEG
+
+namespace {
+
+struct ErrorManager {
+  jpeg_error_mgr base;
+  std::jmp_buf jump;
+};
+
+void OnError(j_common_ptr cinfo) {
+  std::longjmp(reinterpret_cast<ErrorManager*>(cinfo->err)->jump, 1);
+}
+
+// Corrupt-data warnings (e.g. a bad restart marker) must fail the test too.
+void OnMessage(j_common_ptr cinfo, int level) {
+  if (level < 0) OnError(cinfo);
+}
+
+}  // namespace
+
+bool HaveJpegDecoder() { return true; }
+
+bool DecodeJpeg(const std::vector<uint8_t>& jpeg, DecodedJpeg* out) {
+  jpeg_decompress_struct cinfo;
+  ErrorManager error;
+  cinfo.err = jpeg_std_error(&error.base);
+  error.base.error_exit = OnError;
+  error.base.emit_message = OnMessage;
+  if (setjmp(error.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, jpeg.data(), static_cast<unsigned long>(jpeg.size()));
+  if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  cinfo.out_color_space = JCS_RGB;
+  // The slow integer IDCT is the most accurate, so the metrics measure the
+  // encoder rather than the decoder.
+  cinfo.dct_method = JDCT_ISLOW;
+  jpeg_start_decompress(&cinfo);
+  out->width = static_cast<int>(cinfo.output_width);
+  out->height = static_cast<int>(cinfo.output_height);
+  const size_t row_bytes = static_cast<size_t>(out->width) * 3;
+  out->rgb.assign(row_bytes * static_cast<size_t>(out->height), 0);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = out->rgb.data() + cinfo.output_scanline * row_bytes;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return true;
+}
+
+#else
+
+bool HaveJpegDecoder() { return false; }
+
+bool DecodeJpeg(const std::vector<uint8_t>&, DecodedJpeg*) { return false; }
+
+#endif
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,29 @@
+#ifndef SCREENSHOT_CORE_TEST_JPEG_TEST_DECODER_H_
+#define SCREENSHOT_CORE_TEST_JPEG_TEST_DECODER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace screenshot {
+namespace test {
+
+struct DecodedJpeg {
+  int width = 0;
+  int height = 0;
+  // 3 bytes per pixel.
+  std::vector<uint8_t> rgb;
+};
+
+// True when the tests were built against the system libjpeg (usually
+// libjpeg-turbo), which DecodeJpeg uses; JPEG round-trip tests skip without
+// it.
+bool HaveJpegDecoder();
+
+// Decodes a baseline JPEG to packed RGB. Returns false on malformed input or
+// when no decoder is available.
+bool DecodeJpeg(const std::vector<uint8_t>& jpeg, DecodedJpeg* out);
+
+}  // namespace test
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_TEST_JPEG_TEST_DECODER_H_
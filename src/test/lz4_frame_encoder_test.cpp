@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "image.h"
+#include "lz4.h"
+#include "lz4_frame_encoder.h"
+#include "test/lz4_test_decoder.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+// Packed BGRA copy of a BGRA image.
+std::vector<uint8_t> PackedBgra(const std::vector<uint8_t>& pixels, int width,
+                                int height, size_t stride, bool opaque) {
+  const size_t row_bytes = static_cast<size_t>(width) * 4;
+  std::vector<uint8_t> packed(row_bytes * height);
+  for (int y = 0; y < height; ++y) {
+    for (size_t i = 0; i < row_bytes; ++i) {
+      const uint8_t v = pixels[static_cast<size_t>(y) * stride + i];
+      packed[static_cast<size_t>(y) * row_bytes + i] =
+          opaque && i % 4 == 3 ? 0xFF : v;
+    }
+  }
+  return packed;
+}
+
+}  // namespace
+
+TEST(Lz4Test, BlocksRoundTrip) {
+  Lz4Encoder encoder;
+  std::vector<std::vector<uint8_t>> inputs;
+  inputs.push_back({});
+  inputs.push_back(RandomBytes(5, 1));
+  inputs.push_back(RandomBytes(13, 2));
+  inputs.push_back(RandomBytes(100000, 3));
+  inputs.push_back(std::vector<uint8_t>(70000, 0x42));
+  std::vector<uint8_t> screen = TestPattern(300, 200, 1200, 4);
+  inputs.push_back(screen);
+  for (const std::vector<uint8_t>& input : inputs) {
+    std::vector<uint8_t> compressed(Lz4Encoder::CompressBound(input.size()));
+    compressed.resize(
+        encoder.Compress(input.data(), input.size(), compressed.data()));
+    std::vector<uint8_t> decoded;
+    ASSERT_TRUE(Lz4DecompressBlock(compressed.data(), compressed.size(),
+                                   &decoded))
+        << "size=" << input.size();
+    EXPECT_EQ(input, decoded);
+  }
+  // Runs compress to a few bytes per 255.
+  std::vector<uint8_t> compressed(Lz4Encoder::CompressBound(70000));
+  EXPECT_LT(encoder.Compress(inputs[4].data(), 70000, compressed.data()),
+            400u);
+}
+
+TEST(Lz4FrameEncoderTest, RoundTripsAcrossBlocksAndThreadCounts) {
+  // Just over two 1 MiB blocks, with padded rows.
+  const int width = 700;
+  const int height = 800;
+  const size_t stride = static_cast<size_t>(width) * 4 + 16;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 5);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+
+  std::vector<uint8_t> reference;
+  for (int threads : {1, 2, 3, 0}) {
+    for (bool opaque : {false, true}) {
+      Lz4FrameEncodeOptions options;
+      options.threads = threads;
+      options.force_opaque = opaque;
+      Lz4FrameEncoder encoder(options);
+      std::vector<uint8_t> frame;
+      ASSERT_TRUE(encoder.Encode(image, &frame));
+      EXPECT_LE(frame.size(), Lz4FrameEncoder::MaxEncodedSize(width, height));
+      std::vector<uint8_t> decoded;
+      ASSERT_TRUE(Lz4DecompressFrame(frame, &decoded))
+          << "threads=" << threads;
+      EXPECT_EQ(PackedBgra(pixels, width, height, stride, opaque), decoded);
+      if (opaque) {
+        // Independent blocks make the output identical for any thread count.
+        if (reference.empty()) reference = frame;
+        EXPECT_EQ(reference, frame);
+      }
+    }
+  }
+}
+
+TEST(Lz4FrameEncoderTest, ConvertsRgbaToBgra) {
+  const int width = 9;
+  const int height = 4;
+  const std::vector<uint8_t> rgba =
+      RandomBytes(static_cast<size_t>(width) * height * 4, 6);
+  const ImageView image{rgba.data(), width, height,
+                        static_cast<size_t>(width) * 4, PixelFormat::kRgba8};
+  Lz4FrameEncoder encoder;
+  std::vector<uint8_t> frame;
+  ASSERT_TRUE(encoder.Encode(image, &frame));
+  std::vector<uint8_t> decoded;
+  ASSERT_TRUE(Lz4DecompressFrame(frame, &decoded));
+  // Swapping red and blue again gives back the RGBA input.
+  EXPECT_EQ(rgba, ExpectedRgba(decoded.data(), width, height,
+                               static_cast<size_t>(width) * 4, false));
+}
+
+TEST(Lz4FrameEncoderTest, StoresIncompressibleBlocks) {
+  const int width = 256;
+  const int height = 256;
+  const std::vector<uint8_t> noise =
+      RandomBytes(static_cast<size_t>(width) * height * 4, 7);
+  const ImageView image{noise.data(), width, height,
+                        static_cast<size_t>(width) * 4, PixelFormat::kBgra8};
+  Lz4FrameEncoder encoder;
+  std::vector<uint8_t> frame;
+  ASSERT_TRUE(encoder.Encode(image, &frame));
+  // Header, one stored block and the end mark.
+  EXPECT_EQ(15 + 4 + noise.size() + 4, frame.size());
+  std::vector<uint8_t> decoded;
+  ASSERT_TRUE(Lz4DecompressFrame(frame, &decoded));
+  EXPECT_EQ(noise, decoded);
+}
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,129 @@
+#include "test/lz4_test_decoder.h"
+
+#include "checksum.h"
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+uint32_t LoadLe32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Reads a length extension (bytes of 255 terminated by a smaller byte).
+bool ReadLength(const uint8_t* data, size_t len, size_t* pos, size_t* value) {
+  for (;;) {
+    if (*pos >= len) return false;
+    const uint8_t b = data[(*pos)++];
+    *value += b;
+    if (b != 255) return true;
+  }
+}
+
+}  // namespace
+
+bool Lz4DecompressBlock(const uint8_t* data, size_t len,
+                        std::vector<uint8_t>* out) {
+  size_t pos = 0;
+  for (;;) {
+    if (pos >= len) return false;
+    const uint8_t token = data[pos++];
+    size_t literals = token >> 4;
+    if (literals == 15 && !ReadLength(data, len, &pos, &literals)) {
+      return false;
+    }
+    if (literals > len - pos) return false;
+    out->insert(out->end(), data + pos, data + pos + literals);
+    pos += literals;
+    if (pos == len) return true;  // The last sequence has no match.
+
+    if (len - pos < 2) return false;
+    const size_t distance = data[pos] | (static_cast<size_t>(data[pos + 1]) << 8);
+    pos += 2;
+    size_t match = token & 15;
+    if (match == 15 && !ReadLength(data, len, &pos, &match)) return false;
+    match += 4;
+    if (distance == 0 || distance > out->size()) return false;
+    // Byte by byte: the match may overlap the bytes it produces.
+    size_t from = out->size() - distance;
+    for (size_t i = 0; i < match; ++i) out->push_back((*out)[from++]);
+  }
+}
+
+bool Lz4DecompressFrame(const std::vector<uint8_t>& frame,
+                        std::vector<uint8_t>* out) {
+  const uint8_t* data = frame.data();
+  const size_t len = frame.size();
+  if (len < 7 || LoadLe32(data) != 0x184D2204) return false;
+  const uint8_t flags = data[4];
+  const uint8_t bd = data[5];
+  if ((flags >> 6) != 1 || (flags & 0x02) != 0 || (bd & 0x8F) != 0) {
+    return false;
+  }
+  const bool independent = (flags & 0x20) != 0;
+  const bool block_checksum = (flags & 0x10) != 0;
+  const bool has_content_size = (flags & 0x08) != 0;
+  const bool content_checksum = (flags & 0x04) != 0;
+  const bool has_dict_id = (flags & 0x01) != 0;
+  const int block_code = (bd >> 4) & 7;
+  if (block_code < 4) return false;
+  const size_t max_block = size_t{1} << (8 + 2 * block_code);
+
+  size_t descriptor_len = 2 + (has_content_size ? 8 : 0) + (has_dict_id ? 4 : 0);
+  if (len < 4 + descriptor_len + 1) return false;
+  uint64_t content_size = 0;
+  if (has_content_size) {
+    content_size = LoadLe32(data + 6) |
+                   (static_cast<uint64_t>(LoadLe32(data + 10)) << 32);
+  }
+  const uint8_t hc = data[4 + descriptor_len];
+  if (hc != static_cast<uint8_t>(XxHash32(data + 4, descriptor_len, 0) >> 8)) {
+    return false;
+  }
+  size_t pos = 4 + descriptor_len + 1;
+
+  out->clear();
+  for (;;) {
+    if (len - pos < 4) return false;
+    const uint32_t block_size = LoadLe32(data + pos);
+    pos += 4;
+    if (block_size == 0) break;  // end mark
+    const bool stored = (block_size & 0x80000000u) != 0;
+    const size_t size = block_size & 0x7FFFFFFFu;
+    if (size > max_block || size > len - pos) return false;
+    const uint8_t* block = data + pos;
+    pos += size;
+    if (block_checksum) {
+      if (len - pos < 4 || LoadLe32(data + pos) != XxHash32(block, size, 0)) {
+        return false;
+      }
+      pos += 4;
+    }
+    const size_t before = out->size();
+    if (stored) {
+      out->insert(out->end(), block, block + size);
+    } else if (independent) {
+      std::vector<uint8_t> decoded;
+      if (!Lz4DecompressBlock(block, size, &decoded)) return false;
+      out->insert(out->end(), decoded.begin(), decoded.end());
+    } else if (!Lz4DecompressBlock(block, size, out)) {
+      return false;
+    }
+    if (out->size() - before > max_block) return false;
+  }
+  if (content_checksum) {
+    if (len - pos < 4 ||
+        LoadLe32(data + pos) != XxHash32(out->data(), out->size(), 0)) {
+      return false;
+    }
+    pos += 4;
+  }
+  if (has_content_size && content_size != out->size()) return false;
+  return pos == len;
+}
+
+}  // namespace test
+}  // namespace screenshot
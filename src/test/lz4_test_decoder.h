@@ -0,0 +1,25 @@
+#ifndef SCREENSHOT_CORE_TEST_LZ4_TEST_DECODER_H_
+#define SCREENSHOT_CORE_TEST_LZ4_TEST_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace screenshot {
+namespace test {
+
+// Decodes one LZ4 block, appending to |out|, which also serves as the match
+// history (so linked blocks decode too). Returns false on malformed input,
+// including matches that reach before the start of |out|.
+bool Lz4DecompressBlock(const uint8_t* data, size_t len,
+                        std::vector<uint8_t>* out);
+
+// Decodes an LZ4 frame, checking the descriptor checksum, block and content
+// checksums when present, the declared content size and the end mark.
+bool Lz4DecompressFrame(const std::vector<uint8_t>& frame,
+                        std::vector<uint8_t>* out);
+
+}  // namespace test
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_TEST_LZ4_TEST_DECODER_H_
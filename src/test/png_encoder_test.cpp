@@ -0,0 +1,469 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "checksum.h"
+#include "cpu_features.h"
+#include "deflate.h"
+#include "image.h"
+#include "pixel_convert.h"
+#include "png_encoder.h"
+#include "png_filter.h"
+#include "test/png_test_decoder.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+std::vector<uint8_t> DeflateToVector(DeflateEncoder* encoder,
+                                     const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> out(DeflateEncoder::CompressBound(data.size()));
+  out.resize(encoder->Compress(data.data(), data.size(), true, out.data()));
+  return out;
+}
+
+}  // namespace
+
+TEST(ChecksumTest, Crc32KnownVector) {
+  const std::string check = "123456789";
+  EXPECT_EQ(0xCBF43926u,
+            Crc32(0, reinterpret_cast<const uint8_t*>(check.data()),
+                  check.size()));
+  EXPECT_EQ(0u, Crc32(0, nullptr, 0));
+}
+
+TEST(ChecksumTest, Crc32KernelsAgreeAcrossLengths) {
+  const std::vector<uint8_t> data = RandomBytes(4096 + 77, 1);
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    for (size_t len : {0, 1, 15, 16, 63, 64, 65, 127, 128, 1000, 4173}) {
+      uint32_t expected = 0xFFFFFFFFu;
+      for (size_t i = 0; i < len; ++i) {
+        expected ^= data[i];
+        for (int k = 0; k < 8; ++k) {
+          expected = (expected & 1) ? 0xEDB88320u ^ (expected >> 1)
+                                    : expected >> 1;
+        }
+      }
+      EXPECT_EQ(~expected, Crc32(0, data.data(), len)) << "len=" << len;
+    }
+    // Streaming in pieces matches one shot.
+    const uint32_t split = Crc32(Crc32(0, data.data(), 1000),
+                                 data.data() + 1000, data.size() - 1000);
+    EXPECT_EQ(Crc32(0, data.data(), data.size()), split);
+  }
+}
+
+TEST(ChecksumTest, Adler32KernelsAgreeAcrossLengths) {
+  // All-0xFF input maximizes the sums between modulo reductions.
+  std::vector<uint8_t> data = RandomBytes(20000, 2);
+  std::vector<uint8_t> ones(20000, 0xFF);
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    for (const auto* buffer : {&data, &ones}) {
+      for (size_t len : {0, 1, 31, 32, 33, 64, 5552, 5553, 11104, 20000}) {
+        uint32_t a = 1;
+        uint32_t b = 0;
+        for (size_t i = 0; i < len; ++i) {
+          a = (a + (*buffer)[i]) % 65521;
+          b = (b + a) % 65521;
+        }
+        EXPECT_EQ((b << 16) | a, Adler32(1, buffer->data(), len))
+            << "len=" << len;
+      }
+    }
+  }
+}
+
+TEST(ChecksumTest, Adler32CombineMatchesSinglePass) {
+  const std::vector<uint8_t> data = RandomBytes(100000, 3);
+  const uint32_t whole = Adler32(1, data.data(), data.size());
+  for (size_t split : {0, 1, 65521, 70000, 100000}) {
+    const uint32_t first = Adler32(1, data.data(), split);
+    const uint32_t second =
+        Adler32(1, data.data() + split, data.size() - split);
+    EXPECT_EQ(whole, Adler32Combine(first, second, data.size() - split))
+        << "split=" << split;
+  }
+}
+
+TEST(ChecksumTest, XxHash32KnownVectors) {
+  const std::string abc = "abc";
+  EXPECT_EQ(0x02CC5D05u, XxHash32(nullptr, 0, 0));
+  EXPECT_EQ(0x32D153FFu,
+            XxHash32(reinterpret_cast<const uint8_t*>(abc.data()), abc.size(),
+                     0));
+  const std::string fox = "The quick brown fox jumps over the lazy dog";
+  EXPECT_EQ(0xE85EA4DEu,
+            XxHash32(reinterpret_cast<const uint8_t*>(fox.data()), fox.size(),
+                     0));
+}
+
+TEST(PixelConvertTest, SwizzleKernelsMatchScalar) {
+  const std::vector<uint8_t> src = RandomBytes(4 * 67, 4);
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    for (bool opaque : {false, true}) {
+      std::vector<uint8_t> dst(src.size());
+      SwizzleRedBlue(src.data(), dst.data(), 67, opaque);
+      EXPECT_EQ(ExpectedRgba(src.data(), 67, 1, src.size(), opaque), dst);
+      // In place.
+      std::vector<uint8_t> in_place = src;
+      SwizzleRedBlue(in_place.data(), in_place.data(), 67, opaque);
+      EXPECT_EQ(dst, in_place);
+    }
+  }
+}
+
+TEST(PixelConvertTest, SetOpaqueKernelsMatchScalar) {
+  const std::vector<uint8_t> src = RandomBytes(4 * 45, 5);
+  std::vector<uint8_t> expected = src;
+  for (size_t i = 3; i < expected.size(); i += 4) expected[i] = 0xFF;
+  for (const CpuFeatures& features : FeatureLevels()) {
+    ScopedCpuFeatures scoped(features);
+    std::vector<uint8_t> data = src;
+    SetOpaque(data.data(), 45);
+    EXPECT_EQ(expected, data);
+  }
+}
+
+TEST(PixelConvertTest, ConvertImageHandlesStridesAndInPlace) {
+  const int width = 13;
+  const int height = 5;
+  const size_t stride = static_cast<size_t>(width) * 4 + 8;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 6);
+  const ImageView bgra{pixels.data(), width, height, stride,
+                       PixelFormat::kBgra8};
+  const size_t packed = static_cast<size_t>(width) * 4;
+
+  std::vector<uint8_t> rgba(packed * height);
+  ASSERT_TRUE(ConvertImage(bgra, PixelFormat::kRgba8, true, rgba.data(),
+                           packed));
+  EXPECT_EQ(ExpectedRgba(pixels.data(), width, height, stride, true), rgba);
+
+  // Same format, opaque, in place with padded rows.
+  std::vector<uint8_t> in_place = pixels;
+  const ImageView view{in_place.data(), width, height, stride,
+                       PixelFormat::kBgra8};
+  ASSERT_TRUE(ConvertImage(view, PixelFormat::kBgra8, true, in_place.data(),
+                           stride));
+  for (int y = 0; y < height; ++y) {
+    for (size_t i = 0; i < packed; ++i) {
+      const size_t at = static_cast<size_t>(y) * stride + i;
+      EXPECT_EQ(i % 4 == 3 ? 0xFF : pixels[at], in_place[at]);
+    }
+  }
+
+  EXPECT_FALSE(ConvertImage(bgra, PixelFormat::kRgba8, false, rgba.data(),
+                            packed - 1));
+}
+
+TEST(PngFilterTest, KernelsMatchScalarForEveryFilter) {
+  for (size_t len : {4, 8, 20, 36, 64, 4 * 33, 4 * 257}) {
+    const std::vector<uint8_t> row = RandomBytes(len, 5);
+    const std::vector<uint8_t> prior = RandomBytes(len, 6);
+
+    std::vector<std::vector<uint8_t>> reference(kPngFilterCount);
+    uint64_t reference_scores[kPngFilterCount];
+    {
+      ScopedCpuFeatures scalar((CpuFeatures()));
+      for (int f = 0; f < kPngFilterCount; ++f) {
+        reference[f].resize(len);
+        ApplyPngFilter(static_cast<PngFilter>(f), row.data(), prior.data(),
+                       len, reference[f].data());
+      }
+      ScorePngFilters(row.data(), prior.data(), len, reference_scores);
+    }
+
+    for (const CpuFeatures& features : FeatureLevels()) {
+      ScopedCpuFeatures scoped(features);
+      uint64_t scores[kPngFilterCount];
+      ScorePngFilters(row.data(), prior.data(), len, scores);
+      for (int f = 0; f < kPngFilterCount; ++f) {
+        std::vector<uint8_t> out(len);
+        ApplyPngFilter(static_cast<PngFilter>(f), row.data(), prior.data(),
+                       len, out.data());
+        EXPECT_EQ(reference[f], out) << "filter=" << f << " len=" << len;
+        EXPECT_EQ(reference_scores[f], scores[f])
+            << "filter=" << f << " len=" << len;
+      }
+    }
+  }
+}
+
+TEST(PngFilterTest, SelectsUpForRepeatedRows) {
+  const std::vector<uint8_t> row = RandomBytes(256, 7);
+  EXPECT_EQ(PngFilter::kUp, SelectPngFilter(row.data(), row.data(), 256));
+}
+
+TEST(DeflateTest, RoundTripsAtEveryLevel) {
+  std::vector<std::vector<uint8_t>> inputs;
+  inputs.push_back({});
+  inputs.push_back({42});
+  inputs.push_back(RandomBytes(70000, 8));
+  inputs.push_back(std::vector<uint8_t>(300000, 0xAB));
+  std::string text;
+  for (int i = 0; i < 5000; ++i) {
+    text += "capture frame " + std::to_string(i % 97) + " ok; ";
+  }
+  inputs.emplace_back(text.begin(), text.end());
+
+  for (int level = DeflateEncoder::kMinLevel; level <= DeflateEncoder::kMaxLevel;
+       ++level) {
+    DeflateEncoder encoder(level);
+    for (const auto& input : inputs) {
+      const std::vector<uint8_t> compressed = DeflateToVector(&encoder, input);
+      EXPECT_LE(compressed.size(), DeflateEncoder::CompressBound(input.size()));
+      std::vector<uint8_t> decoded;
+      ASSERT_TRUE(RawInflate(compressed.data(), compressed.size(), &decoded))
+          << "level=" << level << " size=" << input.size();
+      EXPECT_EQ(input, decoded) << "level=" << level;
+    }
+  }
+}
+
+TEST(DeflateTest, HigherLevelsCompressRepetitiveDataBetter) {
+  std::string text;
+  for (int i = 0; i < 20000; ++i) {
+    text += "row " + std::to_string((i * 7919) % 1000) + "\n";
+  }
+  const std::vector<uint8_t> input(text.begin(), text.end());
+  DeflateEncoder stored(0);
+  DeflateEncoder fast(1);
+  DeflateEncoder best(9);
+  const size_t stored_size = DeflateToVector(&stored, input).size();
+  const size_t fast_size = DeflateToVector(&fast, input).size();
+  const size_t best_size = DeflateToVector(&best, input).size();
+  EXPECT_GT(stored_size, input.size());
+  EXPECT_LT(fast_size, input.size() / 2);
+  EXPECT_LE(best_size, fast_size);
+}
+
+TEST(DeflateTest, SegmentsWithHistorySpliceIntoOneStream) {
+  std::string text;
+  for (int i = 0; i < 30000; ++i) text += "segment " + std::to_string(i % 50);
+  const std::vector<uint8_t> input(text.begin(), text.end());
+  DeflateEncoder encoder(6);
+  const size_t half = input.size() / 2;
+  std::vector<uint8_t> stream(DeflateEncoder::CompressBound(half) +
+                              DeflateEncoder::CompressBound(input.size() - half));
+  size_t size = encoder.Compress(input.data(), half, false, stream.data());
+  size += encoder.Compress(input.data() + half, input.size() - half, true,
+                           stream.data() + size, half);
+  std::vector<uint8_t> decoded;
+  ASSERT_TRUE(RawInflate(stream.data(), size, &decoded));
+  EXPECT_EQ(input, decoded);
+}
+
+TEST(PngEncoderTest, RoundTripsBgraScreen) {
+  const int width = 193;
+  const int height = 61;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 9);
+  ImageView image{pixels.data(), width, height, stride, PixelFormat::kBgra8};
+
+  PngEncoder encoder;
+  std::vector<uint8_t> png;
+  ASSERT_TRUE(encoder.Encode(image, &png));
+  EXPECT_LE(png.size(), PngEncoder::MaxEncodedSize(width, height));
+
+  DecodedPng decoded;
+  ASSERT_TRUE(DecodePng(png, &decoded));
+  EXPECT_EQ(width, decoded.width);
+  EXPECT_EQ(height, decoded.height);
+  EXPECT_EQ(ExpectedRgba(pixels.data(), width, height, stride, false),
+            decoded.rgba);
+}
+
+TEST(PngEncoderTest, RoundTripsEveryStrategyAndLevel) {
+  const int width = 37;
+  const int height = 23;
+  const size_t stride = static_cast<size_t>(width) * 4 + 12;  // padded rows
+  const std::vector<uint8_t> pixels =
+      TestPattern(width, height, stride, 10);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  const std::vector<uint8_t> expected =
+      ExpectedRgba(pixels.data(), width, height, stride, true);
+
+  const PngFilterStrategy strategies[] = {
+      PngFilterStrategy::kAdaptive, PngFilterStrategy::kNone,
+      PngFilterStrategy::kSub,      PngFilterStrategy::kUp,
+      PngFilterStrategy::kAverage,  PngFilterStrategy::kPaeth};
+  for (const PngFilterStrategy strategy : strategies) {
+    for (int level : {0, 1, 6, 9}) {
+      PngEncodeOptions options;
+      options.filter = strategy;
+      options.level = level;
+      options.force_opaque = true;
+      PngEncoder encoder(options);
+      std::vector<uint8_t> png;
+      ASSERT_TRUE(encoder.Encode(image, &png));
+      DecodedPng decoded;
+      ASSERT_TRUE(DecodePng(png, &decoded))
+          << "strategy=" << static_cast<int>(strategy) << " level=" << level;
+      EXPECT_EQ(expected, decoded.rgba);
+      if (strategy != PngFilterStrategy::kAdaptive) {
+        for (uint8_t filter : decoded.filters) {
+          EXPECT_EQ(static_cast<int>(strategy) - 1, filter);
+        }
+      }
+    }
+  }
+}
+
+TEST(PngEncoderTest, KeepsRgbaInputAsIs) {
+  const int width = 16;
+  const int height = 9;
+  const std::vector<uint8_t> pixels =
+      RandomBytes(static_cast<size_t>(width) * height * 4, 11);
+  const ImageView image{pixels.data(), width, height,
+                        static_cast<size_t>(width) * 4, PixelFormat::kRgba8};
+  PngEncoder encoder;
+  std::vector<uint8_t> png;
+  ASSERT_TRUE(encoder.Encode(image, &png));
+  DecodedPng decoded;
+  ASSERT_TRUE(DecodePng(png, &decoded));
+  EXPECT_EQ(pixels, decoded.rgba);
+}
+
+TEST(PngEncoderTest, ReusesEncoderAcrossSizes) {
+  PngEncoder encoder;
+  for (int size : {64, 8, 64, 1}) {
+    const size_t stride = static_cast<size_t>(size) * 4;
+    const std::vector<uint8_t> pixels =
+        TestPattern(size, size, stride, static_cast<uint32_t>(size));
+    const ImageView image{pixels.data(), size, size, stride,
+                          PixelFormat::kBgra8};
+    std::vector<uint8_t> png;
+    ASSERT_TRUE(encoder.Encode(image, &png));
+    DecodedPng decoded;
+    ASSERT_TRUE(DecodePng(png, &decoded));
+    EXPECT_EQ(ExpectedRgba(pixels.data(), size, size, stride, false),
+              decoded.rgba);
+  }
+}
+
+TEST(PngEncoderTest, BandedEncodingDecodesIdenticallyForAnyThreadCount) {
+  // Large enough for several 256 KiB bands.
+  const int width = 640;
+  const int height = 480;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels =
+      TestPattern(width, height, stride, 12);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+
+  PngEncodeOptions options;
+  options.force_opaque = true;
+  PngEncoder single(options);
+  std::vector<uint8_t> reference_png;
+  ASSERT_TRUE(single.Encode(image, &reference_png));
+  DecodedPng reference;
+  ASSERT_TRUE(DecodePng(reference_png, &reference));
+
+  for (int threads : {2, 3, 4, 8, 16, 0}) {
+    for (int level : {0, 1, 3, 6}) {
+      options.threads = threads;
+      options.level = level;
+      PngEncoder encoder(options);
+      // Encode twice to exercise reuse of the bands and the worker pool.
+      for (int pass = 0; pass < 2; ++pass) {
+        std::vector<uint8_t> png;
+        ASSERT_TRUE(encoder.Encode(image, &png));
+        EXPECT_LE(png.size(), PngEncoder::MaxEncodedSize(width, height));
+        DecodedPng decoded;
+        ASSERT_TRUE(DecodePng(png, &decoded))
+            << "threads=" << threads << " level=" << level;
+        EXPECT_EQ(reference.rgba, decoded.rgba);
+        EXPECT_EQ(reference.filters, decoded.filters);
+      }
+    }
+  }
+}
+
+TEST(PngEncoderTest, StreamedEncodingDecodesIdentically) {
+  // Several kSinkChunkSize segments, so the IDAT data is split.
+  const int width = 1000;
+  const int height = 700;
+  const size_t stride = static_cast<size_t>(width) * 4 + 8;
+  const std::vector<uint8_t> pixels =
+      TestPattern(width, height, stride, 13);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+
+  PngEncodeOptions options;
+  options.force_opaque = true;
+  std::vector<uint8_t> reference_png;
+  ASSERT_TRUE(PngEncoder(options).Encode(image, &reference_png));
+  DecodedPng reference;
+  ASSERT_TRUE(DecodePng(reference_png, &reference));
+
+  for (int threads : {1, 2, 3}) {
+    options.threads = threads;
+    PngEncoder encoder(options);
+    for (int pass = 0; pass < 2; ++pass) {
+      VectorSink sink;
+      ASSERT_TRUE(encoder.Encode(image, &sink));
+      EXPECT_GT(sink.writes(), 3u);
+      DecodedPng decoded;
+      ASSERT_TRUE(DecodePng(sink.bytes(), &decoded)) << "threads=" << threads;
+      EXPECT_EQ(reference.rgba, decoded.rgba);
+      EXPECT_EQ(reference.filters, decoded.filters);
+      // Splitting the stream costs next to nothing.
+      EXPECT_LT(sink.bytes().size(), reference_png.size() * 101 / 100);
+    }
+  }
+
+  // A one-row image fits in a single segment.
+  const ImageView row{pixels.data(), width, 1, stride, PixelFormat::kBgra8};
+  VectorSink sink;
+  ASSERT_TRUE(PngEncoder(options).Encode(row, &sink));
+  DecodedPng decoded;
+  ASSERT_TRUE(DecodePng(sink.bytes(), &decoded));
+  EXPECT_EQ(decoded.height, 1);
+}
+
+TEST(PngEncoderTest, BandedEncodingHandlesShortImages) {
+  // More threads than rows, and a short, wide image.
+  for (const auto& size : {std::pair<int, int>{3000, 3},
+                           std::pair<int, int>{2, 2}}) {
+    const size_t stride = static_cast<size_t>(size.first) * 4;
+    const std::vector<uint8_t> pixels =
+        TestPattern(size.first, size.second, stride, 13);
+    const ImageView image{pixels.data(), size.first, size.second, stride,
+                          PixelFormat::kBgra8};
+    PngEncodeOptions options;
+    options.threads = 8;
+    PngEncoder encoder(options);
+    std::vector<uint8_t> png;
+    ASSERT_TRUE(encoder.Encode(image, &png));
+    DecodedPng decoded;
+    ASSERT_TRUE(DecodePng(png, &decoded));
+    EXPECT_EQ(ExpectedRgba(pixels.data(), size.first, size.second, stride,
+                           false),
+              decoded.rgba);
+  }
+}
+
+TEST(PngEncoderTest, RejectsInvalidImages) {
+  PngEncoder encoder;
+  std::vector<uint8_t> png;
+  EXPECT_FALSE(encoder.Encode(ImageView(), &png));
+  const uint8_t pixel[4] = {};
+  EXPECT_FALSE(encoder.Encode(ImageView{pixel, 2, 1, 4, PixelFormat::kBgra8},
+                              &png));
+  uint8_t small[16];
+  EXPECT_EQ(0u, encoder.Encode(ImageView{pixel, 1, 1, 4, PixelFormat::kBgra8},
+                               small, sizeof(small)));
+}
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,350 @@
+#include "test/png_test_decoder.h"
+
+#include <cstring>
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+// Bitwise CRC-32 and plain Adler-32, deliberately independent of the
+// implementations under test.
+uint32_t ReferenceCrc32(const uint8_t* data, size_t len) {
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < len; ++i) {
+    crc ^= data[i];
+    for (int k = 0; k < 8; ++k) {
+      crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+uint32_t ReferenceAdler32(const uint8_t* data, size_t len) {
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (size_t i = 0; i < len; ++i) {
+    a = (a + data[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+uint32_t LoadBe32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+// Canonical Huffman decoding in the style of zlib's puff.c.
+struct Huffman {
+  uint16_t count[16];
+  uint16_t symbol[320];
+};
+
+class BitReader {
+ public:
+  BitReader(const uint8_t* data, size_t len) : data_(data), len_(len) {}
+
+  bool Bits(int need, uint32_t* value) {
+    uint32_t v = bit_buffer_;
+    while (bit_count_ < need) {
+      if (pos_ >= len_) return false;
+      v |= static_cast<uint32_t>(data_[pos_++]) << bit_count_;
+      bit_count_ += 8;
+    }
+    bit_buffer_ = v >> need;
+    bit_count_ -= need;
+    *value = need == 32 ? v : v & ((1u << need) - 1);
+    return true;
+  }
+
+  void AlignToByte() {
+    bit_buffer_ = 0;
+    bit_count_ = 0;
+  }
+
+  bool Bytes(size_t n, const uint8_t** p) {
+    if (len_ - pos_ < n) return false;
+    *p = data_ + pos_;
+    pos_ += n;
+    return true;
+  }
+
+  int Decode(const Huffman& h) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int len = 1; len < 16; ++len) {
+      uint32_t bit;
+      if (!Bits(1, &bit)) return -1;
+      code |= static_cast<int>(bit);
+      const int count = h.count[len];
+      if (code - count < first) return h.symbol[index + (code - first)];
+      index += count;
+      first += count;
+      first <<= 1;
+      code <<= 1;
+    }
+    return -1;
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t len_;
+  size_t pos_ = 0;
+  uint32_t bit_buffer_ = 0;
+  int bit_count_ = 0;
+};
+
+// Returns false for over-subscribed codes. Incomplete codes are allowed
+// (DEFLATE permits a single distance code).
+bool BuildHuffman(Huffman* h, const uint8_t* lengths, int n) {
+  std::memset(h->count, 0, sizeof(h->count));
+  for (int i = 0; i < n; ++i) ++h->count[lengths[i]];
+  if (h->count[0] == n) return true;
+  int left = 1;
+  for (int len = 1; len < 16; ++len) {
+    left <<= 1;
+    left -= h->count[len];
+    if (left < 0) return false;
+  }
+  uint16_t offs[16];
+  offs[1] = 0;
+  for (int len = 1; len < 15; ++len) {
+    offs[len + 1] = static_cast<uint16_t>(offs[len] + h->count[len]);
+  }
+  for (int i = 0; i < n; ++i) {
+    if (lengths[i] != 0) h->symbol[offs[lengths[i]]++] = static_cast<uint16_t>(i);
+  }
+  return true;
+}
+
+const uint16_t kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,
+                                  15, 17, 19, 23, 27, 31, 35, 43, 51,  59,
+                                  67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint16_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                   2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t kDistBase[30] = {
+    1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
+    33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint16_t kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+bool InflateCodes(BitReader* in, const Huffman& lencode,
+                  const Huffman& distcode, std::vector<uint8_t>* out) {
+  for (;;) {
+    int symbol = in->Decode(lencode);
+    if (symbol < 0) return false;
+    if (symbol < 256) {
+      out->push_back(static_cast<uint8_t>(symbol));
+    } else if (symbol == 256) {
+      return true;
+    } else {
+      symbol -= 257;
+      if (symbol >= 29) return false;
+      uint32_t extra;
+      if (!in->Bits(kLengthExtra[symbol], &extra)) return false;
+      const size_t len = kLengthBase[symbol] + extra;
+      const int dsym = in->Decode(distcode);
+      if (dsym < 0 || dsym >= 30) return false;
+      if (!in->Bits(kDistExtra[dsym], &extra)) return false;
+      const size_t dist = kDistBase[dsym] + extra;
+      if (dist > out->size()) return false;
+      const size_t from = out->size() - dist;
+      for (size_t i = 0; i < len; ++i) out->push_back((*out)[from + i]);
+    }
+  }
+}
+
+}  // namespace
+
+bool RawInflate(const uint8_t* data, size_t len, std::vector<uint8_t>* out) {
+  static const uint8_t kOrder[19] = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                     11, 4,  12, 3, 13, 2, 14, 1, 15};
+  BitReader in(data, len);
+  uint32_t last;
+  do {
+    uint32_t type;
+    if (!in.Bits(1, &last) || !in.Bits(2, &type)) return false;
+    if (type == 0) {
+      in.AlignToByte();
+      const uint8_t* header;
+      if (!in.Bytes(4, &header)) return false;
+      const uint32_t n = header[0] | (header[1] << 8);
+      const uint32_t complement = header[2] | (header[3] << 8);
+      if (n != (~complement & 0xFFFF)) return false;
+      const uint8_t* bytes;
+      if (!in.Bytes(n, &bytes)) return false;
+      out->insert(out->end(), bytes, bytes + n);
+    } else if (type == 1) {
+      uint8_t lengths[288 + 30];
+      for (int i = 0; i < 144; ++i) lengths[i] = 8;
+      for (int i = 144; i < 256; ++i) lengths[i] = 9;
+      for (int i = 256; i < 280; ++i) lengths[i] = 7;
+      for (int i = 280; i < 288; ++i) lengths[i] = 8;
+      for (int i = 0; i < 30; ++i) lengths[288 + i] = 5;
+      Huffman lencode;
+      Huffman distcode;
+      BuildHuffman(&lencode, lengths, 288);
+      BuildHuffman(&distcode, lengths + 288, 30);
+      if (!InflateCodes(&in, lencode, distcode, out)) return false;
+    } else if (type == 2) {
+      uint32_t nlen, ndist, ncode;
+      if (!in.Bits(5, &nlen) || !in.Bits(5, &ndist) || !in.Bits(4, &ncode)) {
+        return false;
+      }
+      nlen += 257;
+      ndist += 1;
+      ncode += 4;
+      if (nlen > 286 || ndist > 30) return false;
+      uint8_t lengths[320] = {};
+      for (uint32_t i = 0; i < ncode; ++i) {
+        uint32_t v;
+        if (!in.Bits(3, &v)) return false;
+        lengths[kOrder[i]] = static_cast<uint8_t>(v);
+      }
+      Huffman lencode;
+      if (!BuildHuffman(&lencode, lengths, 19)) return false;
+      uint32_t index = 0;
+      while (index < nlen + ndist) {
+        const int symbol = in.Decode(lencode);
+        if (symbol < 0) return false;
+        if (symbol < 16) {
+          lengths[index++] = static_cast<uint8_t>(symbol);
+          continue;
+        }
+        uint8_t value = 0;
+        uint32_t repeat;
+        if (symbol == 16) {
+          if (index == 0) return false;
+          value = lengths[index - 1];
+          if (!in.Bits(2, &repeat)) return false;
+          repeat += 3;
+        } else if (symbol == 17) {
+          if (!in.Bits(3, &repeat)) return false;
+          repeat += 3;
+        } else {
+          if (!in.Bits(7, &repeat)) return false;
+          repeat += 11;
+        }
+        if (index + repeat > nlen + ndist) return false;
+        while (repeat--) lengths[index++] = value;
+      }
+      if (lengths[256] == 0) return false;
+      Huffman distcode;
+      if (!BuildHuffman(&lencode, lengths, static_cast<int>(nlen))) {
+        return false;
+      }
+      if (!BuildHuffman(&distcode, lengths + nlen, static_cast<int>(ndist))) {
+        return false;
+      }
+      if (!InflateCodes(&in, lencode, distcode, out)) return false;
+    } else {
+      return false;
+    }
+  } while (!last);
+  return true;
+}
+
+bool ZlibInflate(const uint8_t* data, size_t len, std::vector<uint8_t>* out) {
+  if (len < 6) return false;
+  if ((data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0) {
+    return false;
+  }
+  if (data[1] & 0x20) return false;  // preset dictionary
+  const size_t start = out->size();
+  if (!RawInflate(data + 2, len - 6, out)) return false;
+  return LoadBe32(data + len - 4) ==
+         ReferenceAdler32(out->data() + start, out->size() - start);
+}
+
+bool DecodePng(const std::vector<uint8_t>& png, DecodedPng* out) {
+  static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A,
+                                        '\n'};
+  if (png.size() < 8 || std::memcmp(png.data(), kSignature, 8) != 0) {
+    return false;
+  }
+  std::vector<uint8_t> idat;
+  bool have_header = false;
+  bool have_end = false;
+  size_t pos = 8;
+  while (pos + 12 <= png.size()) {
+    const uint32_t length = LoadBe32(&png[pos]);
+    if (png.size() - pos - 12 < length) return false;
+    const uint8_t* type = &png[pos + 4];
+    const uint8_t* data = type + 4;
+    if (LoadBe32(data + length) != ReferenceCrc32(type, length + 4)) {
+      return false;
+    }
+    if (std::memcmp(type, "IHDR", 4) == 0) {
+      if (length != 13) return false;
+      out->width = static_cast<int>(LoadBe32(data));
+      out->height = static_cast<int>(LoadBe32(data + 4));
+      if (data[8] != 8 || data[9] != 6 || data[10] != 0 || data[11] != 0 ||
+          data[12] != 0) {
+        return false;
+      }
+      have_header = true;
+    } else if (std::memcmp(type, "IDAT", 4) == 0) {
+      idat.insert(idat.end(), data, data + length);
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      have_end = true;
+      pos += 12 + length;
+      break;
+    }
+    pos += 12 + length;
+  }
+  if (!have_header || !have_end || pos != png.size()) return false;
+
+  std::vector<uint8_t> raw;
+  if (!ZlibInflate(idat.data(), idat.size(), &raw)) return false;
+  const size_t row_bytes = static_cast<size_t>(out->width) * 4;
+  const size_t height = static_cast<size_t>(out->height);
+  if (raw.size() != height * (row_bytes + 1)) return false;
+
+  out->rgba.assign(row_bytes * height, 0);
+  out->filters.assign(height, 0);
+  for (size_t y = 0; y < height; ++y) {
+    const uint8_t filter = raw[y * (row_bytes + 1)];
+    const uint8_t* in = &raw[y * (row_bytes + 1) + 1];
+    uint8_t* row = &out->rgba[y * row_bytes];
+    const uint8_t* prior = y > 0 ? row - row_bytes : nullptr;
+    out->filters[y] = filter;
+    for (size_t i = 0; i < row_bytes; ++i) {
+      const int a = i >= 4 ? row[i - 4] : 0;
+      const int b = prior ? prior[i] : 0;
+      const int c = (prior && i >= 4) ? prior[i - 4] : 0;
+      int predictor = 0;
+      switch (filter) {
+        case 0:
+          break;
+        case 1:
+          predictor = a;
+          break;
+        case 2:
+          predictor = b;
+          break;
+        case 3:
+          predictor = (a + b) / 2;
+          break;
+        case 4: {
+          const int p = a + b - c;
+          const int pa = p > a ? p - a : a - p;
+          const int pb = p > b ? p - b : b - p;
+          const int pc = p > c ? p - c : c - p;
+          predictor = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+          break;
+        }
+        default:
+          return false;
+      }
+      row[i] = static_cast<uint8_t>(in[i] + predictor);
+    }
+  }
+  return true;
+}
+
+}  // namespace test
+}  // namespace screenshot
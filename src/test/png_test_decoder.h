@@ -0,0 +1,35 @@
+#ifndef SCREENSHOT_CORE_TEST_PNG_TEST_DECODER_H_
+#define SCREENSHOT_CORE_TEST_PNG_TEST_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace screenshot {
+namespace test {
+
+// Reference decoders used to check encoder output. They favor being obviously
+// correct over being fast and validate every checksum they come across.
+
+// Decodes a raw DEFLATE stream, appending to |out|. Returns false on any
+// malformed input.
+bool RawInflate(const uint8_t* data, size_t len, std::vector<uint8_t>* out);
+
+// Decodes a zlib stream (RFC 1950) and verifies its Adler-32.
+bool ZlibInflate(const uint8_t* data, size_t len, std::vector<uint8_t>* out);
+
+struct DecodedPng {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgba;
+  // Filter type byte of each scanline.
+  std::vector<uint8_t> filters;
+};
+
+// Decodes an 8-bit RGBA, non-interlaced PNG, verifying chunk CRCs.
+bool DecodePng(const std::vector<uint8_t>& png, DecodedPng* out);
+
+}  // namespace test
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_TEST_PNG_TEST_DECODER_H_
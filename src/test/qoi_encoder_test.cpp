@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "image.h"
+#include "qoi_encoder.h"
+#include "test/qoi_test_decoder.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+
+TEST(QoiEncoderTest, RoundTripsBgraScreen) {
+  const int width = 211;
+  const int height = 47;
+  const size_t stride = static_cast<size_t>(width) * 4 + 20;  // padded rows
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 1);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+
+  for (bool opaque : {false, true}) {
+    QoiEncodeOptions options;
+    options.force_opaque = opaque;
+    QoiEncoder encoder(options);
+    std::vector<uint8_t> qoi;
+    ASSERT_TRUE(encoder.Encode(image, &qoi));
+    EXPECT_LE(qoi.size(), QoiEncoder::MaxEncodedSize(width, height));
+
+    DecodedQoi decoded;
+    ASSERT_TRUE(DecodeQoi(qoi, &decoded));
+    EXPECT_EQ(width, decoded.width);
+    EXPECT_EQ(height, decoded.height);
+    EXPECT_EQ(opaque ? 3 : 4, decoded.channels);
+    EXPECT_EQ(ExpectedRgba(pixels.data(), width, height, stride, opaque),
+              decoded.rgba);
+  }
+}
+
+TEST(QoiEncoderTest, RoundTripsRandomRgbaAndLongRuns) {
+  const int width = 64;
+  const int height = 40;
+  std::vector<uint8_t> pixels =
+      RandomBytes(static_cast<size_t>(width) * height * 4, 2);
+  // A run longer than one QOI_OP_RUN can hold, ending on the last pixel.
+  for (size_t i = pixels.size() - 4 * 200; i < pixels.size(); ++i) {
+    pixels[i] = static_cast<uint8_t>(i % 4 == 3 ? 0x80 : 0x11);
+  }
+  const ImageView image{pixels.data(), width, height,
+                        static_cast<size_t>(width) * 4, PixelFormat::kRgba8};
+  QoiEncoder encoder;
+  std::vector<uint8_t> qoi;
+  ASSERT_TRUE(encoder.Encode(image, &qoi));
+  DecodedQoi decoded;
+  ASSERT_TRUE(DecodeQoi(qoi, &decoded));
+  EXPECT_EQ(pixels, decoded.rgba);
+}
+
+TEST(QoiEncoderTest, FlatImageIsTiny) {
+  const int width = 640;
+  const int height = 480;
+  const std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4,
+                                    0x7F);
+  const ImageView image{pixels.data(), width, height,
+                        static_cast<size_t>(width) * 4, PixelFormat::kBgra8};
+  QoiEncoder encoder;
+  std::vector<uint8_t> qoi;
+  ASSERT_TRUE(encoder.Encode(image, &qoi));
+  // One RGBA op, then runs of 62 pixels.
+  EXPECT_LT(qoi.size(), 14 + 5 + (width * height) / 62 + 1 + 8 + 1u);
+}
+
+TEST(QoiEncoderTest, RejectsInvalidImages) {
+  QoiEncoder encoder;
+  std::vector<uint8_t> qoi;
+  EXPECT_FALSE(encoder.Encode(ImageView(), &qoi));
+  const uint8_t pixel[4] = {};
+  uint8_t small[8];
+  EXPECT_EQ(0u, encoder.Encode(ImageView{pixel, 1, 1, 4, PixelFormat::kBgra8},
+                               small, sizeof(small)));
+}
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,92 @@
+#include "test/qoi_test_decoder.h"
+
+#include <cstddef>
+#include <cstring>
+
+namespace screenshot {
+namespace test {
+
+namespace {
+
+uint32_t LoadBe32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+struct Rgba {
+  uint8_t r, g, b, a;
+};
+
+}  // namespace
+
+bool DecodeQoi(const std::vector<uint8_t>& qoi, DecodedQoi* out) {
+  static const uint8_t kEnd[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+  if (qoi.size() < 14 + 8 || std::memcmp(qoi.data(), "qoif", 4) != 0) {
+    return false;
+  }
+  const uint32_t width = LoadBe32(&qoi[4]);
+  const uint32_t height = LoadBe32(&qoi[8]);
+  const int channels = qoi[12];
+  if (width == 0 || height == 0 || (channels != 3 && channels != 4) ||
+      qoi[13] > 1) {
+    return false;
+  }
+  out->width = static_cast<int>(width);
+  out->height = static_cast<int>(height);
+  out->channels = channels;
+  const size_t pixels = static_cast<size_t>(width) * height;
+  out->rgba.assign(pixels * 4, 0);
+
+  Rgba index[64] = {};
+  Rgba px = {0, 0, 0, 255};
+  const size_t chunks_end = qoi.size() - 8;
+  size_t pos = 14;
+  int run = 0;
+  for (size_t i = 0; i < pixels; ++i) {
+    if (run > 0) {
+      --run;
+    } else {
+      if (pos >= chunks_end) return false;
+      const uint8_t b1 = qoi[pos++];
+      if (b1 == 0xFE) {
+        if (pos + 3 > chunks_end) return false;
+        px.r = qoi[pos++];
+        px.g = qoi[pos++];
+        px.b = qoi[pos++];
+      } else if (b1 == 0xFF) {
+        if (pos + 4 > chunks_end) return false;
+        px.r = qoi[pos++];
+        px.g = qoi[pos++];
+        px.b = qoi[pos++];
+        px.a = qoi[pos++];
+      } else if ((b1 & 0xC0) == 0x00) {
+        px = index[b1];
+      } else if ((b1 & 0xC0) == 0x40) {
+        px.r = static_cast<uint8_t>(px.r + ((b1 >> 4) & 3) - 2);
+        px.g = static_cast<uint8_t>(px.g + ((b1 >> 2) & 3) - 2);
+        px.b = static_cast<uint8_t>(px.b + (b1 & 3) - 2);
+      } else if ((b1 & 0xC0) == 0x80) {
+        if (pos + 1 > chunks_end) return false;
+        const uint8_t b2 = qoi[pos++];
+        const int vg = (b1 & 0x3F) - 32;
+        px.r = static_cast<uint8_t>(px.r + vg - 8 + ((b2 >> 4) & 0x0F));
+        px.g = static_cast<uint8_t>(px.g + vg);
+        px.b = static_cast<uint8_t>(px.b + vg - 8 + (b2 & 0x0F));
+      } else {
+        run = b1 & 0x3F;
+      }
+      index[(px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64] = px;
+    }
+    uint8_t* d = &out->rgba[i * 4];
+    d[0] = px.r;
+    d[1] = px.g;
+    d[2] = px.b;
+    d[3] = px.a;
+  }
+  return run == 0 && pos == chunks_end &&
+         std::memcmp(&qoi[chunks_end], kEnd, 8) == 0;
+}
+
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,26 @@
+#ifndef SCREENSHOT_CORE_TEST_QOI_TEST_DECODER_H_
+#define SCREENSHOT_CORE_TEST_QOI_TEST_DECODER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace screenshot {
+namespace test {
+
+struct DecodedQoi {
+  int width = 0;
+  int height = 0;
+  int channels = 0;
+  // Always 4 bytes per pixel.
+  std::vector<uint8_t> rgba;
+};
+
+// Straightforward QOI decoder following the specification's reference code.
+// Returns false on malformed input, including a missing end marker or
+// trailing bytes.
+bool DecodeQoi(const std::vector<uint8_t>& qoi, DecodedQoi* out);
+
+}  // namespace test
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_TEST_QOI_TEST_DECODER_H_
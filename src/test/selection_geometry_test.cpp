@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "image_rect.h"
+#include "selection_geometry.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+// Checks |damage| against every pixel of |bounds|: each pixel whose layer
+// changes from |before| to |after| is covered exactly once, and no other
+// pixel is covered.
+void ExpectExactDamage(const PixelRect& before, const PixelRect& after,
+                       const SelectionStyle& style, const PixelRect& bounds,
+                       const std::vector<PixelRect>& damage) {
+  std::vector<int> covered(static_cast<size_t>(bounds.width) *
+                           static_cast<size_t>(bounds.height));
+  for (const PixelRect& rect : damage) {
+    ASSERT_FALSE(rect.IsEmpty());
+    ASSERT_EQ(IntersectRects(rect, bounds), rect) << "outside the bounds";
+    for (int y = rect.y; y < rect.bottom(); ++y) {
+      for (int x = rect.x; x < rect.right(); ++x) {
+        ++covered[static_cast<size_t>(y - bounds.y) *
+                      static_cast<size_t>(bounds.width) +
+                  static_cast<size_t>(x - bounds.x)];
+      }
+    }
+  }
+  for (int y = bounds.y; y < bounds.bottom(); ++y) {
+    for (int x = bounds.x; x < bounds.right(); ++x) {
+      const bool changed = SelectionLayerAt(before, style, x, y) !=
+                           SelectionLayerAt(after, style, x, y);
+      const int count =
+          covered[static_cast<size_t>(y - bounds.y) *
+                      static_cast<size_t>(bounds.width) +
+                  static_cast<size_t>(x - bounds.x)];
+      ASSERT_EQ(count, changed ? 1 : 0) << "at " << x << "," << y;
+    }
+  }
+}
+
+int64_t Area(const std::vector<PixelRect>& rects) {
+  int64_t area = 0;
+  for (const PixelRect& rect : rects) {
+    area += static_cast<int64_t>(rect.width) * rect.height;
+  }
+  return area;
+}
+
+TEST(SelectionGeometryTest, LayersFollowTheStyle) {
+  const SelectionStyle style;  // One pixel each side of the edge.
+  const PixelRect selection{10, 10, 20, 10};
+  EXPECT_EQ(SelectionLayerAt(selection, style, 8, 15),
+            SelectionLayer::kBackground);
+  EXPECT_EQ(SelectionLayerAt(selection, style, 9, 15), SelectionLayer::kBorder);
+  EXPECT_EQ(SelectionLayerAt(selection, style, 10, 15),
+            SelectionLayer::kBorder);
+  EXPECT_EQ(SelectionLayerAt(selection, style, 11, 15),
+            SelectionLayer::kInterior);
+  EXPECT_EQ(SelectionLayerAt(selection, style, 29, 15),
+            SelectionLayer::kBorder);
+  EXPECT_EQ(SelectionLayerAt(selection, style, 30, 15),
+            SelectionLayer::kBorder);
+  EXPECT_EQ(SelectionLayerAt(selection, style, 31, 15),
+            SelectionLayer::kBackground);
+  EXPECT_EQ(SelectionLayerAt(PixelRect(), style, 0, 0),
+            SelectionLayer::kBackground);
+
+  EXPECT_EQ(SelectionInterior(selection, style), (PixelRect{11, 11, 18, 8}));
+  // A selection too thin for an interior is all border.
+  EXPECT_TRUE(SelectionInterior(PixelRect{0, 0, 2, 50}, style).IsEmpty());
+  EXPECT_EQ(SelectionLayerAt(PixelRect{0, 0, 2, 50}, style, 1, 25),
+            SelectionLayer::kBorder);
+}
+
+TEST(SelectionGeometryTest, BorderStripsCoverTheBorderOnce) {
+  SelectionStyle style;
+  style.border_outside = 2;
+  style.border_inside = 3;
+  for (const PixelRect& selection :
+       {PixelRect{20, 20, 30, 25}, PixelRect{5, 5, 6, 40},
+        PixelRect{5, 5, 4, 4}, PixelRect{0, 0, 1, 1}}) {
+    SCOPED_TRACE(testing::Message() << selection.x << "," << selection.y
+                                    << " " << selection.width << "x"
+                                    << selection.height);
+    PixelRect strips[4];
+    const int count = SelectionBorder(selection, style, strips);
+    ASSERT_GE(count, 1);
+    ASSERT_LE(count, 4);
+    for (int y = -5; y < 80; ++y) {
+      for (int x = -5; x < 80; ++x) {
+        int hits = 0;
+        for (int i = 0; i < count; ++i) {
+          hits += IntersectRects(strips[i], PixelRect{x, y, 1, 1}).IsEmpty()
+                      ? 0
+                      : 1;
+        }
+        const bool border = SelectionLayerAt(selection, style, x, y) ==
+                            SelectionLayer::kBorder;
+        ASSERT_EQ(hits, border ? 1 : 0) << "at " << x << "," << y;
+      }
+    }
+  }
+  PixelRect strips[4];
+  EXPECT_EQ(SelectionBorder(PixelRect(), style, strips), 0);
+}
+
+TEST(SelectionGeometryTest, DraggingACornerDamagesThinStrips) {
+  const SelectionStyle style;
+  const PixelRect bounds{0, 0, 3840, 2160};
+  std::vector<PixelRect> damage;
+
+  // Growing by a few pixels to the lower right: the old right and bottom
+  // borders and the newly exposed strips, nothing more.
+  const PixelRect before{100, 100, 1000, 600};
+  const PixelRect after{100, 100, 1004, 603};
+  SelectionDamage(before, after, style, bounds, &damage);
+  EXPECT_LE(damage.size(), 4u);
+  EXPECT_LT(Area(damage), 2 * (1004 + 603) * 8);
+
+  // Nothing moved, nothing to repaint.
+  SelectionDamage(after, after, style, bounds, &damage);
+  EXPECT_TRUE(damage.empty());
+
+  // Starting a selection draws just its outline and fill.
+  SelectionDamage(PixelRect(), PixelRect{50, 60, 10, 10}, style, bounds,
+                  &damage);
+  EXPECT_EQ(Area(damage), 12 * 12);
+  ASSERT_EQ(damage.size(), 1u);
+  EXPECT_EQ(damage[0], (PixelRect{49, 59, 12, 12}));
+}
+
+TEST(SelectionGeometryTest, DamageIsClippedToTheBounds) {
+  const SelectionStyle style;
+  const PixelRect bounds{0, 0, 64, 48};
+  std::vector<PixelRect> damage;
+  SelectionDamage(PixelRect{-10, -10, 30, 30}, PixelRect{40, 30, 100, 100},
+                  style, bounds, &damage);
+  ExpectExactDamage(PixelRect{-10, -10, 30, 30}, PixelRect{40, 30, 100, 100},
+                    style, bounds, damage);
+  SelectionDamage(PixelRect{0, 0, 10, 10}, PixelRect{5, 5, 10, 10}, style,
+                  PixelRect(), &damage);
+  EXPECT_TRUE(damage.empty());
+}
+
+TEST(SelectionGeometryTest, DamageCoversExactlyTheChangedPixels) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> coordinate(-8, 72);
+  std::uniform_int_distribution<int> border(0, 3);
+  const PixelRect bounds{-4, -2, 64, 48};
+  std::vector<PixelRect> damage;
+  for (int trial = 0; trial < 400; ++trial) {
+    SelectionStyle style;
+    style.border_outside = border(rng);
+    style.border_inside = border(rng);
+    const PixelRect before = RectFromCorners(coordinate(rng), coordinate(rng),
+                                             coordinate(rng), coordinate(rng));
+    // Mostly small drags of one corner, as while selecting, and some jumps.
+    PixelRect after;
+    if (trial % 4 == 0) {
+      after = RectFromCorners(coordinate(rng), coordinate(rng),
+                              coordinate(rng), coordinate(rng));
+    } else {
+      std::uniform_int_distribution<int> step(-3, 3);
+      after = RectFromCorners(before.x, before.y,
+                              before.right() + step(rng),
+                              before.bottom() + step(rng));
+    }
+    SCOPED_TRACE(testing::Message() << "trial " << trial);
+    SelectionDamage(before, after, style, bounds, &damage);
+    ExpectExactDamage(before, after, style, bounds, damage);
+    if (HasFatalFailure()) return;
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
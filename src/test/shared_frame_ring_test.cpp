@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#include "encoder_session.h"
+#include "image.h"
+#include "shared_frame_ring.h"
+#include "test/test_util.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+#if !defined(_WIN32)
+// Maps |length| bytes of |slot| through its handle, the way the Dart side
+// does, and returns a copy of them.
+std::vector<uint8_t> ReadThroughHandle(const SharedFrameSlot& slot,
+                                       size_t length) {
+  void* view = mmap(nullptr, length, PROT_READ, MAP_SHARED,
+                    static_cast<int>(slot.handle),
+                    static_cast<off_t>(slot.offset));
+  EXPECT_NE(view, MAP_FAILED);
+  if (view == MAP_FAILED) return {};
+  const uint8_t* bytes = static_cast<const uint8_t*>(view);
+  std::vector<uint8_t> copy(bytes, bytes + length);
+  munmap(view, length);
+  return copy;
+}
+#endif
+
+TEST(SharedMemoryRegionTest, CreatesZeroedReadWriteMemory) {
+  std::unique_ptr<SharedMemoryRegion> region =
+      SharedMemoryRegion::Create(100000);
+  ASSERT_NE(region, nullptr);
+  EXPECT_EQ(region->size(), 100000u);
+  EXPECT_GE(region->handle(), 0);
+  EXPECT_EQ(region->data()[0], 0);
+  EXPECT_EQ(region->data()[99999], 0);
+  region->data()[99999] = 7;
+  EXPECT_EQ(region->data()[99999], 7);
+  EXPECT_EQ(SharedMemoryRegion::Create(0), nullptr);
+}
+
+TEST(SharedFrameRingTest, LeasesAlignedSlotsWithUniqueGenerations) {
+  SharedFrameRing ring;
+  SharedFrameSlot a, b, c;
+  ASSERT_EQ(ring.Acquire(1000, &a), SharedFrameStatus::kOk);
+  ASSERT_EQ(ring.Acquire(1000, &b), SharedFrameStatus::kOk);
+  ASSERT_EQ(ring.Acquire(1000, &c), SharedFrameStatus::kOk);
+  EXPECT_EQ(ring.leased(), 3u);
+  for (const SharedFrameSlot* slot : {&a, &b, &c}) {
+    EXPECT_EQ(slot->offset % SharedMemoryRegion::kMapAlignment, 0u);
+    EXPECT_EQ(slot->capacity, SharedMemoryRegion::kMapAlignment);
+    EXPECT_EQ(slot->handle, a.handle);
+  }
+  EXPECT_NE(a.offset, b.offset);
+  EXPECT_NE(b.offset, c.offset);
+  EXPECT_NE(a.generation, b.generation);
+  EXPECT_NE(b.generation, c.generation);
+}
+
+TEST(SharedFrameRingTest, FullRingWaitsForExplicitRelease) {
+  SharedFrameRingOptions options;
+  options.slots = 2;
+  SharedFrameRing ring(options);
+  SharedFrameSlot a, b, c;
+  ASSERT_EQ(ring.Acquire(10, &a), SharedFrameStatus::kOk);
+  ASSERT_EQ(ring.Acquire(10, &b), SharedFrameStatus::kOk);
+  EXPECT_EQ(ring.Acquire(10, &c), SharedFrameStatus::kNoFreeSlot);
+
+  ASSERT_TRUE(ring.Release(a.generation));
+  ASSERT_EQ(ring.Acquire(10, &c), SharedFrameStatus::kOk);
+  // The slot is recycled in place under a new generation.
+  EXPECT_EQ(c.offset, a.offset);
+  EXPECT_NE(c.generation, a.generation);
+}
+
+TEST(SharedFrameRingTest, StaleReleasesAreIgnored) {
+  SharedFrameRingOptions options;
+  options.slots = 1;
+  SharedFrameRing ring(options);
+  SharedFrameSlot a, b;
+  ASSERT_EQ(ring.Acquire(10, &a), SharedFrameStatus::kOk);
+  ASSERT_TRUE(ring.Release(a.generation));
+  EXPECT_FALSE(ring.Release(a.generation));
+  ASSERT_EQ(ring.Acquire(10, &b), SharedFrameStatus::kOk);
+  // Releasing the old lease again must not free the slot's new lease.
+  EXPECT_FALSE(ring.Release(a.generation));
+  EXPECT_EQ(ring.leased(), 1u);
+  EXPECT_FALSE(ring.Release(0));
+  EXPECT_FALSE(ring.Release(b.generation + 1));
+}
+
+TEST(SharedFrameRingTest, LargerFrameMovesToNewRegionAndKeepsOldLeases) {
+  SharedFrameRing ring;
+  SharedFrameSlot small, large;
+  ASSERT_EQ(ring.Acquire(1000, &small), SharedFrameStatus::kOk);
+  std::memset(small.data, 0x5A, 1000);
+
+  ASSERT_EQ(ring.Acquire(3 * SharedMemoryRegion::kMapAlignment + 1, &large), SharedFrameStatus::kOk);
+  EXPECT_EQ(large.capacity, 4 * SharedMemoryRegion::kMapAlignment);
+  EXPECT_NE(large.handle, small.handle);
+  // The old region lives on while the small frame is leased.
+  EXPECT_EQ(ring.regions(), 2u);
+  EXPECT_EQ(small.data[999], 0x5A);
+
+  ASSERT_TRUE(ring.Release(small.generation));
+  EXPECT_EQ(ring.regions(), 1u);
+  ASSERT_TRUE(ring.Release(large.generation));
+  EXPECT_EQ(ring.regions(), 1u);
+  EXPECT_EQ(ring.leased(), 0u);
+}
+
+// A region that cannot be created is not reported as a full ring.
+TEST(SharedFrameRingTest, ReportsRegionsThatCannotBeMapped) {
+  SharedFrameRing ring;
+  SharedFrameSlot slot;
+  EXPECT_EQ(ring.Acquire(SIZE_MAX / 2, &slot), SharedFrameStatus::kMapFailed);
+  EXPECT_EQ(ring.Acquire(SIZE_MAX, &slot), SharedFrameStatus::kMapFailed);
+  EXPECT_EQ(ring.regions(), 0u);
+  // The ring still works for frames that fit.
+  ASSERT_EQ(ring.Acquire(10, &slot), SharedFrameStatus::kOk);
+}
+
+#if !defined(_WIN32)
+TEST(SharedFrameRingTest, SlotsCanBeMappedByHandleAndOffset) {
+  SharedFrameRing ring;
+  SharedFrameSlot a, b;
+  ASSERT_EQ(ring.Acquire(5000, &a), SharedFrameStatus::kOk);
+  ASSERT_EQ(ring.Acquire(5000, &b), SharedFrameStatus::kOk);
+  const std::vector<uint8_t> first = RandomBytes(5000, 1);
+  const std::vector<uint8_t> second = RandomBytes(5000, 2);
+  std::memcpy(a.data, first.data(), first.size());
+  std::memcpy(b.data, second.data(), second.size());
+
+  EXPECT_EQ(ReadThroughHandle(a, 5000), first);
+  EXPECT_EQ(ReadThroughHandle(b, 5000), second);
+}
+
+TEST(SharedFrameRingTest, EncodesRawFramesStraightIntoTheSlot) {
+  const int width = 33;
+  const int height = 17;
+  const size_t stride = 33 * 4 + 4;
+  const std::vector<uint8_t> screen = TestPattern(width, height, stride, 4);
+  const ImageView image{screen.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  EncoderSession session;
+  SharedFrameRing ring;
+  for (CaptureFormat format : {CaptureFormat::kRawRgba, CaptureFormat::kPng,
+                               CaptureFormat::kLz4Bgra}) {
+    EncodeSettings settings;
+    settings.format = format;
+    SharedFrameSlot slot;
+    size_t length = 0;
+    size_t row_bytes = 0;
+    ASSERT_EQ(EncodeSharedFrame(&session, image, settings, &ring, &slot,
+                                &length, &row_bytes),
+              SharedFrameStatus::kOk);
+
+    ASSERT_TRUE(session.Encode(image, settings));
+    EXPECT_EQ(length, session.size());
+    EXPECT_EQ(row_bytes, session.stride());
+    EXPECT_EQ(ReadThroughHandle(slot, length),
+              std::vector<uint8_t>(session.data(),
+                                   session.data() + session.size()));
+    ASSERT_TRUE(ring.Release(slot.generation));
+  }
+}
+#endif
+
+TEST(SharedFrameRingTest, EncodeReportsFullRingAndBadImages) {
+  const std::vector<uint8_t> screen = TestPattern(8, 8, 32, 1);
+  const ImageView image{screen.data(), 8, 8, 32, PixelFormat::kBgra8};
+  EncoderSession session;
+  SharedFrameRingOptions options;
+  options.slots = 1;
+  SharedFrameRing ring(options);
+  EncodeSettings settings;
+  settings.format = CaptureFormat::kRawBgra;
+  SharedFrameSlot slot;
+  size_t length = 0;
+  size_t row_bytes = 0;
+  ASSERT_EQ(EncodeSharedFrame(&session, image, settings, &ring, &slot,
+                              &length, &row_bytes),
+            SharedFrameStatus::kOk);
+  for (CaptureFormat format : {CaptureFormat::kRawBgra, CaptureFormat::kQoi}) {
+    settings.format = format;
+    SharedFrameSlot other;
+    EXPECT_EQ(EncodeSharedFrame(&session, image, settings, &ring, &other,
+                                &length, &row_bytes),
+              SharedFrameStatus::kNoFreeSlot);
+  }
+  EXPECT_EQ(EncodeSharedFrame(&session, ImageView(), settings, &ring, &slot,
+                              &length, &row_bytes),
+            SharedFrameStatus::kEncodeFailed);
+  EXPECT_EQ(ring.leased(), 1u);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "image.h"
+#include "image_rect.h"
+#include "synthetic_screen.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+// Captures |rect| of the next frame, packed.
+std::vector<uint8_t> CaptureRect(SyntheticScreen* screen,
+                                 const PixelRect& rect, bool cursor = false) {
+  const size_t stride = static_cast<size_t>(rect.width) * kBytesPerPixel;
+  std::vector<uint8_t> pixels(stride * static_cast<size_t>(rect.height));
+  EXPECT_TRUE(screen->Capture(rect, cursor, pixels.data(), stride));
+  return pixels;
+}
+
+std::vector<uint8_t> CaptureAll(SyntheticScreen* screen, bool cursor = false) {
+  return CaptureRect(screen, screen->Bounds(), cursor);
+}
+
+uint32_t PixelAt(const std::vector<uint8_t>& pixels, int width, int x, int y) {
+  uint32_t bgra = 0;
+  const size_t offset =
+      (static_cast<size_t>(y) * static_cast<size_t>(width) +
+       static_cast<size_t>(x)) *
+      kBytesPerPixel;
+  std::memcpy(&bgra, pixels.data() + offset, sizeof(bgra));
+  return bgra;
+}
+
+// The bounding box of the pixels that differ between two full frames.
+PixelRect ChangedArea(const std::vector<uint8_t>& a,
+                      const std::vector<uint8_t>& b, int width, int height) {
+  int left = width;
+  int top = height;
+  int right = 0;
+  int bottom = 0;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      if (PixelAt(a, width, x, y) != PixelAt(b, width, x, y)) {
+        left = std::min(left, x);
+        top = std::min(top, y);
+        right = std::max(right, x + 1);
+        bottom = std::max(bottom, y + 1);
+      }
+    }
+  }
+  if (right == 0) return PixelRect{};
+  return PixelRect{left, top, right - left, bottom - top};
+}
+
+PixelRect BoundingRect(const PixelRect& a, const PixelRect& b) {
+  const int left = std::min(a.x, b.x);
+  const int top = std::min(a.y, b.y);
+  return PixelRect{left, top, std::max(a.right(), b.right()) - left,
+                   std::max(a.bottom(), b.bottom()) - top};
+}
+
+bool Contains(const PixelRect& outer, const PixelRect& inner) {
+  return inner.x >= outer.x && inner.y >= outer.y &&
+         inner.right() <= outer.right() && inner.bottom() <= outer.bottom();
+}
+
+SyntheticScreenOptions Small() {
+  SyntheticScreenOptions options;
+  options.width = 640;
+  options.height = 360;
+  return options;
+}
+
+TEST(SyntheticScreenTest, IsDeterministic) {
+  SyntheticScreen a(Small());
+  SyntheticScreen b(Small());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(CaptureAll(&a, true), CaptureAll(&b, true)) << "frame " << i;
+  }
+  EXPECT_EQ(3u, a.frame());
+
+  SyntheticScreenOptions other = Small();
+  other.seed = 2;
+  SyntheticScreen c(other);
+  a.set_frame(0);
+  EXPECT_NE(CaptureAll(&a), CaptureAll(&c));
+}
+
+TEST(SyntheticScreenTest, LooksLikeADesktop) {
+  SyntheticScreen screen(Small());
+  const std::vector<uint8_t> frame = CaptureAll(&screen);
+  std::set<uint32_t> colors;
+  for (size_t i = 0; i < frame.size(); i += kBytesPerPixel) {
+    uint32_t bgra = 0;
+    std::memcpy(&bgra, frame.data() + i, sizeof(bgra));
+    EXPECT_EQ(0xFFu, bgra >> 24);
+    colors.insert(bgra);
+  }
+  // Flat chrome, anti-alias-free text and a noisy photo: many colors, but
+  // far fewer than pixels.
+  EXPECT_GT(colors.size(), 1000u);
+  EXPECT_LT(colors.size(), frame.size() / kBytesPerPixel / 4);
+
+  const PixelRect& scroll = screen.scroll_area();
+  const PixelRect& animation = screen.animation_area();
+  EXPECT_FALSE(scroll.IsEmpty());
+  EXPECT_FALSE(animation.IsEmpty());
+  EXPECT_TRUE(IntersectRects(scroll, animation).IsEmpty());
+  EXPECT_TRUE(Contains(screen.Bounds(), scroll));
+  EXPECT_TRUE(Contains(screen.Bounds(), animation));
+}
+
+TEST(SyntheticScreenTest, ChangesOnlyInsideTheMovingAreas) {
+  SyntheticScreen screen(Small());
+  const std::vector<uint8_t> first = CaptureAll(&screen);
+  const std::vector<uint8_t> second = CaptureAll(&screen);
+  const std::vector<uint8_t> third = CaptureAll(&screen);
+  const PixelRect scroll = screen.scroll_area();
+  const PixelRect animation = screen.animation_area();
+  for (const auto* next : {&second, &third}) {
+    // Outside the moving areas every frame is the same.
+    std::vector<uint8_t> a = first;
+    std::vector<uint8_t> b = *next;
+    for (const PixelRect& area : {scroll, animation}) {
+      for (int y = area.y; y < area.bottom(); ++y) {
+        const size_t offset = (static_cast<size_t>(y) * 640 +
+                               static_cast<size_t>(area.x)) *
+                              4;
+        std::memset(a.data() + offset, 0, static_cast<size_t>(area.width) * 4);
+        std::memset(b.data() + offset, 0, static_cast<size_t>(area.width) * 4);
+      }
+    }
+    EXPECT_EQ(a, b);
+  }
+  const PixelRect changed = ChangedArea(first, second, 640, 360);
+  EXPECT_FALSE(changed.IsEmpty());
+  EXPECT_TRUE(Contains(BoundingRect(scroll, animation), changed));
+}
+
+TEST(SyntheticScreenTest, ChangeRateControlsHowOftenFramesChange) {
+  SyntheticScreenOptions options = Small();
+  options.change_rate = 0.0;
+  SyntheticScreen still(options);
+  const std::vector<uint8_t> first = CaptureAll(&still, true);
+  for (int i = 0; i < 4; ++i) EXPECT_EQ(first, CaptureAll(&still, true));
+
+  options.change_rate = 0.5;
+  SyntheticScreen half(options);
+  std::vector<std::vector<uint8_t>> frames;
+  for (int i = 0; i < 5; ++i) frames.push_back(CaptureAll(&half));
+  EXPECT_EQ(frames[0], frames[1]);
+  EXPECT_NE(frames[1], frames[2]);
+  EXPECT_EQ(frames[2], frames[3]);
+  EXPECT_NE(frames[3], frames[4]);
+  EXPECT_EQ(2u, half.ChangesAt(4));
+}
+
+TEST(SyntheticScreenTest, ScrollsTheDocumentUp) {
+  SyntheticScreenOptions options = Small();
+  options.scroll_step = 5;
+  SyntheticScreen screen(options);
+  const PixelRect scroll = screen.scroll_area();
+  ASSERT_GT(scroll.height, 5);
+  const std::vector<uint8_t> first = CaptureRect(&screen, scroll);
+  const std::vector<uint8_t> second = CaptureRect(&screen, scroll);
+  const size_t stride = static_cast<size_t>(scroll.width) * 4;
+  // Row y + 5 of the first frame is row y of the second.
+  for (int y = 0; y + 5 < scroll.height; ++y) {
+    ASSERT_EQ(0,
+              std::memcmp(first.data() + (static_cast<size_t>(y) + 5) * stride,
+                          second.data() + static_cast<size_t>(y) * stride,
+                          stride))
+        << "row " << y;
+  }
+}
+
+TEST(SyntheticScreenTest, SubRectMatchesFullFrameAndKeepsPadding) {
+  SyntheticScreen full(Small());
+  SyntheticScreen part(Small());
+  full.set_frame(7);
+  part.set_frame(7);
+  const std::vector<uint8_t> frame = CaptureAll(&full, true);
+
+  // Straddles the editor, the photo viewer and the media player.
+  const PixelRect rect{300, 20, 200, 300};
+  const size_t stride = 200 * 4 + 24;
+  std::vector<uint8_t> pixels(stride * 300, 0xCD);
+  ASSERT_TRUE(part.Capture(rect, true, pixels.data(), stride));
+  for (int y = 0; y < rect.height; ++y) {
+    const uint8_t* row = pixels.data() + static_cast<size_t>(y) * stride;
+    ASSERT_EQ(0, std::memcmp(row,
+                             frame.data() +
+                                 (static_cast<size_t>(y + rect.y) * 640 +
+                                  static_cast<size_t>(rect.x)) *
+                                     4,
+                             200 * 4))
+        << "row " << y;
+    for (size_t i = 200 * 4; i < stride; ++i) ASSERT_EQ(0xCD, row[i]);
+  }
+}
+
+TEST(SyntheticScreenTest, DrawsTheCursorOnlyWhenAsked) {
+  SyntheticScreen with(Small());
+  SyntheticScreen without(Small());
+  const PixelRect cursor = with.CursorRect(0);
+  const std::vector<uint8_t> a = CaptureAll(&with, true);
+  const std::vector<uint8_t> b = CaptureAll(&without, false);
+  const PixelRect changed = ChangedArea(a, b, 640, 360);
+  EXPECT_FALSE(changed.IsEmpty());
+  EXPECT_TRUE(Contains(cursor, changed));
+  // The cursor moves with the content.
+  EXPECT_NE(cursor.x, with.CursorRect(1).x);
+}
+
+TEST(SyntheticScreenTest, RejectsRectsOutsideTheScreen) {
+  SyntheticScreen screen(Small());
+  std::vector<uint8_t> pixels(64 * 64 * 4);
+  for (const PixelRect& rect :
+       {PixelRect{0, 0, 0, 10}, PixelRect{-1, 0, 10, 10},
+        PixelRect{600, 0, 64, 10}, PixelRect{0, 350, 10, 11}}) {
+    EXPECT_FALSE(screen.Capture(rect, false, pixels.data(), 64 * 4));
+  }
+  EXPECT_EQ(0u, screen.frame());
+}
+
+TEST(SyntheticScreenTest, ScalesFromTinyToHighDpi) {
+  for (const auto& size : {std::pair<int, int>{1, 1}, {7, 5}, {3840, 2160}}) {
+    SyntheticScreenOptions options;
+    options.width = size.first;
+    options.height = size.second;
+    SyntheticScreen screen(options);
+    EXPECT_EQ(size.first, screen.Bounds().width);
+    EXPECT_EQ(size.second, screen.Bounds().height);
+    const std::vector<uint8_t> a = CaptureAll(&screen, true);
+    const std::vector<uint8_t> b = CaptureAll(&screen, true);
+    EXPECT_EQ(a.size(), b.size());
+  }
+  SyntheticScreenOptions options;
+  options.width = 3840;
+  options.height = 2160;
+  SyntheticScreen screen(options);
+  // Chrome and cursor are drawn at twice the size.
+  EXPECT_EQ(24, screen.CursorRect(0).width);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,85 @@
+#include "test/test_util.h"
+
+#include <random>
+
+namespace screenshot {
+namespace test {
+
+ScopedCpuFeatures::ScopedCpuFeatures(const CpuFeatures& features)
+    : features_(features) {
+  OverrideCpuFeaturesForTesting(&features_);
+}
+
+ScopedCpuFeatures::~ScopedCpuFeatures() {
+  OverrideCpuFeaturesForTesting(nullptr);
+}
+
+std::vector<CpuFeatures> FeatureLevels() {
+  const CpuFeatures host = GetCpuFeatures();
+  std::vector<CpuFeatures> levels;
+  levels.push_back(CpuFeatures());
+  CpuFeatures f;
+  f.sse2 = host.sse2;
+  levels.push_back(f);
+  f.ssse3 = host.ssse3;
+  f.sse41 = host.sse41;
+  f.pclmul = host.pclmul;
+  levels.push_back(f);
+  levels.push_back(host);
+  return levels;
+}
+
+std::vector<uint8_t> RandomBytes(size_t n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> bytes(n);
+  for (auto& b : bytes) b = static_cast<uint8_t>(rng());
+  return bytes;
+}
+
+std::vector<uint8_t> TestPattern(int width, int height, size_t stride,
+                                 uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> pixels(stride * static_cast<size_t>(height), 0xCD);
+  for (int y = 0; y < height; ++y) {
+    uint8_t* row = pixels.data() + static_cast<size_t>(y) * stride;
+    for (int x = 0; x < width; ++x) {
+      uint8_t* p = row + static_cast<size_t>(x) * 4;
+      if (y < height / 8) {
+        p[0] = 0x30; p[1] = 0x30; p[2] = 0x30;  // title bar
+      } else if (x < width / 4) {
+        p[0] = static_cast<uint8_t>(x * 255 / width);
+        p[1] = static_cast<uint8_t>(y * 255 / height);
+        p[2] = 0x80;
+      } else if (x > width * 3 / 4 && y > height / 2) {
+        const uint32_t r = rng();
+        p[0] = static_cast<uint8_t>(r);
+        p[1] = static_cast<uint8_t>(r >> 8);
+        p[2] = static_cast<uint8_t>(r >> 16);
+      } else {
+        const bool ink = (rng() % 11) == 0 && (y % 16) < 10;
+        p[0] = p[1] = p[2] = ink ? 0x10 : 0xF0;
+      }
+      p[3] = static_cast<uint8_t>(rng() % 3 == 0 ? 0 : 0xFF);
+    }
+  }
+  return pixels;
+}
+
+std::vector<uint8_t> ExpectedRgba(const uint8_t* bgra, int width, int height,
+                                  size_t stride, bool force_opaque) {
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const uint8_t* s = bgra + static_cast<size_t>(y) * stride + x * 4;
+      uint8_t* d = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+      d[0] = s[2];
+      d[1] = s[1];
+      d[2] = s[0];
+      d[3] = force_opaque ? 0xFF : s[3];
+    }
+  }
+  return rgba;
+}
+
+}  // namespace test
+}  // namespace screenshot
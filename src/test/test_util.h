@@ -0,0 +1,46 @@
+#ifndef SCREENSHOT_CORE_TEST_TEST_UTIL_H_
+#define SCREENSHOT_CORE_TEST_TEST_UTIL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cpu_features.h"
+
+namespace screenshot {
+namespace test {
+
+// Restores CPU feature detection when a test that narrows it finishes.
+class ScopedCpuFeatures {
+ public:
+  explicit ScopedCpuFeatures(const CpuFeatures& features);
+  ~ScopedCpuFeatures();
+
+  ScopedCpuFeatures(const ScopedCpuFeatures&) = delete;
+  ScopedCpuFeatures& operator=(const ScopedCpuFeatures&) = delete;
+
+ private:
+  CpuFeatures features_;
+};
+
+// Feature sets from scalar-only up to everything the host supports, so each
+// kernel gets compared with the scalar path.
+std::vector<CpuFeatures> FeatureLevels();
+
+std::vector<uint8_t> RandomBytes(size_t n, uint32_t seed);
+
+// BGRA frame with flat UI-like areas, a gradient, text-like noise and a
+// photo-like random patch, of any size and stride down to 1x1. Alpha is
+// random, as it is for GDI captures. Tests that need a realistic, animated
+// desktop capture from screenshot::SyntheticScreen instead.
+std::vector<uint8_t> TestPattern(int width, int height, size_t stride,
+                                 uint32_t seed);
+
+// Packed RGBA copy of a BGRA image.
+std::vector<uint8_t> ExpectedRgba(const uint8_t* bgra, int width, int height,
+                                  size_t stride, bool force_opaque);
+
+}  // namespace test
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_TEST_TEST_UTIL_H_
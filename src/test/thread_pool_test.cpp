@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "test/allocation_counter.h"
+#include "thread_pool.h"
+
+namespace screenshot {
+namespace test {
+
+TEST(ThreadPoolTest, ParallelForRunsEveryIndexOnce) {
+  ThreadPool pool(3);
+  for (size_t count : {0u, 1u, 2u, 7u, 100u}) {
+    std::vector<std::atomic<int>> hits(count);
+    pool.ParallelFor(count, [&](size_t i) { hits[i].fetch_add(1); });
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(1, hits[i].load()) << "count=" << count << " i=" << i;
+    }
+  }
+}
+
+TEST(ThreadPoolTest, ParallelForCompletesFromInsideAWorker) {
+  ThreadPool pool(1);
+  std::atomic<int> total{0};
+  pool.ParallelFor(2, [&](size_t) {
+    pool.ParallelFor(4, [&](size_t) { total.fetch_add(1); });
+  });
+  EXPECT_EQ(8, total.load());
+}
+
+TEST(ThreadPoolTest, ParallelForDoesNotAllocateOnceWarm) {
+  ThreadPool pool(3);
+  std::vector<int> values(64, 0);
+  auto run = [&] {
+    pool.ParallelFor(values.size(), [&](size_t i) { values[i] += 1; });
+  };
+  run();
+  run();
+  const uint64_t before = AllocationCount();
+  for (int i = 0; i < 20; ++i) run();
+  const uint64_t allocations = AllocationCount() - before;
+  EXPECT_EQ(0u, allocations);
+  for (int value : values) EXPECT_EQ(22, value);
+}
+
+TEST(ThreadPoolTest, DestructorRunsQueuedTasks) {
+  std::atomic<int> ran{0};
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < 50; ++i) pool.Post([&] { ran.fetch_add(1); });
+  }
+  EXPECT_EQ(50, ran.load());
+}
+
+}  // namespace test
+}  // namespace screenshot
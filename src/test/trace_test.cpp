@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture_source.h"
+#include "frame_pool.h"
+#include "synthetic_screen.h"
+#include "trace.h"
+
+namespace screenshot {
+namespace test {
+namespace {
+
+// The spans named |name| in |trace|.
+size_t CountSpans(const std::vector<TraceThread>& trace, const char* name) {
+  size_t count = 0;
+  for (const TraceThread& thread : trace) {
+    for (const TraceEvent& event : thread.events) {
+      if (std::string(event.name) == name) ++count;
+    }
+  }
+  return count;
+}
+
+size_t CountOccurrences(const std::string& text, const std::string& part) {
+  size_t count = 0;
+  for (size_t at = text.find(part); at != std::string::npos;
+       at = text.find(part, at + part.size())) {
+    ++count;
+  }
+  return count;
+}
+
+TEST(TraceRingTest, KeepsTheNewestSpansOldestFirst) {
+  TraceRing ring(5);
+  EXPECT_EQ(8u, ring.capacity());
+  for (int64_t i = 0; i < 20; ++i) ring.Append("span", i * 10, i);
+  std::vector<TraceEvent> events;
+  ring.Read(&events);
+  ASSERT_EQ(8u, events.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_STREQ("span", events[i].name);
+    EXPECT_EQ(static_cast<int64_t>(12 + i), events[i].duration_nanos);
+    EXPECT_EQ(events[i].duration_nanos * 10, events[i].start_nanos);
+  }
+  EXPECT_EQ(12u, ring.overwritten());
+}
+
+TEST(TraceRingTest, ClearHidesEarlierSpans) {
+  TraceRing ring(16);
+  ring.Append("before", 0, 1);
+  ring.Clear();
+  std::vector<TraceEvent> events;
+  ring.Read(&events);
+  EXPECT_TRUE(events.empty());
+  EXPECT_EQ(0u, ring.overwritten());
+  ring.Append("after", 2, 3);
+  ring.Read(&events);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_STREQ("after", events[0].name);
+}
+
+TEST(TraceRingTest, ReadsWhileTheOwnerAppendsNeverTearASpan) {
+  TraceRing ring(64);
+  std::atomic<bool> done{false};
+  // Every span's start is 1000 times its duration, so a span mixing the
+  // fields of two appends shows.
+  std::thread writer([&ring, &done] {
+    for (int64_t i = 1; i <= 200000; ++i) ring.Append("span", i * 1000, i);
+    done.store(true);
+  });
+  std::vector<TraceEvent> events;
+  size_t reads = 0;
+  while (!done.load() || reads == 0) {
+    events.clear();
+    ring.Read(&events);
+    for (size_t i = 0; i < events.size(); ++i) {
+      ASSERT_EQ(events[i].duration_nanos * 1000, events[i].start_nanos);
+      if (i > 0) {
+        ASSERT_LT(events[i - 1].duration_nanos, events[i].duration_nanos);
+      }
+    }
+    ++reads;
+  }
+  writer.join();
+  events.clear();
+  ring.Read(&events);
+  ASSERT_EQ(64u, events.size());
+  EXPECT_EQ(200000, events.back().duration_nanos);
+}
+
+TEST(TraceTest, SpansAreOnlyRecordedWhileTracing) {
+  StopTracing();
+  { TraceSpan span("untraced"); }
+  StartTracing();
+  EXPECT_TRUE(TracingEnabled());
+  { TraceSpan span("traced"); }
+  StopTracing();
+  { TraceSpan span("untraced"); }
+  const std::vector<TraceThread> trace = CollectTrace();
+  EXPECT_EQ(1u, CountSpans(trace, "traced"));
+  EXPECT_EQ(0u, CountSpans(trace, "untraced"));
+
+  // Starting again drops what was recorded.
+  StartTracing();
+  StopTracing();
+  EXPECT_EQ(0u, CountSpans(CollectTrace(), "traced"));
+}
+
+TEST(TraceTest, CollectsEveryThreadIncludingExitedOnes) {
+  StartTracing();
+  SetTraceThreadName("main");
+  { TraceSpan span("on main"); }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t) {
+    threads.emplace_back([] {
+      SetTraceThreadName("helper");
+      for (int i = 0; i < 10; ++i) TraceSpan span("on helper");
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  StopTracing();
+
+  const std::vector<TraceThread> trace = CollectTrace();
+  EXPECT_EQ(1u, CountSpans(trace, "on main"));
+  EXPECT_EQ(30u, CountSpans(trace, "on helper"));
+  size_t helpers = 0;
+  for (const TraceThread& thread : trace) {
+    if (thread.name == "helper") {
+      ++helpers;
+      EXPECT_EQ(10u, thread.events.size());
+    }
+  }
+  EXPECT_EQ(3u, helpers);
+  SetTraceThreadName(nullptr);
+}
+
+TEST(TraceTest, InstrumentedCapturesRecordTheirStages) {
+  SyntheticScreenOptions options;
+  options.width = 320;
+  options.height = 200;
+  SyntheticScreen screen(options);
+  FramePool pool;
+  StartTracing();
+  FramePool::Lease frame = CaptureToPool(&screen, &pool, screen.Bounds(), true);
+  StopTracing();
+  ASSERT_TRUE(frame);
+  const std::vector<TraceThread> trace = CollectTrace();
+  EXPECT_EQ(1u, CountSpans(trace, "capture"));
+  EXPECT_EQ(1u, CountSpans(trace, "cursor"));
+}
+
+TEST(TraceTest, FormatsChromeTraceEvents) {
+  std::vector<TraceThread> trace(2);
+  trace[0].id = 1;
+  trace[0].name = "capture";
+  trace[0].events.push_back(TraceEvent{"capture", 1234567, 2500});
+  trace[1].id = 7;
+  trace[1].events.push_back(TraceEvent{"enc\"ode", 2000000, 999});
+  trace[1].overwritten = 3;
+  const std::string json = FormatChromeTrace(trace);
+
+  EXPECT_EQ(0u, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  EXPECT_NE(std::string::npos,
+            json.find("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                      "\"tid\":1,\"args\":{\"name\":\"capture\"}}"));
+  EXPECT_NE(std::string::npos,
+            json.find("{\"name\":\"capture\",\"cat\":\"screenshot\","
+                      "\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":1234.567,"
+                      "\"dur\":2.500}"));
+  EXPECT_NE(std::string::npos,
+            json.find("{\"name\":\"enc\\\"ode\",\"cat\":\"screenshot\","
+                      "\"ph\":\"X\",\"pid\":1,\"tid\":7,\"ts\":2000.000,"
+                      "\"dur\":0.999}"));
+  // The unnamed thread has no metadata event.
+  EXPECT_EQ(1u, CountOccurrences(json, "thread_name"));
+  EXPECT_EQ(2u, CountOccurrences(json, "\"ph\":\"X\""));
+  EXPECT_NE(std::string::npos,
+            json.find("\"otherData\":{\"overwrittenSpans\":3}}"));
+  EXPECT_EQ('}', json.back());
+
+  EXPECT_EQ(
+      "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n],"
+      "\"otherData\":{\"overwrittenSpans\":0}}",
+      FormatChromeTrace({}));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace screenshot
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "image.h"
+#include "test/test_util.h"
+#include "webp_encoder.h"
+
+namespace screenshot {
+namespace test {
+
+TEST(WebpEncoderTest, FailsCleanlyWithoutLibwebp) {
+  if (WebpEncoder::IsAvailable()) GTEST_SKIP() << "built with libwebp";
+  uint8_t pixel[4] = {};
+  WebpEncoder encoder;
+  std::vector<uint8_t> webp;
+  EXPECT_FALSE(encoder.Encode(ImageView{pixel, 1, 1, 4}, &webp));
+}
+
+TEST(WebpEncoderTest, WritesRiffContainerAndHonorsQuality) {
+  if (!WebpEncoder::IsAvailable()) GTEST_SKIP() << "libwebp not found";
+  const int width = 320;
+  const int height = 240;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const std::vector<uint8_t> pixels = TestPattern(width, height, stride, 1);
+  const ImageView image{pixels.data(), width, height, stride,
+                        PixelFormat::kBgra8};
+  size_t last_size = 0;
+  for (int quality : {20, 60, 95}) {
+    WebpEncodeOptions options;
+    options.quality = quality;
+    WebpEncoder encoder(options);
+    std::vector<uint8_t> webp;
+    ASSERT_TRUE(encoder.Encode(image, &webp));
+    ASSERT_GT(webp.size(), 12u);
+    EXPECT_EQ(0, std::memcmp(webp.data(), "RIFF", 4));
+    EXPECT_EQ(0, std::memcmp(webp.data() + 8, "WEBP", 4));
+    EXPECT_GT(webp.size(), last_size);
+    last_size = webp.size();
+  }
+}
+
+}  // namespace test
+}  // namespace screenshot
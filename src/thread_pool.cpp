@@ -0,0 +1,197 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "trace.h"
+
+namespace screenshot {
+
+// Shared between ParallelFor and the helper tasks it posts. Helpers may
+// start after ParallelFor has returned, so a job goes back to the free list
+// only when its last user (the caller or a helper) releases it.
+struct ThreadPool::Job {
+  std::atomic<size_t> next{0};
+  size_t count = 0;
+  void (*invoke)(void*, size_t) = nullptr;
+  void* context = nullptr;
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  size_t done = 0;
+  // The caller plus the helpers that have not released the job yet.
+  std::atomic<size_t> users{0};
+  Job* next_free = nullptr;
+
+  // Claims and runs indices until none are left.
+  void Run() {
+    size_t finished = 0;
+    for (;;) {
+      const size_t i = next.fetch_add(1);
+      if (i >= count) break;
+      invoke(context, i);
+      ++finished;
+    }
+    if (finished == 0) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    done += finished;
+    if (done == count) done_cv.notify_all();
+  }
+};
+
+ThreadPool::ThreadPool(int threads) {
+  if (threads < 1) threads = 1;
+  // Enough jobs and queue slots for the caller plus one helper per worker,
+  // so a ParallelFor that is not nested in another never has to allocate.
+  tasks_.resize(std::max<size_t>(16, static_cast<size_t>(threads) * 2));
+  for (int i = 0; i <= threads; ++i) {
+    jobs_.push_back(std::make_unique<Job>());
+    jobs_.back()->next_free = free_jobs_;
+    free_jobs_ = jobs_.back().get();
+  }
+  workers_.reserve(static_cast<size_t>(threads));
+  for (int i = 0; i < threads; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+int ThreadPool::DefaultThreadCount() {
+  const unsigned int cores = std::thread::hardware_concurrency();
+  return cores == 0 ? 1 : static_cast<int>(cores);
+}
+
+void ThreadPool::Post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    PushTaskLocked(Task{std::move(task), nullptr});
+  }
+  cv_.notify_one();
+}
+
+void ThreadPool::RunParallel(size_t count, void (*invoke)(void*, size_t),
+                             void* context) {
+  if (count == 0) return;
+  if (count == 1) {
+    invoke(context, 0);
+    return;
+  }
+  const size_t helpers = std::min(count - 1, workers_.size());
+  Job* job = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job = AcquireJobLocked();
+    job->next.store(0);
+    job->count = count;
+    job->invoke = invoke;
+    job->context = context;
+    job->done = 0;
+    job->users.store(helpers + 1);
+    for (size_t i = 0; i < helpers; ++i) {
+      PushTaskLocked(Task{nullptr, job});
+    }
+  }
+  for (size_t i = 0; i < helpers; ++i) cv_.notify_one();
+  job->Run();
+  // Every index has been claimed, so helpers that have not started yet
+  // have nothing to do; take them off the queue rather than let them pile
+  // up behind other work.
+  size_t cancelled = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled = CancelHelpersLocked(job);
+  }
+  {
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done_cv.wait(lock, [job] { return job->done == job->count; });
+  }
+  ReleaseJob(job, cancelled + 1);
+}
+
+void ThreadPool::PushTaskLocked(Task task) {
+  if (task_count_ == tasks_.size()) {
+    std::vector<Task> grown(std::max<size_t>(16, tasks_.size() * 2));
+    for (size_t i = 0; i < task_count_; ++i) {
+      grown[i] = std::move(tasks_[(task_head_ + i) % tasks_.size()]);
+    }
+    tasks_.swap(grown);
+    task_head_ = 0;
+  }
+  tasks_[(task_head_ + task_count_) % tasks_.size()] = std::move(task);
+  ++task_count_;
+}
+
+ThreadPool::Task ThreadPool::PopTaskLocked() {
+  Task task = std::move(tasks_[task_head_]);
+  tasks_[task_head_] = Task();
+  task_head_ = (task_head_ + 1) % tasks_.size();
+  --task_count_;
+  return task;
+}
+
+size_t ThreadPool::CancelHelpersLocked(const Job* job) {
+  const size_t capacity = tasks_.size();
+  size_t kept = 0;
+  for (size_t i = 0; i < task_count_; ++i) {
+    Task& task = tasks_[(task_head_ + i) % capacity];
+    if (task.job == job) continue;
+    if (kept != i) {
+      tasks_[(task_head_ + kept) % capacity] = std::move(task);
+    }
+    ++kept;
+  }
+  for (size_t i = kept; i < task_count_; ++i) {
+    tasks_[(task_head_ + i) % capacity] = Task();
+  }
+  const size_t cancelled = task_count_ - kept;
+  task_count_ = kept;
+  return cancelled;
+}
+
+ThreadPool::Job* ThreadPool::AcquireJobLocked() {
+  if (!free_jobs_) {
+    jobs_.push_back(std::make_unique<Job>());
+    return jobs_.back().get();
+  }
+  Job* job = free_jobs_;
+  free_jobs_ = job->next_free;
+  job->next_free = nullptr;
+  return job;
+}
+
+void ThreadPool::ReleaseJob(Job* job, size_t users) {
+  if (job->users.fetch_sub(users) != users) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  job->next_free = free_jobs_;
+  free_jobs_ = job;
+}
+
+void ThreadPool::WorkerLoop() {
+  SetTraceThreadName("worker");
+  for (;;) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stopping_ || task_count_ != 0; });
+      if (task_count_ == 0) return;
+      task = PopTaskLocked();
+    }
+    TraceSpan span("pool task");
+    if (task.job) {
+      task.job->Run();
+      ReleaseJob(task.job, 1);
+    } else {
+      task.fn();
+    }
+  }
+}
+
+}  // namespace screenshot
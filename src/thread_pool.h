@@ -0,0 +1,101 @@
+#ifndef SCREENSHOT_CORE_THREAD_POOL_H_
+#define SCREENSHOT_CORE_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace screenshot {
+
+// Fixed-size pool of worker threads.
+class ThreadPool {
+ public:
+  // Starts |threads| workers (at least one).
+  explicit ThreadPool(int threads);
+
+  // Finishes queued tasks, then joins the workers.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int size() const { return static_cast<int>(workers_.size()); }
+
+  // Queues |task| to run on a worker.
+  void Post(std::function<void()> task);
+
+  // Runs fn(0) ... fn(count - 1) on the workers and the calling thread and
+  // returns once all of them have finished. The caller claims indices too,
+  // so this also completes when invoked from inside a worker.
+  //
+  // |fn| is called through a reference rather than copied into a
+  // std::function, and the bookkeeping is recycled, so once the pool has
+  // run a ParallelFor of the same width this does not allocate.
+  template <typename Fn>
+  void ParallelFor(size_t count, Fn&& fn) {
+    using Callable = std::remove_reference_t<Fn>;
+    RunParallel(count, &Invoke<Callable>,
+                const_cast<void*>(static_cast<const void*>(&fn)));
+  }
+
+  // Worker count used when a caller asks for "all cores" (threads <= 0).
+  static int DefaultThreadCount();
+
+  // |threads| if positive, otherwise DefaultThreadCount().
+  static int ResolveThreadCount(int threads) {
+    return threads > 0 ? threads : DefaultThreadCount();
+  }
+
+ private:
+  // One ParallelFor; defined in the .cpp.
+  struct Job;
+
+  // A queued Post() task, or a helper for |job|.
+  struct Task {
+    std::function<void()> fn;
+    Job* job = nullptr;
+  };
+
+  template <typename Callable>
+  static void Invoke(void* context, size_t index) {
+    (*static_cast<Callable*>(context))(index);
+  }
+
+  void RunParallel(size_t count, void (*invoke)(void*, size_t),
+                   void* context);
+
+  // Queue and job free list; both require mutex_.
+  void PushTaskLocked(Task task);
+  Task PopTaskLocked();
+  Job* AcquireJobLocked();
+
+  // Removes |job|'s helpers that are still queued; returns how many.
+  size_t CancelHelpersLocked(const Job* job);
+
+  // Drops |users| references to |job|, returning it to the free list with
+  // the last one.
+  void ReleaseJob(Job* job, size_t users);
+
+  void WorkerLoop();
+
+  std::vector<std::thread> workers_;
+  // Ring buffer of queued tasks; grows when full and never shrinks.
+  std::vector<Task> tasks_;
+  size_t task_head_ = 0;
+  size_t task_count_ = 0;
+  // Every Job ever created, and the ones not in use.
+  std::vector<std::unique_ptr<Job>> jobs_;
+  Job* free_jobs_ = nullptr;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_THREAD_POOL_H_
@@ -0,0 +1,244 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace screenshot {
+
+std::atomic<bool> g_tracing_enabled(false);
+
+namespace {
+
+// A thread that has recorded a span: its ring, and how the trace shows it.
+struct ThreadTrace {
+  explicit ThreadTrace(uint32_t thread_id) : id(thread_id) {}
+
+  const uint32_t id;
+  std::atomic<const char*> name{nullptr};
+  TraceRing ring;
+};
+
+// Every ThreadTrace, held until the StartTracing() after its thread exits
+// so a trace still shows the spans of threads that have finished.
+struct TraceRegistry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadTrace>> threads;
+  uint32_t next_id = 1;
+};
+
+// Never destroyed: threads may still record while the process exits.
+TraceRegistry& Registry() {
+  static TraceRegistry* registry = new TraceRegistry();
+  return *registry;
+}
+
+// The calling thread's ThreadTrace, created by its first span, and the name
+// SetTraceThreadName() gave it (possibly before that).
+thread_local std::shared_ptr<ThreadTrace> t_trace;
+thread_local const char* t_name = nullptr;
+
+ThreadTrace* CurrentThreadTrace() {
+  if (!t_trace) {
+    TraceRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    t_trace = std::make_shared<ThreadTrace>(registry.next_id++);
+    t_trace->name.store(t_name, std::memory_order_relaxed);
+    registry.threads.push_back(t_trace);
+  }
+  return t_trace.get();
+}
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+// Nanoseconds as the microseconds trace_event times are in, to the
+// nanosecond.
+void AppendMicros(int64_t nanos, std::string* out) {
+  if (nanos < 0) nanos = 0;
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%" PRId64 ".%03d", nanos / 1000,
+                static_cast<int>(nanos % 1000));
+  out->append(buffer);
+}
+
+void AppendJsonString(const char* value, std::string* out) {
+  out->push_back('"');
+  for (const char* p = value; *p; ++p) {
+    const unsigned char c = static_cast<unsigned char>(*p);
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(static_cast<char>(c));
+    } else if (c < 0x20) {
+      char escape[8];
+      std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+      out->append(escape);
+    } else {
+      out->push_back(static_cast<char>(c));
+    }
+  }
+  out->push_back('"');
+}
+
+}  // namespace
+
+TraceRing::TraceRing(size_t capacity)
+    : slots_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 1))),
+      mask_(slots_.size() - 1) {}
+
+void TraceRing::Append(const char* name, int64_t start_nanos,
+                       int64_t duration_nanos) {
+  // Only this thread writes head_.
+  const uint64_t index = head_.load(std::memory_order_relaxed);
+  Slot& slot = slots_[static_cast<size_t>(index) & mask_];
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  // The busy mark is visible before any of the new fields.
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.start_nanos.store(start_nanos, std::memory_order_relaxed);
+  slot.duration_nanos.store(duration_nanos, std::memory_order_relaxed);
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+  head_.store(index + 1, std::memory_order_release);
+}
+
+void TraceRing::Read(std::vector<TraceEvent>* events) const {
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  const uint64_t capacity = slots_.size();
+  uint64_t begin = head > capacity ? head - capacity : 0;
+  begin = std::max(begin, floor_.load(std::memory_order_relaxed));
+  for (uint64_t index = begin; index < head; ++index) {
+    const Slot& slot = slots_[static_cast<size_t>(index) & mask_];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    // Being rewritten, or already overwritten by a later event.
+    if (sequence != 2 * index + 2) continue;
+    TraceEvent event;
+    event.name = slot.name.load(std::memory_order_relaxed);
+    event.start_nanos = slot.start_nanos.load(std::memory_order_relaxed);
+    event.duration_nanos =
+        slot.duration_nanos.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+    events->push_back(event);
+  }
+}
+
+void TraceRing::Clear() {
+  floor_.store(head_.load(std::memory_order_acquire),
+               std::memory_order_relaxed);
+}
+
+uint64_t TraceRing::overwritten() const {
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  const uint64_t floor = floor_.load(std::memory_order_relaxed);
+  const uint64_t appended = head > floor ? head - floor : 0;
+  return appended > slots_.size() ? appended - slots_.size() : 0;
+}
+
+void StartTracing() {
+  TraceRegistry& registry = Registry();
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    // A ThreadTrace only the registry holds belongs to a thread that has
+    // exited, so nothing can record into it any more.
+    registry.threads.erase(
+        std::remove_if(registry.threads.begin(), registry.threads.end(),
+                       [](const std::shared_ptr<ThreadTrace>& thread) {
+                         return thread.use_count() == 1;
+                       }),
+        registry.threads.end());
+    for (const std::shared_ptr<ThreadTrace>& thread : registry.threads) {
+      thread->ring.Clear();
+    }
+  }
+  g_tracing_enabled.store(true, std::memory_order_relaxed);
+}
+
+void StopTracing() {
+  g_tracing_enabled.store(false, std::memory_order_relaxed);
+}
+
+void SetTraceThreadName(const char* name) {
+  t_name = name;
+  if (t_trace) t_trace->name.store(name, std::memory_order_relaxed);
+}
+
+void RecordTraceSpan(const char* name, int64_t start_nanos,
+                     int64_t duration_nanos) {
+  CurrentThreadTrace()->ring.Append(name, start_nanos, duration_nanos);
+}
+
+std::vector<TraceThread> CollectTrace() {
+  std::vector<std::shared_ptr<ThreadTrace>> threads;
+  {
+    TraceRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    threads = registry.threads;
+  }
+  std::vector<TraceThread> trace;
+  trace.reserve(threads.size());
+  for (const std::shared_ptr<ThreadTrace>& thread : threads) {
+    TraceThread out;
+    out.id = thread->id;
+    const char* name = thread->name.load(std::memory_order_relaxed);
+    if (name) out.name = name;
+    thread->ring.Read(&out.events);
+    out.overwritten = thread->ring.overwritten();
+    if (out.events.empty()) continue;
+    trace.push_back(std::move(out));
+  }
+  return trace;
+}
+
+std::string FormatChromeTrace(const std::vector<TraceThread>& threads) {
+  size_t events = 0;
+  uint64_t overwritten = 0;
+  for (const TraceThread& thread : threads) {
+    events += thread.events.size();
+    overwritten += thread.overwritten;
+  }
+  std::string json;
+  json.reserve(64 + threads.size() * 96 + events * 112);
+  json.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool first = true;
+  auto begin_event = [&json, &first] {
+    if (!first) json.push_back(',');
+    first = false;
+    json.append("\n{");
+  };
+  for (const TraceThread& thread : threads) {
+    const std::string tid = std::to_string(thread.id);
+    if (!thread.name.empty()) {
+      begin_event();
+      json.append("\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+      json.append(tid);
+      json.append(",\"args\":{\"name\":");
+      AppendJsonString(thread.name.c_str(), &json);
+      json.append("}}");
+    }
+    for (const TraceEvent& event : thread.events) {
+      begin_event();
+      json.append("\"name\":");
+      AppendJsonString(event.name ? event.name : "", &json);
+      json.append(",\"cat\":\"screenshot\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+      json.append(tid);
+      json.append(",\"ts\":");
+      AppendMicros(event.start_nanos, &json);
+      json.append(",\"dur\":");
+      AppendMicros(event.duration_nanos, &json);
+      json.push_back('}');
+    }
+  }
+  json.append("\n],\"otherData\":{\"overwrittenSpans\":");
+  json.append(std::to_string(overwritten));
+  json.append("}}");
+  return json;
+}
+
+std::string ExportChromeTrace() { return FormatChromeTrace(CollectTrace()); }
+
+}  // namespace screenshot
@@ -0,0 +1,148 @@
+#ifndef SCREENSHOT_CORE_TRACE_H_
+#define SCREENSHOT_CORE_TRACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "capture_stats.h"
+
+namespace screenshot {
+
+// Opt-in span tracing of the capture pipeline, for the outliers aggregate
+// stats cannot explain.
+//
+// While tracing is on, each TraceSpan records its name, start and duration
+// into a fixed-size ring of the thread it ran on, without a lock or an
+// allocation; when a ring is full the oldest spans are overwritten. The
+// spans of every thread are exported on demand as Chrome trace_event JSON,
+// which chrome://tracing and Perfetto (ui.perfetto.dev) load as is. While
+// tracing is off, a span is a relaxed load and a branch.
+
+// One recorded span. |name| is a string literal (or otherwise outlives the
+// trace); times are steady-clock nanoseconds, as MonotonicNanos().
+struct TraceEvent {
+  const char* name = nullptr;
+  int64_t start_nanos = 0;
+  int64_t duration_nanos = 0;
+};
+
+// The last spans of one thread: a single-producer ring that any thread can
+// read while its owner appends.
+//
+// Each slot is guarded by a sequence number (a seqlock): Append() marks
+// the slot busy, writes it and marks it with the event's index, and Read()
+// keeps only the slots whose mark is unchanged across the read, so it
+// never returns a half-written span.
+class TraceRing {
+ public:
+  // |capacity| is rounded up to a power of two.
+  explicit TraceRing(size_t capacity = kDefaultCapacity);
+
+  TraceRing(const TraceRing&) = delete;
+  TraceRing& operator=(const TraceRing&) = delete;
+
+  // Owning thread only.
+  void Append(const char* name, int64_t start_nanos, int64_t duration_nanos);
+
+  // Appends the spans still in the ring, oldest first, to |events|.
+  void Read(std::vector<TraceEvent>* events) const;
+
+  // Hides the spans appended so far from Read(). A span being appended
+  // concurrently may survive.
+  void Clear();
+
+  size_t capacity() const { return slots_.size(); }
+
+  // Spans appended since the last Clear() that were overwritten.
+  uint64_t overwritten() const;
+
+  static constexpr size_t kDefaultCapacity = 4096;
+
+ private:
+  struct Slot {
+    // 2 * index + 2 once event |index| is written, odd while it is.
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> start_nanos{0};
+    std::atomic<int64_t> duration_nanos{0};
+  };
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  // Events appended, and the first one Read() returns.
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> floor_{0};
+};
+
+// The spans of one thread, for FormatChromeTrace().
+struct TraceThread {
+  uint32_t id = 0;
+  std::string name;
+  std::vector<TraceEvent> events;
+  uint64_t overwritten = 0;
+};
+
+// Set by StartTracing() and StopTracing(); read it through
+// TracingEnabled().
+extern std::atomic<bool> g_tracing_enabled;
+
+inline bool TracingEnabled() {
+  return g_tracing_enabled.load(std::memory_order_relaxed);
+}
+
+// Drops the spans recorded so far and starts recording.
+void StartTracing();
+
+// Stops recording; the spans recorded stay until the next StartTracing().
+void StopTracing();
+
+// Names the calling thread in the trace, such as "capture" or "encode".
+// |name| must outlive the trace; a string literal is best.
+void SetTraceThreadName(const char* name);
+
+// Records a span on the calling thread's ring, whether or not tracing is
+// enabled; TraceSpan is the usual way in.
+void RecordTraceSpan(const char* name, int64_t start_nanos,
+                     int64_t duration_nanos);
+
+// The spans recorded since StartTracing(), of every thread that recorded
+// one (including threads that have exited since).
+std::vector<TraceThread> CollectTrace();
+
+// |threads| as a Chrome trace_event JSON object: a complete ("X") event per
+// span, timed in microseconds, a thread_name metadata event per named
+// thread, and the number of spans lost to full rings as
+// otherData.overwrittenSpans.
+std::string FormatChromeTrace(const std::vector<TraceThread>& threads);
+
+// FormatChromeTrace(CollectTrace()).
+std::string ExportChromeTrace();
+
+// Records the scope it lives in as a span named |name| (a string literal),
+// if tracing was enabled when it began.
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char* name)
+      : name_(TracingEnabled() ? name : nullptr),
+        start_nanos_(name_ ? MonotonicNanos() : 0) {}
+
+  ~TraceSpan() {
+    if (name_) {
+      RecordTraceSpan(name_, start_nanos_, MonotonicNanos() - start_nanos_);
+    }
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  const char* name_;
+  int64_t start_nanos_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_TRACE_H_
@@ -0,0 +1,95 @@
+#include "webp_encoder.h"
+
+#if SCREENSHOT_CORE_HAVE_WEBP
+#include <webp/encode.h>
+#endif
+
+namespace screenshot {
+
+WebpEncoder::WebpEncoder(const WebpEncodeOptions& options)
+    : options_(options) {}
+
+#if SCREENSHOT_CORE_HAVE_WEBP
+
+bool WebpEncoder::IsAvailable() { return true; }
+
+namespace {
+
+// Encodes |image| with |options|, handing the output to |writer| with
+// |writer_data| as the picture's custom_ptr.
+bool EncodeWebp(const WebpEncodeOptions& options, const ImageView& image,
+                WebPWriterFunction writer, void* writer_data) {
+  // VP8 frames are limited to 16383 pixels per side.
+  if (!image.IsValid() || image.width > WEBP_MAX_DIMENSION ||
+      image.height > WEBP_MAX_DIMENSION) {
+    return false;
+  }
+  WebPConfig config;
+  if (!WebPConfigInit(&config)) return false;
+  const int quality = options.quality < 0     ? 0
+                      : options.quality > 100 ? 100
+                                              : options.quality;
+  const int method = options.method < 0   ? 0
+                     : options.method > 6 ? 6
+                                          : options.method;
+  config.quality = static_cast<float>(quality);
+  config.method = method;
+  config.use_sharp_yuv = options.sharp_yuv ? 1 : 0;
+  if (!WebPValidateConfig(&config)) return false;
+
+  WebPPicture picture;
+  if (!WebPPictureInit(&picture)) return false;
+  picture.width = image.width;
+  picture.height = image.height;
+  // The "X" importers ignore the alpha byte, which screen captures leave
+  // undefined.
+  const int stride = static_cast<int>(image.stride);
+  const int imported =
+      image.format == PixelFormat::kBgra8
+          ? WebPPictureImportBGRX(&picture, image.data, stride)
+          : WebPPictureImportRGBX(&picture, image.data, stride);
+  if (!imported) {
+    WebPPictureFree(&picture);
+    return false;
+  }
+
+  picture.writer = writer;
+  picture.custom_ptr = writer_data;
+  const bool ok = WebPEncode(&config, &picture) != 0;
+  WebPPictureFree(&picture);
+  return ok;
+}
+
+int WriteToSink(const uint8_t* data, size_t size, const WebPPicture* picture) {
+  return static_cast<ByteSink*>(picture->custom_ptr)->Write(data, size) ? 1
+                                                                         : 0;
+}
+
+}  // namespace
+
+bool WebpEncoder::Encode(const ImageView& image, std::vector<uint8_t>* out) {
+  WebPMemoryWriter writer;
+  WebPMemoryWriterInit(&writer);
+  const bool ok = EncodeWebp(options_, image, WebPMemoryWrite, &writer);
+  if (ok) out->assign(writer.mem, writer.mem + writer.size);
+  WebPMemoryWriterClear(&writer);
+  return ok;
+}
+
+bool WebpEncoder::Encode(const ImageView& image, ByteSink* sink) {
+  return EncodeWebp(options_, image, WriteToSink, sink);
+}
+
+#else
+
+bool WebpEncoder::IsAvailable() { return false; }
+
+bool WebpEncoder::Encode(const ImageView&, std::vector<uint8_t>*) {
+  return false;
+}
+
+bool WebpEncoder::Encode(const ImageView&, ByteSink*) { return false; }
+
+#endif
+
+}  // namespace screenshot
@@ -0,0 +1,50 @@
+#ifndef SCREENSHOT_CORE_WEBP_ENCODER_H_
+#define SCREENSHOT_CORE_WEBP_ENCODER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "byte_sink.h"
+#include "image.h"
+
+namespace screenshot {
+
+struct WebpEncodeOptions {
+  // 0 (smallest) to 100 (best), as for cwebp -q.
+  int quality = 80;
+  // 0 (fastest) to 6 (smallest), as for cwebp -m.
+  int method = 2;
+  // Lossy WebP always stores chroma at 4:2:0; "sharp YUV" picks the
+  // subsampled values that keep colored edges (text, UI) crisp, at some
+  // extra encode time.
+  bool sharp_yuv = false;
+};
+
+// Encodes 8-bit BGRA/RGBA pixels (alpha is ignored) as a lossy WebP through
+// libwebp. libwebp is optional: when the core is built without it,
+// IsAvailable() is false and Encode() always fails. Not thread-safe.
+class WebpEncoder {
+ public:
+  explicit WebpEncoder(const WebpEncodeOptions& options = WebpEncodeOptions());
+
+  const WebpEncodeOptions& options() const { return options_; }
+  void set_options(const WebpEncodeOptions& options) { options_ = options; }
+
+  // Whether the core was built with libwebp.
+  static bool IsAvailable();
+
+  // Encodes |image| into |out|. Returns false if the image is invalid,
+  // libwebp is unavailable or encoding fails.
+  bool Encode(const ImageView& image, std::vector<uint8_t>* out);
+
+  // Hands libwebp's output to |sink| as libwebp writes it. Returns false as
+  // above or if |sink| fails.
+  bool Encode(const ImageView& image, ByteSink* sink);
+
+ private:
+  WebpEncodeOptions options_;
+};
+
+}  // namespace screenshot
+
+#endif  // SCREENSHOT_CORE_WEBP_ENCODER_H_
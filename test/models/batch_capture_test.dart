@@ -0,0 +1,41 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/batch_capture.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+import 'package:just_screenshot/src/models/captured_data.dart';
+
+void main() {
+  group('BatchCapture', () {
+    final BatchCapture capture = BatchCapture(
+      x: 40,
+      y: 12,
+      sourceWidth: 4,
+      sourceHeight: 2,
+      data: CapturedData(
+        width: 2,
+        height: 1,
+        bytes: Uint8List.fromList(<int>[1, 2, 3, 255, 4, 5, 6, 255]),
+        format: CaptureFormat.rawBgra,
+        stride: 8,
+      ),
+    );
+
+    test('fromMap and toMap round-trip', () {
+      final Map<String, dynamic> map = capture.toMap();
+
+      expect(BatchCapture.fromMap(map), equals(capture));
+      expect(map['sourceWidth'], equals(4));
+      expect(map['width'], equals(2));
+      expect(map['pixelFormat'], equals('raw_bgra'));
+    });
+
+    test('equality covers the rectangle', () {
+      final BatchCapture moved = BatchCapture(x: 40, y: 12, sourceWidth: 2, sourceHeight: 1, data: capture.data);
+
+      expect(capture, isNot(equals(moved)));
+      expect(capture.hashCode, isNot(equals(moved.hashCode)));
+      expect(capture.toString(), contains('sourceWidth: 4'));
+    });
+  });
+}
@@ -0,0 +1,36 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/batch_rect.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+import 'package:just_screenshot/src/models/chroma_subsampling.dart';
+
+void main() {
+  group('BatchRect', () {
+    test('toMap leaves out the fields the call decides', () {
+      const BatchRect rect = BatchRect(x: -10, y: 20, width: 30, height: 40);
+
+      expect(rect.toMap(), equals(<String, dynamic>{'x': -10, 'y': 20, 'width': 30, 'height': 40}));
+    });
+
+    test('fromMap and toMap round-trip', () {
+      const BatchRect rect = BatchRect(
+        x: 1,
+        y: 2,
+        width: 3,
+        height: 4,
+        format: CaptureFormat.jpeg,
+        quality: 70,
+        chromaSubsampling: ChromaSubsampling.chroma444,
+        maxWidth: 200,
+        maxHeight: 100,
+        scale: 0.5,
+      );
+      final Map<String, dynamic> map = rect.toMap();
+
+      expect(map['format'], equals('jpeg'));
+      expect(map['chromaSubsampling'], equals('444'));
+      expect(BatchRect.fromMap(map), equals(rect));
+      expect(BatchRect.fromMap(map).hashCode, equals(rect.hashCode));
+      expect(rect.toString(), contains('quality: 70'));
+    });
+  });
+}
@@ -0,0 +1,41 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+
+void main() {
+  group('CaptureFormat', () {
+    test('toValue returns the method channel strings', () {
+      expect(CaptureFormat.png.toValue(), equals('png'));
+      expect(CaptureFormat.rawBgra.toValue(), equals('raw_bgra'));
+      expect(CaptureFormat.rawRgba.toValue(), equals('raw_rgba'));
+      expect(CaptureFormat.qoi.toValue(), equals('qoi'));
+      expect(CaptureFormat.lz4Bgra.toValue(), equals('lz4_bgra'));
+      expect(CaptureFormat.jpeg.toValue(), equals('jpeg'));
+      expect(CaptureFormat.webp.toValue(), equals('webp'));
+    });
+
+    test('fromValue round-trips every format', () {
+      for (final CaptureFormat format in CaptureFormat.values) {
+        expect(CaptureFormatExtension.fromValue(format.toValue()), equals(format));
+      }
+    });
+
+    test('fromValue throws ArgumentError for invalid value', () {
+      expect(() => CaptureFormatExtension.fromValue('bmp'), throwsArgumentError);
+    });
+
+    test('isRaw is true only for unencoded formats', () {
+      expect(CaptureFormat.png.isRaw, isFalse);
+      expect(CaptureFormat.rawBgra.isRaw, isTrue);
+      expect(CaptureFormat.rawRgba.isRaw, isTrue);
+      expect(CaptureFormat.qoi.isRaw, isFalse);
+      expect(CaptureFormat.lz4Bgra.isRaw, isFalse);
+      expect(CaptureFormat.jpeg.isRaw, isFalse);
+    });
+
+    test('isLossy is true only for JPEG and WebP', () {
+      for (final CaptureFormat format in CaptureFormat.values) {
+        expect(format.isLossy, equals(format == CaptureFormat.jpeg || format == CaptureFormat.webp));
+      }
+    });
+  });
+}
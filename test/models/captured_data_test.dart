@@ -1,6 +1,7 @@
 import 'dart:typed_data';
 
 import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
 import 'package:just_screenshot/src/models/captured_data.dart';
 
 void main() {
@@ -50,6 +51,45 @@ void main() {
       expect(data.bytes, equals(bytes));
     });
 
+    test('fromMap defaults to PNG when pixelFormat is absent', () {
+      final Uint8List bytes = Uint8List.fromList(<int>[1, 2, 3, 4]);
+      final CapturedData data = CapturedData.fromMap(<Object?, Object?>{'width': 1, 'height': 1, 'bytes': bytes});
+
+      expect(data.format, equals(CaptureFormat.png));
+      expect(data.stride, equals(0));
+    });
+
+    test('fromMap reads raw pixel format and stride', () {
+      final Uint8List bytes = Uint8List(2 * 8 * 4);
+      final Map<Object?, Object?> map = <Object?, Object?>{
+        'width': 7,
+        'height': 2,
+        'stride': 32,
+        'pixelFormat': 'raw_rgba',
+        'bytes': bytes,
+      };
+
+      final CapturedData data = CapturedData.fromMap(map);
+
+      expect(data.format, equals(CaptureFormat.rawRgba));
+      expect(data.stride, equals(32));
+    });
+
+    test('assertion fails when stride is negative', () {
+      final Uint8List bytes = Uint8List.fromList(<int>[1, 2, 3, 4]);
+      expect(() => CapturedData(width: 1, height: 1, bytes: bytes, stride: -4), throwsAssertionError);
+    });
+
+    test('inequality when format differs', () {
+      final Uint8List bytes = Uint8List.fromList(<int>[1, 2, 3, 4]);
+
+      final CapturedData data1 = CapturedData(width: 1, height: 1, bytes: bytes, format: CaptureFormat.rawBgra, stride: 4);
+
+      final CapturedData data2 = CapturedData(width: 1, height: 1, bytes: bytes, format: CaptureFormat.rawRgba, stride: 4);
+
+      expect(data1, isNot(equals(data2)));
+    });
+
     test('toMap creates valid map from instance', () {
       final Uint8List bytes = Uint8List.fromList(<int>[1, 2, 3, 4]);
       final CapturedData data = CapturedData(width: 1920, height: 1080, bytes: bytes);
@@ -58,6 +98,8 @@ void main() {
 
       expect(map['width'], equals(1920));
       expect(map['height'], equals(1080));
+      expect(map['stride'], equals(0));
+      expect(map['pixelFormat'], equals('png'));
       expect(map['bytes'], equals(bytes));
     });
 
@@ -0,0 +1,57 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+import 'package:just_screenshot/src/models/captured_file.dart';
+
+void main() {
+  group('CapturedFile', () {
+    const CapturedFile file = CapturedFile(
+      path: '/home/user/shot.qoi',
+      width: 3840,
+      height: 2160,
+      format: CaptureFormat.qoi,
+      byteCount: 9876543,
+      elapsed: Duration(microseconds: 41250),
+    );
+
+    test('fromMap and toMap round-trip', () {
+      expect(CapturedFile.fromMap(file.toMap()), equals(file));
+      expect(file.toMap()['pixelFormat'], equals('qoi'));
+      expect(file.toMap()['elapsedUs'], equals(41250));
+    });
+
+    test('fromMap defaults to png', () {
+      final CapturedFile png = CapturedFile.fromMap(<Object?, Object?>{
+        'path': 'a.png',
+        'width': 2,
+        'height': 2,
+        'byteCount': 75,
+        'elapsedUs': 300,
+      });
+
+      expect(png.format, equals(CaptureFormat.png));
+      expect(png.elapsed, equals(const Duration(microseconds: 300)));
+    });
+
+    test('equality covers every field', () {
+      const CapturedFile other = CapturedFile(
+        path: '/home/user/shot.qoi',
+        width: 3840,
+        height: 2160,
+        format: CaptureFormat.qoi,
+        byteCount: 9876543,
+        elapsed: Duration(microseconds: 41251),
+      );
+
+      expect(file, isNot(equals(other)));
+      expect(file.hashCode, isNot(equals(other.hashCode)));
+      expect(file.toString(), contains('byteCount: 9876543'));
+    });
+
+    test('assertion fails for empty images', () {
+      expect(
+        () => CapturedFile(path: 'a.png', width: 0, height: 1, byteCount: 1, elapsed: Duration.zero),
+        throwsAssertionError,
+      );
+    });
+  });
+}
@@ -0,0 +1,75 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+import 'package:just_screenshot/src/models/captured_data.dart';
+import 'package:just_screenshot/src/models/captured_frame.dart';
+
+void main() {
+  group('CapturedFrame', () {
+    test('fromMap reads the frame fields and the image', () {
+      final Uint8List bytes = Uint8List.fromList(<int>[0xFF, 0xD8, 0xFF, 0xD9]);
+      final CapturedFrame frame = CapturedFrame.fromMap(<Object?, Object?>{
+        'width': 1920,
+        'height': 1080,
+        'stride': 0,
+        'pixelFormat': 'jpeg',
+        'bytes': bytes,
+        'sequence': 42,
+        'timestampUs': 1234567,
+        'dropped': 3,
+        'failed': 2,
+      });
+
+      expect(frame.sequence, equals(42));
+      expect(frame.timestamp, equals(const Duration(microseconds: 1234567)));
+      expect(frame.dropped, equals(3));
+      expect(frame.failed, equals(2));
+      expect(frame.data.format, equals(CaptureFormat.jpeg));
+      expect(frame.data.width, equals(1920));
+      expect(frame.data.bytes, equals(bytes));
+    });
+
+    test('dropped and failed default to zero', () {
+      final CapturedFrame frame = CapturedFrame.fromMap(<Object?, Object?>{
+        'width': 1,
+        'height': 1,
+        'bytes': Uint8List(4),
+        'sequence': 0,
+        'timestampUs': 0,
+      });
+
+      expect(frame.dropped, equals(0));
+      expect(frame.failed, equals(0));
+    });
+
+    test('toMap round-trips through fromMap', () {
+      final CapturedFrame frame = CapturedFrame(
+        sequence: 7,
+        timestamp: const Duration(milliseconds: 250),
+        dropped: 1,
+        failed: 4,
+        data: CapturedData(
+          width: 2,
+          height: 1,
+          stride: 8,
+          format: CaptureFormat.rawBgra,
+          bytes: Uint8List(8),
+        ),
+      );
+
+      expect(CapturedFrame.fromMap(frame.toMap()), equals(frame));
+    });
+
+    test('assertion fails for a negative sequence', () {
+      expect(
+        () => CapturedFrame(
+          sequence: -1,
+          timestamp: Duration.zero,
+          data: CapturedData(width: 1, height: 1, bytes: Uint8List(4)),
+        ),
+        throwsAssertionError,
+      );
+    });
+  });
+}
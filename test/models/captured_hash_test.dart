@@ -0,0 +1,45 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/captured_hash.dart';
+
+void main() {
+  group('CapturedHash', () {
+    const CapturedHash hash = CapturedHash(x: 10, y: 20, width: 300, height: 200, xxh3: -42, dHash: 0x0F0F, pHash: 7);
+
+    test('fromMap and toMap round-trip', () {
+      final Map<String, dynamic> map = hash.toMap();
+
+      expect(CapturedHash.fromMap(map), equals(hash));
+      expect(map['dhash'], equals(0x0F0F));
+      expect(map['phash'], equals(7));
+    });
+
+    test('hashes that were not computed are null and left out', () {
+      final CapturedHash exact = CapturedHash.fromMap(<Object?, Object?>{
+        'x': 0,
+        'y': 0,
+        'width': 1,
+        'height': 1,
+        'xxh3': 5,
+      });
+
+      expect(exact.dHash, isNull);
+      expect(exact.pHash, isNull);
+      expect(exact.toMap().containsKey('dhash'), isFalse);
+    });
+
+    test('equality covers every hash', () {
+      const CapturedHash other = CapturedHash(x: 10, y: 20, width: 300, height: 200, xxh3: -42, dHash: 0x0F0F, pHash: 6);
+
+      expect(hash, isNot(equals(other)));
+      expect(hash.hashCode, isNot(equals(other.hashCode)));
+      expect(hash.toString(), contains('xxh3: -42'));
+    });
+
+    test('hammingDistance counts differing bits, sign bit included', () {
+      expect(CapturedHash.hammingDistance(0, 0), equals(0));
+      expect(CapturedHash.hammingDistance(0x0F0F, 0x0F0E), equals(1));
+      expect(CapturedHash.hammingDistance(0, -1), equals(64));
+      expect(CapturedHash.hammingDistance(-1 << 63, 0), equals(1));
+    });
+  });
+}
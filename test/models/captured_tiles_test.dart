@@ -0,0 +1,88 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+import 'package:just_screenshot/src/models/captured_tiles.dart';
+
+void main() {
+  group('CapturedTile', () {
+    test('fromMap reads position, size, stride and bytes', () {
+      final Uint8List bytes = Uint8List.fromList(<int>[1, 2, 3, 4]);
+      final CapturedTile tile = CapturedTile.fromMap(<Object?, Object?>{
+        'x': 64,
+        'y': 128,
+        'width': 1,
+        'height': 1,
+        'stride': 4,
+        'bytes': bytes,
+      });
+
+      expect(tile.x, equals(64));
+      expect(tile.y, equals(128));
+      expect(tile.width, equals(1));
+      expect(tile.height, equals(1));
+      expect(tile.stride, equals(4));
+      expect(tile.bytes, equals(bytes));
+    });
+
+    test('assertion fails for negative position or empty size', () {
+      final Uint8List bytes = Uint8List(4);
+      expect(() => CapturedTile(x: -1, y: 0, width: 1, height: 1, bytes: bytes), throwsAssertionError);
+      expect(() => CapturedTile(x: 0, y: 0, width: 0, height: 1, bytes: bytes), throwsAssertionError);
+    });
+  });
+
+  group('CapturedTiles', () {
+    test('fromMap parses every tile and the format', () {
+      final Map<Object?, Object?> map = <Object?, Object?>{
+        'width': 100,
+        'height': 70,
+        'keyframe': true,
+        'tileSize': 64,
+        'pixelFormat': 'qoi',
+        'tiles': <Object?>[
+          <Object?, Object?>{'x': 0, 'y': 0, 'width': 64, 'height': 64, 'stride': 0, 'bytes': Uint8List(8)},
+          <Object?, Object?>{'x': 64, 'y': 64, 'width': 36, 'height': 6, 'stride': 0, 'bytes': Uint8List(8)},
+        ],
+      };
+
+      final CapturedTiles frame = CapturedTiles.fromMap(map);
+
+      expect(frame.width, equals(100));
+      expect(frame.height, equals(70));
+      expect(frame.keyframe, isTrue);
+      expect(frame.tileSize, equals(64));
+      expect(frame.format, equals(CaptureFormat.qoi));
+      expect(frame.tiles, hasLength(2));
+      expect(frame.tiles.last.width, equals(36));
+    });
+
+    test('toMap round-trips through fromMap', () {
+      final CapturedTiles frame = CapturedTiles(
+        width: 10,
+        height: 10,
+        keyframe: false,
+        tileSize: 8,
+        format: CaptureFormat.rawRgba,
+        tiles: <CapturedTile>[
+          CapturedTile(x: 8, y: 0, width: 2, height: 8, stride: 8, bytes: Uint8List(64)),
+        ],
+      );
+
+      expect(CapturedTiles.fromMap(frame.toMap()), equals(frame));
+    });
+
+    test('an unchanged screen has no tiles', () {
+      final CapturedTiles frame = CapturedTiles.fromMap(<Object?, Object?>{
+        'width': 10,
+        'height': 10,
+        'keyframe': false,
+        'tileSize': 64,
+        'tiles': <Object?>[],
+      });
+
+      expect(frame.tiles, isEmpty);
+      expect(frame.format, equals(CaptureFormat.png));
+    });
+  });
+}
@@ -0,0 +1,22 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/chroma_subsampling.dart';
+
+void main() {
+  group('ChromaSubsampling', () {
+    test('toValue returns the method channel strings', () {
+      expect(ChromaSubsampling.chroma444.toValue(), equals('444'));
+      expect(ChromaSubsampling.chroma422.toValue(), equals('422'));
+      expect(ChromaSubsampling.chroma420.toValue(), equals('420'));
+    });
+
+    test('fromValue round-trips every value', () {
+      for (final ChromaSubsampling subsampling in ChromaSubsampling.values) {
+        expect(ChromaSubsamplingExtension.fromValue(subsampling.toValue()), equals(subsampling));
+      }
+    });
+
+    test('fromValue throws ArgumentError for invalid value', () {
+      expect(() => ChromaSubsamplingExtension.fromValue('411'), throwsArgumentError);
+    });
+  });
+}
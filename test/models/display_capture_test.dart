@@ -0,0 +1,39 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+import 'package:just_screenshot/src/models/captured_data.dart';
+import 'package:just_screenshot/src/models/display_capture.dart';
+
+void main() {
+  group('DisplayCapture', () {
+    final DisplayCapture capture = DisplayCapture(
+      displayId: 2,
+      x: 2560,
+      y: -200,
+      data: CapturedData(
+        width: 2,
+        height: 1,
+        bytes: Uint8List.fromList(<int>[1, 2, 3, 255, 4, 5, 6, 255]),
+        format: CaptureFormat.rawBgra,
+        stride: 8,
+      ),
+    );
+
+    test('fromMap and toMap round-trip', () {
+      final Map<String, dynamic> map = capture.toMap();
+
+      expect(DisplayCapture.fromMap(map), equals(capture));
+      expect(map['displayId'], equals(2));
+      expect(map['pixelFormat'], equals('raw_bgra'));
+    });
+
+    test('equality covers the position', () {
+      final DisplayCapture moved = DisplayCapture(displayId: 2, x: 2560, y: 0, data: capture.data);
+
+      expect(capture, isNot(equals(moved)));
+      expect(capture.hashCode, isNot(equals(moved.hashCode)));
+      expect(capture.toString(), contains('displayId: 2'));
+    });
+  });
+}
@@ -0,0 +1,54 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/display_info.dart';
+
+void main() {
+  group('DisplayInfo', () {
+    const DisplayInfo display = DisplayInfo(
+      id: 1,
+      x: -1920,
+      y: 120,
+      width: 1920,
+      height: 1080,
+      name: r'\\.\DISPLAY2',
+    );
+
+    test('fromMap and toMap round-trip', () {
+      expect(DisplayInfo.fromMap(display.toMap()), equals(display));
+      expect(display.toMap()['primary'], isFalse);
+      expect(display.toMap()['x'], equals(-1920));
+    });
+
+    test('fromMap defaults primary and name', () {
+      final DisplayInfo primary = DisplayInfo.fromMap(<Object?, Object?>{
+        'id': 0,
+        'x': 0,
+        'y': 0,
+        'width': 2560,
+        'height': 1440,
+      });
+
+      expect(primary.isPrimary, isFalse);
+      expect(primary.name, isEmpty);
+    });
+
+    test('equality covers every field', () {
+      const DisplayInfo other = DisplayInfo(
+        id: 1,
+        x: -1920,
+        y: 120,
+        width: 1920,
+        height: 1080,
+        isPrimary: true,
+        name: r'\\.\DISPLAY2',
+      );
+
+      expect(display, isNot(equals(other)));
+      expect(display.hashCode, isNot(equals(other.hashCode)));
+      expect(display.toString(), contains('x: -1920'));
+    });
+
+    test('assertion fails for empty displays', () {
+      expect(() => DisplayInfo(id: 0, x: 0, y: 0, width: 0, height: 1), throwsAssertionError);
+    });
+  });
+}
@@ -0,0 +1,103 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+import 'package:just_screenshot/src/models/captured_data.dart';
+import 'package:just_screenshot/src/models/frame_message.dart';
+
+ByteData buildMessage({
+  int kind = 0,
+  int format = 1,
+  int headerSize = FrameMessage.headerSize,
+  int width = 3,
+  int height = 2,
+  int stride = 12,
+  int sequence = 0,
+  int timestampUs = 0,
+  List<int> payload = const <int>[],
+}) {
+  final ByteData data = ByteData(headerSize + payload.length);
+  data.setUint32(0, FrameMessage.magic, Endian.little);
+  data.setUint8(4, kind);
+  data.setUint8(5, format);
+  data.setUint16(6, headerSize, Endian.little);
+  data.setUint32(8, width, Endian.little);
+  data.setUint32(12, height, Endian.little);
+  data.setUint32(16, stride, Endian.little);
+  data.setInt64(24, sequence, Endian.little);
+  data.setInt64(32, timestampUs, Endian.little);
+  for (int i = 0; i < payload.length; i += 1) {
+    data.setUint8(headerSize + i, payload[i]);
+  }
+  return data;
+}
+
+void main() {
+  group('FrameMessage', () {
+    test('parse reads the header fields', () {
+      final FrameMessage message = FrameMessage.parse(
+        buildMessage(
+          format: 4,
+          width: 3840,
+          height: 2160,
+          stride: 15360,
+          sequence: 42,
+          timestampUs: 1234567,
+          payload: <int>[1, 2, 3],
+        ),
+      );
+
+      expect(message.kind, equals(FrameMessageKind.frame));
+      expect(message.format, equals(CaptureFormat.lz4Bgra));
+      expect(message.width, equals(3840));
+      expect(message.height, equals(2160));
+      expect(message.stride, equals(15360));
+      expect(message.sequence, equals(42));
+      expect(message.timestamp, equals(const Duration(microseconds: 1234567)));
+      expect(message.payload, equals(<int>[1, 2, 3]));
+    });
+
+    test('payload is a view into the message', () {
+      final ByteData data = buildMessage(payload: <int>[9, 8, 7, 6]);
+      final FrameMessage message = FrameMessage.parse(data);
+
+      expect(message.payload.buffer, same(data.buffer));
+      expect(message.payload.offsetInBytes, equals(FrameMessage.headerSize));
+      data.setUint8(FrameMessage.headerSize, 0);
+      expect(message.payload.first, equals(0));
+    });
+
+    test('payload starts after a longer header', () {
+      final FrameMessage message = FrameMessage.parse(buildMessage(headerSize: 48, payload: <int>[5]));
+
+      expect(message.payload, equals(<int>[5]));
+    });
+
+    test('parse reads null and error kinds', () {
+      expect(FrameMessage.parse(buildMessage(kind: 1)).kind, equals(FrameMessageKind.none));
+      expect(FrameMessage.parse(buildMessage(kind: 2)).kind, equals(FrameMessageKind.error));
+    });
+
+    test('parse rejects malformed messages', () {
+      expect(() => FrameMessage.parse(ByteData(FrameMessage.headerSize - 1)), throwsFormatException);
+      expect(() => FrameMessage.parse(ByteData(FrameMessage.headerSize)), throwsFormatException);
+      expect(() => FrameMessage.parse(buildMessage(kind: 3)), throwsFormatException);
+      expect(() => FrameMessage.parse(buildMessage(format: CaptureFormat.values.length)), throwsFormatException);
+
+      final ByteData truncated = buildMessage();
+      truncated.setUint16(6, FrameMessage.headerSize + 1, Endian.little);
+      expect(() => FrameMessage.parse(truncated), throwsFormatException);
+    });
+
+    test('toCapturedData uses the payload as the bytes', () {
+      final ByteData data = buildMessage(format: 2, payload: List<int>.filled(24, 0x7F));
+      final CapturedData captured = FrameMessage.parse(data).toCapturedData();
+
+      expect(captured.width, equals(3));
+      expect(captured.height, equals(2));
+      expect(captured.stride, equals(12));
+      expect(captured.format, equals(CaptureFormat.rawRgba));
+      expect(captured.bytes.buffer, same(data.buffer));
+    });
+  });
+}
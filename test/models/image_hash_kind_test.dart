@@ -0,0 +1,22 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/image_hash_kind.dart';
+
+void main() {
+  group('ImageHashKind', () {
+    test('toValue returns the method channel strings', () {
+      expect(ImageHashKind.xxh3.toValue(), equals('xxh3'));
+      expect(ImageHashKind.dHash.toValue(), equals('dhash'));
+      expect(ImageHashKind.pHash.toValue(), equals('phash'));
+    });
+
+    test('fromValue round-trips every value', () {
+      for (final ImageHashKind kind in ImageHashKind.values) {
+        expect(ImageHashKindExtension.fromValue(kind.toValue()), equals(kind));
+      }
+    });
+
+    test('fromValue throws ArgumentError for invalid value', () {
+      expect(() => ImageHashKindExtension.fromValue('md5'), throwsArgumentError);
+    });
+  });
+}
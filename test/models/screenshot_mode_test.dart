@@ -23,14 +23,20 @@ void main() {
       expect(mode, equals(ScreenshotMode.region));
     });
 
+    test('all mode round-trips', () {
+      expect(ScreenshotMode.all.toValue(), equals('all'));
+      expect(ScreenshotModeExtension.fromValue('all'), equals(ScreenshotMode.all));
+    });
+
     test('fromValue throws ArgumentError for invalid value', () {
       expect(() => ScreenshotModeExtension.fromValue('invalid'), throwsArgumentError);
     });
 
     test('enum values are correctly defined', () {
-      expect(ScreenshotMode.values.length, equals(2));
+      expect(ScreenshotMode.values.length, equals(3));
       expect(ScreenshotMode.values, contains(ScreenshotMode.screen));
       expect(ScreenshotMode.values, contains(ScreenshotMode.region));
+      expect(ScreenshotMode.values, contains(ScreenshotMode.all));
     });
   });
 }
@@ -0,0 +1,61 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+import 'package:just_screenshot/src/models/shared_frame.dart';
+
+void main() {
+  group('SharedFrame', () {
+    const SharedFrame frame = SharedFrame(
+      width: 1920,
+      height: 1080,
+      format: CaptureFormat.rawBgra,
+      stride: 7680,
+      handle: 31,
+      offset: 131072,
+      length: 7680 * 1080,
+      generation: 5,
+    );
+
+    test('fromMap and toMap round-trip', () {
+      expect(SharedFrame.fromMap(frame.toMap()), equals(frame));
+      expect(frame.toMap()['pixelFormat'], equals('raw_bgra'));
+    });
+
+    test('fromMap defaults to png without a stride', () {
+      final SharedFrame png = SharedFrame.fromMap(<Object?, Object?>{
+        'width': 2,
+        'height': 2,
+        'handle': 4,
+        'offset': 0,
+        'length': 75,
+        'generation': 1,
+      });
+
+      expect(png.format, equals(CaptureFormat.png));
+      expect(png.stride, equals(0));
+    });
+
+    test('equality covers the slot and generation', () {
+      const SharedFrame other = SharedFrame(
+        width: 1920,
+        height: 1080,
+        format: CaptureFormat.rawBgra,
+        stride: 7680,
+        handle: 31,
+        offset: 131072,
+        length: 7680 * 1080,
+        generation: 6,
+      );
+
+      expect(frame, isNot(equals(other)));
+      expect(frame.hashCode, isNot(equals(other.hashCode)));
+      expect(frame.toString(), contains('generation: 5'));
+    });
+
+    test('assertion fails for empty frames', () {
+      expect(
+        () => SharedFrame(width: 1, height: 1, handle: 1, offset: 0, length: 0, generation: 1),
+        throwsAssertionError,
+      );
+    });
+  });
+}
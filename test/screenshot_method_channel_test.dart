@@ -1,9 +1,25 @@
+import 'dart:math';
+
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
 import 'package:just_screenshot/screenshot_method_channel.dart';
+import 'package:just_screenshot/src/models/batch_capture.dart';
+import 'package:just_screenshot/src/models/batch_rect.dart';
+import 'package:just_screenshot/src/models/capture_format.dart';
+import 'package:just_screenshot/src/models/capture_stats.dart';
 import 'package:just_screenshot/src/models/captured_data.dart';
+import 'package:just_screenshot/src/models/captured_file.dart';
+import 'package:just_screenshot/src/models/captured_frame.dart';
+import 'package:just_screenshot/src/models/captured_hash.dart';
+import 'package:just_screenshot/src/models/captured_tiles.dart';
+import 'package:just_screenshot/src/models/chroma_subsampling.dart';
+import 'package:just_screenshot/src/models/display_capture.dart';
+import 'package:just_screenshot/src/models/display_info.dart';
+import 'package:just_screenshot/src/models/frame_message.dart';
+import 'package:just_screenshot/src/models/image_hash_kind.dart';
 import 'package:just_screenshot/src/models/screenshot_exception.dart';
 import 'package:just_screenshot/src/models/screenshot_mode.dart';
+import 'package:just_screenshot/src/models/shared_frame.dart';
 
 void main() {
   TestWidgetsFlutterBinding.ensureInitialized();
@@ -11,9 +27,27 @@ void main() {
   group('MethodChannelScreenshot', () {
     final MethodChannelScreenshot platform = MethodChannelScreenshot();
     const MethodChannel channel = MethodChannel('dev.flutter.screenshot');
+    const String frameChannel = 'dev.flutter.screenshot/frame';
+
+    // A frame channel reply with the given header fields and payload.
+    ByteData frameReply({int kind = 0, int format = 0, int width = 0, int height = 0, int stride = 0, List<int> payload = const <int>[]}) {
+      final ByteData data = ByteData(FrameMessage.headerSize + payload.length);
+      data.setUint32(0, FrameMessage.magic, Endian.little);
+      data.setUint8(4, kind);
+      data.setUint8(5, format);
+      data.setUint16(6, FrameMessage.headerSize, Endian.little);
+      data.setUint32(8, width, Endian.little);
+      data.setUint32(12, height, Endian.little);
+      data.setUint32(16, stride, Endian.little);
+      for (int i = 0; i < payload.length; i += 1) {
+        data.setUint8(FrameMessage.headerSize + i, payload[i]);
+      }
+      return data;
+    }
 
     setUp(() {
       TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMessageHandler(frameChannel, null);
     });
 
     test('capture sends correct parameters for screen mode', () async {
@@ -37,6 +71,366 @@ void main() {
       final Map<dynamic, dynamic> args = log.first.arguments as Map<dynamic, dynamic>;
       expect(args['mode'], equals('screen'));
       expect(args['includeCursor'], equals(false));
+      expect(args['format'], equals('png'));
+      expect(args.containsKey('quality'), isFalse);
+      expect(args.containsKey('chromaSubsampling'), isFalse);
+      expect(args.containsKey('maxWidth'), isFalse);
+      expect(args.containsKey('maxHeight'), isFalse);
+      expect(args.containsKey('scale'), isFalse);
+    });
+
+    test('capture sends quality and chroma subsampling for lossy formats', () async {
+      final List<MethodCall> log = <MethodCall>[];
+
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <String, dynamic>{
+          'width': 3,
+          'height': 2,
+          'stride': 0,
+          'pixelFormat': 'jpeg',
+          'bytes': Uint8List.fromList(<int>[0xFF, 0xD8, 0xFF, 0xD9]),
+        };
+      });
+
+      final CapturedData? result = await platform.capture(
+        mode: ScreenshotMode.screen,
+        format: CaptureFormat.jpeg,
+        quality: 70,
+        chromaSubsampling: ChromaSubsampling.chroma444,
+      );
+
+      final Map<dynamic, dynamic> args = log.first.arguments as Map<dynamic, dynamic>;
+      expect(args['format'], equals('jpeg'));
+      expect(args['quality'], equals(70));
+      expect(args['chromaSubsampling'], equals('444'));
+      expect(result!.format, equals(CaptureFormat.jpeg));
+    });
+
+    test('capture sends size limits', () async {
+      final List<MethodCall> log = <MethodCall>[];
+
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <String, dynamic>{
+          'width': 256,
+          'height': 144,
+          'bytes': Uint8List.fromList(<int>[1, 2, 3, 4]),
+        };
+      });
+
+      final CapturedData? result = await platform.capture(
+        mode: ScreenshotMode.screen,
+        maxWidth: 256,
+        maxHeight: 256,
+        scale: 0.25,
+      );
+
+      final Map<dynamic, dynamic> args = log.first.arguments as Map<dynamic, dynamic>;
+      expect(args['maxWidth'], equals(256));
+      expect(args['maxHeight'], equals(256));
+      expect(args['scale'], equals(0.25));
+      expect(result!.width, equals(256));
+      expect(result.height, equals(144));
+    });
+
+    test('capture sends format and parses raw pixel results', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      final Uint8List pixels = Uint8List(3 * 2 * 4);
+
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <String, dynamic>{
+          'width': 3,
+          'height': 2,
+          'stride': 12,
+          'pixelFormat': 'raw_bgra',
+          'bytes': pixels,
+        };
+      });
+
+      final CapturedData? result = await platform.capture(mode: ScreenshotMode.screen, format: CaptureFormat.rawBgra);
+
+      final Map<dynamic, dynamic> args = log.first.arguments as Map<dynamic, dynamic>;
+      expect(args['format'], equals('raw_bgra'));
+      expect(result, isNotNull);
+      expect(result!.format, equals(CaptureFormat.rawBgra));
+      expect(result.stride, equals(12));
+      expect(result.bytes, equals(pixels));
+    });
+
+    test('startStream and stopStream send their parameters', () async {
+      final List<MethodCall> log = <MethodCall>[];
+
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return null;
+      });
+
+      await platform.startStream(fps: 15, format: CaptureFormat.jpeg, quality: 60);
+      await platform.stopStream();
+
+      expect(log, hasLength(2));
+      expect(log.first.method, equals('startStream'));
+      final Map<dynamic, dynamic> args = log.first.arguments as Map<dynamic, dynamic>;
+      expect(args['fps'], equals(15.0));
+      expect(args['includeCursor'], equals(false));
+      expect(args['format'], equals('jpeg'));
+      expect(args['quality'], equals(60));
+      expect(args.containsKey('chromaSubsampling'), isFalse);
+      expect(log.last.method, equals('stopStream'));
+    });
+
+    test('startStream maps PlatformException to ScreenshotException', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        throw PlatformException(code: 'invalid_argument', message: 'Invalid fps: 0');
+      });
+
+      expect(
+        () => platform.startStream(fps: 0),
+        throwsA(isA<ScreenshotException>().having((ScreenshotException e) => e.code, 'code', 'invalid_argument')),
+      );
+    });
+
+    test('frames parses stream events', () async {
+      const EventChannel eventChannel = EventChannel('dev.flutter.screenshot/stream');
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+        eventChannel,
+        MockStreamHandler.inline(
+          onListen: (Object? arguments, MockStreamHandlerEventSink events) {
+            for (int sequence = 0; sequence < 3; sequence += 2) {
+              events.success(<String, dynamic>{
+                'width': 2,
+                'height': 1,
+                'stride': 8,
+                'pixelFormat': 'raw_bgra',
+                'bytes': Uint8List(8),
+                'sequence': sequence,
+                'timestampUs': 1000 + sequence * 33333,
+                'dropped': sequence ~/ 2,
+              });
+            }
+            events.endOfStream();
+          },
+        ),
+      );
+
+      final List<CapturedFrame> frames = await MethodChannelScreenshot().frames.toList();
+
+      expect(frames, hasLength(2));
+      expect(frames.last.sequence, equals(2));
+      expect(frames.last.dropped, equals(1));
+      expect(frames.last.timestamp, equals(const Duration(microseconds: 67666)));
+      expect(frames.last.data.format, equals(CaptureFormat.rawBgra));
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(eventChannel, null);
+    });
+
+    test('captureTiles sends parameters and parses tiles', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      final Uint8List pixels = Uint8List(2 * 3 * 4);
+
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <String, dynamic>{
+          'width': 130,
+          'height': 67,
+          'keyframe': false,
+          'tileSize': 64,
+          'pixelFormat': 'raw_bgra',
+          'tiles': <Map<String, dynamic>>[
+            <String, dynamic>{'x': 128, 'y': 64, 'width': 2, 'height': 3, 'stride': 8, 'bytes': pixels},
+          ],
+        };
+      });
+
+      final CapturedTiles result = await platform.captureTiles(format: CaptureFormat.rawBgra, tileSize: 64);
+
+      expect(log.first.method, equals('captureTiles'));
+      final Map<dynamic, dynamic> args = log.first.arguments as Map<dynamic, dynamic>;
+      expect(args['format'], equals('raw_bgra'));
+      expect(args['tileSize'], equals(64));
+      expect(args['keyframe'], equals(false));
+      expect(args.containsKey('quality'), isFalse);
+      expect(result.keyframe, isFalse);
+      expect(result.format, equals(CaptureFormat.rawBgra));
+      expect(result.tiles, hasLength(1));
+      expect(result.tiles.first.x, equals(128));
+      expect(result.tiles.first.y, equals(64));
+      expect(result.tiles.first.stride, equals(8));
+      expect(result.tiles.first.bytes, equals(pixels));
+    });
+
+    test('captureTiles maps PlatformException to ScreenshotException', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        throw PlatformException(code: 'invalid_argument', message: 'Invalid tileSize: 4');
+      });
+
+      expect(
+        () => platform.captureTiles(tileSize: 4),
+        throwsA(isA<ScreenshotException>().having((ScreenshotException e) => e.code, 'code', 'invalid_argument')),
+      );
+    });
+
+    test('captureShared sends parameters and parses the slot', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <String, dynamic>{
+          'width': 3840,
+          'height': 2160,
+          'stride': 15360,
+          'pixelFormat': 'raw_bgra',
+          'handle': 812,
+          'offset': 65536 * 507,
+          'length': 15360 * 2160,
+          'generation': 42,
+        };
+      });
+
+      final SharedFrame? result = await platform.captureShared(
+        mode: ScreenshotMode.screen,
+        format: CaptureFormat.rawBgra,
+        scale: 0.5,
+      );
+
+      expect(log.first.method, equals('captureShared'));
+      final Map<dynamic, dynamic> args = log.first.arguments as Map<dynamic, dynamic>;
+      expect(args['mode'], equals('screen'));
+      expect(args['format'], equals('raw_bgra'));
+      expect(args['scale'], equals(0.5));
+      expect(
+        result,
+        equals(
+          const SharedFrame(
+            width: 3840,
+            height: 2160,
+            format: CaptureFormat.rawBgra,
+            stride: 15360,
+            handle: 812,
+            offset: 65536 * 507,
+            length: 15360 * 2160,
+            generation: 42,
+          ),
+        ),
+      );
+    });
+
+    test('captureShared maps PlatformException to ScreenshotException', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        throw PlatformException(code: 'internal_error', message: 'No free shared frame slot; release earlier frames first');
+      });
+
+      expect(
+        () => platform.captureShared(mode: ScreenshotMode.screen),
+        throwsA(isA<ScreenshotException>().having((ScreenshotException e) => e.code, 'code', 'internal_error')),
+      );
+    });
+
+    test('captureToFile sends the path and options and parses the result', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <String, dynamic>{
+          'path': r'C:\shots\a.jpg',
+          'width': 2560,
+          'height': 1440,
+          'pixelFormat': 'jpeg',
+          'byteCount': 612345,
+          'elapsedUs': 18250,
+        };
+      });
+
+      final CapturedFile? result = await platform.captureToFile(
+        path: r'C:\shots\a.jpg',
+        mode: ScreenshotMode.screen,
+        format: CaptureFormat.jpeg,
+        quality: 80,
+        maxWidth: 1280,
+        maxHeight: 720,
+        atomic: false,
+      );
+
+      expect(log.first.method, equals('captureToFile'));
+      final Map<dynamic, dynamic> args = log.first.arguments as Map<dynamic, dynamic>;
+      expect(args['path'], equals(r'C:\shots\a.jpg'));
+      expect(args['mode'], equals('screen'));
+      expect(args['format'], equals('jpeg'));
+      expect(args['quality'], equals(80));
+      expect(args['maxWidth'], equals(1280));
+      expect(args['maxHeight'], equals(720));
+      expect(args['fsync'], isFalse);
+      expect(args['atomic'], isFalse);
+      expect(
+        result,
+        equals(
+          const CapturedFile(
+            path: r'C:\shots\a.jpg',
+            width: 2560,
+            height: 1440,
+            format: CaptureFormat.jpeg,
+            byteCount: 612345,
+            elapsed: Duration(microseconds: 18250),
+          ),
+        ),
+      );
+    });
+
+    test('captureToFile returns null when cancelled', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        return null;
+      });
+
+      expect(await platform.captureToFile(path: 'a.png', mode: ScreenshotMode.region), isNull);
+    });
+
+    test('captureToFile maps PlatformException to ScreenshotException', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        throw PlatformException(code: 'internal_error', message: 'Failed to write a.png', details: 112);
+      });
+
+      expect(
+        () => platform.captureToFile(path: 'a.png', mode: ScreenshotMode.screen),
+        throwsA(isA<ScreenshotException>().having((ScreenshotException e) => e.code, 'code', 'internal_error')),
+      );
+    });
+
+    test('releaseShared sends the generation', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return true;
+      });
+
+      await platform.releaseShared(42);
+
+      expect(log.single.method, equals('releaseShared'));
+      expect(log.single.arguments, equals(<String, dynamic>{'generation': 42}));
     });
 
     test('capture returns CapturedData on success', () async {
@@ -126,6 +520,234 @@ void main() {
       expect(args.containsKey('displayId'), isFalse);
     });
 
+    test('listDisplays parses every display', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        expect(methodCall.method, equals('listDisplays'));
+        return <Object?>[
+          <String, dynamic>{'id': 0, 'x': 0, 'y': 0, 'width': 2560, 'height': 1440, 'primary': true, 'name': 'A'},
+          <String, dynamic>{'id': 1, 'x': -1920, 'y': 200, 'width': 1920, 'height': 1080, 'primary': false, 'name': 'B'},
+        ];
+      });
+
+      final List<DisplayInfo> displays = await platform.listDisplays();
+
+      expect(displays, hasLength(2));
+      expect(displays.first.isPrimary, isTrue);
+      expect(displays.last.x, equals(-1920));
+      expect(displays.last.name, equals('B'));
+    });
+
+    test('getStats parses stages and counters', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        expect(methodCall.method, equals('getStats'));
+        return <String, dynamic>{
+          'stages': <String, dynamic>{
+            'capture': <String, dynamic>{
+              'count': 10,
+              'errors': 1,
+              'p50Us': 2000.5,
+              'p95Us': 3000.0,
+              'p99Us': 4000.0,
+              'maxUs': 4100.0,
+              'meanUs': 2200.0,
+            },
+          },
+          'capturedBytes': 82944000,
+          'outputBytes': 1000000,
+          'framePool': <String, dynamic>{'hits': 9, 'misses': 1, 'buffers': 1, 'residentBytes': 8294400},
+          'stream': <String, dynamic>{'captured': 0},
+        };
+      });
+
+      final CaptureStats stats = await platform.getStats();
+
+      expect(stats.stage('capture').count, equals(10));
+      expect(stats.stage('capture').errors, equals(1));
+      expect(stats.stage('capture').p50Us, equals(2000.5));
+      expect(stats.stage('capture').maxUs, equals(4100.0));
+      expect(stats.stage('encode').count, equals(0));
+      expect(stats.capturedBytes, equals(82944000));
+      expect(stats.framePool.hits, equals(9));
+      expect(stats.framePool.residentBytes, equals(8294400));
+      expect(stats.stream.delivered, equals(0));
+    });
+
+    test('resetStats invokes the method', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return null;
+      });
+
+      await platform.resetStats();
+
+      expect(log.single.method, equals('resetStats'));
+    });
+
+    test('startTracing and stopTracing return the trace JSON', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return methodCall.method == 'stopTracing' ? '{"traceEvents":[]}' : null;
+      });
+
+      await platform.startTracing();
+      final String trace = await platform.stopTracing();
+
+      expect(log.map((MethodCall call) => call.method), equals(<String>['startTracing', 'stopTracing']));
+      expect(trace, equals('{"traceEvents":[]}'));
+    });
+
+    test('captureAllDisplays sends its parameters and parses each display', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <Object?>[
+          <String, dynamic>{
+            'displayId': 1,
+            'x': -1920,
+            'y': 0,
+            'width': 1,
+            'height': 1,
+            'stride': 4,
+            'pixelFormat': 'raw_bgra',
+            'bytes': Uint8List.fromList(<int>[1, 2, 3, 255]),
+          },
+        ];
+      });
+
+      final List<DisplayCapture> captures = await platform.captureAllDisplays(
+        includeCursor: true,
+        format: CaptureFormat.rawBgra,
+      );
+
+      expect(log.single.method, equals('captureAllDisplays'));
+      final Map<dynamic, dynamic> args = log.single.arguments as Map<dynamic, dynamic>;
+      expect(args['includeCursor'], isTrue);
+      expect(args['format'], equals('raw_bgra'));
+      expect(captures.single.displayId, equals(1));
+      expect(captures.single.x, equals(-1920));
+      expect(captures.single.data.stride, equals(4));
+    });
+
+    test('captureBatch sends its rects and parses each capture', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <Object?>[
+          <String, dynamic>{
+            'x': 5,
+            'y': 6,
+            'sourceWidth': 2,
+            'sourceHeight': 2,
+            'width': 1,
+            'height': 1,
+            'stride': 4,
+            'pixelFormat': 'raw_bgra',
+            'bytes': Uint8List.fromList(<int>[1, 2, 3, 255]),
+          },
+        ];
+      });
+
+      final List<BatchCapture> captures = await platform.captureBatch(
+        <BatchRect>[const BatchRect(x: 5, y: 6, width: 2, height: 2, scale: 0.5)],
+        format: CaptureFormat.rawBgra,
+        quality: 80,
+      );
+
+      expect(log.single.method, equals('captureBatch'));
+      final Map<dynamic, dynamic> args = log.single.arguments as Map<dynamic, dynamic>;
+      expect(args['format'], equals('raw_bgra'));
+      expect(args['quality'], equals(80));
+      expect(args['includeCursor'], isFalse);
+      expect(
+        args['rects'],
+        equals(<Object?>[
+          <String, dynamic>{'x': 5, 'y': 6, 'width': 2, 'height': 2, 'scale': 0.5},
+        ]),
+      );
+      expect(captures.single.x, equals(5));
+      expect(captures.single.sourceWidth, equals(2));
+      expect(captures.single.data.width, equals(1));
+    });
+
+    test('captureBatch without a result throws', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        return null;
+      });
+
+      expect(
+        () => platform.captureBatch(<BatchRect>[const BatchRect(x: 0, y: 0, width: 1, height: 1)]),
+        throwsA(isA<ScreenshotException>().having((ScreenshotException e) => e.code, 'code', 'internal_error')),
+      );
+    });
+
+    test('captureHash sends its rect and hashes and parses the result', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <String, dynamic>{'x': 10, 'y': 20, 'width': 30, 'height': 40, 'xxh3': -7, 'phash': 255};
+      });
+
+      final CapturedHash hash = await platform.captureHash(
+        rect: const Rectangle<int>(10, 20, 30, 40),
+        hashes: <ImageHashKind>{ImageHashKind.xxh3, ImageHashKind.pHash},
+      );
+
+      expect(log.single.method, equals('captureHash'));
+      final Map<dynamic, dynamic> args = log.single.arguments as Map<dynamic, dynamic>;
+      expect(args['includeCursor'], isFalse);
+      expect(args['rect'], equals(<String, int>{'x': 10, 'y': 20, 'width': 30, 'height': 40}));
+      expect(args['hashes'], equals(<String>['xxh3', 'phash']));
+      expect(hash, equals(const CapturedHash(x: 10, y: 20, width: 30, height: 40, xxh3: -7, pHash: 255)));
+    });
+
+    test('captureHash without arguments leaves out rect and hashes', () async {
+      final List<MethodCall> log = <MethodCall>[];
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        log.add(methodCall);
+        return <String, dynamic>{'x': 0, 'y': 0, 'width': 1920, 'height': 1080, 'xxh3': 1, 'dhash': 2, 'phash': 3};
+      });
+
+      final CapturedHash hash = await platform.captureHash();
+
+      final Map<dynamic, dynamic> args = log.single.arguments as Map<dynamic, dynamic>;
+      expect(args.containsKey('rect'), isFalse);
+      expect(args.containsKey('hashes'), isFalse);
+      expect(hash.dHash, equals(2));
+    });
+
+    test('captureHash without a result throws', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        return null;
+      });
+
+      expect(
+        () => platform.captureHash(),
+        throwsA(isA<ScreenshotException>().having((ScreenshotException e) => e.code, 'code', 'internal_error')),
+      );
+    });
+
     test('capture with region mode sends correct parameters', () async {
       final List<MethodCall> log = <MethodCall>[];
 
@@ -272,5 +894,118 @@ void main() {
         expect(exception.details, equals(123));
       }
     });
+
+    test('capture stops trying the frame channel once it goes unanswered', () async {
+      final MethodChannelScreenshot platform = MethodChannelScreenshot();
+      int frameRequests = 0;
+      final List<MethodCall> calls = <MethodCall>[];
+
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMessageHandler(frameChannel, (
+        ByteData? message,
+      ) async {
+        frameRequests += 1;
+        return null;
+      });
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        calls.add(methodCall);
+        return <String, dynamic>{'width': 1, 'height': 1, 'bytes': Uint8List(4)};
+      });
+
+      await platform.capture(mode: ScreenshotMode.screen);
+      await platform.capture(mode: ScreenshotMode.screen);
+
+      expect(frameRequests, equals(1));
+      expect(calls.map((MethodCall call) => call.method), equals(<String>['capture', 'capture']));
+    });
+
+    test('capture uses the frame channel when it is available', () async {
+      // A new instance: the shared one has seen the channel missing.
+      final MethodChannelScreenshot platform = MethodChannelScreenshot();
+      final List<Object?> requests = <Object?>[];
+      final List<MethodCall> calls = <MethodCall>[];
+
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMessageHandler(frameChannel, (
+        ByteData? message,
+      ) async {
+        requests.add(const StandardMessageCodec().decodeMessage(message));
+        return frameReply(format: 1, width: 3, height: 2, stride: 12, payload: List<int>.filled(24, 0x80));
+      });
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+        MethodCall methodCall,
+      ) async {
+        calls.add(methodCall);
+        return null;
+      });
+
+      final CapturedData? result = await platform.capture(
+        mode: ScreenshotMode.screen,
+        includeCursor: true,
+        format: CaptureFormat.rawBgra,
+      );
+
+      expect(calls, isEmpty);
+      expect(requests, hasLength(1));
+      final Map<Object?, Object?> args = requests.first! as Map<Object?, Object?>;
+      expect(args['mode'], equals('screen'));
+      expect(args['includeCursor'], isTrue);
+      expect(args['format'], equals('raw_bgra'));
+      expect(result, isNotNull);
+      expect(result!.width, equals(3));
+      expect(result.height, equals(2));
+      expect(result.stride, equals(12));
+      expect(result.format, equals(CaptureFormat.rawBgra));
+      expect(result.bytes, equals(List<int>.filled(24, 0x80)));
+    });
+
+    test('capture returns null for a null frame reply', () async {
+      final MethodChannelScreenshot platform = MethodChannelScreenshot();
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMessageHandler(frameChannel, (
+        ByteData? message,
+      ) async {
+        return frameReply(kind: 1);
+      });
+
+      expect(await platform.capture(mode: ScreenshotMode.region), isNull);
+    });
+
+    test('capture maps frame channel errors to ScreenshotException', () async {
+      final MethodChannelScreenshot platform = MethodChannelScreenshot();
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMessageHandler(frameChannel, (
+        ByteData? message,
+      ) async {
+        final ByteData envelope = const StandardMethodCodec().encodeErrorEnvelope(
+          code: 'internal_error',
+          message: 'Failed to capture screen',
+          details: 5,
+        );
+        return frameReply(kind: 2, payload: envelope.buffer.asUint8List(envelope.offsetInBytes, envelope.lengthInBytes));
+      });
+
+      expect(
+        () => platform.capture(mode: ScreenshotMode.screen),
+        throwsA(
+          isA<ScreenshotException>()
+              .having((ScreenshotException e) => e.code, 'code', 'internal_error')
+              .having((ScreenshotException e) => e.message, 'message', 'Failed to capture screen')
+              .having((ScreenshotException e) => e.details, 'details', 5),
+        ),
+      );
+    });
+
+    test('capture rejects malformed frame replies', () async {
+      final MethodChannelScreenshot platform = MethodChannelScreenshot();
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMessageHandler(frameChannel, (
+        ByteData? message,
+      ) async {
+        return ByteData(4);
+      });
+
+      expect(
+        () => platform.capture(mode: ScreenshotMode.screen),
+        throwsA(isA<ScreenshotException>().having((ScreenshotException e) => e.code, 'code', 'internal_error')),
+      );
+    });
   });
 }
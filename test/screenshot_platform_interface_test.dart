@@ -1,6 +1,7 @@
 import 'package:flutter_test/flutter_test.dart';
 import 'package:just_screenshot/screenshot_platform_interface.dart';
 import 'package:just_screenshot/screenshot_method_channel.dart';
+import 'package:just_screenshot/src/models/batch_rect.dart';
 import 'package:just_screenshot/src/models/screenshot_mode.dart';
 
 void main() {
@@ -27,6 +28,57 @@ void main() {
       expect(() => platform.capture(mode: ScreenshotMode.screen), throwsUnimplementedError);
     });
 
+    test('captureTiles and streaming are unimplemented in base class', () {
+      final ScreenshotPlatform platform = TestScreenshotPlatform();
+
+      expect(() => platform.captureTiles(), throwsUnimplementedError);
+      expect(() => platform.startStream(), throwsUnimplementedError);
+      expect(() => platform.stopStream(), throwsUnimplementedError);
+      expect(() => platform.frames, throwsUnimplementedError);
+    });
+
+    test('captureBatch is unimplemented in base class', () {
+      final ScreenshotPlatform platform = TestScreenshotPlatform();
+
+      expect(
+        () => platform.captureBatch(<BatchRect>[const BatchRect(x: 0, y: 0, width: 1, height: 1)]),
+        throwsUnimplementedError,
+      );
+    });
+
+    test('captureHash is unimplemented in base class', () {
+      final ScreenshotPlatform platform = TestScreenshotPlatform();
+
+      expect(() => platform.captureHash(), throwsUnimplementedError);
+    });
+
+    test('captureShared and releaseShared are unimplemented in base class', () {
+      final ScreenshotPlatform platform = TestScreenshotPlatform();
+
+      expect(() => platform.captureShared(mode: ScreenshotMode.screen), throwsUnimplementedError);
+      expect(() => platform.releaseShared(1), throwsUnimplementedError);
+    });
+
+    test('captureToFile is unimplemented in base class', () {
+      final ScreenshotPlatform platform = TestScreenshotPlatform();
+
+      expect(() => platform.captureToFile(path: 'a.png', mode: ScreenshotMode.screen), throwsUnimplementedError);
+    });
+
+    test('getStats and resetStats are unimplemented in base class', () {
+      final ScreenshotPlatform platform = TestScreenshotPlatform();
+
+      expect(() => platform.getStats(), throwsUnimplementedError);
+      expect(() => platform.resetStats(), throwsUnimplementedError);
+    });
+
+    test('startTracing and stopTracing are unimplemented in base class', () {
+      final ScreenshotPlatform platform = TestScreenshotPlatform();
+
+      expect(() => platform.startTracing(), throwsUnimplementedError);
+      expect(() => platform.stopTracing(), throwsUnimplementedError);
+    });
+
     test('verifyToken protects platform instance', () {
       // Attempting to set an instance without proper token should fail
       // This is enforced by PlatformInterface.verifyToken
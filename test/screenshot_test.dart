@@ -1,3 +1,6 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:math';
 import 'dart:typed_data';
 
 import 'package:flutter_test/flutter_test.dart';
@@ -6,27 +9,252 @@ import 'package:just_screenshot/screenshot.dart';
 import 'package:just_screenshot/screenshot_method_channel.dart';
 import 'package:just_screenshot/screenshot_platform_interface.dart';
 
+import 'support/memfd.dart';
+
 class MockScreenshotPlatform with MockPlatformInterfaceMixin implements ScreenshotPlatform {
   CapturedData? _mockResult;
   ScreenshotMode? _capturedMode;
   bool? _capturedIncludeCursor;
   int? _capturedDisplayId;
+  CaptureFormat? _capturedFormat;
+  int? _capturedQuality;
+  ChromaSubsampling? _capturedChromaSubsampling;
+  int? _capturedMaxWidth;
+  int? _capturedMaxHeight;
+  double? _capturedScale;
+  int? _capturedTileSize;
+  double? _capturedFps;
+  bool streaming = false;
+  final StreamController<CapturedFrame> frameController = StreamController<CapturedFrame>.broadcast();
+  bool? _capturedKeyframe;
+  SharedFrame? sharedFrame;
+  final List<int> releasedGenerations = <int>[];
+  CapturedFile? capturedFile;
+  String? capturedPath;
+  List<DisplayInfo> displays = const <DisplayInfo>[];
+  List<DisplayCapture> displayCaptures = const <DisplayCapture>[];
+  List<BatchRect>? capturedRects;
+  List<BatchCapture> batchCaptures = const <BatchCapture>[];
+  Rectangle<int>? capturedHashRect;
+  Set<ImageHashKind>? capturedHashes;
+  bool? capturedFsync;
+  bool? capturedAtomic;
+  CaptureStats stats = const CaptureStats();
+  int statsResets = 0;
+  bool tracing = false;
+  String trace = '{"traceEvents":[]}';
 
   void setMockResult(CapturedData? result) {
     _mockResult = result;
   }
 
   @override
-  Future<CapturedData?> capture({required ScreenshotMode mode, bool includeCursor = false, int? displayId}) async {
+  Future<CapturedData?> capture({
+    required ScreenshotMode mode,
+    bool includeCursor = false,
+    int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+  }) async {
     _capturedMode = mode;
     _capturedIncludeCursor = includeCursor;
     _capturedDisplayId = displayId;
+    _capturedFormat = format;
+    _capturedQuality = quality;
+    _capturedChromaSubsampling = chromaSubsampling;
+    _capturedMaxWidth = maxWidth;
+    _capturedMaxHeight = maxHeight;
+    _capturedScale = scale;
     return _mockResult;
   }
 
+  @override
+  Future<SharedFrame?> captureShared({
+    required ScreenshotMode mode,
+    bool includeCursor = false,
+    int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+  }) async {
+    _capturedMode = mode;
+    _capturedIncludeCursor = includeCursor;
+    _capturedFormat = format;
+    _capturedMaxWidth = maxWidth;
+    _capturedMaxHeight = maxHeight;
+    _capturedScale = scale;
+    return sharedFrame;
+  }
+
+  @override
+  Future<CapturedFile?> captureToFile({
+    required String path,
+    required ScreenshotMode mode,
+    bool includeCursor = false,
+    int? displayId,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+    bool fsync = false,
+    bool atomic = true,
+  }) async {
+    capturedPath = path;
+    _capturedMode = mode;
+    _capturedFormat = format;
+    _capturedMaxWidth = maxWidth;
+    _capturedMaxHeight = maxHeight;
+    _capturedScale = scale;
+    capturedFsync = fsync;
+    capturedAtomic = atomic;
+    return capturedFile;
+  }
+
+  @override
+  Future<void> releaseShared(int generation) async {
+    releasedGenerations.add(generation);
+  }
+
+  @override
+  Future<List<DisplayInfo>> listDisplays() async => displays;
+
+  @override
+  Future<List<DisplayCapture>> captureAllDisplays({
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+  }) async {
+    _capturedIncludeCursor = includeCursor;
+    _capturedFormat = format;
+    _capturedQuality = quality;
+    _capturedChromaSubsampling = chromaSubsampling;
+    return displayCaptures;
+  }
+
+  @override
+  Future<List<BatchCapture>> captureBatch(
+    List<BatchRect> rects, {
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? maxWidth,
+    int? maxHeight,
+    double? scale,
+  }) async {
+    capturedRects = rects;
+    _capturedIncludeCursor = includeCursor;
+    _capturedFormat = format;
+    _capturedQuality = quality;
+    _capturedChromaSubsampling = chromaSubsampling;
+    _capturedMaxWidth = maxWidth;
+    _capturedMaxHeight = maxHeight;
+    _capturedScale = scale;
+    return batchCaptures;
+  }
+
+  @override
+  Future<CapturedHash> captureHash({
+    bool includeCursor = false,
+    Rectangle<int>? rect,
+    Set<ImageHashKind>? hashes,
+  }) async {
+    _capturedIncludeCursor = includeCursor;
+    capturedHashRect = rect;
+    capturedHashes = hashes;
+    return const CapturedHash(x: 0, y: 0, width: 8, height: 8, xxh3: 42);
+  }
+
+  @override
+  Future<CapturedTiles> captureTiles({
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+    int? tileSize,
+    bool keyframe = false,
+  }) async {
+    _capturedIncludeCursor = includeCursor;
+    _capturedFormat = format;
+    _capturedQuality = quality;
+    _capturedChromaSubsampling = chromaSubsampling;
+    _capturedTileSize = tileSize;
+    _capturedKeyframe = keyframe;
+    return CapturedTiles(
+      width: 100,
+      height: 50,
+      keyframe: keyframe,
+      tileSize: tileSize ?? 64,
+      tiles: const <CapturedTile>[],
+      format: format,
+    );
+  }
+
+  @override
+  Future<void> startStream({
+    double fps = 30,
+    bool includeCursor = false,
+    CaptureFormat format = CaptureFormat.png,
+    int? quality,
+    ChromaSubsampling? chromaSubsampling,
+  }) async {
+    _capturedFps = fps;
+    _capturedIncludeCursor = includeCursor;
+    _capturedFormat = format;
+    _capturedQuality = quality;
+    _capturedChromaSubsampling = chromaSubsampling;
+    streaming = true;
+  }
+
+  @override
+  Future<void> stopStream() async {
+    streaming = false;
+  }
+
+  @override
+  Stream<CapturedFrame> get frames => frameController.stream;
+
+  @override
+  Future<CaptureStats> getStats() async => stats;
+
+  @override
+  Future<void> resetStats() async {
+    statsResets++;
+  }
+
+  @override
+  Future<void> startTracing() async {
+    tracing = true;
+  }
+
+  @override
+  Future<String> stopTracing() async {
+    tracing = false;
+    return trace;
+  }
+
   ScreenshotMode? get capturedMode => _capturedMode;
   bool? get capturedIncludeCursor => _capturedIncludeCursor;
   int? get capturedDisplayId => _capturedDisplayId;
+  CaptureFormat? get capturedFormat => _capturedFormat;
+  int? get capturedQuality => _capturedQuality;
+  ChromaSubsampling? get capturedChromaSubsampling => _capturedChromaSubsampling;
+  int? get capturedMaxWidth => _capturedMaxWidth;
+  int? get capturedMaxHeight => _capturedMaxHeight;
+  double? get capturedScale => _capturedScale;
+  int? get capturedTileSize => _capturedTileSize;
+  double? get capturedFps => _capturedFps;
+  bool? get capturedKeyframe => _capturedKeyframe;
 }
 
 void main() {
@@ -83,6 +311,273 @@ void main() {
       expect(fakePlatform.capturedMode, equals(ScreenshotMode.screen));
       expect(fakePlatform.capturedIncludeCursor, equals(false));
       expect(fakePlatform.capturedDisplayId, isNull);
+      expect(fakePlatform.capturedFormat, equals(CaptureFormat.png));
+    });
+
+    test('capture forwards format to platform', () async {
+      fakePlatform.setMockResult(null);
+
+      await Screenshot.instance.capture(mode: ScreenshotMode.screen, format: CaptureFormat.rawRgba);
+
+      expect(fakePlatform.capturedFormat, equals(CaptureFormat.rawRgba));
+    });
+
+    test('capture forwards lossy encoding options to platform', () async {
+      fakePlatform.setMockResult(null);
+
+      await Screenshot.instance.capture(
+        mode: ScreenshotMode.screen,
+        format: CaptureFormat.jpeg,
+        quality: 60,
+        chromaSubsampling: ChromaSubsampling.chroma422,
+      );
+
+      expect(fakePlatform.capturedFormat, equals(CaptureFormat.jpeg));
+      expect(fakePlatform.capturedQuality, equals(60));
+      expect(fakePlatform.capturedChromaSubsampling, equals(ChromaSubsampling.chroma422));
+    });
+
+    test('capture forwards size limits to platform', () async {
+      fakePlatform.setMockResult(null);
+
+      await Screenshot.instance.capture(
+        mode: ScreenshotMode.screen,
+        maxWidth: 1920,
+        maxHeight: 1080,
+        scale: 0.5,
+      );
+
+      expect(fakePlatform.capturedMaxWidth, equals(1920));
+      expect(fakePlatform.capturedMaxHeight, equals(1080));
+      expect(fakePlatform.capturedScale, equals(0.5));
+    });
+
+    test('listDisplays returns the platform displays', () async {
+      const DisplayInfo primary = DisplayInfo(id: 0, x: 0, y: 0, width: 2560, height: 1440, isPrimary: true);
+      const DisplayInfo left = DisplayInfo(id: 1, x: -1920, y: 0, width: 1920, height: 1080);
+      fakePlatform.displays = const <DisplayInfo>[primary, left];
+
+      expect(await Screenshot.instance.listDisplays(), equals(<DisplayInfo>[primary, left]));
+    });
+
+    test('getStats and resetStats delegate to platform', () async {
+      fakePlatform.stats = const CaptureStats(
+        stages: <String, StageStats>{'encode': StageStats(count: 3, p99Us: 1500)},
+        outputBytes: 1024,
+      );
+
+      final CaptureStats stats = await Screenshot.instance.getStats();
+      expect(stats.stage('encode').count, equals(3));
+      expect(stats.stage('encode').p99Us, equals(1500));
+      expect(stats.stage('cursor').count, equals(0));
+      expect(stats.outputBytes, equals(1024));
+
+      await Screenshot.instance.resetStats();
+      expect(fakePlatform.statsResets, equals(1));
+    });
+
+    test('startTracing and stopTracing delegate to platform', () async {
+      fakePlatform.trace = '{"traceEvents":[{"name":"capture","ph":"X"}]}';
+
+      await Screenshot.instance.startTracing();
+      expect(fakePlatform.tracing, isTrue);
+
+      expect(await Screenshot.instance.stopTracing(), equals(fakePlatform.trace));
+      expect(fakePlatform.tracing, isFalse);
+    });
+
+    test('capture passes all mode and displayId through', () async {
+      await Screenshot.instance.capture(mode: ScreenshotMode.all);
+      expect(fakePlatform.capturedMode, equals(ScreenshotMode.all));
+
+      await Screenshot.instance.capture(mode: ScreenshotMode.screen, displayId: 1);
+      expect(fakePlatform.capturedDisplayId, equals(1));
+    });
+
+    test('captureAllDisplays delegates to platform with correct parameters', () async {
+      final DisplayCapture capture = DisplayCapture(
+        displayId: 0,
+        x: 0,
+        y: 0,
+        data: CapturedData(width: 1, height: 1, bytes: Uint8List.fromList(<int>[1, 2, 3, 255])),
+      );
+      fakePlatform.displayCaptures = <DisplayCapture>[capture];
+
+      final List<DisplayCapture> result = await Screenshot.instance.captureAllDisplays(
+        includeCursor: true,
+        format: CaptureFormat.jpeg,
+        quality: 70,
+      );
+
+      expect(result, equals(<DisplayCapture>[capture]));
+      expect(fakePlatform.capturedIncludeCursor, isTrue);
+      expect(fakePlatform.capturedFormat, equals(CaptureFormat.jpeg));
+      expect(fakePlatform.capturedQuality, equals(70));
+    });
+
+    test('captureBatch delegates to platform with correct parameters', () async {
+      final BatchCapture capture = BatchCapture(
+        x: 10,
+        y: 20,
+        sourceWidth: 1,
+        sourceHeight: 1,
+        data: CapturedData(width: 1, height: 1, bytes: Uint8List.fromList(<int>[1, 2, 3, 255])),
+      );
+      fakePlatform.batchCaptures = <BatchCapture>[capture];
+      const List<BatchRect> rects = <BatchRect>[
+        BatchRect(x: 10, y: 20, width: 1, height: 1),
+        BatchRect(x: 0, y: 0, width: 64, height: 64, format: CaptureFormat.png),
+      ];
+
+      final List<BatchCapture> result = await Screenshot.instance.captureBatch(
+        rects,
+        includeCursor: true,
+        format: CaptureFormat.jpeg,
+        quality: 70,
+        scale: 0.5,
+      );
+
+      expect(result, equals(<BatchCapture>[capture]));
+      expect(fakePlatform.capturedRects, equals(rects));
+      expect(fakePlatform.capturedIncludeCursor, isTrue);
+      expect(fakePlatform.capturedFormat, equals(CaptureFormat.jpeg));
+      expect(fakePlatform.capturedQuality, equals(70));
+      expect(fakePlatform.capturedScale, equals(0.5));
+    });
+
+    test('captureHash delegates to platform with correct parameters', () async {
+      final CapturedHash result = await Screenshot.instance.captureHash(
+        includeCursor: true,
+        rect: const Rectangle<int>(0, 0, 8, 8),
+        hashes: <ImageHashKind>{ImageHashKind.xxh3},
+      );
+
+      expect(result.xxh3, equals(42));
+      expect(fakePlatform.capturedIncludeCursor, isTrue);
+      expect(fakePlatform.capturedHashRect, equals(const Rectangle<int>(0, 0, 8, 8)));
+      expect(fakePlatform.capturedHashes, equals(<ImageHashKind>{ImageHashKind.xxh3}));
+    });
+
+    test('captureTiles delegates to platform with correct parameters', () async {
+      final CapturedTiles result = await Screenshot.instance.captureTiles(
+        includeCursor: true,
+        format: CaptureFormat.rawBgra,
+        tileSize: 32,
+        keyframe: true,
+      );
+
+      expect(fakePlatform.capturedIncludeCursor, equals(true));
+      expect(fakePlatform.capturedFormat, equals(CaptureFormat.rawBgra));
+      expect(fakePlatform.capturedTileSize, equals(32));
+      expect(fakePlatform.capturedKeyframe, equals(true));
+      expect(result.keyframe, isTrue);
+      expect(result.tileSize, equals(32));
+    });
+
+    test('captureShared returns null when platform returns null', () async {
+      final SharedCapture? result = await Screenshot.instance.captureShared(mode: ScreenshotMode.region);
+
+      expect(result, isNull);
+      expect(fakePlatform.capturedMode, equals(ScreenshotMode.region));
+      expect(fakePlatform.releasedGenerations, isEmpty);
+    });
+
+    test('captureShared maps the frame and releases it once', () async {
+      final Uint8List pixels = Uint8List.fromList(List<int>.generate(64, (int i) => i));
+      final int fd = createMemfd(pixels, offset: 65536);
+      addTearDown(() => closeMemfd(fd));
+      fakePlatform.sharedFrame = SharedFrame(
+        width: 4,
+        height: 4,
+        format: CaptureFormat.rawBgra,
+        stride: 16,
+        handle: fd,
+        offset: 65536,
+        length: pixels.length,
+        generation: 9,
+      );
+
+      final SharedCapture? result = await Screenshot.instance.captureShared(
+        mode: ScreenshotMode.screen,
+        format: CaptureFormat.rawBgra,
+      );
+
+      expect(result, isNotNull);
+      expect(fakePlatform.capturedFormat, equals(CaptureFormat.rawBgra));
+      expect(result!.frame.generation, equals(9));
+      expect(result.bytes, equals(pixels));
+
+      await result.release();
+      await result.release();
+      expect(result.isReleased, isTrue);
+      expect(fakePlatform.releasedGenerations, equals(<int>[9]));
+      expect(() => result.bytes, throwsStateError);
+    }, skip: !Platform.isLinux);
+
+    test('captureShared releases frames it cannot map', () async {
+      fakePlatform.sharedFrame = const SharedFrame(
+        width: 4,
+        height: 4,
+        handle: -1,
+        offset: 0,
+        length: 64,
+        generation: 3,
+      );
+
+      await expectLater(
+        Screenshot.instance.captureShared(mode: ScreenshotMode.screen),
+        throwsA(isA<ScreenshotException>().having((ScreenshotException e) => e.code, 'code', 'internal_error')),
+      );
+      expect(fakePlatform.releasedGenerations, equals(<int>[3]));
+    }, skip: !Platform.isLinux);
+
+    test('captureToFile delegates to platform', () async {
+      fakePlatform.capturedFile = const CapturedFile(
+        path: '/tmp/shot.qoi',
+        width: 1920,
+        height: 1080,
+        format: CaptureFormat.qoi,
+        byteCount: 2500000,
+        elapsed: Duration(milliseconds: 21),
+      );
+
+      final CapturedFile? result = await Screenshot.instance.captureToFile(
+        path: '/tmp/shot.qoi',
+        mode: ScreenshotMode.screen,
+        format: CaptureFormat.qoi,
+        maxWidth: 1280,
+        fsync: true,
+      );
+
+      expect(result, equals(fakePlatform.capturedFile));
+      expect(fakePlatform.capturedPath, equals('/tmp/shot.qoi'));
+      expect(fakePlatform.capturedFormat, equals(CaptureFormat.qoi));
+      expect(fakePlatform.capturedMaxWidth, equals(1280));
+      expect(fakePlatform.capturedFsync, isTrue);
+      expect(fakePlatform.capturedAtomic, isTrue);
+    });
+
+    test('startStream, frames and stopStream delegate to platform', () async {
+      final List<CapturedFrame> received = <CapturedFrame>[];
+      final StreamSubscription<CapturedFrame> subscription = Screenshot.instance.frames.listen(received.add);
+
+      await Screenshot.instance.startStream(fps: 60, format: CaptureFormat.qoi);
+      expect(fakePlatform.streaming, isTrue);
+      expect(fakePlatform.capturedFps, equals(60));
+      expect(fakePlatform.capturedFormat, equals(CaptureFormat.qoi));
+
+      final CapturedFrame frame = CapturedFrame(
+        sequence: 0,
+        timestamp: Duration.zero,
+        data: CapturedData(width: 1, height: 1, bytes: Uint8List(4)),
+      );
+      fakePlatform.frameController.add(frame);
+      await Future<void>.delayed(Duration.zero);
+      expect(received, equals(<CapturedFrame>[frame]));
+
+      await Screenshot.instance.stopStream();
+      expect(fakePlatform.streaming, isFalse);
+      await subscription.cancel();
     });
 
     test('Screenshot uses singleton pattern', () {
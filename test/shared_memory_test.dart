@@ -0,0 +1,29 @@
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:just_screenshot/src/shared_memory.dart';
+
+import 'support/memfd.dart';
+
+void main() {
+  group('SharedMemoryView', () {
+    test('maps bytes at an offset without copying them', () {
+      final Uint8List frame = Uint8List.fromList(List<int>.generate(5000, (int i) => i * 7));
+      final int fd = createMemfd(frame, offset: 65536);
+      addTearDown(() => closeMemfd(fd));
+
+      final SharedMemoryView view = SharedMemoryView.map(handle: fd, offset: 65536, length: frame.length);
+      expect(view.isMapped, isTrue);
+      expect(view.bytes, equals(frame));
+      view.unmap();
+      expect(view.isMapped, isFalse);
+      view.unmap();
+    }, skip: !Platform.isLinux);
+
+    test('throws for a handle that cannot be mapped', () {
+      expect(() => SharedMemoryView.map(handle: -1, offset: 0, length: 16), throwsA(isA<OSError>()));
+      expect(() => SharedMemoryView.map(handle: -1, offset: 0, length: 0), throwsArgumentError);
+    }, skip: !Platform.isLinux);
+  });
+}
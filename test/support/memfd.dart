@@ -0,0 +1,42 @@
+import 'dart:ffi';
+import 'dart:typed_data';
+
+typedef _MallocNative = Pointer<Uint8> Function(IntPtr);
+typedef _Malloc = Pointer<Uint8> Function(int);
+typedef _FreeNative = Void Function(Pointer<Uint8>);
+typedef _Free = void Function(Pointer<Uint8>);
+typedef _MemfdCreateNative = Int32 Function(Pointer<Uint8>, Uint32);
+typedef _MemfdCreate = int Function(Pointer<Uint8>, int);
+typedef _PwriteNative = IntPtr Function(Int32, Pointer<Uint8>, IntPtr, Int64);
+typedef _Pwrite = int Function(int, Pointer<Uint8>, int, int);
+typedef _CloseNative = Int32 Function(Int32);
+typedef _Close = int Function(int);
+
+final DynamicLibrary _libc = DynamicLibrary.process();
+final _Malloc _malloc = _libc.lookupFunction<_MallocNative, _Malloc>('malloc');
+final _Free _free = _libc.lookupFunction<_FreeNative, _Free>('free');
+final _MemfdCreate _memfdCreate = _libc.lookupFunction<_MemfdCreateNative, _MemfdCreate>('memfd_create');
+final _Pwrite _pwrite = _libc.lookupFunction<_PwriteNative, _Pwrite>('pwrite');
+final _Close _close = _libc.lookupFunction<_CloseNative, _Close>('close');
+
+/// A Linux memfd holding [bytes] at [offset], standing in for the plugin's
+/// shared memory. Close it with [closeMemfd].
+int createMemfd(Uint8List bytes, {int offset = 0}) {
+  final Pointer<Uint8> name = _malloc(8);
+  name.asTypedList(8).setAll(0, <int>[...'test'.codeUnits, 0, 0, 0, 0]);
+  final int fd = _memfdCreate(name, 0);
+  _free(name);
+  if (fd < 0) throw StateError('memfd_create failed');
+
+  final Pointer<Uint8> buffer = _malloc(bytes.length);
+  buffer.asTypedList(bytes.length).setAll(0, bytes);
+  final int written = _pwrite(fd, buffer, bytes.length, offset);
+  _free(buffer);
+  if (written != bytes.length) throw StateError('pwrite failed');
+  return fd;
+}
+
+/// Closes a file descriptor from [createMemfd].
+void closeMemfd(int fd) {
+  _close(fd);
+}
@@ -0,0 +1,38 @@
+#include "gdi_capture_source.h"
+
+#include <windows.h>
+
+#include <cstring>
+
+#include "image.h"
+
+namespace screenshot {
+
+PixelRect GdiCaptureSource::Bounds() {
+  // Physical pixels, not the scaled ones a DPI-unaware process is told.
+  SetProcessDPIAware();
+  return PixelRect{0, 0, GetSystemMetrics(SM_CXSCREEN),
+                   GetSystemMetrics(SM_CYSCREEN)};
+}
+
+bool GdiCaptureSource::Capture(const PixelRect& rect, bool include_cursor,
+                               uint8_t* pixels, size_t stride) {
+  if (rect.IsEmpty()) return false;
+  if (!surface_.Capture(rect.x, rect.y, rect.width, rect.height,
+                        include_cursor)) {
+    return false;
+  }
+  const size_t row_bytes = static_cast<size_t>(rect.width) * kBytesPerPixel;
+  if (stride == row_bytes) return surface_.Read(pixels);
+
+  packed_.resize(row_bytes * static_cast<size_t>(rect.height));
+  if (!surface_.Read(packed_.data())) return false;
+  for (int y = 0; y < rect.height; ++y) {
+    std::memcpy(pixels + static_cast<size_t>(y) * stride,
+                packed_.data() + static_cast<size_t>(y) * row_bytes,
+                row_bytes);
+  }
+  return true;
+}
+
+}  // namespace screenshot
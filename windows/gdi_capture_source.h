@@ -0,0 +1,46 @@
+#ifndef FLUTTER_PLUGIN_GDI_CAPTURE_SOURCE_H_
+#define FLUTTER_PLUGIN_GDI_CAPTURE_SOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "capture_source.h"
+#include "image_rect.h"
+#include "screen_surface.h"
+
+namespace screenshot {
+
+// The screen, read with GDI: BitBlt into a ScreenSurface kept between
+// captures, then GetDIBits into the caller's buffer. Coordinates are
+// virtual-desktop pixels, so any display can be captured; Bounds() is the
+// primary display.
+//
+// Use from one thread at a time.
+class GdiCaptureSource : public CaptureSource {
+ public:
+  GdiCaptureSource() = default;
+
+  GdiCaptureSource(const GdiCaptureSource&) = delete;
+  GdiCaptureSource& operator=(const GdiCaptureSource&) = delete;
+
+  PixelRect Bounds() override;
+
+  // On failure the reason is in GetLastError().
+  bool Capture(const PixelRect& rect, bool include_cursor, uint8_t* pixels,
+               size_t stride) override;
+
+  // Times finding the cursor after the BitBlt and compositing it onto the
+  // pixels read.
+  int64_t cursor_nanos() const override { return surface_.cursor_nanos(); }
+
+ private:
+  ScreenSurface surface_;
+  // GetDIBits writes packed rows; they land here first when the caller's
+  // rows are padded.
+  std::vector<uint8_t> packed_;
+};
+
+}  // namespace screenshot
+
+#endif  // FLUTTER_PLUGIN_GDI_CAPTURE_SOURCE_H_
@@ -0,0 +1,68 @@
+#include "gdi_display_backend.h"
+
+#include <windows.h>
+
+#include <string>
+
+namespace screenshot {
+namespace {
+
+// Converts a monitor's device name to UTF-8.
+std::string DeviceName(const wchar_t* name) {
+  const int size =
+      WideCharToMultiByte(CP_UTF8, 0, name, -1, nullptr, 0, nullptr, nullptr);
+  if (size <= 1) return std::string();
+  std::string utf8(static_cast<size_t>(size), '\0');
+  WideCharToMultiByte(CP_UTF8, 0, name, -1, &utf8[0], size, nullptr, nullptr);
+  utf8.resize(static_cast<size_t>(size - 1));
+  return utf8;
+}
+
+BOOL CALLBACK AddDisplay(HMONITOR monitor, HDC, LPRECT, LPARAM data) {
+  auto* displays = reinterpret_cast<std::vector<DisplayInfo>*>(data);
+  MONITORINFOEX info = {};
+  info.cbSize = sizeof(info);
+  if (!GetMonitorInfo(monitor, &info)) return TRUE;
+  DisplayInfo display;
+  display.id = static_cast<int>(displays->size());
+  display.bounds = PixelRect{info.rcMonitor.left, info.rcMonitor.top,
+                             info.rcMonitor.right - info.rcMonitor.left,
+                             info.rcMonitor.bottom - info.rcMonitor.top};
+  display.primary = (info.dwFlags & MONITORINFOF_PRIMARY) != 0;
+  display.name = DeviceName(info.szDevice);
+  displays->push_back(display);
+  return TRUE;
+}
+
+}  // namespace
+
+bool GdiDisplayBackend::ListDisplays(std::vector<DisplayInfo>* displays) {
+  // Monitor rectangles are in physical pixels only when DPI aware.
+  SetProcessDPIAware();
+  displays->clear();
+  if (!EnumDisplayMonitors(nullptr, nullptr, AddDisplay,
+                           reinterpret_cast<LPARAM>(displays))) {
+    return false;
+  }
+  return !displays->empty();
+}
+
+bool GdiDisplayBackend::CaptureDisplay(const DisplayInfo& display,
+                                       bool include_cursor, int lane,
+                                       uint8_t* pixels) {
+  ScreenSurface* surface = Surface(lane);
+  const PixelRect& bounds = display.bounds;
+  return surface->Capture(bounds.x, bounds.y, bounds.width, bounds.height,
+                          include_cursor) &&
+         surface->Read(pixels);
+}
+
+ScreenSurface* GdiDisplayBackend::Surface(int lane) {
+  std::lock_guard<std::mutex> lock(surfaces_mutex_);
+  const size_t index = static_cast<size_t>(lane);
+  if (surfaces_.size() <= index) surfaces_.resize(index + 1);
+  if (!surfaces_[index]) surfaces_[index] = std::make_unique<ScreenSurface>();
+  return surfaces_[index].get();
+}
+
+}  // namespace screenshot
@@ -0,0 +1,41 @@
+#ifndef FLUTTER_PLUGIN_GDI_DISPLAY_BACKEND_H_
+#define FLUTTER_PLUGIN_GDI_DISPLAY_BACKEND_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "display_capture.h"
+#include "screen_surface.h"
+
+namespace screenshot {
+
+// Displays as GDI sees them: the monitors EnumDisplayMonitors() reports,
+// in its order, captured with BitBlt from the virtual screen's DC.
+//
+// Each capture lane keeps a ScreenSurface of its own, so displays captured
+// concurrently never share a DC, and a lane reuses its surface (and the
+// bitmap of its display's size) from call to call.
+class GdiDisplayBackend : public DisplayBackend {
+ public:
+  GdiDisplayBackend() = default;
+
+  GdiDisplayBackend(const GdiDisplayBackend&) = delete;
+  GdiDisplayBackend& operator=(const GdiDisplayBackend&) = delete;
+
+  bool ListDisplays(std::vector<DisplayInfo>* displays) override;
+
+  bool CaptureDisplay(const DisplayInfo& display, bool include_cursor,
+                      int lane, uint8_t* pixels) override;
+
+ private:
+  // The surface of |lane|, created on first use.
+  ScreenSurface* Surface(int lane);
+
+  std::mutex surfaces_mutex_;
+  std::vector<std::unique_ptr<ScreenSurface>> surfaces_;
+};
+
+}  // namespace screenshot
+
+#endif  // FLUTTER_PLUGIN_GDI_DISPLAY_BACKEND_H_
@@ -0,0 +1,92 @@
+#include "platform_task_queue.h"
+
+#include <utility>
+
+namespace screenshot {
+
+namespace {
+
+// How often a failed wake is retried.
+constexpr DWORD kWakeRetryMs = 16;
+
+}  // namespace
+
+PlatformTaskQueue::PlatformTaskQueue(
+    flutter::PluginRegistrarWindows* registrar)
+    : registrar_(registrar) {
+  if (!registrar_ || !registrar_->GetView()) return;
+  HWND view = registrar_->GetView()->GetNativeWindow();
+  window_ = view ? GetAncestor(view, GA_ROOT) : nullptr;
+  if (!window_) return;
+  message_ = RegisterWindowMessage(L"ScreenshotPluginPlatformTask");
+  delegate_id_ = registrar_->RegisterTopLevelWindowProcDelegate(
+      [this](HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+        return HandleWindowProc(hwnd, message, wparam, lparam);
+      });
+}
+
+PlatformTaskQueue::~PlatformTaskQueue() {
+  if (retry_timer_) {
+    // Waits for a running RetryWake() to return.
+    DeleteTimerQueueTimer(nullptr, retry_timer_, INVALID_HANDLE_VALUE);
+  }
+  if (delegate_id_ >= 0) {
+    registrar_->UnregisterTopLevelWindowProcDelegate(delegate_id_);
+  }
+}
+
+bool PlatformTaskQueue::Post(std::function<void()> task) {
+  if (!window_) return false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    // One message drains everything queued before it runs.
+    if (wake_pending_) return true;
+    wake_pending_ = true;
+  }
+  if (!PostMessage(window_, message_, 0, 0)) ScheduleWakeRetry();
+  return true;
+}
+
+void PlatformTaskQueue::ScheduleWakeRetry() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  wake_failed_ = true;
+  if (retry_timer_) return;
+  // The timer can't be a window timer: SetTimer only accepts windows owned
+  // by the calling thread, and Post() runs on the pipeline's threads.
+  if (!CreateTimerQueueTimer(
+          &retry_timer_, nullptr,
+          [](PVOID queue, BOOLEAN) {
+            static_cast<PlatformTaskQueue*>(queue)->RetryWake();
+          },
+          this, kWakeRetryMs, kWakeRetryMs, WT_EXECUTEDEFAULT)) {
+    retry_timer_ = nullptr;
+  }
+}
+
+void PlatformTaskQueue::RetryWake() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!wake_failed_) return;
+  }
+  // A failure leaves wake_failed_ set for the next tick.
+  if (!PostMessage(window_, message_, 0, 0)) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  wake_failed_ = false;
+}
+
+std::optional<LRESULT> PlatformTaskQueue::HandleWindowProc(
+    HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+  if (message != message_) return std::nullopt;
+  std::deque<std::function<void()>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks.swap(tasks_);
+    wake_pending_ = false;
+    wake_failed_ = false;
+  }
+  for (std::function<void()>& task : tasks) task();
+  return 0;
+}
+
+}  // namespace screenshot
@@ -0,0 +1,64 @@
+#ifndef FLUTTER_PLUGIN_PLATFORM_TASK_QUEUE_H_
+#define FLUTTER_PLUGIN_PLATFORM_TASK_QUEUE_H_
+
+#include <windows.h>
+
+#include <flutter/plugin_registrar_windows.h>
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+namespace screenshot {
+
+// Runs tasks on the platform (UI) thread, where Flutter requires method
+// results and event sink calls to happen.
+//
+// Post() may be called from any thread. Tasks are delivered through a
+// private window message to the Flutter view's top-level window, one
+// message per batch, and run in the order they were posted.
+class PlatformTaskQueue {
+ public:
+  explicit PlatformTaskQueue(flutter::PluginRegistrarWindows* registrar);
+  ~PlatformTaskQueue();
+
+  PlatformTaskQueue(const PlatformTaskQueue&) = delete;
+  PlatformTaskQueue& operator=(const PlatformTaskQueue&) = delete;
+
+  // Whether there is a window to deliver to (false without a Flutter view).
+  bool IsAvailable() const { return window_ != nullptr; }
+
+  // Queues |task| to run on the platform thread. Returns false (and drops
+  // the task) only if the queue is not available. A task that is accepted
+  // always runs: if the window cannot be woken, the wake is retried on a
+  // timer until it can.
+  bool Post(std::function<void()> task);
+
+ private:
+  std::optional<LRESULT> HandleWindowProc(HWND hwnd, UINT message,
+                                          WPARAM wparam, LPARAM lparam);
+
+  // Starts retrying the wake after PostMessage failed.
+  void ScheduleWakeRetry();
+  // Timer callback: posts the wake message if one is still owed.
+  void RetryWake();
+
+  flutter::PluginRegistrarWindows* registrar_;
+  HWND window_ = nullptr;
+  UINT message_ = 0;
+  int delegate_id_ = -1;
+
+  std::mutex mutex_;
+  std::deque<std::function<void()>> tasks_;
+  // A message to drain tasks_ is due and has not been handled yet.
+  bool wake_pending_ = false;
+  // That message could not be posted; RetryWake() owes it.
+  bool wake_failed_ = false;
+  // Created on the first failed wake, kept until destruction.
+  HANDLE retry_timer_ = nullptr;
+};
+
+}  // namespace screenshot
+
+#endif  // FLUTTER_PLUGIN_PLATFORM_TASK_QUEUE_H_
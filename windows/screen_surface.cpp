@@ -0,0 +1,191 @@
+#include "screen_surface.h"
+
+#include <vector>
+
+#include "capture_stats.h"
+#include "trace.h"
+
+namespace screenshot {
+
+namespace {
+
+// Reads |bitmap| as top-down rows of |bits_per_pixel| (32 or 1) into |out|,
+// 1-bit rows padded to 32 bits. The bitmap must not be selected into a DC.
+bool ReadBitmap(HDC dc, HBITMAP bitmap, int width, int height,
+                WORD bits_per_pixel, std::vector<uint8_t>* out) {
+  // Room for the two-entry color table GetDIBits writes for 1-bit rows.
+  struct {
+    BITMAPINFOHEADER header;
+    RGBQUAD colors[2];
+  } info = {};
+  info.header.biSize = sizeof(BITMAPINFOHEADER);
+  info.header.biWidth = width;
+  info.header.biHeight = -height;
+  info.header.biPlanes = 1;
+  info.header.biBitCount = bits_per_pixel;
+  info.header.biCompression = BI_RGB;
+  const size_t stride = bits_per_pixel == 1
+                            ? CursorMaskStride(width)
+                            : static_cast<size_t>(width) * 4;
+  out->resize(stride * static_cast<size_t>(height));
+  return GetDIBits(dc, bitmap, 0, static_cast<UINT>(height), out->data(),
+                   reinterpret_cast<BITMAPINFO*>(&info),
+                   DIB_RGB_COLORS) == height;
+}
+
+// Decodes |handle|'s bitmaps into |cursor|: color cursors from their color
+// bitmap and AND mask, monochrome ones from the double-height mask that
+// holds both their AND and XOR masks.
+bool DecodeCursor(HDC dc, HCURSOR handle, CursorImage* cursor) {
+  ICONINFO icon = {};
+  if (!GetIconInfo(handle, &icon)) return false;
+  BITMAP mask_info = {};
+  bool decoded = false;
+  if (icon.hbmMask &&
+      GetObject(icon.hbmMask, sizeof(mask_info), &mask_info) != 0) {
+    const int width = mask_info.bmWidth;
+    std::vector<uint8_t> mask;
+    if (icon.hbmColor) {
+      const int height = mask_info.bmHeight;
+      std::vector<uint8_t> color;
+      decoded =
+          ReadBitmap(dc, icon.hbmColor, width, height, 32, &color) &&
+          ReadBitmap(dc, icon.hbmMask, width, height, 1, &mask) &&
+          DecodeColorCursor(color.data(), mask.data(), width, height, cursor);
+    } else {
+      decoded =
+          ReadBitmap(dc, icon.hbmMask, width, mask_info.bmHeight, 1, &mask) &&
+          DecodeMonochromeCursor(mask.data(), width, mask_info.bmHeight / 2,
+                                 cursor);
+    }
+  }
+  if (decoded) {
+    cursor->hotspot_x = static_cast<int>(icon.xHotspot);
+    cursor->hotspot_y = static_cast<int>(icon.yHotspot);
+  } else {
+    *cursor = CursorImage();
+  }
+  if (icon.hbmMask) DeleteObject(icon.hbmMask);
+  if (icon.hbmColor) DeleteObject(icon.hbmColor);
+  return decoded;
+}
+
+}  // namespace
+
+ScreenSurface::~ScreenSurface() { Release(); }
+
+bool ScreenSurface::Capture(int x, int y, int width, int height,
+                            bool include_cursor) {
+  cursor_ = nullptr;
+  if (width <= 0 || height <= 0) return false;
+  HDC screen = GetDC(nullptr);
+  if (!screen) return false;
+  if (!Resize(screen, width, height)) {
+    ReleaseDC(nullptr, screen);
+    return false;
+  }
+  
+  BOOL copied = FALSE;
+  {
+    TraceSpan span("BitBlt");
+    copied = BitBlt(dc_, 0, 0, width, height, screen, x, y, SRCCOPY);
+  }
+  ReleaseDC(nullptr, screen);
+  if (!copied) return false;
+  
+  // Look up the cursor now, while the screen matches the copy; it is
+  // composited onto the pixels in Read().
+  cursor_nanos_ = -1;
+  if (include_cursor) {
+    TraceSpan span("cursor");
+    const int64_t cursor_start = MonotonicNanos();
+    POINT position = {};
+    cursor_ = CurrentCursor(&position);
+    if (cursor_) {
+      cursor_x_ = static_cast<int>(position.x) - cursor_->hotspot_x - x;
+      cursor_y_ = static_cast<int>(position.y) - cursor_->hotspot_y - y;
+    }
+    cursor_nanos_ = MonotonicNanos() - cursor_start;
+  }
+  return true;
+}
+
+bool ScreenSurface::Read(uint8_t* pixels) {
+  if (!bitmap_) return false;
+  BITMAPINFO bmi = {};
+  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bmi.bmiHeader.biWidth = width_;
+  bmi.bmiHeader.biHeight = -height_;  // Negative height = top-down
+  bmi.bmiHeader.biPlanes = 1;
+  bmi.bmiHeader.biBitCount = 32;
+  bmi.bmiHeader.biCompression = BI_RGB;
+  
+  // GetDIBits wants the bitmap out of any DC while it reads.
+  TraceSpan span("GetDIBits");
+  SelectObject(dc_, original_bitmap_);
+  const int lines = GetDIBits(dc_, bitmap_, 0, static_cast<UINT>(height_),
+                              pixels, &bmi, DIB_RGB_COLORS);
+  SelectObject(dc_, bitmap_);
+  if (lines != height_) return false;
+  if (cursor_) {
+    TraceSpan cursor_span("cursor");
+    const int64_t cursor_start = MonotonicNanos();
+    CompositeCursor(*cursor_, cursor_x_, cursor_y_, pixels, width_, height_,
+                    static_cast<size_t>(width_) * 4);
+    cursor_nanos_ += MonotonicNanos() - cursor_start;
+  }
+  return true;
+}
+
+const CursorImage* ScreenSurface::CurrentCursor(POINT* position) {
+  CURSORINFO info = {};
+  info.cbSize = sizeof(CURSORINFO);
+  if (!GetCursorInfo(&info) || !(info.flags & CURSOR_SHOWING) ||
+      !info.hCursor) {
+    return nullptr;
+  }
+  *position = info.ptScreenPos;
+  const uint64_t key = reinterpret_cast<uintptr_t>(info.hCursor);
+  const CursorImage* cached = cursors_.Find(key);
+  if (!cached) {
+    CursorImage* image = cursors_.Insert(key);
+    DecodeCursor(dc_, info.hCursor, image);
+    cached = image;
+  }
+  return cached->IsEmpty() ? nullptr : cached;
+}
+
+bool ScreenSurface::Resize(HDC screen, int width, int height) {
+  if (bitmap_ && width == width_ && height == height_) return true;
+  if (!dc_) {
+    dc_ = CreateCompatibleDC(screen);
+    if (!dc_) return false;
+  }
+  HBITMAP bitmap = CreateCompatibleBitmap(screen, width, height);
+  if (!bitmap) return false;
+  HGDIOBJ previous = SelectObject(dc_, bitmap);
+  if (bitmap_) {
+    DeleteObject(bitmap_);
+  } else {
+    original_bitmap_ = previous;
+  }
+  bitmap_ = bitmap;
+  width_ = width;
+  height_ = height;
+  return true;
+}
+
+void ScreenSurface::Release() {
+  if (dc_ && bitmap_) SelectObject(dc_, original_bitmap_);
+  if (bitmap_) DeleteObject(bitmap_);
+  if (dc_) DeleteDC(dc_);
+  dc_ = nullptr;
+  bitmap_ = nullptr;
+  original_bitmap_ = nullptr;
+  width_ = 0;
+  height_ = 0;
+  cursor_ = nullptr;
+  cursors_.Clear();
+}
+
+}  // namespace screenshot
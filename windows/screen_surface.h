@@ -0,0 +1,73 @@
+#ifndef FLUTTER_PLUGIN_SCREEN_SURFACE_H_
+#define FLUTTER_PLUGIN_SCREEN_SURFACE_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "cursor_compositor.h"
+
+namespace screenshot {
+
+// A memory DC with a screen-compatible bitmap selected into it, kept between
+// captures so that capturing the same area again does not create a new DC
+// and bitmap (which the driver allocates and clears) each time.
+//
+// Use from one thread at a time.
+class ScreenSurface {
+ public:
+  ScreenSurface() = default;
+  ~ScreenSurface();
+
+  ScreenSurface(const ScreenSurface&) = delete;
+  ScreenSurface& operator=(const ScreenSurface&) = delete;
+
+  // Copies the |width| x |height| area of the screen at (|x|, |y|) into the
+  // surface and, if |include_cursor|, notes the cursor and where it is. The
+  // surface is recreated only when the size changes. Returns false on
+  // failure, with the reason in GetLastError().
+  bool Capture(int x, int y, int width, int height, bool include_cursor);
+
+  // Reads the last capture as top-down BGRA rows (stride width() * 4) into
+  // |pixels|, which must hold width() * height() * 4 bytes, with the cursor
+  // Capture() noted composited on top.
+  bool Read(uint8_t* pixels);
+
+  // How long the last Capture() and Read() spent on the cursor, in
+  // nanoseconds; -1 if they were not asked to draw it.
+  int64_t cursor_nanos() const { return cursor_nanos_; }
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+ private:
+  // Makes the bitmap |width| x |height|, creating the DC on first use.
+  bool Resize(HDC screen, int width, int height);
+
+  void Release();
+
+  // The image of the cursor showing now, decoded on first sight and then
+  // taken from |cursors_|; nullptr if it is hidden or cannot be read.
+  const CursorImage* CurrentCursor(POINT* position);
+
+  HDC dc_ = nullptr;
+  HBITMAP bitmap_ = nullptr;
+  // The DC's original bitmap, selected back in before deleting ours.
+  HGDIOBJ original_bitmap_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  int64_t cursor_nanos_ = -1;
+  // Decoded cursors by HCURSOR. Compositing a cached image onto the pixels
+  // Read() returns replaces DrawIconEx into the DC, which fetched and threw
+  // away the cursor's bitmaps on every capture.
+  CursorCache cursors_;
+  // What Read() draws: the cursor at the last capture, and where its top
+  // left falls in the surface.
+  const CursorImage* cursor_ = nullptr;
+  int cursor_x_ = 0;
+  int cursor_y_ = 0;
+};
+
+}  // namespace screenshot
+
+#endif  // FLUTTER_PLUGIN_SCREEN_SURFACE_H_
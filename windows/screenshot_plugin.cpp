@@ -3,482 +3,586 @@
 // This must be included before many other Windows headers.
 #include <windows.h>
 #include <wingdi.h>
-#include <wincodec.h>
-#include <windowsx.h>  // For GET_X_LPARAM and GET_Y_LPARAM
 
+#include <flutter/binary_messenger.h>
+#include <flutter/event_channel.h>
+#include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
+#include <flutter/standard_message_codec.h>
 #include <flutter/standard_method_codec.h>
 
+#include <chrono>
+#include <cstring>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
-#pragma comment(lib, "windowscodecs.lib")
+#include "batch_encoder.h"
+#include "capture_pipeline.h"
+#include "capture_stats.h"
+#include "capture_stream.h"
+#include "display_capture.h"
+#include "encoder_session.h"
+#include "file_sink.h"
+#include "frame_message.h"
+#include "frame_pool.h"
+#include "frozen_frame.h"
+#include "gdi_capture_source.h"
+#include "image.h"
+#include "image_rect.h"
+#include "jpeg_encoder.h"
+#include "pixel_convert.h"
+#include "selection_overlay.h"
+#include "shared_frame_ring.h"
+#include "trace.h"
+#include "webp_encoder.h"
 
 namespace screenshot {
 
-// Helper function to encode HBITMAP to PNG bytes using WIC
-std::vector<uint8_t> EncodeBitmapToPNG(HBITMAP hBitmap, int width, int height) {
-  std::vector<uint8_t> pngBytes;
-  
-  // Initialize COM
-  HRESULT hr = CoInitialize(nullptr);
-  bool comInitialized = SUCCEEDED(hr);
-  
-  IWICImagingFactory* pFactory = nullptr;
-  IWICBitmap* pWICBitmap = nullptr;
-  IWICStream* pStream = nullptr;
-  IWICBitmapEncoder* pEncoder = nullptr;
-  IWICBitmapFrameEncode* pFrameEncode = nullptr;
-  
-  do {
-    // Create WIC factory
-    hr = CoCreateInstance(
-      CLSID_WICImagingFactory,
-      nullptr,
-      CLSCTX_INPROC_SERVER,
-      IID_IWICImagingFactory,
-      reinterpret_cast<LPVOID*>(&pFactory)
-    );
-    if (FAILED(hr)) break;
-    
-    // Create WIC bitmap from HBITMAP
-    hr = pFactory->CreateBitmapFromHBITMAP(hBitmap, nullptr, WICBitmapUseAlpha, &pWICBitmap);
-    if (FAILED(hr)) break;
-    
-    // Create WIC stream
-    hr = pFactory->CreateStream(&pStream);
-    if (FAILED(hr)) break;
-    
-    // Create memory stream using IStream
-    IStream* pMemStream = nullptr;
-    hr = CreateStreamOnHGlobal(nullptr, TRUE, &pMemStream);
-    if (FAILED(hr)) break;
-    
-    // Initialize WIC stream from IStream
-    hr = pStream->InitializeFromIStream(pMemStream);
-    pMemStream->Release();
-    if (FAILED(hr)) break;
-    
-    // Create PNG encoder
-    hr = pFactory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &pEncoder);
-    if (FAILED(hr)) break;
-    
-    hr = pEncoder->Initialize(pStream, WICBitmapEncoderNoCache);
-    if (FAILED(hr)) break;
-    
-    // Create frame
-    hr = pEncoder->CreateNewFrame(&pFrameEncode, nullptr);
-    if (FAILED(hr)) break;
-    
-    hr = pFrameEncode->Initialize(nullptr);
-    if (FAILED(hr)) break;
-    
-    hr = pFrameEncode->SetSize(width, height);
-    if (FAILED(hr)) break;
-    
-    WICPixelFormatGUID formatGUID = GUID_WICPixelFormat32bppBGRA;
-    hr = pFrameEncode->SetPixelFormat(&formatGUID);
-    if (FAILED(hr)) break;
-    
-    hr = pFrameEncode->WriteSource(pWICBitmap, nullptr);
-    if (FAILED(hr)) break;
-    
-    hr = pFrameEncode->Commit();
-    if (FAILED(hr)) break;
-    
-    hr = pEncoder->Commit();
-    if (FAILED(hr)) break;
-    
-    // Get data from stream
-    ULARGE_INTEGER streamSize;
-    IStream* pIStream = nullptr;
-    hr = pStream->QueryInterface(IID_IStream, reinterpret_cast<void**>(&pIStream));
-    if (SUCCEEDED(hr)) {
-      STATSTG stat;
-      if (SUCCEEDED(pIStream->Stat(&stat, STATFLAG_NONAME))) {
-        streamSize = stat.cbSize;
-        pngBytes.resize(static_cast<size_t>(streamSize.QuadPart));
-        
-        LARGE_INTEGER zero = {};
-        pIStream->Seek(zero, STREAM_SEEK_SET, nullptr);
-        
-        ULONG bytesRead = 0;
-        pIStream->Read(pngBytes.data(), static_cast<ULONG>(pngBytes.size()), &bytesRead);
-      }
-      pIStream->Release();
-    }
-    
-  } while (false);
-  
-  // Cleanup
-  if (pFrameEncode) pFrameEncode->Release();
-  if (pEncoder) pEncoder->Release();
-  if (pStream) pStream->Release();
-  if (pWICBitmap) pWICBitmap->Release();
-  if (pFactory) pFactory->Release();
-  
-  if (comInitialized) {
-    CoUninitialize();
-  }
-  
-  return pngBytes;
-}
+// Default "fps" of "startStream".
+constexpr double kDefaultStreamFps = 30.0;
 
-// Capture screen to HBITMAP
-HBITMAP CaptureScreenToBitmap(int* width, int* height, bool includeCursor) {
-  // Set DPI awareness
-  SetProcessDPIAware();
-  
-  // Get screen DC
-  HDC hdcScreen = GetDC(nullptr);
-  if (!hdcScreen) return nullptr;
-  
-  // Get screen dimensions
-  *width = GetSystemMetrics(SM_CXSCREEN);
-  *height = GetSystemMetrics(SM_CYSCREEN);
-  
-  // Create compatible DC
-  HDC hdcMemory = CreateCompatibleDC(hdcScreen);
-  if (!hdcMemory) {
-    ReleaseDC(nullptr, hdcScreen);
-    return nullptr;
+// Bounds of the "tileSize" argument of "captureTiles".
+constexpr int kMinTileSize = 8;
+constexpr int kMaxTileSize = 1024;
+
+// Most rectangles one "captureBatch" call may ask for.
+constexpr size_t kMaxBatchRects = 256;
+
+// Reads the optional "format", "quality" and "chromaSubsampling" arguments
+// into |settings|. On a bad value reports the error to |result| and returns
+// false.
+bool ParseEncodeSettings(
+    const flutter::EncodableMap& arguments, EncodeSettings* settings,
+    flutter::MethodResult<flutter::EncodableValue>* result) {
+  // Get format parameter (optional, default "png")
+  CaptureFormat& format = settings->format;
+  auto format_it = arguments.find(flutter::EncodableValue("format"));
+  if (format_it != arguments.end() && !format_it->second.IsNull()) {
+    const auto* format_str = std::get_if<std::string>(&format_it->second);
+    if (!format_str) {
+      result->Error("invalid_argument", "'format' must be a string");
+      return false;
+    }
+    if (!ParseCaptureFormat(*format_str, &format)) {
+      result->Error("invalid_argument", "Invalid format: " + *format_str);
+      return false;
+    }
   }
-  
-  // Create compatible bitmap
-  HBITMAP hBitmap = CreateCompatibleBitmap(hdcScreen, *width, *height);
-  if (!hBitmap) {
-    DeleteDC(hdcMemory);
-    ReleaseDC(nullptr, hdcScreen);
-    return nullptr;
+  if (format == CaptureFormat::kWebp && !WebpEncoder::IsAvailable()) {
+    result->Error("not_supported",
+                  "WebP encoding is not available in this build");
+    return false;
   }
-  
-  // Select bitmap into memory DC
-  HBITMAP hOldBitmap = static_cast<HBITMAP>(SelectObject(hdcMemory, hBitmap));
-  
-  // Copy screen to bitmap
-  if (!BitBlt(hdcMemory, 0, 0, *width, *height, hdcScreen, 0, 0, SRCCOPY)) {
-    SelectObject(hdcMemory, hOldBitmap);
-    DeleteObject(hBitmap);
-    DeleteDC(hdcMemory);
-    ReleaseDC(nullptr, hdcScreen);
-    return nullptr;
+
+  // Get quality parameter (optional, default 85; lossy formats only)
+  auto quality_it = arguments.find(flutter::EncodableValue("quality"));
+  if (quality_it != arguments.end() && !quality_it->second.IsNull()) {
+    const auto* quality = std::get_if<int32_t>(&quality_it->second);
+    if (!quality) {
+      result->Error("invalid_argument", "'quality' must be an int");
+      return false;
+    }
+    if (*quality < 1 || *quality > 100) {
+      result->Error("invalid_argument",
+                    "Invalid quality: " + std::to_string(*quality));
+      return false;
+    }
+    settings->quality = *quality;
   }
-  
-  // Draw cursor if requested
-  if (includeCursor) {
-    CURSORINFO cursorInfo = {};
-    cursorInfo.cbSize = sizeof(CURSORINFO);
-    
-    if (GetCursorInfo(&cursorInfo) && (cursorInfo.flags & CURSOR_SHOWING)) {
-      ICONINFO iconInfo;
-      if (GetIconInfo(cursorInfo.hCursor, &iconInfo)) {
-        POINT pt;
-        GetCursorPos(&pt);
-        int x = pt.x - iconInfo.xHotspot;
-        int y = pt.y - iconInfo.yHotspot;
-        
-        DrawIconEx(hdcMemory, x, y, cursorInfo.hCursor, 0, 0, 0, nullptr, DI_NORMAL);
-        
-        if (iconInfo.hbmMask) DeleteObject(iconInfo.hbmMask);
-        if (iconInfo.hbmColor) DeleteObject(iconInfo.hbmColor);
-      }
+
+  // Get chromaSubsampling parameter (optional, default "420")
+  auto chroma_it =
+      arguments.find(flutter::EncodableValue("chromaSubsampling"));
+  if (chroma_it != arguments.end() && !chroma_it->second.IsNull()) {
+    const auto* chroma_str = std::get_if<std::string>(&chroma_it->second);
+    if (!chroma_str) {
+      result->Error("invalid_argument",
+                    "'chromaSubsampling' must be a string");
+      return false;
+    }
+    if (!ParseChromaSubsampling(*chroma_str, &settings->subsampling)) {
+      result->Error("invalid_argument",
+                    "Invalid chromaSubsampling: " + *chroma_str);
+      return false;
     }
   }
-  
-  // Restore old bitmap and cleanup DCs
-  SelectObject(hdcMemory, hOldBitmap);
-  DeleteDC(hdcMemory);
-  ReleaseDC(nullptr, hdcScreen);
-  
-  return hBitmap;
+  return true;
 }
 
-// Structure to hold selection state
-struct SelectionState {
-  POINT startPoint;
-  POINT currentPoint;
-  bool isSelecting;
-  bool cancelled;
-  RECT selectedRect;
-};
-
-// Global state for overlay window (will be set during overlay creation)
-static SelectionState* g_selectionState = nullptr;
-
-// Window procedure for overlay window
-LRESULT CALLBACK OverlayWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-  if (!g_selectionState) return DefWindowProc(hwnd, msg, wParam, lParam);
-  
-  switch (msg) {
-    case WM_LBUTTONDOWN: {
-      // Capture start point
-      g_selectionState->startPoint.x = GET_X_LPARAM(lParam);
-      g_selectionState->startPoint.y = GET_Y_LPARAM(lParam);
-      g_selectionState->currentPoint = g_selectionState->startPoint;
-      g_selectionState->isSelecting = true;
-      SetCapture(hwnd);
-      InvalidateRect(hwnd, nullptr, TRUE);
-      return 0;
-    }
-    
-    case WM_MOUSEMOVE: {
-      if (g_selectionState->isSelecting) {
-        // Update current point and redraw
-        g_selectionState->currentPoint.x = GET_X_LPARAM(lParam);
-        g_selectionState->currentPoint.y = GET_Y_LPARAM(lParam);
-        InvalidateRect(hwnd, nullptr, TRUE);
-      }
-      return 0;
+// Reads the optional "maxWidth", "maxHeight" and "scale" arguments into
+// |limits|. On a bad value reports the error to |result| and returns false.
+bool ParseResizeLimits(
+    const flutter::EncodableMap& arguments, ResizeLimits* limits,
+    flutter::MethodResult<flutter::EncodableValue>* result) {
+  for (const auto& [name, value] :
+       {std::pair<const char*, int*>("maxWidth", &limits->max_width),
+        std::pair<const char*, int*>("maxHeight", &limits->max_height)}) {
+    auto it = arguments.find(flutter::EncodableValue(name));
+    if (it == arguments.end() || it->second.IsNull()) continue;
+    const auto* size = std::get_if<int32_t>(&it->second);
+    if (!size) {
+      result->Error("invalid_argument", std::string("'") + name +
+                                            "' must be an int");
+      return false;
     }
-    
-    case WM_LBUTTONUP: {
-      if (g_selectionState->isSelecting) {
-        // Capture end point
-        g_selectionState->currentPoint.x = GET_X_LPARAM(lParam);
-        g_selectionState->currentPoint.y = GET_Y_LPARAM(lParam);
-        g_selectionState->isSelecting = false;
-        ReleaseCapture();
-        
-        // Normalize rectangle (handle reverse selection)
-        int left = min(g_selectionState->startPoint.x, g_selectionState->currentPoint.x);
-        int top = min(g_selectionState->startPoint.y, g_selectionState->currentPoint.y);
-        int right = max(g_selectionState->startPoint.x, g_selectionState->currentPoint.x);
-        int bottom = max(g_selectionState->startPoint.y, g_selectionState->currentPoint.y);
-        
-        g_selectionState->selectedRect.left = left;
-        g_selectionState->selectedRect.top = top;
-        g_selectionState->selectedRect.right = right;
-        g_selectionState->selectedRect.bottom = bottom;
-        
-        // Close overlay
-        DestroyWindow(hwnd);
-      }
-      return 0;
+    if (*size < 1) {
+      result->Error("invalid_argument", std::string("Invalid ") + name +
+                                            ": " + std::to_string(*size));
+      return false;
     }
-    
-    case WM_KEYDOWN: {
-      if (wParam == VK_ESCAPE) {
-        // User cancelled
-        g_selectionState->cancelled = true;
-        DestroyWindow(hwnd);
-      }
-      return 0;
+    *value = *size;
+  }
+
+  auto scale_it = arguments.find(flutter::EncodableValue("scale"));
+  if (scale_it != arguments.end() && !scale_it->second.IsNull()) {
+    const auto* scale = std::get_if<double>(&scale_it->second);
+    if (!scale) {
+      result->Error("invalid_argument", "'scale' must be a double");
+      return false;
     }
-    
-    case WM_RBUTTONDOWN: {
-      // Right-click cancels
-      g_selectionState->cancelled = true;
-      DestroyWindow(hwnd);
-      return 0;
+    // Also rejects NaN.
+    if (!(*scale > 0.0 && *scale <= 1.0)) {
+      result->Error("invalid_argument",
+                    "Invalid scale: " + std::to_string(*scale));
+      return false;
     }
-    
-    case WM_ERASEBKGND:
-      // Prevent default erase to avoid flicker
-      return 1;
-    
-    case WM_PAINT: {
-      PAINTSTRUCT ps;
-      HDC hdc = BeginPaint(hwnd, &ps);
-      
-      // Get client area
-      RECT clientRect;
-      GetClientRect(hwnd, &clientRect);
-      int width = clientRect.right - clientRect.left;
-      int height = clientRect.bottom - clientRect.top;
-      
-      // Create double buffer
-      HDC hdcMem = CreateCompatibleDC(hdc);
-      HBITMAP hbmMem = CreateCompatibleBitmap(hdc, width, height);
-      HBITMAP hbmOld = static_cast<HBITMAP>(SelectObject(hdcMem, hbmMem));
-      
-      // Fill background with semi-transparent black
-      HBRUSH hBrush = CreateSolidBrush(RGB(0, 0, 0));
-      FillRect(hdcMem, &clientRect, hBrush);
-      DeleteObject(hBrush);
-      
-      // Draw selection rectangle if selecting
-      if (g_selectionState->isSelecting || 
-          (g_selectionState->selectedRect.right > g_selectionState->selectedRect.left)) {
-        int left = min(g_selectionState->startPoint.x, g_selectionState->currentPoint.x);
-        int top = min(g_selectionState->startPoint.y, g_selectionState->currentPoint.y);
-        int right = max(g_selectionState->startPoint.x, g_selectionState->currentPoint.x);
-        int bottom = max(g_selectionState->startPoint.y, g_selectionState->currentPoint.y);
-        
-        RECT selRect = {left, top, right, bottom};
-        
-        // Clear selection area (make it visible)
-        HBRUSH hClearBrush = CreateSolidBrush(RGB(255, 255, 255));
-        FillRect(hdcMem, &selRect, hClearBrush);
-        DeleteObject(hClearBrush);
-        
-        // Draw border around selection
-        HPEN hPen = CreatePen(PS_SOLID, 2, RGB(0, 120, 215)); // Blue border
-        HPEN hOldPen = static_cast<HPEN>(SelectObject(hdcMem, hPen));
-        SelectObject(hdcMem, GetStockObject(NULL_BRUSH));
-        Rectangle(hdcMem, left, top, right, bottom);
-        SelectObject(hdcMem, hOldPen);
-        DeleteObject(hPen);
-      }
-      
-      // Copy buffer to screen
-      BitBlt(hdc, 0, 0, width, height, hdcMem, 0, 0, SRCCOPY);
-      
-      // Cleanup
-      SelectObject(hdcMem, hbmOld);
-      DeleteObject(hbmMem);
-      DeleteDC(hdcMem);
-      
-      EndPaint(hwnd, &ps);
-      return 0;
+    limits->scale = *scale;
+  }
+  return true;
+}
+
+// Reads the int "x", "y", "width" and "height" entries of |map|, the
+// argument |name|, into |rect|. On a bad value reports the error to |result|
+// and returns false.
+bool ParsePixelRect(const flutter::EncodableMap& map, const std::string& name,
+                    PixelRect* rect,
+                    flutter::MethodResult<flutter::EncodableValue>* result) {
+  int values[4] = {};
+  const char* keys[4] = {"x", "y", "width", "height"};
+  for (int k = 0; k < 4; ++k) {
+    auto it = map.find(flutter::EncodableValue(keys[k]));
+    const auto* value = it != map.end() ? std::get_if<int32_t>(&it->second)
+                                        : nullptr;
+    if (!value) {
+      result->Error("invalid_argument",
+                    "'" + name + "." + keys[k] + "' must be an int");
+      return false;
     }
-    
-    case WM_DESTROY:
-      PostQuitMessage(0);
-      return 0;
+    values[k] = *value;
   }
-  
-  return DefWindowProc(hwnd, msg, wParam, lParam);
+  *rect = PixelRect{values[0], values[1], values[2], values[3]};
+  return true;
 }
 
-// Capture region with interactive overlay
-HBITMAP CaptureRegionToBitmap(int* width, int* height, int* x, int* y, bool* cancelled) {
-  *cancelled = false;
-  
-  // Set DPI awareness
-  SetProcessDPIAware();
-  
-  // Get screen dimensions
-  int screenWidth = GetSystemMetrics(SM_CXSCREEN);
-  int screenHeight = GetSystemMetrics(SM_CYSCREEN);
-  
-  // Initialize selection state
-  SelectionState state = {};
-  state.isSelecting = false;
-  state.cancelled = false;
-  g_selectionState = &state;
-  
-  // Register window class
-  const wchar_t* className = L"ScreenshotOverlayClass";
-  WNDCLASSEX wc = {};
-  wc.cbSize = sizeof(WNDCLASSEX);
-  wc.style = CS_HREDRAW | CS_VREDRAW;
-  wc.lpfnWndProc = OverlayWndProc;
-  wc.hInstance = GetModuleHandle(nullptr);
-  wc.hCursor = LoadCursor(nullptr, IDC_CROSS);
-  wc.hbrBackground = static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH));
-  wc.lpszClassName = className;
-  
-  if (!RegisterClassEx(&wc)) {
-    // Class might already be registered
-    if (GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
-      g_selectionState = nullptr;
-      return nullptr;
+// Encodes |image| (opaque BGRA, possibly a window into a larger frame) into
+// the bytes for |settings.format| with |session|, whose encoders and output
+// buffer are reused from call to call. |stride| receives the row size of the
+// (decompressed) pixels, or 0 for image formats.
+bool EncodeImage(EncoderSession* session, const ImageView& image,
+                 const EncodeSettings& settings, std::vector<uint8_t>* bytes,
+                 size_t* stride) {
+  *stride = 0;
+  if (!session->Encode(image, settings)) {
+    bytes->clear();
+    return false;
+  }
+  // The result map owns its bytes and they leave with the reply, so one
+  // copy per capture is the floor, and this copy (sized exactly) is the
+  // only allocation once the session is warm. Handing over the session's
+  // buffer instead would not save it: the buffer is sized for the worst
+  // case, and the next Encode() would have to allocate (and zero) another.
+  TraceSpan span("marshal");
+  bytes->assign(session->data(), session->data() + session->size());
+  *stride = session->stride();
+  return true;
+}
+
+// Turns a captured frame into the bytes for |settings.format|. Raw formats
+// are converted straight into |bytes|; the others are encoded with
+// |session|. |stride| receives the row size of the (decompressed) pixels,
+// or 0 for image formats.
+bool EncodeCapture(const ImageView& image, const EncodeSettings& settings,
+                   EncoderSession* session, std::vector<uint8_t>* bytes,
+                   size_t* stride) {
+  if (settings.format == CaptureFormat::kRawBgra ||
+      settings.format == CaptureFormat::kRawRgba) {
+    const PixelFormat format = settings.format == CaptureFormat::kRawRgba
+                                   ? PixelFormat::kRgba8
+                                   : PixelFormat::kBgra8;
+    *stride = image.RowBytes();
+    bytes->resize(*stride * static_cast<size_t>(image.height));
+    return ConvertImage(image, format, true, bytes->data(), *stride);
+  }
+  return EncodeImage(session, image, settings, bytes, stride);
+}
+
+// Builds the success map returned by "capture".
+flutter::EncodableMap MakeCaptureResult(int width, int height,
+                                        CaptureFormat format, size_t stride,
+                                        std::vector<uint8_t> bytes) {
+  flutter::EncodableMap resultMap;
+  resultMap[flutter::EncodableValue("width")] = flutter::EncodableValue(width);
+  resultMap[flutter::EncodableValue("height")] = flutter::EncodableValue(height);
+  resultMap[flutter::EncodableValue("stride")] =
+      flutter::EncodableValue(static_cast<int>(stride));
+  resultMap[flutter::EncodableValue("pixelFormat")] =
+      flutter::EncodableValue(std::string(CaptureFormatName(format)));
+  resultMap[flutter::EncodableValue("bytes")] =
+      flutter::EncodableValue(std::move(bytes));
+  return resultMap;
+}
+
+// The plugin's default CaptureSourceFactory: the screen, through GDI.
+std::unique_ptr<CaptureSource> MakeGdiCaptureSource() {
+  return std::make_unique<GdiCaptureSource>();
+}
+
+// Steady-clock time in microseconds, as frames are timestamped.
+int64_t SteadyClockMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Captures |rect| of the screen (without the cursor) to select a region
+// from. Returns an empty frame on failure.
+FrozenFrame FreezeScreen(CaptureSource* source, FramePool* pool,
+                         const PixelRect& rect) {
+  const int64_t timestamp_us = SteadyClockMicros();
+  FramePool::Lease frame = CaptureToPool(source, pool, rect, false);
+  if (!frame) return FrozenFrame();
+  return FrozenFrame(std::move(frame), rect.x, rect.y, timestamp_us);
+}
+
+// Nanoseconds as the fractional microseconds "getStats" reports.
+flutter::EncodableValue Micros(int64_t nanos) {
+  return flutter::EncodableValue(static_cast<double>(nanos) / 1000.0);
+}
+
+// The outcome of a capture job, built on the pipeline's threads and sent on
+// the platform thread: a value, or an error when code is set. It also
+// carries the capture's CaptureSample, each stage timed on the thread it
+// runs on.
+class CaptureReply {
+ public:
+  void Succeed(flutter::EncodableValue value) { value_ = std::move(value); }
+
+  // Fails the capture in |stage|, for its error count.
+  void Fail(CaptureStage stage, const std::string& code,
+            const std::string& message,
+            flutter::EncodableValue details = flutter::EncodableValue()) {
+    failed_stage_ = stage;
+    code_ = code;
+    message_ = message;
+    details_ = std::move(details);
+  }
+
+  // Fails the capture in the encode stage.
+  void Fail(const std::string& code, const std::string& message,
+            flutter::EncodableValue details = flutter::EncodableValue()) {
+    Fail(CaptureStage::kEncode, code, message, std::move(details));
+  }
+
+  CaptureSample* sample() { return &sample_; }
+
+  // Times the encode stage, which started at |start_nanos|, leaving out
+  // the scaling the encode function timed within it.
+  void EndEncode(int64_t start_nanos) {
+    if (!code_.empty()) return;
+    const int64_t scale = sample_.Get(CaptureStage::kScale);
+    sample_.Set(CaptureStage::kEncode, MonotonicNanos() - start_nanos -
+                                           (scale > 0 ? scale : 0));
+  }
+
+  // Ends the capture, which started at |start_nanos|, and records it in
+  // |stats|: its stages if it succeeded, or an error in the stage it
+  // failed in.
+  void Finish(CaptureStats* stats, int64_t start_nanos) {
+    if (!code_.empty()) {
+      stats->RecordError(failed_stage_);
+      return;
     }
+    sample_.Set(CaptureStage::kTotal, MonotonicNanos() - start_nanos);
+    stats->Record(sample_);
   }
-  
-  // Create fullscreen layered window
-  HWND hwndOverlay = CreateWindowEx(
-    WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_TOOLWINDOW,
-    className,
-    L"Screenshot Overlay",
-    WS_POPUP,
-    0, 0, screenWidth, screenHeight,
-    nullptr, nullptr, GetModuleHandle(nullptr), nullptr
-  );
-  
-  if (!hwndOverlay) {
-    UnregisterClass(className, GetModuleHandle(nullptr));
-    g_selectionState = nullptr;
-    return nullptr;
+
+  void Send(flutter::MethodResult<flutter::EncodableValue>* result) {
+    if (!code_.empty()) {
+      result->Error(code_, message_, details_);
+    } else {
+      result->Success(value_);
+    }
   }
-  
-  // Set semi-transparent background (50% opacity)
-  SetLayeredWindowAttributes(hwndOverlay, 0, 128, LWA_ALPHA);
-  
-  // Show overlay
-  ShowWindow(hwndOverlay, SW_SHOW);
-  UpdateWindow(hwndOverlay);
-  SetForegroundWindow(hwndOverlay);
-  
-  // Message loop
-  MSG msg;
-  while (GetMessage(&msg, nullptr, 0, 0)) {
-    TranslateMessage(&msg);
-    DispatchMessage(&msg);
+
+ private:
+  flutter::EncodableValue value_;
+  std::string code_;
+  std::string message_;
+  flutter::EncodableValue details_;
+  CaptureStage failed_stage_ = CaptureStage::kEncode;
+  CaptureSample sample_;
+};
+
+// A "capture" or "captureTiles" request on the capture pipeline: copies
+// |rect| of |source| into a pooled buffer, hands it to |encode|, and
+// replies on the platform thread.
+class ScreenCaptureJob : public PipelineJob {
+ public:
+  // Runs on the encode thread with the captured frame and the steady-clock
+  // time its capture started, in microseconds.
+  using EncodeFn = std::function<void(const ImageView& frame,
+                                      int64_t timestamp_us,
+                                      CaptureReply* reply)>;
+
+  ScreenCaptureJob(
+      CaptureSource* source, FramePool* pool, const PixelRect& rect,
+      bool includeCursor, std::string failure_message, EncodeFn encode,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+      CaptureStats* stats)
+      : source_(source),
+        pool_(pool),
+        rect_(rect),
+        includeCursor_(includeCursor),
+        failure_message_(std::move(failure_message)),
+        encode_(std::move(encode)),
+        result_(std::move(result)),
+        stats_(stats) {}
+
+  bool Capture() override {
+    timestamp_us_ = SteadyClockMicros();
+    start_nanos_ = MonotonicNanos();
+    frame_ = CaptureToPool(source_, pool_, rect_, includeCursor_);
+    if (!frame_) {
+      reply_.Fail(CaptureStage::kCapture, "internal_error", failure_message_,
+                  flutter::EncodableValue(static_cast<int>(GetLastError())));
+      return false;
+    }
+    // The source may time drawing the cursor apart from reading the screen.
+    const int64_t cursor = source_->cursor_nanos();
+    CaptureSample* sample = reply_.sample();
+    sample->Set(CaptureStage::kCapture, MonotonicNanos() - start_nanos_ -
+                                            (cursor > 0 ? cursor : 0));
+    sample->Set(CaptureStage::kCursor, cursor);
+    sample->captured_bytes = frame_->size();
+    return true;
   }
-  
-  // Cleanup window
-  UnregisterClass(className, GetModuleHandle(nullptr));
-  
-  // Check if cancelled
-  if (state.cancelled) {
-    *cancelled = true;
-    g_selectionState = nullptr;
-    return nullptr;
+
+  void Encode() override {
+    const int64_t encode_start = MonotonicNanos();
+    encode_(frame_->View(), timestamp_us_, &reply_);
+    reply_.EndEncode(encode_start);
+    // Back to the pool before the next capture needs it.
+    frame_.Reset();
   }
-  
-  // Validate selection
-  int selWidth = state.selectedRect.right - state.selectedRect.left;
-  int selHeight = state.selectedRect.bottom - state.selectedRect.top;
-  
-  if (selWidth <= 0 || selHeight <= 0) {
-    // Invalid selection
-    *cancelled = true;
-    g_selectionState = nullptr;
-    return nullptr;
+
+  void Complete() override {
+    reply_.Finish(stats_, start_nanos_);
+    reply_.Send(result_.get());
   }
-  
-  // Capture the selected region
-  HDC hdcScreen = GetDC(nullptr);
-  if (!hdcScreen) {
-    g_selectionState = nullptr;
-    return nullptr;
+
+ private:
+  CaptureSource* source_;
+  FramePool* pool_;
+  PixelRect rect_;
+  bool includeCursor_;
+  std::string failure_message_;
+  EncodeFn encode_;
+  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result_;
+  CaptureStats* stats_;
+  FramePool::Lease frame_;
+  int64_t timestamp_us_ = 0;
+  int64_t start_nanos_ = 0;
+  CaptureReply reply_;
+};
+
+// A "capture" of a selected region: the screen was captured before the
+// selection overlay appeared, so there is nothing left to capture, and the
+// selection is encoded from a view into that frame. |capture_nanos| is how
+// long that capture took.
+class FrozenFrameJob : public PipelineJob {
+ public:
+  FrozenFrameJob(
+      FrozenFrame frame, int64_t capture_nanos, const PixelRect& selection,
+      ScreenCaptureJob::EncodeFn encode,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+      CaptureStats* stats)
+      : frame_(std::move(frame)),
+        selection_(selection),
+        encode_(std::move(encode)),
+        result_(std::move(result)),
+        stats_(stats),
+        // The total leaves out the time the user spent selecting.
+        start_nanos_(MonotonicNanos() - capture_nanos) {
+    CaptureSample* sample = reply_.sample();
+    sample->Set(CaptureStage::kCapture, capture_nanos);
+    const ImageView view = frame_.View();
+    sample->captured_bytes =
+        view.stride * static_cast<size_t>(view.height);
   }
-  
-  HDC hdcMemory = CreateCompatibleDC(hdcScreen);
-  if (!hdcMemory) {
-    ReleaseDC(nullptr, hdcScreen);
-    g_selectionState = nullptr;
-    return nullptr;
+
+  bool Capture() override { return true; }
+
+  void Encode() override {
+    const int64_t encode_start = MonotonicNanos();
+    ImageView crop;
+    if (!frame_.Crop(selection_, &crop)) {
+      reply_.Fail("internal_error", "Selection is outside the screen");
+    } else {
+      encode_(crop, frame_.timestamp_us(), &reply_);
+    }
+    reply_.EndEncode(encode_start);
+    frame_.Reset();
   }
-  
-  HBITMAP hBitmap = CreateCompatibleBitmap(hdcScreen, selWidth, selHeight);
-  if (!hBitmap) {
-    DeleteDC(hdcMemory);
-    ReleaseDC(nullptr, hdcScreen);
-    g_selectionState = nullptr;
-    return nullptr;
+
+  void Complete() override {
+    reply_.Finish(stats_, start_nanos_);
+    reply_.Send(result_.get());
   }
-  
-  HBITMAP hOldBitmap = static_cast<HBITMAP>(SelectObject(hdcMemory, hBitmap));
-  
-  // Copy selected region to bitmap
-  if (!BitBlt(hdcMemory, 0, 0, selWidth, selHeight, hdcScreen, 
-              state.selectedRect.left, state.selectedRect.top, SRCCOPY)) {
-    SelectObject(hdcMemory, hOldBitmap);
-    DeleteObject(hBitmap);
-    DeleteDC(hdcMemory);
-    ReleaseDC(nullptr, hdcScreen);
-    g_selectionState = nullptr;
-    return nullptr;
+
+ private:
+  FrozenFrame frame_;
+  PixelRect selection_;
+  ScreenCaptureJob::EncodeFn encode_;
+  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result_;
+  CaptureStats* stats_;
+  int64_t start_nanos_;
+  CaptureReply reply_;
+};
+
+// An "all" mode "capture" or a "captureAllDisplays" request: copies every
+// display at once through |capture|, as one stitched frame or a frame per
+// display, hands the frames to |encode| and replies on the platform thread.
+class DisplaysCaptureJob : public PipelineJob {
+ public:
+  // Runs on the encode thread with the captured frames (one if stitched)
+  // and the steady-clock time their capture started, in microseconds.
+  using EncodeFn = std::function<void(const std::vector<ImageView>& frames,
+                                      int64_t timestamp_us,
+                                      CaptureReply* reply)>;
+
+  DisplaysCaptureJob(
+      MultiDisplayCapture* capture, std::vector<DisplayInfo> displays,
+      bool includeCursor, bool stitch, EncodeFn encode,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+      CaptureStats* stats)
+      : capture_(capture),
+        displays_(std::move(displays)),
+        includeCursor_(includeCursor),
+        stitch_(stitch),
+        encode_(std::move(encode)),
+        result_(std::move(result)),
+        stats_(stats) {}
+
+  bool Capture() override {
+    timestamp_us_ = SteadyClockMicros();
+    start_nanos_ = MonotonicNanos();
+    bool captured = false;
+    if (stitch_) {
+      FramePool::Lease desktop =
+          capture_->CaptureDesktop(displays_, includeCursor_);
+      captured = static_cast<bool>(desktop);
+      if (captured) frames_.push_back(std::move(desktop));
+    } else {
+      captured = capture_->Capture(displays_, includeCursor_, &frames_);
+    }
+    if (!captured) {
+      // The displays were copied on several threads, so there is no single
+      // GetLastError() to report.
+      reply_.Fail(CaptureStage::kCapture, "internal_error",
+                  "Failed to capture displays");
+      return false;
+    }
+    // The cursor is drawn as part of each display's capture.
+    CaptureSample* sample = reply_.sample();
+    sample->Set(CaptureStage::kCapture, MonotonicNanos() - start_nanos_);
+    for (const FramePool::Lease& frame : frames_) {
+      sample->captured_bytes += frame->size();
+    }
+    return true;
   }
-  
-  // Restore and cleanup
-  SelectObject(hdcMemory, hOldBitmap);
-  DeleteDC(hdcMemory);
-  ReleaseDC(nullptr, hdcScreen);
-  
-  // Set output parameters
-  *width = selWidth;
-  *height = selHeight;
-  *x = state.selectedRect.left;
-  *y = state.selectedRect.top;
-  
-  g_selectionState = nullptr;
-  return hBitmap;
-}
+
+  void Encode() override {
+    const int64_t encode_start = MonotonicNanos();
+    std::vector<ImageView> views;
+    views.reserve(frames_.size());
+    for (const FramePool::Lease& frame : frames_) {
+      views.push_back(frame->View());
+    }
+    encode_(views, timestamp_us_, &reply_);
+    reply_.EndEncode(encode_start);
+    frames_.clear();
+  }
+
+  void Complete() override {
+    reply_.Finish(stats_, start_nanos_);
+    reply_.Send(result_.get());
+  }
+
+ private:
+  MultiDisplayCapture* capture_;
+  std::vector<DisplayInfo> displays_;
+  bool includeCursor_;
+  bool stitch_;
+  EncodeFn encode_;
+  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result_;
+  CaptureStats* stats_;
+  std::vector<FramePool::Lease> frames_;
+  int64_t timestamp_us_ = 0;
+  int64_t start_nanos_ = 0;
+  CaptureReply reply_;
+};
+
+// Answers a "dev.flutter.screenshot/frame" request. A successful value is
+// the frame message from EncodeFrameMessage and goes out as is, without a
+// codec; null and errors are sent as header-only and error messages.
+class FrameMessageResult
+    : public flutter::MethodResult<flutter::EncodableValue> {
+ public:
+  explicit FrameMessageResult(flutter::BinaryReply reply)
+      : reply_(std::move(reply)) {}
+
+ protected:
+  void SuccessInternal(const flutter::EncodableValue* result) override {
+    const auto* message =
+        result ? std::get_if<std::vector<uint8_t>>(result) : nullptr;
+    if (message) {
+      reply_(message->data(), message->size());
+      return;
+    }
+    FrameMessageHeader header;
+    header.kind = FrameMessageKind::kNull;
+    std::vector<uint8_t> empty;
+    StartFrameMessage(header, 0, &empty);
+    reply_(empty.data(), empty.size());
+  }
+
+  void ErrorInternal(const std::string& code, const std::string& message,
+                     const flutter::EncodableValue* details) override {
+    std::unique_ptr<std::vector<uint8_t>> envelope =
+        flutter::StandardMethodCodec::GetInstance().EncodeErrorEnvelope(
+            code, message, details);
+    FrameMessageHeader header;
+    header.kind = FrameMessageKind::kError;
+    std::vector<uint8_t> error;
+    uint8_t* payload =
+        StartFrameMessage(header, envelope ? envelope->size() : 0, &error);
+    if (envelope && !envelope->empty()) {
+      std::memcpy(payload, envelope->data(), envelope->size());
+    }
+    reply_(error.data(), error.size());
+  }
+
+  void NotImplementedInternal() override { reply_(nullptr, 0); }
+
+ private:
+  flutter::BinaryReply reply_;
+};
 
 // static
 void ScreenshotPlugin::RegisterWithRegistrar(
@@ -488,19 +592,85 @@ void ScreenshotPlugin::RegisterWithRegistrar(
           registrar->messenger(), "dev.flutter.screenshot",
           &flutter::StandardMethodCodec::GetInstance());
 
-  auto plugin = std::make_unique<ScreenshotPlugin>();
+  auto plugin = std::make_unique<ScreenshotPlugin>(registrar);
 
   channel->SetMethodCallHandler(
       [plugin_pointer = plugin.get()](const auto &call, auto result) {
         plugin_pointer->HandleMethodCall(call, std::move(result));
       });
 
+  // "capture" requests whose frame comes back as a binary frame message.
+  registrar->messenger()->SetMessageHandler(
+      "dev.flutter.screenshot/frame",
+      [plugin_pointer = plugin.get()](const uint8_t* message, size_t size,
+                                      flutter::BinaryReply reply) {
+        plugin_pointer->HandleFrameMessage(message, size, std::move(reply));
+      });
+
+  // Frames of "startStream" are sent on this channel.
+  auto event_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "dev.flutter.screenshot/stream",
+          &flutter::StandardMethodCodec::GetInstance());
+  event_channel->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [plugin_pointer = plugin.get()](
+              const flutter::EncodableValue* arguments,
+              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->event_sink_ = std::move(events);
+            return nullptr;
+          },
+          [plugin_pointer = plugin.get()](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            // Nobody is listening any more.
+            plugin_pointer->stream_.Stop();
+            plugin_pointer->event_sink_.reset();
+            return nullptr;
+          }));
+
   registrar->AddPlugin(std::move(plugin));
 }
 
-ScreenshotPlugin::ScreenshotPlugin() {}
+ScreenshotPlugin::ScreenshotPlugin()
+    : ScreenshotPlugin(CaptureSourceFactory(MakeGdiCaptureSource)) {}
+
+ScreenshotPlugin::ScreenshotPlugin(CaptureSourceFactory capture_sources)
+    : capture_sources_(std::move(capture_sources)),
+      screen_source_(capture_sources_()),
+      region_source_(capture_sources_()) {}
 
-ScreenshotPlugin::~ScreenshotPlugin() {}
+ScreenshotPlugin::ScreenshotPlugin(flutter::PluginRegistrarWindows* registrar)
+    : capture_sources_(MakeGdiCaptureSource),
+      screen_source_(capture_sources_()),
+      region_source_(capture_sources_()),
+      task_queue_(std::make_unique<PlatformTaskQueue>(registrar)) {
+  if (task_queue_->IsAvailable()) {
+    PlatformTaskQueue* queue = task_queue_.get();
+    pipeline_ = std::make_unique<CapturePipeline>(
+        [queue](std::function<void()> task) {
+          return queue->Post(std::move(task));
+        });
+  }
+}
+
+ScreenshotPlugin::~ScreenshotPlugin() {
+  // Join the stream and pipeline threads before the members they use go
+  // away.
+  stream_.Stop();
+  pipeline_.reset();
+}
+
+void ScreenshotPlugin::RunCaptureJob(std::unique_ptr<PipelineJob> job) {
+  if (pipeline_) {
+    pipeline_->Submit(std::move(job));
+    return;
+  }
+  // Without a platform task queue there is no way back to the platform
+  // thread, so capture and encode here.
+  if (job->Capture()) job->Encode();
+  job->Complete();
+}
 
 void ScreenshotPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
@@ -512,105 +682,1057 @@ void ScreenshotPlugin::HandleMethodCall(
       result->Error("invalid_argument", "Arguments must be a map");
       return;
     }
-    
-    // Get mode parameter
-    auto mode_it = arguments->find(flutter::EncodableValue("mode"));
-    if (mode_it == arguments->end()) {
-      result->Error("invalid_argument", "Missing 'mode' parameter");
+    HandleCapture(*arguments, CaptureOutput::kMap, std::move(result));
+  } else if (method_call.method_name().compare("startStream") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("invalid_argument", "Arguments must be a map");
       return;
     }
-    
-    const auto* mode_str = std::get_if<std::string>(&mode_it->second);
-    if (!mode_str) {
-      result->Error("invalid_argument", "'mode' must be a string");
+    HandleStartStream(*arguments, std::move(result));
+  } else if (method_call.method_name().compare("stopStream") == 0) {
+    stream_.Stop();
+    result->Success();
+  } else if (method_call.method_name().compare("captureTiles") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("invalid_argument", "Arguments must be a map");
       return;
     }
-    
-    // Validate mode
-    if (*mode_str != "screen" && *mode_str != "region") {
-      result->Error("invalid_argument", "Invalid mode: " + *mode_str);
+    HandleCaptureTiles(*arguments, std::move(result));
+  } else if (method_call.method_name().compare("captureBatch") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("invalid_argument", "Arguments must be a map");
       return;
     }
-    
-    // Get includeCursor parameter (optional, default false)
-    bool includeCursor = false;
-    auto cursor_it = arguments->find(flutter::EncodableValue("includeCursor"));
-    if (cursor_it != arguments->end()) {
-      const auto* cursor_bool = std::get_if<bool>(&cursor_it->second);
-      if (cursor_bool) {
-        includeCursor = *cursor_bool;
+    HandleCaptureBatch(*arguments, std::move(result));
+  } else if (method_call.method_name().compare("captureHash") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("invalid_argument", "Arguments must be a map");
+      return;
+    }
+    HandleCaptureHash(*arguments, std::move(result));
+  } else if (method_call.method_name().compare("captureShared") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("invalid_argument", "Arguments must be a map");
+      return;
+    }
+    HandleCapture(*arguments, CaptureOutput::kSharedMemory, std::move(result));
+  } else if (method_call.method_name().compare("captureToFile") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("invalid_argument", "Arguments must be a map");
+      return;
+    }
+    HandleCapture(*arguments, CaptureOutput::kFile, std::move(result));
+  } else if (method_call.method_name().compare("listDisplays") == 0) {
+    HandleListDisplays(std::move(result));
+  } else if (method_call.method_name().compare("captureAllDisplays") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("invalid_argument", "Arguments must be a map");
+      return;
+    }
+    HandleCaptureAllDisplays(*arguments, std::move(result));
+  } else if (method_call.method_name().compare("releaseShared") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("invalid_argument", "Arguments must be a map");
+      return;
+    }
+    auto generation_it = arguments->find(flutter::EncodableValue("generation"));
+    if (generation_it == arguments->end()) {
+      result->Error("invalid_argument", "Missing 'generation' parameter");
+      return;
+    }
+    // Small values arrive as int32, others as int64.
+    int64_t generation = 0;
+    if (const auto* value32 = std::get_if<int32_t>(&generation_it->second)) {
+      generation = *value32;
+    } else if (const auto* value64 = std::get_if<int64_t>(&generation_it->second)) {
+      generation = *value64;
+    } else {
+      result->Error("invalid_argument", "'generation' must be an int");
+      return;
+    }
+    // Releasing twice (or after the plugin restarted) is harmless.
+    result->Success(flutter::EncodableValue(
+        shared_ring_.Release(static_cast<uint64_t>(generation))));
+  } else if (method_call.method_name().compare("getStats") == 0) {
+    HandleGetStats(std::move(result));
+  } else if (method_call.method_name().compare("resetStats") == 0) {
+    stats_.Reset();
+    result->Success();
+  } else if (method_call.method_name().compare("startTracing") == 0) {
+    SetTraceThreadName("platform");
+    StartTracing();
+    result->Success();
+  } else if (method_call.method_name().compare("stopTracing") == 0) {
+    StopTracing();
+    result->Success(flutter::EncodableValue(ExportChromeTrace()));
+  } else {
+    result->NotImplemented();
+  }
+}
+
+void ScreenshotPlugin::HandleFrameMessage(const uint8_t* message, size_t size,
+                                          flutter::BinaryReply reply) {
+  auto result = std::make_unique<FrameMessageResult>(std::move(reply));
+  std::unique_ptr<flutter::EncodableValue> request =
+      flutter::StandardMessageCodec::GetInstance().DecodeMessage(message, size);
+  const auto* arguments =
+      request ? std::get_if<flutter::EncodableMap>(request.get()) : nullptr;
+  if (!arguments) {
+    result->Error("invalid_argument", "Arguments must be a map");
+    return;
+  }
+  HandleCapture(*arguments, CaptureOutput::kFrameMessage, std::move(result));
+}
+
+void ScreenshotPlugin::HandleCapture(
+    const flutter::EncodableMap& arguments, CaptureOutput output,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  // Get mode parameter
+  auto mode_it = arguments.find(flutter::EncodableValue("mode"));
+  if (mode_it == arguments.end()) {
+    result->Error("invalid_argument", "Missing 'mode' parameter");
+    return;
+  }
+  
+  const auto* mode_str = std::get_if<std::string>(&mode_it->second);
+  if (!mode_str) {
+    result->Error("invalid_argument", "'mode' must be a string");
+    return;
+  }
+  
+  // Validate mode
+  if (*mode_str != "screen" && *mode_str != "region" && *mode_str != "all") {
+    result->Error("invalid_argument", "Invalid mode: " + *mode_str);
+    return;
+  }
+  
+  // Get includeCursor parameter (optional, default false)
+  bool includeCursor = false;
+  auto cursor_it = arguments.find(flutter::EncodableValue("includeCursor"));
+  if (cursor_it != arguments.end()) {
+    const auto* cursor_bool = std::get_if<bool>(&cursor_it->second);
+    if (cursor_bool) {
+      includeCursor = *cursor_bool;
+    }
+  }
+  
+  // Get displayId parameter (optional, default the primary display)
+  std::optional<int> displayId;
+  auto display_it = arguments.find(flutter::EncodableValue("displayId"));
+  if (display_it != arguments.end() && !display_it->second.IsNull()) {
+    const auto* display_int = std::get_if<int32_t>(&display_it->second);
+    if (!display_int) {
+      result->Error("invalid_argument", "'displayId' must be an int");
+      return;
+    }
+    displayId = *display_int;
+  }
+  
+  // Get format, quality and chromaSubsampling parameters (optional)
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, result.get())) return;
+
+  // Get maxWidth, maxHeight and scale parameters (optional)
+  ResizeLimits limits;
+  if (!ParseResizeLimits(arguments, &limits, result.get())) return;
+
+  // Get path, fsync and atomic parameters ("captureToFile" only)
+  std::string path;
+  FileSinkOptions file_options;
+  if (output == CaptureOutput::kFile) {
+    auto path_it = arguments.find(flutter::EncodableValue("path"));
+    const auto* path_str = path_it != arguments.end()
+                               ? std::get_if<std::string>(&path_it->second)
+                               : nullptr;
+    if (!path_str || path_str->empty()) {
+      result->Error("invalid_argument", "'path' must be a non-empty string");
+      return;
+    }
+    path = *path_str;
+    auto fsync_it = arguments.find(flutter::EncodableValue("fsync"));
+    if (fsync_it != arguments.end()) {
+      if (const auto* fsync_bool = std::get_if<bool>(&fsync_it->second)) {
+        file_options.sync = *fsync_bool;
       }
     }
-    
-    // Only implement screen mode for now (US1)
-    if (*mode_str == "screen") {
-      int width = 0;
-      int height = 0;
-      
-      // Capture screen to bitmap
-      HBITMAP hBitmap = CaptureScreenToBitmap(&width, &height, includeCursor);
-      if (!hBitmap) {
-        result->Error("internal_error", "Failed to capture screen", 
-                     flutter::EncodableValue(static_cast<int>(GetLastError())));
-        return;
+    auto atomic_it = arguments.find(flutter::EncodableValue("atomic"));
+    if (atomic_it != arguments.end()) {
+      if (const auto* atomic_bool = std::get_if<bool>(&atomic_it->second)) {
+        file_options.atomic = *atomic_bool;
       }
-      
-      // Encode to PNG
-      std::vector<uint8_t> pngBytes = EncodeBitmapToPNG(hBitmap, width, height);
-      DeleteObject(hBitmap);
-      
-      if (pngBytes.empty()) {
-        result->Error("internal_error", "Failed to encode PNG");
+    }
+  }
+  
+  // Scales the captured frame down to |limits| and encodes it to the
+  // requested format (encode stage). On the frame channel the reply is the
+  // finished frame message.
+  const uint64_t sequence =
+      output == CaptureOutput::kFrameMessage ? frame_sequence_++ : 0;
+  auto encode = [this, settings, limits, output, sequence, path,
+                 file_options](const ImageView& frame, int64_t timestamp_us,
+                               CaptureReply* reply) {
+    const int64_t scale_start = MonotonicNanos();
+    ImageView image = frame;
+    if (!resizer_.Fit(frame, limits, &image)) {
+      reply->Fail(CaptureStage::kScale, "internal_error",
+                  "Failed to resize image");
+      return;
+    }
+    if (image.data != frame.data) {
+      reply->sample()->Set(CaptureStage::kScale,
+                           MonotonicNanos() - scale_start);
+    }
+    if (output == CaptureOutput::kSharedMemory) {
+      EncodeShared(image, settings, reply);
+      return;
+    }
+    if (output == CaptureOutput::kFile) {
+      EncodeToFile(image, settings, path, file_options, timestamp_us, reply);
+      return;
+    }
+    if (output == CaptureOutput::kFrameMessage) {
+      std::vector<uint8_t> message;
+      if (!EncodeFrameMessage(&encoder_session_, image, settings, sequence,
+                              timestamp_us, &message)) {
+        reply->Fail("internal_error", "Failed to encode image");
         return;
       }
-      
-      // Create result map
-      flutter::EncodableMap resultMap;
-      resultMap[flutter::EncodableValue("width")] = flutter::EncodableValue(width);
-      resultMap[flutter::EncodableValue("height")] = flutter::EncodableValue(height);
-      resultMap[flutter::EncodableValue("bytes")] = flutter::EncodableValue(pngBytes);
-      
-      result->Success(flutter::EncodableValue(resultMap));
-    } else if (*mode_str == "region") {
-      // Region mode (US2)
-      int width = 0;
-      int height = 0;
-      int x = 0;
-      int y = 0;
-      bool cancelled = false;
-      
-      // Capture region with overlay
-      HBITMAP hBitmap = CaptureRegionToBitmap(&width, &height, &x, &y, &cancelled);
-      
-      if (cancelled || !hBitmap) {
-        // User cancelled or invalid selection - return null
-        result->Success();  // Success with null value
+      reply->sample()->output_bytes = message.size();
+      reply->Succeed(flutter::EncodableValue(std::move(message)));
+      return;
+    }
+    std::vector<uint8_t> bytes;
+    size_t stride = 0;
+    if (!EncodeCapture(image, settings, &encoder_session_, &bytes, &stride)) {
+      reply->Fail("internal_error", "Failed to encode image");
+      return;
+    }
+    reply->sample()->output_bytes = bytes.size();
+    reply->Succeed(flutter::EncodableValue(MakeCaptureResult(
+        image.width, image.height, settings.format, stride, std::move(bytes))));
+  };
+  
+  // Screen and all modes need the display layout; it is listed here, on
+  // the platform thread, for every request, so a display that was plugged in
+  // or rearranged since the last capture is picked up.
+  std::vector<DisplayInfo> displays;
+  if (*mode_str == "all" || (*mode_str == "screen" && displayId)) {
+    if (!display_backend_.ListDisplays(&displays)) {
+      result->Error("internal_error", "Failed to list displays");
+      return;
+    }
+  }
+  
+  if (*mode_str == "screen") {
+    PixelRect rect = screen_source_->Bounds();
+    if (displayId) {
+      if (*displayId < 0 || static_cast<size_t>(*displayId) >= displays.size()) {
+        result->Error("invalid_argument",
+                      "Invalid displayId: " + std::to_string(*displayId));
         return;
       }
-      
-      // Encode to PNG
-      std::vector<uint8_t> pngBytes = EncodeBitmapToPNG(hBitmap, width, height);
-      DeleteObject(hBitmap);
-      
-      if (pngBytes.empty()) {
-        result->Error("internal_error", "Failed to encode PNG");
+      rect = displays[static_cast<size_t>(*displayId)].bounds;
+    }
+    RunCaptureJob(std::make_unique<ScreenCaptureJob>(
+        screen_source_.get(), &frame_pool_, rect, includeCursor,
+        "Failed to capture screen", std::move(encode), std::move(result),
+        &stats_));
+  } else if (*mode_str == "all") {
+    // Every display at once, stitched into one virtual-desktop frame.
+    RunCaptureJob(std::make_unique<DisplaysCaptureJob>(
+        &display_capture_, std::move(displays), includeCursor, true,
+        [encode](const std::vector<ImageView>& frames, int64_t timestamp_us,
+                 CaptureReply* reply) {
+          encode(frames.front(), timestamp_us, reply);
+        },
+        std::move(result), &stats_));
+  } else if (*mode_str == "region") {
+    // Region mode (US2). The screen is captured once, before the overlay
+    // covers it, and the selection is cut out of that frame: the result is
+    // what was on screen when selecting started, and releasing the mouse
+    // does not wait for another capture.
+    const int64_t freeze_start = MonotonicNanos();
+    FrozenFrame frozen = FreezeScreen(region_source_.get(), &frame_pool_,
+                                      region_source_->Bounds());
+    if (!frozen) {
+      stats_.RecordError(CaptureStage::kCapture);
+      result->Error("internal_error", "Failed to capture region",
+                    flutter::EncodableValue(static_cast<int>(GetLastError())));
+      return;
+    }
+    const int64_t freeze_nanos = MonotonicNanos() - freeze_start;
+    PixelRect selection;
+    bool selected = false;
+    {
+      TraceSpan span("select region");
+      selected = SelectRegion(&selection);
+    }
+    if (!selected) {
+      // User cancelled or invalid selection - return null
+      result->Success();  // Success with null value
+      return;
+    }
+    
+    RunCaptureJob(std::make_unique<FrozenFrameJob>(
+        std::move(frozen), freeze_nanos, selection, std::move(encode),
+        std::move(result), &stats_));
+  } else {
+    // Unknown mode
+    result->Error("invalid_argument", "Invalid mode: " + *mode_str);
+  }
+}
+
+void ScreenshotPlugin::EncodeShared(const ImageView& frame,
+                                    const EncodeSettings& settings,
+                                    CaptureReply* reply) {
+  SharedFrameSlot slot;
+  size_t length = 0;
+  size_t stride = 0;
+  switch (EncodeSharedFrame(&encoder_session_, frame, settings, &shared_ring_,
+                            &slot, &length, &stride)) {
+    case SharedFrameStatus::kOk:
+      break;
+    case SharedFrameStatus::kEncodeFailed:
+      reply->Fail("internal_error", "Failed to encode image");
+      return;
+    case SharedFrameStatus::kNoFreeSlot:
+      reply->Fail("internal_error",
+                  "No free shared frame slot; release earlier frames first");
+      return;
+    case SharedFrameStatus::kMapFailed:
+      reply->Fail("internal_error",
+                  "Failed to create shared memory for the frame");
+      return;
+  }
+  reply->sample()->output_bytes = length;
+  flutter::EncodableMap resultMap;
+  resultMap[flutter::EncodableValue("width")] = flutter::EncodableValue(frame.width);
+  resultMap[flutter::EncodableValue("height")] = flutter::EncodableValue(frame.height);
+  resultMap[flutter::EncodableValue("stride")] =
+      flutter::EncodableValue(static_cast<int>(stride));
+  resultMap[flutter::EncodableValue("pixelFormat")] =
+      flutter::EncodableValue(std::string(CaptureFormatName(settings.format)));
+  resultMap[flutter::EncodableValue("handle")] =
+      flutter::EncodableValue(static_cast<int64_t>(slot.handle));
+  resultMap[flutter::EncodableValue("offset")] =
+      flutter::EncodableValue(static_cast<int64_t>(slot.offset));
+  resultMap[flutter::EncodableValue("length")] =
+      flutter::EncodableValue(static_cast<int64_t>(length));
+  resultMap[flutter::EncodableValue("generation")] =
+      flutter::EncodableValue(static_cast<int64_t>(slot.generation));
+  reply->Succeed(flutter::EncodableValue(std::move(resultMap)));
+}
+
+void ScreenshotPlugin::EncodeToFile(const ImageView& frame,
+                                    const EncodeSettings& settings,
+                                    const std::string& path,
+                                    const FileSinkOptions& options,
+                                    int64_t timestamp_us, CaptureReply* reply) {
+  int error = 0;
+  std::unique_ptr<FileSink> sink = FileSink::Open(path, options, &error);
+  if (!sink) {
+    reply->Fail("internal_error", "Failed to open " + path,
+                flutter::EncodableValue(error));
+    return;
+  }
+  if (!encoder_session_.Encode(frame, settings, sink.get())) {
+    if (sink->error() != 0) {
+      reply->Fail("internal_error", "Failed to write " + path,
+                  flutter::EncodableValue(sink->error()));
+    } else {
+      reply->Fail("internal_error", "Failed to encode image");
+    }
+    return;
+  }
+  if (!sink->Commit()) {
+    reply->Fail("internal_error", "Failed to write " + path,
+                flutter::EncodableValue(sink->error()));
+    return;
+  }
+  const int64_t elapsed_us = SteadyClockMicros() - timestamp_us;
+  reply->sample()->output_bytes = sink->size();
+
+  flutter::EncodableMap resultMap;
+  resultMap[flutter::EncodableValue("path")] = flutter::EncodableValue(path);
+  resultMap[flutter::EncodableValue("width")] = flutter::EncodableValue(frame.width);
+  resultMap[flutter::EncodableValue("height")] = flutter::EncodableValue(frame.height);
+  resultMap[flutter::EncodableValue("pixelFormat")] =
+      flutter::EncodableValue(std::string(CaptureFormatName(settings.format)));
+  resultMap[flutter::EncodableValue("byteCount")] =
+      flutter::EncodableValue(static_cast<int64_t>(sink->size()));
+  resultMap[flutter::EncodableValue("elapsedUs")] =
+      flutter::EncodableValue(elapsed_us);
+  reply->Succeed(flutter::EncodableValue(std::move(resultMap)));
+}
+
+void ScreenshotPlugin::HandleCaptureTiles(
+    const flutter::EncodableMap& arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  bool includeCursor = false;
+  auto cursor_it = arguments.find(flutter::EncodableValue("includeCursor"));
+  if (cursor_it != arguments.end()) {
+    const auto* cursor_bool = std::get_if<bool>(&cursor_it->second);
+    if (cursor_bool) {
+      includeCursor = *cursor_bool;
+    }
+  }
+  
+  // Get keyframe parameter (optional, default false)
+  bool keyframe = false;
+  auto keyframe_it = arguments.find(flutter::EncodableValue("keyframe"));
+  if (keyframe_it != arguments.end() && !keyframe_it->second.IsNull()) {
+    const auto* keyframe_bool = std::get_if<bool>(&keyframe_it->second);
+    if (!keyframe_bool) {
+      result->Error("invalid_argument", "'keyframe' must be a bool");
+      return;
+    }
+    keyframe = *keyframe_bool;
+  }
+  
+  // Get tileSize parameter (optional, default 64). A new size drops the
+  // previous frame, so the next result is a keyframe.
+  // 0 keeps the current size.
+  int tileSize = 0;
+  auto tile_it = arguments.find(flutter::EncodableValue("tileSize"));
+  if (tile_it != arguments.end() && !tile_it->second.IsNull()) {
+    const auto* tile_size = std::get_if<int32_t>(&tile_it->second);
+    if (!tile_size) {
+      result->Error("invalid_argument", "'tileSize' must be an int");
+      return;
+    }
+    if (*tile_size < kMinTileSize || *tile_size > kMaxTileSize) {
+      result->Error("invalid_argument",
+                    "Invalid tileSize: " + std::to_string(*tile_size));
+      return;
+    }
+    tileSize = *tile_size;
+  }
+  
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, result.get())) return;
+  // Tiles are small; encode several at once instead of banding each one.
+  settings.threads = 1;
+  
+  RunCaptureJob(std::make_unique<ScreenCaptureJob>(
+      screen_source_.get(), &frame_pool_, screen_source_->Bounds(),
+      includeCursor,
+      "Failed to capture screen",
+      [this, settings, tileSize, keyframe](const ImageView& frame,
+                                           int64_t timestamp_us,
+                                           CaptureReply* reply) {
+        EncodeTiles(frame, settings, tileSize, keyframe, reply);
+      },
+      std::move(result), &stats_));
+}
+
+void ScreenshotPlugin::EncodeTiles(const ImageView& frame,
+                                   const EncodeSettings& settings,
+                                   int tileSize, bool keyframe,
+                                   CaptureReply* reply) {
+  if (tileSize != 0 && tileSize != frame_differ_.options().tile_size) {
+    FrameDiffOptions diff_options = frame_differ_.options();
+    diff_options.tile_size = tileSize;
+    frame_differ_.set_options(diff_options);
+  }
+  
+  const int width = frame.width;
+  const int height = frame.height;
+  FrameDiff diff;
+  if (!frame_differ_.Diff(frame, keyframe, &diff)) {
+    reply->Fail("internal_error", "Failed to compare frames");
+    return;
+  }
+  
+  // Encode each changed tile from a view into the captured frame.
+  const size_t count = diff.tiles.size();
+  std::vector<std::vector<uint8_t>> encoded(count);
+  std::vector<size_t> strides(count, 0);
+  std::vector<uint8_t> ok(count, 0);
+  RunEncodeLanes(count, [&](EncoderSession* session, size_t i) {
+    const TileRect& tile = diff.tiles[i];
+    ImageView view = frame;
+    view.data = frame.Row(tile.y) +
+                static_cast<size_t>(tile.x) * kBytesPerPixel;
+    view.width = tile.width;
+    view.height = tile.height;
+    ok[i] = EncodeImage(session, view, settings, &encoded[i], &strides[i])
+                ? 1
+                : 0;
+  });
+  
+  flutter::EncodableList tiles;
+  tiles.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (!ok[i]) {
+      // The reference already holds this frame; start over next time.
+      frame_differ_.Reset();
+      reply->Fail("internal_error", "Failed to encode tile");
+      return;
+    }
+    const TileRect& tile = diff.tiles[i];
+    reply->sample()->output_bytes += encoded[i].size();
+    flutter::EncodableMap tileMap;
+    tileMap[flutter::EncodableValue("x")] = flutter::EncodableValue(tile.x);
+    tileMap[flutter::EncodableValue("y")] = flutter::EncodableValue(tile.y);
+    tileMap[flutter::EncodableValue("width")] = flutter::EncodableValue(tile.width);
+    tileMap[flutter::EncodableValue("height")] = flutter::EncodableValue(tile.height);
+    tileMap[flutter::EncodableValue("stride")] =
+        flutter::EncodableValue(static_cast<int>(strides[i]));
+    tileMap[flutter::EncodableValue("bytes")] =
+        flutter::EncodableValue(std::move(encoded[i]));
+    tiles.push_back(flutter::EncodableValue(std::move(tileMap)));
+  }
+  
+  flutter::EncodableMap resultMap;
+  resultMap[flutter::EncodableValue("width")] = flutter::EncodableValue(width);
+  resultMap[flutter::EncodableValue("height")] = flutter::EncodableValue(height);
+  resultMap[flutter::EncodableValue("keyframe")] =
+      flutter::EncodableValue(diff.keyframe);
+  resultMap[flutter::EncodableValue("tileSize")] =
+      flutter::EncodableValue(frame_differ_.options().tile_size);
+  resultMap[flutter::EncodableValue("pixelFormat")] =
+      flutter::EncodableValue(std::string(CaptureFormatName(settings.format)));
+  resultMap[flutter::EncodableValue("tiles")] =
+      flutter::EncodableValue(std::move(tiles));
+  reply->Succeed(flutter::EncodableValue(std::move(resultMap)));
+}
+
+void ScreenshotPlugin::HandleCaptureBatch(
+    const flutter::EncodableMap& arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  bool includeCursor = false;
+  auto cursor_it = arguments.find(flutter::EncodableValue("includeCursor"));
+  if (cursor_it != arguments.end()) {
+    const auto* cursor_bool = std::get_if<bool>(&cursor_it->second);
+    if (cursor_bool) {
+      includeCursor = *cursor_bool;
+    }
+  }
+  
+  // The defaults for every rectangle
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, result.get())) return;
+  ResizeLimits limits;
+  if (!ParseResizeLimits(arguments, &limits, result.get())) return;
+  
+  // Get rects parameter
+  auto rects_it = arguments.find(flutter::EncodableValue("rects"));
+  const auto* rects =
+      rects_it != arguments.end()
+          ? std::get_if<flutter::EncodableList>(&rects_it->second)
+          : nullptr;
+  if (!rects || rects->empty()) {
+    result->Error("invalid_argument", "'rects' must be a non-empty list");
+    return;
+  }
+  if (rects->size() > kMaxBatchRects) {
+    result->Error("invalid_argument",
+                  "Too many rects: " + std::to_string(rects->size()) +
+                      " (at most " + std::to_string(kMaxBatchRects) + ")");
+    return;
+  }
+  
+  // Each rectangle is clipped to the primary display here, so one outside
+  // it fails the call before anything is captured.
+  const PixelRect screen = screen_source_->Bounds();
+  std::vector<BatchCrop> crops(rects->size());
+  PixelRect area;
+  for (size_t i = 0; i < rects->size(); ++i) {
+    const std::string name = "rects[" + std::to_string(i) + "]";
+    const auto* rect = std::get_if<flutter::EncodableMap>(&(*rects)[i]);
+    if (!rect) {
+      result->Error("invalid_argument", "'" + name + "' must be a map");
+      return;
+    }
+    PixelRect requested;
+    if (!ParsePixelRect(*rect, name, &requested, result.get())) return;
+    crops[i].rect = IntersectRects(requested, screen);
+    if (crops[i].rect.IsEmpty()) {
+      result->Error("invalid_argument",
+                    "'" + name + "' is not on the screen");
+      return;
+    }
+    // Per-rectangle format, quality, chromaSubsampling and scaling
+    crops[i].settings = settings;
+    crops[i].limits = limits;
+    if (!ParseEncodeSettings(*rect, &crops[i].settings, result.get()) ||
+        !ParseResizeLimits(*rect, &crops[i].limits, result.get())) {
+      return;
+    }
+    const PixelRect& crop = crops[i].rect;
+    if (i == 0) {
+      area = crop;
+    } else {
+      // windows.h defines min and max as macros.
+      area = RectFromCorners(crop.x < area.x ? crop.x : area.x,
+                             crop.y < area.y ? crop.y : area.y,
+                             crop.right() > area.right() ? crop.right()
+                                                         : area.right(),
+                             crop.bottom() > area.bottom() ? crop.bottom()
+                                                           : area.bottom());
+    }
+  }
+  // Only the box around the rectangles is copied off the screen; crops are
+  // taken from it.
+  for (BatchCrop& crop : crops) {
+    crop.rect.x -= area.x;
+    crop.rect.y -= area.y;
+  }
+  
+  RunCaptureJob(std::make_unique<ScreenCaptureJob>(
+      screen_source_.get(), &frame_pool_, area, includeCursor,
+      "Failed to capture screen",
+      [this, crops, area](const ImageView& frame, int64_t timestamp_us,
+                          CaptureReply* reply) {
+        EncodeBatch(frame, crops, area.x, area.y, reply);
+      },
+      std::move(result), &stats_));
+}
+
+void ScreenshotPlugin::EncodeBatch(const ImageView& frame,
+                                   const std::vector<BatchCrop>& crops,
+                                   int x, int y, CaptureReply* reply) {
+  std::vector<BatchOutput> outputs;
+  if (!batch_encoder_.Encode(frame, crops, &outputs)) {
+    reply->Fail("internal_error", "Failed to encode image");
+    return;
+  }
+  flutter::EncodableList list;
+  list.reserve(outputs.size());
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    BatchOutput& output = outputs[i];
+    reply->sample()->output_bytes += output.bytes.size();
+    flutter::EncodableMap resultMap = MakeCaptureResult(
+        output.width, output.height, crops[i].settings.format, output.stride,
+        std::move(output.bytes));
+    resultMap[flutter::EncodableValue("x")] =
+        flutter::EncodableValue(output.rect.x + x);
+    resultMap[flutter::EncodableValue("y")] =
+        flutter::EncodableValue(output.rect.y + y);
+    resultMap[flutter::EncodableValue("sourceWidth")] =
+        flutter::EncodableValue(output.rect.width);
+    resultMap[flutter::EncodableValue("sourceHeight")] =
+        flutter::EncodableValue(output.rect.height);
+    list.push_back(flutter::EncodableValue(std::move(resultMap)));
+  }
+  reply->Succeed(flutter::EncodableValue(std::move(list)));
+}
+
+void ScreenshotPlugin::HandleCaptureHash(
+    const flutter::EncodableMap& arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  bool includeCursor = false;
+  auto cursor_it = arguments.find(flutter::EncodableValue("includeCursor"));
+  if (cursor_it != arguments.end()) {
+    const auto* cursor_bool = std::get_if<bool>(&cursor_it->second);
+    if (cursor_bool) {
+      includeCursor = *cursor_bool;
+    }
+  }
+  
+  // Get hashes parameter (optional, default every hash)
+  ImageHashOptions options;
+  auto hashes_it = arguments.find(flutter::EncodableValue("hashes"));
+  if (hashes_it != arguments.end() && !hashes_it->second.IsNull()) {
+    const auto* hashes = std::get_if<flutter::EncodableList>(&hashes_it->second);
+    if (!hashes || hashes->empty()) {
+      result->Error("invalid_argument", "'hashes' must be a non-empty list");
+      return;
+    }
+    options.xxh3 = options.dhash = options.phash = false;
+    for (const flutter::EncodableValue& value : *hashes) {
+      const auto* hash = std::get_if<std::string>(&value);
+      if (hash && *hash == "xxh3") {
+        options.xxh3 = true;
+      } else if (hash && *hash == "dhash") {
+        options.dhash = true;
+      } else if (hash && *hash == "phash") {
+        options.phash = true;
+      } else {
+        result->Error("invalid_argument",
+                      "'hashes' must hold \"xxh3\", \"dhash\" or \"phash\"");
         return;
       }
-      
-      // Create result map
-      flutter::EncodableMap resultMap;
-      resultMap[flutter::EncodableValue("width")] = flutter::EncodableValue(width);
-      resultMap[flutter::EncodableValue("height")] = flutter::EncodableValue(height);
-      resultMap[flutter::EncodableValue("bytes")] = flutter::EncodableValue(pngBytes);
-      
-      result->Success(flutter::EncodableValue(resultMap));
-    } else {
-      // Unknown mode
-      result->Error("invalid_argument", "Invalid mode: " + *mode_str);
     }
+  }
+  
+  // Get rect parameter (optional, default the whole primary display)
+  PixelRect rect = screen_source_->Bounds();
+  auto rect_it = arguments.find(flutter::EncodableValue("rect"));
+  if (rect_it != arguments.end() && !rect_it->second.IsNull()) {
+    const auto* rect_map = std::get_if<flutter::EncodableMap>(&rect_it->second);
+    if (!rect_map) {
+      result->Error("invalid_argument", "'rect' must be a map");
+      return;
+    }
+    PixelRect requested;
+    if (!ParsePixelRect(*rect_map, "rect", &requested, result.get())) return;
+    rect = IntersectRects(requested, rect);
+    if (rect.IsEmpty()) {
+      result->Error("invalid_argument", "'rect' is not on the screen");
+      return;
+    }
+  }
+  
+  // Only the rect is copied off the screen, and it is hashed where it was
+  // copied to: nothing is encoded.
+  RunCaptureJob(std::make_unique<ScreenCaptureJob>(
+      screen_source_.get(), &frame_pool_, rect, includeCursor,
+      "Failed to capture screen",
+      [this, options, rect](const ImageView& frame, int64_t timestamp_us,
+                            CaptureReply* reply) {
+        HashCapture(frame, options, rect, reply);
+      },
+      std::move(result), &stats_));
+}
+
+void ScreenshotPlugin::HashCapture(const ImageView& frame,
+                                   const ImageHashOptions& options,
+                                   const PixelRect& rect,
+                                   CaptureReply* reply) {
+  ImageHashes hashes;
+  if (!image_hasher_.Hash(frame, options, &hashes)) {
+    reply->Fail("internal_error", "Failed to hash image");
+    return;
+  }
+  flutter::EncodableMap resultMap;
+  resultMap[flutter::EncodableValue("x")] = flutter::EncodableValue(rect.x);
+  resultMap[flutter::EncodableValue("y")] = flutter::EncodableValue(rect.y);
+  resultMap[flutter::EncodableValue("width")] =
+      flutter::EncodableValue(rect.width);
+  resultMap[flutter::EncodableValue("height")] =
+      flutter::EncodableValue(rect.height);
+  // Dart ints are signed 64-bit; the hashes keep their bits.
+  if (options.xxh3) {
+    resultMap[flutter::EncodableValue("xxh3")] =
+        flutter::EncodableValue(static_cast<int64_t>(hashes.xxh3));
+  }
+  if (options.dhash) {
+    resultMap[flutter::EncodableValue("dhash")] =
+        flutter::EncodableValue(static_cast<int64_t>(hashes.dhash));
+  }
+  if (options.phash) {
+    resultMap[flutter::EncodableValue("phash")] =
+        flutter::EncodableValue(static_cast<int64_t>(hashes.phash));
+  }
+  reply->Succeed(flutter::EncodableValue(std::move(resultMap)));
+}
+
+void ScreenshotPlugin::HandleListDisplays(
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  std::vector<DisplayInfo> displays;
+  if (!display_backend_.ListDisplays(&displays)) {
+    result->Error("internal_error", "Failed to list displays");
+    return;
+  }
+  flutter::EncodableList list;
+  list.reserve(displays.size());
+  for (const DisplayInfo& display : displays) {
+    flutter::EncodableMap displayMap;
+    displayMap[flutter::EncodableValue("id")] = flutter::EncodableValue(display.id);
+    displayMap[flutter::EncodableValue("x")] =
+        flutter::EncodableValue(display.bounds.x);
+    displayMap[flutter::EncodableValue("y")] =
+        flutter::EncodableValue(display.bounds.y);
+    displayMap[flutter::EncodableValue("width")] =
+        flutter::EncodableValue(display.bounds.width);
+    displayMap[flutter::EncodableValue("height")] =
+        flutter::EncodableValue(display.bounds.height);
+    displayMap[flutter::EncodableValue("primary")] =
+        flutter::EncodableValue(display.primary);
+    displayMap[flutter::EncodableValue("name")] =
+        flutter::EncodableValue(display.name);
+    list.push_back(flutter::EncodableValue(std::move(displayMap)));
+  }
+  result->Success(flutter::EncodableValue(std::move(list)));
+}
+
+void ScreenshotPlugin::HandleCaptureAllDisplays(
+    const flutter::EncodableMap& arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  bool includeCursor = false;
+  auto cursor_it = arguments.find(flutter::EncodableValue("includeCursor"));
+  if (cursor_it != arguments.end()) {
+    const auto* cursor_bool = std::get_if<bool>(&cursor_it->second);
+    if (cursor_bool) {
+      includeCursor = *cursor_bool;
+    }
+  }
+  
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, result.get())) return;
+  
+  std::vector<DisplayInfo> displays;
+  if (!display_backend_.ListDisplays(&displays)) {
+    result->Error("internal_error", "Failed to list displays");
+    return;
+  }
+  // The encode stage needs the layout too, for the result.
+  std::vector<DisplayInfo> layout = displays;
+  RunCaptureJob(std::make_unique<DisplaysCaptureJob>(
+      &display_capture_, std::move(displays), includeCursor, false,
+      [this, layout, settings](const std::vector<ImageView>& frames,
+                               int64_t timestamp_us, CaptureReply* reply) {
+        EncodeDisplays(layout, frames, settings, reply);
+      },
+      std::move(result), &stats_));
+}
+
+void ScreenshotPlugin::EncodeDisplays(const std::vector<DisplayInfo>& displays,
+                                      const std::vector<ImageView>& frames,
+                                      const EncodeSettings& settings,
+                                      CaptureReply* reply) {
+  const size_t count = frames.size();
+  EncodeSettings lane_settings = settings;
+  // With several displays, encode them side by side instead of banding
+  // each one.
+  if (count > 1) lane_settings.threads = 1;
+  std::vector<std::vector<uint8_t>> encoded(count);
+  std::vector<size_t> strides(count, 0);
+  std::vector<uint8_t> ok(count, 0);
+  RunEncodeLanes(count, [&](EncoderSession* session, size_t i) {
+    ok[i] = EncodeCapture(frames[i], lane_settings, session, &encoded[i],
+                          &strides[i])
+                ? 1
+                : 0;
+  });
+  
+  flutter::EncodableList list;
+  list.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (!ok[i]) {
+      reply->Fail("internal_error", "Failed to encode image");
+      return;
+    }
+    reply->sample()->output_bytes += encoded[i].size();
+    flutter::EncodableMap resultMap =
+        MakeCaptureResult(frames[i].width, frames[i].height, settings.format,
+                          strides[i], std::move(encoded[i]));
+    resultMap[flutter::EncodableValue("displayId")] =
+        flutter::EncodableValue(displays[i].id);
+    resultMap[flutter::EncodableValue("x")] =
+        flutter::EncodableValue(displays[i].bounds.x);
+    resultMap[flutter::EncodableValue("y")] =
+        flutter::EncodableValue(displays[i].bounds.y);
+    list.push_back(flutter::EncodableValue(std::move(resultMap)));
+  }
+  reply->Succeed(flutter::EncodableValue(std::move(list)));
+}
+
+void ScreenshotPlugin::RunEncodeLanes(
+    size_t count,
+    const std::function<void(EncoderSession* session, size_t i)>& fn) {
+  // Items are dealt out to lanes round robin.
+  const int workers = ThreadPool::DefaultThreadCount() - 1;
+  size_t lanes = 1;
+  if (count > 1 && workers > 0) {
+    lanes = count < static_cast<size_t>(workers) + 1
+                ? count
+                : static_cast<size_t>(workers) + 1;
+  }
+  while (lane_sessions_.size() < lanes) {
+    lane_sessions_.push_back(std::make_unique<EncoderSession>());
+  }
+  auto encode_lane = [&](size_t lane) {
+    EncoderSession* session = lane_sessions_[lane].get();
+    for (size_t i = lane; i < count; i += lanes) fn(session, i);
+  };
+  if (lanes > 1) {
+    if (!lane_pool_ || lane_pool_->size() != workers) {
+      lane_pool_ = std::make_unique<ThreadPool>(workers);
+    }
+    lane_pool_->ParallelFor(lanes, encode_lane);
   } else {
-    result->NotImplemented();
+    encode_lane(0);
+  }
+}
+
+void ScreenshotPlugin::HandleGetStats(
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  const CaptureStatsSnapshot snapshot = stats_.Snapshot();
+  flutter::EncodableMap stages;
+  for (size_t i = 0; i < kCaptureStageCount; ++i) {
+    const StageStats& stage = snapshot.stages[i];
+    flutter::EncodableMap stageMap;
+    stageMap[flutter::EncodableValue("count")] =
+        flutter::EncodableValue(static_cast<int64_t>(stage.latency.count));
+    stageMap[flutter::EncodableValue("errors")] =
+        flutter::EncodableValue(static_cast<int64_t>(stage.errors));
+    stageMap[flutter::EncodableValue("p50Us")] = Micros(stage.latency.p50);
+    stageMap[flutter::EncodableValue("p95Us")] = Micros(stage.latency.p95);
+    stageMap[flutter::EncodableValue("p99Us")] = Micros(stage.latency.p99);
+    stageMap[flutter::EncodableValue("maxUs")] = Micros(stage.latency.max);
+    stageMap[flutter::EncodableValue("meanUs")] = Micros(stage.latency.mean);
+    stages[flutter::EncodableValue(
+        CaptureStageName(static_cast<CaptureStage>(i)))] =
+        flutter::EncodableValue(std::move(stageMap));
+  }
+
+  const FramePoolStats pool = frame_pool_.stats();
+  flutter::EncodableMap poolMap;
+  poolMap[flutter::EncodableValue("hits")] =
+      flutter::EncodableValue(static_cast<int64_t>(pool.hits));
+  poolMap[flutter::EncodableValue("misses")] =
+      flutter::EncodableValue(static_cast<int64_t>(pool.misses));
+  poolMap[flutter::EncodableValue("evictions")] =
+      flutter::EncodableValue(static_cast<int64_t>(pool.evictions));
+  poolMap[flutter::EncodableValue("buffers")] =
+      flutter::EncodableValue(static_cast<int64_t>(pool.buffers));
+  poolMap[flutter::EncodableValue("residentBytes")] =
+      flutter::EncodableValue(static_cast<int64_t>(pool.resident_bytes));
+  poolMap[flutter::EncodableValue("leasedBytes")] =
+      flutter::EncodableValue(static_cast<int64_t>(pool.leased_bytes));
+
+  const CaptureStreamStats stream = stream_.stats();
+  flutter::EncodableMap streamMap;
+  streamMap[flutter::EncodableValue("captured")] =
+      flutter::EncodableValue(static_cast<int64_t>(stream.captured));
+  streamMap[flutter::EncodableValue("delivered")] =
+      flutter::EncodableValue(static_cast<int64_t>(stream.delivered));
+  streamMap[flutter::EncodableValue("dropped")] =
+      flutter::EncodableValue(static_cast<int64_t>(stream.dropped));
+  streamMap[flutter::EncodableValue("failed")] =
+      flutter::EncodableValue(static_cast<int64_t>(stream.failed));
+  streamMap[flutter::EncodableValue("skipped")] =
+      flutter::EncodableValue(static_cast<int64_t>(stream.skipped));
+
+  flutter::EncodableMap resultMap;
+  resultMap[flutter::EncodableValue("stages")] =
+      flutter::EncodableValue(std::move(stages));
+  resultMap[flutter::EncodableValue("capturedBytes")] =
+      flutter::EncodableValue(static_cast<int64_t>(snapshot.captured_bytes));
+  resultMap[flutter::EncodableValue("outputBytes")] =
+      flutter::EncodableValue(static_cast<int64_t>(snapshot.output_bytes));
+  resultMap[flutter::EncodableValue("framePool")] =
+      flutter::EncodableValue(std::move(poolMap));
+  resultMap[flutter::EncodableValue("stream")] =
+      flutter::EncodableValue(std::move(streamMap));
+  result->Success(flutter::EncodableValue(std::move(resultMap)));
+}
+
+void ScreenshotPlugin::HandleStartStream(
+    const flutter::EncodableMap& arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  if (!task_queue_ || !task_queue_->IsAvailable()) {
+    result->Error("not_supported", "Streaming requires a Flutter view");
+    return;
+  }
+  
+  // Get fps parameter (optional, default 30)
+  CaptureStreamOptions options;
+  options.fps = kDefaultStreamFps;
+  auto fps_it = arguments.find(flutter::EncodableValue("fps"));
+  if (fps_it != arguments.end() && !fps_it->second.IsNull()) {
+    if (const auto* fps_double = std::get_if<double>(&fps_it->second)) {
+      options.fps = *fps_double;
+    } else if (const auto* fps_int = std::get_if<int32_t>(&fps_it->second)) {
+      options.fps = *fps_int;
+    } else {
+      result->Error("invalid_argument", "'fps' must be a number");
+      return;
+    }
+    if (!(options.fps > 0.0 && options.fps <= CaptureStream::kMaxFps)) {
+      result->Error("invalid_argument",
+                    "Invalid fps: " + std::to_string(options.fps));
+      return;
+    }
+  }
+  
+  bool includeCursor = false;
+  auto cursor_it = arguments.find(flutter::EncodableValue("includeCursor"));
+  if (cursor_it != arguments.end()) {
+    const auto* cursor_bool = std::get_if<bool>(&cursor_it->second);
+    if (cursor_bool) {
+      includeCursor = *cursor_bool;
+    }
+  }
+  
+  EncodeSettings settings;
+  if (!ParseEncodeSettings(arguments, &settings, result.get())) return;
+  
+  // A new startStream replaces the running stream.
+  stream_.Stop();
+  {
+    std::lock_guard<std::mutex> lock(stream_event_mutex_);
+    pending_stream_event_.reset();
+    stream_events_dropped_ = 0;
+  }
+  stream_source_.reset();
+  stream_capture_source_ = capture_sources_();
+  stream_source_ = std::make_unique<CaptureSourceFrameSource>(
+      stream_capture_source_.get(), includeCursor);
+  const bool started = stream_.Start(
+      stream_source_.get(), options, [this, settings](const StreamFrame& frame) {
+        // Runs on the stream's delivery thread: encode here, send on the
+        // platform thread.
+        std::vector<uint8_t> bytes;
+        size_t stride = 0;
+        if (!EncodeImage(&stream_session_, frame.View(), settings, &bytes,
+                         &stride)) {
+          // Counted in the stream's "failed", which the next event carries.
+          stats_.RecordError(CaptureStage::kEncode);
+          return false;
+        }
+        flutter::EncodableMap event = MakeCaptureResult(
+            frame.width, frame.height, settings.format, stride, std::move(bytes));
+        event[flutter::EncodableValue("sequence")] =
+            flutter::EncodableValue(static_cast<int64_t>(frame.sequence));
+        event[flutter::EncodableValue("timestampUs")] =
+            flutter::EncodableValue(frame.timestamp_us);
+        PostStreamEvent(std::move(event));
+        return true;
+      });
+  if (!started) {
+    result->Error("internal_error", "Failed to start capture stream");
+    return;
+  }
+  result->Success();
+}
+
+void ScreenshotPlugin::PostStreamEvent(flutter::EncodableMap event) {
+  bool post = false;
+  {
+    std::lock_guard<std::mutex> lock(stream_event_mutex_);
+    // Like the capture mailbox, keep only the newest frame if the platform
+    // thread has not sent the previous one yet.
+    if (pending_stream_event_) {
+      ++stream_events_dropped_;
+    } else {
+      post = true;
+    }
+    pending_stream_event_ = std::move(event);
+  }
+  // Post() only fails without a window, and HandleStartStream does not
+  // stream then.
+  if (post) {
+    task_queue_->Post([this] { SendStreamEvent(); });
+  }
+}
+
+void ScreenshotPlugin::SendStreamEvent() {
+  std::optional<flutter::EncodableMap> event;
+  uint64_t dropped = 0;
+  {
+    std::lock_guard<std::mutex> lock(stream_event_mutex_);
+    event.swap(pending_stream_event_);
+    dropped = stream_events_dropped_;
   }
+  if (!event || !event_sink_) return;
+  const CaptureStreamStats stats = stream_.stats();
+  dropped += stats.dropped;
+  (*event)[flutter::EncodableValue("dropped")] =
+      flutter::EncodableValue(static_cast<int64_t>(dropped));
+  (*event)[flutter::EncodableValue("failed")] =
+      flutter::EncodableValue(static_cast<int64_t>(stats.failed));
+  event_sink_->Success(flutter::EncodableValue(std::move(*event)));
 }
 
 }  // namespace screenshot
@@ -1,32 +1,91 @@
 #ifndef FLUTTER_PLUGIN_SCREENSHOT_PLUGIN_H_
 #define FLUTTER_PLUGIN_SCREENSHOT_PLUGIN_H_
 
+#include <flutter/binary_messenger.h>
+#include <flutter/event_channel.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "batch_encoder.h"
+#include "capture_pipeline.h"
+#include "capture_source.h"
+#include "capture_stats.h"
+#include "capture_stream.h"
+#include "display_capture.h"
+#include "encoder_session.h"
+#include "file_sink.h"
+#include "frame_diff.h"
+#include "frame_pool.h"
+#include "gdi_display_backend.h"
+#include "image_hash.h"
+#include "image_resizer.h"
+#include "platform_task_queue.h"
+#include "shared_frame_ring.h"
+#include "thread_pool.h"
 
 namespace screenshot {
 
+class CaptureReply;
+
 // Windows implementation of the screenshot plugin.
 // 
 // Error Codes (returned via MethodResult::Error):
 // - "cancelled": User cancelled the screenshot operation (ESC or right-click during region selection)
-// - "not_supported": Screenshot operation is not supported on this platform (non-Windows)
-// - "internal_error": Internal Windows API error occurred (BitBlt, WIC encoding, memory allocation failure)
+// - "not_supported": Screenshot operation is not supported on this platform (non-Windows),
+//                    or "webp" was requested from a build without libwebp
+// - "internal_error": Internal Windows API error occurred (BitBlt, image encoding, memory allocation failure)
 //                     Details contain Win32 error code (GetLastError) or error description
-// - "invalid_argument": Invalid parameters provided (missing 'mode', invalid mode value, invalid parameter types)
+// - "invalid_argument": Invalid parameters provided (missing 'mode', invalid mode, format, quality,
+//                       chromaSubsampling or displayId value, invalid parameter types)
+//
+// Threading:
+// "capture" and "captureTiles" return right away. The screen is copied on a
+// capture thread and encoded on an encode thread (see CapturePipeline), so
+// the platform thread never waits for GDI or an encoder, and the capture of
+// one request overlaps the encode of the one before. Their results are
+// delivered on the platform thread, in call order, including those of
+// captures that failed; calls answered before reaching the pipeline (bad
+// arguments, a cancelled region selection) are answered right away. Region
+// mode captures the whole screen on the platform thread before showing its
+// overlay there, then queues the encode of the selected part of that
+// frame. "all" mode and "captureAllDisplays" copy every display at once,
+// one capture lane per display, and "captureAllDisplays" encodes them at
+// once too.
 //
 // Return Values:
-// - Success with Map: Screenshot captured successfully, contains 'width', 'height', 'bytes' (PNG)
+// - Success with Map: Screenshot captured successfully, contains 'width', 'height', 'stride',
+//                     'pixelFormat' and 'bytes' (encoded image or raw pixels, see 'format')
 // - Success with null: User cancelled (region mode ESC/right-click) - not an error
 // - Error: Operation failed, see error codes above
 class ScreenshotPlugin : public flutter::Plugin {
  public:
   static void RegisterWithRegistrar(flutter::PluginRegistrarWindows *registrar);
 
+  // Makes the sources the plugin captures from: one for the capture
+  // pipeline, one for region mode and one per stream, each used by one
+  // thread at a time.
+  using CaptureSourceFactory = std::function<std::unique_ptr<CaptureSource>()>;
+
+  // Captures the screen, through GDI.
   ScreenshotPlugin();
 
+  // Captures from sources made by |capture_sources| instead, e.g. a
+  // SyntheticScreen in tests. "all" mode, "captureAllDisplays" and a
+  // "displayId" still read the displays through GDI.
+  explicit ScreenshotPlugin(CaptureSourceFactory capture_sources);
+
+  // Streaming needs |registrar| to deliver frames on the platform thread.
+  explicit ScreenshotPlugin(flutter::PluginRegistrarWindows *registrar);
+
   virtual ~ScreenshotPlugin();
 
   // Disallow copy and assign.
@@ -36,12 +95,272 @@ class ScreenshotPlugin : public flutter::Plugin {
   // Called when a method is called on this plugin's channel from Dart.
   // 
   // Supported methods:
-  // - "capture": Capture screenshot (screen or region mode)
-  //   Parameters: { mode: "screen"|"region", includeCursor?: bool, displayId?: int }
-  //   Returns: { width: int, height: int, bytes: Uint8List } or null (if cancelled)
+  // - "capture": Capture screenshot (screen, region or all mode)
+  //   Parameters: { mode: "screen"|"region"|"all", includeCursor?: bool, displayId?: int,
+  //                 format?: "png"|"raw_bgra"|"raw_rgba"|"qoi"|"lz4_bgra"|"jpeg"|"webp",
+  //                 quality?: int (1-100, JPEG/WebP), chromaSubsampling?: "444"|"422"|"420",
+  //                 maxWidth?: int (>= 1), maxHeight?: int (>= 1), scale?: double (0-1] }
+  //   Returns: { width: int, height: int, stride: int, pixelFormat: String, bytes: Uint8List }
+  //            or null (if cancelled). stride is the row size of raw (and LZ4-framed) pixels,
+  //            0 for image formats. The capture is scaled by scale and then shrunk to fit
+  //            maxWidth x maxHeight (keeping its aspect ratio, never enlarging) before it is
+  //            encoded; width and height are those of the result. Screen mode captures
+  //            the display with displayId (an id from "listDisplays"), or the primary
+  //            display without one; region mode always selects on the primary display.
+  //            All mode captures the whole virtual desktop: every display, stitched
+  //            at its place, with the gaps between them black.
+  // - "listDisplays": List the displays
+  //   Returns: [{ id: int, x: int, y: int, width: int, height: int, primary: bool,
+  //               name: String }], in virtual-desktop pixels with the primary display's
+  //            top left at (0, 0).
+  // - "captureAllDisplays": Capture every display, each into an image of its own
+  //   Parameters: { includeCursor?: bool, format?, quality?, chromaSubsampling? (as for
+  //                 "capture") }
+  //   Returns: [{ displayId: int, x: int, y: int, plus the "capture" result map }], one
+  //            per display in "listDisplays" order. The displays are captured, and then
+  //            encoded, concurrently.
+  // - "captureBatch": Capture the screen once and return several rectangles of it
+  //   Parameters: { rects: [{ x: int, y: int, width: int, height: int, format?, quality?,
+  //                           chromaSubsampling?, maxWidth?, maxHeight?, scale? }] (1-256),
+  //                 includeCursor?: bool, format?, quality?, chromaSubsampling?, maxWidth?,
+  //                 maxHeight?, scale? (as for "capture") }
+  //   Returns: [{ x: int, y: int, sourceWidth: int, sourceHeight: int, plus the "capture"
+  //               result map }], one per rect in order. Rects are in primary-display
+  //            pixels and clipped to it; x, y, sourceWidth and sourceHeight give the
+  //            clipped rect, width and height the (scaled) image. A rect's own format and
+  //            scaling arguments override the top-level ones. The box around the rects is
+  //            copied off the screen once and every rect is a view into that copy; the
+  //            rects are encoded concurrently. A rect off the display fails the call.
+  // - "captureHash": Capture the screen and return fingerprints of it instead of an image
+  //   Parameters: { includeCursor?: bool, rect?: { x: int, y: int, width: int, height: int },
+  //                 hashes?: [String] (of "xxh3", "dhash", "phash"; default all) }
+  //   Returns: { x: int, y: int, width: int, height: int, xxh3?: int, dhash?: int,
+  //              phash?: int }, the rect that was hashed (clipped to the primary display,
+  //            or all of it without one) and the hashes asked for, each a 64-bit int.
+  //            xxh3 is the XXH3-64 of the pixels as "raw_bgra" would return them; dhash
+  //            and phash are perceptual hashes to compare by Hamming distance. Nothing is
+  //            encoded. A rect off the display fails the call.
+  // - "captureTiles": Capture the screen and return the tiles that changed since the
+  //   previous "captureTiles" call
+  //   Parameters: { includeCursor?: bool, format?, quality?, chromaSubsampling? (as for
+  //                 "capture"), tileSize?: int (8-1024, default 64), keyframe?: bool }
+  //   Returns: { width: int, height: int, keyframe: bool, tileSize: int, pixelFormat: String,
+  //              tiles: [{ x: int, y: int, width: int, height: int, stride: int,
+  //                        bytes: Uint8List }] }
+  //            Every tile is returned (keyframe: true) for the first call, when keyframe is
+  //            requested, or when the screen size or tileSize changes.
+  // - "startStream": Start capturing the screen continuously; frames are sent on the
+  //   "dev.flutter.screenshot/stream" event channel. Replaces a running stream.
+  //   Parameters: { fps?: double (0-240, default 30), includeCursor?: bool, format?, quality?,
+  //                 chromaSubsampling? (as for "capture") }
+  //   Events: the "capture" result map plus { sequence: int, timestampUs: int, dropped: int }.
+  //           When encoding or the listener falls behind, older frames are dropped (never
+  //           queued); sequence numbers skip them and dropped counts them.
+  // - "captureShared": Capture as for "capture", but write the bytes into shared memory the
+  //   plugin owns instead of returning them
+  //   Parameters: as for "capture"
+  //   Returns: { width: int, height: int, stride: int, pixelFormat: String, handle: int,
+  //              offset: int, length: int, generation: int } or null (if cancelled).
+  //            handle is a file mapping HANDLE valid in this process; map length bytes at
+  //            offset (a multiple of 64 KiB) read-only. The slot stays reserved until
+  //            "releaseShared"; when every slot is reserved the capture fails.
+  // - "releaseShared": Hand a "captureShared" slot back for reuse
+  //   Parameters: { generation: int }
+  //   Returns: bool, false if that generation was already released
+  // - "captureToFile": Capture as for "capture" and stream the encoded bytes straight to a
+  //   file instead of returning them
+  //   Parameters: as for "capture", plus { path: String, fsync?: bool (default false),
+  //               atomic?: bool (default true) }
+  //   Returns: { path: String, width: int, height: int, pixelFormat: String, byteCount: int,
+  //              elapsedUs: int } or null (if cancelled). elapsedUs runs from the start of
+  //            the screen copy until the file is complete. With atomic, the file is
+  //            written next to path and renamed over it once complete; with fsync, it is
+  //            flushed to disk first. Failures leave no partial file behind.
+  // - "stopStream": Stop the stream, if any.
+  // - "getStats": Report where captures have spent their time
+  //   Returns: { stages: { <stage>: { count: int, errors: int, p50Us: double, p95Us: double,
+  //                                   p99Us: double, maxUs: double, meanUs: double } },
+  //              capturedBytes: int, outputBytes: int,
+  //              framePool: { hits: int, misses: int, evictions: int, buffers: int,
+  //                           residentBytes: int, leasedBytes: int },
+  //              stream: { captured: int, delivered: int, dropped: int, failed: int,
+  //                        skipped: int } }
+  //            Stages are "capture" (the BitBlt), "cursor", "scale", "encode" and "total"
+  //            (from the start of the capture until the reply is sent), over every capture
+  //            since the plugin started or "resetStats"; a stage a capture skipped (no
+  //            cursor, no scaling) is not counted for it, and a failed capture counts only
+  //            as an error in the stage it failed in. Percentiles are within 1/16 of the
+  //            true value. framePool counts since the plugin started, stream since the
+  //            last "startStream".
+  // - "resetStats": Clear the stage statistics of "getStats".
+  // - "startTracing": Drop the spans recorded so far and start recording spans (capture,
+  //   BitBlt, GetDIBits, cursor, overlay, convert, scale, encode, reply, ...) on every
+  //   thread, each into a fixed-size ring of its own.
+  // - "stopTracing": Stop recording spans
+  //   Returns: String, the spans still in the rings as Chrome trace_event JSON, which
+  //            chrome://tracing and Perfetto load as is.
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue> &method_call,
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Called for a message on the "dev.flutter.screenshot/frame" channel: a
+  // StandardMessageCodec map with the "capture" parameters. The reply is a
+  // frame message (see frame_message.h) whose payload is the captured bytes,
+  // with no map or codec in between; a cancelled selection replies with a
+  // kNull header and errors with a kError header plus a StandardMethodCodec
+  // error envelope. sequence counts the requests on this channel.
+  void HandleFrameMessage(const uint8_t* message, size_t size,
+                          flutter::BinaryReply reply);
+
+ private:
+  // How a "capture" result is returned.
+  enum class CaptureOutput {
+    kMap,            // "capture" map on the method channel
+    kFrameMessage,   // frame message on the frame channel
+    kSharedMemory,   // "captureShared": a leased shared_ring_ slot
+    kFile,           // "captureToFile": streamed to a file
+  };
+
+  // "capture", "captureShared" and "captureToFile".
+  void HandleCapture(
+      const flutter::EncodableMap& arguments, CaptureOutput output,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Writes |frame| into a slot of shared_ring_ and describes it in |reply|.
+  // Runs on the encode thread.
+  void EncodeShared(const ImageView& frame, const EncodeSettings& settings,
+                    CaptureReply* reply);
+
+  // Streams |frame| to |path| and describes the file in |reply|. Runs on the
+  // encode thread.
+  void EncodeToFile(const ImageView& frame, const EncodeSettings& settings,
+                    const std::string& path, const FileSinkOptions& options,
+                    int64_t timestamp_us, CaptureReply* reply);
+
+  void HandleStartStream(
+      const flutter::EncodableMap& arguments,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Hands an encoded stream frame to the platform thread, replacing one that
+  // has not been sent yet. Called on the stream's delivery thread.
+  void PostStreamEvent(flutter::EncodableMap event);
+
+  // Sends the pending stream frame, if any. Platform thread only.
+  void SendStreamEvent();
+
+  void HandleCaptureTiles(
+      const flutter::EncodableMap& arguments,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Diffs |frame| against the previous "captureTiles" frame and encodes the
+  // changed tiles into |reply|, switching to |tileSize| first unless it is
+  // 0. Runs on the encode thread.
+  void EncodeTiles(const ImageView& frame, const EncodeSettings& settings,
+                   int tileSize, bool keyframe, CaptureReply* reply);
+
+  void HandleCaptureBatch(
+      const flutter::EncodableMap& arguments,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Encodes |crops| of |frame|, whose top left is at (x, y) on the screen,
+  // into |reply|. Runs on the encode thread.
+  void EncodeBatch(const ImageView& frame, const std::vector<BatchCrop>& crops,
+                   int x, int y, CaptureReply* reply);
+
+  void HandleCaptureHash(
+      const flutter::EncodableMap& arguments,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Hashes |frame|, the capture of |rect|, as |options| asks into |reply|.
+  // Runs on the encode thread.
+  void HashCapture(const ImageView& frame, const ImageHashOptions& options,
+                   const PixelRect& rect, CaptureReply* reply);
+
+  void HandleListDisplays(
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  void HandleGetStats(
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  void HandleCaptureAllDisplays(
+      const flutter::EncodableMap& arguments,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Encodes frames[i], showing displays[i], for each display into |reply|.
+  // Runs on the encode thread.
+  void EncodeDisplays(const std::vector<DisplayInfo>& displays,
+                      const std::vector<ImageView>& frames,
+                      const EncodeSettings& settings, CaptureReply* reply);
+
+  // Runs fn(session, i) for i in [0, count) on up to DefaultThreadCount()
+  // lanes at once, each lane encoding with a long-lived session of its own.
+  // Encode thread only.
+  void RunEncodeLanes(
+      size_t count,
+      const std::function<void(EncoderSession* session, size_t i)>& fn);
+
+  // Runs |job| on pipeline_, or inline when there is no pipeline.
+  void RunCaptureJob(std::unique_ptr<PipelineJob> job);
+
+  CaptureSourceFactory capture_sources_;
+  // "capture" and "captureTiles" copy the screen from screen_source_ into
+  // buffers leased from frame_pool_, and "capture" scales with resizer_ and
+  // encodes with encoder_session_. All of them live as long as the plugin,
+  // so repeated captures reuse the GDI objects, frame buffers, filter taps
+  // and encoders' state. screen_source_ is used only on the pipeline's
+  // capture thread, and resizer_, the encoders and frame_differ_ only on its
+  // encode thread.
+  std::unique_ptr<CaptureSource> screen_source_;
+  // Region mode captures the screen on the platform thread, before showing
+  // its overlay, so it has a source of its own.
+  std::unique_ptr<CaptureSource> region_source_;
+  FramePool frame_pool_;
+  ImageResizer resizer_;
+  EncoderSession encoder_session_;
+  // Sequence number of the next frame channel capture. Platform thread only.
+  uint64_t frame_sequence_ = 0;
+  // "captureShared" frames, leased to Dart until "releaseShared".
+  SharedFrameRing shared_ring_;
+
+  // Previous "captureTiles" frame.
+  FrameDiffer frame_differ_;
+  // Encode changed tiles and displays concurrently, one session per lane;
+  // created on first use.
+  std::unique_ptr<ThreadPool> lane_pool_;
+  std::vector<std::unique_ptr<EncoderSession>> lane_sessions_;
+  // Encodes "captureBatch" rectangles concurrently, on a pool of its own.
+  BatchEncoder batch_encoder_;
+  // Hashes "captureHash" captures.
+  ImageHasher image_hasher_;
+
+  // The displays, listed on the platform thread and captured together on
+  // the capture thread, each display on a lane of display_capture_'s own.
+  GdiDisplayBackend display_backend_;
+  MultiDisplayCapture display_capture_{&display_backend_, &frame_pool_};
+
+  // "startStream" state. The stream captures and encodes on its own threads;
+  // the newest encoded frame waits in pending_stream_event_ for the platform
+  // thread.
+  std::unique_ptr<PlatformTaskQueue> task_queue_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
+  // The stream's source, and the frames it reads from it; used only on the
+  // stream's capture thread.
+  std::unique_ptr<CaptureSource> stream_capture_source_;
+  std::unique_ptr<FrameSource> stream_source_;
+  // Used only on the stream's delivery thread.
+  EncoderSession stream_session_;
+  std::mutex stream_event_mutex_;
+  std::optional<flutter::EncodableMap> pending_stream_event_;
+  uint64_t stream_events_dropped_ = 0;
+  CaptureStream stream_;
+
+  // Every capture's stage timings, recorded by the capture jobs as they
+  // complete, for "getStats".
+  CaptureStats stats_;
+
+  // Captures and encodes "capture" and "captureTiles" requests; null
+  // without a Flutter view, in which case they run on the platform thread.
+  std::unique_ptr<CapturePipeline> pipeline_;
 };
 
 }  // namespace screenshot
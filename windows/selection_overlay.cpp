@@ -0,0 +1,283 @@
+#include "selection_overlay.h"
+
+#include <windows.h>
+#include <windowsx.h>  // For GET_X_LPARAM and GET_Y_LPARAM
+
+#include <vector>
+
+#include "selection_geometry.h"
+#include "trace.h"
+
+namespace screenshot {
+namespace {
+
+const wchar_t kOverlayClassName[] = L"ScreenshotOverlayClass";
+
+// The overlay is shown at 50% opacity: the background dims the screen, and
+// the selection is lightened and outlined.
+constexpr BYTE kOverlayAlpha = 128;
+constexpr COLORREF kBackgroundColor = RGB(0, 0, 0);
+constexpr COLORREF kInteriorColor = RGB(255, 255, 255);
+constexpr COLORREF kBorderColor = RGB(0, 120, 215);  // Blue border
+
+RECT ToRect(const PixelRect& rect) {
+  return RECT{rect.x, rect.y, rect.right(), rect.bottom()};
+}
+
+// State of one overlay window: the selection being dragged, and a back
+// buffer holding the overlay as last drawn together with the brushes it is
+// drawn with. Owned by SelectRegion(); the window finds it through
+// GWLP_USERDATA.
+class SelectionOverlay {
+ public:
+  SelectionOverlay(int width, int height)
+      : bounds_{0, 0, width, height} {}
+
+  ~SelectionOverlay() {
+    if (dc_) {
+      SelectObject(dc_, original_bitmap_);
+      DeleteDC(dc_);
+    }
+    if (bitmap_) DeleteObject(bitmap_);
+    for (HBRUSH brush : {background_, interior_, border_}) {
+      if (brush) DeleteObject(brush);
+    }
+  }
+
+  SelectionOverlay(const SelectionOverlay&) = delete;
+  SelectionOverlay& operator=(const SelectionOverlay&) = delete;
+
+  // Creates the back buffer and brushes and draws the empty overlay.
+  bool Initialize() {
+    HDC screen = GetDC(nullptr);
+    if (!screen) return false;
+    dc_ = CreateCompatibleDC(screen);
+    bitmap_ = CreateCompatibleBitmap(screen, bounds_.width, bounds_.height);
+    ReleaseDC(nullptr, screen);
+    if (!dc_ || !bitmap_) return false;
+    original_bitmap_ = SelectObject(dc_, bitmap_);
+
+    background_ = CreateSolidBrush(kBackgroundColor);
+    interior_ = CreateSolidBrush(kInteriorColor);
+    border_ = CreateSolidBrush(kBorderColor);
+    if (!background_ || !interior_ || !border_) return false;
+
+    const RECT all = ToRect(bounds_);
+    FillRect(dc_, &all, background_);
+    return true;
+  }
+
+  bool cancelled() const { return cancelled_; }
+  const PixelRect& selection() const { return selection_; }
+
+  LRESULT HandleMessage(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+      case WM_LBUTTONDOWN: {
+        // Capture start point
+        start_ = POINT{GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
+        selecting_ = true;
+        SetCapture(hwnd);
+        Draw(hwnd, PixelRect());
+        return 0;
+      }
+
+      case WM_MOUSEMOVE: {
+        if (selecting_) {
+          Draw(hwnd, RectFromCorners(start_.x, start_.y, GET_X_LPARAM(lParam),
+                                     GET_Y_LPARAM(lParam)));
+        }
+        return 0;
+      }
+
+      case WM_LBUTTONUP: {
+        if (selecting_) {
+          selecting_ = false;
+          ReleaseCapture();
+          // Normalize rectangle (handle reverse selection)
+          selection_ = RectFromCorners(start_.x, start_.y,
+                                       GET_X_LPARAM(lParam),
+                                       GET_Y_LPARAM(lParam));
+          // Close overlay
+          DestroyWindow(hwnd);
+        }
+        return 0;
+      }
+
+      case WM_KEYDOWN: {
+        if (wParam == VK_ESCAPE) {
+          // User cancelled
+          cancelled_ = true;
+          DestroyWindow(hwnd);
+        }
+        return 0;
+      }
+
+      case WM_RBUTTONDOWN: {
+        // Right-click cancels
+        cancelled_ = true;
+        DestroyWindow(hwnd);
+        return 0;
+      }
+
+      case WM_ERASEBKGND:
+        // The back buffer covers everything; erasing would only flicker
+        return 1;
+
+      case WM_PAINT: {
+        TraceSpan span("overlay paint");
+        // Copy the invalidated part of the back buffer. The DC is clipped to
+        // the update region, so disjoint strips cost no more than their area.
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(hwnd, &ps);
+        BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top,
+               ps.rcPaint.right - ps.rcPaint.left,
+               ps.rcPaint.bottom - ps.rcPaint.top, dc_, ps.rcPaint.left,
+               ps.rcPaint.top, SRCCOPY);
+        EndPaint(hwnd, &ps);
+        return 0;
+      }
+
+      case WM_DESTROY:
+        PostQuitMessage(0);
+        return 0;
+    }
+    return DefWindowProc(hwnd, msg, wParam, lParam);
+  }
+
+ private:
+  // Moves the drawn selection to |selection|, redrawing and invalidating
+  // only what changes.
+  void Draw(HWND hwnd, const PixelRect& selection) {
+    TraceSpan span("overlay draw");
+    SelectionDamage(drawn_, selection, style_, bounds_, &damage_);
+    drawn_ = selection;
+    const PixelRect interior = SelectionInterior(drawn_, style_);
+    PixelRect border[4];
+    const int border_count = SelectionBorder(drawn_, style_, border);
+    for (const PixelRect& rect : damage_) {
+      // Each layer, clipped to the damaged strip.
+      const RECT area = ToRect(rect);
+      FillRect(dc_, &area, background_);
+      const PixelRect lit = IntersectRects(rect, interior);
+      if (!lit.IsEmpty()) {
+        const RECT lit_area = ToRect(lit);
+        FillRect(dc_, &lit_area, interior_);
+      }
+      for (int i = 0; i < border_count; ++i) {
+        const PixelRect edge = IntersectRects(rect, border[i]);
+        if (edge.IsEmpty()) continue;
+        const RECT edge_area = ToRect(edge);
+        FillRect(dc_, &edge_area, border_);
+      }
+      InvalidateRect(hwnd, &area, FALSE);
+    }
+  }
+
+  const PixelRect bounds_;
+  // A 2-pixel outline centred on the selection's edge.
+  const SelectionStyle style_;
+
+  POINT start_ = {};
+  bool selecting_ = false;
+  bool cancelled_ = false;
+  PixelRect selection_;
+  // The selection as drawn into the back buffer.
+  PixelRect drawn_;
+  std::vector<PixelRect> damage_;
+
+  HDC dc_ = nullptr;
+  HBITMAP bitmap_ = nullptr;
+  HGDIOBJ original_bitmap_ = nullptr;
+  HBRUSH background_ = nullptr;
+  HBRUSH interior_ = nullptr;
+  HBRUSH border_ = nullptr;
+};
+
+// Window procedure for overlay window
+LRESULT CALLBACK OverlayWndProc(HWND hwnd, UINT msg, WPARAM wParam,
+                                LPARAM lParam) {
+  if (msg == WM_NCCREATE) {
+    const auto* create = reinterpret_cast<const CREATESTRUCT*>(lParam);
+    SetWindowLongPtr(hwnd, GWLP_USERDATA,
+                     reinterpret_cast<LONG_PTR>(create->lpCreateParams));
+  }
+  auto* overlay = reinterpret_cast<SelectionOverlay*>(
+      GetWindowLongPtr(hwnd, GWLP_USERDATA));
+  if (!overlay) return DefWindowProc(hwnd, msg, wParam, lParam);
+  return overlay->HandleMessage(hwnd, msg, wParam, lParam);
+}
+
+}  // namespace
+
+bool SelectRegion(PixelRect* selection) {
+  // Set DPI awareness
+  SetProcessDPIAware();
+
+  // Get screen dimensions
+  const int screenWidth = GetSystemMetrics(SM_CXSCREEN);
+  const int screenHeight = GetSystemMetrics(SM_CYSCREEN);
+
+  SelectionOverlay overlay(screenWidth, screenHeight);
+  {
+    TraceSpan span("overlay setup");
+    if (!overlay.Initialize()) return false;
+  }
+
+  // Register window class
+  WNDCLASSEX wc = {};
+  wc.cbSize = sizeof(WNDCLASSEX);
+  wc.style = CS_HREDRAW | CS_VREDRAW;
+  wc.lpfnWndProc = OverlayWndProc;
+  wc.hInstance = GetModuleHandle(nullptr);
+  wc.hCursor = LoadCursor(nullptr, IDC_CROSS);
+  wc.hbrBackground = static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH));
+  wc.lpszClassName = kOverlayClassName;
+
+  if (!RegisterClassEx(&wc)) {
+    // Class might already be registered
+    if (GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
+      return false;
+    }
+  }
+
+  // Create fullscreen layered window
+  HWND hwndOverlay = CreateWindowEx(
+    WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_TOOLWINDOW,
+    kOverlayClassName,
+    L"Screenshot Overlay",
+    WS_POPUP,
+    0, 0, screenWidth, screenHeight,
+    nullptr, nullptr, GetModuleHandle(nullptr), &overlay
+  );
+
+  if (!hwndOverlay) {
+    UnregisterClass(kOverlayClassName, GetModuleHandle(nullptr));
+    return false;
+  }
+
+  // Set semi-transparent background (50% opacity)
+  SetLayeredWindowAttributes(hwndOverlay, 0, kOverlayAlpha, LWA_ALPHA);
+
+  // Show overlay
+  ShowWindow(hwndOverlay, SW_SHOW);
+  UpdateWindow(hwndOverlay);
+  SetForegroundWindow(hwndOverlay);
+
+  // Message loop
+  MSG msg;
+  while (GetMessage(&msg, nullptr, 0, 0)) {
+    TranslateMessage(&msg);
+    DispatchMessage(&msg);
+  }
+
+  // Cleanup window
+  UnregisterClass(kOverlayClassName, GetModuleHandle(nullptr));
+
+  // Cancelled, or an invalid selection
+  if (overlay.cancelled() || overlay.selection().IsEmpty()) return false;
+
+  *selection = overlay.selection();
+  return true;
+}
+
+}  // namespace screenshot
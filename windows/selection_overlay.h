@@ -0,0 +1,21 @@
+#ifndef FLUTTER_PLUGIN_SELECTION_OVERLAY_H_
+#define FLUTTER_PLUGIN_SELECTION_OVERLAY_H_
+
+#include "image_rect.h"
+
+namespace screenshot {
+
+// Lets the user select a region of the primary screen with an interactive
+// overlay, running a modal message loop until they release the mouse or
+// cancel; |selection| is in screen coordinates. Returns false if the
+// selection was cancelled, empty or the overlay failed.
+//
+// The overlay is drawn once into a back buffer, and each mouse move
+// repaints and invalidates only the strips SelectionDamage() reports, with
+// brushes created once per selection, so dragging costs a few small fills
+// and blits however large the screen is.
+bool SelectRegion(PixelRect* selection);
+
+}  // namespace screenshot
+
+#endif  // FLUTTER_PLUGIN_SELECTION_OVERLAY_H_
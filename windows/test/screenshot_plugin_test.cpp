@@ -4,11 +4,18 @@
 #include <gtest/gtest.h>
 #include <windows.h>
 
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <variant>
+#include <vector>
 
+#include "capture_source.h"
+#include "checksum.h"
 #include "screenshot_plugin.h"
+#include "synthetic_screen.h"
+#include "webp_encoder.h"
 
 namespace screenshot {
 namespace test {
@@ -20,199 +27,456 @@ using flutter::EncodableValue;
 using flutter::MethodCall;
 using flutter::MethodResultFunctions;
 
-// Mock MethodResult for testing
+// What a call replied.
+struct CallOutcome {
+  bool success_called = false;
+  bool error_called = false;
+  bool not_implemented_called = false;
+  EncodableValue result_value;
+  std::string error_code;
+  std::string error_message;
+};
+
+// Records the reply in a CallOutcome, which outlives the result: the plugin
+// destroys its result once it has replied.
 class MockMethodResult : public flutter::MethodResult<EncodableValue> {
  public:
-  MockMethodResult() = default;
-  virtual ~MockMethodResult() = default;
+  explicit MockMethodResult(CallOutcome* outcome) : outcome_(outcome) {}
 
   void SuccessInternal(const EncodableValue* result) override {
-    success_called_ = true;
+    outcome_->success_called = true;
     if (result) {
-      result_value_ = *result;
+      outcome_->result_value = *result;
     }
   }
 
   void ErrorInternal(const std::string& error_code,
                      const std::string& error_message,
                      const EncodableValue* error_details) override {
-    error_called_ = true;
-    error_code_ = error_code;
-    error_message_ = error_message;
+    outcome_->error_called = true;
+    outcome_->error_code = error_code;
+    outcome_->error_message = error_message;
   }
 
   void NotImplementedInternal() override {
-    not_implemented_called_ = true;
+    outcome_->not_implemented_called = true;
   }
 
-  bool success_called() const { return success_called_; }
-  bool error_called() const { return error_called_; }
-  bool not_implemented_called() const { return not_implemented_called_; }
-  const EncodableValue& result_value() const { return result_value_; }
-  const std::string& error_code() const { return error_code_; }
-  const std::string& error_message() const { return error_message_; }
-
  private:
-  bool success_called_ = false;
-  bool error_called_ = false;
-  bool not_implemented_called_ = false;
-  EncodableValue result_value_;
-  std::string error_code_;
-  std::string error_message_;
+  CallOutcome* outcome_;
 };
 
+// A screen that cannot be read, as when BitBlt fails.
+class FailingSource : public CaptureSource {
+ public:
+  PixelRect Bounds() override { return PixelRect{0, 0, 64, 64}; }
+  bool Capture(const PixelRect&, bool, uint8_t*, size_t) override {
+    return false;
+  }
+};
+
+constexpr int kScreenWidth = 320;
+constexpr int kScreenHeight = 200;
+
+SyntheticScreenOptions ScreenOptions() {
+  SyntheticScreenOptions options;
+  options.width = kScreenWidth;
+  options.height = kScreenHeight;
+  return options;
+}
+
+// Captures from a SyntheticScreen, so results do not depend on the machine
+// the tests run on. There is no registrar, so jobs run inline and every
+// call has its result when HandleMethodCall() returns.
+std::unique_ptr<ScreenshotPlugin> MakeSyntheticPlugin() {
+  return std::make_unique<ScreenshotPlugin>(
+      []() -> std::unique_ptr<CaptureSource> {
+        return std::make_unique<SyntheticScreen>(ScreenOptions());
+      });
+}
+
+std::unique_ptr<ScreenshotPlugin> MakeFailingPlugin() {
+  return std::make_unique<ScreenshotPlugin>(
+      []() -> std::unique_ptr<CaptureSource> {
+        return std::make_unique<FailingSource>();
+      });
+}
+
+// Calls "capture" with |args| and returns the reply.
+CallOutcome Capture(ScreenshotPlugin* plugin, const EncodableMap& args) {
+  CallOutcome outcome;
+  MethodCall call("capture", std::make_unique<EncodableValue>(args));
+  plugin->HandleMethodCall(call, std::make_unique<MockMethodResult>(&outcome));
+  return outcome;
+}
+
+// Calls "captureBatch" with |args| and returns the reply.
+CallOutcome CaptureBatch(ScreenshotPlugin* plugin, const EncodableMap& args) {
+  CallOutcome outcome;
+  MethodCall call("captureBatch", std::make_unique<EncodableValue>(args));
+  plugin->HandleMethodCall(call, std::make_unique<MockMethodResult>(&outcome));
+  return outcome;
+}
+
+EncodableValue BatchRect(int x, int y, int width, int height) {
+  EncodableMap rect;
+  rect[EncodableValue("x")] = EncodableValue(x);
+  rect[EncodableValue("y")] = EncodableValue(y);
+  rect[EncodableValue("width")] = EncodableValue(width);
+  rect[EncodableValue("height")] = EncodableValue(height);
+  return EncodableValue(rect);
+}
+
+// Calls "captureHash" with |args| and returns the reply.
+CallOutcome CaptureHash(ScreenshotPlugin* plugin, const EncodableMap& args) {
+  CallOutcome outcome;
+  MethodCall call("captureHash", std::make_unique<EncodableValue>(args));
+  plugin->HandleMethodCall(call, std::make_unique<MockMethodResult>(&outcome));
+  return outcome;
+}
+
+// Calls |method| without arguments and returns the reply.
+CallOutcome Call(ScreenshotPlugin* plugin, const std::string& method) {
+  CallOutcome outcome;
+  MethodCall call(method, std::make_unique<EncodableValue>());
+  plugin->HandleMethodCall(call, std::make_unique<MockMethodResult>(&outcome));
+  return outcome;
+}
+
+const EncodableValue& Field(const EncodableValue& map, const char* key) {
+  return std::get<EncodableMap>(map).at(EncodableValue(key));
+}
+
+bool HasField(const EncodableValue& map, const char* key) {
+  const EncodableMap& fields = std::get<EncodableMap>(map);
+  return fields.find(EncodableValue(key)) != fields.end();
+}
+
+// "getStats" field |key| of |stage|.
+int64_t StageCount(const EncodableValue& stats, const char* stage,
+                   const char* key) {
+  return std::get<int64_t>(Field(Field(Field(stats, "stages"), stage), key));
+}
+
 }  // namespace
 
 // T034: Test HandleMethodCall for capture screen method
 TEST(ScreenshotPluginTest, HandleCaptureScreenMethod) {
-  ScreenshotPlugin plugin;
-  auto result = std::make_unique<MockMethodResult>();
-  MockMethodResult* result_ptr = result.get();
-
+  auto plugin = MakeSyntheticPlugin();
   EncodableMap args;
   args[EncodableValue("mode")] = EncodableValue("screen");
   args[EncodableValue("includeCursor")] = EncodableValue(false);
 
-  MethodCall call("capture", std::make_unique<EncodableValue>(args));
-  plugin.HandleMethodCall(call, std::move(result));
-
-  // Currently not implemented, should call NotImplemented
-  EXPECT_TRUE(result_ptr->not_implemented_called());
+  const CallOutcome result = Capture(plugin.get(), args);
+  ASSERT_TRUE(result.success_called);
+  EXPECT_EQ(kScreenWidth, std::get<int32_t>(Field(result.result_value,
+                                                  "width")));
+  EXPECT_EQ(kScreenHeight, std::get<int32_t>(Field(result.result_value,
+                                                   "height")));
+  EXPECT_EQ("png", std::get<std::string>(Field(result.result_value,
+                                               "pixelFormat")));
 }
 
 // T035: Test invalid mode returns error
 TEST(ScreenshotPluginTest, InvalidModeReturnsError) {
-  ScreenshotPlugin plugin;
-  auto result = std::make_unique<MockMethodResult>();
-  MockMethodResult* result_ptr = result.get();
-
+  auto plugin = MakeSyntheticPlugin();
   EncodableMap args;
   args[EncodableValue("mode")] = EncodableValue("invalid_mode");
   args[EncodableValue("includeCursor")] = EncodableValue(false);
 
-  MethodCall call("capture", std::make_unique<EncodableValue>(args));
-  plugin.HandleMethodCall(call, std::move(result));
-
-  // Should return error for invalid mode (when implemented)
-  // Currently returns NotImplemented
-  EXPECT_TRUE(result_ptr->not_implemented_called());
+  const CallOutcome result = Capture(plugin.get(), args);
+  EXPECT_TRUE(result.error_called);
+  EXPECT_EQ("invalid_argument", result.error_code);
 }
 
 // T036: Test capture screen returns valid PNG data
 TEST(ScreenshotPluginTest, CaptureScreenReturnsValidPngData) {
-  ScreenshotPlugin plugin;
-  auto result = std::make_unique<MockMethodResult>();
-  MockMethodResult* result_ptr = result.get();
-
+  auto plugin = MakeSyntheticPlugin();
   EncodableMap args;
   args[EncodableValue("mode")] = EncodableValue("screen");
   args[EncodableValue("includeCursor")] = EncodableValue(true);
 
-  MethodCall call("capture", std::make_unique<EncodableValue>(args));
-  plugin.HandleMethodCall(call, std::move(result));
-
-  // When implemented, should return map with width, height, bytes
-  // Currently returns NotImplemented
-  EXPECT_TRUE(result_ptr->not_implemented_called());
+  const CallOutcome result = Capture(plugin.get(), args);
+  ASSERT_TRUE(result.success_called);
+  const auto& bytes =
+      std::get<std::vector<uint8_t>>(Field(result.result_value, "bytes"));
+  ASSERT_GT(bytes.size(), 24u);
+  const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  EXPECT_EQ(0, std::memcmp(bytes.data(), signature, sizeof(signature)));
+  // IHDR's big-endian width and height.
+  EXPECT_EQ(kScreenWidth, bytes[18] << 8 | bytes[19]);
+  EXPECT_EQ(kScreenHeight, bytes[22] << 8 | bytes[23]);
 }
 
-// T068: Test capture region creates overlay
-TEST(ScreenshotPluginTest, CaptureRegionCreatesOverlay) {
-  ScreenshotPlugin plugin;
-  auto result = std::make_unique<MockMethodResult>();
-  MockMethodResult* result_ptr = result.get();
+TEST(ScreenshotPluginTest, RawCaptureReturnsTheSourcePixels) {
+  auto plugin = MakeSyntheticPlugin();
+  EncodableMap args;
+  args[EncodableValue("mode")] = EncodableValue("screen");
+  args[EncodableValue("format")] = EncodableValue("raw_bgra");
+
+  const CallOutcome result = Capture(plugin.get(), args);
+  ASSERT_TRUE(result.success_called);
+  const size_t stride = static_cast<size_t>(kScreenWidth) * 4;
+  EXPECT_EQ(static_cast<int32_t>(stride),
+            std::get<int32_t>(Field(result.result_value, "stride")));
+
+  // The plugin's first frame of the same synthetic screen.
+  SyntheticScreen screen(ScreenOptions());
+  std::vector<uint8_t> expected(stride * kScreenHeight);
+  ASSERT_TRUE(
+      screen.Capture(screen.Bounds(), false, expected.data(), stride));
+  EXPECT_EQ(expected, std::get<std::vector<uint8_t>>(
+                          Field(result.result_value, "bytes")));
+}
 
+// Every rectangle is cut from the same capture, clipped to the screen and
+// encoded as it asks.
+TEST(ScreenshotPluginTest, CaptureBatchReturnsEachRectOfOneCapture) {
+  auto plugin = MakeSyntheticPlugin();
+  EncodableMap scaled = std::get<EncodableMap>(BatchRect(100, 40, 80, 60));
+  scaled[EncodableValue("scale")] = EncodableValue(0.5);
+  scaled[EncodableValue("format")] = EncodableValue("png");
   EncodableMap args;
-  args[EncodableValue("mode")] = EncodableValue("region");
-  args[EncodableValue("includeCursor")] = EncodableValue(false);
+  args[EncodableValue("format")] = EncodableValue("raw_bgra");
+  args[EncodableValue("rects")] = EncodableValue(flutter::EncodableList{
+      BatchRect(10, 20, 30, 40), EncodableValue(scaled),
+      BatchRect(300, 190, 50, 50)});
+
+  const CallOutcome result = CaptureBatch(plugin.get(), args);
+  ASSERT_TRUE(result.success_called);
+  const auto& crops = std::get<flutter::EncodableList>(result.result_value);
+  ASSERT_EQ(3u, crops.size());
+
+  SyntheticScreen screen(ScreenOptions());
+  const size_t stride = static_cast<size_t>(kScreenWidth) * 4;
+  std::vector<uint8_t> frame(stride * kScreenHeight);
+  ASSERT_TRUE(screen.Capture(screen.Bounds(), false, frame.data(), stride));
+  std::vector<uint8_t> expected;
+  for (int y = 20; y < 60; ++y) {
+    const uint8_t* row = frame.data() + y * stride + 10 * 4;
+    expected.insert(expected.end(), row, row + 30 * 4);
+  }
+  EXPECT_EQ(10, std::get<int32_t>(Field(crops[0], "x")));
+  EXPECT_EQ(20, std::get<int32_t>(Field(crops[0], "y")));
+  EXPECT_EQ("raw_bgra", std::get<std::string>(Field(crops[0], "pixelFormat")));
+  EXPECT_EQ(expected, std::get<std::vector<uint8_t>>(Field(crops[0], "bytes")));
+
+  EXPECT_EQ("png", std::get<std::string>(Field(crops[1], "pixelFormat")));
+  EXPECT_EQ(80, std::get<int32_t>(Field(crops[1], "sourceWidth")));
+  EXPECT_EQ(40, std::get<int32_t>(Field(crops[1], "width")));
+  EXPECT_EQ(30, std::get<int32_t>(Field(crops[1], "height")));
+
+  EXPECT_EQ(300, std::get<int32_t>(Field(crops[2], "x")));
+  EXPECT_EQ(20, std::get<int32_t>(Field(crops[2], "sourceWidth")));
+  EXPECT_EQ(10, std::get<int32_t>(Field(crops[2], "sourceHeight")));
+  EXPECT_EQ(20, std::get<int32_t>(Field(crops[2], "width")));
+}
 
-  MethodCall call("capture", std::make_unique<EncodableValue>(args));
-  plugin.HandleMethodCall(call, std::move(result));
+TEST(ScreenshotPluginTest, CaptureBatchRejectsBadRectsBeforeCapturing) {
+  auto plugin = MakeFailingPlugin();
+  for (const EncodableValue& rects :
+       {EncodableValue(flutter::EncodableList{}),
+        EncodableValue(flutter::EncodableList{BatchRect(64, 0, 10, 10)}),
+        EncodableValue(flutter::EncodableList{BatchRect(0, 0, 0, 10)}),
+        EncodableValue(flutter::EncodableList{EncodableValue("rect")}),
+        EncodableValue(flutter::EncodableList(257, BatchRect(0, 0, 1, 1)))}) {
+    EncodableMap args;
+    args[EncodableValue("rects")] = rects;
+    const CallOutcome result = CaptureBatch(plugin.get(), args);
+    EXPECT_TRUE(result.error_called);
+    EXPECT_EQ("invalid_argument", result.error_code);
+  }
+}
 
-  // When implemented, region mode should create overlay window
-  // For now, expects NotImplemented
-  EXPECT_TRUE(result_ptr->not_implemented_called());
+// The exact hash is that of the pixels "raw_bgra" would return for the
+// rect, clipped to the screen.
+TEST(ScreenshotPluginTest, CaptureHashHashesTheRectsPixels) {
+  auto plugin = MakeSyntheticPlugin();
+  EncodableMap args;
+  args[EncodableValue("rect")] = BatchRect(300, 150, 50, 70);
+  args[EncodableValue("hashes")] = EncodableValue(
+      flutter::EncodableList{EncodableValue("xxh3"), EncodableValue("phash")});
+
+  const CallOutcome result = CaptureHash(plugin.get(), args);
+  ASSERT_TRUE(result.success_called);
+  EXPECT_EQ(300, std::get<int32_t>(Field(result.result_value, "x")));
+  EXPECT_EQ(150, std::get<int32_t>(Field(result.result_value, "y")));
+  EXPECT_EQ(20, std::get<int32_t>(Field(result.result_value, "width")));
+  EXPECT_EQ(50, std::get<int32_t>(Field(result.result_value, "height")));
+  EXPECT_TRUE(HasField(result.result_value, "phash"));
+  EXPECT_FALSE(HasField(result.result_value, "dhash"));
+
+  SyntheticScreen screen(ScreenOptions());
+  const size_t stride = static_cast<size_t>(kScreenWidth) * 4;
+  std::vector<uint8_t> frame(stride * kScreenHeight);
+  ASSERT_TRUE(screen.Capture(screen.Bounds(), false, frame.data(), stride));
+  std::vector<uint8_t> expected;
+  for (int y = 150; y < 200; ++y) {
+    const uint8_t* row = frame.data() + y * stride + 300 * 4;
+    for (int x = 0; x < 20; ++x, row += 4) {
+      expected.insert(expected.end(), {row[0], row[1], row[2], 0xFF});
+    }
+  }
+  EXPECT_EQ(static_cast<int64_t>(XxHash3(expected.data(), expected.size())),
+            std::get<int64_t>(Field(result.result_value, "xxh3")));
+
+  // Without arguments the whole screen is hashed, every way.
+  const CallOutcome whole = CaptureHash(plugin.get(), EncodableMap());
+  ASSERT_TRUE(whole.success_called);
+  EXPECT_EQ(kScreenWidth, std::get<int32_t>(Field(whole.result_value, "width")));
+  EXPECT_TRUE(HasField(whole.result_value, "dhash"));
+  EXPECT_NE(std::get<int64_t>(Field(result.result_value, "xxh3")),
+            std::get<int64_t>(Field(whole.result_value, "xxh3")));
 }
 
-// T069: Test region capture returns null on cancel
-TEST(ScreenshotPluginTest, RegionCaptureReturnsNullOnCancel) {
-  ScreenshotPlugin plugin;
-  auto result = std::make_unique<MockMethodResult>();
-  MockMethodResult* result_ptr = result.get();
+TEST(ScreenshotPluginTest, CaptureHashRejectsBadArgumentsBeforeCapturing) {
+  auto plugin = MakeFailingPlugin();
+  std::vector<EncodableMap> calls(4);
+  calls[0][EncodableValue("rect")] = BatchRect(64, 0, 10, 10);
+  calls[1][EncodableValue("rect")] = EncodableValue("screen");
+  calls[2][EncodableValue("hashes")] = EncodableValue(flutter::EncodableList{});
+  calls[3][EncodableValue("hashes")] =
+      EncodableValue(flutter::EncodableList{EncodableValue("md5")});
+  for (const EncodableMap& args : calls) {
+    const CallOutcome result = CaptureHash(plugin.get(), args);
+    EXPECT_TRUE(result.error_called);
+    EXPECT_EQ("invalid_argument", result.error_code);
+  }
+}
 
+// The screen is captured before the selection overlay is shown, so a
+// failure is reported without showing it.
+TEST(ScreenshotPluginTest, RegionCaptureFailsBeforeShowingOverlay) {
+  auto plugin = MakeFailingPlugin();
   EncodableMap args;
   args[EncodableValue("mode")] = EncodableValue("region");
   args[EncodableValue("includeCursor")] = EncodableValue(false);
 
-  MethodCall call("capture", std::make_unique<EncodableValue>(args));
-  plugin.HandleMethodCall(call, std::move(result));
-
-  // When user cancels (ESC/right-click), should return null via Success(null)
-  // For now, expects NotImplemented
-  EXPECT_TRUE(result_ptr->not_implemented_called());
+  const CallOutcome result = Capture(plugin.get(), args);
+  EXPECT_TRUE(result.error_called);
+  EXPECT_EQ("internal_error", result.error_code);
+  EXPECT_EQ("Failed to capture region", result.error_message);
 }
 
-// T070: Test region capture handles reverse selection
-TEST(ScreenshotPluginTest, RegionCaptureHandlesReverseSelection) {
-  ScreenshotPlugin plugin;
-  auto result = std::make_unique<MockMethodResult>();
-  MockMethodResult* result_ptr = result.get();
-
+TEST(ScreenshotPluginTest, RegionCaptureValidatesArgumentsFirst) {
+  auto plugin = MakeSyntheticPlugin();
   EncodableMap args;
   args[EncodableValue("mode")] = EncodableValue("region");
-  args[EncodableValue("includeCursor")] = EncodableValue(false);
+  args[EncodableValue("format")] = EncodableValue("gif");
 
-  MethodCall call("capture", std::make_unique<EncodableValue>(args));
-  plugin.HandleMethodCall(call, std::move(result));
+  const CallOutcome result = Capture(plugin.get(), args);
+  EXPECT_TRUE(result.error_called);
+  EXPECT_EQ("invalid_argument", result.error_code);
+}
 
-  // When implemented, should handle bottom-right to top-left drag
-  // For now, expects NotImplemented
-  EXPECT_TRUE(result_ptr->not_implemented_called());
+// Stage timings are reported through getStats only, never on the result.
+TEST(ScreenshotPluginTest, GetStatsTimesTheCursorAndScaleStages) {
+  auto plugin = MakeSyntheticPlugin();
+  EncodableMap args;
+  args[EncodableValue("mode")] = EncodableValue("screen");
+  args[EncodableValue("includeCursor")] = EncodableValue(true);
+  args[EncodableValue("maxWidth")] = EncodableValue(160);
+
+  const CallOutcome result = Capture(plugin.get(), args);
+  ASSERT_TRUE(result.success_called);
+  EXPECT_FALSE(HasField(result.result_value, "timingsUs"));
+
+  const CallOutcome stats = Call(plugin.get(), "getStats");
+  ASSERT_TRUE(stats.success_called);
+  for (const char* stage : {"capture", "cursor", "scale", "encode", "total"}) {
+    EXPECT_EQ(1, StageCount(stats.result_value, stage, "count")) << stage;
+  }
 }
 
-// Placeholder test - will be implemented in User Story 1
-TEST(ScreenshotPlugin, PlaceholderTest) {
-  ScreenshotPlugin plugin;
-  EXPECT_TRUE(true);
+TEST(ScreenshotPluginTest, GetStatsCountsStagesBytesAndErrors) {
+  auto plugin = MakeSyntheticPlugin();
+  EncodableMap args;
+  args[EncodableValue("mode")] = EncodableValue("screen");
+  args[EncodableValue("format")] = EncodableValue("raw_bgra");
+  ASSERT_TRUE(Capture(plugin.get(), args).success_called);
+  ASSERT_TRUE(Capture(plugin.get(), args).success_called);
+
+  CallOutcome stats = Call(plugin.get(), "getStats");
+  ASSERT_TRUE(stats.success_called);
+  const EncodableValue& value = stats.result_value;
+  EXPECT_EQ(2, StageCount(value, "capture", "count"));
+  EXPECT_EQ(2, StageCount(value, "encode", "count"));
+  EXPECT_EQ(2, StageCount(value, "total", "count"));
+  // Neither drew the cursor or scaled.
+  EXPECT_EQ(0, StageCount(value, "cursor", "count"));
+  EXPECT_EQ(0, StageCount(value, "scale", "count"));
+  EXPECT_EQ(0, StageCount(value, "capture", "errors"));
+  const EncodableValue& total = Field(Field(value, "stages"), "total");
+  EXPECT_LE(std::get<double>(Field(total, "p50Us")),
+            std::get<double>(Field(total, "maxUs")));
+  const int64_t frame_bytes = int64_t{kScreenWidth} * kScreenHeight * 4;
+  EXPECT_EQ(2 * frame_bytes, std::get<int64_t>(Field(value, "capturedBytes")));
+  EXPECT_EQ(2 * frame_bytes, std::get<int64_t>(Field(value, "outputBytes")));
+  // The second capture reused the first one's buffer.
+  EXPECT_EQ(1, std::get<int64_t>(Field(Field(value, "framePool"), "hits")));
+
+  ASSERT_TRUE(Call(plugin.get(), "resetStats").success_called);
+  stats = Call(plugin.get(), "getStats");
+  EXPECT_EQ(0, StageCount(stats.result_value, "capture", "count"));
+  EXPECT_EQ(0, std::get<int64_t>(Field(stats.result_value, "outputBytes")));
+
+  auto failing = MakeFailingPlugin();
+  EXPECT_TRUE(Capture(failing.get(), args).error_called);
+  stats = Call(failing.get(), "getStats");
+  EXPECT_EQ(1, StageCount(stats.result_value, "capture", "errors"));
+  EXPECT_EQ(0, StageCount(stats.result_value, "capture", "count"));
+}
+
+TEST(ScreenshotPluginTest, StopTracingReturnsTheCaptureSpans) {
+  auto plugin = MakeSyntheticPlugin();
+  EncodableMap args;
+  args[EncodableValue("mode")] = EncodableValue("screen");
+  args[EncodableValue("includeCursor")] = EncodableValue(true);
+  ASSERT_TRUE(Capture(plugin.get(), args).success_called);
+
+  ASSERT_TRUE(Call(plugin.get(), "startTracing").success_called);
+  ASSERT_TRUE(Capture(plugin.get(), args).success_called);
+  CallOutcome trace = Call(plugin.get(), "stopTracing");
+  ASSERT_TRUE(trace.success_called);
+  const std::string& json = std::get<std::string>(trace.result_value);
+  EXPECT_EQ(0u, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  for (const char* span : {"\"capture\"", "\"cursor\"", "\"encode\""}) {
+    EXPECT_NE(std::string::npos, json.find(span)) << span;
+  }
+  EXPECT_NE(std::string::npos, json.find("\"platform\""));
+
+  // Nothing is recorded once tracing stops.
+  ASSERT_TRUE(Capture(plugin.get(), args).success_called);
+  ASSERT_TRUE(Call(plugin.get(), "startTracing").success_called);
+  trace = Call(plugin.get(), "stopTracing");
+  EXPECT_EQ(std::string::npos,
+            std::get<std::string>(trace.result_value).find("\"capture\""));
 }
 
 // T108: Test internal error returns correct code
 TEST(ScreenshotPluginTest, InternalErrorReturnsCorrectCode) {
-  ScreenshotPlugin plugin;
-  auto result = std::make_unique<MockMethodResult>();
-  MockMethodResult* result_ptr = result.get();
-
+  auto plugin = MakeFailingPlugin();
   EncodableMap args;
   args[EncodableValue("mode")] = EncodableValue("screen");
   args[EncodableValue("includeCursor")] = EncodableValue(false);
 
-  MethodCall call("capture", std::make_unique<EncodableValue>(args));
-  plugin.HandleMethodCall(call, std::move(result));
-
-  // When BitBlt or encoding fails, should return error with code "internal_error"
-  // For now, expects NotImplemented - will be implemented in US3
-  EXPECT_TRUE(result_ptr->not_implemented_called());
+  const CallOutcome result = Capture(plugin.get(), args);
+  EXPECT_TRUE(result.error_called);
+  EXPECT_EQ("internal_error", result.error_code);
+  EXPECT_EQ("Failed to capture screen", result.error_message);
 }
 
-// T109: Test not_supported error for invalid platform
-TEST(ScreenshotPluginTest, NotSupportedErrorForInvalidPlatform) {
-  ScreenshotPlugin plugin;
-  auto result = std::make_unique<MockMethodResult>();
-  MockMethodResult* result_ptr = result.get();
-
-  // This test validates that non-Windows platforms would get not_supported error
-  // Since we're testing on Windows, this is more of a design validation
-  // The actual error would be returned if platform detection fails
-  
+// T109: Test not_supported error for an encoder missing from the build
+TEST(ScreenshotPluginTest, NotSupportedErrorForMissingEncoder) {
+  if (WebpEncoder::IsAvailable()) GTEST_SKIP() << "Built with libwebp";
+  auto plugin = MakeSyntheticPlugin();
   EncodableMap args;
   args[EncodableValue("mode")] = EncodableValue("screen");
-  args[EncodableValue("includeCursor")] = EncodableValue(false);
-
-  MethodCall call("capture", std::make_unique<EncodableValue>(args));
-  plugin.HandleMethodCall(call, std::move(result));
+  args[EncodableValue("format")] = EncodableValue("webp");
 
-  // For now, expects NotImplemented - will be properly implemented in US3
-  EXPECT_TRUE(result_ptr->not_implemented_called());
+  const CallOutcome result = Capture(plugin.get(), args);
+  EXPECT_TRUE(result.error_called);
+  EXPECT_EQ("not_supported", result.error_code);
 }
 
 }  // namespace test